@@ -3517,8 +3517,6 @@ use vars qw(@ISA %OWNER %ITERATORS %BLESSEDMEMBERS);
 *swig_q1k_set = *RNAc::mx_pf_q1k_set;
 *swig_qln_get = *RNAc::mx_pf_qln_get;
 *swig_qln_set = *RNAc::mx_pf_qln_set;
-*swig_G_get = *RNAc::mx_pf_G_get;
-*swig_G_set = *RNAc::mx_pf_G_set;
 *swig_qo_get = *RNAc::mx_pf_qo_get;
 *swig_qo_set = *RNAc::mx_pf_qo_set;
 *swig_qm2_get = *RNAc::mx_pf_qm2_get;
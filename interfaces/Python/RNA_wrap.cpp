@@ -9721,9 +9721,20 @@ SWIGINTERN COORDINATE *COORDINATE_get(COORDINATE *self,int i){
   var_array<unsigned char> *
   vrna_hc_t_mx_get(vrna_hc_t *hc)
   {
+    unsigned int  i, j;
+    unsigned char *mx;
+
+    /* expand the banded storage into a dense (n + 1) x (n + 1) copy */
+    mx = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((hc->n + 1) * (hc->n + 1) + 1));
+
+    if (hc->type == VRNA_HC_DEFAULT)
+      for (i = 1; i <= hc->n; i++)
+        for (j = i; j <= hc->n; j++)
+          mx[hc->n * i + j] = mx[hc->n * j + i] = vrna_hc_context(hc, i, j);
+
     return var_array_new(hc->n,
-                         hc->mx,
-                         VAR_ARRAY_SQR | VAR_ARRAY_ONE_BASED);
+                         mx,
+                         VAR_ARRAY_SQR | VAR_ARRAY_ONE_BASED | VAR_ARRAY_OWNED);
   }
 
   var_array<int> *
@@ -15603,14 +15614,6 @@ SWIGINTERN void delete_vrna_mx_pf_t(vrna_mx_pf_t *self){}
                          VAR_ARRAY_TRI | VAR_ARRAY_ONE_BASED);
   }
 
-  var_array<FLT_OR_DBL> *
-  vrna_mx_pf_t_G_get(vrna_mx_pf_t *mx)
-  {
-    return var_array_new(mx->length,
-                         mx->G,
-                         VAR_ARRAY_TRI | VAR_ARRAY_ONE_BASED);
-  }
-
   var_array<FLT_OR_DBL> *
   vrna_mx_pf_t_probs_get(vrna_mx_pf_t *mx)
   {
@@ -90841,35 +90844,6 @@ fail:
 }
 
 
-SWIGINTERN PyObject *_wrap_mx_pf_G_get(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
-  PyObject *resultobj = 0;
-  vrna_mx_pf_t *arg1 = (vrna_mx_pf_t *) 0 ;
-  void *argp1 = 0 ;
-  int res1 = 0 ;
-  PyObject *swig_obj[1] ;
-  var_array< FLT_OR_DBL > *result = 0 ;
-  
-  if (!args) SWIG_fail;
-  swig_obj[0] = args;
-  res1 = SWIG_ConvertPtr(swig_obj[0], &argp1,SWIGTYPE_p_vrna_mx_pf_t, 0 |  0 );
-  if (!SWIG_IsOK(res1)) {
-    SWIG_exception_fail(SWIG_ArgError(res1), "in method '" "mx_pf_G_get" "', argument " "1"" of type '" "vrna_mx_pf_t *""'"); 
-  }
-  arg1 = reinterpret_cast< vrna_mx_pf_t * >(argp1);
-  {
-    try {
-      result = (var_array< FLT_OR_DBL > *)vrna_mx_pf_t_G_get(arg1);
-    } catch (const std::exception& e) {
-      SWIG_exception(SWIG_RuntimeError, e.what());
-    }
-  }
-  resultobj = SWIG_NewPointerObj(SWIG_as_voidptr(result), SWIGTYPE_p_var_arrayT_FLT_OR_DBL_t, 0 |  0 );
-  return resultobj;
-fail:
-  return NULL;
-}
-
-
 SWIGINTERN PyObject *_wrap_mx_pf_qo_get(PyObject *SWIGUNUSEDPARM(self), PyObject *args) {
   PyObject *resultobj = 0;
   vrna_mx_pf_t *arg1 = (vrna_mx_pf_t *) 0 ;
@@ -101189,7 +101163,6 @@ static PyMethodDef SwigMethods[] = {
 	 { "mx_pf_probs_get", _wrap_mx_pf_probs_get, METH_O, NULL},
 	 { "mx_pf_q1k_get", _wrap_mx_pf_q1k_get, METH_O, NULL},
 	 { "mx_pf_qln_get", _wrap_mx_pf_qln_get, METH_O, NULL},
-	 { "mx_pf_G_get", _wrap_mx_pf_G_get, METH_O, NULL},
 	 { "mx_pf_qo_get", _wrap_mx_pf_qo_get, METH_O, NULL},
 	 { "mx_pf_qm2_get", _wrap_mx_pf_qm2_get, METH_O, NULL},
 	 { "mx_pf_qho_get", _wrap_mx_pf_qho_get, METH_O, NULL},
@@ -15801,7 +15801,6 @@ class mx_pf(object):
     probs = property(_RNA.mx_pf_probs_get)
     q1k = property(_RNA.mx_pf_q1k_get)
     qln = property(_RNA.mx_pf_qln_get)
-    G = property(_RNA.mx_pf_G_get)
     qo = property(_RNA.mx_pf_qo_get)
     qm2 = property(_RNA.mx_pf_qm2_get)
     qho = property(_RNA.mx_pf_qho_get)
@@ -27,9 +27,20 @@ typedef struct {
   var_array<unsigned char> *
   vrna_hc_t_mx_get(vrna_hc_t *hc)
   {
+    unsigned int  i, j;
+    unsigned char *mx;
+
+    /* expand the banded storage into a dense (n + 1) x (n + 1) copy */
+    mx = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((hc->n + 1) * (hc->n + 1) + 1));
+
+    if (hc->type == VRNA_HC_DEFAULT)
+      for (i = 1; i <= hc->n; i++)
+        for (j = i; j <= hc->n; j++)
+          mx[hc->n * i + j] = mx[hc->n * j + i] = vrna_hc_context(hc, i, j);
+
     return var_array_new(hc->n,
-                         hc->mx,
-                         VAR_ARRAY_SQR | VAR_ARRAY_ONE_BASED);
+                         mx,
+                         VAR_ARRAY_SQR | VAR_ARRAY_ONE_BASED | VAR_ARRAY_OWNED);
   }
 
   var_array<int> *
@@ -144,7 +144,6 @@ typedef struct {
   var_array<FLT_OR_DBL> *const  probs;
   var_array<FLT_OR_DBL> *const  q1k;
   var_array<FLT_OR_DBL> *const  qln;
-  var_array<FLT_OR_DBL> *const  G;
   const FLT_OR_DBL              qo;
   var_array<FLT_OR_DBL> *const  qm2;
   const FLT_OR_DBL              qho;
@@ -205,14 +204,6 @@ typedef struct {
                          VAR_ARRAY_TRI | VAR_ARRAY_ONE_BASED);
   }
 
-  var_array<FLT_OR_DBL> *
-  vrna_mx_pf_t_G_get(vrna_mx_pf_t *mx)
-  {
-    return var_array_new(mx->length,
-                         mx->G,
-                         VAR_ARRAY_TRI | VAR_ARRAY_ONE_BASED);
-  }
-
   var_array<FLT_OR_DBL> *
   vrna_mx_pf_t_probs_get(vrna_mx_pf_t *mx)
   {
@@ -46,50 +46,45 @@ typedef struct _baum {
 } baum;
 
 static char UNUSED rcsid[]="$Id: baum.c,v 1.9 2008/05/21 10:15:45 ivo Exp $";
-static short *pairList = NULL;
-static short *typeList = NULL;
-static short *aliasList = NULL;
-static baum *rl = NULL;         /* ringlist */
-static baum *wurzl = NULL;      /* virtualroot of ringlist-tree */
-static char **ptype = NULL;
 
 static int comp_struc(const void *A, const void *B);
 /* PUBLIC FUNCTIONES */
-void ini_or_reset_rl (void);
-void move_it (void);
-void update_tree (int i, int j);
-void clean_up_rl (void);
+void ini_simulation (void);
+void ini_or_reset_rl (TrajVars *T);
+void move_it (TrajVars *T);
+void update_tree (TrajVars *T, int i, int j);
+void clean_up_rl (TrajVars *T);
 
 /* PRIVATE FUNCTIONES */
-static void ini_ringlist(void);
-static void reset_ringlist(void);
-static void struc2tree (char *struc);
-static void close_bp_en (baum *i, baum *j);
-static void close_bp (baum *i, baum *j);
-static void open_bp (baum *i);
-static void open_bp_en (baum *i);
-static void inb (baum *root);
-static void inb_nolp (baum *root);
-static void dnb (baum *rli);
-static void dnb_nolp (baum *rli);
-static void fnb (baum *rli);
-static void make_ptypes(const short *S);
+static void ini_ringlist(TrajVars *T);
+static void reset_ringlist(TrajVars *T);
+static void struc2tree (TrajVars *T, char *struc);
+static void close_bp_en (TrajVars *T, baum *i, baum *j);
+static void close_bp (TrajVars *T, baum *i, baum *j);
+static void open_bp (TrajVars *T, baum *i);
+static void open_bp_en (TrajVars *T, baum *i);
+static void inb (TrajVars *T, baum *root);
+static void inb_nolp (TrajVars *T, baum *root);
+static void dnb (TrajVars *T, baum *rli);
+static void dnb_nolp (TrajVars *T, baum *rli);
+static void fnb (TrajVars *T, baum *rli);
+static void make_ptypes(TrajVars *T, const short *S);
 /* debugging tool(s) */
 #if 0
-static void rl_status(void);
+static void rl_status(TrajVars *T);
 #endif
 
 /* convert structure in bracked-dot-notation to a ringlist-tree */
-static void struc2tree(char *struc) {
+static void struc2tree(TrajVars *T, char *struc) {
   char* struc_copy;
   int ipos, jpos, balance = 0;
   baum *rli, *rlj;
 
-  struc_copy = (char *)calloc(GSV.len+1, sizeof(char));
+  struc_copy = (char *)calloc(T->len+1, sizeof(char));
   assert(struc_copy);
   strcpy(struc_copy,struc);
 
-  for (ipos = 0; ipos < GSV.len; ipos++) {
+  for (ipos = 0; ipos < T->len; ipos++) {
     if (struc_copy[ipos] == ')') {
       jpos = ipos;
       struc_copy[ipos] = '.';
@@ -97,40 +92,40 @@ static void struc2tree(char *struc) {
       while (struc_copy[--ipos] != '(');
       struc_copy[ipos] = '.';
       balance--;
-      rli = &rl[ipos];
-      rlj = &rl[jpos];
-      close_bp(rli, rlj);
+      rli = &T->rl[ipos];
+      rlj = &T->rl[jpos];
+      close_bp(T, rli, rlj);
     }
   }
 
   if (balance) {
     fprintf(stderr,
 	    "struc2tree(): start structure is not balanced !\n%s\n%s\n",
-	    GAV.farbe, struc);
+	    T->farbe, struc);
     exit(1);
   }
 
 #if HAVE_LIBRNA_API3
-  GSV.currE = GSV.startE = (float)vrna_eval_structure_pt(GAV.vc, pairList) / 100.0;
+  T->currE = T->startE = (float)vrna_eval_structure_pt(T->vc, T->pairList) / 100.0;
 #else
-  GSV.currE = GSV.startE =
-    (float )energy_of_struct_pt_par(GAV.farbe, pairList, typeList,
-				    aliasList, GAV.params, 0) / 100.0;
+  T->currE = T->startE =
+    (float )energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList,
+				    T->aliasList, GAV.params, 0) / 100.0;
 #endif
   {
     int i;
-    for(i = 0; i < GSV.len; i++) {
-      if (pairList[i+1]>i+1)
+    for(i = 0; i < T->len; i++) {
+      if (T->pairList[i+1]>i+1)
 #if HAVE_LIBRNA_API3
-        rl[i].loop_energy = vrna_eval_loop_pt(GAV.vc, i+1, pairList);
+        T->rl[i].loop_energy = vrna_eval_loop_pt(T->vc, i+1, T->pairList);
 #else
-	rl[i].loop_energy = loop_energy(pairList, typeList, aliasList,i+1);
+	T->rl[i].loop_energy = loop_energy(T->pairList, T->typeList, T->aliasList,i+1);
 #endif
     }
 #if HAVE_LIBRNA_API3
-    wurzl->loop_energy = vrna_eval_loop_pt(GAV.vc, 0, pairList);
+    T->wurzl->loop_energy = vrna_eval_loop_pt(T->vc, 0, T->pairList);
 #else
-    wurzl->loop_energy = loop_energy(pairList, typeList, aliasList,0);
+    T->wurzl->loop_energy = loop_energy(T->pairList, T->typeList, T->aliasList,0);
 #endif
   }
 
@@ -138,233 +133,226 @@ static void struc2tree(char *struc) {
 }
 
 /**/
-static void ini_ringlist(void) {
+static void ini_ringlist(TrajVars *T) {
   int i;
 
   /* needed by function energy_of_struct_pt() from Vienna-RNA-1.4 */
-  pairList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(pairList != NULL);
-  typeList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(typeList != NULL);
-  aliasList = (short *)calloc(GSV.len + 2, sizeof(short));
-  assert(aliasList != NULL);
-  pairList[0] = typeList[0] = aliasList[0] = GSV.len;
-  ptype =  (char **)calloc(GSV.len + 2, sizeof(char *));
-  assert(ptype != NULL);
-  for (i=0; i<=GSV.len; i++) {
-    ptype[i] =   (char*)calloc(GSV.len + 2, sizeof(char));
-    assert(ptype[i] != NULL);
+  T->pairList = (short *)calloc(T->len + 2, sizeof(short));
+  assert(T->pairList != NULL);
+  T->typeList = (short *)calloc(T->len + 2, sizeof(short));
+  assert(T->typeList != NULL);
+  T->aliasList = (short *)calloc(T->len + 2, sizeof(short));
+  assert(T->aliasList != NULL);
+  T->pairList[0] = T->typeList[0] = T->aliasList[0] = T->len;
+  T->ptype =  (char **)calloc(T->len + 2, sizeof(char *));
+  assert(T->ptype != NULL);
+  for (i=0; i<=T->len; i++) {
+    T->ptype[i] =   (char*)calloc(T->len + 2, sizeof(char));
+    assert(T->ptype[i] != NULL);
   }
 
   /* allocate virtual root */
-  wurzl = (baum *)calloc(1, sizeof(baum));
-  assert(wurzl != NULL);
+  T->wurzl = (baum *)calloc(1, sizeof(baum));
+  assert(T->wurzl != NULL);
   /* allocate ringList */
-  rl = (baum *)calloc(GSV.len+1, sizeof(baum));
-  assert(rl != NULL);
+  T->rl = (baum *)calloc(T->len+1, sizeof(baum));
+  assert(T->rl != NULL);
   /* allocate PostOrderList */
 
   /* initialize virtualroot */
-  wurzl->typ = 'r';
-  wurzl->nummer = -1;
+  T->wurzl->typ = 'r';
+  T->wurzl->nummer = -1;
   /* connect virtualroot to ringlist-tree in down direction */
-  wurzl->down = &rl[GSV.len];
+  T->wurzl->down = &T->rl[T->len];
   /* initialize post-order list */
 
-  make_pair_matrix();
-
   /* initialize rest of ringlist-tree */
-  for(i = 0; i < GSV.len; i++) {
+  for(i = 0; i < T->len; i++) {
     int c;
-    GAV.currform[i] = '.';
-    GAV.prevform[i] = 'x';
-    pairList[i+1] = 0;
-    rl[i].typ = 'u';
+    T->currform[i] = '.';
+    T->prevform[i] = 'x';
+    T->pairList[i+1] = 0;
+    T->rl[i].typ = 'u';
     /* decode base to numeric value */
-    c = encode_char(GAV.farbe[i]);
-    rl[i].base = typeList[i+1] = c;
-    aliasList[i+1] = alias[typeList[i+1]];
+    c = encode_char(T->farbe[i]);
+    T->rl[i].base = T->typeList[i+1] = c;
+    T->aliasList[i+1] = alias[T->typeList[i+1]];
     /* astablish links for node of the ringlist-tree */
-    rl[i].nummer = i;
-    rl[i].next = &rl[i+1];
-    rl[i].prev = ((i == 0) ? &rl[GSV.len] : &rl[i-1]);
-    rl[i].up = rl[i].down = NULL;
+    T->rl[i].nummer = i;
+    T->rl[i].next = &T->rl[i+1];
+    T->rl[i].prev = ((i == 0) ? &T->rl[T->len] : &T->rl[i-1]);
+    T->rl[i].up = T->rl[i].down = NULL;
   }
-  GAV.currform[GSV.len] =   GAV.prevform[GSV.len] = '\0';
-  make_ptypes(aliasList);
+  T->currform[T->len] =   T->prevform[T->len] = '\0';
+  make_ptypes(T, T->aliasList);
 
-  rl[i].nummer = i;
-  rl[i].base = 0;
+  T->rl[i].nummer = i;
+  T->rl[i].base = 0;
   /* make ringlist circular in next, prev direction */
-  rl[i].next = &rl[0];
-  rl[i].prev = &rl[i-1];
+  T->rl[i].next = &T->rl[0];
+  T->rl[i].prev = &T->rl[i-1];
   /* make virtual basepair for virtualroot */
-  rl[i].up = wurzl;
-  rl[i].typ = 'x';
+  T->rl[i].up = T->wurzl;
+  T->rl[i].typ = 'x';
 
 }
 
-/**/
-void ini_or_reset_rl(void) {
+/* evaluate start and stop structure(s), called once before any trajectory */
+void ini_simulation(void) {
 
-  /* if there is no ringList-tree make a new one */
-  if (wurzl == NULL) {
-    ini_ringlist();
+  make_pair_matrix();
 
-    /* start structure */
-    struc2tree(GAV.startform);
 #if HAVE_LIBRNA_API3
-    GSV.currE = GSV.startE = vrna_eval_structure(GAV.vc, GAV.startform);
+  GSV.startE = vrna_eval_structure(GAV.vc, GAV.startform);
 #else
-    GSV.currE = GSV.startE = energy_of_structure(GAV.farbe, GAV.startform, 0);
+  GSV.startE = energy_of_structure(GAV.farbe_full, GAV.startform, 0);
 #endif
 
-    /* stop structure(s) */
-    if ( GTV.stop )  {
-      int i;
+  /* stop structure(s) */
+  if ( GTV.stop )  {
+    int i;
 
-      qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
+    qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
 #if HAVE_LIBRNA_API3
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      for (i = 0; i< GSV.maxS; i++)
-        GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
-      GAV.vc->length = tmp_n;
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
 #else
-      for (i = 0; i< GSV.maxS; i++)
-	GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
 #endif
-    }
-    else {
+  }
+  else {
 #if HAVE_LIBRNA_API3
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
-      vrna_mx_mfe_free(GAV.vc);
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
-      GAV.vc->length = tmp_n;
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
+    vrna_mx_mfe_free(GAV.vc);
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
 #else
-      if(GTV.noLP)
-	noLonelyPairs=1;
-      initialize_cofold(GSV.len);
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
-      free_arrays();
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
+    if(GTV.noLP)
+      noLonelyPairs=1;
+    initialize_cofold(GSV.len);
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
+    free_arrays();
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
 #endif
-    }
-    GSV.stopE = GAV.sE[0];
-    ini_nbList(strlen(GAV.farbe_full)*strlen(GAV.farbe_full));
+  }
+  GSV.stopE = GAV.sE[0];
+}
+
+/**/
+void ini_or_reset_rl(TrajVars *T) {
+
+  /* if there is no ringList-tree make a new one */
+  if (T->wurzl == NULL) {
+    ini_ringlist(T);
+
+    /* start structure */
+    struc2tree(T, T->startform);
+#if HAVE_LIBRNA_API3
+    T->currE = T->startE = vrna_eval_structure(T->vc, T->startform);
+#else
+    T->currE = T->startE = energy_of_structure(T->farbe, T->startform, 0);
+#endif
+
+    ini_nbList(T, strlen(GAV.farbe_full)*strlen(GAV.farbe_full));
   }
   else {
     /* reset ringlist-tree to start conditions */
-    reset_ringlist();
-    if(GTV.start) struc2tree(GAV.startform);
+    reset_ringlist(T);
+    if(GTV.start) struc2tree(T, T->startform);
     else {
-      GSV.currE = GSV.startE;
+      T->currE = T->startE;
     }
   }
 }
 
 /**/
-static void reset_ringlist(void) {
+static void reset_ringlist(TrajVars *T) {
   int i;
 
-  for(i = 0; i < GSV.len; i++) {
-    GAV.currform[i] = '.';
-    GAV.prevform[i] = 'x';
-    pairList[i+1] = 0;
-    rl[i].typ = 'u';
-    rl[i].next = &rl[i + 1];
-    rl[i].prev = ((i == 0) ? &rl[GSV.len] : &rl[i - 1]);
-    rl[i].up = rl[i].down = NULL;
+  for(i = 0; i < T->len; i++) {
+    T->currform[i] = '.';
+    T->prevform[i] = 'x';
+    T->pairList[i+1] = 0;
+    T->rl[i].typ = 'u';
+    T->rl[i].next = &T->rl[i + 1];
+    T->rl[i].prev = ((i == 0) ? &T->rl[T->len] : &T->rl[i - 1]);
+    T->rl[i].up = T->rl[i].down = NULL;
   }
-  rl[i].next = &rl[0];
-  rl[i].prev = &rl[i-1];
-  rl[i].up = wurzl;
+  T->rl[i].next = &T->rl[0];
+  T->rl[i].prev = &T->rl[i-1];
+  T->rl[i].up = T->wurzl;
 }
 
 /* update ringlist-tree */
-void update_tree(int i, int j) {
+void update_tree(TrajVars *T, int i, int j) {
 
   baum *rli, *rlj, *tempb;
 
-  if ( abs(i) < GSV.len) { /* >> single basepair move */
+  if ( abs(i) < T->len) { /* >> single basepair move */
     if ((i > 0) && (j > 0)) { /* insert */
-      rli = &rl[i-1];
-      rlj = &rl[j-1];
-      close_bp_en(rli, rlj);
+      rli = &T->rl[i-1];
+      rlj = &T->rl[j-1];
+      close_bp_en(T, rli, rlj);
     }
     else if ((i < 0)&&(j < 0)) { /* delete */
       i = -i;
-      rli = &rl[i-1];
-      open_bp_en(rli);
+      rli = &T->rl[i-1];
+      open_bp_en(T, rli);
     }
     else { /* shift */
       if (i > 0) { /* i remains the same, j shifts */
 	j=-j;
-	rli=&rl[i-1];
-	rlj=&rl[j-1];
-	open_bp_en(rli);
+	rli=&T->rl[i-1];
+	rlj=&T->rl[j-1];
+	open_bp_en(T, rli);
 	ORDER(rli, rlj);
-	close_bp_en(rli, rlj);
+	close_bp_en(T, rli, rlj);
       }
       else { /* j remains the same, i shifts */
 	baum *old_rli;
 	i = -i;
-	rli = &rl[i-1];
-	rlj = &rl[j-1];
+	rli = &T->rl[i-1];
+	rlj = &T->rl[j-1];
 	old_rli = rlj->up;
-	open_bp_en(old_rli);
+	open_bp_en(T, old_rli);
 	ORDER(rli, rlj);
-	close_bp_en(rli, rlj);
+	close_bp_en(T, rli, rlj);
       }
     }
   } /* << single basepair move */
   else { /* >> double basepair move */
     if ((i > 0) && (j > 0)) { /* insert */
-      rli = &rl[i-GSV.len-2];
-      rlj = &rl[j-GSV.len-2];
-      close_bp_en(rli->next, rlj->prev);
-      close_bp_en(rli, rlj);
+      rli = &T->rl[i-T->len-2];
+      rlj = &T->rl[j-T->len-2];
+      close_bp_en(T, rli->next, rlj->prev);
+      close_bp_en(T, rli, rlj);
     }
     else if ((i < 0)&&(j < 0)) { /* delete */
       i = -i;
-      rli = &rl[i-GSV.len-2];
-      open_bp_en(rli);
-      open_bp_en(rli->next);
+      rli = &T->rl[i-T->len-2];
+      open_bp_en(T, rli);
+      open_bp_en(T, rli->next);
     }
   } /* << double basepair move */
 
 }
 
 /* open a particular base pair */
-void open_bp(baum *i) {
+void open_bp(TrajVars *T, baum *i) {
 
   baum *in; /* points to i->next */
 
   /* change string representation */
-  GAV.currform[i->nummer] = '.';
-  GAV.currform[i->down->nummer] = '.';
+  T->currform[i->nummer] = '.';
+  T->currform[i->down->nummer] = '.';
 
   /* change pairtable representation */
-  pairList[1 + i->nummer] = 0;
-  pairList[1 + i->down->nummer] = 0;
+  T->pairList[1 + i->nummer] = 0;
+  T->pairList[1 + i->down->nummer] = 0;
 
   /* change tree representation */
   in = i->next;
@@ -378,17 +366,17 @@ void open_bp(baum *i) {
 }
 
 /* close a particular base pair */
-void close_bp (baum *i, baum *j) {
+void close_bp (TrajVars *T, baum *i, baum *j) {
 
   baum *jn; /* points to j->next */
 
   /* change string representation */
-  GAV.currform[i->nummer] = '(';
-  GAV.currform[j->nummer] = ')';
+  T->currform[i->nummer] = '(';
+  T->currform[j->nummer] = ')';
 
   /* change pairtable representation */
-  pairList[1 + i->nummer] = 1+ j->nummer;
-  pairList[1 + j->nummer] = 1 + i->nummer;
+  T->pairList[1 + i->nummer] = 1+ j->nummer;
+  T->pairList[1 + j->nummer] = 1 + i->nummer;
 
   /* change tree representation */
   jn = j->next;
@@ -404,11 +392,11 @@ void close_bp (baum *i, baum *j) {
 
 # if 0
 /* for a given tree, generate postorder-list */
-static void make_poList (baum *root) {
+static void make_poList (TrajVars *T, baum *root) {
 
   baum *stop, *rli;
 
-  if (!root) root = wurzl;
+  if (!root) root = T->wurzl;
   stop = root->down;
 
   /* foreach base in ringlist ... */
@@ -417,11 +405,11 @@ static void make_poList (baum *root) {
     if (rli->typ == 'p') {
       /*  fprintf(stderr, "%d >%d<\n", poListop, rli->nummer); */
       poList[poListop++] = rli;
-      if ( poListop > GSV.len+1 ) {
+      if ( poListop > T->len+1 ) {
 	fprintf(stderr, "Something went wrong in make_poList()\n");
 	exit(1);
       }
-      make_poList(rli);
+      make_poList(T, rli);
     }
   }
   return;
@@ -430,7 +418,7 @@ static void make_poList (baum *root) {
 
 /* for a given ringlist, generate all structures
    with one additional basepair */
-static void inb(baum *root) {
+static void inb(TrajVars *T, baum *root) {
 
   int EoT;
   int E_old, E_new_in, E_new_out;
@@ -449,24 +437,24 @@ static void inb(baum *root) {
       /* potential j-position is already paired */
       if(rlj->typ=='p') continue;
       /* if i-j can form a base pair ... */
-      if(ptype[rli->nummer][rlj->nummer]){
+      if(T->ptype[rli->nummer][rlj->nummer]){
 	/* close the base bair and ... */
-	close_bp(rli,rlj);
+	close_bp(T, rli,rlj);
 #if HAVE_LIBRNA_API3
-        E_new_in  = vrna_eval_loop_pt(GAV.vc, rli->nummer+1, pairList);
-        E_new_out = vrna_eval_loop_pt(GAV.vc, root->nummer+1, pairList);
+        E_new_in  = vrna_eval_loop_pt(T->vc, rli->nummer+1, T->pairList);
+        E_new_out = vrna_eval_loop_pt(T->vc, root->nummer+1, T->pairList);
 #else
-	E_new_in  = loop_energy(pairList, typeList, aliasList,rli->nummer+1);
-	E_new_out = loop_energy(pairList, typeList, aliasList,root->nummer+1);
+	E_new_in  = loop_energy(T->pairList, T->typeList, T->aliasList,rli->nummer+1);
+	E_new_out = loop_energy(T->pairList, T->typeList, T->aliasList,root->nummer+1);
 #endif
 	/* ... evaluate energy of the structure */
-	EoT = (int) (GSV.currE*100 + ((GSV.currE<0)?-0.4:0.4)) +  E_new_in + E_new_out - E_old ;
-	/* assert(EoT ==  energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params)); */
+	EoT = (int) (T->currE*100 + ((T->currE<0)?-0.4:0.4)) +  E_new_in + E_new_out - E_old ;
+	/* assert(EoT ==  energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params)); */
 	/* open the base pair again... */
-	open_bp(rli);
+	open_bp(T, rli);
 	/* ... and put the move and the enegy
 	   of the structure into the neighbour list */
-	update_nbList(1 + rli->nummer, 1 + rlj->nummer, EoT);
+	update_nbList(T, 1 + rli->nummer, 1 + rlj->nummer, EoT);
       }
     }
   }
@@ -474,7 +462,7 @@ static void inb(baum *root) {
 
 /* for a given ringlist, generate all structures (canonical)
    with one additional base pair (BUT WITHOUT ISOLATED BASE PAIRS) */
-static void inb_nolp(baum *root) {
+static void inb_nolp(TrajVars *T, baum *root) {
 
   int EoT = 0;
   baum *stop, *rli, *rlj;
@@ -491,44 +479,44 @@ static void inb_nolp(baum *root) {
       /* potential j-position is already paired */
       if (rlj->typ=='p') continue;
       /* if i-j can form a base pair ... */
-      if (ptype[rli->nummer][rlj->nummer]) {
+      if (T->ptype[rli->nummer][rlj->nummer]) {
 	/* ... and extends a helix ... */
 	if (((rli->prev==stop && rlj->next==stop) && stop->typ != 'x') ||
 	    (rli->next == rlj->prev)) {
 	  /* ... close the base bair and ... */
-	  close_bp(rli,rlj);
+	  close_bp(T, rli,rlj);
 	  /* ... evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-	  EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+	  EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-	  EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+	  EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
 	  /* open the base pair again... */
-	  open_bp(rli);
+	  open_bp(T, rli);
 	  /* ... and put the move and the enegy
 	     of the structure into the neighbour list */
-	  update_nbList(1 + rli->nummer, 1 + rlj->nummer, EoT);
+	  update_nbList(T, 1 + rli->nummer, 1 + rlj->nummer, EoT);
 	}
 	/* if double insertion is possible ... */
 	else if ((rlj->nummer - rli->nummer >= MYTURN+2)&&
 		 (rli->next->typ != 'p' && rlj->prev->typ != 'p') &&
 		 (rli->next->next != rlj->prev->prev) &&
-		 (ptype[rli->next->nummer][rlj->prev->nummer])) {
+		 (T->ptype[rli->next->nummer][rlj->prev->nummer])) {
 	  /* close the two base bair and ... */
-	  close_bp(rli->next, rlj->prev);
-	  close_bp(rli, rlj);
+	  close_bp(T, rli->next, rlj->prev);
+	  close_bp(T, rli, rlj);
 	  /* ... evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-	  EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+	  EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-	  EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+	  EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
 	  /* open the two base pair again ... */
-	  open_bp(rli);
-	  open_bp(rli->next);
+	  open_bp(T, rli);
+	  open_bp(T, rli->next);
 	  /* ... and put the move and the enegy
 	     of the structure into the neighbour list */
-	  update_nbList(1+rli->nummer+GSV.len+1, 1+rlj->nummer+GSV.len+1, EoT);
+	  update_nbList(T, 1+rli->nummer+T->len+1, 1+rlj->nummer+T->len+1, EoT);
 	}
       }
     }
@@ -537,35 +525,35 @@ static void inb_nolp(baum *root) {
 
 /* for a given ringlist, generate all structures
  with one less base pair */
-static void dnb(baum *rli){
+static void dnb(TrajVars *T, baum *rli){
 
   int EoT, E_old_in, E_old_out, E_new;
 
   baum *rlj, *r;
 
   rlj=rli->down;
-  open_bp(rli);
+  open_bp(T, rli);
   /* ... evaluate energy of the structure */
 
   for (r=rli->next; r->up==NULL; r=r->next);
   E_old_in = rli->loop_energy;
   E_old_out = r->up->loop_energy;
 #if HAVE_LIBRNA_API3
-  E_new = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
+  E_new = vrna_eval_loop_pt(T->vc, r->up->nummer+1, T->pairList);
 #else
-  E_new = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
+  E_new = loop_energy(T->pairList,T->typeList,T->aliasList,r->up->nummer+1);
 #endif
-  EoT = (int) (GSV.currE*100 + ((GSV.currE<0)?-0.4:0.4)) -
+  EoT = (int) (T->currE*100 + ((T->currE<0)?-0.4:0.4)) -
     E_old_in - E_old_out + E_new;
 
-  /* assert(EoT== energy_of_struct_pt(GAV.farbe, pairList, typeList, aliasList));*/
-  close_bp(rli,rlj);
-  update_nbList(-(1 + rli->nummer), -(1 + rlj->nummer), EoT);
+  /* assert(EoT== energy_of_struct_pt(T->farbe, T->pairList, T->typeList, T->aliasList));*/
+  close_bp(T, rli,rlj);
+  update_nbList(T, -(1 + rli->nummer), -(1 + rlj->nummer), EoT);
 }
 
 /* for a given ringlist, generate all structures (canonical)
  with one less base pair (BUT WITHOUT ISOLATED BASE PAIRS) */
-static void dnb_nolp(baum *rli) {
+static void dnb_nolp(TrajVars *T, baum *rli) {
 
   int EoT = 0;
   baum *rlj;
@@ -591,44 +579,44 @@ static void dnb_nolp(baum *rli) {
   /* double delete ? */
   if (rlip==NULL && rlin && rljn->next != rljn->prev ) {
     /* open the two base pairs ... */
-    open_bp(rli);
-    open_bp(rlin);
+    open_bp(T, rli);
+    open_bp(T, rlin);
     /* ... evaluate energy of the structure ... */
 #if HAVE_LIBRNA_API3
-    EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+    EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-    EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+    EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
     /* ... and put the move and the enegy
        of the structure into the neighbour list ... */
-    update_nbList(-(1+rli->nummer+GSV.len+1),-(1+rlj->nummer+GSV.len+1), EoT);
+    update_nbList(T, -(1+rli->nummer+T->len+1),-(1+rlj->nummer+T->len+1), EoT);
     /* ... and close the two base pairs again */
-    close_bp(rlin, rljn);
-    close_bp(rli, rlj);
+    close_bp(T, rlin, rljn);
+    close_bp(T, rli, rlj);
   } else { /* single delete */
     /* the following will work only if boolean expr are shortcicuited */
     if (rlip==NULL || (rlip->prev == rlip->next && rlip->prev->typ != 'x'))
       if (rlin ==NULL || (rljn->next == rljn->prev)) {
 	/* open the base pair ... */
-	open_bp(rli);
+	open_bp(T, rli);
 	/* ... evaluate energy of the structure ... */
 #if HAVE_LIBRNA_API3
-	EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+	EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-	EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+	EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
 	/* ... and put the move and the enegy
 	   of the structure into the neighbour list ... */
-	update_nbList(-(1 + rli->nummer),-(1 + rlj->nummer), EoT);
+	update_nbList(T, -(1 + rli->nummer),-(1 + rlj->nummer), EoT);
 	/* and close the base pair again */
-	close_bp(rli, rlj);
+	close_bp(T, rli, rlj);
       }
   }
 }
 
 /* for a given ringlist, generate all structures
  with one shifted base pair */
-static void fnb(baum *rli) {
+static void fnb(TrajVars *T, baum *rli) {
 
   int EoT = 0, x;
   baum *rlj, *stop, *help_rli, *help_rlj;
@@ -642,43 +630,43 @@ static void fnb(baum *rli) {
     if ((rlj->typ=='p')||(rlj->typ=='q')) continue;
     /* j-position of base pair shifts to k position (ij)->(ik) i<k<j */
     if ( (rlj->nummer-rli->nummer >= MYTURN)
-	 && (ptype[rli->nummer][rlj->nummer]) ) {
+	 && (T->ptype[rli->nummer][rlj->nummer]) ) {
       /* open original basepair */
-      open_bp(rli);
+      open_bp(T, rli);
       /* close shifted version of original basepair */
-      close_bp(rli, rlj);
+      close_bp(T, rli, rlj);
       /* evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+      EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+      EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
       /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(1+rli->nummer, -(1+rlj->nummer), EoT);
+      update_nbList(T, 1+rli->nummer, -(1+rlj->nummer), EoT);
       /* open shifted basepair */
-      open_bp(rli);
+      open_bp(T, rli);
       /* restore original basepair */
-      close_bp(rli, stop);
+      close_bp(T, rli, stop);
     }
     /* i-position of base pair shifts to position k (ij)->(kj) i<k<j */
     if ( (stop->nummer-rlj->nummer >= MYTURN)
-	 && (ptype[stop->nummer][rlj->nummer]) ) {
+	 && (T->ptype[stop->nummer][rlj->nummer]) ) {
       /* open original basepair */
-      open_bp(rli);
+      open_bp(T, rli);
       /* close shifted version of original basepair */
-      close_bp(rlj, stop);
+      close_bp(T, rlj, stop);
       /* evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+      EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+      EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
       /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(-(1 + rlj->nummer), 1 + stop->nummer, EoT);
+      update_nbList(T, -(1 + rlj->nummer), 1 + stop->nummer, EoT);
       /* open shifted basepair */
-      open_bp(rlj);
+      open_bp(T, rlj);
       /* restore original basepair */
-      close_bp(rli, stop);
+      close_bp(T, rli, stop);
     }
   }
   /* examin exterior loop of bp(ij);   (.......)
@@ -688,7 +676,7 @@ static void fnb(baum *rli) {
     x=rlj->nummer-rli->nummer;
     if (x<0) x=-x;
     /* j-position of base pair shifts to position k */
-    if ((x >= MYTURN) && (ptype[rli->nummer][rlj->nummer])) {
+    if ((x >= MYTURN) && (T->ptype[rli->nummer][rlj->nummer])) {
       if (rli->nummer<rlj->nummer) {
 	help_rli=rli;
 	help_rlj=rlj;
@@ -698,26 +686,26 @@ static void fnb(baum *rli) {
 	help_rlj=rli;
       }
       /* open original basepair */
-      open_bp(rli);
+      open_bp(T, rli);
       /* close shifted version of original basepair */
-      close_bp(help_rli,help_rlj);
+      close_bp(T, help_rli,help_rlj);
       /* evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+      EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+      EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
       /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(1 + rli->nummer, -(1 + rlj->nummer), EoT);
+      update_nbList(T, 1 + rli->nummer, -(1 + rlj->nummer), EoT);
       /* open shifted base pair */
-      open_bp(help_rli);
+      open_bp(T, help_rli);
       /* restore original basepair */
-      close_bp(rli,stop);
+      close_bp(T, rli,stop);
     }
     x = rlj->nummer-stop->nummer;
     if (x < 0) x = -x;
     /* i-position of base pair shifts to position k */
-    if ((x >= MYTURN) && (ptype[stop->nummer][rlj->nummer])) {
+    if ((x >= MYTURN) && (T->ptype[stop->nummer][rlj->nummer])) {
       if (stop->nummer < rlj->nummer) {
 	help_rli = stop;
 	help_rlj = rlj;
@@ -727,55 +715,55 @@ static void fnb(baum *rli) {
 	help_rlj = stop;
       }
       /* open original basepair */
-      open_bp(rli);
+      open_bp(T, rli);
        /* close shifted version of original basepair */
-      close_bp(help_rli, help_rlj);
+      close_bp(T, help_rli, help_rlj);
       /* evaluate energy of the structure */
 #if HAVE_LIBRNA_API3
-      EoT = vrna_eval_structure_pt(GAV.vc, pairList);
+      EoT = vrna_eval_structure_pt(T->vc, T->pairList);
 #else
-      EoT = energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0);
+      EoT = energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0);
 #endif
       /* put the move and the enegy of the structure into the neighbour list */
-      update_nbList(-(1 + rlj->nummer), 1 + stop->nummer, EoT);
+      update_nbList(T, -(1 + rlj->nummer), 1 + stop->nummer, EoT);
       /* open shifted basepair */
-      open_bp(help_rli);
+      open_bp(T, help_rli);
       /* restore original basepair */
-      close_bp(rli,stop);
+      close_bp(T, rli,stop);
     }
   }
 }
 
 /* for a given tree (structure),
    generate all neighbours according to moveset */
-void move_it (void) {
+void move_it (TrajVars *T) {
   int i;
   
 #if HAVE_LIBRNA_API3
-  GSV.currE = (float)vrna_eval_structure_pt(GAV.vc, pairList)/100.;
+  T->currE = (float)vrna_eval_structure_pt(T->vc, T->pairList)/100.;
 #else
-  GSV.currE =
-    energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0)/100.;
+  T->currE =
+    energy_of_struct_pt_par(T->farbe, T->pairList, T->typeList, T->aliasList, GAV.params, 0)/100.;
 #endif
   
   if ( GTV.noLP ) { /* canonical neighbours only */
-    inb_nolp(wurzl);
-    for (i = 0; i < GSV.len; i++) {
+    inb_nolp(T, T->wurzl);
+    for (i = 0; i < T->len; i++) {
       
-      if (pairList[i+1]>i+1) {
-	inb_nolp(rl+i);      /* insert pair neighbours */
-	dnb_nolp(rl+i);  /* delete pair neighbour */
+      if (T->pairList[i+1]>i+1) {
+	inb_nolp(T, T->rl+i);      /* insert pair neighbours */
+	dnb_nolp(T, T->rl+i);  /* delete pair neighbour */
       }
     }
   }
   else { /* all neighbours */
-    inb(wurzl);
-    for (i = 0; i < GSV.len; i++) {
+    inb(T, T->wurzl);
+    for (i = 0; i < T->len; i++) {
       
-      if (pairList[i+1]>i+1) {
-	inb(rl+i); 	 /* insert pair neighbours */
-	dnb(rl+i);  /* delete pair neighbour */
-	if ( GTV.noShift == 0 ) fnb(rl+i);
+      if (T->pairList[i+1]>i+1) {
+	inb(T, T->rl+i); 	 /* insert pair neighbours */
+	dnb(T, T->rl+i);  /* delete pair neighbour */
+	if ( GTV.noShift == 0 ) fnb(T, T->rl+i);
       }
     }
   }
@@ -783,17 +771,19 @@ void move_it (void) {
 
 
 /**/
-void clean_up_rl(void) {
+void clean_up_rl(TrajVars *T) {
   int i;
-  free(pairList); pairList=NULL;
-  free(typeList); typeList = NULL;
-  free(aliasList); aliasList = NULL;
-  free(rl); rl=NULL;
-  free(wurzl);  wurzl=NULL;
-  for (i=0; i<=GSV.len; i++)
-    free(ptype[i]);
-  free(ptype);
-  ptype=NULL;
+  free(T->pairList); T->pairList=NULL;
+  free(T->typeList); T->typeList = NULL;
+  free(T->aliasList); T->aliasList = NULL;
+  free(T->rl); T->rl=NULL;
+  free(T->wurzl);  T->wurzl=NULL;
+  /* chain growth may have changed T->len since allocation */
+  if (T->ptype)
+    for (i=0; T->ptype[i]; i++)
+      free(T->ptype[i]);
+  free(T->ptype);
+  T->ptype=NULL;
 }
 
 /**/
@@ -806,27 +796,27 @@ static int comp_struc(const void *A, const void *B) {
 
 #if 0
 /**/
-static void rl_status(void) {
+static void rl_status(TrajVars *T) {
 
   int i;
 
-  printf("\n%s\n%s\n", GAV.farbe, GAV.currform);
-  for (i=0; i <= GSV.len; i++) {
+  printf("\n%s\n%s\n", T->farbe, T->currform);
+  for (i=0; i <= T->len; i++) {
     printf("%2d %c %c %2d %2d %2d %2d\n",
-	   rl[i].nummer,
-	   i == GSV.len ? 'X': GAV.farbe[i],
-	   rl[i].typ,
-	   rl[i].up==NULL?0:(rl[i].up)->nummer,
-	   rl[i].down==NULL?0:(rl[i].down)->nummer,
-	   (rl[i].prev)->nummer,
-	   (rl[i].next)->nummer);
+	   T->rl[i].nummer,
+	   i == T->len ? 'X': T->farbe[i],
+	   T->rl[i].typ,
+	   T->rl[i].up==NULL?0:(T->rl[i].up)->nummer,
+	   T->rl[i].down==NULL?0:(T->rl[i].down)->nummer,
+	   (T->rl[i].prev)->nummer,
+	   (T->rl[i].next)->nummer);
   }
   printf("---\n");
 }
 #endif
 
 #define TURN 3
-static void make_ptypes(const short *S) {
+static void make_ptypes(TrajVars *T, const short *S) {
   int n,i,j,k,l;
   n=S[0];
   for (k=1; k<n; k++)
@@ -840,7 +830,7 @@ static void make_ptypes(const short *S) {
 	if ((i>1)&&(j<n)) ntype = pair[S[i-1]][S[j+1]];
 	if (noLonelyPairs && (!otype) && (!ntype))
 	  type = 0; /* i.j can only form isolated pairs */
-	ptype[i-1][j-1] = ptype[j-1][i-1] = (char) type;
+	T->ptype[i-1][j-1] = T->ptype[j-1][i-1] = (char) type;
 	otype =  type;
 	type  = ntype;
 	i--; j++;
@@ -848,35 +838,35 @@ static void make_ptypes(const short *S) {
     }
 }
 
-static void close_bp_en (baum *i, baum *j) {
+static void close_bp_en (TrajVars *T, baum *i, baum *j) {
   /* close bp and update energy */
   baum *r;
-  close_bp(i,j);
+  close_bp(T, i,j);
 
 #if HAVE_LIBRNA_API3
-  i->loop_energy = vrna_eval_loop_pt(GAV.vc, i->nummer+1, pairList);
+  i->loop_energy = vrna_eval_loop_pt(T->vc, i->nummer+1, T->pairList);
 #else
-  i->loop_energy = loop_energy(pairList,typeList,aliasList,i->nummer+1);
+  i->loop_energy = loop_energy(T->pairList,T->typeList,T->aliasList,i->nummer+1);
 #endif
 
   for (r=i->next; r->up==NULL; r=r->next);
 
 #if HAVE_LIBRNA_API3
-  r->up->loop_energy = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
+  r->up->loop_energy = vrna_eval_loop_pt(T->vc, r->up->nummer+1, T->pairList);
 #else
-  r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
+  r->up->loop_energy = loop_energy(T->pairList,T->typeList,T->aliasList,r->up->nummer+1);
 #endif
 };
 
-static void open_bp_en (baum *i) {
+static void open_bp_en (TrajVars *T, baum *i) {
   /* open bp and update energy */
   baum *r;
   i->loop_energy=0;
-  open_bp(i);
+  open_bp(T, i);
   for (r=i->next; r->up==NULL; r=r->next);
 #if HAVE_LIBRNA_API3
-  r->up->loop_energy = vrna_eval_loop_pt(GAV.vc, r->up->nummer+1, pairList);
+  r->up->loop_energy = vrna_eval_loop_pt(T->vc, r->up->nummer+1, T->pairList);
 #else
-  r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
+  r->up->loop_energy = loop_energy(T->pairList,T->typeList,T->aliasList,r->up->nummer+1);
 #endif
 };
@@ -9,12 +9,15 @@
 #ifndef BAUM_H
 #define BAUM_H
 
+#include "globals.h"
+
 /* used in main.c */
-extern void ini_or_reset_rl(void);
-extern void move_it(void);
-extern void clean_up_rl(void);
+extern void ini_simulation(void);
+extern void ini_or_reset_rl(TrajVars *T);
+extern void move_it(TrajVars *T);
+extern void clean_up_rl(TrajVars *T);
 
 /* used in nachbar.c */
-extern void update_tree(int i,int j);
+extern void update_tree(TrajVars *T, int i,int j);
 
 #endif
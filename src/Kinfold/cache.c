@@ -11,6 +11,8 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/utils.h>
@@ -22,124 +24,307 @@
 
 #ifdef __GNUC__
 # define INLINE inline
+# define COUNT(x) __sync_fetch_and_add(&(x), 1UL)
 #else
 # define INLINE
+# define COUNT(x) ((x)++)
 #endif
 
 /*
-  modify cache_f(), cache_comp() and the typedef of cache_entry
-  in cache_utils.h to suit your application
+  open addressing hash table with linear probing
+
+  keys are structures packed into 2 bits per position, i.e. 32
+  positions per 64bit word. Lookups and inserts never look further
+  than PROBE_WINDOW slots away from the home slot of a key. Once the
+  table reached its maximum size, an insert into a full probe window
+  replaces the entry in the home slot. Since slots are never emptied
+  again, this keeps all other probe sequences intact.
 */
 
 /* PUBLIC FUNCTIONES */
-cache_entry *lookup_cache (char *x);
-int write_cache (cache_entry *x);
-/*  void delete_cache (cache_entry *x); */
+void initialize_cache(unsigned long max_size);
+int lookup_cache (const char *x, cache_entry *dest);
+int write_cache (const char *x, cache_entry *c);
+void get_cache_stats(cache_stats *s);
 void kill_cache();
-void initialize_cache();
 
 /* PRIVATE FUNCTIONES */
-/*  static int cache_comp(cache_entry *x, cache_entry *y); */
-INLINE static unsigned cache_f (char *x);
-
-/* #define CACHESIZE 67108864 -1 */ /* 2^26 -1   must be power of 2 -1 */
-/* #define CACHESIZE 33554432 -1 */ /* 2^25 -1   must be power of 2 -1 */
-/* #define CACHESIZE 16777216 -1 */ /* 2^24 -1   must be power of 2 -1 */ 
-/* #define CACHESIZE  4194304 -1 */ /* 2^22 -1   must be power of 2 -1 */
-#define CACHESIZE  1048576 -1  /* 2^20 -1   must be power of 2 -1 */
-/* #define CACHESIZE   262144 -1 */ /* 2^18 -1   must be power of 2 -1 */
-/* next is default */
-/* #define CACHESIZE    65536 -1 */ /* 2^16 -1   must be power of 2 -1 */
-/* #define CACHESIZE    16384 -1 */ /* 2^14 -1   must be power of 2 -1 */
-/* #define CACHESIZE     4096 -1 */ /* 2^12 -1   must be power of 2 -1 */
-
-static cache_entry *cachetab[CACHESIZE+1];
+typedef struct {
+  uint64_t    hash;    /* 0 marks an empty slot */
+  int         len;     /* length of the structure */
+  uint64_t    *key;    /* packed structure */
+  cache_entry *entry;
+} cache_slot;
+
+INLINE static int key_words(int len);
+INLINE static uint64_t cache_f(const uint64_t *key, int len);
+static uint64_t *pack_key(const char *x, int len, uint64_t *buf);
+static cache_slot *find_slot(cache_slot *tab, unsigned long size, uint64_t hash, int len, const uint64_t *key, int *found, unsigned long *collisions);
+static void alloc_cache(unsigned long size);
+static void resize_cache(unsigned long size);
+static void free_entry(cache_entry *c);
+
+#define PROBE_WINDOW    16
+#define MIN_CACHESIZE   4096       /* 2^12  must be power of 2 */
+#define INI_CACHESIZE   65536      /* 2^16  must be power of 2 */
+#define DEF_CACHESIZE   1048576    /* 2^20  default upper limit */
+#define MAX_CACHESIZE   1073741824 /* 2^30  hard upper limit */
+#define KEY_BUF_WORDS   64         /* keys up to 2048 nt live on the stack */
+
+static cache_slot *cachetab = NULL;
+static cache_stats stats = { 0, 0, 0, 0, 0, 0, 0 };
+static pthread_rwlock_t cache_lock = PTHREAD_RWLOCK_INITIALIZER;
 static char UNUSED rcsid[] ="$Id: cache.c,v 1.3 2006/10/04 12:45:12 xtof Exp $";
-unsigned long collisions=0;
-
-/* stolen from perl source */
-char coeff[] = {
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1};
-
-/* key must not be longer than 128 */
-INLINE static unsigned cache_f(char *x) { 
-  register char *s;
-  register int i;
-  register unsigned cache;
-
-  s = x;
-
-  for (i=0,    cache = 0;
-       /* while */ *s;
-       s++,           i++ , cache *= 5 ) {
-    cache += *s * coeff[i];
+
+INLINE static int key_words(int len) {
+  return (len + 31) / 32;
+}
+
+/* mix 64bit words of the packed structure (murmur3 finalizer) */
+INLINE static uint64_t cache_f(const uint64_t *key, int len) {
+  int i, n;
+  uint64_t h;
+
+  n = key_words(len);
+  h = (uint64_t)len * 0x9e3779b97f4a7c15ULL;
+  for (i = 0; i < n; i++) {
+    h ^= key[i];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
   }
 
-   /* divide through CACHESIZE for normalization */
-  return ((cache) & (CACHESIZE));
+  /* 0 is reserved for empty slots */
+  return (h) ? h : 1;
 }
 
+/* '.' -> 0, '(' -> 1, ')' -> 2 */
+static uint64_t *pack_key(const char *x, int len, uint64_t *buf) {
+  int i, n;
+  uint64_t c;
 
-/* returns NULL unless x is in the cache */
-cache_entry *lookup_cache (char *x) {
-  int cacheval;
-  cache_entry *c;
+  n = key_words(len);
+  if (n > KEY_BUF_WORDS)
+    buf = (uint64_t *)malloc(n * sizeof(uint64_t));
+
+  memset(buf, 0, n * sizeof(uint64_t));
+  for (i = 0; i < len; i++) {
+    switch (x[i]) {
+      case '(': c = 1; break;
+      case ')': c = 2; break;
+      case '.': c = 0; break;
+      default:  c = 3; break;
+    }
+    buf[i >> 5] |= c << (2 * (i & 31));
+  }
+
+  return buf;
+}
+
+/*
+  find slot holding key or the first free one within the probe window,
+  occupied slots passed on the way are counted in collisions unless
+  it is NULL
+*/
+static cache_slot *find_slot(cache_slot *tab, unsigned long size, uint64_t hash,
+                             int len, const uint64_t *key, int *found,
+                             unsigned long *collisions) {
+  unsigned long i, p;
+  cache_slot *s;
+
+  *found = 0;
+  for (i = 0, p = hash & (size - 1); i < PROBE_WINDOW; i++, p = (p + 1) & (size - 1)) {
+    s = tab + p;
+    if (s->hash == 0) return s;
+    if ((s->hash == hash) && (s->len == len) &&
+        (memcmp(s->key, key, key_words(len) * sizeof(uint64_t)) == 0)) {
+      *found = 1;
+      return s;
+    }
+    if (collisions) COUNT(*collisions);
+  }
 
-  cacheval=cache_f(x);
-  if ((c=cachetab[cacheval]))
-    if (strcmp(c->structure,x)==0) return c;
-  
   return NULL;
 }
 
-/* returns 1 if x already was in the cache */
-int write_cache (cache_entry *x) {
-  int cacheval;
+/**/
+static void free_entry(cache_entry *c) {
+  free(c->neighbors);
+  free(c->rates);
+  free(c->energies);
+  free(c);
+}
+
+/* allocate an empty table of size slots, write lock must be held */
+static void alloc_cache(unsigned long size) {
+  cachetab = (cache_slot *)calloc(size, sizeof(cache_slot));
+  if (cachetab == NULL) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+  stats.size  = size;
+  stats.count = 0;
+}
+
+/* rehash into a table of size slots, write lock must be held */
+static void resize_cache(unsigned long size) {
+  unsigned long i, old_size;
+  int found;
+  cache_slot *old, *s;
+
+  old      = cachetab;
+  old_size = stats.size;
+  alloc_cache(size);
+
+  /* rehashing is not a lookup, so probes are not counted as collisions */
+  for (i = 0; i < old_size; i++) {
+    if (old[i].hash == 0) continue;
+    s = find_slot(cachetab, size, old[i].hash, old[i].len, old[i].key, &found, NULL);
+    if (s == NULL) {
+      /* probe window overflow, drop the entry */
+      free(old[i].key);
+      free_entry(old[i].entry);
+      stats.evictions++;
+      continue;
+    }
+    *s = old[i];
+    stats.count++;
+  }
+  free(old);
+}
+
+/*
+  set the maximal size of the cache and allocate it, must be called
+  before any other thread accesses the cache. Otherwise, the first
+  write allocates a cache of default size.
+*/
+void initialize_cache (unsigned long max_size) {
+  unsigned long size;
+
+  if (max_size == 0) max_size = DEF_CACHESIZE;
+  if (max_size < MIN_CACHESIZE) max_size = MIN_CACHESIZE;
+  if (max_size > MAX_CACHESIZE) max_size = MAX_CACHESIZE;
+
+  pthread_rwlock_wrlock(&cache_lock);
+  /* round up to next power of 2 */
+  for (size = MIN_CACHESIZE; size < max_size; size <<= 1);
+  stats.max_size = size;
+  if (size > INI_CACHESIZE) size = INI_CACHESIZE;
+
+  if (cachetab == NULL) alloc_cache(size);
+  pthread_rwlock_unlock(&cache_lock);
+}
+
+/*
+  returns 0 unless x is in the cache, otherwise copies its neighbourhood
+  into the arrays of dest, which must be large enough to hold them
+*/
+int lookup_cache (const char *x, cache_entry *dest) {
+  int len, found;
+  uint64_t kbuf[KEY_BUF_WORDS], *key, hash;
+  cache_slot *s;
   cache_entry *c;
-  
-  cacheval=cache_f(x->structure);
-  if ((c=cachetab[cacheval])) {
-    free(c->structure);
-    free(c->neighbors);
-    free(c->rates);
-    free(c->energies);
-    free(c);
+
+  len  = strlen(x);
+  key  = pack_key(x, len, kbuf);
+  hash = cache_f(key, len);
+
+  pthread_rwlock_rdlock(&cache_lock);
+  /* nothing has been written yet if the cache does not exist */
+  if (cachetab) s = find_slot(cachetab, stats.size, hash, len, key, &found, &stats.collisions);
+  else found = 0;
+  if (found) {
+    c = s->entry;
+    dest->top    = c->top;
+    dest->lmin   = c->lmin;
+    dest->flux   = c->flux;
+    dest->energy = c->energy;
+    memcpy(dest->neighbors, c->neighbors, 2*c->top*sizeof(short));
+    memcpy(dest->rates, c->rates, c->top*sizeof(float));
+    memcpy(dest->energies, c->energies, c->top*sizeof(double));
+    COUNT(stats.hits);
   }
-  cachetab[cacheval]=x;
-  return 0;
+  else COUNT(stats.misses);
+  pthread_rwlock_unlock(&cache_lock);
+
+  if (key != kbuf) free(key);
+  return found;
+}
+
+/* the cache takes ownership of c, returns 1 if x already was in the cache */
+int write_cache (const char *x, cache_entry *c) {
+  int len, found;
+  uint64_t kbuf[KEY_BUF_WORDS], *key, hash;
+  cache_slot *s;
+
+  len  = strlen(x);
+  key  = pack_key(x, len, kbuf);
+  hash = cache_f(key, len);
+
+  pthread_rwlock_wrlock(&cache_lock);
+  /* lazy initialization happens under the write lock */
+  if (cachetab == NULL) {
+    if (stats.max_size == 0) stats.max_size = DEF_CACHESIZE;
+    alloc_cache((stats.max_size > INI_CACHESIZE) ? INI_CACHESIZE : stats.max_size);
+  }
+
+  /* grow at a load factor of 1/2 */
+  if ((2 * (stats.count + 1) > stats.size) && (stats.size < stats.max_size))
+    resize_cache(2 * stats.size);
+
+  s = find_slot(cachetab, stats.size, hash, len, key, &found, &stats.collisions);
+  if (s == NULL) {
+    /* full probe window, replace the entry in the home slot */
+    s = cachetab + (hash & (stats.size - 1));
+    free(s->key);
+    free_entry(s->entry);
+    s->key = NULL;
+    stats.evictions++;
+    stats.count--;
+  }
+
+  if (found) {
+    free_entry(s->entry);
+  }
+  else {
+    s->hash = hash;
+    s->len  = len;
+    s->key  = (uint64_t *)malloc(key_words(len) * sizeof(uint64_t));
+    memcpy(s->key, key, key_words(len) * sizeof(uint64_t));
+    stats.count++;
+  }
+  s->entry = c;
+  pthread_rwlock_unlock(&cache_lock);
+
+  if (key != kbuf) free(key);
+  return found;
 }
 
 /**/
-void initialize_cache () { }
+void get_cache_stats(cache_stats *s) {
+  pthread_rwlock_rdlock(&cache_lock);
+  *s = stats;
+  pthread_rwlock_unlock(&cache_lock);
+}
 
 /**/
 void kill_cache () {
-  int i;
-  
-  for (i=0;i<CACHESIZE+1;i++) {
-    if ( cachetab[i] ) {
-      free (cachetab[i]->structure);
-      free (cachetab[i]->neighbors);
-      free (cachetab[i]->rates);
-      free (cachetab[i]->energies);
-      free (cachetab[i]);
+  unsigned long i;
+
+  pthread_rwlock_wrlock(&cache_lock);
+  if (cachetab) {
+    for (i = 0; i < stats.size; i++) {
+      if (cachetab[i].hash) {
+        free(cachetab[i].key);
+        free_entry(cachetab[i].entry);
+      }
     }
-    cachetab[i]=NULL;
+    free(cachetab);
+    cachetab = NULL;
   }
+  stats.size = stats.count = 0;
+  pthread_rwlock_unlock(&cache_lock);
 }
 
-#if 0
-/**/
-static int cache_comp(cache_entry *x, cache_entry *y) {
-  return strcmp(((cache_entry *)x)->structure, ((cache_entry *)y)->structure);
-}
-#endif
-
 /* End of file */
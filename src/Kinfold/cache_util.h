@@ -16,18 +16,34 @@
 #endif
 
 typedef struct {
-  char *structure;
   int top;           /* number of neighbors */
   int lmin;          /* is a local minimum ? */
   double flux;       /* sum of rates */
   double energy;     /* energy of this structure */
-  short *neighbors;  
+  short *neighbors;
   float *rates;
   double *energies;
 } cache_entry;
 
-extern cache_entry *lookup_cache (char *x);
-extern int write_cache (cache_entry *x);
+typedef struct {
+  unsigned long size;        /* current number of slots */
+  unsigned long max_size;    /* upper limit for size */
+  unsigned long count;       /* number of stored structures */
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long collisions;  /* probes that hit a slot of another structure */
+  unsigned long evictions;   /* entries replaced because of a full probe window */
+} cache_stats;
+
+/*
+  The cache is keyed on the dot-bracket string but stores it packed
+  with 2 bits per position. All functions are safe to call from
+  concurrently running trajectories.
+*/
+extern void initialize_cache(unsigned long max_size);
+extern int lookup_cache (const char *x, cache_entry *dest);
+extern int write_cache (const char *x, cache_entry *c);
+extern void get_cache_stats(cache_stats *s);
 void kill_cache(void);
 
 #endif
@@ -55,6 +55,8 @@ const char *gengetopt_args_info_full_help[] = {
   "      --rect            compute recurrence time (of a start structure which is\n                          contained in stop structures)  (default=off)",
   "      --grow=FLOAT      grow chain every <float> time units  (default=`0')",
   "      --glen=INT        initial size of growing chain  (default=`15')",
+  "      --cachesize=INT   maximal number of structures in the neighbourhood\n                          cache  (default=`1048576')",
+  "      --jobs=INT        number of trajectories simulated in parallel (0 = one\n                          per CPU core)  (default=`1')",
   "      --phi=DOUBLE      set phi value",
   "      --pbounds=STRING  specify 3 floats for phi_min, phi_inc, phi_max in the\n                          form <d1=d2=d3>",
   "\nOutput:",
@@ -63,6 +65,7 @@ const char *gengetopt_args_info_full_help[] = {
   "  -v, --verbose         more information to stdout  (default=off)",
   "      --lmin            output only local minima to stdout  (default=off)",
   "      --cut=FLOAT       only print structures with E <= MFE + <float> to stdout\n                          (default=`20')",
+  "      --bins=INT        print a histogram of first passage times with <int>\n                          bins  (default=`0')",
   "Input File Format:\n  1st line sequence\n  2nd line start structure (if option --start is used)\n  following lines are stop structures (if option --stop is used)",
     0
 };
@@ -92,18 +95,21 @@ init_help_array(void)
   gengetopt_args_info_help[19] = gengetopt_args_info_full_help[19];
   gengetopt_args_info_help[20] = gengetopt_args_info_full_help[20];
   gengetopt_args_info_help[21] = gengetopt_args_info_full_help[21];
-  gengetopt_args_info_help[22] = gengetopt_args_info_full_help[24];
-  gengetopt_args_info_help[23] = gengetopt_args_info_full_help[25];
+  gengetopt_args_info_help[22] = gengetopt_args_info_full_help[22];
+  gengetopt_args_info_help[23] = gengetopt_args_info_full_help[23];
   gengetopt_args_info_help[24] = gengetopt_args_info_full_help[26];
   gengetopt_args_info_help[25] = gengetopt_args_info_full_help[27];
   gengetopt_args_info_help[26] = gengetopt_args_info_full_help[28];
   gengetopt_args_info_help[27] = gengetopt_args_info_full_help[29];
   gengetopt_args_info_help[28] = gengetopt_args_info_full_help[30];
-  gengetopt_args_info_help[29] = 0; 
+  gengetopt_args_info_help[29] = gengetopt_args_info_full_help[31];
+  gengetopt_args_info_help[30] = gengetopt_args_info_full_help[32];
+  gengetopt_args_info_help[31] = gengetopt_args_info_full_help[33];
+  gengetopt_args_info_help[32] = 0; 
   
 }
 
-const char *gengetopt_args_info_help[30];
+const char *gengetopt_args_info_help[33];
 
 typedef enum {ARG_NO
   , ARG_FLAG
@@ -150,6 +156,8 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->rect_given = 0 ;
   args_info->grow_given = 0 ;
   args_info->glen_given = 0 ;
+  args_info->cachesize_given = 0 ;
+  args_info->jobs_given = 0 ;
   args_info->phi_given = 0 ;
   args_info->pbounds_given = 0 ;
   args_info->log_given = 0 ;
@@ -157,6 +165,7 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->verbose_given = 0 ;
   args_info->lmin_given = 0 ;
   args_info->cut_given = 0 ;
+  args_info->bins_given = 0 ;
 }
 
 static
@@ -187,6 +196,10 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->grow_orig = NULL;
   args_info->glen_arg = 15;
   args_info->glen_orig = NULL;
+  args_info->cachesize_arg = 1048576;
+  args_info->cachesize_orig = NULL;
+  args_info->jobs_arg = 1;
+  args_info->jobs_orig = NULL;
   args_info->phi_orig = NULL;
   args_info->pbounds_arg = NULL;
   args_info->pbounds_orig = NULL;
@@ -197,6 +210,8 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->lmin_flag = 0;
   args_info->cut_arg = 20;
   args_info->cut_orig = NULL;
+  args_info->bins_arg = 0;
+  args_info->bins_orig = NULL;
   
 }
 
@@ -224,13 +239,16 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->rect_help = gengetopt_args_info_full_help[19] ;
   args_info->grow_help = gengetopt_args_info_full_help[20] ;
   args_info->glen_help = gengetopt_args_info_full_help[21] ;
-  args_info->phi_help = gengetopt_args_info_full_help[22] ;
-  args_info->pbounds_help = gengetopt_args_info_full_help[23] ;
-  args_info->log_help = gengetopt_args_info_full_help[25] ;
-  args_info->silent_help = gengetopt_args_info_full_help[26] ;
-  args_info->verbose_help = gengetopt_args_info_full_help[27] ;
-  args_info->lmin_help = gengetopt_args_info_full_help[28] ;
-  args_info->cut_help = gengetopt_args_info_full_help[29] ;
+  args_info->cachesize_help = gengetopt_args_info_full_help[22] ;
+  args_info->jobs_help = gengetopt_args_info_full_help[23] ;
+  args_info->phi_help = gengetopt_args_info_full_help[24] ;
+  args_info->pbounds_help = gengetopt_args_info_full_help[25] ;
+  args_info->log_help = gengetopt_args_info_full_help[27] ;
+  args_info->silent_help = gengetopt_args_info_full_help[28] ;
+  args_info->verbose_help = gengetopt_args_info_full_help[29] ;
+  args_info->lmin_help = gengetopt_args_info_full_help[30] ;
+  args_info->cut_help = gengetopt_args_info_full_help[31] ;
+  args_info->bins_help = gengetopt_args_info_full_help[32] ;
   
 }
 
@@ -339,12 +357,15 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_string_field (&(args_info->num_orig));
   free_string_field (&(args_info->grow_orig));
   free_string_field (&(args_info->glen_orig));
+  free_string_field (&(args_info->cachesize_orig));
+  free_string_field (&(args_info->jobs_orig));
   free_string_field (&(args_info->phi_orig));
   free_string_field (&(args_info->pbounds_arg));
   free_string_field (&(args_info->pbounds_orig));
   free_string_field (&(args_info->log_arg));
   free_string_field (&(args_info->log_orig));
   free_string_field (&(args_info->cut_orig));
+  free_string_field (&(args_info->bins_orig));
   
   
 
@@ -454,6 +475,10 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "grow", args_info->grow_orig, 0);
   if (args_info->glen_given)
     write_into_file(outfile, "glen", args_info->glen_orig, 0);
+  if (args_info->cachesize_given)
+    write_into_file(outfile, "cachesize", args_info->cachesize_orig, 0);
+  if (args_info->jobs_given)
+    write_into_file(outfile, "jobs", args_info->jobs_orig, 0);
   if (args_info->phi_given)
     write_into_file(outfile, "phi", args_info->phi_orig, 0);
   if (args_info->pbounds_given)
@@ -468,6 +493,8 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "lmin", 0, 0 );
   if (args_info->cut_given)
     write_into_file(outfile, "cut", args_info->cut_orig, 0);
+  if (args_info->bins_given)
+    write_into_file(outfile, "bins", args_info->bins_orig, 0);
   
 
   i = EXIT_SUCCESS;
@@ -1363,6 +1390,8 @@ cmdline_parser_internal (
         { "rect",	0, NULL, 0 },
         { "grow",	1, NULL, 0 },
         { "glen",	1, NULL, 0 },
+        { "cachesize",	1, NULL, 0 },
+        { "jobs",	1, NULL, 0 },
         { "phi",	1, NULL, 0 },
         { "pbounds",	1, NULL, 0 },
         { "log",	1, NULL, 0 },
@@ -1370,6 +1399,7 @@ cmdline_parser_internal (
         { "verbose",	0, NULL, 'v' },
         { "lmin",	0, NULL, 0 },
         { "cut",	1, NULL, 0 },
+        { "bins",	1, NULL, 0 },
         { 0,  0, 0, 0 }
       };
 
@@ -1628,6 +1658,34 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* maximal number of structures in the neighbourhood cache.  */
+          else if (strcmp (long_options[option_index].name, "cachesize") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->cachesize_arg), 
+                 &(args_info->cachesize_orig), &(args_info->cachesize_given),
+                &(local_args_info.cachesize_given), optarg, 0, "1048576", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "cachesize", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* number of trajectories simulated in parallel (0 = one per CPU core).  */
+          else if (strcmp (long_options[option_index].name, "jobs") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->jobs_arg), 
+                 &(args_info->jobs_orig), &(args_info->jobs_given),
+                &(local_args_info.jobs_given), optarg, 0, "1", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "jobs", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* set phi value.  */
           else if (strcmp (long_options[option_index].name, "phi") == 0)
@@ -1696,6 +1754,20 @@ cmdline_parser_internal (
                 additional_error))
               goto failure;
           
+          }
+          /* print a histogram of first passage times with <int> bins.  */
+          else if (strcmp (long_options[option_index].name, "bins") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->bins_arg), 
+                 &(args_info->bins_orig), &(args_info->bins_given),
+                &(local_args_info.bins_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "bins", '-',
+                additional_error))
+              goto failure;
+          
           }
           
           break;
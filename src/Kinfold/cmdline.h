@@ -80,6 +80,12 @@ struct gengetopt_args_info
   int glen_arg;	/**< @brief initial size of growing chain (default='15').  */
   char * glen_orig;	/**< @brief initial size of growing chain original value given at command line.  */
   const char *glen_help; /**< @brief initial size of growing chain help description.  */
+  int cachesize_arg;	/**< @brief maximal number of structures in the neighbourhood cache (default='1048576').  */
+  char * cachesize_orig;	/**< @brief maximal number of structures in the neighbourhood cache original value given at command line.  */
+  const char *cachesize_help; /**< @brief maximal number of structures in the neighbourhood cache help description.  */
+  int jobs_arg;	/**< @brief number of trajectories simulated in parallel (0 = one per CPU core) (default='1').  */
+  char * jobs_orig;	/**< @brief number of trajectories simulated in parallel (0 = one per CPU core) original value given at command line.  */
+  const char *jobs_help; /**< @brief number of trajectories simulated in parallel (0 = one per CPU core) help description.  */
   double phi_arg;	/**< @brief set phi value.  */
   char * phi_orig;	/**< @brief set phi value original value given at command line.  */
   const char *phi_help; /**< @brief set phi value help description.  */
@@ -98,6 +104,9 @@ struct gengetopt_args_info
   float cut_arg;	/**< @brief only print structures with E <= MFE + <float> to stdout (default='20').  */
   char * cut_orig;	/**< @brief only print structures with E <= MFE + <float> to stdout original value given at command line.  */
   const char *cut_help; /**< @brief only print structures with E <= MFE + <float> to stdout help description.  */
+  int bins_arg;	/**< @brief print a histogram of first passage times with <int> bins (default='0').  */
+  char * bins_orig;	/**< @brief print a histogram of first passage times with <int> bins original value given at command line.  */
+  const char *bins_help; /**< @brief print a histogram of first passage times with <int> bins help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int full_help_given ;	/**< @brief Whether full-help was given.  */
@@ -118,6 +127,8 @@ struct gengetopt_args_info
   unsigned int rect_given ;	/**< @brief Whether rect was given.  */
   unsigned int grow_given ;	/**< @brief Whether grow was given.  */
   unsigned int glen_given ;	/**< @brief Whether glen was given.  */
+  unsigned int cachesize_given ;	/**< @brief Whether cachesize was given.  */
+  unsigned int jobs_given ;	/**< @brief Whether jobs was given.  */
   unsigned int phi_given ;	/**< @brief Whether phi was given.  */
   unsigned int pbounds_given ;	/**< @brief Whether pbounds was given.  */
   unsigned int log_given ;	/**< @brief Whether log was given.  */
@@ -125,6 +136,7 @@ struct gengetopt_args_info
   unsigned int verbose_given ;	/**< @brief Whether verbose was given.  */
   unsigned int lmin_given ;	/**< @brief Whether lmin was given.  */
   unsigned int cut_given ;	/**< @brief Whether cut was given.  */
+  unsigned int bins_given ;	/**< @brief Whether bins was given.  */
 
 } ;
 
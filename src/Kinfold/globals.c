@@ -379,6 +379,15 @@ static void process_options_gg (int argc, char *argv[]) {
   GSV.cut = args_info.cut_arg;
   GSV.grow = args_info.grow_arg;
   GSV.glen = args_info.glen_arg;
+  GSV.cachesize = args_info.cachesize_arg;
+  if (GSV.cachesize <= 0) {
+    fprintf(stderr,
+	    "Value of cachesize must be > 0\n"
+	    "cachesize: %d\n", GSV.cachesize);
+    exit(EXIT_FAILURE);
+  }
+  GSV.threads = args_info.jobs_arg;
+  GSV.bins = args_info.bins_arg;
   GTV.lmin = args_info.lmin_flag;
   GTV.fpt  = args_info.fpt_flag;
   GTV.rect = args_info.rect_flag;
@@ -563,6 +572,9 @@ static void ini_gvars(void) {
   GSV.phi = 1.0;
   GSV.simTime = 0.0;
   GSV.glen = 15;
+  GSV.cachesize = 1048576;
+  GSV.threads = 1;
+  GSV.bins = 0;
 }
 
 /**/
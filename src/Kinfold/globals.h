@@ -37,6 +37,9 @@ typedef struct _GlobVars {
   float currE;
   double grow;
   int    glen;
+  int    cachesize;
+  int    threads;
+  int    bins;
   double time;
   double phi;
   double simTime;
@@ -84,6 +87,55 @@ typedef struct _GlobToogles {
   int verbose;
 } GlobToggles;
 
+/*
+  state of a single trajectory, one instance per worker thread
+  that is reset at the start of each trajectory
+*/
+typedef struct _TrajVars {
+  int len;             /* current chain length */
+  int steps;
+  int rect;            /* recurrence time toggle */
+  float startE;
+  float currE;
+  char *farbe;         /* sequence (shortened for chain growth) */
+  char *startform;     /* start structure */
+  char *currform;      /* current structure */
+  char *prevform;      /* current structure of previous time step */
+  unsigned short subi[3];  /* seed of this trajectory */
+  unsigned short xsubi[3]; /* state of the random-number-generator */
+
+  /* ringlist-tree (baum.c) */
+  struct _baum *rl;
+  struct _baum *wurzl;
+  short *pairList;
+  short *typeList;
+  short *aliasList;
+  char **ptype;
+
+  /* neighbour list (nachbar.c) */
+  short *neighbor_list;
+  float *bmf;
+  double *energies;
+  int top;
+  int lmin;
+  int is_from_cache;
+  double totalflux;
+  double Zeit;
+  double zeitInc;
+  double _RT;
+  double L, D, sumT, sumK, sumKK, sumD; /* laplace stuff */
+  char *cobuf;         /* output buffer for costring() */
+  int cosize;
+
+  /* outcome of the last trajectory */
+  int found_stop;
+  double fpt;
+
+#if HAVE_LIBRNA_API3
+  vrna_fold_compound_t *vc;
+#endif
+} TrajVars;
+
 void decode_switches(int argc, char *argv[]);
 void clean_up_globals(void);
 void log_prog_params(FILE *FP);
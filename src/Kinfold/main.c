@@ -13,6 +13,8 @@
 #include <assert.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <math.h>
+#include <pthread.h>
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/data_structures.h>
@@ -32,18 +34,30 @@
 
 static char UNUSED rcsid[] ="$Id: main.c,v 1.5 2008/08/28 09:40:55 ivo Exp $";
 extern void  read_parameter_file(const char fname[]);
-extern void get_from_cache(cache_entry *c);
 
 /* PRIVAT FUNCTIONS */
 static void ini_energy_model(void);
 static void read_data(void);
 static void clean_up(void);
+static void ini_traj(TrajVars *T);
+static void free_traj(TrajVars *T);
+static void run_trajectory(TrajVars *T);
+static void *run_worker(void *arg);
+static void seed_trajectory(unsigned short subi[3], int k);
+static void print_fpt_histogram(FILE *out);
+
+/* outcome of all trajectories */
+static double *fpt = NULL;
+static int *fpt_stop = NULL;
+static int next_traj = 0;
+static pthread_mutex_t trajMX = PTHREAD_MUTEX_INITIALIZER;
 
 /**/
 int main(int argc, char *argv[]) {
   int i;
-  char * start, *tmp;
-  
+  char *tmp;
+  TrajVars *T;
+
   /*
     process command-line optiones
   */
@@ -53,6 +67,11 @@ int main(int argc, char *argv[]) {
     initialize energy parameters
   */
   ini_energy_model();
+
+  /*
+    set up neighbourhood cache
+  */
+  initialize_cache(GSV.cachesize);
   
   /*
     read input file
@@ -70,65 +89,247 @@ int main(int argc, char *argv[]) {
   free(tmp);
 #endif
 
+  /*
+    evaluate start and stop structure(s) and log initial conditions
+  */
+  ini_simulation();
+  ini_log();
+
+  fpt      = (double *)calloc(GSV.num, sizeof(double));
+  fpt_stop = (int *)calloc(GSV.num, sizeof(int));
+  assert(fpt != NULL && fpt_stop != NULL);
+
+  if (GSV.threads <= 0) {
+    GSV.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (GSV.threads <= 0) GSV.threads = 1;
+  }
+  if (GSV.threads > GSV.num) GSV.threads = GSV.num;
+
+  T = (TrajVars *)calloc(GSV.threads, sizeof(TrajVars));
+  assert(T != NULL);
+  for (i = 0; i < GSV.threads; i++) ini_traj(T + i);
+
   /*
     perform GSV.num simulations
   */
-    
-  start = strdup(GAV.startform); /* remember startform for next run */
-  int rect; rect = GTV.rect; /* Backup and reset the recurrence time option for every simulation.  */
-  for (i = 0; i < GSV.num; i++) {
-    GTV.rect = rect;
-    /*
-      initialize or reset ringlist to start conditions
-    */
-    ini_or_reset_rl();
-    if (GSV.grow>0) {
-      if (strlen(GAV.farbe)>GSV.glen) {
-        start[GSV.glen] = '\0';
-        GAV.farbe[GSV.glen] = '\0';
-        strcpy(GAV.startform,start);
-        strcpy(GAV.currform,start);
-        GSV.len=GSV.glen;
-#if HAVE_LIBRNA_API3
-        GAV.vc->length = GSV.len;
-#endif
-      }
-      clean_up_rl();
-      ini_or_reset_rl();
+  if (GSV.threads == 1) {
+    /* each trajectory continues the random number stream of its predecessor */
+    memcpy(T->subi, GAV.subi, 3*sizeof(unsigned short));
+    memcpy(T->xsubi, GAV.subi, 3*sizeof(unsigned short));
+    for (i = 0; i < GSV.num; i++) {
+      run_trajectory(T);
+      fpt[i] = T->fpt;
+      fpt_stop[i] = T->found_stop;
     }
-
+  }
+  else {
     /*
-      perform simulation
+      trajectories are not written to stdout in parallel mode,
+      their outcome is summarized by a histogram instead
     */
-    for (GSV.steps = 1;; GSV.steps++) {
-      cache_entry *c;
-
-      /*
-	take neighbourhood of current structure from cache if there
-	else generate it from scratch
-      */
-      if ( (c = lookup_cache(GAV.currform)) ) get_from_cache(c);
-      else move_it();
-	
-      /*
-	select a structure from neighbourhood of current structure
-	and make it to the new current structure.
-	stop simulation if stop condition is met.
-      */
-      if ( sel_nb() > 0 ) break;
-
-      /* if (GSV.grow>0) grow_chain(); */
-    }
+    pthread_t *workers;
+
+    if (!GTV.silent)
+      fprintf(stderr, "WARNING: trajectories are not written to stdout "
+              "with --jobs other than 1, implying --silent\n");
+    GTV.silent = 1;
+    if (GSV.bins <= 0) GSV.bins = 20;
+
+    workers = (pthread_t *)calloc(GSV.threads, sizeof(pthread_t));
+    assert(workers != NULL);
+    for (i = 0; i < GSV.threads; i++)
+      if (pthread_create(workers + i, NULL, run_worker, T + i)) {
+        fprintf(stderr, "main(): failed to start thread %d\n", i);
+        exit(EXIT_FAILURE);
+      }
+    for (i = 0; i < GSV.threads; i++)
+      pthread_join(workers[i], NULL);
+    free(workers);
   }
+
+  if (GSV.bins > 0) print_fpt_histogram(stdout);
   
   /*
     clean up memory
   */
-  free(start);
+  for (i = 0; i < GSV.threads; i++) free_traj(T + i);
+  free(T);
+  free(fpt);
+  free(fpt_stop);
   clean_up();
   return(0);
 }
 
+/* simulate a single trajectory */
+static void run_trajectory(TrajVars *T) {
+
+  T->rect = GTV.rect; /* Backup and reset the recurrence time option for every simulation.  */
+  /*
+    initialize or reset ringlist to start conditions
+  */
+  ini_or_reset_rl(T);
+  if (GSV.grow>0) {
+    if (strlen(T->farbe)>GSV.glen) {
+      strncpy(T->startform, GAV.startform, GSV.glen);
+      T->startform[GSV.glen] = '\0';
+      T->farbe[GSV.glen] = '\0';
+      strcpy(T->currform, T->startform);
+      T->len=GSV.glen;
+#if HAVE_LIBRNA_API3
+      T->vc->length = T->len;
+#endif
+    }
+    clean_up_rl(T);
+    ini_or_reset_rl(T);
+  }
+
+  /*
+    perform simulation
+  */
+  for (T->steps = 1;; T->steps++) {
+    /*
+      take neighbourhood of current structure from cache if there
+      else generate it from scratch
+    */
+    if ( !get_from_cache(T) ) move_it(T);
+
+    /*
+      select a structure from neighbourhood of current structure
+      and make it to the new current structure.
+      stop simulation if stop condition is met.
+    */
+    if ( sel_nb(T) > 0 ) break;
+  }
+}
+
+/* worker thread, takes trajectories from the queue until all are done */
+static void *run_worker(void *arg) {
+  int k;
+  TrajVars *T = (TrajVars *)arg;
+
+  for (;;) {
+    pthread_mutex_lock(&trajMX);
+    k = next_traj++;
+    pthread_mutex_unlock(&trajMX);
+    if (k >= GSV.num) break;
+
+    seed_trajectory(T->subi, k);
+    memcpy(T->xsubi, T->subi, 3*sizeof(unsigned short));
+    run_trajectory(T);
+    fpt[k] = T->fpt;
+    fpt_stop[k] = T->found_stop;
+  }
+
+  return NULL;
+}
+
+/*
+  derive an independent seed for trajectory k from the global seed,
+  such that results do not depend on the scheduling of the threads
+*/
+static void seed_trajectory(unsigned short subi[3], int k) {
+  unsigned long long z;
+
+  z = ((unsigned long long)GAV.subi[0] << 32) |
+      ((unsigned long long)GAV.subi[1] << 16) |
+      (unsigned long long)GAV.subi[2];
+  /* splitmix64 */
+  z += (unsigned long long)(k + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  subi[0] = (unsigned short)(z >> 32);
+  subi[1] = (unsigned short)(z >> 16);
+  subi[2] = (unsigned short)z;
+}
+
+/**/
+static void ini_traj(TrajVars *T) {
+  int n;
+  char *tmp;
+
+  memset(T, 0, sizeof(TrajVars));
+  /* strings must hold the full sequence in case of chain growth */
+  n = strlen(GAV.farbe_full);
+  T->len = GSV.len;
+  T->farbe = (char *)calloc(n+1, sizeof(char));
+  T->startform = (char *)calloc(n+1, sizeof(char));
+  T->currform = (char *)calloc(n+1, sizeof(char));
+  T->prevform = (char *)calloc(n+1, sizeof(char));
+  assert(T->farbe && T->startform && T->currform && T->prevform);
+  strcpy(T->farbe, GAV.farbe);
+  strcpy(T->startform, GAV.startform);
+
+#if HAVE_LIBRNA_API3
+  tmp   = vrna_cut_point_insert(GAV.farbe, cut_point);
+  T->vc = vrna_fold_compound(tmp, &(GAV.md), VRNA_OPTION_DEFAULT);
+  free(tmp);
+#endif
+}
+
+/**/
+static void free_traj(TrajVars *T) {
+  clean_up_rl(T);
+  clean_up_nbList(T);
+  free(T->farbe);
+  free(T->startform);
+  free(T->currform);
+  free(T->prevform);
+#if HAVE_LIBRNA_API3
+  vrna_fold_compound_free(T->vc);
+#endif
+}
+
+/* histogram of first passage times on logarithmic scale */
+static void print_fpt_histogram(FILE *out) {
+  int i, b, n, *count, *per_stop;
+  double tmin, tmax, lmin, width, sum, cum;
+
+  count    = (int *)calloc(GSV.bins, sizeof(int));
+  per_stop = (int *)calloc(GSV.maxS + 1, sizeof(int));
+  assert(count != NULL && per_stop != NULL);
+
+  tmin = tmax = sum = 0.;
+  for (n = i = 0; i < GSV.num; i++) {
+    per_stop[fpt_stop[i]]++;
+    if (!fpt_stop[i]) continue;
+    if ((n == 0) || (fpt[i] < tmin)) tmin = fpt[i];
+    if ((n == 0) || (fpt[i] > tmax)) tmax = fpt[i];
+    sum += fpt[i];
+    n++;
+  }
+
+  fprintf(out, "# first passage times: %d of %d trajectories reached a stop structure\n",
+          n, GSV.num);
+  for (i = 1; i <= GSV.maxS; i++)
+    if (per_stop[i]) fprintf(out, "# X%02d %d\n", i, per_stop[i]);
+  if (per_stop[0]) fprintf(out, "# O   %d\n", per_stop[0]);
+
+  if (n > 0) {
+    fprintf(out, "# mean %.3f\n", sum / n);
+    if (tmin <= 0.) tmin = 1e-6;
+    lmin  = log10(tmin);
+    width = (log10(tmax) - lmin) / GSV.bins;
+    for (i = 0; i < GSV.num; i++) {
+      if (!fpt_stop[i]) continue;
+      b = (width > 0.) ? (int)((log10(fpt[i] > tmin ? fpt[i] : tmin) - lmin) / width) : 0;
+      if (b >= GSV.bins) b = GSV.bins - 1;
+      count[b]++;
+    }
+    fprintf(out, "#%13s %14s %8s %10s\n", "from", "to", "count", "cumulative");
+    for (cum = 0., b = 0; b < GSV.bins; b++) {
+      cum += count[b];
+      fprintf(out, "%14.3f %14.3f %8d %10.4f\n",
+              pow(10., lmin + b * width), pow(10., lmin + (b+1) * width),
+              count[b], cum / GSV.num);
+    }
+  }
+  fflush(out);
+
+  free(count);
+  free(per_stop);
+}
+
 /**/
 static void ini_energy_model(void) {
 
@@ -254,9 +455,16 @@ static void read_data(void) {
 }
 
 /**/
-void clean_up(void) {
+static void clean_up(void) {
+  if (GTV.verbose) {
+    cache_stats cs;
+    get_cache_stats(&cs);
+    fprintf(stderr,
+            "cache: %lu structures in %lu slots, %lu hits, %lu misses, "
+            "%lu collisions, %lu evictions\n",
+            cs.count, cs.size, cs.hits, cs.misses, cs.collisions, cs.evictions);
+  }
   clean_up_globals();
-  clean_up_rl();
-  clean_up_nbList();
+  clean_up_log();
   kill_cache();
 }
@@ -13,6 +13,7 @@
 #include <math.h>
 #include "globals.h"
 #include "assert.h"
+#include <pthread.h>
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/fold_vars.h>
@@ -29,147 +30,133 @@
 
 static char UNUSED rcsid[]="$Id: nachbar.c,v 1.8 2008/06/03 21:55:11 ivo Exp $";
 
-/* arrays */
-static short *neighbor_list=NULL;
-static float *bmf=NULL; /* boltzmann weight of structure */
-static const char *costring(const char *str);
-
-/* globals for laplace stuff */
-static double L = 0.0;
-static double D = 0.0;
-static double sumT = 0.0;
-static double sumK = 0.0;
-static double sumKK = 0.0;
-static double sumD = 0.0;
-static double *energies=NULL; /* energies of neighbors */
-
-/* variables */
-/*  static double highestE = -1000.0; */
-/*  static double OhighestE = -1000.0; */
-/*  static char *highestS, *OhighestS; */
-static int lmin = 1;
-static int top = 0;
-static int is_from_cache = 0;
-/*  static double meanE = 0.0; */
-static double totalflux = 0.0;
-static double Zeit = 0.0;
-static double zeitInc = 0.0;
-static double _RT = 0.6;
+static const char *costring(TrajVars *T, const char *str);
+static FILE *logFP=NULL;
+static pthread_mutex_t logMX = PTHREAD_MUTEX_INITIALIZER;
 
 /* public functiones */
-void ini_nbList(int chords);
-void update_nbList(int i, int j, int iE);
-int sel_nb(void);
-void clean_up_nbList(void);
-extern void update_tree(int i, int j);
+void ini_log(void);
+void ini_nbList(TrajVars *T, int chords);
+void update_nbList(TrajVars *T, int i, int j, int iE);
+int sel_nb(TrajVars *T);
+void clean_up_nbList(TrajVars *T);
+void clean_up_log(void);
 
 /* privat functiones */
-static void reset_nbList(void);
-static void grow_chain(void);
-static FILE *logFP=NULL;
+static void reset_nbList(TrajVars *T);
+static void grow_chain(TrajVars *T);
 
 /**/
-void ini_nbList(int chords) {
+void ini_log(void) {
   char logFN[256];
 
-  _RT = (((temperature + K0) * GASCONST) / 1000.0);
-  if (neighbor_list!=NULL) return;
+  /* open log-file */
+  logFP = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
+  assert(logFP != NULL);
+
+  /* log initial condition */
+  log_prog_params(logFP);
+  log_start_stop(logFP);
+}
+
+/**/
+void ini_nbList(TrajVars *T, int chords) {
+
+  T->_RT = (((temperature + K0) * GASCONST) / 1000.0);
+  if (T->neighbor_list!=NULL) return;
   /*
     list for move coding
     make room for 2*chords neighbors (safe bet)
   */
   if (chords == 0) chords = 1;
-  neighbor_list = (short *)calloc(4*chords, sizeof(short));
-  assert(neighbor_list != NULL);
+  T->neighbor_list = (short *)calloc(4*chords, sizeof(short));
+  assert(T->neighbor_list != NULL);
   /*
     list for Boltzmann-factors
   */
-  bmf = (float *)calloc(2*chords, sizeof(double));
-  assert(bmf != NULL);
+  T->bmf = (float *)calloc(2*chords, sizeof(double));
+  assert(T->bmf != NULL);
 
   /* list of neighbor energies */
-  energies = (double*)calloc(2*chords, sizeof(double));
-  assert(energies != NULL);
-  
-  /* open log-file */
-  logFP = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
-  assert(logFP != NULL);
+  T->energies = (double*)calloc(2*chords, sizeof(double));
+  assert(T->energies != NULL);
 
-  /* log initial condition */
-  log_prog_params(logFP);
-  log_start_stop(logFP);
+  T->lmin = 1;
 }
 
 /**/
-void update_nbList(int i, int j, int iE) {
+void update_nbList(TrajVars *T, int i, int j, int iE) {
   double E, dE, p;
 
   E = (double)iE/100.;
-  neighbor_list[2*top] = (short )i;
-  neighbor_list[2*top+1] = (short )j;
-  
+  T->neighbor_list[2*T->top] = (short )i;
+  T->neighbor_list[2*T->top+1] = (short )j;
+
   /* compute rates and some statistics */
   /*    meanE += E; */
-  dE = E-GSV.currE;
+  dE = E-T->currE;
 
   /* laplace stuff */
-  energies[top] = E;
-  L += GSV.currE-E;
-  D++;
+  T->energies[T->top] = E;
+  T->L += T->currE-E;
+  T->D++;
   /* fprintf(stderr, ">>%g %g<<\n", L, D); */
-  
+
   if( GTV.mc ) {
     /* metropolis rule */
     if (dE < 0) p = 1;
-    else p = exp(-(dE / _RT*GSV.phi));
+    else p = exp(-(dE / T->_RT*GSV.phi));
   }
   else  /* kawasaki rule */
-    p = exp(-0.5 * (dE / _RT*GSV.phi));
+    p = exp(-0.5 * (dE / T->_RT*GSV.phi));
 
-  totalflux += p;
-  bmf[top++] = (float )p;
-  if (dE < 0) lmin = 0;
-  if ((dE == 0) && (lmin==1)) lmin = 2;
+  T->totalflux += p;
+  T->bmf[T->top++] = (float )p;
+  if (dE < 0) T->lmin = 0;
+  if ((dE == 0) && (T->lmin==1)) T->lmin = 2;
 }
 
 /**/
-void get_from_cache(cache_entry *c) {
-  top = c->top;
-  totalflux = c->flux;
-  GSV.currE = c->energy;
-  lmin = c->lmin;
-  memcpy(neighbor_list, c->neighbors, 2*top*sizeof(short));
-  memcpy(bmf, c->rates, top*sizeof(float));
-  memcpy(energies, c->energies, top*sizeof(double));
-  is_from_cache = 1;
+int get_from_cache(TrajVars *T) {
+  cache_entry c;
+
+  c.neighbors = T->neighbor_list;
+  c.rates = T->bmf;
+  c.energies = T->energies;
+  if (!lookup_cache(T->currform, &c)) return 0;
+
+  T->top = c.top;
+  T->totalflux = c.flux;
+  T->currE = c.energy;
+  T->lmin = c.lmin;
+  T->is_from_cache = 1;
+  return 1;
 }
 
 /**/
-void put_in_cache(void) {
+void put_in_cache(TrajVars *T) {
   cache_entry *c;
+  int top = T->top;
 
   if ((c = (cache_entry *) malloc(sizeof(cache_entry)))==NULL) {
     fprintf(stderr, "out of memory\n"); exit(255);
   }
-/*    c->structure = strdup(GAV.currform); */
-  c->structure = (char *) calloc(GSV.len+1, sizeof(char));
-  strcpy(c->structure, GAV.currform);
   c->neighbors = (short *) malloc(top*2*sizeof(short));
-  memcpy(c->neighbors,neighbor_list,top*2*sizeof(short));
+  memcpy(c->neighbors,T->neighbor_list,top*2*sizeof(short));
   c->rates = (float *) malloc(top*sizeof(float));
-  memcpy(c->rates, bmf, top*sizeof(float));
+  memcpy(c->rates, T->bmf, top*sizeof(float));
   c->energies = (double*)malloc(top*sizeof(double));
-  memcpy(c->energies, energies, top*sizeof(double));
+  memcpy(c->energies, T->energies, top*sizeof(double));
   c->top = top;
-  c->lmin = lmin;
-  c->flux = totalflux;
-  c->energy = GSV.currE;
-  write_cache(c);
+  c->lmin = T->lmin;
+  c->flux = T->totalflux;
+  c->energy = T->currE;
+  write_cache(T->currform, c);
 }
 
 /*============*/
 
-int sel_nb(void) {
+int sel_nb(TrajVars *T) {
 
   char trans, **s;
   int next, i;
@@ -178,85 +165,89 @@ int sel_nb(void) {
 
   /* before we select a move, store current conformation in cache */
   /* ... unless it just came from there */
-  if ( !is_from_cache ) put_in_cache();
+  if ( !T->is_from_cache ) put_in_cache(T);
   else
     /* laplace stuff */
-    for (i=0; i<top; i++) {
-      L += (GSV.currE - energies[i]);
-      D++;
+    for (i=0; i<T->top; i++) {
+      T->L += (T->currE - T->energies[i]);
+      T->D++;
     }
-  is_from_cache = 0;
+  T->is_from_cache = 0;
 
   /* draw 2 different a random number */
-  schwelle = urn();
-  while ( zufall==0 ) zufall = urn();
+  schwelle = erand48(T->xsubi);
+  while ( zufall==0 ) zufall = erand48(T->xsubi);
 
   /* advance internal clock */
-  if (totalflux>0)
-    zeitInc = (log(1. / zufall) / totalflux);
+  if (T->totalflux>0)
+    T->zeitInc = (log(1. / zufall) / T->totalflux);
   else {
-    if (GSV.grow>0) zeitInc=GSV.grow;
-    else zeitInc = GSV.time;
+    if (GSV.grow>0) T->zeitInc=GSV.grow;
+    else T->zeitInc = GSV.time;
   }
 
-  Zeit += zeitInc;
+  T->Zeit += T->zeitInc;
 
   /* laplace stuff */
-  sumK  += L*zeitInc;
-  sumKK += L*L*zeitInc;
-  sumD  += D*zeitInc;
-  
-  if (GSV.grow>0 && GSV.len < strlen(GAV.farbe_full)) grow_chain();
+  T->sumK  += T->L*T->zeitInc;
+  T->sumKK += T->L*T->L*T->zeitInc;
+  T->sumD  += T->D*T->zeitInc;
+
+  if (GSV.grow>0 && T->len < strlen(GAV.farbe_full)) grow_chain(T);
 
   /* meanE /= (double)top; */
 
   /* normalize boltzmann weights */
-  schwelle *=totalflux;
+  schwelle *=T->totalflux;
 
   /* and choose a neighbour structure next */
-  for (next = 0; next < top; next++) {
-    pegel += bmf[next];
+  for (next = 0; next < T->top; next++) {
+    pegel += T->bmf[next];
     if (pegel > schwelle) break;
   }
 
   /* in case of rounding errors */
-  if (next==top) next=top-1;
+  if (next==T->top) next=T->top-1;
 
   /*
     process termination contitiones
   */
   /* is current structure identical to a stop structure ?*/
   for (found_stop = 0, s = GAV.stopform; *s; s++) {
-    if (strcmp(*s, GAV.currform) == 0) {
+    if (strcmp(*s, T->currform) == 0) {
       found_stop = (s - GAV.stopform) + 1;
       break;
     }
   }
 
   /* Recurrence time: Ignore when you observe the start structure for the first time. */
-  if ((found_stop > 0) && (GTV.rect == 1) && (strcmp(GAV.startform, GAV.currform) == 0)) {
-    GTV.rect = 0; found_stop = 0;
+  if ((found_stop > 0) && (T->rect == 1) && (strcmp(T->startform, T->currform) == 0)) {
+    T->rect = 0; found_stop = 0;
   }
 
-  if ( ((found_stop > 0) && (GTV.fpt == 1)) || (Zeit > GSV.time) ) {
+  if ( ((found_stop > 0) && (GTV.fpt == 1)) || (T->Zeit > GSV.time) ) {
     /* met condition to stop simulation */
 
     /* laplace stuff */
     double K, KK, N, sigma;
-    K = sumK/Zeit;
-    KK = sumKK/Zeit;
-    N = sumD/Zeit;
+    K = T->sumK/T->Zeit;
+    KK = T->sumKK/T->Zeit;
+    N = T->sumD/T->Zeit;
     /* graph Laplacian is - Laplace-Beltrami operator */
     sigma = -1.0*sqrt((KK-K*K)/N)/(K/N);
-    
+
+    /* remember outcome for summary statistics */
+    T->found_stop = found_stop;
+    T->fpt = T->Zeit;
+
     /* this goes to stdout */
     if ( !GTV.silent ) {
-      printf("%s  %6.2f %10.3f", costring(GAV.currform), GSV.currE, Zeit);
+      printf("%s  %6.2f %10.3f", costring(T, T->currform), T->currE, T->Zeit);
 
       /* laplace stuff*/
-      if (GTV.phi) printf(" %8.3f %8.3f %3g", zeitInc, L, D); 
+      if (GTV.phi) printf(" %8.3f %8.3f %3g", T->zeitInc, T->L, T->D);
 
-      if (GTV.verbose) printf(" %4d _ %d", top, lmin);
+      if (GTV.verbose) printf(" %4d _ %d", T->top, T->lmin);
       if (found_stop) printf(" X%d\n", found_stop);/* found a stop structure */
       else printf(" O\n"); /* time for simulation is exceeded */
 
@@ -267,10 +258,11 @@ int sel_nb(void) {
     }
 
     /* this goes to log */
-    fprintf(logFP, "(%5hu %5hu %5hu)", GAV.subi[0], GAV.subi[1], GAV.subi[2]);
+    pthread_mutex_lock(&logMX);
+    fprintf(logFP, "(%5hu %5hu %5hu)", T->subi[0], T->subi[1], T->subi[2]);
     /* comment log steps of simulation as well !!! %6.2f  round */
     if ( found_stop ) {
-      fprintf(logFP," X%02d %12.3f", found_stop, Zeit);
+      fprintf(logFP," X%02d %12.3f", found_stop, T->Zeit);
 
       /* laplace stuff */
       if (GTV.phi) fprintf(logFP, " %3g %7.5f", GSV.phi, sigma);
@@ -278,60 +270,60 @@ int sel_nb(void) {
       fprintf(logFP,"\n");
     }
     else {
-      fprintf(logFP," O   %12.3f", Zeit);
+      fprintf(logFP," O   %12.3f", T->Zeit);
 
       /* laplace stuff */
-      if (GTV.phi) fprintf(logFP, " %3g %7.5f", GSV.phi, sigma);      
+      if (GTV.phi) fprintf(logFP, " %3g %7.5f", GSV.phi, sigma);
 
-      fprintf(logFP," %d %s\n", lmin, costring(GAV.currform));
+      fprintf(logFP," %d %s\n", T->lmin, costring(T, T->currform));
     }
     fflush(logFP);
+    pthread_mutex_unlock(&logMX);
 
     /* set random number for next round */
-    GAV.subi[0] = xsubi[0];
-    GAV.subi[1] = xsubi[1];
-    GAV.subi[2] = xsubi[2];
-    
-    Zeit = 0.0;
+    T->subi[0] = T->xsubi[0];
+    T->subi[1] = T->xsubi[1];
+    T->subi[2] = T->xsubi[2];
+
+    T->Zeit = 0.0;
 
     /* reset laplace stuff for next trajectory */
-    sumT = 0.0;
-    sumK = 0.0;
-    sumKK = 0.0;
-    sumD = 0.0;
-    L = 0.0;
-    D = 0.0;
-    
+    T->sumT = 0.0;
+    T->sumK = 0.0;
+    T->sumKK = 0.0;
+    T->sumD = 0.0;
+    T->L = 0.0;
+    T->D = 0.0;
+
     /*  highestE = OhighestE = -1000.0; */
-    reset_nbList();
-    costring(NULL);
+    reset_nbList(T);
     return(1);
   }
   else {
     /* continue simulation */
     int flag = 0;
-    if( (!GTV.silent) && (GSV.currE <= GSV.stopE+GSV.cut) ) {
+    if( (!GTV.silent) && (T->currE <= GSV.stopE+GSV.cut) ) {
 
-      if (!GTV.lmin || (lmin==1 && strcmp(GAV.prevform, GAV.currform) != 0)) {
+      if (!GTV.lmin || (T->lmin==1 && strcmp(T->prevform, T->currform) != 0)) {
 	char format[64];
 	flag = 1;
 	sprintf(format, "%%-%ds %%6.2f %%10.3f", strlen(GAV.farbe_full)+1);
-	printf(format, costring(GAV.currform), GSV.currE, Zeit);
+	printf(format, costring(T, T->currform), T->currE, T->Zeit);
       }
 
       /* laplace stuff */
       if (GTV.phi) {
-	printf(" %8.3f %8.3f %3g", zeitInc, L, D);
-	L = D = 0.0; /* reset L and D for next structure */
+	printf(" %8.3f %8.3f %3g", T->zeitInc, T->L, T->D);
+	T->L = T->D = 0.0; /* reset L and D for next structure */
       }
 
       if ( flag && GTV.verbose ) {
 	int ii, jj;
 	if (next<0) trans='g'; /* growth */
 	else {
-	  ii = neighbor_list[2*next];
-	  jj = neighbor_list[2*next+1];
-	  if (abs(ii) < GSV.len) {
+	  ii = T->neighbor_list[2*next];
+	  jj = T->neighbor_list[2*next+1];
+	  if (abs(ii) < T->len) {
 	    if ((ii > 0) && (jj > 0)) trans = 'i';
 	    else if ((ii < 0) && (jj < 0)) trans = 'd';
 	    else if ((ii > 0) && (jj < 0)) trans = 's';
@@ -341,7 +333,7 @@ int sel_nb(void) {
 	    else trans = 'D';
 	  }
 	}
-	printf(" %4d %c %d", top, trans, lmin);
+	printf(" %4d %c %d", T->top, trans, T->lmin);
       }
       if (flag) printf("\n");
     }
@@ -349,112 +341,90 @@ int sel_nb(void) {
 
 
   /* store last lmin seen, so we can avoid printing the same lmin twice */
-  if (lmin==1)
-    strcpy(GAV.prevform, GAV.currform);
-
-#if 0
-  if (lmin==1) {
-    /* went back to previous lmin */
-    if (strcmp(GAV.prevform, GAV.currform) == 0) {
-      if (OhighestE < highestE) {
-	highestE = OhighestE;  /* delete loop */
-	strcpy(highestS, OhighestS);
-      }
-    } else {
-      strcpy(GAV.prevform, GAV.currform);
-      OhighestE = 10000.;
-    }
-  }
+  if (T->lmin==1)
+    strcpy(T->prevform, T->currform);
 
-  if ( strcmp(GAV.currform, GAV.startform)==0 ) {
-    OhighestE = highestE = -1000.;
-    highestS[0] = 0;
-  }
-
-  /* log highes energy */
-  if (GSV.currE > highestE) {
-    OhighestE = highestE;
-    highestE = GSV.currE;
-    strcpy(OhighestS, highestS);
-    strcpy(highestS, GAV.currform);
-  }
-#endif
-
-  if (next>=0) update_tree(neighbor_list[2*next], neighbor_list[2*next+1]);
+  if (next>=0) update_tree(T, T->neighbor_list[2*next], T->neighbor_list[2*next+1]);
   else {
-    clean_up_rl(); ini_or_reset_rl();
+    clean_up_rl(T); ini_or_reset_rl(T);
   }
 
-  reset_nbList();
+  reset_nbList(T);
   return(0);
 }
 
 /*==========================*/
-static void reset_nbList(void) {
+static void reset_nbList(TrajVars *T) {
 
-  top = 0;
-  totalflux = 0.0;
+  T->top = 0;
+  T->totalflux = 0.0;
   /*    meanE = 0.0; */
-  lmin = 1;
+  T->lmin = 1;
 }
 
 /*======================*/
-void clean_up_nbList(void){
+void clean_up_nbList(TrajVars *T){
+
+  free(T->neighbor_list);
+  free(T->bmf);
+  free(T->energies);
+  T->neighbor_list = NULL;
+  T->bmf = NULL;
+  T->energies = NULL;
+  costring(T, NULL);
+}
 
-  free(neighbor_list);
-  free(bmf);
-  free(energies);
+/*======================*/
+void clean_up_log(void){
   fprintf(logFP,"\n");
   fclose(logFP);
 }
 
 /*======================*/
-static void grow_chain(void){
+static void grow_chain(TrajVars *T){
   int newl;
   /* note Zeit=0 corresponds to chain length GSV.glen */
-  if (Zeit<(GSV.len+1-GSV.glen) * GSV.grow) return;
-  newl = GSV.len+1;
-  Zeit = (newl-GSV.glen) * GSV.grow;
-  top=0; /* prevent structure move in sel_nb */
-
-  if (GSV.len<newl) {
-    strncpy(GAV.farbe, GAV.farbe_full, newl);
-    GAV.farbe[newl] = '\0';
-    strcpy(GAV.startform, GAV.currform);
-    strcat(GAV.startform, ".");
-
-    GSV.len = newl;
+  if (T->Zeit<(T->len+1-GSV.glen) * GSV.grow) return;
+  newl = T->len+1;
+  T->Zeit = (newl-GSV.glen) * GSV.grow;
+  T->top=0; /* prevent structure move in sel_nb */
+
+  if (T->len<newl) {
+    strncpy(T->farbe, GAV.farbe_full, newl);
+    T->farbe[newl] = '\0';
+    strcpy(T->startform, T->currform);
+    strcat(T->startform, ".");
+
+    T->len = newl;
 #if HAVE_LIBRNA_API3
-    /* fake actual length of sequence in GAV.vc */
-    GAV.vc->length = newl;
+    /* fake actual length of sequence in T->vc */
+    T->vc->length = newl;
 #endif
   }
 }
 
-static const char *costring(const char *str) {
-  static char* buffer=NULL;
-  static int size=0;
+static const char *costring(TrajVars *T, const char *str) {
   int n;
   if (str==NULL) {
-    if (buffer) {
+    if (T->cobuf) {
       /* make it possible to free buffer */
-      free(buffer);
-      size = 0; buffer = NULL;
+      free(T->cobuf);
+      T->cosize = 0; T->cobuf = NULL;
     }
     return NULL;
   }
   n=strlen(str);
-  if (n>=size) {
-    size = n+2;
-    buffer = realloc(buffer, size);
+  if (n>=T->cosize) {
+    T->cosize = n+2;
+    T->cobuf = realloc(T->cobuf, T->cosize);
   }
   if ((cut_point>0)&&(cut_point<=n)) {
-    strncpy(buffer, str, cut_point-1);
-    buffer[cut_point-1] = '&';
-    strncpy(buffer+cut_point, str+cut_point-1, n-cut_point+1);
-    buffer[n+1] = '\0';
+    strncpy(T->cobuf, str, cut_point-1);
+    T->cobuf[cut_point-1] = '&';
+    strncpy(T->cobuf+cut_point, str+cut_point-1, n-cut_point+1);
+    T->cobuf[n+1] = '\0';
   } else {
-    strncpy(buffer, str, n+1);
+    strncpy(T->cobuf, str, n+1);
   }
-  return buffer;
+  return T->cobuf;
 }
@@ -9,13 +9,16 @@
 #ifndef NACHBAR_H
 #define NACHBAR_H
 
+#include "globals.h"
+
 /* used in baum.c */
-extern void ini_nbList(int chords);
-extern void update_nbList(int i,int j, int iE);
+extern void ini_nbList(TrajVars *T, int chords);
+extern void update_nbList(TrajVars *T, int i,int j, int iE);
 
 /* used in main.c */
-extern int sel_nb(void);
-extern void clean_up_nbList(void);
-
-extern void grow_chain(void);
+extern void ini_log(void);
+extern int get_from_cache(TrajVars *T);
+extern int sel_nb(TrajVars *T);
+extern void clean_up_nbList(TrajVars *T);
+extern void clean_up_log(void);
 #endif
@@ -0,0 +1,128 @@
+/*
+  c  Christoph Flamm and Ivo L Hofacker
+  {xtof,ivo}@tbi.univie.ac.at
+  Kinfold: $Name:  $
+
+  checks of the structure cache: hits, misses, replacing an entry,
+  growing the table and the upper limit of its size
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "cache_util.h"
+
+#define N_STRUCTURES  40000
+#define LEN           32
+
+static int failed = 0;
+
+#define CHECK(cond, msg) \
+  do { if (!(cond)) { fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, msg); failed++; } } while (0)
+
+/* a distinct structure for every i, the cache does not need it to be balanced */
+static void make_structure(unsigned long i, char *x) {
+  int k;
+
+  for (k = 0; k < LEN; k++, i /= 3)
+    x[k] = ".()"[i % 3];
+  x[LEN] = '\0';
+}
+
+static cache_entry *make_entry(int top, double energy) {
+  int k;
+  cache_entry *c;
+
+  c = (cache_entry *)malloc(sizeof(cache_entry));
+  c->top       = top;
+  c->lmin      = (top == 0);
+  c->flux      = 0.5 * top;
+  c->energy    = energy;
+  c->neighbors = (short *)malloc(2 * (top + 1) * sizeof(short));
+  c->rates     = (float *)malloc((top + 1) * sizeof(float));
+  c->energies  = (double *)malloc((top + 1) * sizeof(double));
+  for (k = 0; k < top; k++) {
+    c->neighbors[2 * k]     = k + 1;
+    c->neighbors[2 * k + 1] = k + 5;
+    c->rates[k]             = 0.25 * k;
+    c->energies[k]          = energy + k;
+  }
+  return c;
+}
+
+int main(void) {
+  unsigned long i, found;
+  short neighbors[2 * 8];
+  float rates[8];
+  double energies[8];
+  char x[LEN + 1];
+  cache_entry dest;
+  cache_stats st;
+
+  dest.neighbors = neighbors;
+  dest.rates     = rates;
+  dest.energies  = energies;
+
+  /* the table starts small and may grow up to 2^17 slots */
+  initialize_cache(100000);
+  get_cache_stats(&st);
+  CHECK(st.size == 65536, "initial size");
+  CHECK(st.max_size == 131072, "maximal size is rounded up to a power of 2");
+
+  /* miss, then hit after writing */
+  CHECK(lookup_cache("((....))", &dest) == 0, "lookup in empty cache");
+  CHECK(write_cache("((....))", make_entry(3, -1.5)) == 0, "first write");
+  CHECK(lookup_cache("((....))", &dest) == 1, "lookup after write");
+  CHECK(dest.top == 3 && dest.energy == -1.5 && dest.flux == 1.5, "entry fields");
+  CHECK(dest.neighbors[4] == 3 && dest.neighbors[5] == 7, "neighbors");
+  CHECK(dest.rates[2] == 0.5f && dest.energies[2] == 0.5, "rates and energies");
+  CHECK(lookup_cache("((...)).", &dest) == 0, "structure of other length");
+  CHECK(lookup_cache("(.....)", &dest) == 0, "structure not written");
+
+  /* writing the same structure again replaces its entry */
+  CHECK(write_cache("((....))", make_entry(1, -2.5)) == 1, "second write");
+  CHECK(lookup_cache("((....))", &dest) == 1 && dest.top == 1 && dest.energy == -2.5,
+        "replaced entry");
+
+  get_cache_stats(&st);
+  CHECK(st.hits == 2 && st.misses == 3, "hit and miss counters");
+  CHECK(st.count == 1, "one structure stored");
+
+  /* pass the load factor of 1/2 to make the table grow */
+  for (i = 0; i < N_STRUCTURES; i++) {
+    make_structure(i, x);
+    write_cache(x, make_entry(i % 8, (double)i));
+  }
+
+  get_cache_stats(&st);
+  CHECK(st.size == 131072, "table has grown");
+  CHECK(st.count + st.evictions == N_STRUCTURES + 1, "all structures stored");
+
+  /* everything written before and after the growth step is still there */
+  for (found = 0, i = 0; i < N_STRUCTURES; i++) {
+    make_structure(i, x);
+    if (lookup_cache(x, &dest)) {
+      CHECK(dest.top == (int)(i % 8) && dest.energy == (double)i, "entry after growth");
+      found++;
+    }
+  }
+  CHECK(found + st.evictions >= N_STRUCTURES, "lookups after growth");
+  CHECK(lookup_cache("((....))", &dest) == 1 || st.evictions > 0, "first entry after growth");
+
+  kill_cache();
+
+  /* huge limits are capped instead of doubling past the range of unsigned long */
+  initialize_cache(ULONG_MAX);
+  get_cache_stats(&st);
+  CHECK(st.max_size == 1073741824UL, "maximal size is capped");
+  CHECK(st.size == 65536, "capped cache starts small");
+  kill_cache();
+
+  if (failed)
+    fprintf(stderr, "%d checks failed\n", failed);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* End of file */
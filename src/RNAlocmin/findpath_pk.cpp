@@ -15,6 +15,7 @@
 
 extern "C" {
   #include "pair_mat.h"
+  #include "ViennaRNA/datastructures/hash_tables.h"
 }
 
 using namespace std;
@@ -199,8 +200,9 @@ public:
   short *s1;
   int verbose_lvl;
 
-  // hash for already seen structures -> best Saddle energy
-  map<short *, int, compare_struct> structs_visited;
+  // hash for already seen structures -> best Saddle energy (at the index of the structure)
+  vrna_ht_pt_t structs_visited;
+  vector<int> visited_en;
 
   // current state of computation
   priority_queue<intermediate_pk> pqueue;
@@ -213,6 +215,7 @@ public:
   {
     this->seq = seq;
     maxkeep = 10;
+    structs_visited = NULL;
 
     make_pair_matrix();
     s0 = encode_sequence(seq, 0);
@@ -288,24 +291,20 @@ bool Findpath::Insert(intermediate_pk &prev, set<move_fp>::iterator it, int verb
   //if (verbose_lvl > 1) fprintf(stderr, "TIN: %s %6.2f %6.2f %d ", pt_to_str_pk(next.structure).c_str(), next.Sen/100.0, next.energy/100.0, next.dist);
 
   // check if we have encoutered it:
-  map<short*, int, compare_struct>::iterator sit;
+  long sit = vrna_ht_pt_insert(structs_visited, structure);
 
-  /*for (sit=structs_visited.begin(); sit!=structs_visited.end(); sit++) {
-    fprintf(stderr, "---: %s %7.2f\n", pt_to_str_pk(sit->first).c_str(), sit->second/100.0);
-  }*/
-
-  if ((sit = structs_visited.find(structure))!=structs_visited.end()) {
+  if (sit < (long)visited_en.size()) {
     // better:
     // update
-    if (sit->second > prev.energy + energy_chng) {
-      sit->second = prev.energy + energy_chng;
+    if (visited_en[sit] > prev.energy + energy_chng) {
+      visited_en[sit] = prev.energy + energy_chng;
       inserted = true;
     }
     // worse or the same:
     // do nothing.
   } else {
     inserted = true;
-    structs_visited[allocopy(structure)] = prev.energy + energy_chng;
+    visited_en.push_back(prev.energy + energy_chng);
   }
 
     // insert it
@@ -350,7 +349,9 @@ int Findpath::ComputeSaddle(short *str1, short *str2)
 
   intermediate_pk inter_tmp(str1, energy_of_struct_pk(seq, str1, s0, s1, verbose_lvl), moves);
   pqueue.push(inter_tmp);
-  structs_visited[allocopy(inter_tmp.structure)] = inter_tmp.energy;
+  structs_visited = vrna_ht_pt_init(str1[0], VRNA_HT_PT_PK);
+  vrna_ht_pt_insert(structs_visited, inter_tmp.structure);
+  visited_en.push_back(inter_tmp.energy);
 
   // for each distance do
   for (int i=0; i<dist; i++) {
@@ -377,7 +378,7 @@ int Findpath::ComputeSaddle(short *str1, short *str2)
       else break;
 
       // if we are going to proceed the structure with lower energy than optimal:
-      int stored_en = structs_visited[inter.structure];
+      int stored_en = visited_en[vrna_ht_pt_get(structs_visited, inter.structure)];
       if (stored_en != inter.energy) {
         free(inter.structure);
         continue;
@@ -437,9 +438,9 @@ int Findpath::ComputeSaddle(short *str1, short *str2)
     pqueue.pop();
   }
 
-  for (auto it=structs_visited.begin(); it!=structs_visited.end(); it++) {
-    free(it->first);
-  }
+  vrna_ht_pt_free(structs_visited);
+  structs_visited = NULL;
+  visited_en.clear();
 
   return result.Sen;
 }
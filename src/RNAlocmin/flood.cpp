@@ -14,7 +14,7 @@ extern "C" {
 
 using namespace std;
 
-// global priority queue for stuff in flooding (does not hold memory - memory is in hash)
+// global priority queue for stuff in flooding (holds memory - hash stores only packed structures)
 priority_queue<struct_en*, vector<struct_en*>, comps_entries_rev> neighs;
 priority_queue<Structure*, vector<Structure*>, comps_entries_rev> neighs2;
 int energy_lvl;
@@ -24,11 +24,7 @@ int min_lvl;
 bool minh_total;
 bool found_exit;
 // hash for the flooding
-unordered_set<struct_en*, hash_fncts, hash_eq> hash_flood (HASHSIZE);
-unordered_set<struct_en*, hash_fncts, hash_eq>::iterator it_hash;
-
-unordered_set<Structure*, hash_fncts, hash_eq> hash_flood2 (HASHSIZE);
-unordered_set<Structure*, hash_fncts, hash_eq>::iterator it_hash2;
+vrna_ht_pt_t hash_flood = NULL;
 
 
 void copy_se(struct_en *dest, const struct_en *src) {
@@ -47,8 +43,7 @@ struct_en *allocopy_se(const struct_en *src) {
 int flood_func(struct_en *input, struct_en *output)
 {
   // have we seen him?
-  it_hash = hash_flood.find(input);
-  if (it_hash != hash_flood.end()) {
+  if (vrna_ht_pt_get(hash_flood, input->structure) >= 0) {
     // nothing to do with already processed structure
     if (debugg) fprintf(stderr,     "   already seen: %s %.2f\n", pt_to_str(input->structure).c_str(), input->energy/100.0);
     return 0;
@@ -71,7 +66,7 @@ int flood_func(struct_en *input, struct_en *output)
           he_tmp->structure = allocopy(input->structure);
           he_tmp->energy = input->energy;
           neighs.push(he_tmp);
-          hash_flood.insert(he_tmp);
+          vrna_ht_pt_insert(hash_flood, he_tmp->structure);
           return 0;
         }
       }
@@ -92,7 +87,7 @@ int flood_func(struct_en *input, struct_en *output)
         he_tmp->structure = allocopy(input->structure);
         he_tmp->energy = input->energy;
         neighs.push(he_tmp);
-        hash_flood.insert(he_tmp);
+        vrna_ht_pt_insert(hash_flood, he_tmp->structure);
         return 0;
       }
     }
@@ -103,8 +98,7 @@ int flood_func(struct_en *input, struct_en *output)
 int flood_func2(Structure *input, Structure *output)
 {
   // have we seen him?
-  it_hash2 = hash_flood2.find(input);
-  if (it_hash2 != hash_flood2.end()) {
+  if (vrna_ht_pt_get(hash_flood, input->str) >= 0) {
     // nothing to do with already processed structure
     if (debugg) fprintf(stderr,     "   already seen: %s %.2f\n", pt_to_str(input->str).c_str(), input->energy/100.0);
     return 0;
@@ -126,7 +120,7 @@ int flood_func2(Structure *input, Structure *output)
           // just add it to the queue... and to hash
           Structure *str_tmp = new Structure(*input);
           neighs2.push(str_tmp);
-          hash_flood2.insert(str_tmp);
+          vrna_ht_pt_insert(hash_flood, str_tmp->str);
           return 0;
         }
       }
@@ -146,7 +140,7 @@ int flood_func2(Structure *input, Structure *output)
         // just add it to the queue... and to hash
         Structure *str_tmp = new Structure(*input);
         neighs2.push(str_tmp);
-        hash_flood2.insert(str_tmp);
+        vrna_ht_pt_insert(hash_flood, str_tmp->str);
         return 0;
       }
     }
@@ -182,18 +176,18 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
     }
 
     // init hash
-    free_hash(hash_flood2);
+    hash_flood = vrna_ht_pt_init(he.structure[0], VRNA_HT_PT_PK);
     found_exit = false;
 
-    // add the first structure to hash, get its adress and add it to priority queue
+    // add the first structure to hash and to priority queue
     {
       Structure *he_tmp = new Structure(he.structure, he.energy);
       neighs2.push(he_tmp);
-      hash_flood2.insert(he_tmp);
+      vrna_ht_pt_insert(hash_flood, he_tmp->str);
     }
 
     // FLOOOD!
-    while ((int)hash_flood2.size() < Opt.floodMax) {
+    while ((int)vrna_ht_pt_num(hash_flood) < Opt.floodMax) {
       // should not be empty (only when maxh specified)
       if (neighs2.empty()) break;
 
@@ -214,9 +208,11 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
         res = (struct_en*)malloc(sizeof(struct_en));
         res->structure = allocopy(he_top->str);
         res->energy = he_top->energy;
+        delete he_top;
         break;
       }
 
+      delete he_top;
       count++;
     }
 
@@ -228,11 +224,13 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
     // destroy queue
     while (!neighs2.empty()) {
       //fprintf(stderr, "-neighs size: %d\n", (int)neighs.size());
+      delete neighs2.top();
       neighs2.pop();
     }
 
     // destroy hash
-    free_hash(hash_flood2);
+    vrna_ht_pt_free(hash_flood);
+    hash_flood = NULL;
   } else {  /// ######## NOT PKNOTS!!!
     // init priority queue
     while (!neighs.empty()) {
@@ -241,19 +239,19 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
     }
 
     // init hash
-    free_hash(hash_flood);
+    hash_flood = vrna_ht_pt_init(he.structure[0], 0);
     found_exit = false;
 
 
-    // add the first structure to hash, get its adress and add it to priority queue
+    // add the first structure to hash and to priority queue
     {
       struct_en *he_tmp = allocopy_se(&he);
       neighs.push(he_tmp);
-      hash_flood.insert(he_tmp);
+      vrna_ht_pt_insert(hash_flood, he_tmp->structure);
     }
 
     // FLOOOD!
-    while ((int)hash_flood.size() < Opt.floodMax) {
+    while ((int)vrna_ht_pt_num(hash_flood) < Opt.floodMax) {
       // should not be empty (only when maxh specified)
       if (neighs.empty()) break;
 
@@ -272,9 +270,13 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
       // did we find exit from basin?
       if (found_exit) {
         res = allocopy_se(he_top);
+        free(he_top->structure);
+        free(he_top);
         break;
       }
 
+      free(he_top->structure);
+      free(he_top);
       count++;
     }
 
@@ -286,11 +288,14 @@ struct_en* flood(const struct_en &he, SeqInfo &sqi, int &saddle_en, int maxh, bo
     // destroy queue
     while (!neighs.empty()) {
       //fprintf(stderr, "-neighs size: %d\n", (int)neighs.size());
+      free(neighs.top()->structure);
+      free(neighs.top());
       neighs.pop();
     }
 
     // destroy hash
-    free_hash(hash_flood);
+    vrna_ht_pt_free(hash_flood);
+    hash_flood = NULL;
   }  /// #### END OF PKNOTS BRANCH
 
   // restore deg options
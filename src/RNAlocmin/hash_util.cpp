@@ -50,16 +50,16 @@ bool compf_entries_rev (const struct_en *lhs, const struct_en *rhs) {
   return compf_short_rev(lhs->structure, rhs->structure);
 }
 
-void print_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs)
+void print_stats(gw_structs &structs)
 {
   double mean = 0.0;
   int count = 0;
   double entropy = 0.0;
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    count += it->second.count;
-    mean += (it->first.energy)*(it->second.count);
-    entropy += it->second.count*log(it->second.count);
+  vector<gw_struct>::iterator it;
+  for (it=structs.lms.begin(); it!=structs.lms.end(); it++) {
+    count += it->count;
+    mean += (it->energy)*(it->count);
+    entropy += it->count*log(it->count);
   }
 
   mean /= (double)count*100.0;
@@ -68,49 +68,25 @@ void print_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &struc
   fprintf(stderr, "Mean  : %.3f (Entrpy: %.3f)\n", mean, entropy);
 }
 
-void add_stats(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output)
+void add_stats(gw_structs &structs, map<struct_en, int, comps_entries> &output)
 {
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
+  vector<gw_struct>::iterator it;
+  for (it=structs.lms.begin(); it!=structs.lms.end(); it++) {
     // add stats:
-    //fprintf(stderr, "struct: %s %6.2f %d\n", pt_to_str(it->second.he.structure).c_str(), it->second.he.energy/100.0, it->second.count);
+    //fprintf(stderr, "struct: %s %6.2f %d\n", pt_to_str(it->he.structure).c_str(), it->he.energy/100.0, it->count);
 
-    if (output.count(it->second.he) == 0) {
+    if (output.count(it->he) == 0) {
       fprintf(stderr, "ERROR: output does not contain structure it should!!!\n");
       //if (!Opt.pknots) exit(EXIT_FAILURE);
     }
-    output[it->second.he] += it->second.count-1;
+    output[it->he] += it->count-1;
   }
 }
 
 // free hash
-void free_hash(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs)
+void free_hash(gw_structs &structs)
 {
-  unordered_map<struct_en, gw_struct, hash_fncts>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    free(it->first.structure);
-  }
-  structs.clear();
-}
-
-// free hash
-void free_hash(unordered_set<struct_en*, hash_fncts, hash_eq> &structs)
-{
-  unordered_set<struct_en*, hash_fncts, hash_eq>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    free((*it)->structure);
-    free(*it);
-  }
-  structs.clear();
-}
-
-// free hash
-void free_hash(unordered_set<Structure*, hash_fncts, hash_eq> &structs)
-{
-  unordered_set<Structure*, hash_fncts, hash_eq>::iterator it;
-  for (it=structs.begin(); it!=structs.end(); it++) {
-    //free((*it)->str);
-    delete *it;
-  }
-  structs.clear();
+  vrna_ht_pt_free(structs.set);
+  structs.set = NULL;
+  structs.lms.clear();
 }
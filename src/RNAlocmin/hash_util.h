@@ -4,10 +4,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
+#include <vector>
 
 extern "C" {
   #include "utils.h"
   #include "move_set_inside.h"
+  #include "ViennaRNA/datastructures/hash_tables.h"
 }
 
 #include "pknots.h"
@@ -15,10 +17,22 @@ extern "C" {
 // help struct for hash
 struct gw_struct {
   int count;
+  int energy;   // energy of the structure itself
   struct_en he; // does not contain memory
   gw_struct(){
     he.structure = NULL;
     count = 0;
+    energy = 0;
+  }
+};
+
+// structures to minima map, structures are stored packed in the set,
+// their local minima in a vector at the index of the structure
+struct gw_structs {
+  vrna_ht_pt_t set;
+  std::vector<gw_struct> lms;
+  gw_structs(int length, bool pknots) {
+    set = vrna_ht_pt_init(length, pknots ? VRNA_HT_PT_PK : 0);
   }
 };
 
@@ -296,16 +310,13 @@ struct comps_entries_rev {
 };
 
 // print stats about hash
-void print_stats(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs);
+void print_stats(gw_structs &structs);
 // add stats from hash to output map
-void add_stats(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, std::map<struct_en, int, comps_entries> &output);
+void add_stats(gw_structs &structs, std::map<struct_en, int, comps_entries> &output);
 
 
 // free hash
-void free_hash(std::unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs);
-//void free_hash(unordered_map<Structure, gw_struct, hash_fncts, hash_eq> &structs);
-void free_hash(std::unordered_set<struct_en*, hash_fncts, hash_eq> &structs);
-void free_hash(std::unordered_set<Structure*, hash_fncts, hash_eq> &structs);
+void free_hash(gw_structs &structs);
 
 // entry handling
 struct_en *copy_entry(const struct_en *he);
@@ -104,7 +104,7 @@ struct barr_info { // info taken from barriers
 
 // functions that are down in file ;-)
 char *read_seq(char *seq_arg, char **name_out);
-int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output);
+int move(gw_structs &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output);
 char *read_previous(char *previous, map<struct_en, int, comps_entries> &output);
 char *read_barr(char *previous, map<struct_en, barr_info, comps_entries> &output);
 
@@ -211,7 +211,7 @@ int main(int argc, char **argv)
     if (args_info.just_output_flag) printf("%s\n", seq);
 
     // hash
-    unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> structs (HASHSIZE); // structures to minima map
+    gw_structs structs (seq_len, Opt.pknots); // structures to minima map
     while ((!args_info.find_num_given || count != args_info.find_num_arg) && !args_info.just_read_flag) {
       int res = move(structs, output, output_shallow, sqi, args_info.just_output_flag);
 
@@ -320,11 +320,13 @@ int main(int argc, char **argv)
     if (allegiance) {
       for (int i=0; i<(int)structures.size(); i++) {
         fprintf(alleg, "%6d %s %6.2f %6d\n", i+1, pt_to_str_pk(structures[i].structure).c_str(), structures[i].energy/100.0, LM_to_LMnum[str_to_LM[structures[i]]]);
-        //free(structures[i].structure);
       }
-      structures.clear();
       LM_to_LMnum.clear();
       str_to_LM.clear();
+      for (int i=0; i<(int)structures.size(); i++) {
+        free(structures[i].structure);
+      }
+      structures.clear();
     }
 
     // erase possible NULL elements...
@@ -834,7 +836,7 @@ char *read_seq(char *seq_arg, char **name_out)
 }
 
 
-int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output)
+int move(gw_structs &structs, map<struct_en, int, comps_entries> &output, set<struct_en, comps_entries> &output_shallow, SeqInfo &sqi, bool pure_output)
 {
   // read a line
   char *line = my_getline(stdin);
@@ -932,11 +934,11 @@ int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<
   }
 
   // check if it was before
-  unordered_map<struct_en, gw_struct, hash_fncts, hash_eq>::iterator it_s = structs.find(str);
+  long idx = vrna_ht_pt_get(structs.set, str.structure);
 
   // if it was - release memory + get another
-  if (it_s != structs.end()) {
-    it_s->second.count++;
+  if (idx >= 0) {
+    structs.lms[idx].count++;
     free(str.structure);
     return 0;
   } else {
@@ -955,7 +957,8 @@ int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<
     //is it canonical (noLP)
     if (Opt.noLP && find_lone_pair(str.structure)!=-1) {
       if (Opt.verbose_lvl>0) fprintf(stderr, "WARNING: structure \"%s\" has lone pairs, skipping...\n", pt_to_str_pk(str.structure).c_str());
-      free(str.structure);
+      // memory is in structures
+      if (!allegiance) free(str.structure);
       return -2;
     }
 
@@ -971,13 +974,18 @@ int move(unordered_map<struct_en, gw_struct, hash_fncts, hash_eq> &structs, map<
     // only some types of PK allowed!!!
     if (Opt.pknots && str.energy == INT_MAX) {
       free(str.structure);
-      free(old.structure);
+      if (!allegiance) free(old.structure);
       return 0;
     }
 
-    // insert into hash (memory is here only on left side)
-    gw_struct &lm = structs[old];
+    // insert into hash (only a packed copy is stored)
+    idx = vrna_ht_pt_insert(structs.set, old.structure);
+    if (idx == (long)structs.lms.size()) structs.lms.push_back(gw_struct());
+    gw_struct &lm = structs.lms[idx];
     lm.count = 1;
+    lm.energy = old.energy;
+    // memory is in structures
+    if (!allegiance) free(old.structure);
     /*
     int i;
     while ((i = (Opt.rand? move_rand(str) : move_set(str)))!=0) {
@@ -34,6 +34,31 @@ void degeneracy_handling(int degeneracy)
 #################################
 */
 
+/*
+  cache of energy changes of moves. The energy change of a move only
+  depends on the loops it touches, so cached values stay valid as long
+  as none of these loops was modified in the meantime. Loops are named
+  by the 5' position of their closing pair (0 = exterior loop).
+*/
+typedef struct _dG_entry {
+  int           move[4];  /* bp_left, bp_right, bp_left2, bp_right2 */
+  int           energy;
+  unsigned int  stamp;    /* step the energy was computed in, 0 = empty slot */
+} dG_entry;
+
+typedef struct _dG_cache {
+  short         *pt;        /* structure the loop indices refer to */
+  int           *loop;      /* loop every position belongs to */
+  int           *loop_tmp;
+  int           *stack;
+  unsigned int  *modified;  /* step a loop was modified last */
+  unsigned int  step;
+
+  dG_entry      *table;     /* open addressing, linear probing */
+  unsigned int  size;
+  unsigned int  count;
+} dG_cache;
+
 /* internal struct with moves, sequence, degeneracy and options*/
 typedef struct _Encoded {
   /* sequence*/
@@ -71,6 +96,8 @@ typedef struct _Encoded {
   /* function for flooding */
   int (*funct) (struct_en*, struct_en*);
 
+  /* energy changes of moves (NULL = evaluate every move from scratch) */
+  dG_cache *dG;
 
 } Encoded;
 
@@ -96,6 +123,11 @@ PRIVATE int     shifts(Encoded *Enc, struct_en *str, struct_en *minim);
 PRIVATE int     move_set(Encoded *Enc, struct_en *str);
 PRIVATE void    construct_moves(Encoded *Enc, short *structure);
 PRIVATE int     move_rset(Encoded *Enc, struct_en *str);
+PRIVATE dG_cache *ini_dG_cache(short *pt);
+PRIVATE void    free_dG_cache(dG_cache *c);
+PRIVATE void    loop_index(const short *pt, int *loop, int *stack);
+PRIVATE void    sync_dG_cache(dG_cache *c, const short *pt);
+PRIVATE int     move_dG(Encoded *Enc, short *pt);
 
 
 /*
@@ -198,16 +230,160 @@ do_move(short *pt, int bp_left, int bp_right){
   }
 }
 
+PRIVATE dG_cache *
+ini_dG_cache(short *pt){
+
+  int n = pt[0];
+  dG_cache *c = (dG_cache*) space(sizeof(dG_cache));
+
+  c->pt = allocopy(pt);
+  c->loop = (int*) space(sizeof(int)*(n+2));
+  c->loop_tmp = (int*) space(sizeof(int)*(n+2));
+  c->stack = (int*) space(sizeof(int)*(n+2));
+  c->modified = (unsigned int*) space(sizeof(unsigned int)*(n+2));
+  c->step = 1;
+  loop_index(pt, c->loop, c->stack);
+
+  c->size = 1024;
+  c->count = 0;
+  c->table = (dG_entry*) space(sizeof(dG_entry)*c->size);
+
+  return c;
+}
+
+PRIVATE void
+free_dG_cache(dG_cache *c){
+
+  if (c) {
+    free(c->pt);
+    free(c->loop);
+    free(c->loop_tmp);
+    free(c->stack);
+    free(c->modified);
+    free(c->table);
+    free(c);
+  }
+}
+
+/* loop[i] = 5' position of the pair closing the loop that contains i */
+PRIVATE void
+loop_index(const short *pt, int *loop, int *stack){
+
+  int i, top = 0;
+
+  stack[0] = 0;
+  for (i=1; i<=pt[0]; i++) {
+    if (pt[i]!=0 && pt[i]<i) top--;  /* ')' */
+    loop[i] = stack[top];
+    if (pt[i]>i) stack[++top] = i;   /* '(' */
+  }
+}
+
+/* mark all loops that differ between the cached and the current structure */
+PRIVATE void
+sync_dG_cache(dG_cache *c, const short *pt){
+
+  int i, *tmp;
+
+  c->step++;
+  loop_index(pt, c->loop_tmp, c->stack);
+  for (i=1; i<=pt[0]; i++) {
+    if (pt[i]==c->pt[i] && c->loop_tmp[i]==c->loop[i]) continue;
+    c->modified[c->loop[i]] = c->step;
+    c->modified[c->loop_tmp[i]] = c->step;
+    if (c->pt[i]) c->modified[(i<c->pt[i])?i:c->pt[i]] = c->step;
+    if (pt[i]) c->modified[(i<pt[i])?i:pt[i]] = c->step;
+  }
+  tmp = c->loop;
+  c->loop = c->loop_tmp;
+  c->loop_tmp = tmp;
+  memcpy(c->pt, pt, sizeof(short)*(pt[0]+1));
+}
+
+PRIVATE inline unsigned int
+dG_hash(const int move[4]){
+
+  unsigned int h = 2166136261U;
+  int i;
+  for (i=0; i<4; i++) {
+    h ^= (unsigned int)move[i];
+    h *= 16777619U;
+  }
+  return h ^ (h >> 15);
+}
+
+PRIVATE dG_entry *
+dG_slot(dG_cache *c, const int move[4]){
+
+  unsigned int p = dG_hash(move) & (c->size-1);
+  while (c->table[p].stamp && memcmp(c->table[p].move, move, 4*sizeof(int)) != 0)
+    p = (p+1) & (c->size-1);
+  return c->table + p;
+}
+
+/* energy change of the current move(s) in Enc applied to pt */
+PRIVATE int
+move_dG(Encoded *Enc, short *pt){
+
+  int en, i, move[4];
+  dG_cache *c = Enc->dG;
+  dG_entry *e = NULL;
+
+  if (c) {
+    move[0] = Enc->bp_left;
+    move[1] = Enc->bp_right;
+    move[2] = Enc->bp_left2;
+    move[3] = Enc->bp_right2;
+    e = dG_slot(c, move);
+
+    /* deletions depend on the loop closed by the pair as well */
+    i = (Enc->bp_left>0) ? Enc->bp_left : -Enc->bp_left;
+    if (e->stamp &&
+        e->stamp >= c->modified[c->loop[i]] &&
+        (Enc->bp_left>0 || e->stamp >= c->modified[i]) &&
+        (Enc->bp_left2>=0 || e->stamp >= c->modified[-Enc->bp_left2]))
+      return e->energy;
+  }
+
+  en = energy_of_move_pt(pt, Enc->s0, Enc->s1, Enc->bp_left, Enc->bp_right);
+  if (Enc->bp_left2 != 0) {
+    do_move(pt, Enc->bp_left, Enc->bp_right);
+    en += energy_of_move_pt(pt, Enc->s0, Enc->s1, Enc->bp_left2, Enc->bp_right2);
+    do_move(pt, -Enc->bp_left, -Enc->bp_right);
+  }
+
+  if (c) {
+    if (!e->stamp) {
+      c->count++;
+      memcpy(e->move, move, 4*sizeof(int));
+    }
+    e->energy = en;
+    e->stamp = c->step;
+
+    /* keep the load factor below 1/2 */
+    if (2*c->count > c->size) {
+      unsigned int k, old_size = c->size;
+      dG_entry *old = c->table;
+      c->size *= 2;
+      c->table = (dG_entry*) space(sizeof(dG_entry)*c->size);
+      for (k=0; k<old_size; k++)
+        if (old[k].stamp) *dG_slot(c, old[k].move) = old[k];
+      free(old);
+    }
+  }
+
+  return en;
+}
+
 /* done with all structures along the way to deepest*/
 PRIVATE int
 update_deepest(Encoded *Enc, struct_en *str, struct_en *min){
 
   /* apply move + get its energy*/
   int tmp_en;
-  tmp_en = str->energy + energy_of_move_pt(str->structure, Enc->s0, Enc->s1, Enc->bp_left, Enc->bp_right);
+  tmp_en = str->energy + move_dG(Enc, str->structure);
   do_move(str->structure, Enc->bp_left, Enc->bp_right);
   if (Enc->bp_left2 != 0) {
-    tmp_en += energy_of_move_pt(str->structure, Enc->s0, Enc->s1, Enc->bp_left2, Enc->bp_right2);
     do_move(str->structure, Enc->bp_left2, Enc->bp_right2);
   }
   int last_en = str->energy;
@@ -554,6 +730,7 @@ move_set(Encoded *Enc, struct_en *str){
   min.structure = allocopy(str->structure);
   min.energy = str->energy;
   Enc->current_en = str->energy;
+  if (Enc->dG) sync_dG_cache(Enc->dG, str->structure);
 
   if (Enc->verbose_lvl>0) { fprintf(stderr, "  start of MS:\n  "); print_str(stderr, str->structure); fprintf(stderr, " %d\n\n", str->energy); }
 
@@ -663,6 +840,7 @@ move_rset(Encoded *Enc, struct_en *str){
   min.structure = allocopy(str->structure);
   min.energy = str->energy;
   Enc->current_en = str->energy;
+  if (Enc->dG) sync_dG_cache(Enc->dG, str->structure);
 
   if (Enc->verbose_lvl>0) { fprintf(stderr, "  start of MR:\n  "); print_str(stderr, str->structure); fprintf(stderr, " %d\n\n", str->energy); }
 
@@ -798,6 +976,7 @@ move_gradient(char *string,
 
   /* function */
   enc.funct=NULL;
+  enc.dG=NULL;
 
   int i;
   for (i=0; i<MAX_DEGEN; i++) enc.processed[i]=enc.unprocessed[i]=NULL;
@@ -806,10 +985,12 @@ move_gradient(char *string,
   str.structure = allocopy(ptable);
   str.energy = energy_of_structure_pt(enc.seq, str.structure, enc.s0, enc.s1, 0);
 
+  enc.dG = ini_dG_cache(str.structure);
   while (move_set(&enc, &str)!=0) {
     free_degen(&enc);
   }
   free_degen(&enc);
+  free_dG_cache(enc.dG);
 
   copy_arr(ptable, str.structure);
   free(str.structure);
@@ -852,6 +1033,7 @@ move_first( char *string,
 
   /* function */
   enc.funct=NULL;
+  enc.dG=NULL;
 
   int i;
   for (i=0; i<MAX_DEGEN; i++) enc.processed[i]=enc.unprocessed[i]=NULL;
@@ -860,10 +1042,12 @@ move_first( char *string,
   str.structure = allocopy(ptable);
   str.energy = energy_of_structure_pt(enc.seq, str.structure, enc.s0, enc.s1, 0);
 
+  enc.dG = ini_dG_cache(str.structure);
   while (move_set(&enc, &str)!=0) {
     free_degen(&enc);
   }
   free_degen(&enc);
+  free_dG_cache(enc.dG);
 
   copy_arr(ptable, str.structure);
   free(str.structure);
@@ -906,6 +1090,7 @@ move_adaptive(char *string,
 
   /* function */
   enc.funct=NULL;
+  enc.dG=NULL;
 
   /* allocate memory for moves */
   enc.moves_from = (int*) space(ptable[0]*ptable[0]*sizeof(int));
@@ -918,10 +1103,12 @@ move_adaptive(char *string,
   str.structure = allocopy(ptable);
   str.energy = energy_of_structure_pt(enc.seq, str.structure, enc.s0, enc.s1, 0);
 
+  enc.dG = ini_dG_cache(str.structure);
   while (move_rset(&enc, &str)!=0) {
     free_degen(&enc);
   }
   free_degen(&enc);
+  free_dG_cache(enc.dG);
 
   copy_arr(ptable, str.structure);
   free(str.structure);
@@ -990,6 +1177,7 @@ browse_neighs_pt( char *string,
 
   /* function */
   enc.funct=funct;
+  enc.dG=NULL;
 
   int i;
   for (i=0; i<MAX_DEGEN; i++) enc.processed[i]=enc.unprocessed[i]=NULL;
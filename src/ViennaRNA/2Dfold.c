@@ -163,6 +163,39 @@ prepareArray2(unsigned long ***array,
               int           *max_l);
 
 
+INLINE PRIVATE void
+prepareBandedBoundaries(int max_k_pre,
+                        int max_l_pre,
+                        int bpdist,
+                        int maxD1,
+                        int maxD2,
+                        int *min_k,
+                        int *max_k,
+                        int **min_l,
+                        int **max_l);
+
+
+INLINE PRIVATE void
+prepareArrayBlock(int ***array,
+                  int min_k,
+                  int max_k,
+                  int *min_l,
+                  int *max_l);
+
+
+PRIVATE void
+moveArrayToPool(vrna_mx_pool_t  *pool,
+                int             ***array,
+                int             *k_min,
+                int             *k_max,
+                int             **l_min,
+                int             **l_max,
+                int             k_min_post,
+                int             k_max_post,
+                int             *l_min_post,
+                int             *l_max_post);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -450,7 +483,7 @@ mfe_linear(vrna_fold_compound_t *vc)
     /* i,j in [1..length] */
 #ifdef _OPENMP
 #pragma \
-    omp parallel for private(additional_en, j, energy, temp2, i, ij, dia,dib,dja,djb,cnt1,cnt2,cnt3,cnt4, d1, d2)
+    omp parallel for private(additional_en, j, energy, temp2, i, ij, dia,dib,dja,djb,cnt1,cnt2,cnt3,cnt4, d1, d2) schedule(dynamic)
 #endif
     for (j = d; j <= seq_length; j++) {
       unsigned int  p, q, pq, u, maxp, dij;
@@ -479,23 +512,22 @@ mfe_linear(vrna_fold_compound_t *vc)
         d1  = base_d1 + referenceBPs1[ij];
         d2  = base_d2 + referenceBPs2[ij];
 
-        int min_k, max_k, min_l, max_l;
+        int max_k, max_l;
         int real_min_k, real_max_k, *min_l_real, *max_l_real;
 
-        min_l = min_k = 0;
         max_k = mm1[ij] + referenceBPs1[ij];
         max_l = mm2[ij] + referenceBPs2[ij];
 
-        prepareBoundaries(min_k,
-                          max_k,
-                          min_l,
-                          max_l,
-                          bpdist[ij],
-                          &matrices->k_min_C[ij],
-                          &matrices->k_max_C[ij],
-                          &matrices->l_min_C[ij],
-                          &matrices->l_max_C[ij]
-                          );
+        prepareBandedBoundaries(max_k,
+                                max_l,
+                                bpdist[ij],
+                                maxD1,
+                                maxD2,
+                                &matrices->k_min_C[ij],
+                                &matrices->k_max_C[ij],
+                                &matrices->l_min_C[ij],
+                                &matrices->l_max_C[ij]
+                                );
 
         preparePosteriorBoundaries(matrices->k_max_C[ij] - matrices->k_min_C[ij] + 1,
                                    matrices->k_min_C[ij],
@@ -505,12 +537,12 @@ mfe_linear(vrna_fold_compound_t *vc)
                                    &max_l_real
                                    );
 
-        prepareArray(&matrices->E_C[ij],
-                     matrices->k_min_C[ij],
-                     matrices->k_max_C[ij],
-                     matrices->l_min_C[ij],
-                     matrices->l_max_C[ij]
-                     );
+        prepareArrayBlock(&matrices->E_C[ij],
+                          matrices->k_min_C[ij],
+                          matrices->k_max_C[ij],
+                          matrices->l_min_C[ij],
+                          matrices->l_max_C[ij]
+                          );
 
 #ifdef COUNT_STATES
         prepareArray2(&matrices->N_C[ij],
@@ -746,17 +778,18 @@ mfe_linear(vrna_fold_compound_t *vc)
           }
         }
 
-        /* resize and move memory portions of energy matrix E_C */
-        adjustArrayBoundaries(&matrices->E_C[ij],
-                              &matrices->k_min_C[ij],
-                              &matrices->k_max_C[ij],
-                              &matrices->l_min_C[ij],
-                              &matrices->l_max_C[ij],
-                              real_min_k,
-                              real_max_k,
-                              min_l_real,
-                              max_l_real
-                              );
+        /* move actually used portion of energy matrix E_C into the memory pool */
+        moveArrayToPool(matrices->pool,
+                        &matrices->E_C[ij],
+                        &matrices->k_min_C[ij],
+                        &matrices->k_max_C[ij],
+                        &matrices->l_min_C[ij],
+                        &matrices->l_max_C[ij],
+                        real_min_k,
+                        real_max_k,
+                        min_l_real,
+                        max_l_real
+                        );
 #ifdef COUNT_STATES
         /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
 #endif
@@ -782,35 +815,34 @@ mfe_linear(vrna_fold_compound_t *vc)
       else
         temp2 = E_MLstem(type, -1, -1, P);
 
-      int min_k_guess, max_k_guess, min_l_guess, max_l_guess;
+      int max_k_guess, max_l_guess;
       int min_k_real_m, max_k_real_m, *min_l_real_m, *max_l_real_m;
       int min_k_real_m1, max_k_real_m1, *min_l_real_m1, *max_l_real_m1;
 
-      min_k_guess = min_l_guess = 0;
       max_k_guess = mm1[ij] + referenceBPs1[ij];
       max_l_guess = mm2[ij] + referenceBPs2[ij];
 
-      prepareBoundaries(min_k_guess,
-                        max_k_guess,
-                        min_l_guess,
-                        max_l_guess,
-                        bpdist[ij],
-                        &matrices->k_min_M[ij],
-                        &matrices->k_max_M[ij],
-                        &matrices->l_min_M[ij],
-                        &matrices->l_max_M[ij]
-                        );
+      prepareBandedBoundaries(max_k_guess,
+                              max_l_guess,
+                              bpdist[ij],
+                              maxD1,
+                              maxD2,
+                              &matrices->k_min_M[ij],
+                              &matrices->k_max_M[ij],
+                              &matrices->l_min_M[ij],
+                              &matrices->l_max_M[ij]
+                              );
 
-      prepareBoundaries(min_k_guess,
-                        max_k_guess,
-                        min_l_guess,
-                        max_l_guess,
-                        bpdist[ij],
-                        &matrices->k_min_M1[ij],
-                        &matrices->k_max_M1[ij],
-                        &matrices->l_min_M1[ij],
-                        &matrices->l_max_M1[ij]
-                        );
+      prepareBandedBoundaries(max_k_guess,
+                              max_l_guess,
+                              bpdist[ij],
+                              maxD1,
+                              maxD2,
+                              &matrices->k_min_M1[ij],
+                              &matrices->k_max_M1[ij],
+                              &matrices->l_min_M1[ij],
+                              &matrices->l_max_M1[ij]
+                              );
 
       preparePosteriorBoundaries(matrices->k_max_M[ij] - matrices->k_min_M[ij] + 1,
                                  matrices->k_min_M[ij],
@@ -827,19 +859,19 @@ mfe_linear(vrna_fold_compound_t *vc)
                                  &max_l_real_m1
                                  );
 
-      prepareArray(&matrices->E_M[ij],
-                   matrices->k_min_M[ij],
-                   matrices->k_max_M[ij],
-                   matrices->l_min_M[ij],
-                   matrices->l_max_M[ij]
-                   );
+      prepareArrayBlock(&matrices->E_M[ij],
+                        matrices->k_min_M[ij],
+                        matrices->k_max_M[ij],
+                        matrices->l_min_M[ij],
+                        matrices->l_max_M[ij]
+                        );
 
-      prepareArray(&matrices->E_M1[ij],
-                   matrices->k_min_M1[ij],
-                   matrices->k_max_M1[ij],
-                   matrices->l_min_M1[ij],
-                   matrices->l_max_M1[ij]
-                   );
+      prepareArrayBlock(&matrices->E_M1[ij],
+                        matrices->k_min_M1[ij],
+                        matrices->k_max_M1[ij],
+                        matrices->l_min_M1[ij],
+                        matrices->l_max_M1[ij]
+                        );
 #ifdef COUNT_STATES
       prepareArray2(&matrices->N_M[ij],
                     matrices->k_min_M[ij],
@@ -1137,27 +1169,29 @@ mfe_linear(vrna_fold_compound_t *vc)
 
       /* thats all folks for the multiloop decomposition... */
 
-      adjustArrayBoundaries(&matrices->E_M[ij],
-                            &matrices->k_min_M[ij],
-                            &matrices->k_max_M[ij],
-                            &matrices->l_min_M[ij],
-                            &matrices->l_max_M[ij],
-                            min_k_real_m,
-                            max_k_real_m,
-                            min_l_real_m,
-                            max_l_real_m
-                            );
+      moveArrayToPool(matrices->pool,
+                      &matrices->E_M[ij],
+                      &matrices->k_min_M[ij],
+                      &matrices->k_max_M[ij],
+                      &matrices->l_min_M[ij],
+                      &matrices->l_max_M[ij],
+                      min_k_real_m,
+                      max_k_real_m,
+                      min_l_real_m,
+                      max_l_real_m
+                      );
 
-      adjustArrayBoundaries(&matrices->E_M1[ij],
-                            &matrices->k_min_M1[ij],
-                            &matrices->k_max_M1[ij],
-                            &matrices->l_min_M1[ij],
-                            &matrices->l_max_M1[ij],
-                            min_k_real_m1,
-                            max_k_real_m1,
-                            min_l_real_m1,
-                            max_l_real_m1
-                            );
+      moveArrayToPool(matrices->pool,
+                      &matrices->E_M1[ij],
+                      &matrices->k_min_M1[ij],
+                      &matrices->k_max_M1[ij],
+                      &matrices->l_min_M1[ij],
+                      &matrices->l_max_M1[ij],
+                      min_k_real_m1,
+                      max_k_real_m1,
+                      min_l_real_m1,
+                      max_l_real_m1
+                      );
 
 #ifdef COUNT_STATES
       /* actually we should adjust the array boundaries here but we might never use the count states option more than once so what....*/
@@ -4180,6 +4214,156 @@ prepareArray2(unsigned long ***array,
 }
 
 
+/*
+ * Boundaries for the per-cell arrays of E_C, E_M, and E_M1. Any structure on
+ * [i,j] with distances (k,l) to both references satisfies k + l >= bpdist and
+ * |k - l| <= bpdist (triangle inequality), while entries beyond maxD1/maxD2 go
+ * to the *_rem arrays. Thus, the band below covers all entries we ever write.
+ */
+INLINE PRIVATE void
+prepareBandedBoundaries(int max_k_pre,
+                        int max_l_pre,
+                        int bpdist,
+                        int maxD1,
+                        int maxD2,
+                        int *min_k,
+                        int *max_k,
+                        int **min_l,
+                        int **max_l)
+{
+  int cnt, mem;
+
+  *min_k  = MAX2(0, bpdist - maxD2);
+  *max_k  = MIN2(max_k_pre, MIN2(maxD1, bpdist + maxD2));
+
+  /* keep a single (empty) row if nothing fits into the band */
+  if (*max_k < *min_k)
+    *max_k = *min_k;
+
+  mem     = *max_k - *min_k + 1;
+  *min_l  = (int *)vrna_alloc(sizeof(int) * mem);
+  *max_l  = (int *)vrna_alloc(sizeof(int) * mem);
+
+  *min_l  -= *min_k;
+  *max_l  -= *min_k;
+
+  for (cnt = *min_k; cnt <= *max_k; cnt++) {
+    (*min_l)[cnt] = (cnt < bpdist) ? bpdist - cnt : cnt - bpdist;
+    (*max_l)[cnt] = MIN2(MIN2(max_l_pre, maxD2), cnt + bpdist);
+  }
+}
+
+
+/*
+ * Scratch array with the same layout as prepareArray() but all rows in a
+ * single memory block. Rows with min_l > max_l are empty.
+ */
+INLINE PRIVATE void
+prepareArrayBlock(int ***array,
+                  int min_k,
+                  int max_k,
+                  int *min_l,
+                  int *max_l)
+{
+  char  *block;
+  int   i, mem, *data;
+
+  mem = 0;
+  for (i = min_k; i <= max_k; i++)
+    if (max_l[i] >= min_l[i])
+      mem += (max_l[i] - min_l[i]) / 2 + 1;
+
+  block = (char *)vrna_alloc(sizeof(int *) * (max_k - min_k + 1) + sizeof(int) * MAX2(mem, 1));
+  data  = (int *)(block + sizeof(int *) * (max_k - min_k + 1));
+
+  for (i = 0; i < mem; i++)
+    data[i] = INF;
+
+  *array  = (int **)block;
+  *array  -= min_k;
+
+  for (i = min_k; i <= max_k; i++) {
+    (*array)[i] = data - min_l[i] / 2;
+    if (max_l[i] >= min_l[i])
+      data += (max_l[i] - min_l[i]) / 2 + 1;
+  }
+}
+
+
+/*
+ * Counterpart of adjustArrayBoundaries() for scratch arrays obtained from
+ * prepareArrayBlock(). Copies the actually used entries into a single block
+ * of the memory pool and releases the scratch memory.
+ */
+PRIVATE void
+moveArrayToPool(vrna_mx_pool_t  *pool,
+                int             ***array,
+                int             *k_min,
+                int             *k_max,
+                int             **l_min,
+                int             **l_max,
+                int             k_min_post,
+                int             k_max_post,
+                int             *l_min_post,
+                int             *l_max_post)
+{
+  char  *block;
+  int   cnt1, k_span, mem, **rows, *data, *l_min_pool, *l_max_pool;
+
+  rows        = NULL;
+  l_min_pool  = NULL;
+  l_max_pool  = NULL;
+
+  if (k_min_post < INF) {
+    k_span  = k_max_post - k_min_post + 1;
+    mem     = 0;
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++)
+      if (l_min_post[cnt1] < INF)
+        mem += (l_max_post[cnt1] - l_min_post[cnt1]) / 2 + 1;
+
+    /* row pointers first, followed by the data and the l boundaries */
+    block = (char *)vrna_mx_pool_alloc(pool,
+                                       sizeof(int *) * k_span +
+                                       sizeof(int) * (mem + 2 * k_span));
+    rows        = (int **)block;
+    data        = (int *)(block + sizeof(int *) * k_span);
+    l_min_pool  = data + mem;
+    l_max_pool  = l_min_pool + k_span;
+
+    rows        -= k_min_post;
+    l_min_pool  -= k_min_post;
+    l_max_pool  -= k_min_post;
+
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
+      l_min_pool[cnt1]  = l_min_post[cnt1];
+      l_max_pool[cnt1]  = l_max_post[cnt1];
+
+      if (l_min_post[cnt1] < INF) {
+        mem = (l_max_post[cnt1] - l_min_post[cnt1]) / 2 + 1;
+        memcpy(data, (*array)[cnt1] + l_min_post[cnt1] / 2, sizeof(int) * mem);
+        rows[cnt1]  = data - l_min_post[cnt1] / 2;
+        data        += mem;
+      } else {
+        rows[cnt1] = NULL;
+      }
+    }
+  }
+
+  /* release scratch array and boundaries */
+  free(*array + *k_min);
+  free(*l_min + *k_min);
+  free(*l_max + *k_min);
+  free(l_min_post + *k_min);
+  free(l_max_post + *k_min);
+
+  *array  = rows;
+  *l_min  = l_min_pool;
+  *l_max  = l_max_pool;
+  *k_min  = k_min_post;
+  *k_max  = k_max_post;
+}
+
+
 /*
  #################################
  # OLD API support               #
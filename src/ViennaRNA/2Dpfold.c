@@ -163,6 +163,39 @@ prepareArray(FLT_OR_DBL ***array,
              int        *max_l);
 
 
+INLINE PRIVATE void
+prepareBandedBoundaries(int max_k_pre,
+                        int max_l_pre,
+                        int bpdist,
+                        int maxD1,
+                        int maxD2,
+                        int *min_k,
+                        int *max_k,
+                        int **min_l,
+                        int **max_l);
+
+
+INLINE PRIVATE void
+prepareArrayBlock(FLT_OR_DBL  ***array,
+                  int         min_k,
+                  int         max_k,
+                  int         *min_l,
+                  int         *max_l);
+
+
+PRIVATE void
+moveArrayToPool(vrna_mx_pool_t  *pool,
+                FLT_OR_DBL      ***array,
+                int             *k_min,
+                int             *k_max,
+                int             **l_min,
+                int             **l_max,
+                int             k_min_post,
+                int             k_max_post,
+                int             *l_min_post,
+                int             *l_max_post);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -429,15 +462,19 @@ pf2D_linear(vrna_fold_compound_t *vc)
 
   for (j = 1; j <= seq_length; j++)
     for (i = (j > turn ? (j - turn) : 1); i <= j; i++) {
+      char *block = (char *)vrna_mx_pool_alloc(matrices->pool,
+                                               sizeof(FLT_OR_DBL *) +
+                                               sizeof(FLT_OR_DBL) +
+                                               sizeof(int) * 2);
       ij                        = my_iindx[i] - j;
       matrices->k_min_Q[ij]     = 0;
       matrices->k_max_Q[ij]     = 0;
-      matrices->l_min_Q[ij]     = (int *)vrna_alloc(sizeof(int));
-      matrices->l_max_Q[ij]     = (int *)vrna_alloc(sizeof(int));
+      matrices->Q[ij]           = (FLT_OR_DBL **)block;
+      matrices->Q[ij][0]        = (FLT_OR_DBL *)(block + sizeof(FLT_OR_DBL *));
+      matrices->l_min_Q[ij]     = (int *)(matrices->Q[ij][0] + 1);
+      matrices->l_max_Q[ij]     = matrices->l_min_Q[ij] + 1;
       matrices->l_min_Q[ij][0]  = 0;
       matrices->l_max_Q[ij][0]  = 0;
-      matrices->Q[ij]           = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *));
-      matrices->Q[ij][0]        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL));
       matrices->Q[ij][0][0]     = 1.0 * scale[j - i + 1];
     }
 
@@ -445,7 +482,7 @@ pf2D_linear(vrna_fold_compound_t *vc)
   for (d = turn + 2; d <= seq_length; d++) {
     /* i,j in [1..seq_length] */
 #ifdef _OPENMP
-#pragma omp parallel for private(i, j, ij, cnt1, cnt2, cnt3, cnt4)
+#pragma omp parallel for private(i, j, ij, cnt1, cnt2, cnt3, cnt4) schedule(dynamic)
 #endif
     for (j = d; j <= seq_length; j++) {
       unsigned int  k, l, kl, u, ii, dij;
@@ -463,26 +500,25 @@ pf2D_linear(vrna_fold_compound_t *vc)
       if (type) {
         /* we have a pair */
 
-        int k_min_Q_B, k_max_Q_B, l_min_Q_B, l_max_Q_B;
+        int k_max_Q_B, l_max_Q_B;
         int k_min_post_b, k_max_post_b, *l_min_post_b, *l_max_post_b;
         int update_b = 0;
 
         if (!matrices->Q_B[ij]) {
           update_b  = 1;
-          k_min_Q_B = l_min_Q_B = 0;
           k_max_Q_B = mm1[ij] + referenceBPs1[ij];
           l_max_Q_B = mm2[ij] + referenceBPs2[ij];
 
-          prepareBoundaries(k_min_Q_B,
-                            k_max_Q_B,
-                            l_min_Q_B,
-                            l_max_Q_B,
-                            bpdist[ij],
-                            &matrices->k_min_Q_B[ij],
-                            &matrices->k_max_Q_B[ij],
-                            &matrices->l_min_Q_B[ij],
-                            &matrices->l_max_Q_B[ij]
-                            );
+          prepareBandedBoundaries(k_max_Q_B,
+                                  l_max_Q_B,
+                                  bpdist[ij],
+                                  maxD1,
+                                  maxD2,
+                                  &matrices->k_min_Q_B[ij],
+                                  &matrices->k_max_Q_B[ij],
+                                  &matrices->l_min_Q_B[ij],
+                                  &matrices->l_max_Q_B[ij]
+                                  );
           preparePosteriorBoundaries(matrices->k_max_Q_B[ij] - matrices->k_min_Q_B[ij] + 1,
                                      matrices->k_min_Q_B[ij],
                                      &k_min_post_b,
@@ -491,12 +527,12 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                      &l_max_post_b
                                      );
 
-          prepareArray(&matrices->Q_B[ij],
-                       matrices->k_min_Q_B[ij],
-                       matrices->k_max_Q_B[ij],
-                       matrices->l_min_Q_B[ij],
-                       matrices->l_max_Q_B[ij]
-                       );
+          prepareArrayBlock(&matrices->Q_B[ij],
+                            matrices->k_min_Q_B[ij],
+                            matrices->k_max_Q_B[ij],
+                            matrices->l_min_Q_B[ij],
+                            matrices->l_max_Q_B[ij]
+                            );
         }
 
         /* hairpin ----------------------------------------------*/
@@ -692,44 +728,44 @@ pf2D_linear(vrna_fold_compound_t *vc)
         }
 
         if (update_b) {
-          adjustArrayBoundaries(&matrices->Q_B[ij],
-                                &matrices->k_min_Q_B[ij],
-                                &matrices->k_max_Q_B[ij],
-                                &matrices->l_min_Q_B[ij],
-                                &matrices->l_max_Q_B[ij],
-                                k_min_post_b,
-                                k_max_post_b,
-                                l_min_post_b,
-                                l_max_post_b
-                                );
+          moveArrayToPool(matrices->pool,
+                          &matrices->Q_B[ij],
+                          &matrices->k_min_Q_B[ij],
+                          &matrices->k_max_Q_B[ij],
+                          &matrices->l_min_Q_B[ij],
+                          &matrices->l_max_Q_B[ij],
+                          k_min_post_b,
+                          k_max_post_b,
+                          l_min_post_b,
+                          l_max_post_b
+                          );
         }
       } /* end >> if (pair) << */
 
       /* free ends ? -----------------------------------------*/
 
-      int k_min_Q_M, k_max_Q_M, l_min_Q_M, l_max_Q_M;
+      int k_max_Q_M, l_max_Q_M;
       int k_min_post_m, k_max_post_m, *l_min_post_m, *l_max_post_m;
       int update_m = 0;
-      int k_min_Q_M1, k_max_Q_M1, l_min_Q_M1, l_max_Q_M1;
+      int k_max_Q_M1, l_max_Q_M1;
       int k_min_post_m1, k_max_post_m1, *l_min_post_m1, *l_max_post_m1;
       int update_m1 = 0;
 
       if (!matrices->Q_M[ij]) {
         update_m  = 1;
-        k_min_Q_M = l_min_Q_M = 0;
         k_max_Q_M = mm1[ij] + referenceBPs1[ij];
         l_max_Q_M = mm2[ij] + referenceBPs2[ij];
 
-        prepareBoundaries(k_min_Q_M,
-                          k_max_Q_M,
-                          l_min_Q_M,
-                          l_max_Q_M,
-                          bpdist[ij],
-                          &matrices->k_min_Q_M[ij],
-                          &matrices->k_max_Q_M[ij],
-                          &matrices->l_min_Q_M[ij],
-                          &matrices->l_max_Q_M[ij]
-                          );
+        prepareBandedBoundaries(k_max_Q_M,
+                                l_max_Q_M,
+                                bpdist[ij],
+                                maxD1,
+                                maxD2,
+                                &matrices->k_min_Q_M[ij],
+                                &matrices->k_max_Q_M[ij],
+                                &matrices->l_min_Q_M[ij],
+                                &matrices->l_max_Q_M[ij]
+                                );
         preparePosteriorBoundaries(matrices->k_max_Q_M[ij] - matrices->k_min_Q_M[ij] + 1,
                                    matrices->k_min_Q_M[ij],
                                    &k_min_post_m,
@@ -738,30 +774,29 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                    &l_max_post_m
                                    );
 
-        prepareArray(&matrices->Q_M[ij],
-                     matrices->k_min_Q_M[ij],
-                     matrices->k_max_Q_M[ij],
-                     matrices->l_min_Q_M[ij],
-                     matrices->l_max_Q_M[ij]
-                     );
+        prepareArrayBlock(&matrices->Q_M[ij],
+                          matrices->k_min_Q_M[ij],
+                          matrices->k_max_Q_M[ij],
+                          matrices->l_min_Q_M[ij],
+                          matrices->l_max_Q_M[ij]
+                          );
       }
 
       if (!matrices->Q_M1[jindx[j] + i]) {
         update_m1   = 1;
-        k_min_Q_M1  = l_min_Q_M1 = 0;
         k_max_Q_M1  = mm1[ij] + referenceBPs1[ij];
         l_max_Q_M1  = mm2[ij] + referenceBPs2[ij];
 
-        prepareBoundaries(k_min_Q_M1,
-                          k_max_Q_M1,
-                          l_min_Q_M1,
-                          l_max_Q_M1,
-                          bpdist[ij],
-                          &matrices->k_min_Q_M1[jindx[j] + i],
-                          &matrices->k_max_Q_M1[jindx[j] + i],
-                          &matrices->l_min_Q_M1[jindx[j] + i],
-                          &matrices->l_max_Q_M1[jindx[j] + i]
-                          );
+        prepareBandedBoundaries(k_max_Q_M1,
+                                l_max_Q_M1,
+                                bpdist[ij],
+                                maxD1,
+                                maxD2,
+                                &matrices->k_min_Q_M1[jindx[j] + i],
+                                &matrices->k_max_Q_M1[jindx[j] + i],
+                                &matrices->l_min_Q_M1[jindx[j] + i],
+                                &matrices->l_max_Q_M1[jindx[j] + i]
+                                );
         preparePosteriorBoundaries(matrices->k_max_Q_M1[jindx[j] + i] -
                                    matrices->k_min_Q_M1[jindx[j] + i] + 1,
                                    matrices->k_min_Q_M1[jindx[j] + i],
@@ -771,12 +806,12 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                    &l_max_post_m1
                                    );
 
-        prepareArray(&matrices->Q_M1[jindx[j] + i],
-                     matrices->k_min_Q_M1[jindx[j] + i],
-                     matrices->k_max_Q_M1[jindx[j] + i],
-                     matrices->l_min_Q_M1[jindx[j] + i],
-                     matrices->l_max_Q_M1[jindx[j] + i]
-                     );
+        prepareArrayBlock(&matrices->Q_M1[jindx[j] + i],
+                          matrices->k_min_Q_M1[jindx[j] + i],
+                          matrices->k_max_Q_M1[jindx[j] + i],
+                          matrices->l_min_Q_M1[jindx[j] + i],
+                          matrices->l_max_Q_M1[jindx[j] + i]
+                          );
       }
 
       /* j is unpaired */
@@ -1011,51 +1046,52 @@ pf2D_linear(vrna_fold_compound_t *vc)
       }
 
       if (update_m) {
-        adjustArrayBoundaries(&matrices->Q_M[ij],
-                              &matrices->k_min_Q_M[ij],
-                              &matrices->k_max_Q_M[ij],
-                              &matrices->l_min_Q_M[ij],
-                              &matrices->l_max_Q_M[ij],
-                              k_min_post_m,
-                              k_max_post_m,
-                              l_min_post_m,
-                              l_max_post_m
-                              );
+        moveArrayToPool(matrices->pool,
+                        &matrices->Q_M[ij],
+                        &matrices->k_min_Q_M[ij],
+                        &matrices->k_max_Q_M[ij],
+                        &matrices->l_min_Q_M[ij],
+                        &matrices->l_max_Q_M[ij],
+                        k_min_post_m,
+                        k_max_post_m,
+                        l_min_post_m,
+                        l_max_post_m
+                        );
       }
 
       if (update_m1) {
-        adjustArrayBoundaries(&matrices->Q_M1[jindx[j] + i],
-                              &matrices->k_min_Q_M1[jindx[j] + i],
-                              &matrices->k_max_Q_M1[jindx[j] + i],
-                              &matrices->l_min_Q_M1[jindx[j] + i],
-                              &matrices->l_max_Q_M1[jindx[j] + i],
-                              k_min_post_m1,
-                              k_max_post_m1,
-                              l_min_post_m1,
-                              l_max_post_m1
-                              );
+        moveArrayToPool(matrices->pool,
+                        &matrices->Q_M1[jindx[j] + i],
+                        &matrices->k_min_Q_M1[jindx[j] + i],
+                        &matrices->k_max_Q_M1[jindx[j] + i],
+                        &matrices->l_min_Q_M1[jindx[j] + i],
+                        &matrices->l_max_Q_M1[jindx[j] + i],
+                        k_min_post_m1,
+                        k_max_post_m1,
+                        l_min_post_m1,
+                        l_max_post_m1
+                        );
       }
 
       /* compute contributions for Q(i,j) */
-      int k_min, k_max, l_min, l_max;
+      int k_max, l_max;
       int k_min_post, k_max_post, *l_min_post, *l_max_post;
       int update_q = 0;
       if (!matrices->Q[ij]) {
         update_q  = 1;
-        k_min     = l_min = 0;
         k_max     = mm1[ij] + referenceBPs1[ij];
         l_max     = mm2[ij] + referenceBPs2[ij];
 
-        prepareBoundaries(k_min,
-                          k_max,
-                          l_min,
-                          l_max,
-                          bpdist[ij],
-                          &matrices->k_min_Q[ij],
-                          &matrices->k_max_Q[ij],
-                          &matrices->l_min_Q[ij],
-                          &matrices->l_max_Q[ij]
-                          );
+        prepareBandedBoundaries(k_max,
+                                l_max,
+                                bpdist[ij],
+                                maxD1,
+                                maxD2,
+                                &matrices->k_min_Q[ij],
+                                &matrices->k_max_Q[ij],
+                                &matrices->l_min_Q[ij],
+                                &matrices->l_max_Q[ij]
+                                );
         preparePosteriorBoundaries(matrices->k_max_Q[ij] - matrices->k_min_Q[ij] + 1,
                                    matrices->k_min_Q[ij],
                                    &k_min_post,
@@ -1064,12 +1100,12 @@ pf2D_linear(vrna_fold_compound_t *vc)
                                    &l_max_post
                                    );
 
-        prepareArray(&matrices->Q[ij],
-                     matrices->k_min_Q[ij],
-                     matrices->k_max_Q[ij],
-                     matrices->l_min_Q[ij],
-                     matrices->l_max_Q[ij]
-                     );
+        prepareArrayBlock(&matrices->Q[ij],
+                          matrices->k_min_Q[ij],
+                          matrices->k_max_Q[ij],
+                          matrices->l_min_Q[ij],
+                          matrices->l_max_Q[ij]
+                          );
       }
 
       if (type) {
@@ -1223,16 +1259,17 @@ pf2D_linear(vrna_fold_compound_t *vc)
       }
 
       if (update_q) {
-        adjustArrayBoundaries(&matrices->Q[ij],
-                              &matrices->k_min_Q[ij],
-                              &matrices->k_max_Q[ij],
-                              &matrices->l_min_Q[ij],
-                              &matrices->l_max_Q[ij],
-                              k_min_post,
-                              k_max_post,
-                              l_min_post,
-                              l_max_post
-                              );
+        moveArrayToPool(matrices->pool,
+                        &matrices->Q[ij],
+                        &matrices->k_min_Q[ij],
+                        &matrices->k_max_Q[ij],
+                        &matrices->l_min_Q[ij],
+                        &matrices->l_max_Q[ij],
+                        k_min_post,
+                        k_max_post,
+                        l_min_post,
+                        l_max_post
+                        );
       }
 
 #if 1
@@ -4418,6 +4455,157 @@ prepareArray(FLT_OR_DBL ***array,
 }
 
 
+/*
+ * Boundaries for the per-cell arrays of Q, Q_B, Q_M, and Q_M1. Any structure
+ * on [i,j] with distances (k,l) to both references satisfies k + l >= bpdist
+ * and |k - l| <= bpdist, while contributions beyond maxD1/maxD2 go to the
+ * *_rem arrays. Thus, the band below covers all entries we ever write.
+ */
+INLINE PRIVATE void
+prepareBandedBoundaries(int max_k_pre,
+                        int max_l_pre,
+                        int bpdist,
+                        int maxD1,
+                        int maxD2,
+                        int *min_k,
+                        int *max_k,
+                        int **min_l,
+                        int **max_l)
+{
+  int cnt, mem;
+
+  *min_k  = MAX2(0, bpdist - maxD2);
+  *max_k  = MIN2(max_k_pre, MIN2(maxD1, bpdist + maxD2));
+
+  /* keep a single (empty) row if nothing fits into the band */
+  if (*max_k < *min_k)
+    *max_k = *min_k;
+
+  mem     = *max_k - *min_k + 1;
+  *min_l  = (int *)vrna_alloc(sizeof(int) * mem);
+  *max_l  = (int *)vrna_alloc(sizeof(int) * mem);
+
+  *min_l  -= *min_k;
+  *max_l  -= *min_k;
+
+  for (cnt = *min_k; cnt <= *max_k; cnt++) {
+    (*min_l)[cnt] = (cnt < bpdist) ? bpdist - cnt : cnt - bpdist;
+    (*max_l)[cnt] = MIN2(MIN2(max_l_pre, maxD2), cnt + bpdist);
+  }
+}
+
+
+/*
+ * Scratch array with the same layout as prepareArray() but all rows in a
+ * single, zero-initialized memory block. Rows with min_l > max_l are empty.
+ */
+INLINE PRIVATE void
+prepareArrayBlock(FLT_OR_DBL  ***array,
+                  int         min_k,
+                  int         max_k,
+                  int         *min_l,
+                  int         *max_l)
+{
+  char        *block;
+  int         i, mem;
+  FLT_OR_DBL  *data;
+
+  mem = 0;
+  for (i = min_k; i <= max_k; i++)
+    if (max_l[i] >= min_l[i])
+      mem += (max_l[i] - min_l[i]) / 2 + 1;
+
+  block = (char *)vrna_alloc(sizeof(FLT_OR_DBL *) * (max_k - min_k + 1) +
+                             sizeof(FLT_OR_DBL) * MAX2(mem, 1));
+  data = (FLT_OR_DBL *)(block + sizeof(FLT_OR_DBL *) * (max_k - min_k + 1));
+
+  *array  = (FLT_OR_DBL **)block;
+  *array  -= min_k;
+
+  for (i = min_k; i <= max_k; i++) {
+    (*array)[i] = data - min_l[i] / 2;
+    if (max_l[i] >= min_l[i])
+      data += (max_l[i] - min_l[i]) / 2 + 1;
+  }
+}
+
+
+/*
+ * Counterpart of adjustArrayBoundaries() for scratch arrays obtained from
+ * prepareArrayBlock(). Copies the actually used entries into a single block
+ * of the memory pool and releases the scratch memory.
+ */
+PRIVATE void
+moveArrayToPool(vrna_mx_pool_t  *pool,
+                FLT_OR_DBL      ***array,
+                int             *k_min,
+                int             *k_max,
+                int             **l_min,
+                int             **l_max,
+                int             k_min_post,
+                int             k_max_post,
+                int             *l_min_post,
+                int             *l_max_post)
+{
+  char        *block;
+  int         cnt1, k_span, mem, *l_min_pool, *l_max_pool;
+  FLT_OR_DBL  **rows, *data;
+
+  rows        = NULL;
+  l_min_pool  = NULL;
+  l_max_pool  = NULL;
+
+  if (k_min_post < INF) {
+    k_span  = k_max_post - k_min_post + 1;
+    mem     = 0;
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++)
+      if (l_min_post[cnt1] < INF)
+        mem += (l_max_post[cnt1] - l_min_post[cnt1]) / 2 + 1;
+
+    /* row pointers first, followed by the data and the l boundaries */
+    block = (char *)vrna_mx_pool_alloc(pool,
+                                       sizeof(FLT_OR_DBL *) * k_span +
+                                       sizeof(FLT_OR_DBL) * mem +
+                                       sizeof(int) * 2 * k_span);
+    rows        = (FLT_OR_DBL **)block;
+    data        = (FLT_OR_DBL *)(block + sizeof(FLT_OR_DBL *) * k_span);
+    l_min_pool  = (int *)(data + mem);
+    l_max_pool  = l_min_pool + k_span;
+
+    rows        -= k_min_post;
+    l_min_pool  -= k_min_post;
+    l_max_pool  -= k_min_post;
+
+    for (cnt1 = k_min_post; cnt1 <= k_max_post; cnt1++) {
+      l_min_pool[cnt1]  = l_min_post[cnt1];
+      l_max_pool[cnt1]  = l_max_post[cnt1];
+
+      if (l_min_post[cnt1] < INF) {
+        mem = (l_max_post[cnt1] - l_min_post[cnt1]) / 2 + 1;
+        memcpy(data, (*array)[cnt1] + l_min_post[cnt1] / 2, sizeof(FLT_OR_DBL) * mem);
+        rows[cnt1]  = data - l_min_post[cnt1] / 2;
+        data        += mem;
+      } else {
+        rows[cnt1] = NULL;
+      }
+    }
+  }
+
+  /* release scratch array and boundaries */
+  free(*array + *k_min);
+  free(*l_min + *k_min);
+  free(*l_max + *k_min);
+  free(l_min_post + *k_min);
+  free(l_max_post + *k_min);
+
+  *array  = rows;
+  *l_min  = l_min_pool;
+  *l_max  = l_max_pool;
+  *k_min  = k_min_post;
+  *k_max  = k_max_post;
+}
+
+
 /*
  #################################
  # DEPRECATED FUNCTIONS BELOW    #
@@ -0,0 +1,618 @@
+/*
+ *  accessibility.c
+ *
+ *  A persistent store of probabilities to be unpaired
+ *
+ *  Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/strings.h"
+#include "ViennaRNA/io/utils.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/part_func_window.h"
+#include "ViennaRNA/accessibility.h"
+
+/*
+ *  Layout of a profile file:
+ *  header:   8 bytes magic, uint32_t version, length, ulength, int32_t window_size,
+ *            max_bp_span, uint32_t scale, uint64_t key, 8 bytes reserved
+ *  sequence: length characters, padded with zeros to a multiple of 8 bytes
+ *  values:   length rows of ulength uint16_t, where the u-th value of row i encodes
+ *            the probability that segment [i - u + 1, i] is unpaired as
+ *            round(-ln(p) * scale), or ACCESS_STORE_NA if p = 0
+ */
+#define ACCESS_STORE_MAGIC    "VRNAUPST"
+#define ACCESS_STORE_VERSION  1
+#define ACCESS_STORE_HEADER   48
+#define ACCESS_STORE_SCALE    2048
+#define ACCESS_STORE_NA       0xFFFF
+#define ACCESS_STORE_ALIGN(x) (((x) + 7) & ~((size_t)7))
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct vrna_access_store_s {
+  char *directory;
+};
+
+struct vrna_access_profile_s {
+  unsigned char   *data;    /* the entire profile file */
+  size_t          size;     /* size of the profile file in bytes */
+  int             mapped;   /* whether data is memory-mapped */
+  unsigned int    length;   /* length of the sequence */
+  unsigned int    ulength;  /* maximal length of unpaired segments */
+  const uint16_t  *values;  /* quantized probabilities, row by row */
+};
+
+/* what identifies a profile */
+struct access_settings {
+  const char    *sequence;
+  unsigned int  length;
+  unsigned int  ulength;
+  int           window_size;
+  int           max_bp_span;
+  uint64_t      key;
+};
+
+struct access_cb_data {
+  uint16_t      *values;
+  unsigned int  ulength;
+};
+
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE uint64_t
+hash_bytes(uint64_t   h,
+           const void *data,
+           size_t     size);
+
+
+PRIVATE uint64_t
+access_key(const struct access_settings *s,
+           vrna_md_t                    *md);
+
+
+PRIVATE vrna_access_profile_t *
+profile_load(const char                   *filename,
+             const struct access_settings *s);
+
+
+PRIVATE vrna_access_profile_t *
+profile_compute(const char                    *filename,
+                const struct access_settings  *s,
+                vrna_md_t                     *md);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC vrna_access_store_t *
+vrna_access_store_open(const char *directory)
+{
+  vrna_access_store_t *store;
+
+  if (!directory)
+    return NULL;
+
+  if (vrna_mkdir_p(directory) != 0)
+    return NULL;
+
+  store             = (vrna_access_store_t *)vrna_alloc(sizeof(vrna_access_store_t));
+  store->directory  = strdup(directory);
+
+  return store;
+}
+
+
+PUBLIC void
+vrna_access_store_close(vrna_access_store_t *store)
+{
+  if (store) {
+    free(store->directory);
+    free(store);
+  }
+}
+
+
+PUBLIC vrna_access_profile_t *
+vrna_access_store_get(vrna_access_store_t *store,
+                      const char          *sequence,
+                      unsigned int        ulength,
+                      int                 window_size,
+                      int                 max_bp_span,
+                      const vrna_md_t     *md)
+{
+  char                    *seq, *filename;
+  vrna_md_t               md_local;
+  vrna_access_profile_t   *profile;
+  struct access_settings  s;
+
+  if ((!store) ||
+      (!sequence) ||
+      (ulength == 0))
+    return NULL;
+
+  if (md)
+    md_local = *md;
+  else
+    vrna_md_set_default(&md_local);
+
+  seq = strdup(sequence);
+  vrna_seq_toupper(seq);
+  vrna_seq_toRNA(seq);
+
+  s.sequence  = seq;
+  s.length    = (unsigned int)strlen(seq);
+  s.ulength   = ulength;
+
+  if (s.length == 0) {
+    free(seq);
+    return NULL;
+  }
+
+  /* the same sanitizing the fold compound applies, such that equivalent settings share a profile */
+  s.window_size = ((window_size <= 0) || (window_size > (int)s.length)) ?
+                  (int)s.length :
+                  window_size;
+  s.max_bp_span = ((max_bp_span <= 0) || (max_bp_span > s.window_size)) ?
+                  s.window_size :
+                  max_bp_span;
+
+  md_local.compute_bpp  = 1;
+  md_local.window_size  = s.window_size;
+  md_local.max_bp_span  = s.max_bp_span;
+
+  s.key     = access_key(&s, &md_local);
+  filename  = vrna_strdup_printf("%s/%016llx.up",
+                                 store->directory,
+                                 (unsigned long long)s.key);
+
+  profile = profile_load(filename, &s);
+
+  if (!profile)
+    profile = profile_compute(filename, &s, &md_local);
+
+  free(filename);
+  free(seq);
+
+  return profile;
+}
+
+
+PUBLIC void
+vrna_access_profile_free(vrna_access_profile_t *profile)
+{
+  if (profile) {
+#ifndef _WIN32
+    if (profile->mapped)
+      munmap(profile->data, profile->size);
+    else
+#endif
+    free(profile->data);
+
+    free(profile);
+  }
+}
+
+
+PUBLIC unsigned int
+vrna_access_profile_length(const vrna_access_profile_t *profile)
+{
+  return (profile) ? profile->length : 0;
+}
+
+
+PUBLIC unsigned int
+vrna_access_profile_ulength(const vrna_access_profile_t *profile)
+{
+  return (profile) ? profile->ulength : 0;
+}
+
+
+PUBLIC double
+vrna_access_profile_up(const vrna_access_profile_t  *profile,
+                       unsigned int                 i,
+                       unsigned int                 u)
+{
+  uint16_t v;
+
+  if ((!profile) ||
+      (i == 0) ||
+      (i > profile->length) ||
+      (u == 0) ||
+      (u > profile->ulength))
+    return 0.;
+
+  v = profile->values[(size_t)(i - 1) * profile->ulength + u - 1];
+
+  if (v == ACCESS_STORE_NA)
+    return 0.;
+
+  return exp(-(double)v / ACCESS_STORE_SCALE);
+}
+
+
+PUBLIC double **
+vrna_access_profile_matrix(const vrna_access_profile_t *profile)
+{
+  unsigned int  i, u;
+  double        **pU;
+
+  if (!profile)
+    return NULL;
+
+  pU = (double **)vrna_alloc(sizeof(double *) * (profile->length + 2));
+
+  for (i = 1; i <= profile->length; i++) {
+    pU[i] = (double *)vrna_alloc(sizeof(double) * (profile->ulength + 2));
+    for (u = 1; u <= profile->ulength; u++)
+      pU[i][u] = vrna_access_profile_up(profile, i, u);
+  }
+
+  return pU;
+}
+
+
+/*
+ #################################
+ # STATIC helper functions below #
+ #################################
+ */
+
+/* 64-bit FNV-1a */
+PRIVATE uint64_t
+hash_bytes(uint64_t   h,
+           const void *data,
+           size_t     size)
+{
+  size_t              k;
+  const unsigned char *p = (const unsigned char *)data;
+
+  for (k = 0; k < size; k++) {
+    h ^= (uint64_t)p[k];
+    h *= 0x100000001B3ULL;
+  }
+
+  return h;
+}
+
+
+PRIVATE uint64_t
+access_key(const struct access_settings *s,
+           vrna_md_t                    *md)
+{
+  uint64_t      h;
+  vrna_param_t  *P;
+
+  h = 0xCBF29CE484222325ULL;
+  h = hash_bytes(h, s->sequence, s->length);
+  h = hash_bytes(h, &(s->ulength), sizeof(s->ulength));
+  h = hash_bytes(h, &(s->window_size), sizeof(s->window_size));
+  h = hash_bytes(h, &(s->max_bp_span), sizeof(s->max_bp_span));
+
+  /* model details that affect the probabilities, one by one to skip any padding */
+  h = hash_bytes(h, &(md->temperature), sizeof(md->temperature));
+  h = hash_bytes(h, &(md->betaScale), sizeof(md->betaScale));
+  h = hash_bytes(h, &(md->pf_smooth), sizeof(md->pf_smooth));
+  h = hash_bytes(h, &(md->dangles), sizeof(md->dangles));
+  h = hash_bytes(h, &(md->special_hp), sizeof(md->special_hp));
+  h = hash_bytes(h, &(md->noLP), sizeof(md->noLP));
+  h = hash_bytes(h, &(md->noGU), sizeof(md->noGU));
+  h = hash_bytes(h, &(md->noGUclosure), sizeof(md->noGUclosure));
+  h = hash_bytes(h, &(md->logML), sizeof(md->logML));
+  h = hash_bytes(h, &(md->circ), sizeof(md->circ));
+  h = hash_bytes(h, &(md->gquad), sizeof(md->gquad));
+  h = hash_bytes(h, &(md->energy_set), sizeof(md->energy_set));
+  h = hash_bytes(h, md->nonstandards, strlen(md->nonstandards));
+  h = hash_bytes(h, &(md->min_loop_size), sizeof(md->min_loop_size));
+  h = hash_bytes(h, &(md->salt), sizeof(md->salt));
+  h = hash_bytes(h, &(md->saltMLLower), sizeof(md->saltMLLower));
+  h = hash_bytes(h, &(md->saltMLUpper), sizeof(md->saltMLUpper));
+  h = hash_bytes(h, &(md->saltDPXInit), sizeof(md->saltDPXInit));
+  h = hash_bytes(h, &(md->saltDPXInitFact), sizeof(md->saltDPXInitFact));
+  h = hash_bytes(h, &(md->helical_rise), sizeof(md->helical_rise));
+  h = hash_bytes(h, &(md->backbone_length), sizeof(md->backbone_length));
+
+  /*
+   *  the energy parameters currently loaded, i.e. everything but the model details
+   *  and the parameter file name. The data structure is zero-initialized, so any
+   *  padding in between does not disturb the hash
+   */
+  P = vrna_params(md);
+  h = hash_bytes(h,
+                 (const unsigned char *)P + offsetof(vrna_param_t, stack),
+                 offsetof(vrna_param_t, model_details) - offsetof(vrna_param_t, stack));
+  h = hash_bytes(h,
+                 (const unsigned char *)P + offsetof(vrna_param_t, SaltStack),
+                 sizeof(vrna_param_t) - offsetof(vrna_param_t, SaltStack));
+  free(P);
+
+  /* 0 is no valid key */
+  return (h) ? h : 1;
+}
+
+
+PRIVATE size_t
+profile_size(const struct access_settings *s)
+{
+  return ACCESS_STORE_ALIGN(ACCESS_STORE_HEADER + (size_t)s->length) +
+         sizeof(uint16_t) * (size_t)s->length * s->ulength;
+}
+
+
+/* assign the pointers into a profile file, and check whether it matches the settings */
+PRIVATE int
+profile_validate(vrna_access_profile_t        *profile,
+                 const struct access_settings *s)
+{
+  unsigned char *d;
+  uint32_t      version, length, ulength, scale;
+  int32_t       window_size, max_bp_span;
+  uint64_t      key;
+
+  d = profile->data;
+
+  if (profile->size < ACCESS_STORE_HEADER)
+    return 0;
+
+  memcpy(&version, d + 8, sizeof(uint32_t));
+  memcpy(&length, d + 12, sizeof(uint32_t));
+  memcpy(&ulength, d + 16, sizeof(uint32_t));
+  memcpy(&window_size, d + 20, sizeof(int32_t));
+  memcpy(&max_bp_span, d + 24, sizeof(int32_t));
+  memcpy(&scale, d + 28, sizeof(uint32_t));
+  memcpy(&key, d + 32, sizeof(uint64_t));
+
+  if ((memcmp(d, ACCESS_STORE_MAGIC, 8) != 0) ||
+      (version != ACCESS_STORE_VERSION) ||
+      (length != s->length) ||
+      (ulength != s->ulength) ||
+      (window_size != s->window_size) ||
+      (max_bp_span != s->max_bp_span) ||
+      (scale != ACCESS_STORE_SCALE) ||
+      (key != s->key) ||
+      (profile->size < profile_size(s)) ||
+      (memcmp(d + ACCESS_STORE_HEADER, s->sequence, s->length) != 0))
+    return 0;
+
+  profile->length   = length;
+  profile->ulength  = ulength;
+  profile->values   = (const uint16_t *)(d + ACCESS_STORE_ALIGN(ACCESS_STORE_HEADER + (size_t)length));
+
+  return 1;
+}
+
+
+PRIVATE vrna_access_profile_t *
+profile_load(const char                   *filename,
+             const struct access_settings *s)
+{
+  unsigned char         *data;
+  int                   mapped;
+  size_t                size;
+  vrna_access_profile_t *profile;
+
+  data    = NULL;
+  mapped  = 0;
+  size    = 0;
+
+#ifndef _WIN32
+  {
+    int         fd;
+    struct stat st;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+      return NULL;
+
+    if ((fstat(fd, &st) == 0) && (st.st_size >= ACCESS_STORE_HEADER)) {
+      size  = (size_t)st.st_size;
+      data  = (unsigned char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == (unsigned char *)MAP_FAILED)
+        data = NULL;
+      else
+        mapped = 1;
+    }
+
+    close(fd);
+  }
+#endif
+
+  if (!data) {
+    /* fall back to reading the entire file into memory */
+    FILE *fp;
+    long len;
+
+    if (!(fp = fopen(filename, "rb")))
+      return NULL;
+
+    if ((fseek(fp, 0, SEEK_END) == 0) &&
+        ((len = ftell(fp)) >= ACCESS_STORE_HEADER) &&
+        (fseek(fp, 0, SEEK_SET) == 0)) {
+      size  = (size_t)len;
+      data  = (unsigned char *)vrna_alloc(size);
+      if (fread(data, 1, size, fp) != size) {
+        free(data);
+        data = NULL;
+      }
+    }
+
+    fclose(fp);
+
+    if (!data)
+      return NULL;
+  }
+
+  profile         = (vrna_access_profile_t *)vrna_alloc(sizeof(vrna_access_profile_t));
+  profile->data   = data;
+  profile->size   = size;
+  profile->mapped = mapped;
+
+  if (!profile_validate(profile, s)) {
+    /* hash collision, different settings, or broken file */
+    vrna_access_profile_free(profile);
+    return NULL;
+  }
+
+  return profile;
+}
+
+
+PRIVATE void
+access_cb(FLT_OR_DBL    *pr,
+          int           pr_size,
+          int           i,
+          int           max,
+          unsigned int  type,
+          void          *data)
+{
+  int                   u;
+  double                v;
+  uint16_t              *row;
+  struct access_cb_data *d = (struct access_cb_data *)data;
+
+  if ((type & VRNA_PROBS_WINDOW_UP) && ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP)) {
+    row = d->values + (size_t)(i - 1) * d->ulength;
+
+    for (u = 1; u <= MIN2(pr_size, (int)d->ulength); u++) {
+      if (pr[u] >= 1.) {
+        row[u - 1] = 0;
+      } else if (pr[u] > 0.) {
+        v           = -log(pr[u]) * ACCESS_STORE_SCALE + 0.5;
+        row[u - 1]  = (v < ACCESS_STORE_NA - 1) ?
+                      (uint16_t)v :
+                      ACCESS_STORE_NA - 1;
+      }
+    }
+  }
+}
+
+
+PRIVATE vrna_access_profile_t *
+profile_compute(const char                    *filename,
+                const struct access_settings  *s,
+                vrna_md_t                     *md)
+{
+  unsigned char         *data;
+  int                   ret;
+  uint32_t              v;
+  size_t                size, k;
+  char                  *tmp_name;
+  FILE                  *fp;
+  vrna_fold_compound_t  *fc;
+  vrna_access_profile_t *profile;
+  struct access_cb_data d;
+
+  fc = vrna_fold_compound(s->sequence, md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  if (!fc)
+    return NULL;
+
+  size  = profile_size(s);
+  data  = (unsigned char *)vrna_alloc(size);
+
+  memcpy(data, ACCESS_STORE_MAGIC, 8);
+  v = ACCESS_STORE_VERSION;
+  memcpy(data + 8, &v, sizeof(uint32_t));
+  memcpy(data + 12, &(s->length), sizeof(uint32_t));
+  memcpy(data + 16, &(s->ulength), sizeof(uint32_t));
+  memcpy(data + 20, &(s->window_size), sizeof(int32_t));
+  memcpy(data + 24, &(s->max_bp_span), sizeof(int32_t));
+  v = ACCESS_STORE_SCALE;
+  memcpy(data + 28, &v, sizeof(uint32_t));
+  memcpy(data + 32, &(s->key), sizeof(uint64_t));
+  memcpy(data + ACCESS_STORE_HEADER, s->sequence, s->length);
+
+  d.values  = (uint16_t *)(data + ACCESS_STORE_ALIGN(ACCESS_STORE_HEADER + (size_t)s->length));
+  d.ulength = s->ulength;
+
+  for (k = 0; k < (size_t)s->length * s->ulength; k++)
+    d.values[k] = ACCESS_STORE_NA;
+
+  vrna_ptypes_prepare(fc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ret = vrna_probs_window(fc, (int)s->ulength, VRNA_PROBS_WINDOW_UP, &access_cb, &d);
+  vrna_fold_compound_free(fc);
+
+  if (!ret) {
+    free(data);
+    return NULL;
+  }
+
+  /* write to a temporary file first, so concurrent readers never see a partial profile */
+  fp = NULL;
+#ifndef _WIN32
+  {
+    int fd;
+
+    tmp_name = vrna_strdup_printf("%s.XXXXXX", filename);
+    if ((fd = mkstemp(tmp_name)) >= 0) {
+      /* mkstemp() restricts access to the owner, but the store may be shared */
+      (void)fchmod(fd, 0644);
+      if (!(fp = fdopen(fd, "wb")))
+        close(fd);
+    }
+  }
+#else
+  tmp_name  = vrna_strdup_printf("%s.tmp", filename);
+  fp        = fopen(tmp_name, "wb");
+#endif
+
+  if (fp) {
+    ret = (fwrite(data, 1, size, fp) == size);
+    if (fclose(fp) != 0)
+      ret = 0;
+
+#ifdef _WIN32
+    /* rename() does not replace existing files here */
+    if (ret)
+      remove(filename);
+
+#endif
+
+    if ((!ret) ||
+        (rename(tmp_name, filename) != 0)) {
+      vrna_message_warning("vrna_access_store_get: Failed to write profile %s", filename);
+      remove(tmp_name);
+    }
+  } else {
+    vrna_message_warning("vrna_access_store_get: Can't open file %s for writing", tmp_name);
+  }
+
+  free(tmp_name);
+
+  /* the profile is usable even if it could not be stored */
+  profile         = (vrna_access_profile_t *)vrna_alloc(sizeof(vrna_access_profile_t));
+  profile->data   = data;
+  profile->size   = size;
+  profile->mapped = 0;
+  (void)profile_validate(profile, s);
+
+  return profile;
+}
@@ -0,0 +1,154 @@
+#ifndef VIENNA_RNA_PACKAGE_ACCESSIBILITY_H
+#define VIENNA_RNA_PACKAGE_ACCESSIBILITY_H
+
+#include <ViennaRNA/model.h>
+
+/**
+ *  @file     accessibility.h
+ *  @ingroup  part_func_window
+ *  @brief    A persistent store of probabilities to be unpaired computed with the sliding window algorithm
+ */
+
+/**
+ *  @addtogroup part_func_window
+ *  @{
+ */
+
+/**
+ *  @brief  A persistent store of accessibility profiles
+ *
+ *  The store is a directory that holds one binary file per profile. Each file is
+ *  named after a 64-bit hash of the sequence, the window settings, the maximum
+ *  length of unpaired segments, the model details, and the energy parameters
+ *  the profile has been computed with.
+ *
+ *  @see vrna_access_store_open(), vrna_access_store_get()
+ */
+typedef struct vrna_access_store_s vrna_access_store_t;
+
+/**
+ *  @brief  An accessibility profile, i.e. the probabilities to be unpaired of a sequence
+ *
+ *  @see vrna_access_store_get(), vrna_access_profile_up()
+ */
+typedef struct vrna_access_profile_s vrna_access_profile_t;
+
+
+/**
+ *  @brief  Open an accessibility store
+ *
+ *  The directory is created if it does not exist yet.
+ *
+ *  @see  vrna_access_store_close(), vrna_access_store_get()
+ *
+ *  @param  directory   The directory that holds the store
+ *  @return             The store, or @em NULL on any error
+ */
+vrna_access_store_t *
+vrna_access_store_open(const char *directory);
+
+
+/**
+ *  @brief  Close an accessibility store
+ *
+ *  Profiles obtained from the store remain valid and must be released
+ *  with vrna_access_profile_free().
+ *
+ *  @param  store   The store
+ */
+void
+vrna_access_store_close(vrna_access_store_t *store);
+
+
+/**
+ *  @brief  Get the accessibility profile of a sequence from the store
+ *
+ *  If the store does not contain a profile for this combination of sequence, settings,
+ *  and model details yet, it is computed with vrna_probs_window() and
+ *  #VRNA_PROBS_WINDOW_UP, the same way RNAplfold -u computes it, and added to the store.
+ *  Otherwise, the stored profile is memory-mapped where supported, so repeated queries
+ *  neither fold the sequence again nor read more than they use.
+ *
+ *  Probabilities are stored as 16-bit quantized values of @f$ -\ln p @f$ with a
+ *  resolution of @f$ 1/2048 @f$, i.e. with a relative error below @f$ 0.025\% @f$.
+ *  Probabilities below @f$ e^{-32} @f$ are rounded up to this value.
+ *
+ *  This function may be called concurrently for the same store, also from different
+ *  processes. New profiles are first written to a temporary file that is renamed once
+ *  complete.
+ *
+ *  @see  vrna_access_profile_up(), vrna_access_profile_matrix(), vrna_access_profile_free(),
+ *        vrna_pfl_fold_up()
+ *
+ *  @param  store         The store
+ *  @param  sequence      The RNA sequence
+ *  @param  ulength       The maximal length of unpaired segments
+ *  @param  window_size   The size of the sliding window
+ *  @param  max_bp_span   The maximal base pair span
+ *  @param  md            The model details (may be @em NULL)
+ *  @return               The accessibility profile, or @em NULL on any error
+ */
+vrna_access_profile_t *
+vrna_access_store_get(vrna_access_store_t *store,
+                      const char          *sequence,
+                      unsigned int        ulength,
+                      int                 window_size,
+                      int                 max_bp_span,
+                      const vrna_md_t     *md);
+
+
+/**
+ *  @brief  Release an accessibility profile
+ *
+ *  @param  profile   The profile
+ */
+void
+vrna_access_profile_free(vrna_access_profile_t *profile);
+
+
+/**
+ *  @brief  Get the length of the sequence of an accessibility profile
+ */
+unsigned int
+vrna_access_profile_length(const vrna_access_profile_t *profile);
+
+
+/**
+ *  @brief  Get the maximal length of unpaired segments of an accessibility profile
+ */
+unsigned int
+vrna_access_profile_ulength(const vrna_access_profile_t *profile);
+
+
+/**
+ *  @brief  Get the probability of a segment to be unpaired
+ *
+ *  @param  profile   The profile
+ *  @param  i         The 3' end of the segment (1-based)
+ *  @param  u         The length of the segment, i.e. the segment is @f$ [i - u + 1, i] @f$
+ *  @return           The probability that the segment is unpaired, or 0 if the segment is invalid
+ */
+double
+vrna_access_profile_up(const vrna_access_profile_t  *profile,
+                       unsigned int                 i,
+                       unsigned int                 u);
+
+
+/**
+ *  @brief  Get all probabilities to be unpaired of an accessibility profile
+ *
+ *  The matrix is laid out as the one returned by vrna_pfl_fold_up(), i.e. the
+ *  probability that the segment of length @f$ u @f$ ending at position
+ *  @f$ i @f$ is unpaired is stored in @f$ X[i][u] @f$. It is the users
+ *  responsibility to free the memory occupied by this matrix.
+ *
+ *  @param  profile   The profile
+ *  @return           The probabilities to be unpaired, or @em NULL on any error
+ */
+double **
+vrna_access_profile_matrix(const vrna_access_profile_t *profile);
+
+
+/**@}*/
+
+#endif
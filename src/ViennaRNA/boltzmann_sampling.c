@@ -441,7 +441,6 @@ backtrack_ext_loop(int                              start,
                    struct sc_wrappers               *sc_wrap,
                    struct vrna_pbacktrack_memory_s  *nr_mem)
 {
-  unsigned char         *hard_constraints;
   short                 *S1, *S2, **S, **S5, **S3;
   unsigned int          **a2s, s, n_seq;
   int                   ret, i, j, ij, n, k, type, *my_iindx, hc_decompose, *hc_up_ext;
@@ -502,7 +501,6 @@ backtrack_ext_loop(int                              start,
     a2s   = vc->a2s;
   }
 
-  hard_constraints  = hc->mx;
   hc_up_ext         = hc->up_ext;
   sc_wrapper_ext    = &(sc_wrap->sc_wrapper_ext);
 
@@ -602,7 +600,7 @@ backtrack_ext_loop(int                              start,
       /* apply alternating boustrophedon scheme to variable i */
       i             = is[k];
       ij            = my_iindx[i] - j;
-      hc_decompose  = hard_constraints[n * j + i];
+      hc_decompose  = vrna_hc_context(hc, j, i);
       if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         qkl = qb[ij] *
               q1k[i - 1];
@@ -910,10 +908,9 @@ backtrack_qm1(int                             i,
               struct vrna_pbacktrack_memory_s *nr_mem)
 {
   /* i is paired to l, i<l<j; backtrack in qm1 to find l */
-  unsigned char         *hard_constraints;
   char                  *ptype;
   short                 *S1, **S, **S5, **S3;
-  unsigned int          n, s, n_seq;
+  unsigned int          s, n_seq;
   int                   ii, l, il, type, turn, u, *my_iindx, *jindx, *hc_up_ml;
   FLT_OR_DBL            qt, fbd, fbds, r, q_temp, *qm1, *qb, *expMLbase;
   double                *q_remain;
@@ -943,7 +940,6 @@ backtrack_qm1(int                             i,
   NR_NODE *memorized_node_cur   = NULL;           /* remembers actual node in linked list */
 #endif
 
-  n                 = vc->length;
   fbd               = 0.;
   fbds              = 0.;
   pf_params         = vc->exp_params;
@@ -952,7 +948,6 @@ backtrack_qm1(int                             i,
   jindx             = vc->jindx;
   hc                = vc->hc;
   hc_up_ml          = hc->up_ml;
-  hard_constraints  = hc->mx;
   sc_wrapper_ml     = &(sc_wrap->sc_wrapper_ml);
 
   matrices  = vc->exp_matrices;
@@ -995,7 +990,7 @@ backtrack_qm1(int                             i,
   ii  = my_iindx[i];
   for (qt = 0., l = j; l > i + turn; l--) {
     il = jindx[l] + i;
-    if (hard_constraints[n * i + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+    if (vrna_hc_context(hc, i, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
       u = j - l;
       if (hc_up_ml[l + 1] >= u) {
         q_temp = qb[ii - l] *
@@ -1119,10 +1114,10 @@ backtrack(int                             i,
           struct sc_wrappers              *sc_wrap,
           struct vrna_pbacktrack_memory_s *nr_mem)
 {
-  unsigned char         *hard_constraints, hc_decompose;
+  unsigned char         hc_decompose;
   char                  *ptype;
   short                 *S1, **S, **S5, **S3;
-  unsigned int          **a2s, s, n_seq, n, type, type_2, *types, u1_local, u2_local;
+  unsigned int          **a2s, s, n_seq, type, type_2, *types, u1_local, u2_local;
   int                   *my_iindx, *jindx, *hc_up_int, ret, *pscore, turn, *rtype,
                         k, l, kl, u1, u2, max_k, min_l, ii, jj;
   FLT_OR_DBL            *qb, *qm, *qm1, *scale, r, fbd, fbds, qbt1, qbr, qt, q_temp,
@@ -1161,7 +1156,6 @@ backtrack(int                             i,
   qbt1    = 0.;
   q_temp  = 0.;
 
-  n         = vc->length;
   pf_params = vc->exp_params;
   kTn       = pf_params->kT / 10.;
   md        = &(pf_params->model_details);
@@ -1196,7 +1190,6 @@ backtrack(int                             i,
 
   hc                = vc->hc;
   hc_up_int         = hc->up_int;
-  hard_constraints  = hc->mx;
   sc_wrapper_int    = &(sc_wrap->sc_wrapper_int);
   sc_wrapper_ml     = &(sc_wrap->sc_wrapper_ml);
 
@@ -1214,7 +1207,7 @@ backtrack(int                             i,
 
 #endif
 
-  hc_decompose = hard_constraints[n * j + i];
+  hc_decompose = vrna_hc_context(hc, j, i);
 
   do {
     k = i;
@@ -1239,7 +1232,7 @@ backtrack(int                             i,
     r     = vrna_urn() * (qbr - fbd);
     qbt1  = 0.;
 
-    hc_decompose = hard_constraints[n * i + j];
+    hc_decompose = vrna_hc_context(hc, i, j);
 
     /* hairpin contribution */
     q_temp = vrna_exp_E_hp_loop(vc, i, j);
@@ -1295,7 +1288,7 @@ backtrack(int                             i,
           if (hc_up_int[l + 1] < u2)
             break;
 
-          if (hard_constraints[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+          if (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
             q_temp = qb[kl]
                      * scale[u1 + u2 + 2];
 
@@ -1385,7 +1378,7 @@ backtrack(int                             i,
   } while (1);
 
   /* backtrack in multi-loop */
-  if (hard_constraints[n * j + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+  if (vrna_hc_context(hc, j, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
     closingPair = expMLclosing *
                   scale[2];
 
@@ -1518,7 +1511,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                 vrna_bs_result_f  bs_cb,
                 void                              *data)
 {
-  unsigned char         *hc_mx, eval_loop;
+  unsigned char         eval_loop;
   char                  *pstruc;
   short                 *S1, *S2, **S, **S5, **S3;
   unsigned int          type, type2, *tt, s, n_seq, **a2s, u1_local,
@@ -1550,7 +1543,6 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
   qm2   = matrices->qm2;
   scale = matrices->scale;
 
-  hc_mx = vc->hc->mx;
   hc_up = vc->hc->up_int;
 
   sc_wrap         = sc_init(vc);
@@ -1617,7 +1609,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
         }
 
         /* 2. search for (k,l) with which we can close an interior loop  */
-        if (hc_mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_context(vc->hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           if (vc->type == VRNA_FC_TYPE_SINGLE)
             type = vrna_get_ptype_md(S2[j], S2[i], md);
           else
@@ -1646,7 +1638,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
               if ((ln1 + ln2 + ln3) > MAXLOOP)
                 continue;
 
-              eval_loop = hc_mx[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
+              eval_loop = vrna_hc_context(vc->hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
 
               if (eval_loop) {
                 q_temp = qb_ij *
@@ -21,9 +21,17 @@
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/io/file_formats.h"
 #include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/dp_matrices.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
+#include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/constraints/SHAPE.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -55,6 +63,26 @@ conversion_deigan(double  reactivity,
                   double  b);
 
 
+PRIVATE vrna_fold_compound_t *
+SHAPE_worker_init(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+SHAPE_worker_free(vrna_fold_compound_t *worker);
+
+
+PRIVATE int
+SHAPE_profile_apply(vrna_fold_compound_t          *fc,
+                    const vrna_sc_SHAPE_profile_t *profile);
+
+
+PRIVATE void
+SHAPE_profile_fold(vrna_fold_compound_t           *fc,
+                   const vrna_sc_SHAPE_profile_t  *profile,
+                   unsigned int                   options,
+                   vrna_sc_SHAPE_fold_t           *result);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -523,6 +551,89 @@ vrna_sc_SHAPE_parse_method(const char *method_string,
 }
 
 
+PUBLIC vrna_sc_SHAPE_fold_t *
+vrna_sc_SHAPE_fold_batch(vrna_fold_compound_t           *fc,
+                         const vrna_sc_SHAPE_profile_t  *profiles,
+                         unsigned int                   num,
+                         unsigned int                   options)
+{
+  int                   threads;
+  vrna_sc_SHAPE_fold_t  *results;
+
+  if ((!fc) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (!profiles) ||
+      (num == 0) ||
+      (!(options & (VRNA_OPTION_MFE | VRNA_OPTION_PF))))
+    return NULL;
+
+  if ((fc->hc) &&
+      (fc->hc->type == VRNA_HC_WINDOW)) {
+    vrna_message_warning("vrna_sc_SHAPE_fold_batch(): "
+                         "Fold compounds for sliding-window predictions are not supported!");
+    return NULL;
+  }
+
+  /*
+   *  energy parameters and hard constraints are shared among all profiles,
+   *  so they must be in place before the workers start
+   */
+  vrna_params_prepare(fc, options | VRNA_OPTION_MFE);
+  vrna_hc_prepare(fc, options | VRNA_OPTION_MFE);
+
+  results = (vrna_sc_SHAPE_fold_t *)vrna_alloc(sizeof(vrna_sc_SHAPE_fold_t) * num);
+  threads = 1;
+
+#ifdef _OPENMP
+  /* user callbacks and the multi-strand grammar extension can't be shared among threads */
+  if ((fc->strands == 1) &&
+      (!fc->stat_cb) &&
+      (!fc->aux_grammar))
+    threads = MIN2(omp_get_max_threads(), (int)num);
+
+#pragma omp parallel num_threads(threads)
+#endif
+  {
+    int                   k;
+    vrna_fold_compound_t  *worker;
+
+    worker = SHAPE_worker_init(fc);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (k = 0; k < (int)num; k++)
+      SHAPE_profile_fold(worker, profiles + k, options, results + k);
+
+    SHAPE_worker_free(worker);
+  }
+
+  return results;
+}
+
+
+PUBLIC void
+vrna_sc_SHAPE_fold_batch_free(vrna_sc_SHAPE_fold_t  *results,
+                              unsigned int          num)
+{
+  unsigned int k;
+
+  if (results) {
+    for (k = 0; k < num; k++) {
+      free(results[k].structure);
+      free(results[k].probs);
+    }
+
+    free(results);
+  }
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
 PRIVATE void
 sc_parse_parameters(const char  *string,
                     char        c1,
@@ -581,3 +692,131 @@ conversion_deigan(double  reactivity,
 {
   return reactivity < 0 ? 0. : (FLT_OR_DBL)(m * log(reactivity + 1) + b);
 }
+
+
+/*
+ *  A shallow copy of the fold compound that shares sequence encodings, pair
+ *  type arrays and hard constraints with the original, but owns its energy
+ *  parameters, soft constraints and DP matrices
+ */
+PRIVATE vrna_fold_compound_t *
+SHAPE_worker_init(vrna_fold_compound_t *fc)
+{
+  vrna_fold_compound_t *worker;
+
+  worker = (vrna_fold_compound_t *)vrna_alloc(sizeof(vrna_fold_compound_t));
+  memcpy(worker, fc, sizeof(vrna_fold_compound_t));
+
+  worker->params        = vrna_params_copy(fc->params);
+  worker->exp_params    = (fc->exp_params) ? vrna_exp_params_copy(fc->exp_params) : NULL;
+  worker->matrices      = NULL;
+  worker->exp_matrices  = NULL;
+  worker->sc            = NULL;
+
+  return worker;
+}
+
+
+PRIVATE void
+SHAPE_worker_free(vrna_fold_compound_t *worker)
+{
+  vrna_sc_remove(worker);
+  vrna_mx_mfe_free(worker);
+  vrna_mx_pf_free(worker);
+  free(worker->params);
+  free(worker->exp_params);
+  free(worker);
+}
+
+
+PRIVATE int
+SHAPE_profile_apply(vrna_fold_compound_t          *fc,
+                    const vrna_sc_SHAPE_profile_t *profile)
+{
+  unsigned int  i;
+  int           ret;
+  FLT_OR_DBL    *values;
+
+  ret = 0;
+
+  vrna_sc_remove(fc);
+
+  if (profile->reactivities) {
+    switch (profile->method) {
+      case 'D':
+        ret = vrna_sc_add_SHAPE_deigan(fc,
+                                       profile->reactivities,
+                                       profile->p1,
+                                       profile->p2,
+                                       VRNA_OPTION_DEFAULT);
+        break;
+
+      case 'Z':
+        ret = vrna_sc_add_SHAPE_zarringhalam(fc,
+                                             profile->reactivities,
+                                             profile->p1,
+                                             0.5,
+                                             (profile->shape_conversion) ?
+                                             profile->shape_conversion :
+                                             "O",
+                                             VRNA_OPTION_DEFAULT);
+        break;
+
+      case 'W':
+        values = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (fc->length + 1));
+        for (i = 1; i <= fc->length; i++)
+          values[i] = (FLT_OR_DBL)profile->reactivities[i];
+
+        ret = vrna_sc_set_up(fc, (const FLT_OR_DBL *)values, VRNA_OPTION_DEFAULT);
+        free(values);
+        break;
+
+      default:
+        vrna_message_warning("vrna_sc_SHAPE_fold_batch(): "
+                             "SHAPE method %c not recognized!",
+                             profile->method);
+        break;
+    }
+  }
+
+  return ret;
+}
+
+
+PRIVATE void
+SHAPE_profile_fold(vrna_fold_compound_t           *fc,
+                   const vrna_sc_SHAPE_profile_t  *profile,
+                   unsigned int                   options,
+                   vrna_sc_SHAPE_fold_t           *result)
+{
+  unsigned int  n;
+  double        mfe;
+
+  n = fc->length;
+
+  if (!SHAPE_profile_apply(fc, profile))
+    return;
+
+  /* the MFE is always required to scale the partition function */
+  vrna_sc_prepare(fc, options | VRNA_OPTION_MFE);
+
+  result->structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  result->mfe       = vrna_mfe(fc, result->structure);
+
+  if (options & VRNA_OPTION_PF) {
+    mfe = (double)result->mfe;
+    vrna_exp_params_rescale(fc, &mfe);
+
+    result->ensemble_energy = (double)vrna_pf(fc, NULL);
+
+    if ((fc->exp_params->model_details.compute_bpp) &&
+        (fc->exp_matrices->probs)) {
+      result->probs = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
+      memcpy(result->probs,
+             fc->exp_matrices->probs,
+             sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
+    }
+  }
+
+  result->status = 1;
+}
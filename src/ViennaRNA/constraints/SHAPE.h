@@ -169,4 +169,76 @@ vrna_sc_SHAPE_to_pr(const char  *shape_conversion,
                     double      default_value);
 
 
+/**
+ *  @brief  A SHAPE reactivity profile and the parameters of its conversion into soft constraints
+ *
+ *  @ingroup SHAPE_reactivities
+ *  @see  vrna_sc_SHAPE_fold_batch()
+ */
+typedef struct {
+  const double  *reactivities;      /**<  @brief  Normalized SHAPE reactivities (1-based) */
+  char          method;             /**<  @brief  Conversion method, i.e. 'D' (Deigan et al.), 'Z' (Zarringhalam et al.),
+                                     *            or 'W' (reactivities are pseudo energies for unpaired nucleotides)
+                                     */
+  double        p1;                 /**<  @brief  Slope @f$ m @f$ ('D') or scaling factor @f$ \beta @f$ ('Z') */
+  double        p2;                 /**<  @brief  Intercept @f$ b @f$ ('D') */
+  const char    *shape_conversion;  /**<  @brief  Conversion of reactivities into probabilities ('Z'), see vrna_sc_SHAPE_to_pr() */
+} vrna_sc_SHAPE_profile_t;
+
+
+/**
+ *  @brief  The results of folding a sequence under a single SHAPE reactivity profile
+ *
+ *  @ingroup SHAPE_reactivities
+ *  @see  vrna_sc_SHAPE_fold_batch(), vrna_sc_SHAPE_fold_batch_free()
+ */
+typedef struct {
+  int         status;           /**<  @brief  1 if the profile was folded successfully, 0 otherwise */
+  float       mfe;              /**<  @brief  The minimum free energy in kcal/mol */
+  char        *structure;       /**<  @brief  The MFE structure in dot-bracket notation */
+  double      ensemble_energy;  /**<  @brief  The ensemble free energy in kcal/mol (#VRNA_OPTION_PF only) */
+  FLT_OR_DBL  *probs;           /**<  @brief  The base pair probabilities in the layout of the @p probs array of
+                                 *            #vrna_mx_pf_t (#VRNA_OPTION_PF and @p compute_bpp only, @em NULL otherwise)
+                                 */
+} vrna_sc_SHAPE_fold_t;
+
+
+/**
+ *  @brief  Fold a sequence under many SHAPE reactivity profiles and conversion parameters
+ *
+ *  Each profile is converted into soft constraints as if it was applied with
+ *  vrna_sc_add_SHAPE_deigan(), vrna_sc_add_SHAPE_zarringhalam() or vrna_sc_set_up()
+ *  to a fold compound of its own. All profiles share the sequence encoding, pair
+ *  types and hard constraints of @p fc, but soft constraints already present in
+ *  @p fc are not applied. If OpenMP support is enabled, profiles are folded in
+ *  parallel. The partition function of each profile is scaled by its own MFE.
+ *
+ *  @ingroup SHAPE_reactivities
+ *  @see  vrna_sc_SHAPE_fold_batch_free()
+ *
+ *  @param  fc        A fold compound of type #VRNA_FC_TYPE_SINGLE
+ *  @param  profiles  The SHAPE reactivity profiles
+ *  @param  num       The number of profiles
+ *  @param  options   #VRNA_OPTION_MFE and/or #VRNA_OPTION_PF
+ *  @return           An array of @p num results in the order of @p profiles, or @em NULL on any error
+ */
+vrna_sc_SHAPE_fold_t *
+vrna_sc_SHAPE_fold_batch(vrna_fold_compound_t           *fc,
+                         const vrna_sc_SHAPE_profile_t  *profiles,
+                         unsigned int                   num,
+                         unsigned int                   options);
+
+
+/**
+ *  @brief  Release the memory occupied by the results of vrna_sc_SHAPE_fold_batch()
+ *
+ *  @ingroup SHAPE_reactivities
+ *  @param  results   The results
+ *  @param  num       The number of results
+ */
+void
+vrna_sc_SHAPE_fold_batch_free(vrna_sc_SHAPE_fold_t  *results,
+                              unsigned int          num);
+
+
 #endif
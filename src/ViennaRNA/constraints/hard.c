@@ -21,6 +21,7 @@
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/constraints/basic.h"
 #include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/dp_matrices.h"
 
 
 #ifdef __GNUC__
@@ -111,6 +112,48 @@ prepare_hc_bp(vrna_fold_compound_t  *fc,
               unsigned int          options);
 
 
+PRIVATE void
+hc_band_prepare(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+hc_far_free(vrna_hc_t *hc);
+
+
+PRIVATE INLINE unsigned char *
+hc_bp_ref(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          int           create);
+
+
+PRIVATE INLINE void
+hc_bp_set(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned int          j,
+          unsigned char         context);
+
+
+PRIVATE INLINE void
+hc_bp_and(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned int          j,
+          unsigned char         context);
+
+
+PRIVATE INLINE void
+hc_bp_or(vrna_fold_compound_t *fc,
+         unsigned int         i,
+         unsigned int         j,
+         unsigned char        context);
+
+
+PRIVATE INLINE void
+hc_up_set(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned char         context);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -161,11 +204,13 @@ vrna_hc_init(vrna_fold_compound_t *vc)
   vrna_hc_free(vc->hc);
 
   /* allocate memory new hard constraints data structure */
-  hc          = (vrna_hc_t *)vrna_alloc(sizeof(vrna_hc_t));
-  hc->type    = VRNA_HC_DEFAULT;
-  hc->n       = n;
-  hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (n + 1) + 1));
-  hc->up_ext  = (int *)vrna_alloc(sizeof(int) * (n + 2));
+  hc                = (vrna_hc_t *)vrna_alloc(sizeof(vrna_hc_t));
+  hc->type          = VRNA_HC_DEFAULT;
+  hc->n             = n;
+  hc->matrix_local  = NULL;
+  hc->span          = 0;
+  hc->far           = NULL;
+  hc->up_ext        = (int *)vrna_alloc(sizeof(int) * (n + 2));
   hc->up_hp   = (int *)vrna_alloc(sizeof(int) * (n + 2));
   hc->up_int  = (int *)vrna_alloc(sizeof(int) * (n + 2));
   hc->up_ml   = (int *)vrna_alloc(sizeof(int) * (n + 2));
@@ -185,6 +230,8 @@ vrna_hc_init(vrna_fold_compound_t *vc)
 
   /* update */
   hc_update_up(vc);
+
+  vrna_mx_invalidate(vc, n, 1);
 }
 
 
@@ -204,6 +251,8 @@ vrna_hc_init_window(vrna_fold_compound_t *vc)
   hc->type          = VRNA_HC_WINDOW;
   hc->n             = n;
   hc->matrix_local  = (unsigned char **)vrna_alloc(sizeof(unsigned char *) * (n + 2));
+  hc->span          = n + 1; /* each row covers the entire window */
+  hc->far           = NULL;
   hc->up_ext        = NULL;
   hc->up_hp         = NULL;
   hc->up_int        = NULL;
@@ -269,8 +318,10 @@ vrna_hc_prepare(vrna_fold_compound_t  *fc,
         vrna_hc_init_window(fc);
     } else {
       if (fc->hc->state & STATE_UNINITIALIZED) {
+        hc_band_prepare(fc);
         default_hc_up(fc, options);
         default_hc_bp(fc, options);
+        vrna_mx_invalidate(fc, fc->length, 1);
       }
 
       if (fc->hc->state & STATE_DIRTY_UP)
@@ -578,14 +629,30 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
 }
 
 
+PUBLIC unsigned char
+vrna_hc_context_far(const vrna_hc_t *hc,
+                    unsigned int    i,
+                    unsigned int    j)
+{
+  unsigned char *c;
+
+  /* without create, the lookup leaves the hard constraints untouched */
+  c = hc_bp_ref((vrna_hc_t *)hc, i, j, 0);
+
+  return (c) ? *c : VRNA_CONSTRAINT_CONTEXT_NONE;
+}
+
+
 PUBLIC void
 vrna_hc_free(vrna_hc_t *hc)
 {
   if (hc) {
-    if (hc->type == VRNA_HC_DEFAULT)
-      free(hc->mx);
-    else if (hc->type == VRNA_HC_WINDOW)
-      free(hc->matrix_local);
+    if ((hc->type == VRNA_HC_DEFAULT) &&
+        (hc->matrix_local))
+      free(hc->matrix_local[1]); /* all rows share a single memory block */
+
+    free(hc->matrix_local);
+    hc_far_free(hc);
 
     hc_depot_free(hc);
 
@@ -612,6 +679,7 @@ vrna_hc_add_f(vrna_fold_compound_t  *vc,
         vrna_hc_init(vc);
 
       vc->hc->f = f;
+      vrna_mx_invalidate(vc, vc->length, 1);
     }
   }
 }
@@ -629,6 +697,7 @@ vrna_hc_add_data(vrna_fold_compound_t *vc,
 
       vc->hc->data      = data;
       vc->hc->free_data = f;
+      vrna_mx_invalidate(vc, vc->length, 1);
     }
   }
 }
@@ -843,7 +912,7 @@ default_hc_up(vrna_fold_compound_t  *fc,
     n = fc->length;
 
     for (i = 1; i <= n; i++)
-      hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+      hc->matrix_local[i][0] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
   }
 }
 
@@ -882,29 +951,21 @@ prepare_hc_up(vrna_fold_compound_t  *fc,
 
             if (option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE) {
               /* only allow for possibly non-canonical pairs, do not enforce them */
-              for (j = 1; j < i; j++) {
-                hc->mx[n * i + j] |= t1;
-                hc->mx[n * j + i] |= t1;
-              }
-              for (j = i + 1; j <= n; j++) {
-                hc->mx[n * i + j] |= t2;
-                hc->mx[n * j + i] |= t2;
-              }
+              for (j = 1; j < i; j++)
+                hc_bp_or(fc, j, i, t1);
+              for (j = i + 1; j <= n; j++)
+                hc_bp_or(fc, i, j, t2);
             } else {
               /* force pairing direction */
-              for (j = 1; j < i; j++) {
-                hc->mx[n * i + j] &= t1;
-                hc->mx[n * j + i] &= t1;
-              }
-              for (j = i + 1; j <= n; j++) {
-                hc->mx[n * i + j] &= t2;
-                hc->mx[n * j + i] &= t2;
-              }
+              for (j = 1; j < i; j++)
+                hc_bp_and(fc, j, i, t1);
+              for (j = i + 1; j <= n; j++)
+                hc_bp_and(fc, i, j, t2);
             }
 
             /* nucleotide mustn't be unpaired */
             if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE)
-              hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+              hc_up_set(fc, i, VRNA_CONSTRAINT_CONTEXT_NONE);
           } else {
             /* 'regular' nucleotide-specific constraint */
             if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
@@ -913,35 +974,27 @@ prepare_hc_up(vrna_fold_compound_t  *fc,
                * do not allow i to be paired with any other nucleotide
                */
               if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-                for (j = 1; j < i; j++) {
-                  hc->mx[n * i + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                  hc->mx[n * j + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                }
-                for (j = i + 1; j <= n; j++) {
-                  hc->mx[n * i + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                  hc->mx[n * j + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                }
+                for (j = 1; j < i; j++)
+                  hc_bp_set(fc, j, i, VRNA_CONSTRAINT_CONTEXT_NONE);
+                for (j = i + 1; j <= n; j++)
+                  hc_bp_set(fc, i, j, VRNA_CONSTRAINT_CONTEXT_NONE);
               }
 
               type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
 
-              hc->mx[n * i + i] = type;
+              hc_up_set(fc, i, type);
             } else {
               type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
 
               /* do not allow i to be paired with any other nucleotide (in context type) */
               if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-                for (j = 1; j < i; j++) {
-                  hc->mx[n * i + j] &= ~type;
-                  hc->mx[n * j + i] &= ~type;
-                }
-                for (j = i + 1; j <= n; j++) {
-                  hc->mx[n * i + j] &= ~type;
-                  hc->mx[n * j + i] &= ~type;
-                }
+                for (j = 1; j < i; j++)
+                  hc_bp_and(fc, j, i, ~type);
+                for (j = i + 1; j <= n; j++)
+                  hc_bp_and(fc, i, j, ~type);
               }
 
-              hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+              hc_up_set(fc, i, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
             }
           }
         }
@@ -962,13 +1015,11 @@ default_hc_bp(vrna_fold_compound_t  *fc,
 
   if (options & VRNA_OPTION_WINDOW) {
   } else {
+    /* pairs outside the band are never allowed by default */
     n = fc->length;
-    for (j = n; j > 1; j--) {
-      for (i = 1; i < j; i++) {
-        hc->mx[n * i + j] = default_pair_constraint(fc, i, j);
-        hc->mx[n * j + i] = hc->mx[n * i + j];
-      }
-    }
+    for (i = 1; i < n; i++)
+      for (j = i + 1; (j <= n) && (j - i < hc->span); j++)
+        hc->matrix_local[j][j - i] = default_pair_constraint(fc, i, j);
   }
 }
 
@@ -1007,8 +1058,7 @@ prepare_hc_bp(vrna_fold_compound_t  *fc,
 
           if (i < j) {
             /* apply the constraint */
-            hc->mx[n * i + j] = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-            hc->mx[n * j + i] = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+            hc_bp_set(fc, i, j, option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
 
             /* is the ptype reset actually required??? */
             if ((fc->type == VRNA_FC_TYPE_SINGLE) &&
@@ -1024,39 +1074,29 @@ prepare_hc_bp(vrna_fold_compound_t  *fc,
                * with any other nucleotide k
                */
               for (p = 1; p < i; p++) {
-                hc->mx[n * i + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * j + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-                for (q = i + 1; q < j; q++) {
-                  hc->mx[n * p + q] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                  hc->mx[n * q + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                }
+                hc_bp_set(fc, p, i, VRNA_CONSTRAINT_CONTEXT_NONE);
+                hc_bp_set(fc, p, j, VRNA_CONSTRAINT_CONTEXT_NONE);
+
+                for (q = i + 1; q < j; q++)
+                  hc_bp_set(fc, p, q, VRNA_CONSTRAINT_CONTEXT_NONE);
               }
               for (p = i + 1; p < j; p++) {
-                hc->mx[n * i + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * j + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-                for (q = j + 1; q <= n; q++) {
-                  hc->mx[n * p + q] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                  hc->mx[n * q + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                }
+                hc_bp_set(fc, i, p, VRNA_CONSTRAINT_CONTEXT_NONE);
+                hc_bp_set(fc, p, j, VRNA_CONSTRAINT_CONTEXT_NONE);
+
+                for (q = j + 1; q <= n; q++)
+                  hc_bp_set(fc, p, q, VRNA_CONSTRAINT_CONTEXT_NONE);
               }
               for (p = j + 1; p <= n; p++) {
-                hc->mx[n * i + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * j + p] = VRNA_CONSTRAINT_CONTEXT_NONE;
-                hc->mx[n * p + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+                hc_bp_set(fc, i, p, VRNA_CONSTRAINT_CONTEXT_NONE);
+                hc_bp_set(fc, j, p, VRNA_CONSTRAINT_CONTEXT_NONE);
               }
             }
 
             if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
               /* do not allow i,j to be unpaired */
-              hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-              hc->mx[n * j + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+              hc_up_set(fc, i, VRNA_CONSTRAINT_CONTEXT_NONE);
+              hc_up_set(fc, j, VRNA_CONSTRAINT_CONTEXT_NONE);
             }
           }
         }
@@ -1815,6 +1855,8 @@ hc_reset_to_default(vrna_fold_compound_t *vc)
    * #########################
    */
 
+  hc_band_prepare(vc);
+
   default_hc_up(vc, 0);
 
   default_hc_bp(vc, 0);
@@ -1844,19 +1886,19 @@ hc_update_up(vrna_fold_compound_t *vc)
     /* do nothing for now! */
   } else {
     for (hc->up_ext[n + 1] = 0, i = n; i > 0; i--) /* unpaired stretch in exterior loop */
-      hc->up_ext[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) ? 1 +
+      hc->up_ext[i] = (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) ? 1 +
                       hc->up_ext[i + 1] : 0;
 
     for (hc->up_hp[n + 1] = 0, i = n; i > 0; i--)  /* unpaired stretch in hairpin loop */
-      hc->up_hp[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) ? 1 +
+      hc->up_hp[i] = (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) ? 1 +
                      hc->up_hp[i + 1] : 0;
 
     for (hc->up_int[n + 1] = 0, i = n; i > 0; i--) /* unpaired stretch in interior loop */
-      hc->up_int[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 +
+      hc->up_int[i] = (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 +
                       hc->up_int[i + 1] : 0;
 
     for (hc->up_ml[n + 1] = 0, i = n; i > 0; i--)  /* unpaired stretch in multibranch loop */
-      hc->up_ml[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) ? 1 +
+      hc->up_ml[i] = (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) ? 1 +
                      hc->up_ml[i + 1] : 0;
 
     /*
@@ -1865,40 +1907,40 @@ hc_update_up(vrna_fold_compound_t *vc)
      *  Note, circular fold is only possible for single strand predictions
      */
     if (vc->strands < 2) {
-      if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+      if (hc->matrix_local[1][0] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         hc->up_ext[n + 1] = hc->up_ext[1];
         for (i = n; i > 0; i--) {
-          if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)
+          if (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)
             hc->up_ext[i] = MIN2(n, 1 + hc->up_ext[i + 1]);
           else
             break;
         }
       }
 
-      if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
+      if (hc->matrix_local[1][0] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
         hc->up_hp[n + 1] = hc->up_hp[1];
         for (i = n; i > 0; i--) {
-          if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP)
+          if (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP)
             hc->up_hp[i] = MIN2(n, 1 + hc->up_hp[i + 1]);
           else
             break;
         }
       }
 
-      if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+      if (hc->matrix_local[1][0] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
         hc->up_int[n + 1] = hc->up_int[1];
         for (i = n; i > 0; i--) {
-          if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP)
+          if (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP)
             hc->up_int[i] = MIN2(n, 1 + hc->up_int[i + 1]);
           else
             break;
         }
       }
 
-      if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+      if (hc->matrix_local[1][0] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
         hc->up_ml[n + 1] = hc->up_ml[1];
         for (i = n; i > 0; i--) {
-          if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP)
+          if (hc->matrix_local[i][0] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP)
             hc->up_ml[i] = MIN2(n, 1 + hc->up_ml[i + 1]);
           else
             break;
@@ -1990,6 +2032,200 @@ hc_update_up_window(vrna_fold_compound_t  *vc,
 }
 
 
+/*
+ *  (Re-)allocate the banded pair context storage. Row j holds the contexts
+ *  of all (i, j) with j - i < span, where span is the maximum base pair span
+ *  of the current model. Indexing rows by the 3' nucleotide keeps the pairs
+ *  (k, l) of the innermost interior loop iterations, i.e. a fixed l and
+ *  consecutive k, in consecutive memory. Any pair beyond does not fit into
+ *  the band and, thus, needs to be listed in the sparse table hc->far.
+ */
+PRIVATE void
+hc_band_prepare(vrna_fold_compound_t *fc)
+{
+  unsigned char *block;
+  unsigned int  i, n, span;
+  size_t        size;
+  vrna_hc_t     *hc;
+  vrna_md_t     *md;
+
+  hc    = fc->hc;
+  n     = fc->length;
+  md    = (fc->params) ? &(fc->params->model_details) :
+          ((fc->exp_params) ? &(fc->exp_params->model_details) : NULL);
+  span  = ((md) && (md->max_bp_span > 0) && ((unsigned int)md->max_bp_span < n)) ?
+          (unsigned int)md->max_bp_span :
+          n;
+
+  hc_far_free(hc);
+
+  if ((hc->matrix_local) &&
+      (hc->span == span))
+    return;
+
+  if (hc->matrix_local)
+    free(hc->matrix_local[1]);
+
+  free(hc->matrix_local);
+
+  for (size = 0, i = 1; i <= n; i++)
+    size += MIN2(span, i);
+
+  block             = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (size + 1));
+  hc->matrix_local  = (unsigned char **)vrna_alloc(sizeof(unsigned char *) * (n + 2));
+  hc->span          = span;
+
+  for (i = 1; i <= n; i++) {
+    hc->matrix_local[i] = block;
+    block               += MIN2(span, i);
+  }
+}
+
+
+PRIVATE void
+hc_far_free(vrna_hc_t *hc)
+{
+  unsigned int i;
+
+  if (hc->far) {
+    for (i = 0; i <= hc->n; i++) {
+      free(hc->far[i].j);
+      free(hc->far[i].context);
+    }
+
+    free(hc->far);
+    hc->far = NULL;
+  }
+}
+
+
+/*
+ *  Return a pointer to the context of pair (i, j), i < j, or NULL if
+ *  the pair is neither within the band nor listed in the sparse table.
+ *  With create set, missing pairs are inserted into the sparse table.
+ */
+PRIVATE INLINE unsigned char *
+hc_bp_ref(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          int           create)
+{
+  unsigned int  k, lo, hi;
+  vrna_hc_far_t *row;
+
+  if (j - i < hc->span)
+    return hc->matrix_local[j] + (j - i);
+
+  if (!hc->far) {
+    if (!create)
+      return NULL;
+
+    hc->far = (vrna_hc_far_t *)vrna_alloc(sizeof(vrna_hc_far_t) * (hc->n + 1));
+  }
+
+  row = hc->far + i;
+  lo  = 0;
+  hi  = row->size;
+
+  while (lo < hi) {
+    k = (lo + hi) / 2;
+    if (row->j[k] < j)
+      lo = k + 1;
+    else
+      hi = k;
+  }
+
+  if ((lo < row->size) &&
+      (row->j[lo] == j))
+    return row->context + lo;
+
+  if (!create)
+    return NULL;
+
+  row->j        = (unsigned int *)vrna_realloc(row->j, sizeof(unsigned int) * (row->size + 1));
+  row->context  = (unsigned char *)vrna_realloc(row->context,
+                                                sizeof(unsigned char) * (row->size + 1));
+
+  for (k = row->size; k > lo; k--) {
+    row->j[k]       = row->j[k - 1];
+    row->context[k] = row->context[k - 1];
+  }
+
+  row->j[lo]        = j;
+  row->context[lo]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+  row->size++;
+
+  return row->context + lo;
+}
+
+
+/*
+ *  Changing the context of a pair (i, j) or a nucleotide i outdates all
+ *  DP matrix entries that enclose it, so every actual change is reported
+ *  to the DP matrices for incremental re-computation
+ */
+PRIVATE INLINE void
+hc_bp_set(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned int          j,
+          unsigned char         context)
+{
+  unsigned char *c = hc_bp_ref(fc->hc, i, j, context != VRNA_CONSTRAINT_CONTEXT_NONE);
+
+  if ((c) &&
+      (*c != context)) {
+    *c = context;
+    vrna_mx_invalidate(fc, i, j);
+  }
+}
+
+
+PRIVATE INLINE void
+hc_bp_and(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned int          j,
+          unsigned char         context)
+{
+  unsigned char *c = hc_bp_ref(fc->hc, i, j, 0);
+
+  if ((c) &&
+      ((*c & context) != *c)) {
+    *c &= context;
+    vrna_mx_invalidate(fc, i, j);
+  }
+}
+
+
+PRIVATE INLINE void
+hc_bp_or(vrna_fold_compound_t *fc,
+         unsigned int         i,
+         unsigned int         j,
+         unsigned char        context)
+{
+  unsigned char *c = hc_bp_ref(fc->hc, i, j, context != VRNA_CONSTRAINT_CONTEXT_NONE);
+
+  if ((c) &&
+      ((*c | context) != *c)) {
+    *c |= context;
+    vrna_mx_invalidate(fc, i, j);
+  }
+}
+
+
+PRIVATE INLINE void
+hc_up_set(vrna_fold_compound_t  *fc,
+          unsigned int          i,
+          unsigned char         context)
+{
+  vrna_hc_t *hc = fc->hc;
+
+  if (hc->matrix_local[i][0] != context) {
+    hc->matrix_local[i][0] = context;
+    vrna_mx_invalidate(fc, i, i);
+  }
+}
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /*
@@ -34,6 +34,12 @@ typedef struct vrna_hc_up_s vrna_hc_up_t;
 
 typedef struct vrna_hc_depot_s vrna_hc_depot_t;
 
+/**
+ *  @brief Typename for the sparse hard constraint row data structure #vrna_hc_far_s
+ *  @ingroup  hard_constraints
+ */
+typedef struct vrna_hc_far_s vrna_hc_far_t;
+
 #include <ViennaRNA/fold_compound.h>
 #include <ViennaRNA/constraints/basic.h>
 
@@ -369,21 +375,22 @@ struct vrna_hc_s {
 
   unsigned char   state;
 
-#ifndef VRNA_DISABLE_C11_FEATURES
-  /* C11 support for unnamed unions/structs */
-  union {
-    struct {
-#endif
-  unsigned char *mx;
-#ifndef VRNA_DISABLE_C11_FEATURES
-};
-struct {
-#endif
-  unsigned char **matrix_local;
-#ifndef VRNA_DISABLE_C11_FEATURES
-};
-};
-#endif
+  unsigned char   **matrix_local; /**<  @brief  The hard constraint contexts, where matrix_local[i][0]
+                                   *            holds the context of nucleotide i being unpaired
+                                   *
+                                   *    For #VRNA_HC_WINDOW, matrix_local[i][j - i] holds the
+                                   *    context of the base pair (i, j). For #VRNA_HC_DEFAULT,
+                                   *    matrix_local[j][j - i] does, and each row only stores
+                                   *    the first vrna_hc_s.span diagonals. Use vrna_hc_context()
+                                   *    to retrieve the context of any (i, j).
+                                   */
+  unsigned int    span;           /**<  @brief  The number of diagonals stored in each row of
+                                   *            vrna_hc_s.matrix_local
+                                   */
+  vrna_hc_far_t   *far;           /**<  @brief  Contexts of base pairs (i, j) with
+                                   *            @f$ j - i \geq span @f$, i.e. user-defined
+                                   *            constraints outside the band (may be NULL)
+                                   */
 
   int                 *up_ext;    /**<  @brief  A linear array that holds the number of allowed
                                    *            unpaired nucleotides in an exterior loop
@@ -421,6 +428,76 @@ struct {
   vrna_hc_depot_t *depot;
 };
 
+/**
+ *  @brief  Hard constraint contexts for base pairs that exceed the band of stored diagonals
+ *
+ *  One such list exists for each 5' nucleotide i. The 3' nucleotides @p j are
+ *  sorted in ascending order. Any base pair not listed is not allowed at all.
+ *
+ *  @ingroup hard_constraints
+ */
+struct vrna_hc_far_s {
+  unsigned int  size;     /**<  @brief  Number of entries in the list */
+  unsigned int  *j;       /**<  @brief  The 3' nucleotides of the base pairs (ascending) */
+  unsigned char *context; /**<  @brief  The corresponding hard constraint contexts */
+};
+
+/**
+ *  @brief  Get the hard constraint context of a base pair (i, j) that exceeds the band of stored diagonals
+ *
+ *  This is the slow path of vrna_hc_context() for pairs with @f$ j - i \geq span @f$,
+ *  which looks up the pair in the sparse table vrna_hc_s.far.
+ *
+ *  @ingroup hard_constraints
+ *
+ *  @param  hc  The hard constraints data structure
+ *  @param  i   The 5' nucleotide
+ *  @param  j   The 3' nucleotide (@f$ i < j @f$)
+ *  @return     The hard constraint context of (i, j)
+ */
+unsigned char
+vrna_hc_context_far(const vrna_hc_t *hc,
+                    unsigned int    i,
+                    unsigned int    j);
+
+
+/**
+ *  @brief  Get the hard constraint context of a base pair (i, j)
+ *
+ *  Returns the loop contexts the base pair (i, j) may appear in. For i = j,
+ *  the contexts nucleotide i may stay unpaired in are returned instead. The
+ *  order of @p i and @p j doesn't matter.
+ *
+ *  Only hard constraints of type #VRNA_HC_DEFAULT are supported. Sliding window
+ *  hard constraints are read from vrna_hc_s.matrix_local directly.
+ *
+ *  @ingroup hard_constraints
+ *
+ *  @param  hc  The hard constraints data structure
+ *  @param  i   The first nucleotide
+ *  @param  j   The second nucleotide
+ *  @return     The hard constraint context of (i, j)
+ */
+static inline unsigned char
+vrna_hc_context(const vrna_hc_t *hc,
+                unsigned int    i,
+                unsigned int    j)
+{
+  unsigned int m;
+
+  if (i > j) {
+    m = i;
+    i = j;
+    j = m;
+  }
+
+  if (j - i < hc->span)
+    return hc->matrix_local[j][j - i];
+
+  return vrna_hc_context_far(hc, i, j);
+}
+
+
 /**
  *  @brief  A single hard constraint for a single nucleotide
  *
@@ -22,6 +22,7 @@
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/constraints/SHAPE.h"
 #include "ViennaRNA/constraints/soft.h"
+#include "ViennaRNA/dp_matrices.h"
 
 
 #ifndef INLINE
@@ -127,6 +128,14 @@ populate_sc_up_pf(vrna_fold_compound_t  *fc,
                   unsigned int          n);
 
 
+PRIVATE INLINE void
+populate_sc_il_mfe(vrna_fold_compound_t *fc);
+
+
+PRIVATE INLINE void
+populate_sc_il_pf(vrna_fold_compound_t *fc);
+
+
 PRIVATE INLINE void
 sc_init_bp_storage(vrna_sc_t *sc);
 
@@ -324,12 +333,69 @@ vrna_sc_update(vrna_fold_compound_t *fc,
 }
 
 
+PUBLIC void
+vrna_sc_rescale_pf(vrna_fold_compound_t *fc)
+{
+  unsigned int  s;
+  vrna_sc_t     *sc;
+
+  if (fc) {
+    /* only recompute Boltzmann factors that have been requested before */
+    switch (fc->type) {
+      case VRNA_FC_TYPE_SINGLE:
+        sc = fc->sc;
+        if (!sc)
+          return;
+
+        if (sc->exp_energy_up) {
+          sc->state |= STATE_DIRTY_UP_PF;
+          prepare_sc_up_pf(fc, VRNA_OPTION_PF);
+        }
+
+        if (sc->exp_energy_bp) {
+          sc->state |= STATE_DIRTY_BP_PF;
+          prepare_sc_bp_pf(fc, VRNA_OPTION_PF);
+        }
+
+        if (sc->exp_energy_stack)
+          prepare_sc_stack_pf(fc);
+
+        break;
+
+      case VRNA_FC_TYPE_COMPARATIVE:
+        if (!fc->scs)
+          return;
+
+        for (s = 0; s < fc->n_seq; s++)
+          if ((fc->scs[s]) && (fc->scs[s]->exp_energy_stack))
+            break;
+
+        if (s < fc->n_seq)
+          prepare_sc_stack_pf(fc);
+
+        break;
+
+      default:
+        return;
+    }
+
+    (void)prepare_sc_user_cb(fc, VRNA_OPTION_PF);
+
+    vrna_mx_invalidate(fc, fc->length, 1);
+  }
+}
+
+
 PUBLIC void
 vrna_sc_remove(vrna_fold_compound_t *fc)
 {
   unsigned int s;
 
   if (fc) {
+    /* removing soft constraints only affects the matrices if there were any */
+    if ((fc->sc) || (fc->scs))
+      vrna_mx_invalidate(fc, fc->length, 1);
+
     switch (fc->type) {
       case  VRNA_FC_TYPE_SINGLE:
         vrna_sc_free(fc->sc);
@@ -493,6 +559,8 @@ vrna_sc_set_stack(vrna_fold_compound_t  *fc,
     for (i = 1; i <= fc->length; ++i)
       fc->sc->energy_stack[i] = (int)roundf(constraints[i] * 100.);
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -529,6 +597,8 @@ vrna_sc_set_stack_comparative(vrna_fold_compound_t  *fc,
       }
     }
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -561,6 +631,8 @@ vrna_sc_add_stack(vrna_fold_compound_t  *fc,
 
       fc->sc->energy_stack[i] += (int)roundf(energy * 100.);
 
+      vrna_mx_invalidate(fc, (unsigned int)i, (unsigned int)i);
+
       return 1;
     }
   }
@@ -598,6 +670,8 @@ vrna_sc_add_stack_comparative(vrna_fold_compound_t  *fc,
         fc->scs[s]->energy_stack[i] += (int)roundf(energies[s] * 100.);
       }
 
+      vrna_mx_invalidate(fc, (unsigned int)i, (unsigned int)i);
+
       return 1;
     }
   }
@@ -635,6 +709,8 @@ vrna_sc_add_auxdata(vrna_fold_compound_t    *fc,
     sc->free_data     = free_cb;
     sc->prepare_data  = prepare_cb;
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -668,6 +744,8 @@ vrna_sc_add_data_comparative(vrna_fold_compound_t *fc,
       for (s = 0; s < fc->n_seq; s++)
         fc->scs[s]->data = data[s];
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -686,6 +764,7 @@ vrna_sc_add_f(vrna_fold_compound_t  *fc,
       vrna_sc_init(fc);
 
     fc->sc->f = f;
+    vrna_mx_invalidate(fc, fc->length, 1);
     return 1;
   }
 
@@ -708,6 +787,8 @@ vrna_sc_add_f_comparative(vrna_fold_compound_t  *fc,
     for (s = 0; s < fc->n_seq; s++)
       fc->scs[s]->f = f[s];
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -744,6 +825,7 @@ vrna_sc_add_exp_f(vrna_fold_compound_t  *fc,
       vrna_sc_init(fc);
 
     fc->sc->exp_f = exp_f;
+    vrna_mx_invalidate(fc, fc->length, 1);
     return 1;
   }
 
@@ -766,6 +848,8 @@ vrna_sc_add_exp_f_comparative(vrna_fold_compound_t  *fc,
     for (s = 0; s < fc->n_seq; s++)
       fc->scs[s]->exp_f = exp_f[s];
 
+    vrna_mx_invalidate(fc, fc->length, 1);
+
     return 1;
   }
 
@@ -823,6 +907,53 @@ populate_sc_up_pf(vrna_fold_compound_t  *fc,
 }
 
 
+/*
+ *  compile sc->energy_up into flat tables of the unpaired stretches 5' and 3'
+ *  of interior loop inner pairs, such that the interior loop recursions can
+ *  look them up by the closing pair and the stretch length only
+ */
+PRIVATE INLINE void
+populate_sc_il_mfe(vrna_fold_compound_t *fc)
+{
+  unsigned int  i, u, n, w;
+  int           *e5, *e3;
+  vrna_sc_t     *sc = fc->sc;
+
+  n   = fc->length;
+  w   = MAXLOOP + 1;
+  e5  = sc->energy_il5 = (int *)vrna_realloc(sc->energy_il5, sizeof(int) * w * (n + 2));
+  e3  = sc->energy_il3 = (int *)vrna_realloc(sc->energy_il3, sizeof(int) * w * (n + 2));
+
+  for (i = 0; i <= n + 1; i++, e5 += w, e3 += w)
+    for (u = 0; u < w; u++) {
+      e5[u] = ((u > 0) && (i + u <= n)) ? sc->energy_up[i + 1][u] : 0;
+      e3[u] = ((u > 0) && (u < i)) ? sc->energy_up[i - u][u] : 0;
+    }
+}
+
+
+PRIVATE INLINE void
+populate_sc_il_pf(vrna_fold_compound_t *fc)
+{
+  unsigned int  i, u, n, w;
+  FLT_OR_DBL    *q5, *q3;
+  vrna_sc_t     *sc = fc->sc;
+
+  n   = fc->length;
+  w   = MAXLOOP + 1;
+  q5  = sc->exp_energy_il5 = (FLT_OR_DBL *)vrna_realloc(sc->exp_energy_il5,
+                                                         sizeof(FLT_OR_DBL) * w * (n + 2));
+  q3  = sc->exp_energy_il3 = (FLT_OR_DBL *)vrna_realloc(sc->exp_energy_il3,
+                                                         sizeof(FLT_OR_DBL) * w * (n + 2));
+
+  for (i = 0; i <= n + 1; i++, q5 += w, q3 += w)
+    for (u = 0; u < w; u++) {
+      q5[u] = ((u > 0) && (i + u <= n)) ? sc->exp_energy_up[i + 1][u] : 1.;
+      q3[u] = ((u > 0) && (u < i)) ? sc->exp_energy_up[i - u][u] : 1.;
+    }
+}
+
+
 PRIVATE INLINE void
 sc_init_bp_storage(vrna_sc_t *sc)
 {
@@ -1031,6 +1162,8 @@ sc_add_bp(vrna_fold_compound_t  *fc,
   sc_init_bp_storage(sc);
   sc_store_bp(sc->bp_storage, i, j, j, (int)roundf(energy * 100.));
   sc->state |= STATE_DIRTY_BP_MFE | STATE_DIRTY_BP_PF;
+
+  vrna_mx_invalidate(fc, i, j);
 }
 
 
@@ -1059,6 +1192,15 @@ free_sc_up(vrna_sc_t *sc)
   free(sc->exp_energy_up);
   sc->exp_energy_up = NULL;
 
+  free(sc->energy_il5);
+  free(sc->energy_il3);
+  free(sc->exp_energy_il5);
+  free(sc->exp_energy_il3);
+  sc->energy_il5      = NULL;
+  sc->energy_il3      = NULL;
+  sc->exp_energy_il5  = NULL;
+  sc->exp_energy_il3  = NULL;
+
   sc->state &= ~(STATE_DIRTY_UP_MFE | STATE_DIRTY_UP_PF);
 }
 
@@ -1131,6 +1273,8 @@ sc_reset_up(vrna_fold_compound_t  *fc,
   } else {
     free_sc_up(sc);
   }
+
+  vrna_mx_invalidate(fc, n, 1);
 }
 
 
@@ -1168,6 +1312,8 @@ sc_reset_bp(vrna_fold_compound_t  *fc,
   } else {
     free_sc_bp(sc);
   }
+
+  vrna_mx_invalidate(fc, n, 1);
 }
 
 
@@ -1188,6 +1334,8 @@ sc_add_up(vrna_fold_compound_t  *fc,
   sc_init_up_storage(sc);
   sc->up_storage[i] += (int)roundf(energy * 100.);
   sc->state         |= STATE_DIRTY_UP_MFE | STATE_DIRTY_UP_PF;
+
+  vrna_mx_invalidate(fc, i, i);
 }
 
 
@@ -1234,6 +1382,8 @@ prepare_sc_up_mfe(vrna_fold_compound_t  *fc,
 
               sc->energy_up[0][0]     = 0;
               sc->energy_up[n + 1][0] = 0;
+
+              populate_sc_il_mfe(fc);
             }
 
             sc->state &= ~STATE_DIRTY_UP_MFE;
@@ -1299,6 +1449,8 @@ prepare_sc_up_pf(vrna_fold_compound_t *fc,
 
               sc->exp_energy_up[0][0]     = 1.;
               sc->exp_energy_up[n + 1][0] = 1.;
+
+              populate_sc_il_pf(fc);
             }
 
             sc->state &= ~STATE_DIRTY_UP_PF;
@@ -1523,6 +1675,10 @@ nullify(vrna_sc_t *sc)
     sc->energy_stack      = NULL;
     sc->exp_energy_stack  = NULL;
     sc->exp_energy_up     = NULL;
+    sc->energy_il5        = NULL;
+    sc->energy_il3        = NULL;
+    sc->exp_energy_il5    = NULL;
+    sc->exp_energy_il3    = NULL;
 
     sc->f             = NULL;
     sc->exp_f         = NULL;
@@ -240,6 +240,11 @@ struct {
   int           *energy_stack;                    /**<  @brief Pseudo Energy contribution per base pair involved in a stack */
   FLT_OR_DBL    *exp_energy_stack;                /**<  @brief Boltzmann weighted pseudo energy contribution per nucleotide involved in a stack */
 
+  int           *energy_il5;        /**<  @brief Flat table of energy contributions for unpaired stretches @f$ [i + 1, i + u] @f$ 5' of an interior loop's inner pair, stored at @f$ i \cdot (MAXLOOP + 1) + u @f$ */
+  int           *energy_il3;        /**<  @brief Flat table of energy contributions for unpaired stretches @f$ [j - u, j - 1] @f$ 3' of an interior loop's inner pair, stored at @f$ j \cdot (MAXLOOP + 1) + u @f$ */
+  FLT_OR_DBL    *exp_energy_il5;    /**<  @brief Boltzmann factors of the contributions in #vrna_sc_s.energy_il5 */
+  FLT_OR_DBL    *exp_energy_il3;    /**<  @brief Boltzmann factors of the contributions in #vrna_sc_s.energy_il3 */
+
   /* generic soft contraints below */
   vrna_sc_f     f;            /**<  @brief  A function pointer used for pseudo
                                *            energy contribution in MFE calculations
@@ -299,6 +304,22 @@ vrna_sc_update(vrna_fold_compound_t *fc,
                unsigned int         options);
 
 
+/**
+ *  @brief  Recompute the Boltzmann factors of soft constraints for the current energy parameters
+ *
+ *  The Boltzmann factors of soft constraints depend on the temperature of the
+ *  energy parameters in place when they were computed. Call this function after
+ *  changing the temperature, e.g. with vrna_params_reset(), to update them. Only
+ *  Boltzmann factors that have been computed before are updated.
+ *
+ *  @ingroup  soft_constraints
+ *
+ *  @param  fc  The #vrna_fold_compound_t the soft constraints are associated with
+ */
+void
+vrna_sc_rescale_pf(vrna_fold_compound_t *fc);
+
+
 /**
  *  @brief  Set soft constraints for paired nucleotides
  *
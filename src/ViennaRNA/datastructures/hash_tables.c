@@ -5,6 +5,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/datastructures/hash_tables.h"
@@ -22,6 +23,25 @@ struct vrna_hash_table_s {
 };
 
 
+/* slot of the packed structure set, index is 0 for empty slots */
+struct ht_pt_slot {
+  uint32_t  hash;
+  uint32_t  index;
+};
+
+
+struct vrna_ht_pt_s {
+  unsigned int      length;
+  unsigned int      options;
+  unsigned int      words;      /* number of 64bit words per packed structure */
+  unsigned long     size;       /* number of slots, always a power of 2 */
+  unsigned long     num;        /* number of stored structures */
+  struct ht_pt_slot *slots;
+  uint64_t          *keys;      /* packed structures, in order of their indices */
+  unsigned long     keys_size;  /* number of structures that fit into keys */
+};
+
+
 typedef struct vrna_hash_entry_list_s {
   unsigned long length;
   unsigned long allocated_length;
@@ -406,3 +426,333 @@ vrna_ht_db_free_entry(void *hash_entry)
   free(((vrna_ht_entry_db_t *)hash_entry)->structure);
   return 0;
 }
+
+
+/* ----------------------------------------------------------------- */
+
+#define HT_PT_INIT_SIZE   1024
+#define HT_PT_BUF_WORDS   64      /* structures up to 2048 nt are packed on the stack */
+#define HT_PT_MAX_LOAD    0.5
+
+
+PRIVATE unsigned int
+ht_pt_words(unsigned int  length,
+            unsigned int  options)
+{
+  if (options & VRNA_HT_PT_PK)
+    return length / 4 + 1;      /* 16 bits per position */
+
+  return (length + 31) / 32;    /* 2 bits per position */
+}
+
+
+/* mix 64bit words of a packed structure (murmur3 finalizer) */
+PRIVATE uint32_t
+ht_pt_hash(const uint64_t *key,
+           unsigned int   words)
+{
+  unsigned int  i;
+  uint64_t      h;
+
+  h = (uint64_t)words * 0x9e3779b97f4a7c15ULL;
+  for (i = 0; i < words; i++) {
+    h ^= key[i];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+  }
+
+  return (uint32_t)h;
+}
+
+
+/*
+ *  Pack pair table pt into the words of key. Returns 0 on success and -1
+ *  if the structure can not be encoded, i.e. if its length doesn't match
+ *  or it contains crossing pairs although VRNA_HT_PT_PK is not set.
+ */
+PRIVATE int
+ht_pt_pack(struct vrna_ht_pt_s  *ht,
+           const short          *pt,
+           uint64_t             *key)
+{
+  unsigned int  i, n, top, buf[HT_PT_BUF_WORDS * 32], *stack;
+  int           ret;
+  uint64_t      c;
+
+  n = ht->length;
+
+  if ((!pt) ||
+      (pt[0] != (short)n))
+    return -1;
+
+  memset(key, 0, sizeof(uint64_t) * ht->words);
+
+  if (ht->options & VRNA_HT_PT_PK) {
+    for (i = 1; i <= n; i++)
+      key[i >> 2] |= (uint64_t)(unsigned short)pt[i] << (16 * (i & 3));
+
+    return 0;
+  }
+
+  /* '.' -> 0, '(' -> 1, ')' -> 2, positions of open pairs are kept on a stack */
+  stack = (n <= HT_PT_BUF_WORDS * 32) ? buf : (unsigned int *)vrna_alloc(sizeof(unsigned int) * n);
+  ret   = 0;
+
+  for (top = 0, i = 1; i <= n; i++) {
+    if (pt[i] == 0)
+      continue;
+
+    if (pt[i] > (short)i) {
+      stack[top++]  = i;
+      c             = 1;
+    } else if ((top > 0) &&
+               (stack[top - 1] == (unsigned int)pt[i])) {
+      top--;
+      c = 2;
+    } else {
+      ret = -1;
+      break;
+    }
+
+    key[(i - 1) >> 5] |= c << (2 * ((i - 1) & 31));
+  }
+
+  if (stack != buf)
+    free(stack);
+
+  return ret;
+}
+
+
+PRIVATE short *
+ht_pt_unpack(struct vrna_ht_pt_s  *ht,
+             const uint64_t       *key)
+{
+  unsigned int  i, n, top, *stack;
+  short         *pt;
+
+  n       = ht->length;
+  pt      = (short *)vrna_alloc(sizeof(short) * (n + 2));
+  pt[0]   = (short)n;
+
+  if (ht->options & VRNA_HT_PT_PK) {
+    for (i = 1; i <= n; i++)
+      pt[i] = (short)((key[i >> 2] >> (16 * (i & 3))) & 0xFFFFU);
+
+    return pt;
+  }
+
+  stack = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n + 1));
+
+  for (top = 0, i = 1; i <= n; i++) {
+    switch ((key[(i - 1) >> 5] >> (2 * ((i - 1) & 31))) & 3U) {
+      case 1:
+        stack[top++] = i;
+        break;
+
+      case 2:
+        top--;
+        pt[i]           = (short)stack[top];
+        pt[stack[top]]  = (short)i;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  free(stack);
+
+  return pt;
+}
+
+
+/* find the slot holding key, or the empty slot where it would be inserted */
+PRIVATE struct ht_pt_slot *
+ht_pt_find(struct vrna_ht_pt_s  *ht,
+           const uint64_t       *key,
+           uint32_t             hash)
+{
+  unsigned long     p, mask;
+  struct ht_pt_slot *s;
+
+  mask = ht->size - 1;
+
+  for (p = hash & mask; ; p = (p + 1) & mask) {
+    s = ht->slots + p;
+    if (s->index == 0)
+      return s;
+
+    if ((s->hash == hash) &&
+        (memcmp(ht->keys + (unsigned long)(s->index - 1) * ht->words,
+                key,
+                sizeof(uint64_t) * ht->words) == 0))
+      return s;
+  }
+}
+
+
+PRIVATE void
+ht_pt_resize(struct vrna_ht_pt_s  *ht,
+             unsigned long        size)
+{
+  unsigned long     i, p;
+  struct ht_pt_slot *old;
+
+  old       = ht->slots;
+  ht->slots = (struct ht_pt_slot *)vrna_alloc(sizeof(struct ht_pt_slot) * size);
+
+  /* re-insert all entries, no key comparisons required */
+  for (i = 0; i < ht->size; i++) {
+    if (old[i].index == 0)
+      continue;
+
+    for (p = old[i].hash & (size - 1); ht->slots[p].index != 0; p = (p + 1) & (size - 1));
+    ht->slots[p] = old[i];
+  }
+
+  ht->size = size;
+  free(old);
+}
+
+
+PUBLIC struct vrna_ht_pt_s *
+vrna_ht_pt_init(unsigned int  length,
+                unsigned int  options)
+{
+  struct vrna_ht_pt_s *ht = NULL;
+
+  if ((length > 0) &&
+      (length < 32768)) {
+    ht = (struct vrna_ht_pt_s *)vrna_alloc(sizeof(struct vrna_ht_pt_s));
+
+    ht->length    = length;
+    ht->options   = options;
+    ht->words     = ht_pt_words(length, options);
+    ht->size      = HT_PT_INIT_SIZE;
+    ht->num       = 0;
+    ht->slots     = (struct ht_pt_slot *)vrna_alloc(sizeof(struct ht_pt_slot) * ht->size);
+    ht->keys_size = HT_PT_INIT_SIZE / 2;
+    ht->keys      = (uint64_t *)vrna_alloc(sizeof(uint64_t) * ht->words * ht->keys_size);
+  }
+
+  return ht;
+}
+
+
+PUBLIC unsigned long
+vrna_ht_pt_num(struct vrna_ht_pt_s *ht)
+{
+  if (ht)
+    return ht->num;
+
+  return 0L;
+}
+
+
+PUBLIC long
+vrna_ht_pt_get(struct vrna_ht_pt_s  *ht,
+               const short          *pt)
+{
+  long              ret;
+  uint64_t          buf[HT_PT_BUF_WORDS], *key;
+  struct ht_pt_slot *s;
+
+  ret = -1;
+
+  if (ht) {
+    key = (ht->words <= HT_PT_BUF_WORDS) ? buf : (uint64_t *)vrna_alloc(sizeof(uint64_t) * ht->words);
+
+    if (ht_pt_pack(ht, pt, key) == 0) {
+      s = ht_pt_find(ht, key, ht_pt_hash(key, ht->words));
+      if (s->index != 0)
+        ret = (long)s->index - 1;
+    }
+
+    if (key != buf)
+      free(key);
+  }
+
+  return ret;
+}
+
+
+PUBLIC long
+vrna_ht_pt_insert(struct vrna_ht_pt_s *ht,
+                  const short         *pt)
+{
+  long              ret;
+  uint32_t          hash;
+  uint64_t          buf[HT_PT_BUF_WORDS], *key;
+  struct ht_pt_slot *s;
+
+  ret = -1;
+
+  if ((ht) &&
+      (ht->num < UINT32_MAX - 1)) {
+    key = (ht->words <= HT_PT_BUF_WORDS) ? buf : (uint64_t *)vrna_alloc(sizeof(uint64_t) * ht->words);
+
+    if (ht_pt_pack(ht, pt, key) == 0) {
+      if (ht->num + 1 > HT_PT_MAX_LOAD * ht->size)
+        ht_pt_resize(ht, 2 * ht->size);
+
+      hash  = ht_pt_hash(key, ht->words);
+      s     = ht_pt_find(ht, key, hash);
+
+      if (s->index == 0) {
+        if (ht->num == ht->keys_size) {
+          ht->keys_size *= 2;
+          ht->keys      = (uint64_t *)vrna_realloc(ht->keys,
+                                                   sizeof(uint64_t) * ht->words * ht->keys_size);
+        }
+
+        memcpy(ht->keys + ht->num * ht->words, key, sizeof(uint64_t) * ht->words);
+        s->hash   = hash;
+        s->index  = (uint32_t)++ht->num;
+      }
+
+      ret = (long)s->index - 1;
+    }
+
+    if (key != buf)
+      free(key);
+  }
+
+  return ret;
+}
+
+
+PUBLIC short *
+vrna_ht_pt_ptable(struct vrna_ht_pt_s *ht,
+                  unsigned long       i)
+{
+  if ((ht) &&
+      (i < ht->num))
+    return ht_pt_unpack(ht, ht->keys + i * ht->words);
+
+  return NULL;
+}
+
+
+PUBLIC void
+vrna_ht_pt_clear(struct vrna_ht_pt_s *ht)
+{
+  if (ht) {
+    memset(ht->slots, 0, sizeof(struct ht_pt_slot) * ht->size);
+    ht->num = 0;
+  }
+}
+
+
+PUBLIC void
+vrna_ht_pt_free(struct vrna_ht_pt_s *ht)
+{
+  if (ht) {
+    free(ht->slots);
+    free(ht->keys);
+    free(ht);
+  }
+}
@@ -302,6 +302,124 @@ int vrna_ht_db_free_entry(void *hash_entry);
 /* End of dot-bracket interface */
 /**@}*/
 
+/**
+ *  @name Packed secondary structure sets
+ *  @{
+ */
+
+/**
+ *  @brief  A set of secondary structures stored in packed form
+ *
+ *  In contrast to the abstract hash table, this set stores copies of
+ *  the structures in a compact encoding within a single, contiguous
+ *  memory block. Look-ups use open addressing with linear probing on a
+ *  flat array of slots, such that no memory is allocated per entry.
+ *  Each structure is identified by a unique index, where structures
+ *  receive consecutive indices in the order they are inserted, starting
+ *  at 0. This allows for storing any additional data in simple arrays.
+ *
+ *  @see  vrna_ht_pt_init(), vrna_ht_pt_insert(), vrna_ht_pt_get(), vrna_ht_pt_free()
+ */
+typedef struct vrna_ht_pt_s *vrna_ht_pt_t;
+
+
+/**
+ *  @brief  Option flag for vrna_ht_pt_init() to store pair tables with crossing base pairs
+ *
+ *  By default, structures are encoded with 2 bits per nucleotide, i.e. in
+ *  the same way as their dot-bracket string. This, however, requires that
+ *  all structures are free of pseudo-knots. With this flag, the pair table
+ *  itself is stored instead, such that arbitrary base pairs are allowed.
+ */
+#define VRNA_HT_PT_PK   1U
+
+
+/**
+ *  @brief  Get an initialized set of packed structures
+ *
+ *  @see  vrna_ht_pt_free(), #VRNA_HT_PT_PK
+ *
+ *  @param  length  The length of the structures
+ *  @param  options Options, i.e. 0 or #VRNA_HT_PT_PK
+ *  @return         An empty set of structures, or @p NULL on any error
+ */
+vrna_ht_pt_t
+vrna_ht_pt_init(unsigned int  length,
+                unsigned int  options);
+
+
+/**
+ *  @brief  Get the number of structures stored in the set
+ *
+ *  @param  ht  The set of structures
+ *  @return     The number of structures stored in @p ht
+ */
+unsigned long
+vrna_ht_pt_num(vrna_ht_pt_t ht);
+
+
+/**
+ *  @brief  Look-up the index of a structure
+ *
+ *  @param  ht  The set of structures
+ *  @param  pt  The structure in pair table format
+ *  @return     The index of @p pt, or -1 if @p pt is not in the set
+ */
+long
+vrna_ht_pt_get(vrna_ht_pt_t ht,
+               const short  *pt);
+
+
+/**
+ *  @brief  Insert a structure into the set
+ *
+ *  If the structure is not yet stored in @p ht, it is inserted and
+ *  receives the next free index, i.e. the number of structures in the
+ *  set prior to insertion.
+ *
+ *  @param  ht  The set of structures
+ *  @param  pt  The structure in pair table format
+ *  @return     The index of @p pt, or -1 on any error, e.g. a length
+ *              mismatch or crossing base pairs without #VRNA_HT_PT_PK
+ */
+long
+vrna_ht_pt_insert(vrna_ht_pt_t  ht,
+                  const short   *pt);
+
+
+/**
+ *  @brief  Get a structure from the set
+ *
+ *  @param  ht  The set of structures
+ *  @param  i   The index of the structure
+ *  @return     A newly allocated pair table of structure @p i, or @p NULL if @p i is out of range
+ */
+short *
+vrna_ht_pt_ptable(vrna_ht_pt_t  ht,
+                  unsigned long i);
+
+
+/**
+ *  @brief  Remove all structures from the set
+ *
+ *  @param  ht  The set of structures
+ */
+void
+vrna_ht_pt_clear(vrna_ht_pt_t ht);
+
+
+/**
+ *  @brief  Free all memory occupied by the set
+ *
+ *  @param  ht  The set of structures
+ */
+void
+vrna_ht_pt_free(vrna_ht_pt_t ht);
+
+
+/* End of packed structures interface */
+/**@}*/
+
 /**
  *  @}
  */
@@ -54,6 +54,10 @@
 #define ALLOC_PF_WO_PROBS         (ALLOC_F | ALLOC_C | ALLOC_FML)
 #define ALLOC_PF_DEFAULT          (ALLOC_PF_WO_PROBS | ALLOC_PROBS | ALLOC_AUX)
 
+/* default chunk size and alignment of the memory pools for distance class matrices */
+#define POOL_CHUNK_SIZE           (1 << 20)
+#define POOL_ALIGN                16
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -66,6 +70,14 @@
  #################################
  */
 
+struct vrna_mx_pool_s {
+  size_t  chunk_size;
+  char    *top;       /* next free byte within the current chunk */
+  size_t  avail;      /* number of free bytes left in the current chunk */
+  void    **chunks;
+  size_t  num_chunks;
+};
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -100,8 +112,7 @@ mfe_matrices_free_window(vrna_mx_mfe_t  *self,
 PRIVATE void
 mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
                          unsigned int   length,
-                         int            min_loop_size,
-                         int            *indx);
+                         int            turn);
 
 
 PRIVATE void
@@ -117,9 +128,7 @@ pf_matrices_free_window(vrna_mx_pf_t  *self,
 PRIVATE void
 pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
                         unsigned int  length,
-                        int           turn,
-                        int           *indx,
-                        int           *jindx);
+                        int           turn);
 
 
 PRIVATE int
@@ -195,8 +204,7 @@ vrna_mx_mfe_free(vrna_fold_compound_t *vc)
         case VRNA_MX_2DFOLD:
           mfe_matrices_free_2Dfold(self,
                                    vc->length,
-                                   vc->params->model_details.min_loop_size,
-                                   vc->iindx);
+                                   vc->params->model_details.min_loop_size);
           break;
 
         default:                /* do nothing */
@@ -227,9 +235,7 @@ vrna_mx_pf_free(vrna_fold_compound_t *vc)
         case VRNA_MX_2DFOLD:
           pf_matrices_free_2Dfold(self,
                                   vc->length,
-                                  vc->exp_params->model_details.min_loop_size,
-                                  vc->iindx,
-                                  vc->jindx);
+                                  vc->exp_params->model_details.min_loop_size);
           break;
 
         default:                /* do nothing */
@@ -272,7 +278,9 @@ vrna_mx_mfe_add(vrna_fold_compound_t  *vc,
                 vrna_mx_type_e        mx_type,
                 unsigned int          options)
 {
-  unsigned int mx_alloc_vector;
+  unsigned char incremental;
+  unsigned int  mx_alloc_vector;
+  int           ret;
 
   if (vc->params) {
     options |= VRNA_OPTION_MFE;
@@ -280,8 +288,15 @@ vrna_mx_mfe_add(vrna_fold_compound_t  *vc,
     mx_alloc_vector = get_mx_alloc_vector(vc,
                                           mx_type,
                                           options);
+    incremental = (vc->matrices) ? vc->matrices->incremental : 0;
     vrna_mx_mfe_free(vc);
-    return add_mfe_matrices(vc, mx_type, mx_alloc_vector);
+    ret = add_mfe_matrices(vc, mx_type, mx_alloc_vector);
+
+    /* keep the incremental mode across re-allocations */
+    if ((ret) && (vc->matrices))
+      vc->matrices->incremental = incremental;
+
+    return ret;
   }
 
   return 0;
@@ -293,14 +308,23 @@ vrna_mx_pf_add(vrna_fold_compound_t *vc,
                vrna_mx_type_e       mx_type,
                unsigned int         options)
 {
-  unsigned int mx_alloc_vector;
+  unsigned char incremental;
+  unsigned int  mx_alloc_vector;
+  int           ret;
 
   if (vc->exp_params) {
     mx_alloc_vector = get_mx_alloc_vector(vc,
                                           mx_type,
                                           options | VRNA_OPTION_PF);
+    incremental = (vc->exp_matrices) ? vc->exp_matrices->incremental : 0;
     vrna_mx_pf_free(vc);
-    return add_pf_matrices(vc, mx_type, mx_alloc_vector);
+    ret = add_pf_matrices(vc, mx_type, mx_alloc_vector);
+
+    /* keep the incremental mode across re-allocations */
+    if ((ret) && (vc->exp_matrices))
+      vc->exp_matrices->incremental = incremental;
+
+    return ret;
   }
 
   return 0;
@@ -392,6 +416,154 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
 }
 
 
+PUBLIC int
+vrna_mx_incremental(vrna_fold_compound_t  *fc,
+                    unsigned int          options,
+                    int                   on)
+{
+  int ret = 0;
+
+  if ((fc) &&
+      (options & (VRNA_OPTION_MFE | VRNA_OPTION_PF)) &&
+      (!(options & VRNA_OPTION_WINDOW))) {
+    if (!vrna_mx_prepare(fc, options))
+      return ret;
+
+    /*
+     *  do not trust the matrix contents from a time when the incremental mode was off,
+     *  i.e. the first fill after switching it on always covers the entire matrices
+     */
+    if ((options & VRNA_OPTION_MFE) &&
+        (fc->matrices) &&
+        (fc->matrices->type == VRNA_MX_DEFAULT)) {
+      if ((on) && (!fc->matrices->incremental)) {
+        fc->matrices->dirty_i = fc->matrices->length;
+        fc->matrices->dirty_j = 1;
+      }
+
+      fc->matrices->incremental = (on) ? 1 : 0;
+      ret                       = 1;
+    }
+
+    if ((options & VRNA_OPTION_PF) &&
+        (fc->exp_matrices) &&
+        (fc->exp_matrices->type == VRNA_MX_DEFAULT)) {
+      if ((on) && (!fc->exp_matrices->incremental)) {
+        fc->exp_matrices->dirty_i = fc->exp_matrices->length;
+        fc->exp_matrices->dirty_j = 1;
+      }
+
+      fc->exp_matrices->incremental = (on) ? 1 : 0;
+      ret                           = 1;
+    }
+  }
+
+  return ret;
+}
+
+
+PUBLIC void
+vrna_mx_invalidate(vrna_fold_compound_t *fc,
+                   unsigned int         i,
+                   unsigned int         j)
+{
+  vrna_mx_mfe_t *mx;
+  vrna_mx_pf_t  *exp_mx;
+
+  if (fc) {
+    mx      = fc->matrices;
+    exp_mx  = fc->exp_matrices;
+
+    if ((mx) &&
+        (mx->type == VRNA_MX_DEFAULT)) {
+      mx->dirty_i = MAX2(mx->dirty_i, i);
+      mx->dirty_j = MIN2(mx->dirty_j, j);
+    }
+
+    if ((exp_mx) &&
+        (exp_mx->type == VRNA_MX_DEFAULT)) {
+      exp_mx->dirty_i = MAX2(exp_mx->dirty_i, i);
+      exp_mx->dirty_j = MIN2(exp_mx->dirty_j, j);
+    }
+  }
+}
+
+
+PUBLIC vrna_mx_pool_t *
+vrna_mx_pool_init(size_t chunk_size)
+{
+  vrna_mx_pool_t *pool;
+
+  pool              = (vrna_mx_pool_t *)vrna_alloc(sizeof(vrna_mx_pool_t));
+  pool->chunk_size  = (chunk_size > 0) ? chunk_size : POOL_CHUNK_SIZE;
+  pool->top         = NULL;
+  pool->avail       = 0;
+  pool->chunks      = NULL;
+  pool->num_chunks  = 0;
+
+  return pool;
+}
+
+
+PUBLIC void *
+vrna_mx_pool_alloc(vrna_mx_pool_t *pool,
+                   size_t         size)
+{
+  char *block;
+
+  if ((!pool) ||
+      (size == 0))
+    return NULL;
+
+  /* round up to keep subsequent blocks aligned */
+  size = (size + POOL_ALIGN - 1) & ~((size_t)POOL_ALIGN - 1);
+
+#ifdef _OPENMP
+#pragma omp critical (vrna_mx_pool)
+#endif
+  {
+    if (size > pool->avail) {
+      pool->chunks = (void **)vrna_realloc(pool->chunks,
+                                           sizeof(void *) * (pool->num_chunks + 1));
+
+      if (size > pool->chunk_size / 4) {
+        /* large blocks get a chunk of their own, the current chunk remains in use */
+        block = (char *)vrna_alloc(size);
+        pool->chunks[pool->num_chunks++] = block;
+      } else {
+        pool->top                         = (char *)vrna_alloc(pool->chunk_size);
+        pool->avail                       = pool->chunk_size;
+        pool->chunks[pool->num_chunks++]  = pool->top;
+        block                             = pool->top;
+        pool->top                         += size;
+        pool->avail                       -= size;
+      }
+    } else {
+      block       = pool->top;
+      pool->top   += size;
+      pool->avail -= size;
+    }
+  }
+
+  return (void *)block;
+}
+
+
+PUBLIC void
+vrna_mx_pool_free(vrna_mx_pool_t *pool)
+{
+  size_t i;
+
+  if (pool) {
+    for (i = 0; i < pool->num_chunks; i++)
+      free(pool->chunks[i]);
+
+    free(pool->chunks);
+    free(pool);
+  }
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
@@ -665,12 +837,16 @@ mfe_matrices_free_window(vrna_mx_mfe_t  *self,
 PRIVATE void
 mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
                          unsigned int   length,
-                         int            turn,
-                         int            *indx)
+                         int            turn)
 {
-  unsigned int  i, j, ij;
+  unsigned int  i;
   int           cnt1;
 
+#ifdef COUNT_STATES
+  unsigned int  j, ij;
+  int           *indx = vrna_idx_row_wise(length);
+#endif
+
   /* This will be some fun... */
 #ifdef COUNT_STATES
   if (self->N_F5 != NULL) {
@@ -774,28 +950,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
 #endif
 
   if (self->E_C != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->E_C[ij])
-          continue;
-
-        for (cnt1 = self->k_min_C[ij]; cnt1 <= self->k_max_C[ij]; cnt1++)
-          if (self->l_min_C[ij][cnt1] < INF) {
-            self->E_C[ij][cnt1] += self->l_min_C[ij][cnt1] / 2;
-            free(self->E_C[ij][cnt1]);
-          }
-
-        if (self->k_min_C[ij] < INF) {
-          self->E_C[ij] += self->k_min_C[ij];
-          free(self->E_C[ij]);
-          self->l_min_C[ij] += self->k_min_C[ij];
-          self->l_max_C[ij] += self->k_min_C[ij];
-          free(self->l_min_C[ij]);
-          free(self->l_max_C[ij]);
-        }
-      }
-    }
     free(self->E_C);
     free(self->l_min_C);
     free(self->l_max_C);
@@ -829,28 +983,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
 #endif
 
   if (self->E_M != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->E_M[ij])
-          continue;
-
-        for (cnt1 = self->k_min_M[ij]; cnt1 <= self->k_max_M[ij]; cnt1++)
-          if (self->l_min_M[ij][cnt1] < INF) {
-            self->E_M[ij][cnt1] += self->l_min_M[ij][cnt1] / 2;
-            free(self->E_M[ij][cnt1]);
-          }
-
-        if (self->k_min_M[ij] < INF) {
-          self->E_M[ij] += self->k_min_M[ij];
-          free(self->E_M[ij]);
-          self->l_min_M[ij] += self->k_min_M[ij];
-          self->l_max_M[ij] += self->k_min_M[ij];
-          free(self->l_min_M[ij]);
-          free(self->l_max_M[ij]);
-        }
-      }
-    }
     free(self->E_M);
     free(self->l_min_M);
     free(self->l_max_M);
@@ -884,28 +1016,6 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
 #endif
 
   if (self->E_M1 != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->E_M1[ij])
-          continue;
-
-        for (cnt1 = self->k_min_M1[ij]; cnt1 <= self->k_max_M1[ij]; cnt1++)
-          if (self->l_min_M1[ij][cnt1] < INF) {
-            self->E_M1[ij][cnt1] += self->l_min_M1[ij][cnt1] / 2;
-            free(self->E_M1[ij][cnt1]);
-          }
-
-        if (self->k_min_M1[ij] < INF) {
-          self->E_M1[ij] += self->k_min_M1[ij];
-          free(self->E_M1[ij]);
-          self->l_min_M1[ij]  += self->k_min_M1[ij];
-          self->l_max_M1[ij]  += self->k_min_M1[ij];
-          free(self->l_min_M1[ij]);
-          free(self->l_max_M1[ij]);
-        }
-      }
-    }
     free(self->E_M1);
     free(self->l_min_M1);
     free(self->l_max_M1);
@@ -1014,6 +1124,13 @@ mfe_matrices_free_2Dfold(vrna_mx_mfe_t  *self,
   free(self->E_M_rem);
   free(self->E_M1_rem);
   free(self->E_M2_rem);
+
+  /* the per-cell arrays of E_C, E_M, and E_M1 are released with the pool */
+  vrna_mx_pool_free(self->pool);
+
+#ifdef COUNT_STATES
+  free(indx);
+#endif
 }
 
 
@@ -1026,7 +1143,7 @@ pf_matrices_free_default(vrna_mx_pf_t *self)
   free(self->qm1);
   free(self->qm2);
   free(self->probs);
-  free(self->G);
+  vrna_gquad_index_free(self->G);
   free(self->q1k);
   free(self->qln);
 }
@@ -1052,38 +1169,13 @@ pf_matrices_free_window(vrna_mx_pf_t  *self,
 PRIVATE void
 pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
                         unsigned int  length,
-                        int           turn,
-                        int           *indx,
-                        int           *jindx)
+                        int           turn)
 {
-  unsigned int  i, j, ij;
+  unsigned int  i;
   int           cnt1;
 
-  /* This will be some fun... */
-  if (self->Q != NULL) {
-    for (i = 1; i <= length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->Q[ij])
-          continue;
-
-        for (cnt1 = self->k_min_Q[ij]; cnt1 <= self->k_max_Q[ij]; cnt1++)
-          if (self->l_min_Q[ij][cnt1] < INF) {
-            self->Q[ij][cnt1] += self->l_min_Q[ij][cnt1] / 2;
-            free(self->Q[ij][cnt1]);
-          }
-
-        if (self->k_min_Q[ij] < INF) {
-          self->Q[ij] += self->k_min_Q[ij];
-          free(self->Q[ij]);
-          self->l_min_Q[ij] += self->k_min_Q[ij];
-          self->l_max_Q[ij] += self->k_min_Q[ij];
-          free(self->l_min_Q[ij]);
-          free(self->l_max_Q[ij]);
-        }
-      }
-    }
-  }
+  /* the per-cell arrays of Q, Q_B, Q_M, and Q_M1 are released with the pool */
+  vrna_mx_pool_free(self->pool);
 
   free(self->Q);
   free(self->l_min_Q);
@@ -1091,93 +1183,18 @@ pf_matrices_free_2Dfold(vrna_mx_pf_t  *self,
   free(self->k_min_Q);
   free(self->k_max_Q);
 
-  if (self->Q_B != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->Q_B[ij])
-          continue;
-
-        for (cnt1 = self->k_min_Q_B[ij]; cnt1 <= self->k_max_Q_B[ij]; cnt1++)
-          if (self->l_min_Q_B[ij][cnt1] < INF) {
-            self->Q_B[ij][cnt1] += self->l_min_Q_B[ij][cnt1] / 2;
-            free(self->Q_B[ij][cnt1]);
-          }
-
-        if (self->k_min_Q_B[ij] < INF) {
-          self->Q_B[ij] += self->k_min_Q_B[ij];
-          free(self->Q_B[ij]);
-          self->l_min_Q_B[ij] += self->k_min_Q_B[ij];
-          self->l_max_Q_B[ij] += self->k_min_Q_B[ij];
-          free(self->l_min_Q_B[ij]);
-          free(self->l_max_Q_B[ij]);
-        }
-      }
-    }
-  }
-
   free(self->Q_B);
   free(self->l_min_Q_B);
   free(self->l_max_Q_B);
   free(self->k_min_Q_B);
   free(self->k_max_Q_B);
 
-  if (self->Q_M != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = indx[i] - j;
-        if (!self->Q_M[ij])
-          continue;
-
-        for (cnt1 = self->k_min_Q_M[ij]; cnt1 <= self->k_max_Q_M[ij]; cnt1++)
-          if (self->l_min_Q_M[ij][cnt1] < INF) {
-            self->Q_M[ij][cnt1] += self->l_min_Q_M[ij][cnt1] / 2;
-            free(self->Q_M[ij][cnt1]);
-          }
-
-        if (self->k_min_Q_M[ij] < INF) {
-          self->Q_M[ij] += self->k_min_Q_M[ij];
-          free(self->Q_M[ij]);
-          self->l_min_Q_M[ij] += self->k_min_Q_M[ij];
-          self->l_max_Q_M[ij] += self->k_min_Q_M[ij];
-          free(self->l_min_Q_M[ij]);
-          free(self->l_max_Q_M[ij]);
-        }
-      }
-    }
-  }
-
   free(self->Q_M);
   free(self->l_min_Q_M);
   free(self->l_max_Q_M);
   free(self->k_min_Q_M);
   free(self->k_max_Q_M);
 
-  if (self->Q_M1 != NULL) {
-    for (i = 1; i < length; i++) {
-      for (j = i; j <= length; j++) {
-        ij = jindx[j] + i;
-        if (!self->Q_M1[ij])
-          continue;
-
-        for (cnt1 = self->k_min_Q_M1[ij]; cnt1 <= self->k_max_Q_M1[ij]; cnt1++)
-          if (self->l_min_Q_M1[ij][cnt1] < INF) {
-            self->Q_M1[ij][cnt1] += self->l_min_Q_M1[ij][cnt1] / 2;
-            free(self->Q_M1[ij][cnt1]);
-          }
-
-        if (self->k_min_Q_M1[ij] < INF) {
-          self->Q_M1[ij] += self->k_min_Q_M1[ij];
-          free(self->Q_M1[ij]);
-          self->l_min_Q_M1[ij]  += self->k_min_Q_M1[ij];
-          self->l_max_Q_M1[ij]  += self->k_min_Q_M1[ij];
-          free(self->l_min_Q_M1[ij]);
-          free(self->l_max_Q_M1[ij]);
-        }
-      }
-    }
-  }
-
   free(self->Q_M1);
   free(self->l_min_Q_M1);
   free(self->l_max_Q_M1);
@@ -1318,6 +1335,8 @@ init_mx_mfe_default(vrna_fold_compound_t  *fc,
     lin_size    = n + 2;
     mx->length  = n;
     mx->strands = strands;
+    mx->dirty_i = n;  /* nothing has been computed yet */
+    mx->dirty_j = 1;
 
     if (alloc_vector & ALLOC_F5)
       mx->f5 = (int *)vrna_alloc(sizeof(int) * lin_size);
@@ -1498,6 +1517,8 @@ init_mx_mfe_2Dfold(vrna_fold_compound_t *fc,
     mx->N_M   = (unsigned long ***)vrna_alloc(sizeof(unsigned long **) * size);
     mx->N_M1  = (unsigned long ***)vrna_alloc(sizeof(unsigned long **) * size);
 #endif
+
+    mx->pool = vrna_mx_pool_init(0);
   }
 
   return mx;
@@ -1613,6 +1634,8 @@ nullify_mfe(vrna_mx_mfe_t *mx)
         mx->N_M1  = NULL;
 #endif
 
+        mx->pool = NULL;
+
         break;
     }
   }
@@ -1647,6 +1670,8 @@ init_mx_pf_default(vrna_fold_compound_t *fc,
     size        = ((n + 1) * (n + 2)) / 2;
     lin_size    = n + 2;
     mx->length  = n;
+    mx->dirty_i = n;  /* nothing has been computed yet */
+    mx->dirty_j = 1;
 
     if (alloc_vector & ALLOC_F)
       mx->q = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
@@ -1822,6 +1847,8 @@ init_mx_pf_2Dfold(vrna_fold_compound_t  *fc,
      */
     mx->scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * lin_size);
     mx->expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * lin_size);
+
+    mx->pool = vrna_mx_pool_init(0);
   }
 
   return mx;
@@ -1924,6 +1951,8 @@ nullify_pf(vrna_mx_pf_t *mx)
         mx->k_max_Q_cM  = 0;
         mx->Q_cM_rem    = 0.;
 
+        mx->pool = NULL;
+
         break;
     }
   }
@@ -20,6 +20,10 @@
 typedef struct  vrna_mx_mfe_s vrna_mx_mfe_t;
 /** @brief Typename for the Partition Function (PF) DP matrices data structure #vrna_mx_pf_s */
 typedef struct  vrna_mx_pf_s vrna_mx_pf_t;
+/** @brief Typename for the sparse G-quadruplex index data structure #vrna_gquad_index_s */
+typedef struct  vrna_gquad_index_s vrna_gquad_index_t;
+/** @brief Typename for the memory pool of distance class DP matrices #vrna_mx_pool_s */
+typedef struct  vrna_mx_pool_s vrna_mx_pool_t;
 
 #include <ViennaRNA/datastructures/basic.h>
 #include <ViennaRNA/fold_compound.h>
@@ -199,6 +203,19 @@ struct {
 };
 };
 #endif
+
+  /** @name Incremental fills and matrix pool
+   *  @{
+   */
+  unsigned char         incremental;  /**<  @brief  Whether or not to reuse up-to-date entries in subsequent fills, see vrna_mx_incremental() */
+  unsigned int          dirty_i;  /**<  @brief  Outdated entries @f$ (i,j) @f$ satisfy @f$ i \leq @f$ dirty_i */
+  unsigned int          dirty_j;  /**<  @brief  Outdated entries @f$ (i,j) @f$ satisfy @f$ j \geq @f$ dirty_j */
+  const vrna_param_t    *params;  /**<  @brief  The energy parameters the matrices have been filled with */
+  int                   params_id;  /**<  @brief  The identifier of these energy parameters */
+  vrna_mx_pool_t  *pool;  /**<  @brief  Storage of the per-cell arrays of E_C, E_M, and E_M1 */
+  /**
+   *  @}
+   */
 };
 
 /**
@@ -235,7 +252,7 @@ struct vrna_mx_pf_s {
   FLT_OR_DBL *probs;
   FLT_OR_DBL *q1k;
   FLT_OR_DBL *qln;
-  FLT_OR_DBL *G;
+  vrna_gquad_index_t *G;  /**<  @brief  Sparse G-quadruplex Boltzmann weights, see vrna_gquad_pf_index() */
 
   FLT_OR_DBL qo;
   FLT_OR_DBL *qm2;
@@ -348,6 +365,7 @@ struct {
   FLT_OR_DBL Q_cH_rem;
   FLT_OR_DBL Q_cI_rem;
   FLT_OR_DBL Q_cM_rem;
+
   /**
    *  @}
    */
@@ -357,6 +375,19 @@ struct {
 };
 };
 #endif
+
+  /** @name Incremental fills and matrix pool
+   *  @{
+   */
+  unsigned char         incremental;  /**<  @brief  Whether or not to reuse up-to-date entries in subsequent fills, see vrna_mx_incremental() */
+  unsigned int          dirty_i;    /**<  @brief  Outdated entries @f$ (i,j) @f$ satisfy @f$ i \leq @f$ dirty_i */
+  unsigned int          dirty_j;    /**<  @brief  Outdated entries @f$ (i,j) @f$ satisfy @f$ j \geq @f$ dirty_j */
+  const vrna_exp_param_t *params;  /**<  @brief  The Boltzmann factors the matrices have been filled with */
+  int                   params_id;  /**<  @brief  The identifier of these Boltzmann factors */
+  vrna_mx_pool_t *pool; /**<  @brief  Storage of the per-cell arrays of Q, Q_B, Q_M, and Q_M1 */
+  /**
+   *  @}
+   */
 };
 
 /**
@@ -433,6 +464,101 @@ void
 vrna_mx_pf_free(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Switch incremental re-computation of the default DP matrices on or off
+ *
+ *  In incremental mode, vrna_mfe() and vrna_pf() only recompute those matrix
+ *  entries @f$ (i,j) @f$ whose subsegment encloses a change made since the
+ *  previous fill, and reuse all other entries. Changes of hard and soft
+ *  constraints applied through the constraints API, as well as replaced energy
+ *  parameters and Boltzmann factor scaling, are tracked automatically, no matter
+ *  whether the parameters are replaced through the API or by assigning another
+ *  set to @p fc directly. Any other modification that affects the energy
+ *  evaluation, e.g. changing the current parameter set in place, must be
+ *  announced by vrna_mx_invalidate().
+ *
+ *  Computations that the incremental mode does not support, i.e. multiple
+ *  strands, the lonely pair restriction, unstructured domains, and auxiliary
+ *  grammar extensions, silently fall back to a full fill.
+ *
+ *  @see  vrna_mx_invalidate(), vrna_mfe(), vrna_pf()
+ *
+ *  @param  fc      The #vrna_fold_compound_t holding the DP matrices
+ *  @param  options Any of #VRNA_OPTION_MFE and #VRNA_OPTION_PF to select the matrices
+ *  @param  on      Non-zero to switch the incremental mode on, 0 to switch it off
+ *  @returns        1 on success, 0 otherwise
+ */
+int
+vrna_mx_incremental(vrna_fold_compound_t  *fc,
+                    unsigned int          options,
+                    int                   on);
+
+
+/**
+ *  @brief  Mark all DP matrix entries enclosing the interval @f$ [i,j] @f$ as outdated
+ *
+ *  Entries @f$ (k,l) @f$ with @f$ k \leq i @f$ and @f$ l \geq j @f$ of the default MFE
+ *  and partition function matrices will be recomputed by the next incremental
+ *  fill. Use @f$ i = n @f$ and @f$ j = 1 @f$ to invalidate the entire matrices.
+ *
+ *  @see  vrna_mx_incremental()
+ *
+ *  @param  fc  The #vrna_fold_compound_t holding the DP matrices
+ *  @param  i   The 5' end of the changed interval
+ *  @param  j   The 3' end of the changed interval
+ */
+void
+vrna_mx_invalidate(vrna_fold_compound_t *fc,
+                   unsigned int         i,
+                   unsigned int         j);
+
+
+/**
+ *  @brief  Create a memory pool for the per-cell arrays of distance class DP matrices
+ *
+ *  The distance class (2D) DP matrices store a small two-dimensional array for
+ *  each pair @f$ (i,j) @f$. The pool hands out these arrays from large chunks of
+ *  memory instead of individually allocated rows, and releases all of them at
+ *  once in vrna_mx_pool_free().
+ *
+ *  @see  vrna_mx_pool_alloc(), vrna_mx_pool_free()
+ *
+ *  @param  chunk_size  The size of the memory chunks in bytes, or 0 for the default
+ *  @returns            A new memory pool
+ */
+vrna_mx_pool_t *
+vrna_mx_pool_init(size_t chunk_size);
+
+
+/**
+ *  @brief  Allocate a block of memory from a pool
+ *
+ *  The block is suitably aligned for pointers and floating point numbers but,
+ *  other than with vrna_alloc(), not initialized. It is valid until the pool
+ *  is released. The function may be called concurrently from multiple threads.
+ *
+ *  @see  vrna_mx_pool_init(), vrna_mx_pool_free()
+ *
+ *  @param  pool  The memory pool
+ *  @param  size  The size of the block in bytes
+ *  @returns      A pointer to the memory block
+ */
+void *
+vrna_mx_pool_alloc(vrna_mx_pool_t *pool,
+                   size_t         size);
+
+
+/**
+ *  @brief  Release a memory pool and all blocks allocated from it
+ *
+ *  @see  vrna_mx_pool_init()
+ *
+ *  @param  pool  The memory pool
+ */
+void
+vrna_mx_pool_free(vrna_mx_pool_t *pool);
+
+
 /**
  *  @}
  */
@@ -641,11 +641,12 @@ PRIVATE int
 pf_create_bppm(vrna_fold_compound_t *vc,
                char                 *structure)
 {
-  unsigned int      s;
+  unsigned          int      s;
   int               n, i, j, l, ij, *pscore, *jindx, ov = 0;
   FLT_OR_DBL        Qmax = 0;
-  FLT_OR_DBL        *qb, *G, *probs;
+  FLT_OR_DBL        *qb, *probs;
   FLT_OR_DBL        *q1k, *qln;
+  vrna_gquad_index_t*G;
 
   int               with_gquad;
   vrna_hc_t         *hc;
@@ -835,7 +836,7 @@ pf_create_bppm(vrna_fold_compound_t *vc,
             /*  search for possible auxiliary base pairs in hairpin loop motifs to store
              *  the corresponding probability corrections
              */
-            if (hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
+            if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
               vrna_basepair_t *ptr, *aux_bps;
               aux_bps = sc->bt(i, j, i, j, VRNA_DECOMP_PAIR_HP, sc->data);
               if (aux_bps) {
@@ -876,9 +877,9 @@ pf_create_bppm(vrna_fold_compound_t *vc,
             probs[ij] *= qb[ij];
             if (vc->type == VRNA_FC_TYPE_COMPARATIVE)
               probs[ij] *= exp(-pscore[jindx[j] + i] / kTn);
-          } else if (G[ij] > 0.) {
+          } else if (vrna_gquad_index_weight(G, i, j) > 0.) {
             probs[ij] += q1k[i - 1] *
-                         G[ij] *
+                         vrna_gquad_index_weight(G, i, j) *
                          qln[j + 1] /
                          q1k[n];
           }
@@ -1261,7 +1262,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
     if (qb[kl] == 0.)
       continue;
 
-    if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+    if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
       type_2 = rtype[vrna_get_ptype(jindx[l] + k, ptype)];
 
       for (i = MAX2(1, k - MAXLOOP - 1); i <= k - 1; i++) {
@@ -1426,7 +1427,7 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
     if (qb[kl] == 0.)
       continue;
 
-    if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+    if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
       psc_exp = exp(pscore[jindx[l] + k] / kTn);
 
       for (s = 0; s < n_seq; s++)
@@ -1511,9 +1512,10 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
   unsigned int              *sn;
   int                       cnt, i, j, k, n, u, ii, ij, kl, lj, *my_iindx, *jindx,
                             *rtype, with_gquad, with_ud;
-  FLT_OR_DBL                temp, ppp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *G, *scale,
+  FLT_OR_DBL                temp, ppp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *scale,
                             *expMLbase, expMLclosing, expMLstem;
   double                    max_real;
+  vrna_gquad_index_t        *G;
   vrna_exp_param_t          *pf_params;
   vrna_md_t                 *md;
   vrna_ud_t                 *domains_up;
@@ -1695,7 +1697,7 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
 
       if (with_gquad) {
         if ((!tt) &&
-            (G[kl] == 0.))
+            (vrna_gquad_index_weight(G, k, l) == 0.))
           continue;
       } else {
         if (qb[kl] == 0.)
@@ -1722,7 +1724,7 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
 
       if ((with_gquad) &&
           (qb[kl] == 0.)) {
-        temp *= G[kl] *
+        temp *= vrna_gquad_index_weight(G, k, l) *
                 expMLstem;
       } else if (hc_eval(k, l, k, l, VRNA_DECOMP_ML_STEM, hc_dat)) {
         if (tt == 0)
@@ -1766,13 +1768,14 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
                                     int                   *ov,
                                     constraints_helper    *constraints)
 {
-  unsigned char     tt;
+  unsigned          char     tt;
   short             **S, **S5, **S3;
-  unsigned int      **a2s, s, n_seq, *sn;
+  unsigned          int      **a2s, s, n_seq, *sn;
   int               i, j, k, n, ii, kl, ij, lj, *my_iindx, *jindx, *pscore, with_gquad;
-  FLT_OR_DBL        temp, ppp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *G, *scale,
+  FLT_OR_DBL        temp, ppp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *scale,
                     *expMLbase, expMLclosing, expMLstem;
   double            max_real, kTn;
+  vrna_gquad_index_t*G;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
   vrna_hc_t         *hc;
@@ -1822,7 +1825,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
       if (sn[k] == sn[i]) {
         for (j = l + 2; j <= n; j++, ij--, lj--) {
-          if ((hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (sn[j] == sn[j - 1])) {
             /* which decomposition is covered here? =>
              * i + 1 = k < l < j:
@@ -1859,7 +1862,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
         ii = my_iindx[i];   /* ii-j=[i,j]     */
 
-        if (hc->mx[(l + 1) * n + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+        if (vrna_hc_context(hc, l + 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
           prmt1 = probs[ii - (l + 1)] *
                   (FLT_OR_DBL)pow(expMLclosing, (double)n_seq);
 
@@ -1944,7 +1947,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
       if (with_gquad) {
         if ((qb[kl] == 0.) &&
-            (G[kl] == 0.))
+            (vrna_gquad_index_weight(G, k, l) == 0.))
           continue;
       } else {
         if (qb[kl] == 0.)
@@ -1962,10 +1965,10 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
 
       if ((with_gquad) &&
           (qb[kl] == 0.)) {
-        temp *= G[kl] *
+        temp *= vrna_gquad_index_weight(G, k, l) *
                 expMLstem;
       } else {
-        if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+        if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
           for (s = 0; s < n_seq; s++) {
             tt    = vrna_get_ptype_md(S[s][k], S[s][l], md);
             temp  *= exp_E_MLstem(tt, S5[s][k], S3[s][l], pf_params);
@@ -2002,11 +2005,12 @@ PRIVATE void
 compute_gquad_prob_internal(vrna_fold_compound_t  *fc,
                             int                   l)
 {
-  unsigned char     type;
+  unsigned          char     type;
   char              *ptype;
   short             *S1;
   int               i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx;
-  FLT_OR_DBL        tmp2, qe, *G, *probs, *scale;
+  FLT_OR_DBL        tmp2, qe, qg, *probs, *scale;
+  vrna_gquad_index_t*G;
   vrna_exp_param_t  *pf_params;
 
   n         = (int)fc->length;
@@ -2019,13 +2023,17 @@ compute_gquad_prob_internal(vrna_fold_compound_t  *fc,
   probs     = fc->exp_matrices->probs;
   scale     = fc->exp_matrices->scale;
 
-  /* 2.5. bonding k,l as gquad enclosed by i,j */
+  /* 2.5. bonding k,l as gquad enclosed by i,j, where k is at most
+   *      VRNA_GQUAD_MAX_BOX_SIZE - 1 nucleotides upstream of l */
   double *expintern = &(pf_params->expinternal[0]);
 
   if (l < n - 3) {
-    for (k = 2; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(2, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2  = 0.;
@@ -2044,14 +2052,17 @@ compute_gquad_prob_internal(vrna_fold_compound_t  *fc,
                  pf_params->expmismatchI[type][S1[i + 1]][S1[j - 1]] *
                  scale[u1 + 2];
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 
   if (l < n - 1) {
-    for (k = 3; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(3, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2 = 0.;
@@ -2072,14 +2083,17 @@ compute_gquad_prob_internal(vrna_fold_compound_t  *fc,
                    scale[u1 + u2 + 2];
         }
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 
   if (l < n) {
-    for (k = 4; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(4, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2  = 0.;
@@ -2098,7 +2112,7 @@ compute_gquad_prob_internal(vrna_fold_compound_t  *fc,
                  pf_params->expmismatchI[type][S1[i + 1]][S1[j - 1]] *
                  scale[u2 + 2];
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 }
@@ -2108,11 +2122,12 @@ PRIVATE void
 compute_gquad_prob_internal_comparative(vrna_fold_compound_t  *fc,
                                         int                   l)
 {
-  unsigned char     type;
+  unsigned          char     type;
   short             **S, **S5, **S3;
-  unsigned int      **a2s, s, n_seq;
+  unsigned          int      **a2s, s, n_seq;
   int               i, j, k, n, ij, kl, u1, u2, u1_local, u2_local, *my_iindx;
-  FLT_OR_DBL        tmp2, qe, *G, *qb, *probs, *scale;
+  FLT_OR_DBL        tmp2, qe, qg, *qb, *probs, *scale;
+  vrna_gquad_index_t*G;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
 
@@ -2130,13 +2145,17 @@ compute_gquad_prob_internal_comparative(vrna_fold_compound_t  *fc,
   scale     = fc->exp_matrices->scale;
   md        = &(pf_params->model_details);
 
-  /* 2.5. bonding k,l as gquad enclosed by i,j */
+  /* 2.5. bonding k,l as gquad enclosed by i,j, where k is at most
+   *      VRNA_GQUAD_MAX_BOX_SIZE - 1 nucleotides upstream of l */
   double *expintern = &(pf_params->expinternal[0]);
 
   if (l < n - 3) {
-    for (k = 2; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(2, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2  = 0.;
@@ -2165,14 +2184,17 @@ compute_gquad_prob_internal_comparative(vrna_fold_compound_t  *fc,
                 qe *
                 scale[u1 + 2];
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 
   if (l < n - 1) {
-    for (k = 3; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(3, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2 = 0.;
@@ -2204,14 +2226,17 @@ compute_gquad_prob_internal_comparative(vrna_fold_compound_t  *fc,
                   scale[u1 + u2 + 2];
         }
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 
   if (l < n) {
-    for (k = 4; k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1; k++) {
+    for (k = MAX2(4, l - VRNA_GQUAD_MAX_BOX_SIZE + 1);
+         k <= l - VRNA_GQUAD_MIN_BOX_SIZE + 1;
+         k++) {
       kl = my_iindx[k] - l;
-      if (G[kl] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       tmp2  = 0.;
@@ -2240,7 +2265,7 @@ compute_gquad_prob_internal_comparative(vrna_fold_compound_t  *fc,
                 qe *
                 scale[u2 + 2];
       }
-      probs[kl] += tmp2 * G[kl];
+      probs[kl] += tmp2 * qg;
     }
   }
 }
@@ -2952,19 +2977,19 @@ ud_outside_int_loops(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_int_loops2(vrna_fold_compound_t *vc)
 {
-  unsigned char *hard_constraints;
   int           i, j, k, l, p, q, pq, kl, u, n, *my_iindx, pmax, qmin,
                 u1, u2, uu1, uu2, u2_max, m;
   FLT_OR_DBL    temp, q5, q3, exp_motif_en, outside,
                 *probs, *qb, qq1, qq2, *qqk, *qql, *qqp, **qq_ud, **pp_ud, temp5,
                 temp3;
+  vrna_hc_t     *hc;
   vrna_ud_t     *domains_up, *ud_bak;
 
   n                 = vc->length;
   my_iindx          = vc->iindx;
   qb                = vc->exp_matrices->qb;
   probs             = vc->exp_matrices->probs;
-  hard_constraints  = vc->hc->mx;
+  hc                = vc->hc;
   domains_up        = vc->domains_up;
 
   qqk = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
@@ -3000,7 +3025,7 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
       if (probs[kl] == 0.)
         continue;
 
-      if (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+      if (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
         for (i = l - 1; i > MAX2(k, l - MAXLOOP - 1); i--) {
           qql[i] = domains_up->exp_energy_cb(vc,
                                              i, l - 1,
@@ -3029,7 +3054,7 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
           for (q = qmin; q < l; q++) {
             pq = my_iindx[p] - q;
 
-            if (hard_constraints[p * n + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+            if (vrna_hc_context(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
               u2              = l - q - 1;
               ud_bak          = vc->domains_up;
               vc->domains_up  = NULL;
@@ -3118,7 +3143,6 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_mb_loops(vrna_fold_compound_t *vc)
 {
-  unsigned char     *hc;
   char              *ptype;
   short             *S;
   int               i, j, k, l, kl, jkl, *my_iindx, u, n, cnt, *motif_list,
@@ -3127,6 +3151,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
                     *expMLbase, *qmli, exp_motif_ml_left, exp_motif_ml_right;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
+  vrna_hc_t         *hc;
   vrna_sc_t         *sc;
   vrna_ud_t         *domains_up;
 
@@ -3142,7 +3167,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
   probs         = vc->exp_matrices->probs;
   scale         = vc->exp_matrices->scale;
   hc_up         = vc->hc->up_ml;
-  hc            = vc->hc->mx;
+  hc            = vc->hc;
   domains_up    = vc->domains_up;
   sc            = vc->sc;
   rtype         = &(md->rtype[0]);
@@ -3183,7 +3208,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               for (k = i - 1; k > 0; k--) {
                 kl = my_iindx[k] - l;
                 if (probs[kl] > 0.) {
-                  if (hc[n * l + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                  if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                     /* respect hard constraints */
                     FLT_OR_DBL qqq;
                     jkl = jindx[l] + k;
@@ -3222,7 +3247,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               for (k = i - 1; k > 0; k--) {
                 up  = i - k - 1;
                 kl  = my_iindx[k] - l;
-                if ((hc[n * l + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+                if ((vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
                     (probs[kl] > 0.) &&
                     (hc_up[k + 1] >= up)) {
                   int jkl = jindx[l] + k;
@@ -3283,7 +3308,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
                 }
 
                 /* 3rd, l - 1 pairs with u */
-                if (hc[n * (l - 1) + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_context(hc, l - 1, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   tt    = vrna_get_ptype(jindx[l - 1] + u, ptype);
                   temp  = qb[my_iindx[u] - (l - 1)] *
                           exp_E_MLstem(tt, S[u - 1], S[l], pf_params);
@@ -3323,7 +3348,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               /* update qmli[k] = qm1[k,i-1] */
               for (qmli[k] = 0., u = k + 1; u < i; u++) {
                 /* respect hard constraints */
-                if (hc[n * u + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_context(hc, u, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   up = (i - 1) - (u + 1) + 1;
                   if (hc_up[u + 1] >= up) {
                     temp = qb[my_iindx[k] - u] *
@@ -3352,7 +3377,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
 
               for (l = j + 1; l <= n; l++) {
                 kl = my_iindx[k] - l;
-                if (hc[n * k + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                if (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                   int up, jkl;
                   jkl = jindx[l] + k;
                   tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3413,7 +3438,6 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 {
-  unsigned char     *hc;
   char              *ptype;
   short             *S;
   int               i, j, k, l, kl, jkl, *my_iindx, u, n, cnt, *motif_list,
@@ -3423,6 +3447,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
                     exp_motif_ml_right, *qqi, *qqj, *qqmi, *qqmj;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
+  vrna_hc_t         *hc;
   vrna_sc_t         *sc;
   vrna_ud_t         *domains_up;
 
@@ -3438,7 +3463,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
   probs         = vc->exp_matrices->probs;
   scale         = vc->exp_matrices->scale;
   hc_up         = vc->hc->up_ml;
-  hc            = vc->hc->mx;
+  hc            = vc->hc;
   domains_up    = vc->domains_up;
   sc            = vc->sc;
   rtype         = &(md->rtype[0]);
@@ -3498,7 +3523,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
                 kl = my_iindx[k] - l;
                 if (probs[kl] > 0.) {
                   jkl = jindx[l] + k;
-                  if (hc[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                  if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                     /* respect hard constraints */
                     FLT_OR_DBL qqq;
                     tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3536,7 +3561,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
               for (k = i - 1; k > 0; k--) {
                 up  = i - k - 1;
                 kl  = my_iindx[k] - l;
-                if ((hc[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+                if ((vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
                     (probs[kl] > 0.) &&
                     (hc_up[k + 1] >= up)) {
                   int jkl = jindx[l] + k;
@@ -3595,7 +3620,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 
                 /* 3rd, l - 1 pairs with u */
                 int ul = my_iindx[u] - (l - 1);
-                if (hc[(l - 1) * n + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_context(hc, l - 1, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   tt    = vrna_get_ptype(jindx[l - 1] + u, ptype);
                   temp  = qb[ul] *
                           exp_E_MLstem(tt, S[u - 1], S[l], pf_params);
@@ -3635,7 +3660,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
               for (qmli[k] = 0., u = k + 1; u < i; u++) {
                 int ku = my_iindx[k] - u;
                 /* respect hard constraints */
-                if (hc[k * n + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_context(hc, k, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   up = (i - 1) - (u + 1) + 1;
                   if (hc_up[u + 1] >= up) {
                     temp = qb[ku] *
@@ -3661,7 +3686,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 
               for (l = j + 1; l <= n; l++) {
                 kl = my_iindx[k] - l;
-                if (hc[k * n + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                if (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                   int up, jkl;
                   jkl = jindx[l] + k;
                   tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3749,7 +3774,7 @@ bppm_circ(vrna_fold_compound_t  *fc,
           constraints_helper    *constraints)
 {
   char                      *ptype;
-  unsigned char             *hard_constraints, eval;
+  unsigned char             eval;
   short                     *S, *S1, **SS, **S5, **S3;
   unsigned int              s, n_seq, type, rt, *tt, **a2s;
   int                       n, i, j, k, l, ij, *rtype, *my_iindx, *jindx;
@@ -3792,7 +3817,6 @@ bppm_circ(vrna_fold_compound_t  *fc,
   scale             = matrices->scale;
   expMLbase         = matrices->expMLbase;
   qo                = matrices->qo;
-  hard_constraints  = hc->mx;
   hc_dat_mb         = &(constraints->hc_dat_mb);
   hc_eval_mb        = constraints->hc_eval_mb;
   sc_dat_int        = &(constraints->sc_wrapper_int);
@@ -3835,7 +3859,7 @@ bppm_circ(vrna_fold_compound_t  *fc,
         /* 1.1. Exterior Hairpin Contribution */
         tmp2 = vrna_exp_E_hp_loop(fc, j, i);
 
-        if (hard_constraints[i * n + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           /*
            * 1.2. Exterior Interior Loop Contribution
            * 1.2.1. i,j  delimtis the "left" part of the interior loop
@@ -3869,7 +3893,7 @@ bppm_circ(vrna_fold_compound_t  *fc,
               if (qb[my_iindx[k] - l] == 0.)
                 continue;
 
-              eval = (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
+              eval = (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
               if (hc->f)
                 eval = hc->f(k, l, i, j, VRNA_DECOMP_PAIR_IL, hc->data);
 
@@ -3942,7 +3966,7 @@ bppm_circ(vrna_fold_compound_t  *fc,
               if (qb[my_iindx[k] - l] == 0.)
                 continue;
 
-              eval = (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
+              eval = (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
               if (hc->f)
                 eval = hc->f(i, j, k, l, VRNA_DECOMP_PAIR_IL, hc->data) ? eval : 0;
 
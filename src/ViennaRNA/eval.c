@@ -34,6 +34,7 @@
 #endif
 
 #include <limits.h>
+#include <stdint.h>
 
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/structures.h"
@@ -54,6 +55,26 @@
 
 #define   ADD_OR_INF(a, b)     (((a) != INF) && ((b) != INF) ?  (a) + (b) : INF)
 
+#define   LOOP_CACHE_INIT_SIZE 1024
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+
+/*
+ *  Open addressing hash table that maps hairpin loops (i,j) and
+ *  interior loops (i,j,p,q) to their free energy. A key of 0 marks
+ *  an empty slot.
+ */
+struct loop_cache {
+  uint64_t  *keys;
+  int       *energies;
+  size_t    size;
+  size_t    filled;
+};
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -76,7 +97,8 @@ stack_energy(vrna_fold_compound_t *fc,
              int                  i,
              const short          *pt,
              vrna_cstr_t          output_stream,
-             int                  verbostiy_level);
+             int                  verbostiy_level,
+             struct loop_cache    *cache);
 
 
 PRIVATE int
@@ -128,7 +150,25 @@ PRIVATE int
 energy_of_ext_loop_components(vrna_fold_compound_t  *fc,
                               const short           *pt,
                               vrna_cstr_t           output_stream,
-                              int                   verbosity_level);
+                              int                   verbosity_level,
+                              struct loop_cache     *cache);
+
+
+PRIVATE void
+loop_cache_init(struct loop_cache *cache);
+
+
+PRIVATE void
+loop_cache_free(struct loop_cache *cache);
+
+
+PRIVATE int
+cached_loop_energy(vrna_fold_compound_t *fc,
+                   int                  i,
+                   int                  j,
+                   int                  p,
+                   int                  q,
+                   struct loop_cache    *cache);
 
 
 PRIVATE int
@@ -402,6 +442,68 @@ vrna_eval_move_pt(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC int *
+vrna_eval_structure_pt_batch(vrna_fold_compound_t *fc,
+                             const short          *pts,
+                             unsigned int         num)
+{
+  unsigned int  n;
+  int           *energies;
+
+  if ((!fc) ||
+      (!pts) ||
+      (num == 0))
+    return NULL;
+
+  n         = fc->length;
+  energies  = (int *)vrna_alloc(sizeof(int) * num);
+
+  if (fc->params->model_details.gquad)
+    vrna_message_warning("vrna_eval_*_pt: No gquadruplex support!\n"
+                         "Ignoring potential gquads in structure!\n"
+                         "Use e.g. vrna_eval_structure() instead!");
+
+  /* make sure no thread needs to modify the soft constraints data */
+  vrna_sc_prepare(fc, VRNA_OPTION_MFE);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    unsigned int      k;
+    int               e, ee;
+    const short       *pt;
+    struct loop_cache cache;
+
+    loop_cache_init(&cache);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+    for (k = 0; k < num; k++) {
+      pt = pts + (size_t)k * (n + 1);
+
+      if (pt[0] != (short)n) {
+        energies[k] = INF;
+        continue;
+      }
+
+      e   = energy_of_extLoop_pt(fc, 0, pt);
+      ee  = energy_of_ext_loop_components(fc,
+                                          pt,
+                                          NULL,
+                                          VRNA_VERBOSITY_QUIET,
+                                          &cache);
+      energies[k] = ADD_OR_INF(e, ee);
+    }
+
+    loop_cache_free(&cache);
+  }
+
+  return energies;
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -547,7 +649,7 @@ eval_pt(vrna_fold_compound_t  *fc,
                                   energy);
   }
 
-  ee      = energy_of_ext_loop_components(fc, pt, output_stream, verbosity_level);
+  ee      = energy_of_ext_loop_components(fc, pt, output_stream, verbosity_level, NULL);
   energy  = ADD_OR_INF(energy, ee);
 
   return energy;
@@ -905,7 +1007,8 @@ PRIVATE int
 energy_of_ext_loop_components(vrna_fold_compound_t  *fc,
                               const short           *pt,
                               vrna_cstr_t           output_stream,
-                              int                   verbosity_level)
+                              int                   verbosity_level,
+                              struct loop_cache     *cache)
 {
   unsigned int  last_s, s, i, n, a, *so, *sn, *ss;
   int           energy = 0;
@@ -931,7 +1034,7 @@ energy_of_ext_loop_components(vrna_fold_compound_t  *fc,
            * pairs down-stream
            * add energy of enclosed substem
            */
-          energy  += stack_energy(fc, i, pt, output_stream, verbosity_level);
+          energy  += stack_energy(fc, i, pt, output_stream, verbosity_level, cache);
           i       = (unsigned int)pt[i];
           last_s  = sn[i]; /* update current strand number */
         } else {
@@ -1002,7 +1105,8 @@ eval_circ_pt(vrna_fold_compound_t *fc,
                            i,
                            (const short *)pt,
                            output_stream,
-                           verbosity_level);
+                           verbosity_level,
+                           NULL);
     i = pt[i];
   }
 
@@ -1460,7 +1564,8 @@ stack_energy(vrna_fold_compound_t *fc,
              int                  i,
              const short          *pt,
              vrna_cstr_t          output_stream,
-             int                  verbosity_level)
+             int                  verbosity_level,
+             struct loop_cache    *cache)
 {
   /* recursively calculate energy of substructure enclosed by (i,j) */
   char          *string;
@@ -1522,7 +1627,9 @@ stack_energy(vrna_fold_compound_t *fc,
         }
       }
 
-      ee = vrna_eval_int_loop(fc, i, j, p, q);
+      ee = (cache) ?
+           cached_loop_energy(fc, i, j, p, q, cache) :
+           vrna_eval_int_loop(fc, i, j, p, q);
 
       if (verbosity_level > 0) {
         vrna_cstr_print_eval_int_loop(output_stream,
@@ -1546,7 +1653,9 @@ stack_energy(vrna_fold_compound_t *fc,
   if (p > q) {
     /* hairpin */
     if (sn[i] == sn[j]) {
-      ee = vrna_eval_hp_loop(fc, i, j);
+      ee = (cache) ?
+           cached_loop_energy(fc, i, j, 0, 0, cache) :
+           vrna_eval_hp_loop(fc, i, j);
       if (verbosity_level > 0) {
         vrna_cstr_print_eval_hp_loop(output_stream,
                                      i, j,
@@ -1564,7 +1673,7 @@ stack_energy(vrna_fold_compound_t *fc,
   if (!first_pair_after_last_nick(i, j, pt, sn)) {
     while (p < j) {
       /* add up the contributions of the substructures of the ML */
-      energy  += stack_energy(fc, p, pt, output_stream, verbosity_level);
+      energy  += stack_energy(fc, p, pt, output_stream, verbosity_level, cache);
       p       = pt[p];
       /* search for next base pair in multiloop */
       while (pt[++p] == 0);
@@ -2133,3 +2242,110 @@ energy_of_ml_pt(vrna_fold_compound_t  *fc,
 
   return energy + bonus;
 }
+
+
+PRIVATE void
+loop_cache_init(struct loop_cache *cache)
+{
+  cache->size     = LOOP_CACHE_INIT_SIZE;
+  cache->filled   = 0;
+  cache->keys     = (uint64_t *)vrna_alloc(sizeof(uint64_t) * cache->size);
+  cache->energies = (int *)vrna_alloc(sizeof(int) * cache->size);
+}
+
+
+PRIVATE void
+loop_cache_free(struct loop_cache *cache)
+{
+  free(cache->keys);
+  free(cache->energies);
+}
+
+
+PRIVATE INLINE size_t
+loop_cache_slot(const struct loop_cache *cache,
+                uint64_t                key)
+{
+  size_t h, mask;
+
+  mask  = cache->size - 1;
+  h     = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+
+  /* linear probing */
+  while ((cache->keys[h] != 0) &&
+         (cache->keys[h] != key))
+    h = (h + 1) & mask;
+
+  return h;
+}
+
+
+PRIVATE void
+loop_cache_grow(struct loop_cache *cache)
+{
+  size_t    k, h, old_size;
+  uint64_t  *old_keys;
+  int       *old_energies;
+
+  old_size      = cache->size;
+  old_keys      = cache->keys;
+  old_energies  = cache->energies;
+
+  cache->size     = 2 * old_size;
+  cache->keys     = (uint64_t *)vrna_alloc(sizeof(uint64_t) * cache->size);
+  cache->energies = (int *)vrna_alloc(sizeof(int) * cache->size);
+
+  for (k = 0; k < old_size; k++) {
+    if (old_keys[k] != 0) {
+      h                   = loop_cache_slot(cache, old_keys[k]);
+      cache->keys[h]      = old_keys[k];
+      cache->energies[h]  = old_energies[k];
+    }
+  }
+
+  free(old_keys);
+  free(old_energies);
+}
+
+
+/*
+ *  Energy of the hairpin loop (i,j) if p == 0, or the interior
+ *  loop (i,j,p,q) otherwise. Looked up in, or added to, the cache
+ */
+PRIVATE int
+cached_loop_energy(vrna_fold_compound_t *fc,
+                   int                  i,
+                   int                  j,
+                   int                  p,
+                   int                  q,
+                   struct loop_cache    *cache)
+{
+  int       e;
+  size_t    h;
+  uint64_t  key;
+
+  key = ((uint64_t)i << 48) |
+        ((uint64_t)j << 32) |
+        ((uint64_t)p << 16) |
+        (uint64_t)q;
+
+  h = loop_cache_slot(cache, key);
+
+  if (cache->keys[h] == key)
+    return cache->energies[h];
+
+  e = (p == 0) ?
+      vrna_eval_hp_loop(fc, i, j) :
+      vrna_eval_int_loop(fc, i, j, p, q);
+
+  if (2 * (cache->filled + 1) > cache->size) {
+    loop_cache_grow(cache);
+    h = loop_cache_slot(cache, key);
+  }
+
+  cache->keys[h]      = key;
+  cache->energies[h]  = e;
+  cache->filled++;
+
+  return e;
+}
@@ -243,6 +243,35 @@ vrna_eval_structure_pt_v(vrna_fold_compound_t *fc,
                          FILE                 *file);
 
 
+/**
+ *  @brief Calculate the free energies of many structures for the same sequence
+ *
+ *  This function evaluates a batch of @p num secondary structures given as pair tables
+ *  and yields the same energies as calling vrna_eval_structure_pt() for each of them.
+ *  The pair tables are expected to be packed into a single array, i.e. the pair table
+ *  of the @f$ k @f$-th structure starts at @p pts @f$ + k \cdot (n + 1) @f$ where
+ *  @f$ n @f$ is the length of the sequence.
+ *
+ *  Hairpin and interior loop energies are cached by their delimiting base pairs and
+ *  re-used for all subsequent structures that contain the same loop. This applies to
+ *  any type of fold compound. If the library has been compiled with OpenMP support,
+ *  the structures are distributed among the available threads. No energy contributions
+ *  are printed, and the warning about missing G-quadruplex support is issued at most
+ *  once per batch instead of once per structure.
+ *
+ *  @see vrna_eval_structure_pt(), vrna_ptable()
+ *
+ *  @param fc   A vrna_fold_compound_t containing the energy parameters and model details
+ *  @param pts  The packed pair tables of all structures
+ *  @param num  The number of structures
+ *  @return     An array of @p num free energies in 10cal/mol, or NULL on any error
+ */
+int *
+vrna_eval_structure_pt_batch(vrna_fold_compound_t *fc,
+                             const short          *pts,
+                             unsigned int         num);
+
+
 /* End basic eval interface with pair table */
 /**@}*/
 
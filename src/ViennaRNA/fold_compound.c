@@ -22,6 +22,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/structures.h"
@@ -41,6 +42,10 @@
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/fold_compound.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /*
  #################################
  # PRIVATE MACROS                #
@@ -77,6 +82,15 @@ PRIVATE void
 make_pscores(vrna_fold_compound_t *fc);
 
 
+PRIVATE uint64_t *
+aln_column_bits(vrna_fold_compound_t  *fc,
+                unsigned int          num_codes);
+
+
+PRIVATE INLINE unsigned int
+popcount64(uint64_t x);
+
+
 PRIVATE void
 sanitize_bp_span(vrna_fold_compound_t *fc,
                  unsigned int         options);
@@ -738,10 +752,12 @@ make_pscores(vrna_fold_compound_t *fc)
 
 #define NONE -10000 /* score for forbidden pairs */
 
-  int       i, j, k, l, s, max_span, turn;
-  short     **S   = fc->S;
-  char      **AS  = fc->sequences;
-  int       n_seq = fc->n_seq;
+  int           i, j, k, l, s, max_span, turn, num_pairs;
+  unsigned int  a, b, words, num_codes, stride, pairs[(MAXALPHA + 1) * (MAXALPHA + 1)][3];
+  uint64_t      *columns;
+  short         **S   = fc->S;
+  char          **AS  = fc->sequences;
+  int           n_seq = fc->n_seq;
   vrna_md_t *md   =
     (fc->params) ? &(fc->params->model_details) : &(fc->exp_params->model_details);
   int       *pscore   = fc->pscore;             /* precomputed array of pair types */
@@ -774,7 +790,48 @@ make_pscores(vrna_fold_compound_t *fc)
   if ((max_span < turn + 2) || (max_span > n))
     max_span = n;
 
+  /*
+   *  Instead of looking up the pair type of each sequence for every
+   *  pair of columns, we transpose the alignment into bit vectors over
+   *  all sequences, one per column and nucleotide. Pair type frequencies
+   *  then reduce to population counts of their conjunctions
+   */
+  num_codes = 1;
+  for (s = 0; s < n_seq; s++)
+    for (i = 1; i <= n; i++)
+      num_codes = MAX2(num_codes, (unsigned int)S[s][i] + 1);
+
+  num_codes = MIN2(num_codes, MAXALPHA + 1);
+  words     = (n_seq + 63) / 64;
+  stride    = (num_codes + 2) * words;
+  columns   = aln_column_bits(fc, num_codes);
+
+  /* all nucleotide combinations that form a pair, except gap-gap */
+  num_pairs = 0;
+  for (a = 0; a < num_codes; a++)
+    for (b = 0; b < num_codes; b++) {
+      int type = md->pair[a][b];
+
+      if ((md->noGU) && ((type == 3) || (type == 4)))
+        type = 0;
+
+      if ((type) && (a + b > 0)) {
+        pairs[num_pairs][0] = a;
+        pairs[num_pairs][1] = b;
+        pairs[num_pairs][2] = (unsigned int)type;
+        num_pairs++;
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for private(j, k, l) schedule(dynamic)
+#endif
   for (i = 1; i < n; i++) {
+    unsigned int  w, cnt;
+    uint64_t      *ci, *cj;
+
+    ci = columns + (size_t)i * stride;
+
     for (j = i + 1; (j < i + turn + 1) && (j <= n); j++)
       pscore[indx[j] + i] = NONE;
     for (j = i + turn + 1; j <= n; j++) {
@@ -787,27 +844,36 @@ make_pscores(vrna_fold_compound_t *fc)
         0, 0, 0, 0, 0, 0, 0, 0
       };
 
-      for (s = 0; s < n_seq; s++) {
-        int type;
-        if (S[s][i] == 0 && S[s][j] == 0) {
-          type = 7;                             /* gap-gap  */
-        } else {
-          if ((AS[s][i] == '~') || (AS[s][j] == '~')) {
-            type = 7;
-          } else {
-            type = md->pair[S[s][i]][S[s][j]];
-            if ((md->noGU) && ((type == 3) || (type == 4)))
-              type = 0;
-          }
-        }
+      cj = columns + (size_t)j * stride;
+
+      /* gap-gap, or any '~' */
+      for (w = 0; w < words; w++)
+        pfreq[7] += popcount64((ci[num_codes * words + w] & cj[num_codes * words + w]) |
+                               ci[(num_codes + 1) * words + w] |
+                               cj[(num_codes + 1) * words + w]);
+
+      for (k = 0; k < num_pairs; k++) {
+        uint64_t *bi = ci + pairs[k][0] * words;
+        uint64_t *bj = cj + pairs[k][1] * words;
 
-        pfreq[type]++;
+        for (cnt = w = 0; w < words; w++)
+          cnt += popcount64(bi[w] & bj[w]);
+
+        pfreq[pairs[k][2]] += cnt;
       }
 
+      /* everything else can't pair */
+      for (cnt = 0, l = 1; l < 8; l++)
+        cnt += pfreq[l];
+
+      pfreq[0] = n_seq - cnt;
+
       pscore[indx[j] + i] = vrna_pscore_freq(fc, &pfreq[0], 6);
     }
   }
 
+  free(columns);
+
   if (md->noLP) {
     /* remove unwanted pairs */
     for (k = 1; k < n - turn - 1; k++)
@@ -841,6 +907,60 @@ make_pscores(vrna_fold_compound_t *fc)
 }
 
 
+/*
+ *  Transpose the alignment into bit vectors over the sequences. For each
+ *  column i, the layout is num_codes bit vectors (one per nucleotide code,
+ *  excluding sequences with a '~' at i), followed by one bit vector for gaps
+ *  and one for '~'. The '~' test uses the same indexing as vrna_pscore().
+ */
+PRIVATE uint64_t *
+aln_column_bits(vrna_fold_compound_t  *fc,
+                unsigned int          num_codes)
+{
+  unsigned int  i, s, n, n_seq, words, stride, c;
+  uint64_t      *columns, *col, bit;
+
+  n       = fc->length;
+  n_seq   = fc->n_seq;
+  words   = (n_seq + 63) / 64;
+  stride  = (num_codes + 2) * words;
+  columns = (uint64_t *)vrna_alloc(sizeof(uint64_t) * (n + 1) * stride);
+
+  for (s = 0; s < n_seq; s++) {
+    bit = (uint64_t)1 << (s % 64);
+
+    for (i = 1; i <= n; i++) {
+      col = columns + (size_t)i * stride + s / 64;
+      c   = (unsigned int)fc->S[s][i];
+
+      if (c == 0)
+        col[num_codes * words] |= bit;
+
+      if (fc->sequences[s][i] == '~')
+        col[(num_codes + 1) * words] |= bit;
+      else if (c < num_codes)
+        col[c * words] |= bit;
+    }
+  }
+
+  return columns;
+}
+
+
+PRIVATE INLINE unsigned int
+popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+  return (unsigned int)__builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (unsigned int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
 PRIVATE vrna_fold_compound_t *
 init_fc_single(void)
 {
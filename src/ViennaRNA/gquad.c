@@ -320,6 +320,14 @@ count_gquad_layer_mismatches(int          i,
                              unsigned int mm[2]);
 
 
+PRIVATE vrna_gquad_index_t *
+create_pf_index(short       *S,
+                int         n,
+                void        (*f)(int, int, int *, void *, void *, void *, void *),
+                void        *data,
+                FLT_OR_DBL  *scale);
+
+
 PRIVATE int **
 create_L_matrix(short         *S,
                 int           start,
@@ -618,6 +626,60 @@ get_gquad_pf_matrix_comparative(unsigned int      n,
 }
 
 
+PUBLIC vrna_gquad_index_t *
+vrna_gquad_pf_index(vrna_fold_compound_t *fc)
+{
+  void                    *data;
+  void                    (*f)(int, int, int *, void *, void *, void *, void *);
+  short                   *S;
+  int                     n;
+  struct gquad_ali_helper gq_help;
+
+  if ((!fc) ||
+      (!fc->exp_matrices) ||
+      (!fc->exp_matrices->scale))
+    return NULL;
+
+  n = (int)fc->length;
+
+  switch (fc->type) {
+    case VRNA_FC_TYPE_SINGLE:
+      S     = fc->sequence_encoding2;
+      f     = &gquad_pf;
+      data  = (void *)fc->exp_params;
+      break;
+
+    case VRNA_FC_TYPE_COMPARATIVE:
+      S             = fc->S_cons;
+      f             = &gquad_pf_ali;
+      gq_help.S     = fc->S;
+      gq_help.a2s   = fc->a2s;
+      gq_help.n_seq = fc->n_seq;
+      gq_help.pf    = fc->exp_params;
+      data          = (void *)&gq_help;
+      break;
+
+    default:
+      return NULL;
+  }
+
+  return create_pf_index(S, n, f, data, fc->exp_matrices->scale);
+}
+
+
+PUBLIC void
+vrna_gquad_index_free(vrna_gquad_index_t *G)
+{
+  if (G) {
+    free(G->first);
+    free(G->last);
+    free(G->offset);
+    free(G->w);
+    free(G);
+  }
+}
+
+
 PUBLIC int *
 get_gquad_ali_matrix(unsigned int n,
                      short        *S_cons,
@@ -698,6 +760,92 @@ vrna_gquad_mx_local_update(vrna_fold_compound_t *vc,
 }
 
 
+/*
+ *  Enumerate the G-quadruplexes of each 5' delimiter i separately. Only the
+ *  3' delimiters j within the window of feasible box sizes need to be
+ *  considered, and only the non-zero range of each window is kept.
+ */
+PRIVATE vrna_gquad_index_t *
+create_pf_index(short       *S,
+                int         n,
+                void        (*f)(int, int, int *, void *, void *, void *, void *),
+                void        *data,
+                FLT_OR_DBL  *scale)
+{
+  int                 i, j, jmin, jmax, lo, hi, *gg;
+  size_t              size;
+  FLT_OR_DBL          row[VRNA_GQUAD_MAX_BOX_SIZE];
+  vrna_gquad_index_t  *G;
+
+  gg        = get_g_islands(S);
+  G         = (vrna_gquad_index_t *)vrna_alloc(sizeof(vrna_gquad_index_t));
+  G->n      = n;
+  G->first  = (int *)vrna_alloc(sizeof(int) * (n + 2));
+  G->last   = (int *)vrna_alloc(sizeof(int) * (n + 2));
+  G->offset = (size_t *)vrna_alloc(sizeof(size_t) * (n + 2));
+  G->num    = 0;
+  size      = (size_t)n + 1;
+  G->w      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+
+  for (i = 0; i <= n + 1; i++) {
+    G->first[i]   = 1;
+    G->last[i]    = 0;
+    G->offset[i]  = 0;
+  }
+
+  for (i = 1; i <= n; i++) {
+    /* a G-quadruplex must start with a run of at least VRNA_GQUAD_MIN_STACK_SIZE guanines */
+    if (gg[i] < VRNA_GQUAD_MIN_STACK_SIZE)
+      continue;
+
+    lo  = i + VRNA_GQUAD_MIN_BOX_SIZE - 1;
+    hi  = MIN2(n, i + VRNA_GQUAD_MAX_BOX_SIZE - 1);
+
+    if (lo > hi)
+      continue;
+
+    jmin  = hi + 1;
+    jmax  = lo - 1;
+
+    for (j = lo; j <= hi; j++) {
+      row[j - lo] = 0.;
+      process_gquad_enumeration(gg, i, j,
+                                f,
+                                (void *)(&(row[j - lo])),
+                                data,
+                                NULL,
+                                NULL);
+
+      if (row[j - lo] != 0.) {
+        jmin  = MIN2(jmin, j);
+        jmax  = j;
+      }
+    }
+
+    if (jmin > jmax)
+      continue;
+
+    if (G->num + (size_t)(jmax - jmin + 1) > size) {
+      size  = 2 * size + (size_t)(jmax - jmin + 1);
+      G->w  = (FLT_OR_DBL *)vrna_realloc(G->w, sizeof(FLT_OR_DBL) * size);
+    }
+
+    G->first[i]   = jmin;
+    G->last[i]    = jmax;
+    G->offset[i]  = G->num;
+
+    for (j = jmin; j <= jmax; j++)
+      G->w[G->num++] = row[j - lo] * scale[j - i + 1];
+  }
+
+  G->w = (FLT_OR_DBL *)vrna_realloc(G->w, sizeof(FLT_OR_DBL) * (G->num + 1));
+
+  free(gg);
+
+  return G;
+}
+
+
 PRIVATE int **
 create_L_matrix(short         *S,
                 int           start,
@@ -1050,13 +1198,13 @@ vrna_get_gquad_pattern_pf(vrna_fold_compound_t  *fc,
 
 
 PUBLIC plist *
-get_plist_gquad_from_pr(short             *S,
-                        int               gi,
-                        int               gj,
-                        FLT_OR_DBL        *G,
-                        FLT_OR_DBL        *probs,
-                        FLT_OR_DBL        *scale,
-                        vrna_exp_param_t  *pf)
+get_plist_gquad_from_pr(short               *S,
+                        int                 gi,
+                        int                 gj,
+                        vrna_gquad_index_t  *G,
+                        FLT_OR_DBL          *probs,
+                        FLT_OR_DBL          *scale,
+                        vrna_exp_param_t    *pf)
 {
   int L, l[3];
 
@@ -1076,15 +1224,15 @@ vrna_get_plist_gquad_from_pr(vrna_fold_compound_t *fc,
 
 
 PUBLIC plist *
-get_plist_gquad_from_pr_max(short             *S,
-                            int               gi,
-                            int               gj,
-                            FLT_OR_DBL        *G,
-                            FLT_OR_DBL        *probs,
-                            FLT_OR_DBL        *scale,
-                            int               *Lmax,
-                            int               lmax[3],
-                            vrna_exp_param_t  *pf)
+get_plist_gquad_from_pr_max(short               *S,
+                            int                 gi,
+                            int                 gj,
+                            vrna_gquad_index_t  *G,
+                            FLT_OR_DBL          *probs,
+                            FLT_OR_DBL          *scale,
+                            int                 *Lmax,
+                            int                 lmax[3],
+                            vrna_exp_param_t    *pf)
 {
   int         n, size, *gg, counter, i, j, *my_index;
   FLT_OR_DBL  pp, *tempprobs;
@@ -1113,7 +1261,7 @@ get_plist_gquad_from_pr_max(short             *S,
                             (void *)Lmax,
                             (void *)lmax);
 
-  pp = probs[my_index[gi] - gj] * scale[gj - gi + 1] / G[my_index[gi] - gj];
+  pp = probs[my_index[gi] - gj] * scale[gj - gi + 1] / vrna_gquad_index_weight(G, gi, gj);
   for (i = gi; i < gj; i++) {
     for (j = i; j <= gj; j++) {
       if (tempprobs[my_index[i] - j] > 0.) {
@@ -1145,11 +1293,12 @@ vrna_get_plist_gquad_from_pr_max(vrna_fold_compound_t *fc,
                                  int                  *Lmax,
                                  int                  lmax[3])
 {
-  short             *S;
-  int               n, size, *gg, counter, i, j, *my_index;
-  FLT_OR_DBL        pp, *tempprobs, *G, *probs, *scale;
-  plist             *pl;
-  vrna_exp_param_t  *pf;
+  short               *S;
+  int                 n, size, *gg, counter, i, j, *my_index;
+  FLT_OR_DBL          pp, *tempprobs, *probs, *scale;
+  plist               *pl;
+  vrna_exp_param_t    *pf;
+  vrna_gquad_index_t  *G;
 
   n         = (int)fc->length;
   pf        = fc->exp_params;
@@ -1207,7 +1356,7 @@ vrna_get_plist_gquad_from_pr_max(vrna_fold_compound_t *fc,
 
   pp = probs[my_index[gi] - gj] *
        scale[gj - gi + 1] /
-       G[my_index[gi] - gj];
+       vrna_gquad_index_weight(G, gi, gj);
 
   for (i = gi; i < gj; i++) {
     for (j = i; j <= gj; j++) {
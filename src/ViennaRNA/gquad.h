@@ -89,6 +89,76 @@ FLT_OR_DBL *get_gquad_pf_matrix_comparative(unsigned int  n,
                                             vrna_exp_param_t  *pf);
 
 
+/**
+ *  @brief  Sparse index of G-quadruplex Boltzmann weights
+ *
+ *  Only few pairs of delimiters (i, j) are able to enclose a G-quadruplex: i
+ *  must start a run of guanines, and j lies within a window of at most
+ *  #VRNA_GQUAD_MAX_BOX_SIZE nucleotides downstream of i. Instead of a full
+ *  triangular matrix, the index therefore stores the weights grouped by 5'
+ *  delimiter i, each group covering the range [first[i], last[i]] of 3'
+ *  delimiters with non-zero weight only. Use vrna_gquad_index_weight() to
+ *  look up an entry in constant time.
+ *
+ *  @see vrna_gquad_pf_index(), vrna_gquad_index_free()
+ */
+struct vrna_gquad_index_s {
+  int         n;      /**<  @brief  Length of the (consensus) sequence */
+  int         *first; /**<  @brief  Smallest 3' delimiter with non-zero weight for each 5' delimiter i, or 1 if there is none */
+  int         *last;  /**<  @brief  Largest 3' delimiter with non-zero weight for each 5' delimiter i, or 0 if there is none */
+  size_t      *offset;/**<  @brief  Position of the weight of (i, first[i]) in #w */
+  size_t      num;    /**<  @brief  Total number of weights stored in #w */
+  FLT_OR_DBL  *w;     /**<  @brief  Scaled Boltzmann weights of all G-quadruplexes delimited by (i, j) */
+};
+
+
+/**
+ *  @brief  Create a sparse index of G-quadruplex Boltzmann weights for the partition function
+ *
+ *  For each pair of delimiters (i, j), the sum of Boltzmann weights of all
+ *  G-quadruplexes delimited by i and j is computed and scaled by the factor
+ *  @p fc->exp_matrices->scale[j - i + 1]. This is the sparse counterpart of
+ *  get_gquad_pf_matrix() and get_gquad_pf_matrix_comparative(), i.e. it
+ *  requires memory proportional to the number of actual G-quadruplex
+ *  candidates rather than to the squared sequence length.
+ *
+ *  @param  fc  A fold compound of type #VRNA_FC_TYPE_SINGLE or #VRNA_FC_TYPE_COMPARATIVE with prepared partition function matrices
+ *  @return     The G-quadruplex index, or NULL on error
+ */
+vrna_gquad_index_t *
+vrna_gquad_pf_index(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Free memory occupied by a sparse G-quadruplex index
+ *
+ *  @param  G   The G-quadruplex index to free
+ */
+void
+vrna_gquad_index_free(vrna_gquad_index_t *G);
+
+
+/**
+ *  @brief  Look up the Boltzmann weight of all G-quadruplexes delimited by i and j
+ *
+ *  @param  G   The G-quadruplex index
+ *  @param  i   The 5' delimiter
+ *  @param  j   The 3' delimiter
+ *  @return     The scaled Boltzmann weight, or 0 if no G-quadruplex is delimited by i and j
+ */
+PRIVATE INLINE FLT_OR_DBL
+vrna_gquad_index_weight(const vrna_gquad_index_t  *G,
+                        int                       i,
+                        int                       j)
+{
+  if ((j < G->first[i]) ||
+      (j > G->last[i]))
+    return 0.;
+
+  return G->w[G->offset[i] + j - G->first[i]];
+}
+
+
 int **get_gquad_L_matrix(short        *S,
                          int          start,
                          int          maxdist,
@@ -127,24 +197,24 @@ void get_gquad_pattern_pf(short             *S,
                           int               l[3]);
 
 
-plist *get_plist_gquad_from_pr(short            *S,
-                               int              gi,
-                               int              gj,
-                               FLT_OR_DBL       *G,
-                               FLT_OR_DBL       *probs,
-                               FLT_OR_DBL       *scale,
-                               vrna_exp_param_t *pf);
+plist *get_plist_gquad_from_pr(short               *S,
+                               int                 gi,
+                               int                 gj,
+                               vrna_gquad_index_t  *G,
+                               FLT_OR_DBL          *probs,
+                               FLT_OR_DBL          *scale,
+                               vrna_exp_param_t    *pf);
 
 
-plist *get_plist_gquad_from_pr_max(short            *S,
-                                   int              gi,
-                                   int              gj,
-                                   FLT_OR_DBL       *G,
-                                   FLT_OR_DBL       *probs,
-                                   FLT_OR_DBL       *scale,
-                                   int              *L,
-                                   int              l[3],
-                                   vrna_exp_param_t *pf);
+plist *get_plist_gquad_from_pr_max(short               *S,
+                                   int                 gi,
+                                   int                 gj,
+                                   vrna_gquad_index_t  *G,
+                                   FLT_OR_DBL          *probs,
+                                   FLT_OR_DBL          *scale,
+                                   int                 *L,
+                                   int                 l[3],
+                                   vrna_exp_param_t    *pf);
 
 
 plist *get_plist_gquad_from_db(const char *structure,
@@ -1504,17 +1574,16 @@ E_GQuad_IntLoop_L(int           i,
 
 PRIVATE INLINE
 FLT_OR_DBL
-exp_E_GQuad_IntLoop(int               i,
-                    int               j,
-                    int               type,
-                    short             *S,
-                    FLT_OR_DBL        *G,
-                    FLT_OR_DBL        *scale,
-                    int               *index,
-                    vrna_exp_param_t  *pf)
+exp_E_GQuad_IntLoop(int                 i,
+                    int                 j,
+                    int                 type,
+                    short               *S,
+                    vrna_gquad_index_t  *G,
+                    FLT_OR_DBL          *scale,
+                    vrna_exp_param_t    *pf)
 {
   int         k, l, minl, maxl, u, r;
-  FLT_OR_DBL  q, qe;
+  FLT_OR_DBL  q, qe, qg;
   double      *expintern;
   short       si, sj;
 
@@ -1536,15 +1605,19 @@ exp_E_GQuad_IntLoop(int               i,
       u     = j - 3;
       maxl  = k + VRNA_GQUAD_MAX_BOX_SIZE + 1;
       maxl  = MIN2(u, maxl);
+      /* only 3' delimiters stored for k can close a G-quadruplex */
+      minl  = MAX2(minl, G->first[k]);
+      maxl  = MIN2(maxl, G->last[k] + 1);
       for (l = minl; l < maxl; l++) {
         if (S[l] != 3)
           continue;
 
-        if (G[index[k] - l] == 0.)
+        qg = G->w[G->offset[k] + l - G->first[k]];
+        if (qg == 0.)
           continue;
 
         q += qe
-             * G[index[k] - l]
+             * qg
              * (FLT_OR_DBL)expintern[j - l - 1]
              * scale[j - l + 1];
       }
@@ -1567,15 +1640,18 @@ exp_E_GQuad_IntLoop(int               i,
     maxl  = k + VRNA_GQUAD_MAX_BOX_SIZE + 1;
     r     = j - 1;
     maxl  = MIN2(r, maxl);
+    minl  = MAX2(minl, G->first[k]);
+    maxl  = MIN2(maxl, G->last[k] + 1);
     for (l = minl; l < maxl; l++) {
       if (S[l] != 3)
         continue;
 
-      if (G[index[k] - l] == 0.)
+      qg = G->w[G->offset[k] + l - G->first[k]];
+      if (qg == 0.)
         continue;
 
       q += qe
-           * G[index[k] - l]
+           * qg
            * (FLT_OR_DBL)expintern[u + j - l - 1]
            * scale[u + j - l + 1];
     }
@@ -1591,11 +1667,12 @@ exp_E_GQuad_IntLoop(int               i,
       if (S[k] != 3)
         continue;
 
-      if (G[index[k] - l] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       q += qe
-           * G[index[k] - l]
+           * qg
            * (FLT_OR_DBL)expintern[u]
            * scale[u + 2];
     }
@@ -1606,22 +1683,21 @@ exp_E_GQuad_IntLoop(int               i,
 
 PRIVATE INLINE
 FLT_OR_DBL
-exp_E_GQuad_IntLoop_comparative(int               i,
-                                int               j,
-                                unsigned int      *tt,
-                                short             *S_cons,
-                                short             **S5,
-                                short             **S3,
-                                unsigned int      **a2s,
-                                FLT_OR_DBL        *G,
-                                FLT_OR_DBL        *scale,
-                                int               *index,
-                                int               n_seq,
-                                vrna_exp_param_t  *pf)
+exp_E_GQuad_IntLoop_comparative(int                 i,
+                                int                 j,
+                                unsigned int        *tt,
+                                short               *S_cons,
+                                short               **S5,
+                                short               **S3,
+                                unsigned int        **a2s,
+                                vrna_gquad_index_t  *G,
+                                FLT_OR_DBL          *scale,
+                                int                 n_seq,
+                                vrna_exp_param_t    *pf)
 {
   unsigned int  type;
   int           k, l, minl, maxl, u, u1, u2, r, s;
-  FLT_OR_DBL    q, qe, qqq;
+  FLT_OR_DBL    q, qe, qg, qqq;
   double        *expintern;
   vrna_md_t     *md;
 
@@ -1648,11 +1724,15 @@ exp_E_GQuad_IntLoop_comparative(int               i,
       u     = j - 3;
       maxl  = k + VRNA_GQUAD_MAX_BOX_SIZE + 1;
       maxl  = MIN2(u, maxl);
+      /* only 3' delimiters stored for k can close a G-quadruplex */
+      minl  = MAX2(minl, G->first[k]);
+      maxl  = MIN2(maxl, G->last[k] + 1);
       for (l = minl; l < maxl; l++) {
         if (S_cons[l] != 3)
           continue;
 
-        if (G[index[k] - l] == 0.)
+        qg = G->w[G->offset[k] + l - G->first[k]];
+        if (qg == 0.)
           continue;
 
         qqq = 1.;
@@ -1663,7 +1743,7 @@ exp_E_GQuad_IntLoop_comparative(int               i,
         }
 
         q += qe *
-             G[index[k] - l] *
+             qg *
              qqq *
              scale[j - l + 1];
       }
@@ -1686,11 +1766,14 @@ exp_E_GQuad_IntLoop_comparative(int               i,
     maxl  = k + VRNA_GQUAD_MAX_BOX_SIZE + 1;
     r     = j - 1;
     maxl  = MIN2(r, maxl);
+    minl  = MAX2(minl, G->first[k]);
+    maxl  = MIN2(maxl, G->last[k] + 1);
     for (l = minl; l < maxl; l++) {
       if (S_cons[l] != 3)
         continue;
 
-      if (G[index[k] - l] == 0.)
+      qg = G->w[G->offset[k] + l - G->first[k]];
+      if (qg == 0.)
         continue;
 
       qqq = 1.;
@@ -1702,7 +1785,7 @@ exp_E_GQuad_IntLoop_comparative(int               i,
       }
 
       q += qe *
-           G[index[k] - l] *
+           qg *
            qqq *
            scale[u + j - l + 1];
     }
@@ -1718,7 +1801,8 @@ exp_E_GQuad_IntLoop_comparative(int               i,
       if (S_cons[k] != 3)
         continue;
 
-      if (G[index[k] - l] == 0.)
+      qg = vrna_gquad_index_weight(G, k, l);
+      if (qg == 0.)
         continue;
 
       qqq = 1.;
@@ -1729,7 +1813,7 @@ exp_E_GQuad_IntLoop_comparative(int               i,
       }
 
       q += qe *
-           G[index[k] - l] *
+           qg *
            qqq *
            scale[u + 2];
     }
@@ -1,14 +1,20 @@
 #include  <stdio.h>
 #include  <stdlib.h>
+#include  <string.h>
 #include  <math.h>
 
 #include  "ViennaRNA/utils/basic.h"
 #include  "ViennaRNA/params/constants.h"
+#include  "ViennaRNA/params/basic.h"
+#include  "ViennaRNA/dp_matrices.h"
+#include  "ViennaRNA/constraints/soft.h"
 #include  "ViennaRNA/mfe.h"
 #include  "ViennaRNA/part_func.h"
 #include  "ViennaRNA/heat_capacity.h"
 
-#define MAXWIDTH  201
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 struct data_collector {
   struct vrna_heat_capacity_s *data;
@@ -29,6 +35,30 @@ store_results_cb(float  t,
                  void   *data);
 
 
+PRIVATE void
+pf_temperatures(vrna_fold_compound_t  *fc,
+                vrna_md_t             *md,
+                const double          *T,
+                unsigned int          num,
+                float                 h,
+                float                 *F);
+
+
+PRIVATE void
+pf_temperature_range(vrna_fold_compound_t *fc,
+                     vrna_md_t            *md_p,
+                     const double         *T,
+                     unsigned int         from,
+                     unsigned int         to,
+                     float                h,
+                     float                *F);
+
+
+PRIVATE int
+compare_peaks(const void  *a,
+              const void  *b);
+
+
 PUBLIC struct vrna_heat_capacity_s *
 vrna_heat_capacity_simple(const char    *sequence,
                           float         T_min,
@@ -101,10 +131,10 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
                       vrna_heat_capacity_f cb,
                       void                        *data)
 {
-  unsigned int  i, n;
+  unsigned int  i, num;
   int           ret;
-  float         hc, F[MAXWIDTH];
-  double        min_en;
+  float         hc, *F;
+  double        t, *T;
   vrna_md_t     md, md_init;
 
   ret = 0;
@@ -129,7 +159,6 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
       h = T_max - T_min;
 
     /* now for the actual algorithm */
-    n       = fc->length;
     md_init = md = fc->params->model_details;
 
     /* required for vrna_exp_param_rescale() in subsequent calls */
@@ -137,53 +166,98 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
     md.backtrack    = 0;
     md.compute_bpp  = 0;
 
-    md.temperature = T_min - m * h;
-    vrna_params_reset(fc, &md);
-
-    min_en = (double)vrna_mfe(fc, NULL);
+    /*
+     *  collect the temperatures along the way the heat capacity curve is
+     *  scanned. We need the ensemble free energies at all of them except
+     *  the last one, which only marks the end of the range
+     */
+    num = 2 * m + 1;
+    T   = (double *)vrna_alloc(sizeof(double) * num);
+    t   = T_min - m * h;
+
+    for (i = 0; i < num; i++, t += h)
+      T[i] = t;
+
+    while (t <= (T_max + m * h + h)) {
+      T         = (double *)vrna_realloc(T, sizeof(double) * (num + 1));
+      T[num++]  = t;
+      t         += h;
+    }
 
-    vrna_exp_params_rescale(fc, &min_en);
+    F = (float *)vrna_alloc(sizeof(float) * num);
 
-    for (i = 0; i < 2 * m + 1; i++) {
-      F[i] = vrna_pf(fc, NULL);
-      /* increase temperature */
-      md.temperature += h;
-      /* reset all energy parameters according to temperature changes */
-      vrna_params_reset(fc, &md);
+    pf_temperatures(fc, &md, T, num - 1, h, F);
 
-      min_en = F[i] + h * 0.00727 * n;
+    for (i = 2 * m + 1; i < num; i++) {
+      hc = -ddiff(F + i - 2 * m - 1, h, m) * (T[i] + K0 - m * h - h);
 
-      vrna_exp_params_rescale(fc, &min_en);
+      /* return results */
+      cb((T[i] - (float)m * h - h), hc, data);
     }
 
-    while (md.temperature <= (T_max + m * h + h)) {
-      hc = -ddiff(F, h, m) * (md.temperature + K0 - m * h - h);
+    free(T);
+    free(F);
 
-      /* return results */
-      cb((md.temperature - (float)m * h - h), hc, data);
+    /* restore original state of (the model of) the fold_compound */
+    vrna_params_reset(fc, &md_init);
+    vrna_sc_rescale_pf(fc);
 
-      for (i = 0; i < 2 * m; i++)
-        F[i] = F[i + 1];
+    ret = 1;
+  }
 
-      F[2 * m] = vrna_pf(fc, NULL);
+  return ret;
+}
 
-      /*       printf("%g\n", F[2*m]);*/
-      md.temperature += h;
 
-      vrna_params_reset(fc, &md);
+PUBLIC struct vrna_heat_capacity_s *
+vrna_heat_capacity_peaks(const struct vrna_heat_capacity_s *curve)
+{
+  size_t                      i, n, num;
+  float                       d, y0, y1, y2, denom, offset;
+  struct vrna_heat_capacity_s *peaks;
 
-      min_en = F[i] + h * 0.00727 * n;
+  peaks = NULL;
 
-      vrna_exp_params_rescale(fc, &min_en);
+  if (curve) {
+    for (n = 0; curve[n].temperature >= -K0; n++);
+
+    num   = 0;
+    peaks = (struct vrna_heat_capacity_s *)vrna_alloc(sizeof(struct vrna_heat_capacity_s) *
+                                                      (n / 2 + 1));
+
+    for (i = 1; i + 1 < n; i++) {
+      y0  = curve[i - 1].heat_capacity;
+      y1  = curve[i].heat_capacity;
+      y2  = curve[i + 1].heat_capacity;
+
+      if ((y1 > y0) && (y1 >= y2)) {
+        /* refine position and height of the maximum by a parabola through all three points */
+        d     = curve[i + 1].temperature - curve[i].temperature;
+        denom = y0 - 2 * y1 + y2;
+
+        peaks[num].temperature    = curve[i].temperature;
+        peaks[num].heat_capacity  = y1;
+
+        if (denom < 0.) {
+          offset                    = 0.5 * (y0 - y2) / denom;
+          peaks[num].temperature    += offset * d;
+          peaks[num].heat_capacity  -= 0.25 * (y0 - y2) * offset;
+        }
+
+        num++;
+      }
     }
 
-    /* restore original state of (the model of) the fold_compound */
-    vrna_params_reset(fc, &md_init);
+    qsort(peaks, num, sizeof(struct vrna_heat_capacity_s), compare_peaks);
 
-    ret = 1;
+    peaks = (struct vrna_heat_capacity_s *)vrna_realloc(peaks,
+                                                        sizeof(struct vrna_heat_capacity_s) *
+                                                        (num + 1));
+    peaks[num].temperature    = -K0 - 1.;
+    peaks[num].heat_capacity  = -K0 - 1.;
   }
 
-  return ret;
+  return peaks;
 }
 
 
@@ -227,3 +301,156 @@ store_results_cb(float  t,
   d->data[d->num_entries].heat_capacity = hc;
   d->num_entries++;
 }
+
+
+PRIVATE int
+compare_peaks(const void  *a,
+              const void  *b)
+{
+  const struct vrna_heat_capacity_s *p1, *p2;
+
+  p1  = (const struct vrna_heat_capacity_s *)a;
+  p2  = (const struct vrna_heat_capacity_s *)b;
+
+  if (p1->heat_capacity > p2->heat_capacity)
+    return -1;
+
+  if (p1->heat_capacity < p2->heat_capacity)
+    return 1;
+
+  return (p1->temperature > p2->temperature) - (p1->temperature < p2->temperature);
+}
+
+
+/*
+ *  Compute the ensemble free energies for all temperatures T[0] to T[num - 1].
+ *  If vrna_pf_temperatures() can't handle the fold compound, the temperature
+ *  range is split into contiguous blocks, one per thread. Each
+ *  thread works on a shallow copy of the fold compound that shares sequence
+ *  encodings, pair type arrays and hard constraints with the original, but owns
+ *  its energy parameters and DP matrices. Soft constraints store temperature
+ *  dependent Boltzmann factors, so fold compounds with soft constraints are
+ *  processed by a single thread.
+ */
+PRIVATE void
+pf_temperatures(vrna_fold_compound_t  *fc,
+                vrna_md_t             *md,
+                const double          *T,
+                unsigned int          num,
+                float                 h,
+                float                 *F)
+{
+  unsigned int  i;
+  int           threads;
+  FLT_OR_DBL    *G;
+
+  /* process all temperatures within a single DP pass if the model allows for it */
+  G = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * num);
+
+  if (vrna_pf_temperatures(fc, T, num, G)) {
+    for (i = 0; i < num; i++)
+      F[i] = (float)G[i];
+
+    free(G);
+    return;
+  }
+
+  free(G);
+
+  threads = 1;
+
+#ifdef _OPENMP
+  /*
+   *  user callbacks, soft constraints, and the multi-strand grammar extension
+   *  can't be shared among threads
+   */
+  if ((fc->strands == 1) &&
+      (!fc->stat_cb) &&
+      (!fc->sc) &&
+      (!fc->scs) &&
+      (!fc->aux_grammar))
+    threads = MIN2(omp_get_max_threads(), (int)num);
+#endif
+
+  if (threads <= 1) {
+    pf_temperature_range(fc, md, T, 0, num, h, F);
+    return;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+  {
+    unsigned int          t;
+    vrna_fold_compound_t  *worker;
+
+    t = (unsigned int)omp_get_thread_num();
+
+    worker = (vrna_fold_compound_t *)vrna_alloc(sizeof(vrna_fold_compound_t));
+    memcpy(worker, fc, sizeof(vrna_fold_compound_t));
+    worker->params        = vrna_params_copy(fc->params);
+    worker->exp_params    = vrna_exp_params_copy(fc->exp_params);
+    worker->matrices      = NULL;
+    worker->exp_matrices  = NULL;
+
+    pf_temperature_range(worker,
+                         md,
+                         T,
+                         num * t / threads,
+                         num * (t + 1) / threads,
+                         h,
+                         F);
+
+    vrna_mx_mfe_free(worker);
+    vrna_mx_pf_free(worker);
+    free(worker->params);
+    free(worker->exp_params);
+    free(worker);
+  }
+#endif
+}
+
+
+PRIVATE void
+pf_temperature_range(vrna_fold_compound_t *fc,
+                     vrna_md_t            *md_p,
+                     const double         *T,
+                     unsigned int         from,
+                     unsigned int         to,
+                     float                h,
+                     float                *F)
+{
+  unsigned int  i, n;
+  double        min_en;
+  vrna_md_t     md;
+
+  if (from >= to)
+    return;
+
+  n               = fc->length;
+  md              = *md_p;
+  md.temperature  = T[from];
+
+  vrna_params_reset(fc, &md);
+  vrna_sc_rescale_pf(fc);
+
+  /* start with the MFE as estimate for the scaling factor */
+  min_en = (double)vrna_mfe(fc, NULL);
+
+  vrna_exp_params_rescale(fc, &min_en);
+
+  for (i = from; i < to; i++) {
+    F[i] = vrna_pf(fc, NULL);
+
+    if (i + 1 < to) {
+      /* reset all energy parameters according to temperature changes */
+      md.temperature = T[i + 1];
+      vrna_params_reset(fc, &md);
+      vrna_sc_rescale_pf(fc);
+
+      /* scale according to the previous ensemble free energy */
+      min_en = F[i] + h * 0.00727 * n;
+
+      vrna_exp_params_rescale(fc, &min_en);
+    }
+  }
+}
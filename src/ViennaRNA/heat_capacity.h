@@ -135,6 +135,14 @@ vrna_heat_capacity(vrna_fold_compound_t *fc,
  *  to @f$ 2 \cdot mpoints + 1 @f$ data points to calculate 2nd derivatives. Increasing this
  *  parameter produces a smoother curve.
  *
+ *  If OpenMP support is enabled, the partition functions for the individual temperatures
+ *  are computed in parallel. Each thread processes a contiguous block of temperatures
+ *  using its own energy parameters and DP matrices, while sequence encodings and
+ *  constraints are shared with @p fc. Results are still passed to the callback
+ *  in order of increasing temperature and from the calling thread only. For
+ *  multi-strand fold compounds, or in the presence of a status callback or grammar
+ *  extensions, all temperatures are processed sequentially.
+ *
  *  @see  vrna_heat_capacity(), vrna_heat_capacity_f
  *
  *  @param  fc            The #vrna_fold_compound_t with the RNA sequence to analyze
@@ -156,6 +164,29 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
                       void                        *data);
 
 
+/**
+ *  @brief  Extract the melting temperatures from a heat capacity curve
+ *
+ *  This function determines all local maxima of a heat capacity curve as
+ *  obtained from vrna_heat_capacity(). The position and height of each maximum
+ *  is refined by fitting a parabola through the maximum and its two neighboring
+ *  data points. The resulting peaks are sorted by decreasing heat capacity, such
+ *  that the first entry corresponds to the melting temperature @f$ T_m @f$ of the
+ *  main transition. Local maxima at the boundaries of the curve are not reported.
+ *  Since numeric differentiation amplifies rounding errors for small temperature
+ *  increments, noisy curves may exhibit spurious local maxima close to the actual
+ *  peak. Increasing the number of interpolation points of the curve reduces them.
+ *
+ *  @see  vrna_heat_capacity(), vrna_heat_capacity_t
+ *
+ *  @param  curve   A heat capacity curve as returned by vrna_heat_capacity()
+ *  @return         A list of melting temperatures and corresponding heat capacity or @em NULL upon any failure.
+ *                  The last entry of the list is indicated by a @b temperature field set to a value below -273.15 &deg;C
+ */
+vrna_heat_capacity_t *
+vrna_heat_capacity_peaks(const vrna_heat_capacity_t *curve);
+
+
 /* End basic interface */
 /**@}*/
 
@@ -25,6 +25,13 @@
 #include "ViennaRNA/io/file_formats.h"
 #include "ViennaRNA/io/file_formats_msa.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* upper bound for the number of alignments waiting to be processed per thread */
+#define MSA_STREAM_PENDING_PER_THREAD   4
+
 /*
  #################################
  # STATIC DECLARATIONS           #
@@ -141,6 +148,11 @@ write_stockholm_alignment(FILE          *fp,
                           int           verbosity);
 
 
+PRIVATE unsigned int
+detect_format(FILE          *fp,
+              unsigned int  options);
+
+
 PRIVATE int
 check_alignment(const char  **names,
                 const char  **aln,
@@ -155,6 +167,24 @@ free_msa_record(char  ***names,
                 char  **structure);
 
 
+PRIVATE vrna_msa_record_t *
+pack_msa_record(char          **names,
+                char          **aln,
+                char          *id,
+                char          *structure,
+                unsigned int  n_seq,
+                unsigned int  number);
+
+
+PRIVATE void
+fold_msa_record(vrna_msa_record_t *record,
+                const vrna_md_t   *md,
+                unsigned int      fc_options,
+                vrna_msa_fold_f   fold,
+                vrna_ostream_t    stream,
+                void              *data);
+
+
 PRIVATE void
 add_sequence(const char *id,
              const char *seq,
@@ -202,14 +232,9 @@ vrna_file_msa_detect_format(const char    *filename,
                             unsigned int  options)
 {
   FILE          *fp;
-  char          **names, **aln;
   unsigned int  format;
-  int           i, r;
-  long int      fp_position;
 
-  names   = NULL;
-  aln     = NULL;
-  format  = VRNA_FILE_FORMAT_MSA_UNKNOWN;
+  format = VRNA_FILE_FORMAT_MSA_UNKNOWN;
 
   /* if no alignment file format(s) were specified we probe for all of them */
   if (options == 0)
@@ -224,28 +249,7 @@ vrna_file_msa_detect_format(const char    *filename,
     return format;
   }
 
-  r           = -1;
-  fp_position = ftell(fp);
-
-  for (i = 0; i < NUM_PARSERS; i++) {
-    if ((options & known_parsers[i].code) && (known_parsers[i].parser)) {
-      /* go back to beginning of file */
-      if (!fseek(fp, fp_position, SEEK_SET)) {
-        r = known_parsers[i].parser(fp, &names, &aln, NULL, NULL, -1);
-        free_msa_record(&names, &aln, NULL, NULL);
-        if (r > 0) {
-          format = known_parsers[i].code;
-          break;
-        }
-      } else {
-        vrna_message_warning("vrna_file_msa_detect_format: "
-                             "Something unexpected happened while parsing the alignment file");
-        goto msa_detect_format_exit;
-      }
-    }
-  }
-
-msa_detect_format_exit:
+  format = detect_format(fp, options);
 
   fclose(fp);
 
@@ -429,6 +433,141 @@ vrna_file_msa_read_record(FILE          *fp,
 }
 
 
+PUBLIC unsigned int
+vrna_file_msa_fold_stream(FILE                  *fp,
+                          unsigned int          options,
+                          const vrna_md_t       *md,
+                          unsigned int          fc_options,
+                          vrna_msa_fold_f       fold,
+                          vrna_stream_output_f  output,
+                          void                  *data)
+{
+  char              **names, **aln, *id, *structure;
+  int               i, n_seq, threads;
+  unsigned int      num, pending, max_pending, format;
+  long int          fp_position;
+  vrna_md_t         md_default;
+  vrna_ostream_t    stream;
+  vrna_msa_record_t *record;
+
+  num = 0;
+
+  if ((!fp) || (!fold))
+    return num;
+
+  if (!md) {
+    vrna_md_set_default(&md_default);
+    md = &md_default;
+  }
+
+  if (!(options & VRNA_FILE_FORMAT_MSA_DEFAULT))
+    options |= VRNA_FILE_FORMAT_MSA_DEFAULT;
+
+  /*
+   *  detect the format once, such that all records are read by the same
+   *  parser. This requires a seekable stream, otherwise we stick to the
+   *  first format requested
+   */
+  format = options & VRNA_FILE_FORMAT_MSA_DEFAULT;
+
+  if (format & (format - 1)) {
+    if (ftell(fp) >= 0) {
+      format = detect_format(fp, options);
+      if (format == VRNA_FILE_FORMAT_MSA_UNKNOWN) {
+        if (!(options & VRNA_FILE_FORMAT_MSA_SILENT))
+          vrna_message_warning("vrna_file_msa_fold_stream: "
+                               "Unknown alignment file format!");
+
+        return num;
+      }
+    } else {
+      for (i = 0; i < NUM_PARSERS; i++)
+        if (options & known_parsers[i].code) {
+          format = known_parsers[i].code;
+          break;
+        }
+    }
+  }
+
+  options = (options & ~VRNA_FILE_FORMAT_MSA_DEFAULT) | format;
+
+  stream  = vrna_ostream_init(output, data);
+  pending = 0;
+  threads = 1;
+
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  max_pending = MSA_STREAM_PENDING_PER_THREAD * (unsigned int)threads;
+
+  /*
+   *  The thread that enters the single block keeps on reading alignments
+   *  and hands them over to the remaining threads as tasks. Whenever too
+   *  many alignments are pending, it processes the current one by itself
+   */
+#ifdef _OPENMP
+#pragma omp parallel if (threads > 1)
+#pragma omp single
+#endif
+  {
+    unsigned int current;
+
+    while (!feof(fp)) {
+      fp_position = ftell(fp);
+      n_seq       = vrna_file_msa_read_record(fp, &names, &aln, &id, &structure, options);
+
+      if (n_seq <= 0) {
+        /* stop if the parser doesn't make any progress */
+        if ((fp_position >= 0) &&
+            (ftell(fp) == fp_position))
+          break;
+
+        continue;
+      }
+
+      record = pack_msa_record(names, aln, id, structure, (unsigned int)n_seq, num);
+      free_msa_record(&names, &aln, &id, &structure);
+
+      vrna_ostream_request(stream, num++);
+
+      current = max_pending;
+
+      if (threads > 1) {
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+        current = pending;
+      }
+
+      if (current < max_pending) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        pending++;
+
+#ifdef _OPENMP
+#pragma omp task firstprivate(record) shared(pending)
+#endif
+        {
+          fold_msa_record(record, md, fc_options, fold, stream, data);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+          pending--;
+        }
+      } else {
+        fold_msa_record(record, md, fc_options, fold, stream, data);
+      }
+    }
+  }
+
+  vrna_ostream_free(stream);
+
+  return num;
+}
+
+
 PUBLIC int
 vrna_file_msa_write(const char    *filename,
                     const char    **names,
@@ -1187,6 +1326,91 @@ write_aln_stockholm(FILE          *fp,
 }
 
 
+PRIVATE vrna_msa_record_t *
+pack_msa_record(char          **names,
+                char          **aln,
+                char          *id,
+                char          *structure,
+                unsigned int  n_seq,
+                unsigned int  number)
+{
+  char              *ptr;
+  size_t            size, l;
+  unsigned int      s;
+  vrna_msa_record_t *record;
+
+  /* store the entire record in a single memory block */
+  size = sizeof(vrna_msa_record_t) +
+         sizeof(char *) * 2 * (n_seq + 1);
+
+  for (s = 0; s < n_seq; s++)
+    size += strlen(names[s]) + strlen(aln[s]) + 2;
+
+  if (id)
+    size += strlen(id) + 1;
+
+  if (structure)
+    size += strlen(structure) + 1;
+
+  record            = (vrna_msa_record_t *)vrna_alloc(size);
+  record->number    = number;
+  record->n_seq     = n_seq;
+  record->length    = (unsigned int)strlen(aln[0]);
+  record->names     = (char **)(record + 1);
+  record->sequences = record->names + n_seq + 1;
+  ptr               = (char *)(record->sequences + n_seq + 1);
+
+  for (s = 0; s < n_seq; s++) {
+    l                     = strlen(names[s]) + 1;
+    record->names[s]      = memcpy(ptr, names[s], l);
+    ptr                   += l;
+    l                     = strlen(aln[s]) + 1;
+    record->sequences[s]  = memcpy(ptr, aln[s], l);
+    ptr                   += l;
+  }
+
+  if (id) {
+    l           = strlen(id) + 1;
+    record->id  = memcpy(ptr, id, l);
+    ptr         += l;
+  }
+
+  if (structure)
+    record->structure = strcpy(ptr, structure);
+
+  return record;
+}
+
+
+PRIVATE void
+fold_msa_record(vrna_msa_record_t *record,
+                const vrna_md_t   *md,
+                unsigned int      fc_options,
+                vrna_msa_fold_f   fold,
+                vrna_ostream_t    stream,
+                void              *data)
+{
+  unsigned int          number;
+  void                  *result;
+  vrna_fold_compound_t  *fc;
+
+  result  = NULL;
+  number  = record->number;
+  fc      = vrna_fold_compound_comparative((const char **)record->sequences,
+                                           (vrna_md_t *)md,
+                                           fc_options);
+
+  if (fc) {
+    result = fold(fc, record, data);
+    vrna_fold_compound_free(fc);
+  }
+
+  free(record);
+
+  vrna_ostream_provide(stream, number, result);
+}
+
+
 PRIVATE void
 add_sequence(const char *id,
              const char *seq,
@@ -1251,3 +1475,47 @@ check_alignment(const char  **names,
 
   return pass;
 }
+
+
+/*
+ *  Probe the parsers requested in options one after another for the
+ *  alignment at the current position of fp, and return the code of the first
+ *  one that succeeds. The file position is restored afterwards
+ */
+PRIVATE unsigned int
+detect_format(FILE          *fp,
+              unsigned int  options)
+{
+  char          **names, **aln;
+  unsigned int  format;
+  int           i, r;
+  long int      fp_position;
+
+  names       = NULL;
+  aln         = NULL;
+  format      = VRNA_FILE_FORMAT_MSA_UNKNOWN;
+  fp_position = ftell(fp);
+
+  for (i = 0; i < NUM_PARSERS; i++) {
+    if ((options & known_parsers[i].code) && (known_parsers[i].parser)) {
+      /* go back to where we started */
+      if (!fseek(fp, fp_position, SEEK_SET)) {
+        r = known_parsers[i].parser(fp, &names, &aln, NULL, NULL, -1);
+        free_msa_record(&names, &aln, NULL, NULL);
+        if (r > 0) {
+          format = known_parsers[i].code;
+          break;
+        }
+      } else {
+        vrna_message_warning("vrna_file_msa_detect_format: "
+                             "Something unexpected happened while parsing the alignment file");
+        return VRNA_FILE_FORMAT_MSA_UNKNOWN;
+      }
+    }
+  }
+
+  if (fseek(fp, fp_position, SEEK_SET))
+    format = VRNA_FILE_FORMAT_MSA_UNKNOWN;
+
+  return format;
+}
@@ -9,6 +9,10 @@
 
 #include <stdio.h>
 
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/datastructures/stream_output.h>
+
 /**
  *  @addtogroup   file_formats_msa
  *  @{
@@ -280,6 +284,90 @@ vrna_file_msa_write(const char    *filename,
                     unsigned int  options);
 
 
+/**
+ *  @brief  A multiple sequence alignment record as passed to #vrna_msa_fold_f callbacks
+ *
+ *  All strings and arrays of a record are stored within a single memory block.
+ *
+ *  @see vrna_file_msa_fold_stream()
+ */
+typedef struct vrna_msa_record_s vrna_msa_record_t;
+
+
+/**
+ *  @brief  A multiple sequence alignment record as passed to #vrna_msa_fold_f callbacks
+ */
+struct vrna_msa_record_s {
+  unsigned int  number;      /**< @brief The index of the alignment within the input, starting at 0 */
+  unsigned int  n_seq;       /**< @brief The number of sequences */
+  unsigned int  length;      /**< @brief The length of the alignment */
+  char          *id;         /**< @brief The ID of the alignment (Maybe NULL) */
+  char          *structure;  /**< @brief The consensus structure of the alignment (Maybe NULL) */
+  char          **names;     /**< @brief The sequence identifiers, terminated by a NULL pointer */
+  char          **sequences; /**< @brief The aligned sequences, terminated by a NULL pointer */
+};
+
+
+/**
+ *  @brief  Callback to process a single alignment in vrna_file_msa_fold_stream()
+ *
+ *  @callback
+ *  @parblock
+ *  This function is called once per alignment, possibly concurrently from
+ *  different threads, with a comparative fold compound created from the alignment.
+ *  The fold compound and the record are released after the callback returns.
+ *  The returned data is passed to the output callback of vrna_file_msa_fold_stream()
+ *  in the order of the alignments within the input.
+ *  @endparblock
+ *
+ *  @see vrna_file_msa_fold_stream()
+ *
+ *  @param  fc      The comparative fold compound of the alignment
+ *  @param  record  The alignment record
+ *  @param  data    The arbitrary data pointer passed to vrna_file_msa_fold_stream()
+ *  @return         The results for this alignment
+ */
+typedef void *(*vrna_msa_fold_f)(vrna_fold_compound_t     *fc,
+                                 const vrna_msa_record_t  *record,
+                                 void                     *data);
+
+
+/**
+ *  @brief  Process all multiple sequence alignments of a file in parallel
+ *
+ *  This function reads one alignment record after another from @p fp, see
+ *  vrna_file_msa_read_record(), and packs each of them into a compact memory
+ *  block. If @p options request more than one file format, the format is
+ *  detected once from the first record, see vrna_file_msa_detect_format(),
+ *  unless @p fp is not seekable. In that case, the first of the requested
+ *  formats is used. If OpenMP support is enabled, the calling thread keeps on reading
+ *  while worker threads create comparative fold compounds for the alignments
+ *  read so far and process them with @p fold. The number of alignments in flight
+ *  is bounded to a small multiple of the number of threads. Results are
+ *  passed to @p output strictly in input order through an ordered output stream
+ *  (see vrna_ostream_init()), where @p output is responsible for releasing them.
+ *
+ *  @see  vrna_file_msa_read_record(), vrna_fold_compound_comparative(), vrna_ostream_init()
+ *
+ *  @param  fp          The file pointer the alignments are read from
+ *  @param  options     Options to manipulate the behavior of vrna_file_msa_read_record()
+ *  @param  md          The model details used for the comparative fold compounds (Maybe NULL)
+ *  @param  fc_options  Options passed to vrna_fold_compound_comparative()
+ *  @param  fold        The callback that processes each alignment
+ *  @param  output      The callback that receives the results in input order
+ *  @param  data        An arbitrary data pointer passed to @p fold and @p output
+ *  @return             The number of alignments processed
+ */
+unsigned int
+vrna_file_msa_fold_stream(FILE                  *fp,
+                          unsigned int          options,
+                          const vrna_md_t       *md,
+                          unsigned int          fc_options,
+                          vrna_msa_fold_f       fold,
+                          vrna_stream_output_f  output,
+                          void                  *data);
+
+
 /**
  * @}
  */
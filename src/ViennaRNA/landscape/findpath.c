@@ -10,6 +10,7 @@
 #include <limits.h>
 
 #include "ViennaRNA/datastructures/basic.h"
+#include "ViennaRNA/datastructures/array.h"
 #include "ViennaRNA/model.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/fold.h"
@@ -18,17 +19,14 @@
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/landscape/findpath.h"
 
 
-#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
-
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
-#endif
-
 #define LOOP_EN
 
 #define   PATH_DIRECT_FINDPATH     1U
@@ -54,6 +52,34 @@ typedef struct intermediate {
 } intermediate_t;
 
 
+/* structure with its position in the batch input */
+struct structure_id {
+  const char    *structure;
+  unsigned int  index;
+};
+
+/* pair of structure ids with its position in the batch input */
+struct pair_id {
+  unsigned int  a;
+  unsigned int  b;
+  unsigned int  index;
+};
+
+/* saddle energy of a path to structure id */
+struct saddle_bound {
+  unsigned int  id;
+  int           en;
+};
+
+/* saddle energy of the path between structure ids a and b */
+struct saddle_edge {
+  unsigned int  a;
+  unsigned int  b;
+  int           en;
+  unsigned int  index;
+};
+
+
 struct vrna_path_options_s {
   unsigned int  type;
   unsigned int  method;
@@ -97,17 +123,33 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
  #################################
  */
 PRIVATE move_t *
-copy_moves(move_t *mvs);
+copy_moves(move_t *mvs,
+           int    bp_dist);
 
 
 PRIVATE int
-compare_ptable(const void *A,
+compare_energy(const void *A,
                const void *B);
 
 
 PRIVATE int
-compare_energy(const void *A,
-               const void *B);
+compare_intermediates(const intermediate_t  *a,
+                      const intermediate_t  *b);
+
+
+PRIVATE unsigned int
+hash_ptable(const short *pt);
+
+
+PRIVATE int
+remove_duplicates(intermediate_t  *list,
+                  int             num);
+
+
+PRIVATE void
+select_best(intermediate_t  *list,
+            int             num,
+            int             k);
 
 
 PRIVATE int
@@ -115,6 +157,36 @@ compare_moves_when(const void *A,
                    const void *B);
 
 
+PRIVATE int
+compare_structure_ids(const void  *A,
+                      const void  *B);
+
+
+PRIVATE int
+compare_pair_ids(const void *A,
+                 const void *B);
+
+
+PRIVATE int
+saddle_bound(struct saddle_bound  **known,
+             unsigned int         a,
+             unsigned int         b,
+             int                  *via);
+
+
+PRIVATE void
+saddle_closure(unsigned int       n_str,
+               unsigned int       num,
+               const unsigned int *ids,
+               const unsigned int *rep,
+               int                *saddles);
+
+
+PRIVATE int
+compare_saddle_edges(const void *A,
+                     const void *B);
+
+
 PRIVATE void
 free_intermediate(intermediate_t *i);
 
@@ -128,12 +200,25 @@ usage(void);
 
 #endif
 
+PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                const char            *s1,
+                const char            *s2,
+                int                   width,
+                int                   maxE,
+                move_t                **best_path,
+                int                   *bp_dist,
+                int                   *fwd);
+
+
 PRIVATE int
 find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE);
+               int                  maxE,
+               move_t               **path_once,
+               int                  *bp_dist);
 
 
 PRIVATE int
@@ -141,7 +226,8 @@ try_moves(vrna_fold_compound_t  *vc,
           intermediate_t        c,
           int                   maxE,
           intermediate_t        *next,
-          int                   dist);
+          int                   dist,
+          int                   bp_dist);
 
 
 /*
@@ -189,53 +275,164 @@ vrna_path_findpath_saddle_ub(vrna_fold_compound_t *vc,
                              int                  width,
                              int                  maxE)
 {
-  int     maxl;
-  short   *ptr, *pt1, *pt2;
-  move_t  *bestpath = NULL;
-  int     dir;
+  /* keep the best path in the (deprecated) globals */
+  free(path);
+  path = NULL;
 
-  path_fwd  = dir = 0;
-  pt1       = vrna_ptable(s1);
-  pt2       = vrna_ptable(s2);
+  return findpath_saddle(vc, s1, s2, width, maxE, &path, &BP_dist, &path_fwd);
+}
 
-  maxl = 1;
-  do {
-    int saddleE;
-    path_fwd = !path_fwd;
-    if (maxl > width)
-      maxl = width;
 
-    if (path)
-      free(path);
+PUBLIC int *
+vrna_path_findpath_saddle_batch(vrna_fold_compound_t  *fc,
+                                const char            **s1,
+                                const char            **s2,
+                                unsigned int          num,
+                                int                   width,
+                                int                   maxE)
+{
+  unsigned int                      i, n_str, *ids, *rep;
+  int                               *saddles;
+  struct structure_id               *sids;
+  struct pair_id                    *pids;
+  vrna_array(struct saddle_bound)   *known;
+
+  if ((!fc) ||
+      (!s1) ||
+      (!s2) ||
+      (num == 0))
+    return NULL;
+
+  saddles = (int *)vrna_alloc(sizeof(int) * num);
+  ids     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * 2 * num);
+  rep     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num);
+  sids    = (struct structure_id *)vrna_alloc(sizeof(struct structure_id) * 2 * num);
+  pids    = (struct pair_id *)vrna_alloc(sizeof(struct pair_id) * num);
+
+  /* assign the same id to identical structures */
+  for (i = 0; i < num; i++) {
+    sids[2 * i].structure     = s1[i];
+    sids[2 * i].index         = 2 * i;
+    sids[2 * i + 1].structure = s2[i];
+    sids[2 * i + 1].index     = 2 * i + 1;
+  }
 
-    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE);
-    if (saddleE < maxE) {
-      maxE = saddleE;
-      if (bestpath)
-        free(bestpath);
+  qsort(sids, 2 * num, sizeof(struct structure_id), compare_structure_ids);
 
-      bestpath  = path;
-      path      = NULL;
-      dir       = path_fwd;
-    } else {
-      free(path);
-      path = NULL;
+  for (n_str = i = 0; i < 2 * num; i++) {
+    if ((i > 0) &&
+        (strcmp(sids[i].structure, sids[i - 1].structure) != 0))
+      n_str++;
+
+    ids[sids[i].index] = n_str;
+  }
+  n_str++;
+
+  /* identical pairs are computed only once */
+  for (i = 0; i < num; i++) {
+    pids[i].a     = ids[2 * i];
+    pids[i].b     = ids[2 * i + 1];
+    pids[i].index = i;
+  }
+
+  qsort(pids, num, sizeof(struct pair_id), compare_pair_ids);
+
+  for (i = 0; i < num; i++)
+    rep[pids[i].index] = ((i > 0) &&
+                          (pids[i].a == pids[i - 1].a) &&
+                          (pids[i].b == pids[i - 1].b)) ?
+                         rep[pids[i - 1].index] :
+                         pids[i].index;
+
+  /* saddle energies of all paths found so far, stored for both end points */
+  known = (struct saddle_bound **)vrna_alloc(sizeof(struct saddle_bound *) * n_str);
+
+  /*
+   *  make sure no thread needs to modify the soft constraints data. After
+   *  that, energy evaluation only reads from the fold compound, unless a
+   *  user-defined soft constraints callback prepares its data on each call
+   */
+  vrna_sc_prepare(fc, VRNA_OPTION_MFE);
+
+#ifdef _OPENMP
+#pragma omp parallel if (!((fc->sc) && (fc->sc->prepare_data)))
+#endif
+  {
+    unsigned int  k, a, b;
+    int           bound, en, bp_dist, *via;
+
+    via = (int *)vrna_alloc(sizeof(int) * n_str);
+    for (k = 0; k < n_str; k++)
+      via[k] = INT_MAX;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (k = 0; k < num; k++) {
+      if (rep[k] != k)
+        continue;
+
+      a = ids[2 * k];
+      b = ids[2 * k + 1];
+
+#ifdef _OPENMP
+#pragma omp critical (findpath_batch)
+#endif
+      bound = saddle_bound(known, a, b, via);
+
+      en = findpath_saddle(fc,
+                           s1[k],
+                           s2[k],
+                           width,
+                           MIN2(maxE, bound),
+                           NULL,
+                           &bp_dist,
+                           NULL);
+
+      saddles[k] = en;
+
+      if (en < maxE) {
+#ifdef _OPENMP
+#pragma omp critical (findpath_batch)
+#endif
+        {
+          struct saddle_bound s;
+
+          if (!known[a])
+            vrna_array_init(known[a]);
+
+          if (!known[b])
+            vrna_array_init(known[b]);
+
+          s.id    = b;
+          s.en    = en;
+          vrna_array_append(known[a], s);
+          s.id    = a;
+          vrna_array_append(known[b], s);
+        }
+      }
     }
 
-    ptr   = pt1;
-    pt1   = pt2;
-    pt2   = ptr;
-    maxl  *= 2;
-  } while (maxl < 2 * width);
+    free(via);
+  }
 
-  /* (re)set some globals */
-  path      = bestpath;
-  path_fwd  = dir;
+  /* results must not depend on the bounds that were available to a search */
+  saddle_closure(n_str, num, ids, rep, saddles);
 
-  free(pt1);
-  free(pt2);
+  for (i = 0; i < num; i++)
+    saddles[i] = saddles[rep[i]];
 
-  return maxE;
+  for (i = 0; i < n_str; i++)
+    if (known[i])
+      vrna_array_free(known[i]);
+
+  free(known);
+  free(pids);
+  free(sids);
+  free(rep);
+  free(ids);
+
+  return saddles;
 }
 
 
@@ -314,44 +511,46 @@ findpath_method(vrna_fold_compound_t  *fc,
                 int                   maxE,
                 unsigned int          return_type)
 {
-  int         E, d;
+  int         E, d, bp_dist, fwd;
   float       last_E;
+  move_t      *moves;
   vrna_path_t *route = NULL;
 
-  E = vrna_path_findpath_saddle_ub(fc, s1, s2, width, maxE);
+  moves = NULL;
+  E     = findpath_saddle(fc, s1, s2, width, maxE, &moves, &bp_dist, &fwd);
 
   /* did we find a better path than one with saddle maxE? */
   if (E < maxE) {
-    route = (vrna_path_t *)vrna_alloc((BP_dist + 2) * sizeof(vrna_path_t));
+    route = (vrna_path_t *)vrna_alloc((bp_dist + 2) * sizeof(vrna_path_t));
 
-    qsort(path, BP_dist, sizeof(move_t), compare_moves_when);
+    qsort(moves, bp_dist, sizeof(move_t), compare_moves_when);
 
     switch (return_type) {
       case VRNA_PATH_TYPE_MOVES:
-        if (path_fwd) {
+        if (fwd) {
           last_E = vrna_eval_structure(fc, s1);
-          for (d = 0; d < BP_dist; d++) {
+          for (d = 0; d < bp_dist; d++) {
             route[d].type = return_type;
-            route[d].move = vrna_move_init(path[d].i,
-                                           path[d].j);
-            route[d].en = (path[d].E / 100.0) - last_E;
-            last_E      = path[d].E / 100.0;
+            route[d].move = vrna_move_init(moves[d].i,
+                                           moves[d].j);
+            route[d].en = (moves[d].E / 100.0) - last_E;
+            last_E      = moves[d].E / 100.0;
           }
 
-          route[BP_dist].type = return_type;
-          route[BP_dist].move = vrna_move_init(0, 0);
+          route[bp_dist].type = return_type;
+          route[bp_dist].move = vrna_move_init(0, 0);
         } else {
           last_E = vrna_eval_structure(fc, s2);
-          for (d = 0; d < BP_dist; d++) {
-            route[BP_dist - d - 2].type = return_type;
-            route[BP_dist - d - 2].move = vrna_move_init(path[d].i,
-                                                         path[d].j);
-            route[BP_dist - d - 2].en = last_E - (path[d].E / 100.0);
-            last_E                    = path[d].E / 100;
+          for (d = 0; d < bp_dist; d++) {
+            route[bp_dist - d - 2].type = return_type;
+            route[bp_dist - d - 2].move = vrna_move_init(moves[d].i,
+                                                         moves[d].j);
+            route[bp_dist - d - 2].en = last_E - (moves[d].E / 100.0);
+            last_E                    = moves[d].E / 100;
           }
 
-          route[BP_dist].type = return_type;
-          route[BP_dist].move = vrna_move_init(0, 0);
+          route[bp_dist].type = return_type;
+          route[bp_dist].move = vrna_move_init(0, 0);
         }
 
         break;
@@ -360,18 +559,18 @@ findpath_method(vrna_fold_compound_t  *fc,
       /* fall through */
 
       default:
-        if (path_fwd) {
-          /* memorize start of path */
+        if (fwd) {
+          /* memorize start of moves */
           route[0].type = return_type;
           route[0].s    = strdup(s1);
           route[0].en   = vrna_eval_structure(fc, s1);
 
-          for (d = 0; d < BP_dist; d++) {
+          for (d = 0; d < bp_dist; d++) {
             int i, j;
             route[d + 1].type = return_type;
             route[d + 1].s    = strdup(route[d].s);
-            i                 = path[d].i;
-            j                 = path[d].j;
+            i                 = moves[d].i;
+            j                 = moves[d].j;
             if (i < 0) {
               /* delete */
               route[d + 1].s[(-i) - 1] = route[d + 1].s[(-j) - 1] = '.';
@@ -380,29 +579,29 @@ findpath_method(vrna_fold_compound_t  *fc,
               route[d + 1].s[j - 1] = ')';
             }
 
-            route[d + 1].en = path[d].E / 100.0;
+            route[d + 1].en = moves[d].E / 100.0;
           }
         } else {
-          /* memorize start of path */
+          /* memorize start of moves */
           route[0].type     = return_type;
-          route[BP_dist].s  = strdup(s2);
-          route[BP_dist].en = vrna_eval_structure(fc, s2);
+          route[bp_dist].s  = strdup(s2);
+          route[bp_dist].en = vrna_eval_structure(fc, s2);
 
-          for (d = 0; d < BP_dist; d++) {
+          for (d = 0; d < bp_dist; d++) {
             int i, j;
-            route[BP_dist - d - 1].type = return_type;
-            route[BP_dist - d - 1].s    = strdup(route[BP_dist - d].s);
-            i                           = path[d].i;
-            j                           = path[d].j;
+            route[bp_dist - d - 1].type = return_type;
+            route[bp_dist - d - 1].s    = strdup(route[bp_dist - d].s);
+            i                           = moves[d].i;
+            j                           = moves[d].j;
             if (i < 0) {
               /* delete */
-              route[BP_dist - d - 1].s[(-i) - 1] = route[BP_dist - d - 1].s[(-j) - 1] = '.';
+              route[bp_dist - d - 1].s[(-i) - 1] = route[bp_dist - d - 1].s[(-j) - 1] = '.';
             } else {
-              route[BP_dist - d - 1].s[i - 1] = '(';
-              route[BP_dist - d - 1].s[j - 1] = ')';
+              route[bp_dist - d - 1].s[i - 1] = '(';
+              route[bp_dist - d - 1].s[j - 1] = ')';
             }
 
-            route[BP_dist - d - 1].en = path[d].E / 100.0;
+            route[bp_dist - d - 1].en = moves[d].E / 100.0;
           }
         }
 
@@ -412,7 +611,7 @@ findpath_method(vrna_fold_compound_t  *fc,
 #if _DEBUG_FINDPATH_
     if (return_type & VRNA_PATH_TYPE_DOT_BRACKET) {
       fprintf(stderr, "\n%s\n%s\n%s\n\n", seq, s1, s2);
-      for (d = 0; d <= BP_dist; d++)
+      for (d = 0; d <= bp_dist; d++)
         fprintf(stderr, "%s %6.2f\n", route[d].s, route[d].en);
       fprintf(stderr, "%d\n", *num_entry);
     }
@@ -420,8 +619,7 @@ findpath_method(vrna_fold_compound_t  *fc,
 #endif
   }
 
-  free(path);
-  path = NULL;
+  free(moves);
 
   return route;
 }
@@ -603,12 +801,68 @@ usage(void)
  # STATIC helper functions below #
  #################################
  */
+PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                const char            *s1,
+                const char            *s2,
+                int                   width,
+                int                   maxE,
+                move_t                **best_path,
+                int                   *bp_dist,
+                int                   *fwd)
+{
+  int     maxl, saddleE, forward, dir;
+  short   *ptr, *pt1, *pt2;
+  move_t  *moves, *bestpath = NULL;
+
+  forward = dir = 0;
+  pt1     = vrna_ptable(s1);
+  pt2     = vrna_ptable(s2);
+
+  maxl = 1;
+  do {
+    forward = !forward;
+    if (maxl > width)
+      maxl = width;
+
+    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE, &moves, bp_dist);
+    if (saddleE < maxE) {
+      maxE = saddleE;
+      free(bestpath);
+      bestpath  = moves;
+      dir       = forward;
+    } else {
+      free(moves);
+    }
+
+    ptr   = pt1;
+    pt1   = pt2;
+    pt2   = ptr;
+    maxl  *= 2;
+  } while (maxl < 2 * width);
+
+  if (best_path)
+    *best_path = bestpath;
+  else
+    free(bestpath);
+
+  if (fwd)
+    *fwd = dir;
+
+  free(pt1);
+  free(pt2);
+
+  return maxE;
+}
+
+
 PRIVATE int
 try_moves(vrna_fold_compound_t  *vc,
           intermediate_t        c,
           int                   maxE,
           intermediate_t        *next,
-          int                   dist)
+          int                   dist,
+          int                   bp_dist)
 {
   int     *loopidx, len, num_next = 0, en, oldE;
   move_t  *mv;
@@ -654,7 +908,7 @@ try_moves(vrna_fold_compound_t  *vc,
       next[num_next].pt       = pt;
       mv->when                = dist;
       mv->E                   = en;
-      next[num_next++].moves  = copy_moves(c.moves);
+      next[num_next++].moves  = copy_moves(c.moves, bp_dist);
       mv->when                = 0;
     } else {
       free(pt);
@@ -670,7 +924,9 @@ find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE)
+               int                  maxE,
+               move_t               **path_once,
+               int                  *bp_dist)
 {
   move_t          *mlist;
   int             i, len, d, dist = 0, result;
@@ -700,7 +956,7 @@ find_path_once(vrna_fold_compound_t *vc,
     }
   }
 
-  BP_dist           = dist;
+  *bp_dist          = dist;
   current           = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (maxl + 1));
   current[0].pt     = pt;
   current[0].Sen    = current[0].curr_en = vrna_eval_structure_pt(vc, pt);
@@ -713,7 +969,7 @@ find_path_once(vrna_fold_compound_t *vc,
     intermediate_t  *cc;
 
     for (c = 0; current[c].pt != NULL; c++)
-      num_next += try_moves(vc, current[c], maxE, next + num_next, d);
+      num_next += try_moves(vc, current[c], maxE, next + num_next, d, dist);
     if (num_next == 0) {
       for (cc = current; cc->pt != NULL; cc++)
         free_intermediate(cc);
@@ -721,17 +977,11 @@ find_path_once(vrna_fold_compound_t *vc,
       break;
     }
 
-    /* remove duplicates via sort|uniq
-     * if this becomes a bottleneck we can use a hash instead */
-    qsort(next, num_next, sizeof(intermediate_t), compare_ptable);
-    for (u = 0, c = 1; c < num_next; c++) {
-      if (memcmp(next[u].pt, next[c].pt, sizeof(short) * len) != 0)
-        next[++u] = next[c];
-      else
-        free_intermediate(next + c);
-    }
-    num_next = u + 1;
-    qsort(next, num_next, sizeof(intermediate_t), compare_energy);
+    num_next = remove_duplicates(next, num_next);
+
+    /* move the maxl best intermediates to the front, in sorted order */
+    select_best(next, num_next, maxl);
+
     /* free the old stuff */
     for (cc = current; cc->pt != NULL; cc++)
       free_intermediate(cc);
@@ -742,8 +992,8 @@ find_path_once(vrna_fold_compound_t *vc,
     num_next = 0;
   }
   free(next);
-  path    = current[0].moves;
-  result  = current[0].Sen;
+  *path_once  = current[0].moves;
+  result      = current[0].Sen;
   free(current[0].pt);
   free(current);
   return result;
@@ -762,39 +1012,405 @@ free_intermediate(intermediate_t *i)
 
 
 PRIVATE int
-compare_ptable(const void *A,
+compare_intermediates(const intermediate_t  *a,
+                      const intermediate_t  *b)
+{
+  if (a->Sen != b->Sen)
+    return (a->Sen < b->Sen) ? -1 : 1;
+
+  if (a->curr_en != b->curr_en)
+    return (a->curr_en < b->curr_en) ? -1 : 1;
+
+  /* ties are resolved by the pair table to yield a total order */
+  return memcmp(a->pt, b->pt, (a->pt[0] + 1) * sizeof(short));
+}
+
+
+PRIVATE int
+compare_energy(const void *A,
                const void *B)
 {
-  intermediate_t  *a, *b;
-  int             c;
+  return compare_intermediates((const intermediate_t *)A,
+                               (const intermediate_t *)B);
+}
+
+
+PRIVATE unsigned int
+hash_ptable(const short *pt)
+{
+  unsigned int  i, h;
+
+  /* FNV-1a */
+  for (h = 2166136261U, i = 0; i < (unsigned int)pt[0]; i++) {
+    h ^= (unsigned short)pt[i + 1];
+    h *= 16777619U;
+  }
+
+  return h;
+}
+
+
+/*
+ *  Remove intermediates with identical pair tables, only the one with
+ *  lowest energy (or the first one for equal energies) is kept. Returns
+ *  the number of remaining intermediates.
+ */
+PRIVATE int
+remove_duplicates(intermediate_t  *list,
+                  int             num)
+{
+  int           c, u, len;
+  unsigned int  size, h, *table;
+
+  if (num < 2)
+    return num;
+
+  len = list[0].pt[0];
+
+  for (size = 2; size < 2 * (unsigned int)num; size <<= 1);
+
+  /* open addressing with linear probing, slots store (index + 1) */
+  table = (unsigned int *)vrna_alloc(sizeof(unsigned int) * size);
+
+  for (c = 0; c < num; c++) {
+    for (h = hash_ptable(list[c].pt) & (size - 1); table[h]; h = (h + 1) & (size - 1)) {
+      u = table[h] - 1;
+      if (memcmp(list[u].pt, list[c].pt, sizeof(short) * (len + 1)) == 0)
+        break;
+    }
+
+    if (!table[h]) {
+      table[h] = c + 1;
+      continue;
+    }
+
+    u = table[h] - 1;
+    if (compare_intermediates(list + c, list + u) < 0) {
+      free_intermediate(list + u);
+      list[u] = list[c];
+    } else {
+      free_intermediate(list + c);
+    }
+
+    list[c].pt    = NULL;
+    list[c].moves = NULL;
+  }
+
+  free(table);
+
+  for (u = c = 0; c < num; c++)
+    if (list[c].pt)
+      list[u++] = list[c];
+
+  return u;
+}
+
+
+/*
+ *  Partial selection (quickselect) of the k best intermediates
+ *  that are subsequently sorted by energy. This is much cheaper
+ *  than sorting the entire list when k << num.
+ */
+PRIVATE void
+select_best(intermediate_t  *list,
+            int             num,
+            int             k)
+{
+  int             lo, hi, mid, i, j;
+  intermediate_t  pivot, tmp;
+
+#define SWAP_INTERMEDIATES(a, b)  { tmp = list[a]; list[a] = list[b]; list[b] = tmp; }
+
+  if (k < num) {
+    lo  = 0;
+    hi  = num - 1;
+
+    while (lo < hi) {
+      /* median of three */
+      mid = lo + (hi - lo) / 2;
+      if (compare_intermediates(list + mid, list + lo) < 0)
+        SWAP_INTERMEDIATES(mid, lo);
+
+      if (compare_intermediates(list + hi, list + lo) < 0)
+        SWAP_INTERMEDIATES(hi, lo);
+
+      if (compare_intermediates(list + hi, list + mid) < 0)
+        SWAP_INTERMEDIATES(hi, mid);
+
+      pivot = list[mid];
+      i     = lo;
+      j     = hi;
+      while (i <= j) {
+        while (compare_intermediates(list + i, &pivot) < 0)
+          i++;
+        while (compare_intermediates(&pivot, list + j) < 0)
+          j--;
+        if (i <= j) {
+          SWAP_INTERMEDIATES(i, j);
+          i++;
+          j--;
+        }
+      }
 
-  a = (intermediate_t *)A;
-  b = (intermediate_t *)B;
+      if (k - 1 <= j)
+        hi = j;
+      else if (k - 1 >= i)
+        lo = i;
+      else
+        break;
+    }
+  } else {
+    k = num;
+  }
+
+#undef SWAP_INTERMEDIATES
+
+  qsort(list, k, sizeof(intermediate_t), compare_energy);
+}
+
+
+PRIVATE int
+compare_structure_ids(const void  *A,
+                      const void  *B)
+{
+  const struct structure_id *a, *b;
+  int                       c;
+
+  a = (const struct structure_id *)A;
+  b = (const struct structure_id *)B;
+  c = strcmp(a->structure, b->structure);
 
-  c = memcmp(a->pt, b->pt, a->pt[0] * sizeof(short));
   if (c != 0)
     return c;
 
-  if ((a->Sen - b->Sen) != 0)
-    return a->Sen - b->Sen;
+  return (a->index < b->index) ? -1 : (a->index > b->index);
+}
+
 
-  return a->curr_en - b->curr_en;
+PRIVATE int
+compare_pair_ids(const void *A,
+                 const void *B)
+{
+  const struct pair_id *a, *b;
+
+  a = (const struct pair_id *)A;
+  b = (const struct pair_id *)B;
+
+  if (a->a != b->a)
+    return (a->a < b->a) ? -1 : 1;
+
+  if (a->b != b->b)
+    return (a->b < b->b) ? -1 : 1;
+
+  return (a->index < b->index) ? -1 : (a->index > b->index);
 }
 
 
+/*
+ *  Upper bound for the saddle between structures a and b from the
+ *  paths found so far, either a direct one, or a path a -> x -> b
+ *  via some common neighbor x. The array via must be of size
+ *  n_str and filled with INT_MAX, it is restored upon return.
+ */
 PRIVATE int
-compare_energy(const void *A,
-               const void *B)
+saddle_bound(struct saddle_bound  **known,
+             unsigned int         a,
+             unsigned int         b,
+             int                  *via)
+{
+  size_t  k;
+  int     bound, en;
+
+  bound = INT_MAX;
+
+  if ((!known[a]) ||
+      (!known[b]))
+    return bound;
+
+  for (k = 0; k < vrna_array_size(known[b]); k++)
+    via[known[b][k].id] = MIN2(via[known[b][k].id], known[b][k].en);
+
+  for (k = 0; k < vrna_array_size(known[a]); k++) {
+    if (known[a][k].id == b) {
+      en = known[a][k].en;
+    } else if (via[known[a][k].id] != INT_MAX) {
+      en = MAX2(known[a][k].en, via[known[a][k].id]);
+    } else {
+      continue;
+    }
+
+    bound = MIN2(bound, en);
+  }
+
+  for (k = 0; k < vrna_array_size(known[b]); k++)
+    via[known[b][k].id] = INT_MAX;
+
+  return bound;
+}
+
+
+PRIVATE int
+compare_saddle_edges(const void *A,
+                     const void *B)
 {
-  intermediate_t *a, *b;
+  const struct saddle_edge *a, *b;
+
+  a = (const struct saddle_edge *)A;
+  b = (const struct saddle_edge *)B;
 
-  a = (intermediate_t *)A;
-  b = (intermediate_t *)B;
+  if (a->en != b->en)
+    return (a->en < b->en) ? -1 : 1;
+
+  return (a->index < b->index) ? -1 : (a->index > b->index);
+}
+
+
+PRIVATE unsigned int
+saddle_closure_root(unsigned int  *uf,
+                    unsigned int  v)
+{
+  while (uf[v] != v) {
+    uf[v] = uf[uf[v]];
+    v     = uf[v];
+  }
+
+  return v;
+}
 
-  if ((a->Sen - b->Sen) != 0)
-    return a->Sen - b->Sen;
 
-  return a->curr_en - b->curr_en;
+/*
+ *  Replace the saddle energy of each pair by the lowest saddle energy of
+ *  any path composed of paths between pairs of the batch. Every search
+ *  returns the minimum of its direct path and the bound it was given, and
+ *  every bound is the saddle of such a composed path. Thus, the minimax
+ *  path between a and b is the same regardless of the order in which the
+ *  searches finished. It is found along the minimum spanning forest of
+ *  the graph with structures as nodes and saddle energies as edge weights.
+ */
+PRIVATE void
+saddle_closure(unsigned int       n_str,
+               unsigned int       num,
+               const unsigned int *ids,
+               const unsigned int *rep,
+               int                *saddles)
+{
+  unsigned int        i, k, n_e, n_t, u, v, a, b, *uf, *deg, *adj, *parent, *depth,
+                      *stack;
+  int                 *adj_en, *up_en, en;
+  struct saddle_edge  *edges, *tree;
+
+  edges = (struct saddle_edge *)vrna_alloc(sizeof(struct saddle_edge) * num);
+
+  for (n_e = k = 0; k < num; k++) {
+    if ((rep[k] != k) ||
+        (ids[2 * k] == ids[2 * k + 1]))
+      continue;
+
+    edges[n_e].a      = ids[2 * k];
+    edges[n_e].b      = ids[2 * k + 1];
+    edges[n_e].en     = saddles[k];
+    edges[n_e].index  = k;
+    n_e++;
+  }
+
+  qsort(edges, n_e, sizeof(struct saddle_edge), compare_saddle_edges);
+
+  /* Kruskal's algorithm */
+  uf    = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_str);
+  deg   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n_str + 1));
+  tree  = (struct saddle_edge *)vrna_alloc(sizeof(struct saddle_edge) * (n_e + 1));
+
+  for (v = 0; v < n_str; v++)
+    uf[v] = v;
+
+  for (n_t = i = 0; i < n_e; i++) {
+    u = saddle_closure_root(uf, edges[i].a);
+    v = saddle_closure_root(uf, edges[i].b);
+    if (u != v) {
+      uf[u]       = v;
+      tree[n_t++] = edges[i];
+      deg[edges[i].a + 1]++;
+      deg[edges[i].b + 1]++;
+    }
+  }
+
+  /* adjacency lists of the forest */
+  for (v = 0; v < n_str; v++)
+    deg[v + 1] += deg[v];
+
+  adj     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (2 * n_t + 1));
+  adj_en  = (int *)vrna_alloc(sizeof(int) * (2 * n_t + 1));
+
+  for (i = 0; i < n_t; i++) {
+    a               = tree[i].a;
+    b               = tree[i].b;
+    adj[deg[a]]     = b;
+    adj_en[deg[a]]  = tree[i].en;
+    adj[deg[b]]     = a;
+    adj_en[deg[b]]  = tree[i].en;
+    deg[a]++;
+    deg[b]++;
+  }
+
+  /* deg[v] now marks the end of the list of v, which begins at deg[v - 1] */
+  parent  = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_str);
+  depth   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_str);
+  up_en   = (int *)vrna_alloc(sizeof(int) * n_str);
+  stack   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (n_str + 1));
+
+  for (v = 0; v < n_str; v++)
+    parent[v] = n_str;
+
+  for (v = 0; v < n_str; v++) {
+    if (parent[v] != n_str)
+      continue;
+
+    parent[v] = v;
+    stack[0]  = v;
+    k         = 1;
+    while (k > 0) {
+      u = stack[--k];
+      for (i = (u > 0) ? deg[u - 1] : 0; i < deg[u]; i++) {
+        if (parent[adj[i]] != n_str)
+          continue;
+
+        parent[adj[i]]  = u;
+        depth[adj[i]]   = depth[u] + 1;
+        up_en[adj[i]]   = adj_en[i];
+        stack[k++]      = adj[i];
+      }
+    }
+  }
+
+  /* the highest edge on the tree path between a and b */
+  for (i = 0; i < n_e; i++) {
+    a   = edges[i].a;
+    b   = edges[i].b;
+    en  = INT_MIN;
+
+    while (a != b) {
+      if (depth[a] >= depth[b]) {
+        en  = MAX2(en, up_en[a]);
+        a   = parent[a];
+      } else {
+        en  = MAX2(en, up_en[b]);
+        b   = parent[b];
+      }
+    }
+
+    saddles[edges[i].index] = MIN2(saddles[edges[i].index], en);
+  }
+
+  free(stack);
+  free(up_en);
+  free(depth);
+  free(parent);
+  free(adj_en);
+  free(adj);
+  free(tree);
+  free(deg);
+  free(uf);
+  free(edges);
 }
 
 
@@ -812,12 +1428,13 @@ compare_moves_when(const void *A,
 
 
 PRIVATE move_t *
-copy_moves(move_t *mvs)
+copy_moves(move_t *mvs,
+           int    bp_dist)
 {
   move_t *new;
 
-  new = (move_t *)vrna_alloc(sizeof(move_t) * (BP_dist + 1));
-  memcpy(new, mvs, sizeof(move_t) * (BP_dist + 1));
+  new = (move_t *)vrna_alloc(sizeof(move_t) * (bp_dist + 1));
+  memcpy(new, mvs, sizeof(move_t) * (bp_dist + 1));
   return new;
 }
 
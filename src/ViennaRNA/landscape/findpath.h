@@ -89,6 +89,48 @@ vrna_path_findpath_saddle_ub(vrna_fold_compound_t *fc,
                              int                  maxE);
 
 
+/**
+ *  @brief Find energies of saddle points for a batch of structure pairs (search only direct paths)
+ *
+ *  This function computes the saddle energies for @p num pairs of structures
+ *  @f$(s_1[i], s_2[i])@f$ as obtained by vrna_path_findpath_saddle_ub(). All searches
+ *  are independent of each other and, if the library has been compiled with OpenMP
+ *  support, are distributed among the available threads.
+ *
+ *  Pairs that share a structure are exploited to reduce the search space. Whenever paths
+ *  @f$a \rightarrow x@f$ and @f$x \rightarrow b@f$ have already been found, the higher
+ *  of their saddle energies serves as upper bound for the search between @f$a@f$ and @f$b@f$.
+ *  Identical pairs are computed only once. Each returned value is the lowest saddle energy
+ *  of any path between the two structures that is composed of the paths found for pairs
+ *  in the batch. It is never higher than the one returned by vrna_path_findpath_saddle_ub()
+ *  and does not depend on the number of threads or the order in which the searches finish.
+ *
+ *  Energy evaluations of concurrent searches share the fold compound @p fc, which is only
+ *  read once its soft constraints are prepared. If soft constraints with a user-defined
+ *  callback to prepare their data are present, the searches are performed sequentially.
+ *
+ *  @warning  Similar to vrna_path_findpath_saddle_ub(), the value @p maxE is returned for
+ *            all pairs where no path with @f$E_{saddle} < E_{max}@f$ is found.
+ *
+ *  @see  vrna_path_findpath_saddle_ub(), vrna_path_findpath_saddle()
+ *
+ *  @param fc     The #vrna_fold_compound_t with precomputed sequence encoding and model details
+ *  @param s1     The start structures in dot-bracket notation
+ *  @param s2     The target structures in dot-bracket notation
+ *  @param num    The number of structure pairs
+ *  @param width  A number specifying how many strutures are being kept at each step during the search
+ *  @param maxE   An upper bound for the saddle point energies in 10cal/mol
+ *  @returns      An array of @p num saddle energies in 10cal/mol, or NULL on any error
+ */
+int *
+vrna_path_findpath_saddle_batch(vrna_fold_compound_t  *fc,
+                                const char            **s1,
+                                const char            **s2,
+                                unsigned int          num,
+                                int                   width,
+                                int                   maxE);
+
+
 /**
  *  @brief Find refolding path between 2 structures (search only direct path)
  *
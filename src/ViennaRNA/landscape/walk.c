@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 
 #include "ViennaRNA/utils/basic.h"
@@ -22,13 +23,15 @@
 #endif
 
 #include "local_neighbors.inc"
+#include "move_energies.inc"
 
 #define DEBUG   0
 
 
 struct heap_rev_idx {
-  vrna_heap_t heap;
-  short       *pt;
+  vrna_heap_t           heap;
+  short                 *pt;
+  struct move_en_cache  *en_cache;
   size_t      *reverse_idx;
   size_t      *reverse_idx_remove;
 };
@@ -233,6 +236,9 @@ do_path(vrna_fold_compound_t  *vc,
 
   vrna_move_t *moveset = vrna_neighbors(vc, ptStartAndResultStructure, options);
 
+  /* energy changes of moves are only re-evaluated if their loops changed */
+  struct move_en_cache *en_cache = move_en_cache_init(ptStartAndResultStructure);
+
   vrna_move_t *newMoveSet = NULL;
   int         energyNeighbor;
   bool        isDeepest   = false;
@@ -249,7 +255,7 @@ do_path(vrna_fold_compound_t  *vc,
       int lowestEnergy      = 0;
       int i                 = 0;
       for (vrna_move_t *moveNeighbor = moveset; moveNeighbor->pos_5 != 0; moveNeighbor++, i++) {
-        energyNeighbor = vrna_eval_move_shift_pt(vc, moveNeighbor, ptStartAndResultStructure);
+        energyNeighbor = move_en_cache_dG(vc, en_cache, moveNeighbor);
         if (energyNeighbor <= lowestEnergy) {
           /* make the walk unique */
           if ((energyNeighbor == lowestEnergy) &&
@@ -275,7 +281,7 @@ do_path(vrna_fold_compound_t  *vc,
         length++;
       int index = rand() % length;
       m               = moveset[index];
-      energyNeighbor  = vrna_eval_move_shift_pt(vc, &m, ptStartAndResultStructure);
+      energyNeighbor  = move_en_cache_dG(vc, en_cache, &m);
       iterations--;
     }
 
@@ -308,6 +314,7 @@ do_path(vrna_fold_compound_t  *vc,
 
     /* adjust pt for next round */
     vrna_move_apply(ptStartAndResultStructure, &m);
+    move_en_cache_apply(en_cache, &m);
     energy += energyNeighbor;
 
     /* alternative neighbor generation
@@ -317,6 +324,8 @@ do_path(vrna_fold_compound_t  *vc,
      */
   }
 
+  move_en_cache_free(en_cache);
+
   if (!(options & VRNA_PATH_NO_TRANSITION_OUTPUT)) {
     vrna_move_t end = {
       0, 0
@@ -380,6 +389,7 @@ gradient_descent_data(size_t  n,
 PRIVATE void
 gradient_descent_data_free(struct heap_rev_idx *d)
 {
+  move_en_cache_free(d->en_cache);
   free(d->reverse_idx);
   free(d->reverse_idx_remove);
   free(d);
@@ -460,7 +470,7 @@ gradient_descent_update_cb(vrna_fold_compound_t *fc,
       break;
 
     case VRNA_NEIGHBOR_NEW:
-      dG = vrna_eval_move_pt(fc, lookup->pt, neighbor.pos_5, neighbor.pos_3);
+      dG = move_en_cache_dG(fc, lookup->en_cache, &neighbor);
       if (dG <= 0) {
         mm = move_en_init(neighbor, dG);
         vrna_heap_insert(h, mm);
@@ -469,7 +479,7 @@ gradient_descent_update_cb(vrna_fold_compound_t *fc,
       break;
 
     case VRNA_NEIGHBOR_CHANGE:
-      dG = vrna_eval_move_pt(fc, lookup->pt, neighbor.pos_5, neighbor.pos_3);
+      dG = move_en_cache_dG(fc, lookup->en_cache, &neighbor);
       if (dG <= 0) {
         mm = move_en_init(neighbor, dG);
         free(vrna_heap_update(h, mm));
@@ -516,8 +526,10 @@ gradient_descent(vrna_fold_compound_t *fc,
                            (void *)lookup);
   lookup->heap = h;
 
+  lookup->en_cache = move_en_cache_init(pt);
+
   for (i = 0; neighbors[i].pos_5 != 0; i++) {
-    dG = vrna_eval_move_pt(fc, pt, neighbors[i].pos_5, neighbors[i].pos_3);
+    dG = move_en_cache_dG(fc, lookup->en_cache, &(neighbors[i]));
     if (dG <= 0) {
       struct move_en *mm = move_en_init(neighbors[i], dG);
       vrna_heap_insert(h, mm);
@@ -538,6 +550,9 @@ gradient_descent(vrna_fold_compound_t *fc,
         ((dG == 0) && vrna_move_is_removal(&(next_move))))
       break;
 
+    /* update loops such that the callback sees energies of the new structure */
+    move_en_cache_apply(lookup->en_cache, &next_move);
+
     vrna_move_neighbor_diff_cb(fc,
                                pt,
                                next_move,
@@ -155,6 +155,19 @@ vrna_exp_E_ext_fast(vrna_fold_compound_t  *fc,
                     vrna_mx_pf_aux_el_t   aux_mx);
 
 
+/**
+ *  @brief  Only advance the auxiliary arrays for segment @f$ [i,j] @f$
+ *
+ *  This is the cheap counterpart of vrna_exp_E_ext_fast() for segments whose
+ *  partition function is already known, e.g. in incremental re-computations.
+ */
+void
+vrna_exp_E_ext_fast_aux(vrna_fold_compound_t  *fc,
+                        int                   i,
+                        int                   j,
+                        vrna_mx_pf_aux_el_t   aux_mx);
+
+
 void
 vrna_exp_E_ext_fast_update(vrna_fold_compound_t *fc,
                            int                  j,
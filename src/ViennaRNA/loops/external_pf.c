@@ -85,6 +85,16 @@ split_ext_fast(vrna_fold_compound_t       *fc,
                struct sc_ext_exp_dat      *sc_wrapper);
 
 
+PRIVATE INLINE FLT_OR_DBL
+reduce_ext_qq_fast(vrna_fold_compound_t       *fc,
+                   int                        i,
+                   int                        j,
+                   struct vrna_mx_pf_aux_el_s *aux_mx,
+                   vrna_hc_eval_f  evaluate,
+                   struct hc_ext_def_dat      *hc_dat_local,
+                   struct sc_ext_exp_dat      *sc_wrapper);
+
+
 PRIVATE FLT_OR_DBL
 exp_E_ext_fast(vrna_fold_compound_t       *fc,
                int                        i,
@@ -284,6 +294,31 @@ vrna_exp_E_ext_fast(vrna_fold_compound_t        *fc,
 }
 
 
+PUBLIC void
+vrna_exp_E_ext_fast_aux(vrna_fold_compound_t        *fc,
+                        int                         i,
+                        int                         j,
+                        struct vrna_mx_pf_aux_el_s  *aux_mx)
+{
+  vrna_hc_eval_f        evaluate;
+  struct hc_ext_def_dat hc_dat_local;
+  struct sc_ext_exp_dat sc_wrapper;
+
+  if ((fc) && (aux_mx)) {
+    if (fc->hc->type == VRNA_HC_WINDOW)
+      evaluate = prepare_hc_ext_def_window(fc, &hc_dat_local);
+    else
+      evaluate = prepare_hc_ext_def(fc, &hc_dat_local);
+
+    init_sc_ext_exp(fc, &sc_wrapper);
+
+    (void)reduce_ext_qq_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_ext_exp(&sc_wrapper);
+  }
+}
+
+
 PUBLIC void
 vrna_exp_E_ext_fast_update(vrna_fold_compound_t       *fc,
                            int                        j,
@@ -579,42 +614,32 @@ split_ext_fast(vrna_fold_compound_t       *fc,
 }
 
 
-PRIVATE FLT_OR_DBL
-exp_E_ext_fast(vrna_fold_compound_t       *fc,
-               int                        i,
-               int                        j,
-               struct vrna_mx_pf_aux_el_s *aux_mx)
+PRIVATE INLINE FLT_OR_DBL
+reduce_ext_qq_fast(vrna_fold_compound_t       *fc,
+                   int                        i,
+                   int                        j,
+                   struct vrna_mx_pf_aux_el_s *aux_mx,
+                   vrna_hc_eval_f  evaluate,
+                   struct hc_ext_def_dat      *hc_dat_local,
+                   struct sc_ext_exp_dat      *sc_wrapper)
 {
-  int                       *iidx, ij, with_ud, with_gquad;
-  FLT_OR_DBL                qbt1, *qq, **qqu, *G, **G_local;
-  vrna_md_t                 *md;
-  vrna_exp_param_t          *pf_params;
-  vrna_ud_t                 *domains_up;
-  vrna_hc_eval_f evaluate;
-  struct hc_ext_def_dat     hc_dat_local;
-  struct sc_ext_exp_dat     sc_wrapper;
+  int                 with_ud, with_gquad;
+  FLT_OR_DBL          qbt1, *qq, **qqu, **G_local;
+  vrna_gquad_index_t  *G;
+  vrna_ud_t           *domains_up;
 
   qq          = aux_mx->qq;
   qqu         = aux_mx->qqu;
-  pf_params   = fc->exp_params;
-  md          = &(pf_params->model_details);
   domains_up  = fc->domains_up;
-  with_gquad  = md->gquad;
+  with_gquad  = fc->exp_params->model_details.gquad;
   with_ud     = (domains_up && domains_up->exp_energy_cb);
 
-  if (fc->hc->type == VRNA_HC_WINDOW) // not into
-    evaluate = prepare_hc_ext_def_window(fc, &hc_dat_local);
-  else
-    evaluate = prepare_hc_ext_def(fc, &hc_dat_local);
-
-  init_sc_ext_exp(fc, &sc_wrapper);
-
   qbt1 = 0.;
 
   /* all exterior loop parts [i, j] with exactly one stem (i, u) i < u < j */
-  qbt1 += reduce_ext_ext_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += reduce_ext_ext_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
   /* exterior loop part with stem (i, j) */
-  qbt1 += reduce_ext_stem_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += reduce_ext_stem_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
 
   if (with_gquad) {
     if (fc->hc->type == VRNA_HC_WINDOW) {
@@ -622,9 +647,7 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
       qbt1    += G_local[i][j];
     } else {
       G     = fc->exp_matrices->G;
-      iidx  = fc->iindx;
-      ij    = iidx[i] - j;
-      qbt1  += G[ij];
+      qbt1  += vrna_gquad_index_weight(G, i, j);
     }
   }
 
@@ -633,6 +656,31 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
   if (with_ud)
     qqu[0][i] = qbt1;
 
+  return qbt1;
+}
+
+
+PRIVATE FLT_OR_DBL
+exp_E_ext_fast(vrna_fold_compound_t       *fc,
+               int                        i,
+               int                        j,
+               struct vrna_mx_pf_aux_el_s *aux_mx)
+{
+  FLT_OR_DBL                qbt1;
+  vrna_hc_eval_f evaluate;
+  struct hc_ext_def_dat     hc_dat_local;
+  struct sc_ext_exp_dat     sc_wrapper;
+
+  if (fc->hc->type == VRNA_HC_WINDOW) // not into
+    evaluate = prepare_hc_ext_def_window(fc, &hc_dat_local);
+  else
+    evaluate = prepare_hc_ext_def(fc, &hc_dat_local);
+
+  init_sc_ext_exp(fc, &sc_wrapper);
+
+  /* all exterior loop parts [i, j] with a stem starting at i */
+  qbt1 = reduce_ext_qq_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
   /* the entire stretch [i,j] is unpaired */
   qbt1 += reduce_ext_up_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
 
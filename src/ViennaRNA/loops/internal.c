@@ -365,10 +365,11 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                 int                   i,
                 int                   j)
 {
-  unsigned char         sliding_window, hc_decompose, *hc_mx, **hc_mx_local;
+  unsigned char         sliding_window, hc_decompose, **hc_mx_local;
+  vrna_hc_t             *hc;
   char                  *ptype, **ptype_local;
   short                 *S, **SS, **S5, **S3;
-  unsigned int          *sn, **a2s, n_seq, s, n;
+  unsigned int          *sn, **a2s, n_seq, s;
   int                   e, eee, *idx, ij, *c, *ggg, *rtype, with_ud, with_gquad, noclose,
                         *hc_up, **c_local, **ggg_local;
   vrna_param_t          *P;
@@ -383,13 +384,12 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
   e = INF;
 
-  n               = fc->length;
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   sn              = fc->strand_number;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   idx             = fc->jindx;
   ij              = (sliding_window) ? 0 : idx[j] + i;
-  hc_mx           = (sliding_window) ? NULL : fc->hc->mx;
+  hc              = fc->hc;
   hc_mx_local     = (sliding_window) ? fc->hc->matrix_local : NULL;
   hc_up           = fc->hc->up_int;
   ptype           = (fc->type == VRNA_FC_TYPE_SINGLE) ? (sliding_window ? NULL : fc->ptype) : NULL;
@@ -411,11 +411,12 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   with_ud     = ((domains_up) && (domains_up->energy_cb)) ? 1 : 0;
   with_gquad  = md->gquad;
 
-  hc_decompose = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
+  hc_decompose = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_context(hc, i, j);
 
   if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     unsigned int  type, type2, has_nick, *tt;
-    int           k, l, kl, last_k, first_l, u1, u2, noGUclosure;
+    int           k, l, kl, last_k, first_l, u1, u2, noGUclosure, sc_flat,
+                  sc5[MAXLOOP + 1], sc3[MAXLOOP + 1];
 
     has_nick    = sn[i] != sn[j] ? 1 : 0;
     noGUclosure = md->noGUclosure;
@@ -440,7 +441,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
     l = j - 1;
     if (k < l) {
       kl            = (sliding_window) ? 0 : idx[l] + k;
-      hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[n * k + l];
+      hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
       if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
           (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -494,6 +495,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
     if (!noclose) {
       /* only proceed if the enclosing pair is allowed */
+      sc_flat = sc_int_flat(i, j, &sc_wrapper, sc5, sc3);
 
       /* handle bulges in 5' side */
       l = j - 1;
@@ -511,10 +513,8 @@ E_internal_loop(vrna_fold_compound_t  *fc,
         k   = i + 2;
         kl  = (sliding_window) ? 0 : idx[l] + k;
 
-        hc_mx += n * l;
-
         for (; k <= last_k; k++, u1++, kl++) {
-          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
+          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -564,7 +564,9 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                   break;
               }
 
-              if (sc_wrapper.pair)
+              if (sc_flat)
+                eee += sc5[u1] + sc3[0];
+              else if (sc_wrapper.pair)
                 eee += sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
               e = MIN2(e, eee);
@@ -580,7 +582,6 @@ E_internal_loop(vrna_fold_compound_t  *fc,
           }
         }
 
-        hc_mx -= n * l;
       }
 
       /* handle bulges in 3' side */
@@ -591,14 +592,12 @@ E_internal_loop(vrna_fold_compound_t  *fc,
           first_l = j - 1 - MAXLOOP;
 
         u2    = 1;
-        hc_mx += n * k;
-
         for (l = j - 2; l >= first_l; l--, u2++) {
           if (u2 > hc_up[l + 1])
             break;
 
           kl            = (sliding_window) ? 0 : idx[l] + k;
-          hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[l];
+          hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -648,7 +647,9 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                   break;
               }
 
-              if (sc_wrapper.pair)
+              if (sc_flat)
+                eee += sc5[0] + sc3[u2];
+              else if (sc_wrapper.pair)
                 eee += sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
               e = MIN2(e, eee);
@@ -664,7 +665,6 @@ E_internal_loop(vrna_fold_compound_t  *fc,
           }
         }
 
-        hc_mx -= n * k;
       }
 
       /* last but not least, all other internal loops */
@@ -689,10 +689,8 @@ E_internal_loop(vrna_fold_compound_t  *fc,
         k   = i + 2;
         kl  = (sliding_window) ? 0 : idx[l] + k;
 
-        hc_mx += n * l;
-
         for (; k <= last_k; k++, u1++, kl++) {
-          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
+          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -750,7 +748,9 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                   break;
               }
 
-              if (sc_wrapper.pair)
+              if (sc_flat)
+                eee += sc5[u1] + sc3[u2];
+              else if (sc_wrapper.pair)
                 eee += sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
               e = MIN2(e, eee);
@@ -775,7 +775,6 @@ E_internal_loop(vrna_fold_compound_t  *fc,
           }
         }
 
-        hc_mx -= n * l;
       }
 
       if (with_gquad) {
@@ -840,7 +839,8 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
 {
   int                   q, p, e, s, u1, u2, qmin, energy,
                         n, *indx, *hc_up, *c, n_seq;
-  unsigned char         *hc, eval_loop;
+  unsigned char         eval_loop;
+  vrna_hc_t             *hc;
   unsigned int          *tt;
   short                 **SS;
   vrna_md_t             *md;
@@ -853,7 +853,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
   SS    = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   indx  = fc->jindx;
   c     = fc->matrices->c;
-  hc    = fc->hc->mx;
+  hc    = fc->hc;
   hc_up = fc->hc->up_int;
   P     = fc->params;
   md    = &(P->model_details);
@@ -864,7 +864,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
   evaluate = prepare_hc_int_def(fc, &hc_dat_local);
 
   /* CONSTRAINED INTERIOR LOOP start */
-  if (hc[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     /* prepare necessary variables */
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE) {
       tt = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
@@ -895,7 +895,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
 
         int pq = indx[q] + p;
 
-        eval_loop = hc[n * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
+        eval_loop = vrna_hc_context(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
 
         if (eval_loop && evaluate(i, j, p, q, &hc_dat_local)) {
           energy = c[pq];
@@ -927,10 +927,11 @@ E_stack(vrna_fold_compound_t  *fc,
         int                   j)
 {
   unsigned char         sliding_window, hc_decompose_ij, hc_decompose_pq,
-                        *hc_mx, **hc_mx_local, eval_loop;
+                        **hc_mx_local, eval_loop;
   char                  *ptype, **ptype_local;
   short                 **SS;
-  unsigned int          n, *sn, type, type_2;
+  unsigned int          *sn, type, type_2;
+  vrna_hc_t             *hc;
   int                   e, ij, pq, p, q, s, n_seq, *rtype, *indx;
   vrna_param_t          *P;
   vrna_md_t             *md;
@@ -940,7 +941,6 @@ E_stack(vrna_fold_compound_t  *fc,
 
   e               = INF;
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
-  n               = fc->length;
   p               = i + 1;
   q               = j - 1;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
@@ -956,7 +956,7 @@ E_stack(vrna_fold_compound_t  *fc,
   md          = &(P->model_details);
   rtype       = &(md->rtype[0]);
   indx        = (sliding_window) ? NULL : fc->jindx;
-  hc_mx       = (sliding_window) ? NULL : fc->hc->mx;
+  hc          = fc->hc;
   hc_mx_local = (sliding_window) ? fc->hc->matrix_local : NULL;
   ij          = (sliding_window) ? 0 : indx[j] + i;
   pq          = (sliding_window) ? 0 : indx[q] + p;
@@ -964,8 +964,8 @@ E_stack(vrna_fold_compound_t  *fc,
 
   init_sc_int(fc, &sc_wrapper);
 
-  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
-  hc_decompose_pq = (sliding_window) ? hc_mx_local[p][q - p] : hc_mx[n * p + q];
+  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_context(hc, i, j);
+  hc_decompose_pq = (sliding_window) ? hc_mx_local[p][q - p] : vrna_hc_context(hc, p, q);
 
   eval_loop = (hc_decompose_ij & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
               (hc_decompose_pq & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC);
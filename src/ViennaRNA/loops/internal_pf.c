@@ -107,12 +107,14 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
 {
   unsigned char         sliding_window, hc_decompose_ij, hc_decompose_kl;
   char                  *ptype, **ptype_local;
-  unsigned char         *hc_mx, **hc_mx_local;
+  unsigned char         **hc_mx_local;
   short                 *S1, **SS, **S5, **S3;
-  unsigned int          *sn, *se, *ss, n_seq, s, **a2s, n;
+  vrna_hc_t             *hc;
+  unsigned int          *sn, *se, *ss, n_seq, s, **a2s;
   int                   *rtype, noclose, *my_iindx, *jindx, *hc_up, ij,
                         with_gquad, with_ud;
-  FLT_OR_DBL            qbt1, q_temp, *qb, **qb_local, *G, *scale;
+  FLT_OR_DBL            qbt1, q_temp, *qb, **qb_local, *scale;
+  vrna_gquad_index_t    *G;
   vrna_exp_param_t      *pf_params;
   vrna_md_t             *md;
   vrna_ud_t             *domains_up;
@@ -121,7 +123,6 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
   struct sc_int_exp_dat sc_wrapper;
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
-  n               = fc->length;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   sn              = fc->strand_number;
   se              = fc->strand_end;
@@ -140,7 +141,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
   scale       = fc->exp_matrices->scale;
   my_iindx    = fc->iindx;
   jindx       = fc->jindx;
-  hc_mx       = (sliding_window) ? NULL : fc->hc->mx;
+  hc          = fc->hc;
   hc_mx_local = (sliding_window) ? fc->hc->matrix_local : NULL;
   hc_up       = fc->hc->up_int;
   pf_params   = fc->exp_params;
@@ -156,12 +157,13 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
 
   ij = (sliding_window) ? 0 : jindx[j] + i;
 
-  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
+  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_context(hc, i, j);
 
   /* CONSTRAINED INTERIOR LOOP start */
   if (hc_decompose_ij & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     unsigned int  type, type2, *tt;
-    int           k, l, kl, last_k, first_l, u1, u2, noGUclosure;
+    int           k, l, kl, last_k, first_l, u1, u2, noGUclosure, sc_flat;
+    FLT_OR_DBL    sc5[MAXLOOP + 1], sc3[MAXLOOP + 1];
 
     noGUclosure = md->noGUclosure;
     tt          = NULL;
@@ -185,7 +187,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
     l = j - 1;
     if ((k < l) && (sn[i] == sn[k]) && (sn[l] == sn[j])) {
       kl              = (sliding_window) ? 0 : jindx[l] + k;
-      hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[n * k + l];
+      hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
       if ((hc_decompose_kl & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
           (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -235,6 +237,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
 
     if (!noclose) {
       /* only proceed if the enclosing pair is allowed */
+      sc_flat = sc_int_exp_flat(i, j, &sc_wrapper, sc5, sc3);
 
       /* handle bulges in 5' side */
       l = j - 1;
@@ -254,10 +257,8 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
 
         k     = i + 2;
         kl    = (sliding_window) ? 0 : jindx[l] + k;
-        hc_mx += n * l;
-
         for (; k <= last_k; k++, u1++, kl++) {
-          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
+          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose_kl & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -301,7 +302,9 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                 break;
             }
 
-            if (sc_wrapper.pair)
+            if (sc_flat)
+              q_temp *= sc5[u1] * sc3[0];
+            else if (sc_wrapper.pair)
               q_temp *= sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
             qbt1 += q_temp *
@@ -318,7 +321,6 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
           }
         }
 
-        hc_mx -= n * l;
       }
 
       /* handle bulges in 3' side */
@@ -332,14 +334,12 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
           first_l = ss[sn[j]];
 
         u2    = 1;
-        hc_mx += n * k;
-
         for (l = j - 2; l >= first_l; l--, u2++) {
           if (u2 > hc_up[l + 1])
             break;
 
           kl              = (sliding_window) ? 0 : jindx[l] + k;
-          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[l];
+          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose_kl & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -383,7 +383,9 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                 break;
             }
 
-            if (sc_wrapper.pair)
+            if (sc_flat)
+              q_temp *= sc5[0] * sc3[u2];
+            else if (sc_wrapper.pair)
               q_temp *= sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
             qbt1 += q_temp *
@@ -400,7 +402,6 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
           }
         }
 
-        hc_mx -= n * k;
       }
 
       /* last but not least, all other internal loops */
@@ -428,14 +429,12 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
 
         u2 = 1;
 
-        hc_mx += n * k;
-
         for (l = j - 2; l >= first_l; l--, u2++) {
           if (hc_up[l + 1] < u2)
             break;
 
           kl              = (sliding_window) ? 0 : jindx[l] + k;
-          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[l];
+          hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
 
           if ((hc_decompose_kl & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -481,7 +480,9 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                 break;
             }
 
-            if (sc_wrapper.pair)
+            if (sc_flat)
+              q_temp *= sc5[u1] * sc3[u2];
+            else if (sc_wrapper.pair)
               q_temp *= sc_wrapper.pair(i, j, k, l, &sc_wrapper);
 
             qbt1 += q_temp *
@@ -513,7 +514,6 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
           }
         }
 
-        hc_mx -= n * k;
       }
 
       if ((with_gquad) && (!noclose)) {
@@ -522,7 +522,7 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
             if (sliding_window) {
               /* no G-Quadruplex support for sliding window partition function yet! */
             } else if (sn[j] == sn[i]) {
-              qbt1 += exp_E_GQuad_IntLoop(i, j, type, S1, G, scale, my_iindx, pf_params);
+              qbt1 += exp_E_GQuad_IntLoop(i, j, type, S1, G, scale, pf_params);
             }
 
             break;
@@ -537,7 +537,6 @@ exp_E_int_loop(vrna_fold_compound_t *fc,
                                                       S5, S3, a2s,
                                                       G,
                                                       scale,
-                                                      my_iindx,
                                                       (int)n_seq,
                                                       pf_params);
             }
@@ -561,8 +560,9 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
                    int                  i,
                    int                  j)
 {
-  unsigned char         *hc_mx, eval_loop;
+  unsigned char         eval_loop;
   short                 *S, *S2, **SS, **S5, **S3;
+  vrna_hc_t             *hc;
   unsigned int          *tt, n_seq, s, **a2s, type, type2;
   int                   k, l, u1, u2, u3, qmin, with_ud,
                         n, *my_iindx, *hc_up,
@@ -586,7 +586,7 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
   my_iindx    = fc->iindx;
   qb          = fc->exp_matrices->qb;
   scale       = fc->exp_matrices->scale;
-  hc_mx       = fc->hc->mx;
+  hc          = fc->hc;
   hc_up       = fc->hc->up_int;
   pf_params   = fc->exp_params;
   md          = &(pf_params->model_details);
@@ -602,7 +602,7 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
   init_sc_int_exp(fc, &sc_wrapper);
 
   /* CONSTRAINED INTERIOR LOOP start */
-  if (hc_mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     /* prepare necessary variables */
     if (fc->type == VRNA_FC_TYPE_SINGLE) {
       type = vrna_get_ptype_md(S2[j], S2[i], md);
@@ -634,7 +634,7 @@ exp_E_ext_int_loop(vrna_fold_compound_t *fc,
         if (u1 + u2 + u3 > MAXLOOP)
           continue;
 
-        eval_loop = hc_mx[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
+        eval_loop = vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
 
         if (eval_loop && evaluate(i, j, k, l, &hc_dat_local)) {
           q_temp = qb[my_iindx[k] - l];
@@ -735,9 +735,10 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
 {
   unsigned char         sliding_window, type, type2;
   char                  *ptype, **ptype_local;
-  unsigned char         *hc_mx, **hc_mx_local, eval_loop, hc_decompose_ij, hc_decompose_kl;
+  unsigned char         **hc_mx_local, eval_loop, hc_decompose_ij, hc_decompose_kl;
   short                 *S1, **SS, **S5, **S3;
-  unsigned int          n, *sn, n_seq, s, **a2s;
+  vrna_hc_t             *hc;
+  unsigned int          *sn, n_seq, s, **a2s;
   int                   u1, u2, *rtype, *jindx, *hc_up;
   FLT_OR_DBL            qbt1, q_temp, *scale;
   vrna_exp_param_t      *pf_params;
@@ -748,7 +749,6 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
   struct sc_int_exp_dat sc_wrapper;
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
-  n               = fc->length;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   ptype           = (fc->type == VRNA_FC_TYPE_SINGLE) ? (sliding_window ? NULL : fc->ptype) : NULL;
   ptype_local     =
@@ -759,7 +759,7 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
   jindx       = fc->jindx;
-  hc_mx       = (sliding_window) ? NULL : fc->hc->mx;
+  hc          = fc->hc;
   hc_mx_local = (sliding_window) ? fc->hc->matrix_local : NULL;
   hc_up       = fc->hc->up_int;
   pf_params   = fc->exp_params;
@@ -785,8 +785,8 @@ exp_E_interior_loop(vrna_fold_compound_t  *fc,
 
   init_sc_int_exp(fc, &sc_wrapper);
 
-  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
-  hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[n * k + l];
+  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_context(hc, i, j);
+  hc_decompose_kl = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_context(hc, k, l);
   eval_loop       = ((hc_decompose_ij & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
                      (hc_decompose_kl & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC)) ?
                     1 : 0;
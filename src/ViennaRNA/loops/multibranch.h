@@ -131,6 +131,19 @@ vrna_exp_E_ml_fast(vrna_fold_compound_t *fc,
                    vrna_mx_pf_aux_ml_t  aux_mx);
 
 
+/**
+ *  @brief  Advance the auxiliary helper arrays for segment @f$ [i,j] @f$ without computing its multibranch loop contribution
+ *
+ *  Use this function instead of vrna_exp_E_ml_fast() for segments whose
+ *  contributions are already known, e.g. in incremental re-computations.
+ */
+void
+vrna_exp_E_ml_fast_aux(vrna_fold_compound_t *fc,
+                       int                  i,
+                       int                  j,
+                       vrna_mx_pf_aux_ml_t  aux_mx);
+
+
 /* End partition function interface */
 /**@}*/
 
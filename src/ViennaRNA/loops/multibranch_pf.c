@@ -57,6 +57,16 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
               struct vrna_mx_pf_aux_ml_s  *aux_mx);
 
 
+PRIVATE INLINE void
+ml_fast_qqm(vrna_fold_compound_t        *fc,
+            int                         i,
+            int                         j,
+            struct vrna_mx_pf_aux_ml_s  *aux_mx,
+            vrna_hc_eval_f              evaluate,
+            struct hc_mb_def_dat        *hc_dat_local,
+            struct sc_mb_exp_dat        *sc_wrapper);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -92,6 +102,27 @@ vrna_exp_E_ml_fast(vrna_fold_compound_t       *fc,
 }
 
 
+PUBLIC void
+vrna_exp_E_ml_fast_aux(vrna_fold_compound_t       *fc,
+                       int                        i,
+                       int                        j,
+                       struct vrna_mx_pf_aux_ml_s *aux_mx)
+{
+  vrna_hc_eval_f        evaluate;
+  struct hc_mb_def_dat  hc_dat_local;
+  struct sc_mb_exp_dat  sc_wrapper;
+
+  if ((fc) && (aux_mx)) {
+    evaluate = prepare_hc_mb_def(fc, &hc_dat_local);
+    init_sc_mb_exp(fc, &sc_wrapper);
+
+    ml_fast_qqm(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_mb_exp(&sc_wrapper);
+  }
+}
+
+
 PUBLIC struct vrna_mx_pf_aux_ml_s *
 vrna_exp_E_ml_fast_init(vrna_fold_compound_t *fc)
 {
@@ -377,71 +408,63 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
 }
 
 
-PRIVATE FLT_OR_DBL
-exp_E_ml_fast(vrna_fold_compound_t        *fc,
-              int                         i,
-              int                         j,
-              struct vrna_mx_pf_aux_ml_s  *aux_mx)
+/*
+ *  Compute qqm[i] for segment [i, j], i.e. the contributions where
+ *  i pairs with some l <= j and [l + 1, j] is unpaired
+ */
+PRIVATE INLINE void
+ml_fast_qqm(vrna_fold_compound_t        *fc,
+            int                         i,
+            int                         j,
+            struct vrna_mx_pf_aux_ml_s  *aux_mx,
+            vrna_hc_eval_f              evaluate,
+            struct hc_mb_def_dat        *hc_dat_local,
+            struct sc_mb_exp_dat        *sc_wrapper)
 {
-  unsigned char             sliding_window;
-  short                     *S1, *S2, **SS, **S5, **S3;
-  unsigned int              *sn, *ss, *se, n_seq, s;
-  int                       n, *iidx, k, ij, kl, maxk, ii, with_ud, u, circular, with_gquad,
-                            *hc_up_ml, type;
-  FLT_OR_DBL                qbt1, temp, *qm, *qb, *qqm, *qqm1, **qqmu, q_temp, q_temp2, *G,
-                            *expMLbase, **qb_local, **qm_local, **G_local;
-  vrna_md_t                 *md;
-  vrna_exp_param_t          *pf_params;
-  vrna_ud_t                 *domains_up;
-  vrna_hc_t                 *hc;
-  vrna_hc_eval_f evaluate;
-  struct hc_mb_def_dat      hc_dat_local;
-  struct sc_mb_exp_dat      sc_wrapper;
+  unsigned char       sliding_window;
+  short               *S1, *S2, **SS, **S5, **S3;
+  unsigned int        n_seq, s;
+  int                 n, ij, u, circular, with_gquad, with_ud, type;
+  FLT_OR_DBL          qbt1, q_temp, q_temp2, *qb, *qqm, *qqm1, **qqmu, *expMLbase,
+                      **qb_local, **G_local;
+  vrna_gquad_index_t  *G;
+  vrna_md_t           *md;
+  vrna_exp_param_t    *pf_params;
+  vrna_ud_t           *domains_up;
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n               = (int)fc->length;
-  sn              = fc->strand_number;
-  ss              = fc->strand_start;
-  se              = fc->strand_end;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   S5              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
-  iidx            = (sliding_window) ? NULL : fc->iindx;
-  ij              = (sliding_window) ? 0 : iidx[i] - j;
+  ij              = (sliding_window) ? 0 : fc->iindx[i] - j;
   qqm             = aux_mx->qqm;
   qqm1            = aux_mx->qqm1;
   qqmu            = aux_mx->qqmu;
-  qm              = (sliding_window) ? NULL : fc->exp_matrices->qm;
   qb              = (sliding_window) ? NULL : fc->exp_matrices->qb;
   G               = (sliding_window) ? NULL : fc->exp_matrices->G;
-  qm_local        = (sliding_window) ? fc->exp_matrices->qm_local : NULL;
   qb_local        = (sliding_window) ? fc->exp_matrices->qb_local : NULL;
   G_local         = (sliding_window) ? fc->exp_matrices->G_local : NULL;
   expMLbase       = fc->exp_matrices->expMLbase;
   pf_params       = fc->exp_params;
   md              = &(pf_params->model_details);
-  hc              = fc->hc;
   domains_up      = fc->domains_up;
   circular        = md->circ;
   with_gquad      = md->gquad;
   with_ud         = (domains_up && domains_up->exp_energy_cb);
-  hc_up_ml        = hc->up_ml;
-  evaluate        = prepare_hc_mb_def(fc, &hc_dat_local);
-
-  init_sc_mb_exp(fc, &sc_wrapper);
 
   qbt1    = 0;
   q_temp  = 0.;
 
   qqm[i] = 0.;
 
-  if (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
+  if (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_ML, hc_dat_local)) {
     q_temp = qqm1[i] *
              expMLbase[1];
 
-    if (sc_wrapper.red_ml)
-      q_temp *= sc_wrapper.red_ml(i, j, i, j - 1, &sc_wrapper);
+    if (sc_wrapper->red_ml)
+      q_temp *= sc_wrapper->red_ml(i, j, i, j - 1, sc_wrapper);
 
     qqm[i] += q_temp;
   }
@@ -453,7 +476,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     for (cnt = 0; cnt < domains_up->uniq_motif_count; cnt++) {
       u = domains_up->uniq_motif_size[cnt];
       if (j - u >= i) {
-        if (evaluate(i, j, i, j - u, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
+        if (evaluate(i, j, i, j - u, VRNA_DECOMP_ML_ML, hc_dat_local)) {
           q_temp2 = qqmu[u][i] *
                     domains_up->exp_energy_cb(fc,
                                               j - u + 1,
@@ -463,8 +486,8 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
                                               domains_up->data) *
                     expMLbase[u];
 
-          if (sc_wrapper.red_ml)
-            q_temp2 *= sc_wrapper.red_ml(i, j, i, j - u, &sc_wrapper);
+          if (sc_wrapper->red_ml)
+            q_temp2 *= sc_wrapper->red_ml(i, j, i, j - u, sc_wrapper);
 
           q_temp += q_temp2;
         }
@@ -474,7 +497,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     qqm[i] += q_temp;
   }
 
-  if (evaluate(i, j, i, j, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
+  if (evaluate(i, j, i, j, VRNA_DECOMP_ML_STEM, hc_dat_local)) {
     qbt1 = (sliding_window) ? qb_local[i][j] : qb[ij];
 
     switch (fc->type) {
@@ -503,20 +526,57 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
         break;
     }
 
-    if (sc_wrapper.red_stem)
-      qbt1 *= sc_wrapper.red_stem(i, j, i, j, &sc_wrapper);
+    if (sc_wrapper->red_stem)
+      qbt1 *= sc_wrapper->red_stem(i, j, i, j, sc_wrapper);
 
     qqm[i] += qbt1;
   }
 
   if (with_gquad) {
-    q_temp  = (sliding_window) ? G_local[i][j] : G[ij];
+    q_temp  = (sliding_window) ? G_local[i][j] : vrna_gquad_index_weight(G, i, j);
     qqm[i]  += q_temp *
                pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq);
   }
 
   if (with_ud)
     qqmu[0][i] = qqm[i];
+}
+
+
+PRIVATE FLT_OR_DBL
+exp_E_ml_fast(vrna_fold_compound_t        *fc,
+              int                         i,
+              int                         j,
+              struct vrna_mx_pf_aux_ml_s  *aux_mx)
+{
+  unsigned char             sliding_window;
+  unsigned int              *sn, *ss, *se;
+  int                       *iidx, k, kl, maxk, ii, with_ud, *hc_up_ml;
+  FLT_OR_DBL                temp, *qm, *qqm, *expMLbase, **qm_local;
+  vrna_ud_t                 *domains_up;
+  vrna_hc_t                 *hc;
+  vrna_hc_eval_f evaluate;
+  struct hc_mb_def_dat      hc_dat_local;
+  struct sc_mb_exp_dat      sc_wrapper;
+
+  sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
+  sn              = fc->strand_number;
+  ss              = fc->strand_start;
+  se              = fc->strand_end;
+  iidx            = (sliding_window) ? NULL : fc->iindx;
+  qqm             = aux_mx->qqm;
+  qm              = (sliding_window) ? NULL : fc->exp_matrices->qm;
+  qm_local        = (sliding_window) ? fc->exp_matrices->qm_local : NULL;
+  expMLbase       = fc->exp_matrices->expMLbase;
+  hc              = fc->hc;
+  domains_up      = fc->domains_up;
+  with_ud         = (domains_up && domains_up->exp_energy_cb);
+  hc_up_ml        = hc->up_ml;
+  evaluate        = prepare_hc_mb_def(fc, &hc_dat_local);
+
+  init_sc_mb_exp(fc, &sc_wrapper);
+
+  ml_fast_qqm(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
 
   /*
    *  construction of qm matrix containing multiple loop
@@ -350,7 +350,7 @@ PRIVATE int
 fill_arrays(vrna_fold_compound_t  *fc,
             struct ms_helpers     *ms_dat)
 {
-  unsigned int      *sn;
+  unsigned int      *sn, dirty_i, dirty_j;
   int               i, j, ij, length, uniq_ML, *indx, *f5, *c, *fML, *fM1;
   vrna_param_t      *P;
   vrna_md_t         *md;
@@ -371,6 +371,27 @@ fill_arrays(vrna_fold_compound_t  *fc,
   domains_up  = fc->domains_up;
   sn          = fc->strand_number;
 
+  /*
+   *  in incremental mode, only entries (i, j) with i <= dirty_i and j >= dirty_j
+   *  are outdated. Everything that keeps state across more than the helper arrays
+   *  (multiple strands, lonely pairs, ligands, grammar extensions) is always
+   *  computed from scratch, and so is everything after the energy parameters
+   *  have been replaced
+   */
+  dirty_i = length;
+  dirty_j = 1;
+
+  if ((matrices->incremental) &&
+      (matrices->params == P) &&
+      (matrices->params_id == P->id) &&
+      (fc->strands == 1) &&
+      (!md->noLP) &&
+      (!domains_up) &&
+      (!fc->aux_grammar)) {
+    dirty_i = MIN2(matrices->dirty_i, (unsigned int)length);
+    dirty_j = MAX2(matrices->dirty_j, 1);
+  }
+
   /* allocate memory for all helper arrays */
   helper_arrays = get_aux_arrays(length);
 
@@ -394,7 +415,11 @@ fill_arrays(vrna_fold_compound_t  *fc,
     return 0;
   }
 
-  for (i = length - 1; i >= 1; i--) {
+  /*
+   *  rows i > dirty_i + 2 are neither outdated nor required to restore the
+   *  helper arrays DMLi1 and DMLi2 of outdated rows
+   */
+  for (i = MIN2(length - 1, (int)dirty_i + 2); i >= 1; i--) {
     if ((fc->strands > 1) &&
         (sn[i] != sn[i + 1]))
       update_fms3_arrays(fc, sn[i + 1], ms_dat);
@@ -402,6 +427,20 @@ fill_arrays(vrna_fold_compound_t  *fc,
     for (j = i + 1; j <= length; j++) {
       ij = indx[j] + i;
 
+      if ((i > (int)dirty_i) || (j < (int)dirty_j)) {
+        /*
+         *  up-to-date entry, only restore the helper arrays that outdated
+         *  entries read, i.e. the fML row and DMLi of the last two columns
+         *  before dirty_j
+         */
+        if (j + 2 < (int)dirty_j)
+          helper_arrays->Fmi[j] = fML[ij];
+        else
+          (void)vrna_E_ml_stems_fast(fc, i, j, helper_arrays->Fmi, helper_arrays->DMLi);
+
+        continue;
+      }
+
       /* decompose subsegment [i, j] with pair (i, j) */
       c[ij] = decompose_pair(fc, i, j, helper_arrays, ms_dat);
 
@@ -429,6 +468,14 @@ fill_arrays(vrna_fold_compound_t  *fc,
   /* clean up memory */
   free_aux_arrays(helper_arrays);
 
+  matrices->params    = P;
+  matrices->params_id = P->id;
+
+  if (matrices->incremental) {
+    matrices->dirty_i = 0;
+    matrices->dirty_j = length + 1;
+  }
+
   return f5[length];
 }
 
@@ -448,7 +495,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
    * fM_d5 = multiloop region with >= 2 stems, extending to pos n-1
    *         (a pair (1,k) will form a 5' dangle with pos n)
    */
-  unsigned char *hard_constraints, eval;
+  unsigned char eval;
   char          *ptype;
   short         *S1, **SS, **S5, **S3;
   unsigned int  **a2s;
@@ -477,7 +524,6 @@ postprocess_circular(vrna_fold_compound_t *fc,
   scs               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->scs;
   dangle_model      = md->dangles;
   turn              = md->min_loop_size;
-  hard_constraints  = hc->mx;
   my_c              = fc->matrices->c;
   my_fML            = fc->matrices->fML;
   fM2               = fc->matrices->fM2;
@@ -528,7 +574,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
 
       ij = indx[j] + i;
 
-      if (!hard_constraints[length * i + j])
+      if (!vrna_hc_context(hc, i, j))
         continue;
 
       /* exterior hairpin case */
@@ -791,7 +837,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = 2 * turn + 1; i < length - turn; i++) {
         if (c_tmp[i + 1] != INF) {
           /* obey internal hard constraints */
-          if (hard_constraints[length * length + i + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          if (vrna_hc_context(hc, length, i + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
             tmp = 0;
             switch (fc->type) {
               case VRNA_FC_TYPE_SINGLE:
@@ -891,7 +937,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = 2 * turn + 1; i < length - turn; i++) {
         if (c_tmp[i + 1] != INF) {
           /* obey internal hard constraints */
-          if ((hard_constraints[length * length + i + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_context(hc, length, i + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (hc->up_ml[i])) {
             tmp = 0;
             switch (fc->type) {
@@ -981,7 +1027,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       /* add contributions for enclosing pair */
       for (i = turn + 1; i < length - turn; i++) {
         if (fmd5_tmp[i + 1] != INF) {
-          if (hard_constraints[length + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          if (vrna_hc_context(hc, 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
             tmp = 0;
             switch (fc->type) {
               case VRNA_FC_TYPE_SINGLE:
@@ -1079,7 +1125,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = turn + 1; i < length - turn; i++) {
         if (fmd5_tmp[i + 2] != INF) {
           /* obey internal hard constraints */
-          if ((hard_constraints[length + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_context(hc, 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (hc->up_ml[i + 1])) {
             tmp = 0;
             switch (fc->type) {
@@ -3411,15 +3457,13 @@ decompose_pair(vrna_fold_compound_t *fc,
                struct ms_helpers    *ms_dat)
 {
   unsigned char hc_decompose;
-  unsigned int  n;
   int           e, new_c, energy, stackEnergy, ij, dangle_model, noLP,
                 *DMLi1, *DMLi2, *cc, *cc1;
 
-  n             = fc->length;
   ij            = fc->jindx[j] + i;
   dangle_model  = fc->params->model_details.dangles;
   noLP          = fc->params->model_details.noLP;
-  hc_decompose  = fc->hc->mx[n * i + j];
+  hc_decompose  = vrna_hc_context(fc->hc, i, j);
   DMLi1         = aux->DMLi1;
   DMLi2         = aux->DMLi2;
   cc            = aux->cc;
@@ -23,20 +23,19 @@
 PUBLIC int
 vrna_maximum_matching(vrna_fold_compound_t *fc)
 {
-  unsigned char *mx, *hc_up;
+  unsigned char *hc_up;
   int           i, j, l, n, turn, *mm, max, max2, max3;
   vrna_hc_t     *hc;
 
   n     = (int)fc->length;
   turn  = fc->params->model_details.min_loop_size;
   hc    = fc->hc;
-  mx    = hc->mx;
   hc_up = (unsigned char *)vrna_alloc(sizeof(unsigned char) * n);
   mm    = (int *)vrna_alloc(sizeof(int) * (n * n));
 
   /* comply with hard constraints for unpaired positions */
   for (i = n - 1; i >= 0; i--)
-    if (mx[n * (i + 1) + i + 1] & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS)
+    if (vrna_hc_context(hc, i + 1, i + 1) & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS)
       hc_up[i] = 1;
 
   /* initialize DP matrix */
@@ -52,7 +51,7 @@ vrna_maximum_matching(vrna_fold_compound_t *fc)
       max = -1;
 
       /* 1st case: i pairs with j */
-      if (mx[n * (i + 1) + j + 1] & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS) {
+      if (vrna_hc_context(hc, i + 1, j + 1) & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS) {
         max2 = mm[n * (i + 1) + j - 1];
 
         if (max2 != -1) {
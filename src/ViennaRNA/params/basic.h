@@ -33,6 +33,7 @@ typedef struct  vrna_exp_param_s vrna_exp_param_t;
 #include <ViennaRNA/datastructures/basic.h>
 #include <ViennaRNA/fold_compound.h>
 #include <ViennaRNA/model.h>
+#include <ViennaRNA/params/salt.h>
 
 #define   VRNA_GQUAD_MAX_STACK_SIZE     7
 #define   VRNA_GQUAD_MIN_STACK_SIZE     2
@@ -237,6 +238,45 @@ vrna_exp_params_comparative(unsigned int  n_seq,
                             vrna_md_t     *md);
 
 
+/**
+ *  @brief  Get a data structure containing prescaled free energy parameters
+ *          for precomputed salt corrections
+ *
+ *  Similar to vrna_params(), but the salt corrections are taken from @p corr
+ *  instead of being evaluated from scratch. Temperature and salt concentration
+ *  of the returned parameters are those of @p corr, all other model settings
+ *  are copied from @p md. This is most useful for evaluating the same model
+ *  over a grid of conditions, where the corrections have been obtained from a
+ *  single call to vrna_salt_corrections().
+ *
+ *  @see vrna_salt_corrections(), vrna_params(), vrna_exp_params_salt()
+ *
+ *  @param  md    A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @param  corr  The salt corrections computed for @p md (Maybe NULL)
+ *  @return       A pointer to the memory location where the requested parameters are stored
+ */
+vrna_param_t *
+vrna_params_salt(vrna_md_t                    *md,
+                 const vrna_salt_correction_t *corr);
+
+
+/**
+ *  @brief  Get a data structure containing prescaled free energy parameters
+ *          already transformed to Boltzmann factors for precomputed salt corrections
+ *
+ *  Boltzmann factor variant of vrna_params_salt().
+ *
+ *  @see vrna_salt_corrections(), vrna_exp_params(), vrna_params_salt()
+ *
+ *  @param  md    A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @param  corr  The salt corrections computed for @p md (Maybe NULL)
+ *  @return       A pointer to the memory location where the requested parameters are stored
+ */
+vrna_exp_param_t *
+vrna_exp_params_salt(vrna_md_t                    *md,
+                     const vrna_salt_correction_t *corr);
+
+
 /**
  *  @brief Get a copy of the provided free energy parameters (provided as Boltzmann factors)
  *
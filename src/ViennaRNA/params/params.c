@@ -19,6 +19,7 @@
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/params/salt.h"
+#include "ViennaRNA/dp_matrices.h"
 
 /**
  *** \file ViennaRNA/params/basic.c
@@ -82,8 +83,6 @@
       ) \
     )
 
-#define saltT md->temperature+K0
-
 /*
  #################################
  # PRIVATE VARIABLES             #
@@ -106,18 +105,21 @@ PRIVATE int               pf_id = -1;
  */
 
 PRIVATE vrna_param_t *
-get_scaled_params(vrna_md_t *md);
+get_scaled_params(vrna_md_t                     *md,
+                  const vrna_salt_correction_t  *salt_corr);
 
 
 PRIVATE vrna_exp_param_t *
-get_scaled_exp_params(vrna_md_t *md,
-                      double    pfs);
+get_scaled_exp_params(vrna_md_t                     *md,
+                      double                        pfs,
+                      const vrna_salt_correction_t  *salt_corr);
 
 
 PRIVATE vrna_exp_param_t *
-get_exp_params_ali(vrna_md_t    *md,
-                   unsigned int n_seq,
-                   double       pfs);
+get_exp_params_ali(vrna_md_t                    *md,
+                   unsigned int                 n_seq,
+                   double                       pfs,
+                   const vrna_salt_correction_t *salt_corr);
 
 
 PRIVATE void
@@ -135,11 +137,11 @@ PUBLIC vrna_param_t *
 vrna_params(vrna_md_t *md)
 {
   if (md) {
-    return get_scaled_params(md);
+    return get_scaled_params(md, NULL);
   } else {
     vrna_md_t md;
     vrna_md_set_default(&md);
-    return get_scaled_params(&md);
+    return get_scaled_params(&md, NULL);
   }
 }
 
@@ -148,11 +150,11 @@ PUBLIC vrna_exp_param_t *
 vrna_exp_params(vrna_md_t *md)
 {
   if (md) {
-    return get_scaled_exp_params(md, -1.);
+    return get_scaled_exp_params(md, -1., NULL);
   } else {
     vrna_md_t md;
     vrna_md_set_default(&md);
-    return get_scaled_exp_params(&md, -1.);
+    return get_scaled_exp_params(&md, -1., NULL);
   }
 }
 
@@ -162,15 +164,57 @@ vrna_exp_params_comparative(unsigned int  n_seq,
                             vrna_md_t     *md)
 {
   if (md) {
-    return get_exp_params_ali(md, n_seq, -1.);
+    return get_exp_params_ali(md, n_seq, -1., NULL);
   } else {
     vrna_md_t md;
     vrna_md_set_default(&md);
-    return get_exp_params_ali(&md, n_seq, -1.);
+    return get_exp_params_ali(&md, n_seq, -1., NULL);
   }
 }
 
 
+PUBLIC vrna_param_t *
+vrna_params_salt(vrna_md_t                    *md_p,
+                 const vrna_salt_correction_t *corr)
+{
+  vrna_md_t md;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  if (!corr)
+    return get_scaled_params(&md, NULL);
+
+  md.temperature  = corr->temperature;
+  md.salt         = corr->salt;
+
+  return get_scaled_params(&md, corr);
+}
+
+
+PUBLIC vrna_exp_param_t *
+vrna_exp_params_salt(vrna_md_t                    *md_p,
+                     const vrna_salt_correction_t *corr)
+{
+  vrna_md_t md;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  if (!corr)
+    return get_scaled_exp_params(&md, -1., NULL);
+
+  md.temperature  = corr->temperature;
+  md.salt         = corr->salt;
+
+  return get_scaled_exp_params(&md, -1., corr);
+}
+
+
 PUBLIC vrna_param_t *
 vrna_params_copy(vrna_param_t *par)
 {
@@ -221,6 +265,8 @@ vrna_params_subst(vrna_fold_compound_t  *vc,
           break;
       }
     }
+
+    vrna_mx_invalidate(vc, vc->length, 1);
   }
 }
 
@@ -245,6 +291,7 @@ vrna_params_reset(vrna_fold_compound_t  *vc,
           vc->exp_params = vrna_exp_params(md_p);
         }
 
+        vrna_mx_invalidate(vc, vc->length, 1);
         break;
 
       default:
@@ -267,6 +314,7 @@ vrna_exp_params_reset(vrna_fold_compound_t  *vc,
           free(vc->exp_params);
 
         vc->exp_params = vrna_exp_params(md_p);
+        vrna_mx_invalidate(vc, vc->length, 1);
         break;
 
       default:
@@ -306,6 +354,8 @@ vrna_exp_params_subst(vrna_fold_compound_t  *vc,
 
     /* fill additional helper arrays for scaling etc. */
     vrna_exp_params_rescale(vc, NULL);
+
+    vrna_mx_invalidate(vc, vc->length, 1);
   }
 }
 
@@ -387,10 +437,13 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
         }
       }
 
-      if (!fc->exp_params)
+      if (!fc->exp_params) {
         fc->exp_params = (fc->type == VRNA_FC_TYPE_SINGLE) ? \
                          vrna_exp_params(md_p) : \
                          vrna_exp_params_comparative(fc->n_seq, md_p);
+
+        vrna_mx_invalidate(fc, fc->length, 1);
+      }
     }
   }
 }
@@ -402,13 +455,18 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
  #####################################
  */
 PRIVATE vrna_param_t *
-get_scaled_params(vrna_md_t *md)
+get_scaled_params(vrna_md_t                     *md,
+                  const vrna_salt_correction_t  *salt_corr)
 {
-  unsigned int  i, j, k, l;
-  double        tempf;
-  vrna_param_t  *params;
-  double salt = md->salt;
-  double saltStandard = VRNA_MODEL_DEFAULT_SALT;
+  unsigned int            i, j, k, l;
+  double                  tempf;
+  vrna_param_t            *params;
+  vrna_salt_correction_t  *corr;
+
+  /* compute salt corrections unless they have been provided by the caller */
+  corr = NULL;
+  if (!salt_corr)
+    salt_corr = corr = vrna_salt_corrections(md, NULL, 0, NULL, 0);
 
   params = (vrna_param_t *)vrna_alloc(sizeof(vrna_param_t));
 
@@ -452,18 +510,11 @@ get_scaled_params(vrna_md_t *md)
                        (int)(params->lxc * log((double)(i) / 30.));
     params->internal_loop[i] = params->internal_loop[30] +
                                (int)(params->lxc * log((double)(i) / 30.));
-    params->SaltLoopDbl[i]   = (salt==saltStandard) ? 0. : vrna_salt_loop(i, salt, saltT, md->backbone_length);
-    params->SaltLoop[i]      = (int) (params->SaltLoopDbl[i] + 0.5 - (params->SaltLoopDbl[i]<0));
-  }
-
-  for (i = 0; i <= MIN2(31, MAXLOOP+1); i++) {
-    params->SaltLoopDbl[i]    = (salt==saltStandard) ? 0. : vrna_salt_loop(i, salt, saltT, md->backbone_length);
-    params->SaltLoop[i]       = (int) (params->SaltLoopDbl[i] + 0.5 - (params->SaltLoopDbl[i]<0));
   }
 
-  for (; i <= MAXLOOP; i++) {
-    params->SaltLoopDbl[i]   = (salt==saltStandard) ? 0. : vrna_salt_loop(i, salt, saltT, md->backbone_length);
-    params->SaltLoop[i]      = (int) (params->SaltLoopDbl[i] + 0.5 - (params->SaltLoopDbl[i]<0));
+  for (i = 0; i <= MAXLOOP + 1; i++) {
+    params->SaltLoopDbl[i]  = salt_corr->loop[i];
+    params->SaltLoop[i]     = (int) (params->SaltLoopDbl[i] + 0.5 - (params->SaltLoopDbl[i]<0));
   }
 
   for (i = 0; (i * 7) < strlen(Tetraloops); i++)
@@ -569,11 +620,9 @@ get_scaled_params(vrna_md_t *md)
   strncpy(params->Hexaloops, Hexaloops, 361);
 
   /* Salt correction for stack and multiloop */
-  params->SaltStack = (salt==saltStandard) ? 0 : vrna_salt_stack(salt, saltT, md->helical_rise);
-  if (salt == saltStandard)
-    params->SaltMLbase = params->SaltMLclosing = 0;
-  else
-    vrna_salt_ml(params->SaltLoopDbl, md->saltMLLower, md->saltMLUpper, &params->SaltMLbase, &params->SaltMLclosing);
+  params->SaltStack     = salt_corr->stack;
+  params->SaltMLbase    = salt_corr->ml_base;
+  params->SaltMLclosing = salt_corr->ml_closing;
   
   params->MLclosing += params->SaltMLbase;
   params->MLclosing += params->SaltMLclosing;
@@ -581,31 +630,33 @@ get_scaled_params(vrna_md_t *md)
   for (i = 0; i <= NBPAIRS; i++)
     params->MLintern[i] += params->SaltMLbase;
 
-  params->SaltDPXInit = 0;
-  if (salt != saltStandard)
-  {
-    if (md->saltDPXInit != VRNA_MODEL_DEFAULT_SALT_DPXINIT)
-      params->SaltDPXInit = md->saltDPXInit;
-    else if (md->saltDPXInit)
-      params->SaltDPXInit = vrna_salt_duplex_init(md);
-  }
+  params->SaltDPXInit = salt_corr->duplex_init;
   params->DuplexInit += params->SaltDPXInit;
 
+  free(corr);
+
   params->id = ++id;
   return params;
 }
 
 
 PRIVATE vrna_exp_param_t *
-get_scaled_exp_params(vrna_md_t *md,
-                      double    pfs)
+get_scaled_exp_params(vrna_md_t                     *md,
+                      double                        pfs,
+                      const vrna_salt_correction_t  *salt_corr)
 {
-  unsigned int      i, j, k, l;
-  int               pf_smooth;
-  double            kT, TT;
-  double            GT;
-  double            salt, saltStandard;
-  vrna_exp_param_t  *pf;
+  unsigned int            i, j, k, l;
+  int                     pf_smooth;
+  double                  kT, TT;
+  double                  GT;
+  double                  salt, saltStandard;
+  vrna_exp_param_t        *pf;
+  vrna_salt_correction_t  *corr;
+
+  /* compute salt corrections unless they have been provided by the caller */
+  corr = NULL;
+  if (!salt_corr)
+    salt_corr = corr = vrna_salt_corrections(md, NULL, 0, NULL, 0);
 
   pf = (vrna_exp_param_t *)vrna_alloc(sizeof(vrna_exp_param_t));
 
@@ -660,14 +711,8 @@ get_scaled_exp_params(vrna_md_t *md,
       pf->expSaltLoop[i] = 1.;
     }
   } else {
-    for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
-      pf->SaltLoopDbl[i]   = vrna_salt_loop(i, salt, saltT, md->backbone_length);
-      int saltLoop = (int) (pf->SaltLoopDbl[i] + 0.5 - (pf->SaltLoopDbl[i]<0));
-      pf->expSaltLoop[i]   = exp(-saltLoop * 10. / kT);
-    }
-
-    for (i = 31; i <= MAXLOOP; i++) {
-      pf->SaltLoopDbl[i] = vrna_salt_loop(i, salt, saltT, md->backbone_length);
+    for (i = 0; i <= MAXLOOP; i++) {
+      pf->SaltLoopDbl[i] = salt_corr->loop[i];
       int saltLoop = (int) (pf->SaltLoopDbl[i] + 0.5 - (pf->SaltLoopDbl[i]<0));
       pf->expSaltLoop[i] = exp(-saltLoop * 10. / kT);
     }
@@ -809,13 +854,10 @@ get_scaled_exp_params(vrna_md_t *md,
   if (salt==saltStandard) { /* into */
     pf->expSaltStack = 1.;
   } else {
-    pf->expSaltStack = exp(- vrna_salt_stack(salt, saltT, md->helical_rise) * 10. / kT);
-    vrna_salt_ml(pf->SaltLoopDbl, md->saltMLLower, md->saltMLUpper, &pf->SaltMLbase, &pf->SaltMLclosing);
-
-    if (md->saltDPXInit != VRNA_MODEL_DEFAULT_SALT_DPXINIT)
-      pf->SaltDPXInit = md->saltDPXInit;
-    else if (md->saltDPXInit) /* into */
-      pf->SaltDPXInit = vrna_salt_duplex_init(md);
+    pf->expSaltStack  = exp(- salt_corr->stack * 10. / kT);
+    pf->SaltMLbase    = salt_corr->ml_base;
+    pf->SaltMLclosing = salt_corr->ml_closing;
+    pf->SaltDPXInit   = salt_corr->duplex_init;
 
     pf->expMLclosing *= exp(- pf->SaltMLbase * 10. / kT);
     pf->expMLclosing *= exp(- pf->SaltMLclosing * 10. / kT);
@@ -826,22 +868,31 @@ get_scaled_exp_params(vrna_md_t *md,
     pf->expDuplexInit *= exp(- pf->SaltDPXInit*10. / kT);
   }
 
+  free(corr);
+
   return pf;
 }
 
 
 PRIVATE vrna_exp_param_t *
-get_exp_params_ali(vrna_md_t    *md,
-                   unsigned int n_seq,
-                   double       pfs)
+get_exp_params_ali(vrna_md_t                    *md,
+                   unsigned int                 n_seq,
+                   double                       pfs,
+                   const vrna_salt_correction_t *salt_corr)
 {
   /* scale energy parameters and pre-calculate Boltzmann weights */
-  unsigned int      i, j, k, l;
-  int               pf_smooth;
-  double            kTn, TT;
-  double            GT;
-  double            salt, saltStandard;
-  vrna_exp_param_t  *pf;
+  unsigned int            i, j, k, l;
+  int                     pf_smooth;
+  double                  kTn, TT;
+  double                  GT;
+  double                  salt, saltStandard;
+  vrna_exp_param_t        *pf;
+  vrna_salt_correction_t  *corr;
+
+  /* compute salt corrections unless they have been provided by the caller */
+  corr = NULL;
+  if (!salt_corr)
+    salt_corr = corr = vrna_salt_corrections(md, NULL, 0, NULL, 0);
 
   pf                = (vrna_exp_param_t *)vrna_alloc(sizeof(vrna_exp_param_t));
   pf->model_details = *md;
@@ -883,10 +934,6 @@ get_exp_params_ali(vrna_md_t    *md,
   for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
     pf->expbulge[i]     = RESCALE_BF(bulge37[i], bulgedH[i], TT, kTn);
     pf->expinternal[i]  = RESCALE_BF(internal_loop37[i], internal_loopdH[i], TT, kTn);
-
-    pf->SaltLoopDbl[i]   = (salt==saltStandard) ? 0. : vrna_salt_loop(i, salt, saltT, md->backbone_length);
-    int saltLoop = (int) (pf->SaltLoopDbl[i] + 0.5 - (pf->SaltLoopDbl[i]<0));
-    pf->expSaltLoop[i]   = exp(-saltLoop * 10. / kTn);
   }
 
   if (salt==saltStandard) {
@@ -899,14 +946,8 @@ get_exp_params_ali(vrna_md_t    *md,
       pf->expSaltLoop[i] = 1.;
     }
   } else {
-    for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
-      pf->SaltLoopDbl[i]  = vrna_salt_loop(i, salt, saltT, md->backbone_length);
-      int saltLoop = (int) (pf->SaltLoopDbl[i] + 0.5 - (pf->SaltLoopDbl[i]<0));
-      pf->expSaltLoop[i]   = exp(-saltLoop * 10. / kTn);
-    }
-
-    for (i = 31; i <= MAXLOOP; i++) {
-      pf->SaltLoopDbl[i] = vrna_salt_loop(i, salt, saltT, md->backbone_length);
+    for (i = 0; i <= MAXLOOP; i++) {
+      pf->SaltLoopDbl[i] = salt_corr->loop[i];
       int saltLoop = (int) (pf->SaltLoopDbl[i] + 0.5 - (pf->SaltLoopDbl[i]<0));
       pf->expSaltLoop[i] = exp(-saltLoop * 10. / kTn);
     }
@@ -1054,14 +1095,10 @@ get_exp_params_ali(vrna_md_t    *md,
   if (salt==saltStandard) {
     pf->expSaltStack = 1.;
   } else {
-    pf->expSaltStack = exp(- vrna_salt_stack(salt, saltT, md->helical_rise) * 10. / kTn);
-
-    vrna_salt_ml(pf->SaltLoopDbl, md->saltMLLower, md->saltMLUpper, &pf->SaltMLbase, &pf->SaltMLclosing);
-
-    if (md->saltDPXInit != VRNA_MODEL_DEFAULT_SALT_DPXINIT)
-      pf->SaltDPXInit = md->saltDPXInit;
-    else if (md->saltDPXInit)
-      pf->SaltDPXInit = vrna_salt_duplex_init(md);
+    pf->expSaltStack  = exp(- salt_corr->stack * 10. / kTn);
+    pf->SaltMLbase    = salt_corr->ml_base;
+    pf->SaltMLclosing = salt_corr->ml_closing;
+    pf->SaltDPXInit   = salt_corr->duplex_init;
 
     pf->expMLclosing *= exp(- pf->SaltMLbase * 10. / kTn);
     pf->expMLclosing *= exp(- pf->SaltMLclosing * 10. / kTn);
@@ -1072,6 +1109,8 @@ get_exp_params_ali(vrna_md_t    *md,
     pf->expDuplexInit *= exp(- pf->SaltDPXInit*10. / kTn);
   }
 
+  free(corr);
+
   return pf;
 }
 
@@ -1084,6 +1123,13 @@ rescale_params(vrna_fold_compound_t *vc)
   vrna_mx_pf_t      *m  = vc->exp_matrices;
 
   if (m && pf) {
+    /* a different scaling factor outdates all partition function entries */
+    if ((m->type == VRNA_MX_DEFAULT) &&
+        (m->scale[1] != (FLT_OR_DBL)(1. / pf->pf_scale))) {
+      m->dirty_i  = m->length;
+      m->dirty_j  = 1;
+    }
+
     m->scale[0]     = 1.;
     m->scale[1]     = (FLT_OR_DBL)(1. / pf->pf_scale);
     m->expMLbase[0] = 1;
@@ -1118,7 +1164,7 @@ get_scaled_parameters(double    temp,
                       vrna_md_t md)
 {
   md.temperature = temp;
-  return get_scaled_params(&md);
+  return get_scaled_params(&md, NULL);
 }
 
 
@@ -1132,7 +1178,7 @@ get_boltzmann_factors(double    temp,
   md.betaScale    = betaScale;
   pf_scale        = pfs;
 
-  return get_scaled_exp_params(&md, pfs);
+  return get_scaled_exp_params(&md, pfs, NULL);
 }
 
 
@@ -1162,7 +1208,7 @@ get_boltzmann_factors_ali(unsigned int  n_seq,
   md.betaScale    = betaScale;
   pf_scale        = pfs;
 
-  return get_exp_params_ali(&md, n_seq, pfs);
+  return get_exp_params_ali(&md, n_seq, pfs, NULL);
 }
 
 
@@ -1173,7 +1219,7 @@ get_scaled_alipf_parameters(unsigned int n_seq)
 
   set_model_details(&md);
 
-  return get_exp_params_ali(&md, n_seq, pf_scale);
+  return get_exp_params_ali(&md, n_seq, pf_scale, NULL);
 }
 
 
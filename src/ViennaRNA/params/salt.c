@@ -211,3 +211,82 @@ vrna_salt_duplex_init(vrna_md_t *md_p)
     return roundint(x * md_p->saltDPXInitFact);
   }
 }
+
+
+PUBLIC vrna_salt_correction_t *
+vrna_salt_corrections(vrna_md_t     *md_p,
+                      const double  *temperatures,
+                      unsigned int  num_temperatures,
+                      const double  *salt,
+                      unsigned int  num_salt)
+{
+  unsigned int            t, s, L, have_ref;
+  double                  T, temperature, rho, kn_ref, kappa_T, ref[MAXLOOP + 2];
+  vrna_md_t               md;
+  vrna_salt_correction_t  *corr, *c;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  temperature = md.temperature;
+  rho         = md.salt;
+
+  if (!temperatures)
+    num_temperatures = 1;
+
+  if (!salt)
+    num_salt = 1;
+
+  if ((num_temperatures == 0) || (num_salt == 0))
+    return NULL;
+
+  corr = (vrna_salt_correction_t *)vrna_alloc(sizeof(vrna_salt_correction_t) *
+                                              num_temperatures *
+                                              num_salt);
+
+  for (t = 0; t < num_temperatures; t++) {
+    md.temperature  = (temperatures) ? temperatures[t] : temperature;
+    T               = md.temperature + K0;
+    have_ref        = 0;
+
+    for (s = 0; s < num_salt; s++) {
+      c               = corr + t * num_salt + s;
+      md.salt         = (salt) ? salt[s] : rho;
+      c->temperature  = md.temperature;
+      c->salt         = md.salt;
+
+      /* all corrections vanish at the reference salt concentration */
+      if (md.salt == VRNA_MODEL_DEFAULT_SALT)
+        continue;
+
+      /* terms at the reference salt concentration only depend on the temperature */
+      if (!have_ref) {
+        kappa_T = kappa(VRNA_MODEL_DEFAULT_SALT, T);
+        for (L = 1; L <= MAXLOOP + 1; L++)
+          ref[L] = loop_salt_aux(kappa_T * L * md.backbone_length, L, T, md.backbone_length);
+
+        kn_ref    = kn(0, Rods_dist * kappa_T);
+        have_ref  = 1;
+      }
+
+      kappa_T = kappa(md.salt, T);
+      for (L = 1; L <= MAXLOOP + 1; L++)
+        c->loop[L] = loop_salt_aux(kappa_T * L * md.backbone_length, L, T, md.backbone_length) -
+                     ref[L];
+
+      c->stack = roundint(100 * pairing_salt_const(T, md.helical_rise) *
+                          (kn(0, Rods_dist * kappa_T) - kn_ref));
+
+      vrna_salt_ml(c->loop, md.saltMLLower, md.saltMLUpper, &(c->ml_base), &(c->ml_closing));
+
+      if (md.saltDPXInit != VRNA_MODEL_DEFAULT_SALT_DPXINIT)
+        c->duplex_init = md.saltDPXInit;
+      else if (md.saltDPXInit)
+        c->duplex_init = vrna_salt_duplex_init(&md);
+    }
+  }
+
+  return corr;
+}
@@ -15,6 +15,31 @@
 #include <math.h>
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/model.h"
+#include "ViennaRNA/params/constants.h"
+
+
+/**
+ *  @brief  Typename for the salt corrections at a particular temperature and salt concentration
+ *
+ *  @see vrna_salt_correction_s, vrna_salt_corrections()
+ */
+typedef struct vrna_salt_correction_s vrna_salt_correction_t;
+
+
+/**
+ *  @brief  Salt corrections of all loop types at a particular temperature and salt concentration
+ *
+ *  @see vrna_salt_corrections(), vrna_params_salt(), vrna_exp_params_salt()
+ */
+struct vrna_salt_correction_s {
+  double  temperature;        /**< @brief  Temperature in &deg;C */
+  double  salt;               /**< @brief  Salt concentration (M) */
+  double  loop[MAXLOOP + 2];  /**< @brief  Salt correction for loops with @f$ L @f$ backbones in dcal/mol */
+  int     stack;              /**< @brief  Rounded salt correction for stacks in dcal/mol */
+  int     ml_base;            /**< @brief  Slope of the linear fit of multiloop salt corrections in dcal/mol */
+  int     ml_closing;         /**< @brief  Intercept of the linear fit of multiloop salt corrections in dcal/mol */
+  int     duplex_init;        /**< @brief  Salt correction for duplex initialization in dcal/mol */
+};
 
 
 /**
@@ -91,6 +116,39 @@ vrna_salt_ml(double saltLoop[], int lower, int upper, int *m, int *b);
 int
 vrna_salt_duplex_init(vrna_md_t *md);
 
+
+/**
+ *  @brief Get salt corrections for a grid of temperatures and salt concentrations
+ *
+ *  This function computes the salt corrections of all loop types for each
+ *  point of a grid spanned by @p temperatures and @p salt. Terms that only
+ *  depend on the temperature, such as the corrections at the reference salt
+ *  concentration, are evaluated once per temperature and shared among all
+ *  salt concentrations. All other settings, e.g. backbone length, helical rise,
+ *  and multiloop fitting range, are taken from @p md. Passing @em NULL for
+ *  @p temperatures or @p salt uses the temperature or salt concentration of
+ *  @p md instead.
+ *
+ *  The results are stored temperature-major, i.e. the corrections for the
+ *  @f$ t @f$-th temperature and @f$ s @f$-th salt concentration are found at
+ *  position @f$ t \cdot num\_salt + s @f$.
+ *
+ *  @see vrna_params_salt(), vrna_exp_params_salt()
+ *
+ *  @param md                 Model details data structure (default model if @em NULL)
+ *  @param temperatures       List of temperatures in &deg;C (may be @em NULL)
+ *  @param num_temperatures   Number of temperatures in @p temperatures
+ *  @param salt               List of salt concentrations in M (may be @em NULL)
+ *  @param num_salt           Number of salt concentrations in @p salt
+ *  @return                   A list of salt corrections for all grid points, or @em NULL if the grid is empty
+ */
+vrna_salt_correction_t *
+vrna_salt_corrections(vrna_md_t     *md,
+                      const double  *temperatures,
+                      unsigned int  num_temperatures,
+                      const double  *salt,
+                      unsigned int  num_salt);
+
 /**
  *  @}
  */
@@ -235,6 +235,75 @@ vrna_pf_dimer(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC vrna_dimer_grid_t *
+vrna_pf_dimer_grid(vrna_fold_compound_t *fc,
+                   const double         *temperatures,
+                   unsigned int         num_temperatures,
+                   const double         *salt,
+                   unsigned int         num_salt)
+{
+  unsigned int            k, num;
+  double                  mfe;
+  vrna_md_t               md;
+  vrna_param_t            *P;
+  vrna_exp_param_t        *pf;
+  vrna_salt_correction_t  *corr;
+  vrna_dimer_grid_t       *grid;
+
+  grid = NULL;
+
+  if ((fc) &&
+      (fc->type == VRNA_FC_TYPE_SINGLE)) {
+    md              = fc->params->model_details;
+    md.backtrack    = 0;
+    md.compute_bpp  = 0;
+
+    /* salt corrections for all grid points at once */
+    corr = vrna_salt_corrections(&md,
+                                 temperatures,
+                                 num_temperatures,
+                                 salt,
+                                 num_salt);
+
+    if (corr) {
+      num   = ((temperatures) ? num_temperatures : 1) *
+              ((salt) ? num_salt : 1);
+      grid  = (vrna_dimer_grid_t *)vrna_alloc(sizeof(vrna_dimer_grid_t) * num);
+
+      /* keep the original energy parameters to restore them afterwards */
+      P               = fc->params;
+      pf              = fc->exp_params;
+      fc->exp_params  = NULL;
+
+      for (k = 0; k < num; k++) {
+        fc->params      = vrna_params_salt(&md, corr + k);
+        fc->exp_params  = vrna_exp_params_salt(&md, corr + k);
+
+        /* the MFE serves as estimate for the scaling factor */
+        mfe = (double)vrna_mfe(fc, NULL);
+        vrna_exp_params_rescale(fc, &mfe);
+
+        grid[k].temperature = corr[k].temperature;
+        grid[k].salt        = corr[k].salt;
+        grid[k].mfe         = mfe;
+        grid[k].F           = vrna_pf_dimer(fc, NULL);
+        grid[k].dG          = grid[k].F.FcAB - grid[k].F.FA - grid[k].F.FB;
+
+        free(fc->params);
+        free(fc->exp_params);
+      }
+
+      fc->params      = P;
+      fc->exp_params  = pf;
+
+      free(corr);
+    }
+  }
+
+  return grid;
+}
+
+
 PUBLIC int
 vrna_pf_float_precision(void)
 {
@@ -301,6 +370,7 @@ vrna_pf_add(FLT_OR_DBL  dG1,
 PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc)
 { 
+  unsigned int        dirty_i, dirty_j;
   int                 n, i, j, k, ij, *my_iindx, *jindx, with_gquad, with_ud;
   FLT_OR_DBL          temp, Qmax, *q, *qb, *qm, *qm1, *q1k, *qln;
   double              max_real;
@@ -329,6 +399,24 @@ fill_arrays(vrna_fold_compound_t *fc)
   with_ud = (domains_up && domains_up->exp_energy_cb && (!(fc->type == VRNA_FC_TYPE_COMPARATIVE)));
   Qmax    = 0;
 
+  /*
+   *  in incremental mode, only entries (i, j) with i <= dirty_i and j >= dirty_j
+   *  are outdated. Multiple strands, ligands, grammar extensions, and replaced
+   *  Boltzmann factors always require a computation from scratch
+   */
+  dirty_i = n;
+  dirty_j = 1;
+
+  if ((matrices->incremental) &&
+      (matrices->params == pf_params) &&
+      (matrices->params_id == pf_params->id) &&
+      (fc->strands == 1) &&
+      (!domains_up) &&
+      (!fc->aux_grammar)) {
+    dirty_i = MIN2(matrices->dirty_i, (unsigned int)n);
+    dirty_j = MAX2(matrices->dirty_j, 1);
+  }
+
   max_real = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
   if (with_ud && domains_up->exp_prod_cb) // not into
@@ -336,26 +424,8 @@ fill_arrays(vrna_fold_compound_t *fc)
 
   /* no G-Quadruplexes for comparative partition function (yet) */
   if (with_gquad) { // not into
-    free(fc->exp_matrices->G);
-    fc->exp_matrices->G = NULL;
-
-    switch (fc->type) {
-      case VRNA_FC_TYPE_SINGLE:
-        fc->exp_matrices->G = get_gquad_pf_matrix(fc->sequence_encoding2,
-                                                  fc->exp_matrices->scale,
-                                                  fc->exp_params);
-        break;
-
-      case VRNA_FC_TYPE_COMPARATIVE:
-        fc->exp_matrices->G = get_gquad_pf_matrix_comparative(fc->length,
-                                                              fc->S_cons,
-                                                              fc->S,
-                                                              fc->a2s,
-                                                              fc->exp_matrices->scale,
-                                                              fc->n_seq,
-                                                              fc->exp_params);
-        break;
-    }
+    vrna_gquad_index_free(fc->exp_matrices->G);
+    fc->exp_matrices->G = vrna_gquad_pf_index(fc);
   }
 
   /* init auxiliary arrays for fast exterior/multibranch loops */
@@ -373,6 +443,16 @@ fill_arrays(vrna_fold_compound_t *fc)
     for (i = j - 1; i >= 1; i--) {
       ij = my_iindx[i] - j;
 
+      if ((i > (int)dirty_i) || (j < (int)dirty_j)) {
+        /*
+         *  up-to-date entry, only advance the auxiliary arrays since they
+         *  are computed recursively along j
+         */
+        vrna_exp_E_ml_fast_aux(fc, i, j, aux_mx_ml);
+        vrna_exp_E_ext_fast_aux(fc, i, j, aux_mx_el);
+        continue;
+      }
+
       qb[ij] = decompose_pair(fc, i, j, aux_mx_ml);
 
       /* Multibranch loop */
@@ -431,6 +511,14 @@ fill_arrays(vrna_fold_compound_t *fc)
   vrna_exp_E_ml_fast_free(aux_mx_ml);
   vrna_exp_E_ext_fast_free(aux_mx_el);
 
+  matrices->params    = pf_params;
+  matrices->params_id = pf_params->id;
+
+  if (matrices->incremental) {
+    matrices->dirty_i = 0;
+    matrices->dirty_j = n + 1;
+  }
+
   return 1;
 }
 
@@ -441,17 +529,15 @@ decompose_pair(vrna_fold_compound_t *fc,
                int                  j,
                vrna_mx_pf_aux_ml_t  aux_mx_ml)
 {
-  unsigned int  n;
   int           *jindx, *pscore;
   FLT_OR_DBL    contribution;
   double        kTn;
   vrna_hc_t     *hc;
 
   contribution  = 0.;
-  n             = fc->length;
   hc            = fc->hc;
 
-  if (hc->mx[j * n + i]) {
+  if (vrna_hc_context(hc, i, j)) {
     /* process hairpin loop(s) */
     contribution += vrna_exp_E_hp_loop(fc, i, j);
     /* process interior loop(s) */
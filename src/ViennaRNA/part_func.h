@@ -72,6 +72,24 @@ struct vrna_dimer_pf_s {
   double  FB;   /**< @brief monomer B */
 };
 
+/**
+ *  @brief  Typename for the dimer free energies at a particular temperature and salt concentration
+ *
+ *  @see vrna_dimer_grid_s, vrna_pf_dimer_grid()
+ */
+typedef struct vrna_dimer_grid_s vrna_dimer_grid_t;
+
+/**
+ *  @brief  Data structure returned by vrna_pf_dimer_grid()
+ */
+struct vrna_dimer_grid_s {
+  double          temperature;  /**< @brief Temperature in &deg;C */
+  double          salt;         /**< @brief Salt concentration in M */
+  double          mfe;          /**< @brief Minimum free energy of the dimer in kcal/mol */
+  vrna_dimer_pf_t F;            /**< @brief Ensemble free energies of dimer and monomers in kcal/mol */
+  double          dG;           /**< @brief Free energy of hybridization @f$ F_{cAB} - F_A - F_B @f$ in kcal/mol */
+};
+
 struct vrna_multimer_pf_s {
   /* free energies for: */
   double  F_connected;  /**< @brief Fully connected ensemble (incl. DuplexInititiation and rotational symmetry correction */
@@ -139,6 +157,40 @@ vrna_pf_dimer(vrna_fold_compound_t  *fc,
               char                  *structure);
 
 
+/**
+ *  @brief  Compute dimer free energies over a grid of temperatures and salt concentrations
+ *
+ *  This function evaluates the minimum free energy and the dimer partition
+ *  functions, see vrna_pf_dimer(), for each combination of temperature and salt
+ *  concentration. Salt corrections are computed once for the entire grid by
+ *  vrna_salt_corrections(), and each grid point re-uses the sequence encoding,
+ *  pair type arrays and constraints of @p fc, such that only the energy parameters
+ *  are re-computed per grid point. Passing @em NULL for @p temperatures or @p salt
+ *  uses the temperature or salt concentration of the model details attached to
+ *  @p fc. Base pair probabilities are not computed and the energy parameters of
+ *  @p fc are restored on return.
+ *
+ *  The results are stored temperature-major, i.e. the free energies for the
+ *  @f$ t @f$-th temperature and @f$ s @f$-th salt concentration are found at
+ *  position @f$ t \cdot num\_salt + s @f$.
+ *
+ *  @see  vrna_pf_dimer(), vrna_salt_corrections(), vrna_params_salt(), vrna_exp_params_salt()
+ *
+ *  @param  fc                The fold compound data structure of the dimer
+ *  @param  temperatures      List of temperatures in &deg;C (may be @em NULL)
+ *  @param  num_temperatures  Number of temperatures in @p temperatures
+ *  @param  salt              List of salt concentrations in M (may be @em NULL)
+ *  @param  num_salt          Number of salt concentrations in @p salt
+ *  @return                   A list of free energies for all grid points, or @em NULL upon any failure
+ */
+vrna_dimer_grid_t *
+vrna_pf_dimer_grid(vrna_fold_compound_t *fc,
+                   const double         *temperatures,
+                   unsigned int         num_temperatures,
+                   const double         *salt,
+                   unsigned int         num_salt);
+
+
 FLT_OR_DBL *
 vrna_pf_substrands(vrna_fold_compound_t *fc,
                    size_t               complex_size);
@@ -148,6 +200,43 @@ vrna_pf_add(FLT_OR_DBL  dG1,
             FLT_OR_DBL  dG2,
             double      kT);
 
+
+/**
+ *  @brief  Compute the ensemble free energy of an RNA for multiple temperatures at once
+ *
+ *  Instead of running the partition function recursions once per temperature,
+ *  this function processes up to 16 temperatures within a single pass. All
+ *  temperatures share the same loop decomposition, hard constraint evaluation
+ *  and pair type lookups, while each entry of the dynamic programming matrices
+ *  holds a vector of Boltzmann weights, one per temperature. Multiple such
+ *  passes are distributed among threads if OpenMP support is enabled. The
+ *  number of temperatures per pass and the number of concurrent passes are
+ *  reduced for long sequences, such that the DP matrices of all concurrent
+ *  passes occupy at most 256 MB, or those of a single temperature if they
+ *  need more. The scaling factor for each temperature is estimated from the
+ *  MFE at the lowest temperature. The model details and hard constraints of
+ *  @p fc are used, only the temperature is replaced.
+ *
+ *  This is mainly useful for short sequences and dense temperature grids, e.g.
+ *  for melting curves. Base pair probabilities are not computed. Currently,
+ *  only single sequence fold compounds without soft constraints, unstructured
+ *  domains, grammar extensions, G-quadruplexes, or circular RNAs are supported,
+ *  and the model must use @p dangles = 0 or @p dangles = 2 and allow lonely pairs.
+ *
+ *  @see  vrna_pf(), vrna_heat_capacity()
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  temperatures  The list of temperatures in &deg;C
+ *  @param  num           The number of temperatures
+ *  @param  G             A pointer to an array of size @p num where the ensemble free energies (in kcal/mol) will be stored
+ *  @return               Non-zero on success, 0 if @p fc is not supported
+ */
+int
+vrna_pf_temperatures(vrna_fold_compound_t *fc,
+                     const double         *temperatures,
+                     unsigned int         num,
+                     FLT_OR_DBL           *G);
+
 /* End basic global interface */
 /**@}*/
 
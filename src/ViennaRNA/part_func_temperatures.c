@@ -0,0 +1,498 @@
+/*
+ *                partition function for multiple temperatures
+ *
+ *                Compute the partition function of a single RNA sequence for
+ *                many temperatures at once. All temperatures share the same
+ *                loop decomposition, i.e. each DP matrix entry holds a vector
+ *                of Boltzmann weights, one lane per temperature.
+ *
+ *                Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/fold_vars.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/constraints/soft.h"
+#include "ViennaRNA/part_func.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ #################################
+ # GLOBAL VARIABLES              #
+ #################################
+ */
+
+/*
+ #################################
+ # PRIVATE VARIABLES             #
+ #################################
+ */
+
+/* maximum number of temperatures processed within a single DP pass */
+#define PF_TEMPERATURE_LANES  16
+
+/*
+ *  for shorter sequences, setting up the Boltzmann factors of all lanes
+ *  dominates the run time, and the memory traffic of many simultaneous
+ *  parameter sets outweighs the shared decomposition
+ */
+#define PF_TEMPERATURE_LANES_MIN_LENGTH 32
+
+/*
+ *  upper limit for the memory of the DP matrices of all passes that run
+ *  concurrently. Each lane requires about 2.5 n^2 entries, so longer
+ *  sequences are processed with fewer lanes and threads
+ */
+#define PF_TEMPERATURE_MEMORY           ((size_t)1 << 28)
+
+struct pf_lanes {
+  vrna_fold_compound_t  *fc;
+  unsigned int          num;        /* number of lanes, i.e. temperatures */
+  vrna_exp_param_t      *P[PF_TEMPERATURE_LANES];
+  FLT_OR_DBL            *scale;     /* scale[k * num + t], scaling for k nucleotides at temperature t */
+  FLT_OR_DBL            *expMLbase; /* expMLbase[k * num + t] */
+  FLT_OR_DBL            *qb;        /* all matrices store vectors of length num at position my_iindx[i] - j */
+  FLT_OR_DBL            *qm;
+  FLT_OR_DBL            *qm1;
+  FLT_OR_DBL            *qb_ml;     /* qb times the Boltzmann weight of a multiloop stem */
+  FLT_OR_DBL            *qb_ext;    /* qb times the Boltzmann weight of an exterior loop stem */
+  FLT_OR_DBL            *q5;        /* q5[j * num + t] */
+};
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE int
+pf_temperatures_supported(vrna_fold_compound_t *fc);
+
+
+PRIVATE double
+pf_temperatures_mfe(vrna_fold_compound_t  *fc,
+                    double                temperature);
+
+
+PRIVATE void
+pf_lanes_init(struct pf_lanes       *dat,
+              vrna_fold_compound_t  *fc,
+              const double          *temperatures,
+              unsigned int          num,
+              double                T0,
+              double                mfe);
+
+
+PRIVATE void
+pf_lanes_free(struct pf_lanes *dat);
+
+
+PRIVATE void
+pf_lanes_fill(struct pf_lanes *dat);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC int
+vrna_pf_temperatures(vrna_fold_compound_t *fc,
+                     const double         *temperatures,
+                     unsigned int         num,
+                     FLT_OR_DBL           *G)
+{
+  unsigned int  i, width;
+  int           chunks, c;
+  size_t        lane_memory, threads;
+  double        T0, mfe;
+
+  if ((!fc) ||
+      (!temperatures) ||
+      (!G) ||
+      (!pf_temperatures_supported(fc)))
+    return 0;
+
+  if (num == 0)
+    return 1;
+
+  /* the MFE at the lowest temperature serves as reference for all scaling factors */
+  T0 = temperatures[0];
+  for (i = 1; i < num; i++)
+    T0 = MIN2(T0, temperatures[i]);
+
+  mfe         = pf_temperatures_mfe(fc, T0);
+  lane_memory = sizeof(FLT_OR_DBL) * 5 * ((((size_t)fc->length + 1) * (fc->length + 2)) / 2 + 1);
+  width       = (fc->length < PF_TEMPERATURE_LANES_MIN_LENGTH) ? 1 : PF_TEMPERATURE_LANES;
+  width       = (unsigned int)MAX2(1, MIN2(width, PF_TEMPERATURE_MEMORY / lane_memory));
+  chunks      = (int)((num + width - 1) / width);
+  threads     = MAX2(1, PF_TEMPERATURE_MEMORY / (width * lane_memory));
+
+#ifdef _OPENMP
+  threads = MIN2(threads, (size_t)omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic, 1) num_threads((int)threads)
+#else
+  (void)threads;
+#endif
+  for (c = 0; c < chunks; c++) {
+    unsigned int    t, n, from, lanes;
+    struct pf_lanes dat;
+
+    n     = fc->length;
+    from  = (unsigned int)c * width;
+    lanes = MIN2(width, num - from);
+
+    pf_lanes_init(&dat, fc, temperatures + from, lanes, T0, mfe);
+    pf_lanes_fill(&dat);
+
+    for (t = 0; t < lanes; t++)
+      G[from + t] = (FLT_OR_DBL)((-log(dat.q5[n * lanes + t]) -
+                                  n * log(dat.P[t]->pf_scale)) *
+                                 dat.P[t]->kT / 1000.);
+
+    pf_lanes_free(&dat);
+  }
+
+  return 1;
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE int
+pf_temperatures_supported(vrna_fold_compound_t *fc)
+{
+  vrna_md_t *md;
+
+  md = &(fc->params->model_details);
+
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands != 1) ||
+      (!fc->hc) ||
+      (fc->hc->type != VRNA_HC_DEFAULT) ||
+      (fc->hc->f) ||
+      (fc->sc) ||
+      (fc->domains_up) ||
+      (fc->aux_grammar) ||
+      (md->circ) ||
+      (md->gquad) ||
+      (md->noLP) ||
+      ((md->dangles != 0) && (md->dangles != 2)))
+    return 0;
+
+  return 1;
+}
+
+
+/*
+ *  Constraints can only increase the MFE, so an unconstrained fold compound
+ *  is sufficient to estimate the scaling factors
+ */
+PRIVATE double
+pf_temperatures_mfe(vrna_fold_compound_t  *fc,
+                    double                temperature)
+{
+  double                mfe;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *tmp;
+
+  md              = fc->params->model_details;
+  md.temperature  = temperature;
+  md.backtrack    = 0;
+  md.compute_bpp  = 0;
+
+  tmp = vrna_fold_compound(fc->sequence, &md, VRNA_OPTION_MFE);
+  mfe = (double)vrna_mfe(tmp, NULL);
+  vrna_fold_compound_free(tmp);
+
+  return mfe;
+}
+
+
+PRIVATE void
+pf_lanes_init(struct pf_lanes       *dat,
+              vrna_fold_compound_t  *fc,
+              const double          *temperatures,
+              unsigned int          num,
+              double                T0,
+              double                mfe)
+{
+  unsigned int  t, k, n, size;
+  double        e_per_nt, kT;
+  vrna_md_t     md;
+
+  n         = fc->length;
+  size      = ((n + 1) * (n + 2)) / 2 + 1;
+  dat->fc   = fc;
+  dat->num  = num;
+  md        = fc->params->model_details;
+
+  /*
+   *  Estimate the scaling factors from the MFE at the lowest temperature
+   *  and the average entropy of random sequences, similar to what the
+   *  heat capacity computations do
+   */
+  for (t = 0; t < num; t++) {
+    md.temperature  = temperatures[t];
+    dat->P[t]       = vrna_exp_params(&md);
+    kT              = dat->P[t]->kT;
+    e_per_nt        = (mfe + (temperatures[t] - T0) * 0.00727 * n) * 1000. / n;
+
+    dat->P[t]->pf_scale = exp(-(md.sfact * e_per_nt) / kT);
+  }
+
+  dat->scale      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2) * num);
+  dat->expMLbase  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2) * num);
+
+  for (t = 0; t < num; t++) {
+    dat->scale[t]           = 1.;
+    dat->scale[num + t]     = (FLT_OR_DBL)(1. / dat->P[t]->pf_scale);
+    dat->expMLbase[t]       = 1.;
+    dat->expMLbase[num + t] = (FLT_OR_DBL)(dat->P[t]->expMLbase / dat->P[t]->pf_scale);
+    for (k = 2; k <= n; k++) {
+      dat->scale[k * num + t] = dat->scale[(k / 2) * num + t] *
+                                dat->scale[(k - (k / 2)) * num + t];
+      dat->expMLbase[k * num + t] = (FLT_OR_DBL)pow(dat->P[t]->expMLbase, (double)k) *
+                                    dat->scale[k * num + t];
+    }
+  }
+
+  dat->qb     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * num);
+  dat->qm     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * num);
+  dat->qm1    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * num);
+  dat->qb_ml  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * num);
+  dat->qb_ext = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * num);
+  dat->q5     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1) * num);
+}
+
+
+PRIVATE void
+pf_lanes_free(struct pf_lanes *dat)
+{
+  unsigned int t;
+
+  for (t = 0; t < dat->num; t++)
+    free(dat->P[t]);
+
+  free(dat->scale);
+  free(dat->expMLbase);
+  free(dat->qb);
+  free(dat->qm);
+  free(dat->qm1);
+  free(dat->qb_ml);
+  free(dat->qb_ext);
+  free(dat->q5);
+}
+
+
+PRIVATE void
+pf_lanes_fill(struct pf_lanes *dat)
+{
+  char                  *sequence;
+  unsigned char         hc_ij;
+  short                 *S, *S1;
+  unsigned int          L, t;
+  int                   n, i, j, k, l, u, u1, u2, turn, type, type2, tt, ij, kl, *my_iindx,
+                        *up_ext, *up_hp, *up_int, *up_ml, dangles, n5d, n3d;
+  FLT_OR_DBL            *qb, *qm, *qm1, *qb_ml, *qb_ext, *q5, *scale, *expMLbase, *q_ij, *q_kl,
+                        *q_a, *q_b, tmp[PF_TEMPERATURE_LANES];
+  vrna_exp_param_t      **P;
+  vrna_md_t             *md;
+  vrna_hc_t             *hc;
+  vrna_fold_compound_t  *fc;
+
+  fc        = dat->fc;
+  L         = dat->num;
+  P         = dat->P;
+  n         = (int)fc->length;
+  sequence  = fc->sequence;
+  S         = fc->sequence_encoding2;
+  S1        = fc->sequence_encoding;
+  my_iindx  = fc->iindx;
+  hc        = fc->hc;
+  up_ext    = fc->hc->up_ext;
+  up_hp     = fc->hc->up_hp;
+  up_int    = fc->hc->up_int;
+  up_ml     = fc->hc->up_ml;
+  md        = &(P[0]->model_details);
+  turn      = md->min_loop_size;
+  dangles   = md->dangles;
+  scale     = dat->scale;
+  expMLbase = dat->expMLbase;
+  qb        = dat->qb;
+  qm        = dat->qm;
+  qm1       = dat->qm1;
+  qb_ml     = dat->qb_ml;
+  qb_ext    = dat->qb_ext;
+  q5        = dat->q5;
+
+  for (i = n - turn - 1; i >= 1; i--) {
+    for (j = i + turn + 1; j <= n; j++) {
+      ij    = my_iindx[i] - j;
+      q_ij  = qb + (size_t)ij * L;
+      hc_ij = vrna_hc_context(hc, i, j);
+
+      if (hc_ij) {
+        type = vrna_get_ptype_md(S[i], S[j], md);
+
+        /* hairpin loop */
+        u = j - i - 1;
+        if ((hc_ij & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) &&
+            (up_hp[i + 1] >= u))
+          for (t = 0; t < L; t++)
+            q_ij[t] = exp_E_Hairpin(u, type, S1[i + 1], S1[j - 1], sequence + i - 1, P[t]) *
+                      scale[(u + 2) * L + t];
+
+        /* interior loops */
+        if (hc_ij & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+          for (k = i + 1; k <= MIN2(i + MAXLOOP + 1, j - turn - 2); k++) {
+            u1 = k - i - 1;
+            if ((u1 > 0) && (up_int[i + 1] < u1))
+              break;
+
+            for (l = j - 1; l >= MAX2(k + turn + 1, j - 1 - MAXLOOP + u1); l--) {
+              u2 = j - l - 1;
+              if ((u2 > 0) && (up_int[l + 1] < u2))
+                break;
+
+              if (!(vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC))
+                continue;
+
+              kl    = my_iindx[k] - l;
+              q_kl  = qb + (size_t)kl * L;
+              type2 = md->rtype[vrna_get_ptype_md(S[k], S[l], md)];
+
+              for (t = 0; t < L; t++)
+                q_ij[t] += q_kl[t] *
+                           exp_E_IntLoop(u1,
+                                         u2,
+                                         type,
+                                         type2,
+                                         S1[i + 1],
+                                         S1[j - 1],
+                                         S1[k - 1],
+                                         S1[l + 1],
+                                         P[t]) *
+                           scale[(u1 + u2 + 2) * L + t];
+            }
+          }
+        }
+
+        /* multibranch loops */
+        if (hc_ij & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          for (t = 0; t < L; t++)
+            tmp[t] = 0.;
+
+          for (u = i + turn + 2; u < j - turn - 1; u++) {
+            q_a = qm + (size_t)(my_iindx[i + 1] - u + 1) * L;
+            q_b = qm1 + (size_t)(my_iindx[u] - j + 1) * L;
+            for (t = 0; t < L; t++)
+              tmp[t] += q_a[t] * q_b[t];
+          }
+
+          tt = md->rtype[type];
+          for (t = 0; t < L; t++)
+            q_ij[t] += tmp[t] *
+                       P[t]->expMLclosing *
+                       exp_E_MLstem(tt,
+                                    (dangles) ? S1[j - 1] : -1,
+                                    (dangles) ? S1[i + 1] : -1,
+                                    P[t]) *
+                       scale[2 * L + t];
+        }
+
+        /* stems as they appear in multibranch and exterior loops */
+        if (hc_ij & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+          q_a = qb_ml + (size_t)ij * L;
+          for (t = 0; t < L; t++)
+            q_a[t] = q_ij[t] *
+                     exp_E_MLstem(type,
+                                  (dangles) ? S1[i - 1] : -1,
+                                  (dangles) ? S1[j + 1] : -1,
+                                  P[t]);
+        }
+
+        if (hc_ij & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+          n5d = ((dangles) && (i > 1)) ? S1[i - 1] : -1;
+          n3d = ((dangles) && (j < n)) ? S1[j + 1] : -1;
+          q_a = qb_ext + (size_t)ij * L;
+          for (t = 0; t < L; t++)
+            q_a[t] = q_ij[t] *
+                     vrna_exp_E_ext_stem(type, n5d, n3d, P[t]);
+        }
+      }
+
+      /* qm1[i, j], a single stem (i, l) followed by unpaired nucleotides l + 1 ... j */
+      q_ij = qm1 + (size_t)ij * L;
+      for (l = j; l > i + turn; l--) {
+        if ((l < j) &&
+            (up_ml[l + 1] < j - l))
+          break;
+
+        q_a = qb_ml + (size_t)(my_iindx[i] - l) * L;
+        q_b = expMLbase + (size_t)(j - l) * L;
+        for (t = 0; t < L; t++)
+          q_ij[t] += q_a[t] * q_b[t];
+      }
+
+      /* qm[i, j], at least one stem within i ... j */
+      q_ij = qm + (size_t)ij * L;
+      for (k = i; k < j - turn; k++) {
+        q_b = qm1 + (size_t)(my_iindx[k] - j) * L;
+
+        if ((k == i) ||
+            (up_ml[i] >= k - i)) {
+          q_a = expMLbase + (size_t)(k - i) * L;
+          for (t = 0; t < L; t++)
+            q_ij[t] += q_a[t] * q_b[t];
+        }
+
+        if (k > i + turn + 1) {
+          q_a = qm + (size_t)(my_iindx[i] - k + 1) * L;
+          for (t = 0; t < L; t++)
+            q_ij[t] += q_a[t] * q_b[t];
+        }
+      }
+    }
+  }
+
+  /* exterior loop */
+  for (t = 0; t < L; t++)
+    q5[t] = 1.;
+
+  for (j = 1; j <= n; j++) {
+    q_ij = q5 + (size_t)j * L;
+
+    if (up_ext[j] >= 1)
+      for (t = 0; t < L; t++)
+        q_ij[t] = q5[(j - 1) * L + t] * scale[L + t];
+
+    for (k = 1; k < j - turn; k++) {
+      q_a = q5 + (size_t)(k - 1) * L;
+      q_b = qb_ext + (size_t)(my_iindx[k] - j) * L;
+      for (t = 0; t < L; t++)
+        q_ij[t] += q_a[t] * q_b[t];
+    }
+  }
+}
@@ -78,6 +78,7 @@
 #include "ViennaRNA/pair_mat.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/part_func.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/loops/all.h"
 #include "ViennaRNA/part_func_up.h"
 #include "ViennaRNA/duplex.h"
@@ -113,6 +114,20 @@ PRIVATE double            init_temp;      /* temperature in last call to scale_p
 PRIVATE int               *my_iindx = NULL;
 /* make iptypes array for intermolecular constrains (ipidx for indexing)*/
 
+struct vrna_up_engine_s {
+  int               length;
+  short             *S;           /* target encoding */
+  short             *S1;          /* target encoding for mismatches, S1[0] = 0 */
+  int               w;
+  int               incr3;
+  int               incr5;
+  int               pc_size;
+  double            *p_u;         /* p_u[i * pc_size + u], sum of the pu_contrib arrays */
+  vrna_md_t         md;
+  vrna_param_t      *P;           /* for the duplex estimate of the scaling factor */
+  vrna_exp_param_t  *exp_params;
+};
+
 
 /*
  #################################
@@ -182,6 +197,24 @@ get_interact_arrays(unsigned int  n1,
                     double        ***p_c2_S);
 
 
+PRIVATE char *
+up_engine_ptypes(const vrna_up_engine_t *engine,
+                 const short            *SS);
+
+
+PRIVATE int
+up_engine_duplex_energy(const vrna_up_engine_t  *engine,
+                        const short             *SS,
+                        const short             *SS2);
+
+
+PRIVATE INLINE void
+qint_axpy(FLT_OR_DBL        *dst,
+          const FLT_OR_DBL  *src,
+          FLT_OR_DBL        e,
+          int               n);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -1745,3 +1778,466 @@ set_encoded_seq(const char  *sequence,
     (*S1)[0]      = (*S1)[l];
   }
 }
+
+
+/*
+ #################################
+ # Reentrant interaction engine  #
+ #################################
+ */
+PUBLIC vrna_up_engine_t *
+vrna_up_engine(const char       *target,
+               const pu_contrib *p_c,
+               int              w,
+               int              incr3,
+               int              incr5,
+               const vrna_md_t  *md)
+{
+  int               i, u, n;
+  vrna_up_engine_t  *engine;
+
+  if ((!target) ||
+      (!p_c) ||
+      (w <= 0) ||
+      (incr3 < 0) ||
+      (incr5 < 0))
+    return NULL;
+
+  n = (int)strlen(target);
+
+  if ((n == 0) ||
+      (p_c->length < n) ||
+      (p_c->w + 1 < MIN2(w + incr5 + incr3, n))) {
+    vrna_message_warning("vrna_up_engine: "
+                         "probabilities of being unpaired do not cover the target for w = %d",
+                         w + incr5 + incr3);
+    return NULL;
+  }
+
+  engine          = (vrna_up_engine_t *)vrna_alloc(sizeof(vrna_up_engine_t));
+  engine->length  = n;
+  engine->w       = w;
+  engine->incr3   = incr3;
+  engine->incr5   = incr5;
+  engine->pc_size = MIN2(w + incr5 + incr3, n);
+
+  if (md)
+    engine->md = *md;
+  else
+    set_model_details(&(engine->md));
+
+  engine->S   = vrna_seq_encode_simple(target, &(engine->md));
+  engine->S1  = vrna_seq_encode(target, &(engine->md));
+  /* same as the encoding used by pf_interact() */
+  engine->S1[0] = 0;
+
+  engine->P           = vrna_params(&(engine->md));
+  engine->exp_params  = vrna_exp_params(&(engine->md));
+
+  /* collapse all loop type contributions once */
+  engine->p_u = (double *)vrna_alloc(sizeof(double) * (n + 1) * engine->pc_size);
+  for (i = 1; i <= n; i++)
+    for (u = 0; u < engine->pc_size; u++)
+      engine->p_u[i * engine->pc_size + u] = p_c->H[i][u] + p_c->I[i][u] + p_c->M[i][u] +
+                                             p_c->E[i][u];
+
+  return engine;
+}
+
+
+PUBLIC void
+vrna_up_engine_free(vrna_up_engine_t *engine)
+{
+  if (engine) {
+    free(engine->S);
+    free(engine->S1);
+    free(engine->P);
+    free(engine->exp_params);
+    free(engine->p_u);
+    free(engine);
+  }
+}
+
+
+/*
+ *  Same recursions as pf_interact() for the unconstrained case. The
+ *  qint_4[i][j][a][b] arrays of the last w positions i of the target are kept
+ *  in a ring buffer of contiguous (w + 1) x (w + 1) blocks, and the
+ *  contributions qint_ik[k][i] are stored as band of width w.
+ */
+PUBLIC interact *
+vrna_up_engine_interact(const vrna_up_engine_t  *engine,
+                        const char              *query,
+                        const pu_contrib        *p_c2)
+{
+  int               i, j, k, l, a, b, x, n1, n2, w, isw, ws, pc2_size, end_k, type, type2,
+                    add_i5, add_i3, amax, bmax, gi, gj, gk, gl, Emin;
+  short             *S1, *SS, *SS2;
+  char              *ptypes;
+  size_t            cell_size, slot_size;
+  double            Z, E, rev_d, temp, tt, intt, scalew, G_min, G_is, Gi_min, mfe, int_scale,
+                    const_scale, const_T, *p_u, *p_c2_S;
+  FLT_OR_DBL        *scale, *qint, *qint_ik, *q_ij, *q_kl;
+  vrna_md_t         md;
+  vrna_exp_param_t  *pf;
+  interact          *Int;
+
+  if ((!engine) ||
+      (!query) ||
+      (*query == '\0'))
+    return NULL;
+
+  n1    = engine->length;
+  n2    = (int)strlen(query);
+  w     = engine->w;
+  isw   = w / 2;
+  ws    = w + 1;
+  S1    = engine->S1;
+  p_u   = engine->p_u;
+  pf    = engine->exp_params;
+  md    = engine->md;
+  gi    = gj = gk = gl = 0;
+  G_min = G_is = Gi_min = 100.0;
+
+  SS  = vrna_seq_encode_simple(query, &md);
+  SS2 = vrna_seq_encode(query, &md);
+
+  ptypes = up_engine_ptypes(engine, SS);
+
+  /* use RNAduplex energy to get a realistic estimate for the scaling factor */
+  Emin      = up_engine_duplex_energy(engine, SS, SS2);
+  int_scale = 1.;
+  if (Emin < INF) {
+    mfe       = (float)Emin / 100.;
+    int_scale = exp(-mfe / (pf->kT / 1000.0) / n2);
+  }
+
+  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (2 * w + 2));
+  scale[0]  = 1.;
+  scale[1]  = 1. / int_scale;
+  for (i = 2; i <= 2 * w + 1; i++)
+    scale[i] = scale[i / 2] * scale[i - (i / 2)];
+
+  p_c2_S = NULL;
+  if (p_c2) {
+    pc2_size  = MIN2(w, n2);
+    p_c2_S    = (double *)vrna_alloc(sizeof(double) * (n2 + 1) * (pc2_size + 2));
+    for (j = 1; j <= n2; j++)
+      for (b = 0; b < pc2_size; b++)
+        p_c2_S[j * (pc2_size + 2) + b] = p_c2->H[j][b] + p_c2->I[j][b] + p_c2->M[j][b] +
+                                         p_c2->E[j][b];
+  } else {
+    pc2_size = 0;
+  }
+
+  cell_size = (size_t)ws * ws;
+  slot_size = cell_size * (n2 + 1);
+  qint      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * slot_size * w);
+  qint_ik   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1) * w);
+
+  Int     = (interact *)vrna_alloc(sizeof(interact));
+  Int->Pi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
+  Int->Gi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
+
+  const_scale = isw * log(int_scale);
+  const_T     = pf->kT / 1000.0;
+  Z           = 0.;
+
+  for (i = 1; i <= n1; i++) {
+    end_k = i - w;
+    memset(qint + (size_t)(i % w) * slot_size, 0, sizeof(FLT_OR_DBL) * slot_size);
+
+    for (j = n2; j > 0; j--) {
+      type = ptypes[i * (n2 + 1) + j];
+      if (!type)
+        continue;
+
+      q_ij    = qint + (size_t)(i % w) * slot_size + (size_t)j * cell_size;
+      q_ij[0] = pf->expDuplexInit;
+      q_ij[0] *= vrna_exp_E_ext_stem(type,
+                                     (i > 1) ? S1[i - 1] : -1,
+                                     (j < n2) ? SS2[j + 1] : -1,
+                                     pf);
+
+      rev_d = vrna_exp_E_ext_stem(md.rtype[type],
+                                  (j > 1) ? SS2[j - 1] : -1,
+                                  (i < n1) ? S1[i + 1] : -1,
+                                  pf);
+
+      add_i5  = (i - engine->incr5 > 0) ? i - engine->incr5 : 1;
+      add_i3  = (engine->incr3 < engine->pc_size) ? engine->incr3 : engine->pc_size - 1;
+
+      /* only one bp (no interior loop) */
+      if (p_c2_S)
+        tt = q_ij[0] * rev_d * p_u[add_i5 * engine->pc_size + add_i3] *
+             p_c2_S[j * (pc2_size + 2)] * scale[isw];
+      else
+        tt = q_ij[0] * rev_d * p_u[add_i5 * engine->pc_size + add_i3] * scale[isw];
+
+      qint_ik[i * w] += tt;
+      Z              += tt;
+
+      temp = 0.;
+      for (k = i - 1; k > end_k && k > 0; k--) {
+        for (l = j + 1; l < j + w && l <= n2; l++) {
+          type2 = ptypes[k * (n2 + 1) + l];
+          if (!type2)
+            continue;
+
+          a = i - k;
+          b = l - j;
+
+          /* scale everything to w/2 */
+          if ((a + b) < isw)
+            scalew = scale[isw - (a + b)];
+          else if ((a + b) > isw)
+            scalew = 1 / (scale[(a + b) - isw]);
+          else
+            scalew = 1;
+
+          if (a + b - 2 <= MAXLOOP) {
+            E = exp_E_IntLoop(a - 1, b - 1, type2, md.rtype[type],
+                              S1[k + 1], SS2[l - 1], S1[i - 1], SS2[j + 1], pf) *
+                scale[a + b];
+
+            q_kl = qint + (size_t)(k % w) * slot_size + (size_t)l * cell_size;
+
+            q_ij[a * ws + b] += q_kl[0] * E;
+
+            /* extend all interactions starting at (k, l) by the interior loop (i, j) -> (k, l) */
+            amax  = MIN2(w - a, i - a);
+            bmax  = MIN2(w - b, n2 - j - b + 1);
+            if (bmax > 1)
+              for (x = 1; x < amax; x++)
+                qint_axpy(q_ij + (a + x) * ws + b + 1,
+                          q_kl + x * ws + 1,
+                          E,
+                          bmax - 1);
+          }
+
+          add_i5  = (k - engine->incr5 > 0) ? k - engine->incr5 : 1;
+          add_i3  = (a + engine->incr3 < engine->pc_size) ? a + engine->incr3 : engine->pc_size - 1;
+
+          if (p_c2_S)
+            tt = q_ij[a * ws + b] * p_u[add_i5 * engine->pc_size + add_i3] *
+                 p_c2_S[j * (pc2_size + 2) + b] * scalew * rev_d;
+          else
+            tt = q_ij[a * ws + b] * p_u[add_i5 * engine->pc_size + add_i3] * scalew * rev_d;
+
+          temp              += tt;
+          qint_ik[k * w + a] += tt;
+          intt              = q_ij[a * ws + b] * scalew * rev_d;
+          G_is              = (-log(tt) - const_scale) * (const_T);
+          if (G_is < G_min || EQUAL(G_is, G_min)) {
+            G_min   = G_is;
+            Gi_min  = (-log(intt) - const_scale) * (const_T);
+            gi      = i;
+            gj      = j;
+            gk      = k;
+            gl      = l;
+          }
+        }
+      }
+      Z += temp;
+    }
+  }
+
+  for (i = 1; i <= n1; i++) {
+    for (k = i; k <= n1 && k < i + w; k++) {
+      for (l = i; l <= k; l++) {
+        Int->Pi[l]  += qint_ik[i * w + k - i] / Z;
+        Int->Gi[l]  = MIN2(Int->Gi[l],
+                           (-log(qint_ik[i * w + k - i]) - const_scale) * const_T);
+      }
+    }
+  }
+
+  Int->length   = n1;
+  Int->i        = gi;
+  Int->j        = gj;
+  Int->k        = gk;
+  Int->l        = gl;
+  Int->Gikjl    = G_min;
+  Int->Gikjl_wo = Gi_min;
+
+  free(SS);
+  free(SS2);
+  free(ptypes);
+  free(scale);
+  free(p_c2_S);
+  free(qint);
+  free(qint_ik);
+
+  return Int;
+}
+
+
+PUBLIC interact **
+vrna_up_engine_interact_multi(vrna_up_engine_t  **engines,
+                              unsigned int      num_engines,
+                              const char        **queries,
+                              pu_contrib        **p_c2,
+                              unsigned int      num_queries)
+{
+  int       c, num;
+  interact  **results;
+
+  if ((!engines) ||
+      (!queries) ||
+      (num_engines == 0) ||
+      (num_queries == 0))
+    return NULL;
+
+  num     = (int)(num_engines * num_queries);
+  results = (interact **)vrna_alloc(sizeof(interact *) * num);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (c = 0; c < num; c++)
+    results[c] = vrna_up_engine_interact(engines[c / num_queries],
+                                         queries[c % num_queries],
+                                         (p_c2) ? p_c2[c % num_queries] : NULL);
+
+  return results;
+}
+
+
+PUBLIC void
+vrna_up_interact_free(interact *pin)
+{
+  if (pin) {
+    free(pin->Pi);
+    free(pin->Gi);
+    free(pin);
+  }
+}
+
+
+/*
+ *  Pair types between target position i and query position j, stored
+ *  at ptypes[i * (n2 + 1) + j]. Lonely pairs are removed the same way
+ *  get_ptypes_up() does for the concatenated sequence
+ */
+PRIVATE char *
+up_engine_ptypes(const vrna_up_engine_t *engine,
+                 const short            *SS)
+{
+  int   i, j, n1, n2, type, inner, outer;
+  char  *ptypes;
+  short *S;
+
+  S       = engine->S;
+  n1      = engine->length;
+  n2      = SS[0];
+  ptypes  = (char *)vrna_alloc(sizeof(char) * (n1 + 1) * (n2 + 1));
+
+  for (i = 1; i <= n1; i++)
+    for (j = 1; j <= n2; j++) {
+      type = engine->md.pair[S[i]][SS[j]];
+
+      if ((type) && (engine->md.noLP)) {
+        /* inner pair (i + 1, n1 + j - 1) of the concatenated sequence */
+        if (n1 + j - i < 3)
+          inner = 0;
+        else if (i == n1)
+          inner = engine->md.pair[SS[1]][SS[j - 1]];
+        else if (j == 1)
+          inner = engine->md.pair[S[i + 1]][S[n1]];
+        else
+          inner = engine->md.pair[S[i + 1]][SS[j - 1]];
+
+        /* outer pair (i - 1, n1 + j + 1), lonely pairs at the ends are kept */
+        if ((i > 1) && (j < n2))
+          outer = engine->md.pair[S[i - 1]][SS[j + 1]];
+        else
+          outer = type;
+
+        if ((!inner) && (!outer))
+          type = 0;
+      }
+
+      ptypes[i * (n2 + 1) + j] = (char)type;
+    }
+
+  return ptypes;
+}
+
+
+/*
+ *  MFE of the duplex between query and target as in duplexfold(query, target)
+ */
+PRIVATE int
+up_engine_duplex_energy(const vrna_up_engine_t  *engine,
+                        const short             *SS,
+                        const short             *SS2)
+{
+  int           i, j, k, l, n1, n2, type, type2, E, Emin, **c;
+  short         *S, *S1;
+  vrna_param_t  *P;
+
+  P     = engine->P;
+  S     = engine->S;
+  S1    = engine->S1;
+  n1    = SS[0];
+  n2    = engine->length;
+  Emin  = INF;
+
+  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  for (i = 1; i <= n1; i++)
+    c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+
+  for (i = 1; i <= n1; i++) {
+    for (j = n2; j > 0; j--) {
+      type    = engine->md.pair[SS[i]][S[j]];
+      c[i][j] = type ? P->DuplexInit : INF;
+      if (!type)
+        continue;
+
+      c[i][j] += vrna_E_ext_stem(type, (i > 1) ? SS2[i - 1] : -1, (j < n2) ? S1[j + 1] : -1, P);
+      for (k = i - 1; k > 0 && k > i - MAXLOOP - 2; k--) {
+        for (l = j + 1; l <= n2; l++) {
+          if (i - k + l - j - 2 > MAXLOOP)
+            break;
+
+          type2 = engine->md.pair[SS[k]][S[l]];
+          if (!type2)
+            continue;
+
+          E       = E_IntLoop(i - k - 1, l - j - 1, type2, engine->md.rtype[type],
+                              SS2[k + 1], S1[l - 1], SS2[i - 1], S1[j + 1], P);
+          c[i][j] = MIN2(c[i][j], c[k][l] + E);
+        }
+      }
+      E = c[i][j];
+      E += vrna_E_ext_stem(engine->md.rtype[type],
+                           (j > 1) ? S1[j - 1] : -1,
+                           (i < n1) ? SS2[i + 1] : -1,
+                           P);
+      if (E < Emin)
+        Emin = E;
+    }
+  }
+
+  for (i = 1; i <= n1; i++)
+    free(c[i]);
+  free(c);
+
+  return Emin;
+}
+
+
+PRIVATE INLINE void
+qint_axpy(FLT_OR_DBL        *dst,
+          const FLT_OR_DBL  *src,
+          FLT_OR_DBL        e,
+          int               n)
+{
+  int x;
+
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+  for (x = 0; x < n; x++)
+    dst[x] += src[x] * e;
+}
@@ -2,6 +2,14 @@
 #define VIENNA_RNA_PACKAGE_PART_FUNC_UP_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
+
+/**
+ *  @brief  A reentrant engine for RNA-RNA interactions with a single target RNA
+ *
+ *  @see vrna_up_engine(), vrna_up_engine_interact(), vrna_up_engine_free()
+ */
+typedef struct vrna_up_engine_s vrna_up_engine_t;
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -137,4 +145,114 @@ free_pu_contrib(pu_contrib *pu);
 
 #endif
 
+/**
+ *  @addtogroup up_cofold
+ *  @{
+ */
+
+/**
+ *  @brief  Prepare a reentrant interaction engine for a target RNA
+ *
+ *  The engine stores everything that pf_interact() would otherwise re-compute
+ *  for each query of the same target, i.e. the sequence encoding, the energy
+ *  parameters, and the probabilities of being unpaired for all stretches of
+ *  up to @f$ w + incr5 + incr3 @f$ nucleotides as obtained from pf_unstru().
+ *  Afterwards, interactions with arbitrarily many query RNAs can be evaluated
+ *  with vrna_up_engine_interact(), concurrently from as many threads as
+ *  desired, since the engine itself is never modified.
+ *
+ *  Model details default to the global settings when @p md is @em NULL.
+ *  In contrast to pf_interact(), no intermolecular constraints are supported.
+ *
+ *  @see  vrna_up_engine_interact(), vrna_up_engine_interact_multi(), vrna_up_engine_free(), pf_unstru()
+ *
+ *  @param  target    The (longer) target RNA sequence
+ *  @param  p_c       Contributions to the probabilities of being unpaired of @p target as obtained from pf_unstru()
+ *  @param  w         The maximal length of the region of interaction
+ *  @param  incr3     Number of unpaired nucleotides 3' of the interaction in @p target
+ *  @param  incr5     Number of unpaired nucleotides 5' of the interaction in @p target
+ *  @param  md        The model details (may be @em NULL)
+ *  @return           The interaction engine, or @em NULL on any error
+ */
+vrna_up_engine_t *
+vrna_up_engine(const char       *target,
+               const pu_contrib *p_c,
+               int              w,
+               int              incr3,
+               int              incr5,
+               const vrna_md_t  *md);
+
+
+/**
+ *  @brief  Free memory occupied by an interaction engine
+ *
+ *  @see  vrna_up_engine()
+ *
+ *  @param  engine  The interaction engine
+ */
+void
+vrna_up_engine_free(vrna_up_engine_t *engine);
+
+
+/**
+ *  @brief  Compute the interaction of a query RNA with the target of an engine
+ *
+ *  This is the reentrant counterpart of pf_interact() for the target @p engine
+ *  has been prepared for. All intermediate data is local to the call, so
+ *  different threads may use the same engine at the same time. It evaluates
+ *  the same recursions as pf_interact() does without constraints.
+ *
+ *  @see  vrna_up_engine(), vrna_up_interact_free(), pf_interact()
+ *
+ *  @param  engine  The interaction engine of the target RNA
+ *  @param  query   The (shorter) query RNA sequence
+ *  @param  p_c2    Contributions to the probabilities of being unpaired of @p query (may be @em NULL)
+ *  @return         The interaction data, or @em NULL on any error. Use vrna_up_interact_free() to release it
+ */
+interact *
+vrna_up_engine_interact(const vrna_up_engine_t  *engine,
+                        const char              *query,
+                        const pu_contrib        *p_c2);
+
+
+/**
+ *  @brief  Compute the interactions of many query RNAs with many targets
+ *
+ *  Evaluates all combinations of @p num_engines target engines and @p num_queries
+ *  query sequences. If OpenMP support is enabled, the combinations are processed
+ *  in parallel. The interaction of query @f$ q @f$ with target @f$ e @f$ is stored
+ *  at position @f$ e \cdot num\_queries + q @f$ of the returned array.
+ *
+ *  @see  vrna_up_engine_interact()
+ *
+ *  @param  engines       The interaction engines of the target RNAs
+ *  @param  num_engines   The number of engines
+ *  @param  queries       The query RNA sequences
+ *  @param  p_c2          Contributions to the probabilities of being unpaired of each query (may be @em NULL)
+ *  @param  num_queries   The number of queries
+ *  @return               An array of @f$ num\_engines \cdot num\_queries @f$ interactions, or @em NULL on any error
+ */
+interact **
+vrna_up_engine_interact_multi(vrna_up_engine_t  **engines,
+                              unsigned int      num_engines,
+                              const char        **queries,
+                              pu_contrib        **p_c2,
+                              unsigned int      num_queries);
+
+
+/**
+ *  @brief  Free the output of vrna_up_engine_interact()
+ *
+ *  In contrast to free_interact(), this function doesn't touch any global state.
+ *
+ *  @param  pin   The interaction data
+ */
+void
+vrna_up_interact_free(interact *pin);
+
+
+/**
+ * @}
+ */
+
 #endif
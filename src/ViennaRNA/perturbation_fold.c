@@ -12,16 +12,27 @@
 #include <gsl/gsl_multimin.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/eval.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/fold.h"
+#include "ViennaRNA/dp_matrices.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/perturbation_fold.h"
 
+/* number of correction pairs kept by the L-BFGS minimizer */
+#define LBFGS_HISTORY     5
+
+/* sufficient decrease parameter of the L-BFGS line search */
+#define LBFGS_ARMIJO      1e-4
+
 static void
 calculate_probability_unpaired(vrna_fold_compound_t *vc,
                                double               *probability)
@@ -74,6 +85,7 @@ addSoftConstraint(vrna_fold_compound_t  *vc,
 
   /* add new soft constraints */
   vrna_sc_set_up(vc, (const FLT_OR_DBL *)constraints, VRNA_OPTION_DEFAULT);
+  vrna_sc_prepare(vc, VRNA_OPTION_MFE | VRNA_OPTION_PF);
 
   free(constraints);
 }
@@ -145,6 +157,183 @@ evaluate_perturbation_vector_score(vrna_fold_compound_t *vc,
 }
 
 
+static int
+evaluation_threads(vrna_fold_compound_t *vc,
+                   unsigned int         num)
+{
+  int threads = 1;
+
+#ifdef _OPENMP
+  /* user callbacks and the multi-strand grammar extension can't be shared among threads */
+  if ((vc->strands == 1) &&
+      (!vc->stat_cb) &&
+      (!vc->aux_grammar))
+    threads = MIN2(omp_get_max_threads(), (int)num);
+#endif
+
+  return threads;
+}
+
+
+/*
+ *  Evaluate the objective function for num perturbation vectors at once.
+ *  Each thread works on a shallow copy of the fold compound that shares
+ *  sequence encodings, pair type arrays and hard constraints with the
+ *  original, but owns its energy parameters, soft constraints and DP
+ *  matrices.
+ */
+static void
+evaluate_perturbation_vector_scores(vrna_fold_compound_t  *vc,
+                                    double                **epsilons,
+                                    unsigned int          num,
+                                    const double          *q_prob_unpaired,
+                                    double                sigma_squared,
+                                    double                tau_squared,
+                                    int                   objective_function,
+                                    double                *scores)
+{
+  unsigned int  k;
+  int           threads;
+
+  threads = evaluation_threads(vc, num);
+
+  if (threads <= 1) {
+    for (k = 0; k < num; k++)
+      scores[k] = evaluate_perturbation_vector_score(vc,
+                                                     epsilons[k],
+                                                     q_prob_unpaired,
+                                                     sigma_squared,
+                                                     tau_squared,
+                                                     objective_function);
+
+    return;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads) private(k)
+  {
+    vrna_fold_compound_t *worker;
+
+    worker = (vrna_fold_compound_t *)vrna_alloc(sizeof(vrna_fold_compound_t));
+    memcpy(worker, vc, sizeof(vrna_fold_compound_t));
+    worker->params        = vrna_params_copy(vc->params);
+    worker->exp_params    = vrna_exp_params_copy(vc->exp_params);
+    worker->matrices      = NULL;
+    worker->exp_matrices  = NULL;
+    worker->sc            = NULL;
+
+#pragma omp for schedule(dynamic, 1)
+    for (k = 0; k < num; k++)
+      scores[k] = evaluate_perturbation_vector_score(worker,
+                                                     epsilons[k],
+                                                     q_prob_unpaired,
+                                                     sigma_squared,
+                                                     tau_squared,
+                                                     objective_function);
+
+    vrna_sc_remove(worker);
+    vrna_mx_mfe_free(worker);
+    vrna_mx_pf_free(worker);
+    free(worker->params);
+    free(worker->exp_params);
+    free(worker);
+  }
+#endif
+}
+
+
+/*
+ *  Backtracking line search along direction, starting at step_size and
+ *  halving it until a trial point is accepted or the step size drops below
+ *  min_step_size. If c1 > 0, trial points must satisfy the Armijo condition
+ *  with respect to the directional derivative slope, otherwise they must
+ *  improve the score by at least a fraction of min_improvement. As many
+ *  trial points as there are threads available are evaluated concurrently.
+ *  Returns non-zero if a trial point was accepted. In any case, new_epsilon
+ *  and new_score hold the last trial point that has been inspected.
+ */
+static int
+line_search(vrna_fold_compound_t  *vc,
+            const double          *epsilon,
+            const double          *direction,
+            double                score,
+            double                slope,
+            double                step_size,
+            double                min_step_size,
+            double                min_improvement,
+            double                c1,
+            const double          *q_prob_unpaired,
+            double                sigma_squared,
+            double                tau_squared,
+            int                   objective_function,
+            double                *new_epsilon,
+            double                *new_score)
+{
+  unsigned int  k, num, batch;
+  int           i, accepted, length;
+  double        **trials, *steps, *scores;
+
+  length    = vc->length;
+  batch     = (unsigned int)evaluation_threads(vc, 1024);
+  trials    = (double **)vrna_alloc(sizeof(double *) * batch);
+  steps     = (double *)vrna_alloc(sizeof(double) * batch);
+  scores    = (double *)vrna_alloc(sizeof(double) * batch);
+  accepted  = 0;
+
+  for (k = 0; k < batch; k++)
+    trials[k] = (double *)vrna_alloc(sizeof(double) * (length + 1));
+
+  do {
+    /* collect a batch of successively halved step sizes */
+    for (num = 0; num < batch;) {
+      for (i = 1; i <= length; ++i)
+        trials[num][i] = epsilon[i] + step_size * direction[i];
+
+      steps[num++]  = step_size;
+      step_size     /= 2;
+
+      if (step_size < min_step_size)
+        break;
+    }
+
+    evaluate_perturbation_vector_scores(vc,
+                                        trials,
+                                        num,
+                                        q_prob_unpaired,
+                                        sigma_squared,
+                                        tau_squared,
+                                        objective_function,
+                                        scores);
+
+    /* take the largest step that has been accepted */
+    for (k = 0; k < num; k++) {
+      if (c1 > 0.)
+        accepted = (scores[k] <= score + c1 * steps[k] * slope) ? 1 : 0;
+      else
+        accepted = (1 - scores[k] / score >= min_improvement) ? 1 : 0;
+
+      if (accepted)
+        break;
+    }
+
+    if (k == num)
+      k--;
+
+    *new_score = scores[k];
+    memcpy(new_epsilon, trials[k], sizeof(double) * (length + 1));
+  } while ((!accepted) && (step_size >= min_step_size));
+
+  for (k = 0; k < batch; k++)
+    free(trials[k]);
+
+  free(trials);
+  free(steps);
+  free(scores);
+
+  return accepted;
+}
+
+
 static void
 pairing_probabilities_from_restricted_pf(vrna_fold_compound_t *vc,
                                          const double         *epsilon,
@@ -188,6 +377,7 @@ pairing_probabilities_from_restricted_pf(vrna_fold_compound_t *vc,
                                        &(vc->exp_params->model_details),
                                        VRNA_OPTION_DEFAULT);
     vrna_constraints_add(restricted_vc, hc_string, constraint_options);
+    vrna_hc_prepare(restricted_vc, VRNA_OPTION_PF);
     free(hc_string);
 
     vrna_exp_params_subst(restricted_vc, vc->exp_params);
@@ -420,6 +610,220 @@ fdf_gsl(const gsl_vector  *x,
 
 #endif /* VRNA_WITH_GSL */
 
+static double
+dot_product(const double  *a,
+            const double  *b,
+            int           length)
+{
+  double  sum = 0.;
+  int     i;
+
+  for (i = 1; i <= length; ++i)
+    sum += a[i] * b[i];
+
+  return sum;
+}
+
+
+/*
+ *  Limited-memory BFGS minimization of the objective function. The search
+ *  direction is obtained from the two-loop recursion over the last
+ *  LBFGS_HISTORY correction pairs, and the step length from a backtracking
+ *  line search with Armijo condition. If no curvature information is
+ *  available (first iteration, or after a failed line search), a steepest
+ *  descent step of length initialStepSize is attempted instead.
+ */
+static void
+minimize_lbfgs(vrna_fold_compound_t *vc,
+               const double         *q_prob_unpaired,
+               int                  objective_function,
+               double               sigma_squared,
+               double               tau_squared,
+               int                  sample_size,
+               double               *epsilon,
+               double               initialStepSize,
+               double               minStepSize,
+               double               minImprovement,
+               double               minimizerTolerance,
+               int                  max_iterations,
+               progress_callback    callback)
+{
+  const char  *reason;
+  int         i, k, idx, length, iteration_count, history, newest, accepted;
+  double      score, new_score, improvement, slope, gamma, beta, sy, gradient_norm;
+  double      *gradient, *new_gradient, *new_epsilon, *direction;
+  double      *s[LBFGS_HISTORY], *y[LBFGS_HISTORY], rho[LBFGS_HISTORY], alpha[LBFGS_HISTORY];
+
+  length          = vc->length;
+  iteration_count = 0;
+  history         = 0;
+  newest          = -1;
+  gradient        = vrna_alloc(sizeof(double) * (length + 1));
+  new_gradient    = vrna_alloc(sizeof(double) * (length + 1));
+  new_epsilon     = vrna_alloc(sizeof(double) * (length + 1));
+  direction       = vrna_alloc(sizeof(double) * (length + 1));
+
+  for (k = 0; k < LBFGS_HISTORY; k++) {
+    s[k]  = vrna_alloc(sizeof(double) * (length + 1));
+    y[k]  = vrna_alloc(sizeof(double) * (length + 1));
+  }
+
+  score = evaluate_perturbation_vector_score(vc,
+                                             epsilon,
+                                             q_prob_unpaired,
+                                             sigma_squared,
+                                             tau_squared,
+                                             objective_function);
+
+  if (callback)
+    callback(0, score, epsilon);
+
+  evaluate_perturbation_vector_gradient(vc,
+                                        epsilon,
+                                        q_prob_unpaired,
+                                        sigma_squared,
+                                        tau_squared,
+                                        objective_function,
+                                        sample_size,
+                                        gradient);
+
+  while (1) {
+    gradient_norm = sqrt(dot_product(gradient, gradient, length));
+
+    if (gradient_norm <= minimizerTolerance) {
+      reason = "gradient norm below tolerance";
+      break;
+    }
+
+    if (iteration_count >= max_iterations) {
+      reason = "maximum number of iterations reached";
+      break;
+    }
+
+    ++iteration_count;
+
+    /* two-loop recursion, direction = -H * gradient */
+    for (i = 1; i <= length; ++i)
+      direction[i] = -gradient[i];
+
+    for (k = 0; k < history; k++) {
+      idx         = (newest - k + LBFGS_HISTORY) % LBFGS_HISTORY;
+      alpha[idx]  = rho[idx] * dot_product(s[idx], direction, length);
+      for (i = 1; i <= length; ++i)
+        direction[i] -= alpha[idx] * y[idx][i];
+    }
+
+    if (history > 0)
+      gamma = dot_product(s[newest], y[newest], length) /
+              dot_product(y[newest], y[newest], length);
+    else
+      gamma = initialStepSize;
+
+    for (i = 1; i <= length; ++i)
+      direction[i] *= gamma;
+
+    for (k = history - 1; k >= 0; k--) {
+      idx   = (newest - k + LBFGS_HISTORY) % LBFGS_HISTORY;
+      beta  = rho[idx] * dot_product(y[idx], direction, length);
+      for (i = 1; i <= length; ++i)
+        direction[i] += (alpha[idx] - beta) * s[idx][i];
+    }
+
+    slope = dot_product(gradient, direction, length);
+
+    if ((history > 0) && (slope >= 0.)) {
+      /* not a descent direction, fall back to steepest descent */
+      history = 0;
+      for (i = 1; i <= length; ++i)
+        direction[i] = -initialStepSize * gradient[i];
+      slope = dot_product(gradient, direction, length);
+    }
+
+    accepted = line_search(vc,
+                           epsilon,
+                           direction,
+                           score,
+                           slope,
+                           1.,
+                           minStepSize / initialStepSize,
+                           minImprovement,
+                           LBFGS_ARMIJO,
+                           q_prob_unpaired,
+                           sigma_squared,
+                           tau_squared,
+                           objective_function,
+                           new_epsilon,
+                           &new_score);
+
+    if (!accepted) {
+      if (history > 0) {
+        /* discard curvature information and retry with steepest descent */
+        history = 0;
+        --iteration_count;
+        continue;
+      }
+
+      reason = "line search failed";
+      break;
+    }
+
+    evaluate_perturbation_vector_gradient(vc,
+                                          new_epsilon,
+                                          q_prob_unpaired,
+                                          sigma_squared,
+                                          tau_squared,
+                                          objective_function,
+                                          sample_size,
+                                          new_gradient);
+
+    /* store correction pair if it satisfies the curvature condition */
+    idx = (newest + 1) % LBFGS_HISTORY;
+    for (i = 1; i <= length; ++i) {
+      s[idx][i] = new_epsilon[i] - epsilon[i];
+      y[idx][i] = new_gradient[i] - gradient[i];
+    }
+
+    sy = dot_product(s[idx], y[idx], length);
+    if (sy > 1e-10 * sqrt(dot_product(s[idx], s[idx], length) *
+                          dot_product(y[idx], y[idx], length))) {
+      rho[idx]  = 1. / sy;
+      newest    = idx;
+      history   = MIN2(history + 1, LBFGS_HISTORY);
+    }
+
+    if (callback)
+      callback(iteration_count, new_score, new_epsilon);
+
+    improvement = 1 - new_score / score;
+    score       = new_score;
+    memcpy(epsilon, new_epsilon, sizeof(double) * (length + 1));
+    memcpy(gradient, new_gradient, sizeof(double) * (length + 1));
+
+    if (improvement < minImprovement) {
+      reason = "improvement below threshold";
+      break;
+    }
+  }
+
+  vrna_message_info(stderr,
+                    "L-BFGS: %s after %d iterations (score: %g, gradient norm: %g)",
+                    reason,
+                    iteration_count,
+                    score,
+                    sqrt(dot_product(gradient, gradient, length)));
+
+  for (k = 0; k < LBFGS_HISTORY; k++) {
+    free(s[k]);
+    free(y[k]);
+  }
+
+  free(direction);
+  free(new_epsilon);
+  free(new_gradient);
+  free(gradient);
+}
+
+
 PUBLIC void
 vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
                              const double         *q_prob_unpaired,
@@ -435,6 +839,7 @@ vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
                              double               minimizerTolerance,
                              progress_callback    callback)
 {
+  int                                   i;
   int                                   iteration_count = 0;
   const int                             max_iterations  = 100;
   int                                   length          = vc->length;
@@ -458,7 +863,6 @@ vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
       gsl_multimin_fdfminimizer_steepest_descent },
     { 0,
       NULL } };
-  int i;
   for (i = 0; algorithms[i].type; ++i)
     if (algorithms[i].type == algorithm) {
       minimizer_type = algorithms[i].gsl_type;
@@ -521,8 +925,26 @@ vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
   double        improvement;
   const double  min_improvement = minImprovement;
 
+  if (algorithm == VRNA_MINIMIZER_LBFGS) {
+    minimize_lbfgs(vc,
+                   q_prob_unpaired,
+                   objective_function,
+                   sigma_squared,
+                   tau_squared,
+                   sample_size,
+                   epsilon,
+                   initialStepSize,
+                   minStepSize,
+                   minImprovement,
+                   minimizerTolerance,
+                   max_iterations,
+                   callback);
+    return;
+  }
+
   double        *new_epsilon  = vrna_alloc(sizeof(double) * (length + 1));
   double        *gradient     = vrna_alloc(sizeof(double) * (length + 1));
+  double        *direction    = vrna_alloc(sizeof(double) * (length + 1));
 
   double        score = evaluate_perturbation_vector_score(vc,
                                                            epsilon,
@@ -552,20 +974,26 @@ vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
     /*    step_size = 0.5 / calculate_norm(gradient, length);*/
     step_size = initialStepSize;
 
-    do {
-      int i;
-      for (i = 1; i <= length; ++i)
-        new_epsilon[i] = epsilon[i] - step_size * gradient[i];
-
-      new_score = evaluate_perturbation_vector_score(vc,
-                                                     new_epsilon,
-                                                     q_prob_unpaired,
-                                                     sigma_squared,
-                                                     tau_squared,
-                                                     objective_function);
-      improvement = 1 - new_score / score;
-      step_size   /= 2;
-    } while ((improvement < min_improvement) && (step_size >= minStepSize));
+    for (i = 1; i <= length; ++i)
+      direction[i] = -gradient[i];
+
+    (void)line_search(vc,
+                      epsilon,
+                      direction,
+                      score,
+                      0.,
+                      step_size,
+                      minStepSize,
+                      min_improvement,
+                      0.,
+                      q_prob_unpaired,
+                      sigma_squared,
+                      tau_squared,
+                      objective_function,
+                      new_epsilon,
+                      &new_score);
+
+    improvement = 1 - new_score / score;
 
     if (new_score > score)
       break;
@@ -577,6 +1005,7 @@ vrna_sc_minimize_pertubation(vrna_fold_compound_t *vc,
     memcpy(epsilon, new_epsilon, sizeof(double) * (length + 1));
   } while (improvement >= min_improvement && iteration_count < max_iterations);
 
+  free(direction);
   free(gradient);
   free(new_epsilon);
 }
@@ -80,6 +80,17 @@
  */
 #define VRNA_MINIMIZER_STEEPEST_DESCENT 5
 
+/**
+ * @brief Use a custom implementation of the limited-memory Broyden-Fletcher-Goldfarb-Shanno algorithm to minimize the objective function
+ *
+ * Search directions are derived from the curvature information of the last few iterations, such that usually far fewer
+ * evaluations of the gradient, and thus of conditional pairing probabilities, are required than with the default gradient descent.
+ * This algorithm does not require the GNU Scientific Library. The reason for termination is reported on @p stderr.
+ *
+ * @ingroup perturbation
+ */
+#define VRNA_MINIMIZER_LBFGS 6
+
 /**
  * @brief Callback for following the progress of the minimization process
  *
@@ -116,6 +127,8 @@ typedef void (*progress_callback)(int     iteration,
  *  Since an exact evaluation is expensive, the probabilities can also be estimated from sampling by setting an appropriate sample size.
  *  The found vector of perturbation energies will be stored in the array epsilon.
  *  The progress of the minimization process can be tracked by implementing and passing a callback function.
+ *  If OpenMP is available, the trial points of the line search in the custom minimizers (#VRNA_MINIMIZER_DEFAULT and #VRNA_MINIMIZER_LBFGS)
+ *  are evaluated concurrently on private copies of the fold compound.
  *
  *  @see For further details we refer to @rstinline :cite:t:`washietl:2012` @endrst.
  *
@@ -40,7 +40,21 @@
 #include <math.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/fold.h"
@@ -49,6 +63,11 @@
 #include "ViennaRNA/plex.h"
 #include "ViennaRNA/ali_plex.h"
 #include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/part_func_window.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
+#include "ViennaRNA/datastructures/heap.h"
 /* #################SIMD############### */
 
 /* int subopt_sorted=0; */
@@ -77,6 +96,36 @@
 #define LINIX(i, j, l)    ((i + 20) * l + j)
 #define LINIY(i, j, l)    ((i + 25) * l + j)
 
+/**
+*** Energy parameters and pairing rules used by the reentrant parts of the
+*** duplex computations. The legacy interface refers to the global pair
+*** matrix, whereas a vrna_plex_engine_t brings its own (see below)
+**/
+typedef struct {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1];
+  int           *rtype;
+} plex_model_t;
+
+struct vrna_plex_engine_s {
+  plex_model_t  model;
+  int           threshold;
+  int           alignment_length;
+  int           delta;
+  int           il_a;
+  int           il_b;
+  int           b_a;
+  int           b_b;
+};
+
+struct vrna_plex_access_db_s {
+  unsigned char *data;        /* the entire database file */
+  size_t        size;         /* size of the database file in bytes */
+  int           mapped;       /* whether data is memory-mapped */
+  unsigned int  num;          /* number of records */
+  unsigned int  max_unpaired; /* maximal length of unpaired stretches */
+};
+
 PRIVATE void
 encode_seqs(const char  *s1,
             const char  *s2);
@@ -86,6 +135,13 @@ PRIVATE short *
 encode_seq(const char *seq);
 
 
+PRIVATE void
+encode_seq_md(const char  *sequence,
+              vrna_md_t   *md,
+              short       **S,
+              short       **SS);
+
+
 PRIVATE void
 update_dfold_params(void);
 
@@ -138,60 +194,136 @@ plot_max(const int  max,
          const int  b_b);
 
 
-/* PRIVATE duplexT duplexfold_XS(const char *s1, const char *s2,const int **access_s1, const int **access_s2, const int i_pos, const int j_pos, const int threshold); */
 PRIVATE duplexT
-duplexfold_XS(const char  *s1,
-              const char  *s2,
-              const int   **access_s1,
-              const int   **access_s2,
-              const int   i_pos,
-              const int   j_pos,
-              const int   threshold,
-              const int   i_flag,
-              const int   j_flag);
-
-
-/* PRIVATE char *   backtrack_XS(int i, int j, const int** access_s1, const int** access_s2); */
+duplexfold_XS(const plex_model_t  *m,
+              const char          *s1,
+              const char          *s2,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           threshold,
+              const int           i_flag,
+              const int           j_flag);
+
+
 PRIVATE char *
-backtrack_XS(int        i,
-             int        j,
-             const int  **access_s1,
-             const int  **access_s2,
-             const int  i_flag,
-             const int  j_flag);
+backtrack_XS(const plex_model_t *m,
+             int                **c,
+             const short        *S1,
+             const short        *SS1,
+             const short        *S2,
+             const short        *SS2,
+             const int          n3,
+             const int          n4,
+             int                i,
+             int                j,
+             const int          i_flag,
+             const int          j_flag);
+
+
+PRIVATE int
+scan_XS(const plex_model_t  *m,
+        const short         *S1,
+        const short         *SS1,
+        const int           n1,
+        const short         *S2,
+        const short         *SS2,
+        const int           n2,
+        const int           **access_s1,
+        const int           **access_s2,
+        const int           delta,
+        const int           il_a,
+        const int           il_b,
+        const int           b_a,
+        const int           b_b,
+        int                 *position,
+        int                 *position_j,
+        int                 *max_pos,
+        int                 *max_pos_j);
+
+
+PRIVATE int
+scan(const plex_model_t *m,
+     const short        *S1,
+     const short        *SS1,
+     const int          n1,
+     const short        *S2,
+     const short        *SS2,
+     const int          n2,
+     const int          extension_cost,
+     const int          delta,
+     const int          il_a,
+     const int          il_b,
+     const int          b_a,
+     const int          b_b,
+     int                *position,
+     int                *position_j,
+     int                *max_pos,
+     int                *max_pos_j);
+
+
+PRIVATE int
+profile_compatible(const short  *S1,
+                   const short  *SS1,
+                   const int    n1,
+                   const int    n2);
+
+
+PRIVATE int
+scan_profile(const plex_model_t *m,
+             const short        *S1,
+             const int          n1,
+             const short        *S2,
+             const short        *SS2,
+             const int          n2,
+             const int          **access_s1,
+             const int          **access_s2,
+             const int          extension_cost,
+             const int          delta,
+             const int          il_a,
+             const int          il_b,
+             const int          b_a,
+             const int          b_b,
+             int                *position,
+             int                *position_j,
+             int                *max_pos,
+             int                *max_pos_j);
 
 
 PRIVATE void
-find_max_XS(const int   *position,
-            const int   *position_j,
-            const int   delta,
-            const int   threshold,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b);
+find_max_XS(const plex_model_t  *m,
+            const int           *position,
+            const int           *position_j,
+            const int           delta,
+            const int           threshold,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b);
 
 
 PRIVATE void
-plot_max_XS(const int   max,
-            const int   max_pos,
-            const int   max_pos_j,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b);
+plot_max_XS(const plex_model_t  *m,
+            const int           max,
+            const int           max_pos,
+            const int           max_pos_j,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b);
 
 
 PRIVATE duplexT
@@ -282,53 +414,55 @@ PRIVATE int   n3, n4; /*sequence length for the duplex*/;
 *** profiles, i_pos, j_pos are the coordinates of the closing pair.
 **/
 PRIVATE duplexT
-duplexfold_XS(const char  *s1,
-              const char  *s2,
-              const int   **access_s1,
-              const int   **access_s2,
-              const int   i_pos,
-              const int   j_pos,
-              const int   threshold,
-              const int   i_flag,
-              const int   j_flag)
+duplexfold_XS(const plex_model_t  *m,
+              const char          *s1,
+              const char          *s2,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           threshold,
+              const int           i_flag,
+              const int           j_flag)
 {
-  int       i, j, p, q, Emin = INF, l_min = 0, k_min = 0;
-  char      *struc;
-  vrna_md_t md;
+  int           i, j, p, q, Emin = INF, l_min = 0, k_min = 0, n3, n4, **c;
+  short         *S1, *SS1, *S2, *SS2;
+  char          *struc;
+  vrna_param_t  *P      = m->P;
+  int           *rtype  = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
 
   struc = NULL;
-  duplexT   mfe;
+  duplexT       mfe;
 
   n3  = (int)strlen(s1);
   n4  = (int)strlen(s2);
 
-  set_model_details(&md);
-
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
   c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
   for (i = 0; i <= n3; i++)
     c[i] = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
   for (i = 0; i <= n3; i++)
     for (j = 0; j <= n4; j++)
       c[i][j] = INF;
-  encode_seqs(s1, s2);
+  encode_seq_md(s1, &(P->model_details), &S1, &SS1);
+  encode_seq_md(s2, &(P->model_details), &S2, &SS2);
   int type, type2, type3, E, k, l;
 
   i     = n3 - i_flag;
   j     = 1 + j_flag;
   type  = pair[S1[i]][S2[j]];
   if (!type) {
-    printf("Error during initialization of the duplex in duplexfold_XS\n");
+    vrna_message_warning("Error during initialization of the duplex in duplexfold_XS");
     mfe.structure = NULL;
     mfe.energy    = INF;
+    mfe.ddG       = INF;
+    for (i = 0; i <= n3; i++)
+      free(c[i]);
+    free(c);
+    free(S1);
+    free(S2);
+    free(SS1);
+    free(SS2);
     return mfe;
   }
 
@@ -422,7 +556,7 @@ duplexfold_XS(const char  *s1,
     free(SS2);
     return mfe;
   } else {
-    struc = backtrack_XS(k_min, l_min, access_s1, access_s2, i_flag, j_flag);
+    struc = backtrack_XS(m, c, S1, SS1, S2, SS2, n3, n4, k_min, l_min, i_flag, j_flag);
   }
 
   /**
@@ -471,17 +605,26 @@ duplexfold_XS(const char  *s1,
 
 
 PRIVATE char *
-backtrack_XS(int        i,
-             int        j,
-             const int  **access_s1,
-             const int  **access_s2,
-             const int  i_flag,
-             const int  j_flag)
+backtrack_XS(const plex_model_t *m,
+             int                **c,
+             const short        *S1,
+             const short        *SS1,
+             const short        *S2,
+             const short        *SS2,
+             const int          n3,
+             const int          n4,
+             int                i,
+             int                j,
+             const int          i_flag,
+             const int          j_flag)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+  vrna_param_t  *P      = m->P;
+  int           *rtype  = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n3 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n4 + 1));
@@ -1904,72 +2047,77 @@ fbacktrack_XS(int       i,
 }
 
 
-duplexT **
-Lduplexfold_XS(const char *s1,
-               const char *s2,
-               const int  **access_s1,
-               const int  **access_s2,
-               const int  threshold,
-               const int  alignment_length,
-               const int  delta,
-               const int  fast,
-               const int  il_a,
-               const int  il_b,
-               const int  b_a,
-               const int  b_b)
+/**
+*** scan_XS performs the forward recursion of Lduplexfold_XS on the 1D array SA.
+*** For each target position i, position[i + delta] and position_j[i + delta]
+*** store the best score of a duplex closed by (i, j) and the corresponding j.
+*** All state is passed in, so the function can be used concurrently.
+*** Returns the overall minimum and sets max_pos, max_pos_j accordingly.
+**/
+PRIVATE int
+scan_XS(const plex_model_t  *m,
+        const short         *S1,
+        const short         *SS1,
+        const int           n1,
+        const short         *S2,
+        const short         *SS2,
+        const int           n2,
+        const int           **access_s1,
+        const int           **access_s2,
+        const int           delta,
+        const int           il_a,
+        const int           il_b,
+        const int           b_a,
+        const int           b_b,
+        int                 *position,
+        int                 *position_j,
+        int                 *max_pos,
+        int                 *max_pos_j)
 {
   /**
   *** See variable definition in fduplexfold_XS
   **/
-  int       i, j;
-  int       bopen       = b_b;
-  int       bext        = b_a;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * il_a;
-  int       iext_ass    = 50 + il_a;
-  int       min_colonne = INF;
-  int       i_length;
-  int       max_pos;
-  int       max_pos_j;
-  int       min_j_colonne;
-  int       max = INF;
-  int       *position;
-  int       *position_j;
-  int       maxPenalty[4];
-  int       **DJ;
+  int           i, j;
+  int           bopen       = b_b;
+  int           bext        = b_a;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * il_a;
+  int           iext_ass    = 50 + il_a;
+  int           min_colonne = INF;
+  int           i_length;
+  int           min_j_colonne;
+  int           max = INF;
+  int           maxPenalty[4];
+  int           **DJ;
   /**
   *** 1D array corresponding to the standard 2d recursion matrix
   *** Makes the computation 20% faster
   **/
-  int       *SA;
-  vrna_md_t md;
-
-  /**
-  *** variable initialization
-  **/
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
-  /**
-  *** Sequence encoding
-  **/
-
-  set_model_details(&md);
-
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_dfold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  int           *SA;
+  vrna_param_t  *P      = m->P;
+  int           *rtype  = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
+
+  if (profile_compatible(S1, SS1, n1, n2))
+    return scan_profile(m,
+                        S1,
+                        n1,
+                        S2,
+                        SS2,
+                        n2,
+                        access_s1,
+                        access_s2,
+                        0,
+                        delta,
+                        il_a,
+                        il_b,
+                        b_a,
+                        b_b,
+                        position,
+                        position_j,
+                        max_pos,
+                        max_pos_j);
 
-  encode_seqs(s1, s2);
-  /**
-  *** Position of the high score on the target and query sequence
-  **/
-  position    = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
-  position_j  = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
   /**
   *** extension penalty, computed only once, further reduce the computation time
   **/
@@ -2307,9 +2455,9 @@ Lduplexfold_XS(const char *s1,
       /* ---------------------------------------------------------------------end update */
     }
     if (max >= min_colonne) {
-      max       = min_colonne;
-      max_pos   = i;
-      max_pos_j = min_j_colonne;
+      max         = min_colonne;
+      *max_pos    = i;
+      *max_pos_j  = min_j_colonne;
     }
 
     position[i + delta]   = min_colonne;
@@ -2318,14 +2466,94 @@ Lduplexfold_XS(const char *s1,
     /* remove this line printf("\n"); */
     i++;
   }
+  free(SA);
+
+  for (i = 0; i <= 3; i++)
+    free(DJ[i]);
+  free(DJ);
+
+  return max;
+}
+
+
+duplexT **
+Lduplexfold_XS(const char *s1,
+               const char *s2,
+               const int  **access_s1,
+               const int  **access_s2,
+               const int  threshold,
+               const int  alignment_length,
+               const int  delta,
+               const int  fast,
+               const int  il_a,
+               const int  il_b,
+               const int  b_a,
+               const int  b_b)
+{
+  int           max, max_pos, max_pos_j;
+  int           *position;
+  int           *position_j;
+  vrna_md_t     md;
+  plex_model_t  model;
+
+  /**
+  *** variable initialization
+  **/
+  n1  = (int)strlen(s1);
+  n2  = (int)strlen(s2);
+  /**
+  *** Sequence encoding
+  **/
+
+  set_model_details(&md);
+
+  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
+    update_dfold_params();
+    if (P)
+      free(P);
+
+    P = vrna_params(&md);
+    make_pair_matrix();
+  }
+
+  encode_seqs(s1, s2);
+  /**
+  *** Position of the high score on the target and query sequence
+  **/
+  position    = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+  position_j  = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+
+  model.P     = P;
+  model.pair  = pair;
+  model.rtype = rtype;
+
+  max = scan_XS(&model,
+                S1,
+                SS1,
+                n1,
+                S2,
+                SS2,
+                n2,
+                access_s1,
+                access_s2,
+                delta,
+                il_a,
+                il_b,
+                b_a,
+                b_b,
+                position,
+                position_j,
+                &max_pos,
+                &max_pos_j);
+
   /* printf("MAX: %d",max); */
   free(S1);
   free(S2);
   free(SS1);
   free(SS2);
-  free(SA);
   if (max < threshold) {
-    find_max_XS(position,
+    find_max_XS(&model,
+                position,
                 position_j,
                 delta,
                 threshold,
@@ -2342,7 +2570,8 @@ Lduplexfold_XS(const char *s1,
   }
 
   if (max < INF) {
-    plot_max_XS(max,
+    plot_max_XS(&model,
+                max,
                 max_pos,
                 max_pos_j,
                 alignment_length,
@@ -2357,9 +2586,6 @@ Lduplexfold_XS(const char *s1,
                 b_b);
   }
 
-  for (i = 0; i <= 3; i++)
-    free(DJ[i]);
-  free(DJ);
   free(position);
   free(position_j);
   return NULL;
@@ -2367,20 +2593,21 @@ Lduplexfold_XS(const char *s1,
 
 
 PRIVATE void
-find_max_XS(const int   *position,
-            const int   *position_j,
-            const int   delta,
-            const int   threshold,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+find_max_XS(const plex_model_t  *m,
+            const int           *position,
+            const int           *position_j,
+            const int           delta,
+            const int           threshold,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b)
 {
   int pos = n1 - 9;
 
@@ -2502,13 +2729,14 @@ find_max_XS(const int   *position,
         j_flag  = (begin_q == max_pos_j - 1 ? 1 : 0);
         char    *s3 = (char *)vrna_alloc(sizeof(char) * (end_t - begin_t + 2));
         char    *s4 = (char *)vrna_alloc(sizeof(char) * (end_q - begin_q + 2));
-        strncpy(s3, (s1 + begin_t), end_t - begin_t + 1);
-        strncpy(s4, (s2 + begin_q), end_q - begin_q + 1);
+        /* same segments as for the optimal hit in plot_max_XS() */
+        strncpy(s3, (s1 + begin_t - 1), end_t - begin_t + 1);
+        strncpy(s4, (s2 + begin_q - 1), end_q - begin_q + 1);
         s3[end_t - begin_t + 1] = '\0';
         s4[end_q - begin_q + 1] = '\0';
         duplexT test;
         test =
-          duplexfold_XS(s3, s4, access_s1, access_s2, pos, max_pos_j, threshold, i_flag, j_flag);
+          duplexfold_XS(m, s3, s4, access_s1, access_s2, pos, max_pos_j, threshold, i_flag, j_flag);
         if (test.energy * 100 < threshold) {
           printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
                  test.structure,
@@ -2559,19 +2787,20 @@ compare(const void  *sub1,
 #endif
 
 PRIVATE void
-plot_max_XS(const int   max,
-            const int   max_pos,
-            const int   max_pos_j,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+plot_max_XS(const plex_model_t  *m,
+            const int           max,
+            const int           max_pos,
+            const int           max_pos_j,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b)
 {
   if (fast == 1) {
     printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
@@ -2631,7 +2860,7 @@ plot_max_XS(const int   max,
     s3[end_t - begin_t + 1] = '\0';                       /*  */
     s4[end_q - begin_q + 1] = '\0';
     duplexT test;
-    test = duplexfold_XS(s3, s4, access_s1, access_s2, max_pos, max_pos_j, INF, i_flag, j_flag);
+    test = duplexfold_XS(m, s3, s4, access_s1, access_s2, max_pos, max_pos_j, INF, i_flag, j_flag);
     printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
            test.structure,
            test.tb,
@@ -3756,81 +3985,85 @@ fbacktrack(int        i,
 }
 
 
-duplexT **
-Lduplexfold(const char  *s1,
-            const char  *s2,
-            const int   threshold,
-            const int   extension_cost,
-            const int   alignment_length,
-            const int   delta,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+/**
+*** scan performs the forward recursion of Lduplexfold on the 1D array SA,
+*** see scan_XS() for the meaning of the arguments and return value
+**/
+PRIVATE int
+scan(const plex_model_t *m,
+     const short        *S1,
+     const short        *SS1,
+     const int          n1,
+     const short        *S2,
+     const short        *SS2,
+     const int          n2,
+     const int          extension_cost,
+     const int          delta,
+     const int          il_a,
+     const int          il_b,
+     const int          b_a,
+     const int          b_b,
+     int                *position,
+     int                *position_j,
+     int                *max_pos,
+     int                *max_pos_j)
 {
   /**
   *** See variable definition in fduplexfold_XS
   **/
-  int       i, j;
-  int       bopen       = b_b;
-  int       bext        = b_a + extension_cost;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int       iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
-  int       min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
-  int       i_length;
-  int       max_pos;                                    /* get position of the best hit */
-  int       max_pos_j;
-  int       temp = INF;
-  int       min_j_colonne;
-  int       max = INF;
-  int       *position; /* contains the position of the hits with energy > E */
-  int       *position_j;
+  int           i, j;
+  int           bopen       = b_b;
+  int           bext        = b_a + extension_cost;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
+  int           i_length;
+  int           temp = INF;
+  int           min_j_colonne;
+  int           max = INF;
   /**
   *** 1D array corresponding to the standard 2d recursion matrix
   *** Makes the computation 20% faster
   **/
-  int       *SA;
-  vrna_md_t md;
+  int           *SA;
+  vrna_param_t  *P      = m->P;
+  int           *rtype  = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
+
+  if (profile_compatible(S1, SS1, n1, n2))
+    return scan_profile(m,
+                        S1,
+                        n1,
+                        S2,
+                        SS2,
+                        n2,
+                        NULL,
+                        NULL,
+                        extension_cost,
+                        delta,
+                        il_a,
+                        il_b,
+                        b_a,
+                        b_b,
+                        position,
+                        position_j,
+                        max_pos,
+                        max_pos_j);
 
   /**
-  *** variable initialization
-  **/
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
-  /**
-  *** Sequence encoding
-  **/
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
-  encode_seqs(s1, s2);
-  /**
-  *** Position of the high score on the target and query sequence
-  **/
-  position    = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
-  position_j  = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
-  /**
-  *** instead of having 4 2-dim arrays we use a unique 1-dim array
-  *** The mapping 2d -> 1D is done based ont the macro
-  *** LCI(i,j,l)      ((i     )*l + j)
-  *** LINI(i,j,l)     ((i +  5)*l + j)
-  *** LBXI(i,j,l)     ((i + 10)*l + j)
-  *** LBYI(i,j,l)     ((i + 15)*l + j)
-  *** LINIX(i,j,l)    ((i + 20)*l + j)
-  *** LINIY(i,j,l)    ((i + 25)*l + j)
-  ***
-  *** SA has a length of 5 (number of columns we look back) *
-  ***                  * 6 (number of structures we look at) *
-  ***                  * length of the sequence
+  *** instead of having 4 2-dim arrays we use a unique 1-dim array
+  *** The mapping 2d -> 1D is done based ont the macro
+  *** LCI(i,j,l)      ((i     )*l + j)
+  *** LINI(i,j,l)     ((i +  5)*l + j)
+  *** LBXI(i,j,l)     ((i + 10)*l + j)
+  *** LBYI(i,j,l)     ((i + 15)*l + j)
+  *** LINIX(i,j,l)    ((i + 20)*l + j)
+  *** LINIY(i,j,l)    ((i + 25)*l + j)
+  ***
+  *** SA has a length of 5 (number of columns we look back) *
+  ***                  * 6 (number of structures we look at) *
+  ***                  * length of the sequence
   **/
   SA = (int *)vrna_alloc(sizeof(int) * 5 * 6 * (n2 + 5));
   for (j = n2 + 4; j >= 0; j--) {
@@ -4077,9 +4310,9 @@ Lduplexfold(const char  *s1,
         min_j_colonne = j;
     }
     if (max >= min_colonne) {
-      max       = min_colonne;
-      max_pos   = i;
-      max_pos_j = min_j_colonne;
+      max         = min_colonne;
+      *max_pos    = i;
+      *max_pos_j  = min_j_colonne;
     }
 
     position[i + delta]   = min_colonne;
@@ -4087,6 +4320,80 @@ Lduplexfold(const char  *s1,
     position_j[i + delta] = min_j_colonne;
     i++;
   }
+  free(SA);
+
+  return max;
+}
+
+
+duplexT **
+Lduplexfold(const char  *s1,
+            const char  *s2,
+            const int   threshold,
+            const int   extension_cost,
+            const int   alignment_length,
+            const int   delta,
+            const int   fast,
+            const int   il_a,
+            const int   il_b,
+            const int   b_a,
+            const int   b_b)
+{
+  int           max;
+  int           max_pos;  /* get position of the best hit */
+  int           max_pos_j;
+  int           *position; /* contains the position of the hits with energy > E */
+  int           *position_j;
+  vrna_md_t     md;
+  plex_model_t  model;
+
+  /**
+  *** variable initialization
+  **/
+  n1  = (int)strlen(s1);
+  n2  = (int)strlen(s2);
+  /**
+  *** Sequence encoding
+  **/
+  set_model_details(&md);
+  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
+    update_fold_params();
+    if (P)
+      free(P);
+
+    P = vrna_params(&md);
+    make_pair_matrix();
+  }
+
+  encode_seqs(s1, s2);
+  /**
+  *** Position of the high score on the target and query sequence
+  **/
+  position    = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+  position_j  = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+
+  model.P     = P;
+  model.pair  = pair;
+  model.rtype = rtype;
+
+  max = scan(&model,
+             S1,
+             SS1,
+             n1,
+             S2,
+             SS2,
+             n2,
+             extension_cost,
+             delta,
+             il_a,
+             il_b,
+             b_a,
+             b_b,
+             position,
+             position_j,
+             &max_pos,
+             &max_pos_j);
+
   /* printf("MAX: %d",max); */
   free(S1);
   free(S2);
@@ -4123,7 +4430,6 @@ Lduplexfold(const char  *s1,
              b_b);
   }
 
-  free(SA);
   free(position);
   free(position_j);
   return NULL;
@@ -4503,6 +4809,23 @@ encode_seq(const char *sequence)
 }
 
 
+PRIVATE void
+encode_seq_md(const char  *sequence,
+              vrna_md_t   *md,
+              short       **S,
+              short       **SS)
+{
+  unsigned int i, l;
+
+  l     = strlen(sequence);
+  *S    = vrna_seq_encode_simple(sequence, md);
+  *SS   = (short *)vrna_alloc(sizeof(short) * (l + 2));
+
+  for (i = 1; i <= l; i++)  /* for mismatches of nostandard bases */
+    (*SS)[i] = md->alias[(*S)[i]];
+}
+
+
 int
 arraySize(duplexT **array)
 {
@@ -4517,12 +4840,1834 @@ arraySize(duplexT **array)
 void
 freeDuplexT(duplexT **array)
 {
-  int size = arraySize(array);
+  int i;
+
+  if (array) {
+    for (i = 0; array[i]; i++) {
+      free(array[i]->structure);
+      free(array[i]);
+    }
+    free(array);
+  }
+}
+
+
+/*
+ #####################################
+ # Query profile scan kernel         #
+ #####################################
+ */
+
+/**
+*** The forward recursions of Lduplexfold() and Lduplexfold_XS() only look
+*** back at most 4 nucleotides on the target. Hence, all energy contributions
+*** of a column i of SA are determined by a handful of target nucleotides and
+*** the query position j. For each such context, we tabulate the energies
+*** along the entire query once (query profile), such that a column
+*** boils down to element-wise minima over sums of contiguous arrays, which
+*** is what vrna_fun_min_add_terms() efficiently computes with SIMD
+*** instructions. Invalid (type2 == 0) terms receive a sentinel energy that
+*** exceeds any real score. Only the recursions that depend on the same
+*** column (j + 1) are left for a short scalar pass.
+**/
+#define PLEX_PROFILE_MAX_LENGTH 2048
+#define PLEX_PROFILE_SENTINEL   (100 * INF)
+#define PLEX_PROFILE_CONTEXTS   625   /* 5^4, contexts of up to 4 nucleotides */
+#define PLEX_PROFILE_LANES      16    /* rows are padded to multiples of the widest SIMD vector */
+
+#define PROF_INIT       0   /* duplex initiation, (i, i - 1) */
+#define PROF_STACK      1   /* stacked pair, (i, i - 1) */
+#define PROF_BULGE_X    2   /* 1x0 bulge, (i, i - 1) */
+#define PROF_BULGE_Y    3   /* 0x1 bulge, (i, i - 2) */
+#define PROF_INT11      4   /* 1x1 loop, (i, i - 1, i - 2) */
+#define PROF_INT22      5   /* 2x2 loop, (i, i - 1, i - 2, i - 3) */
+#define PROF_INT21      6   /* 2x1 loop, (i, i - 1, i - 2, i - 3) */
+#define PROF_INT12      7   /* 1x2 loop, (i, i - 1, i - 2) */
+#define PROF_INT23      8   /* 2x3 loop, (i, i - 1, i - 3, i - 4) */
+#define PROF_INT32      9   /* 3x2 loop, (i, i - 1, i - 2, i - 3) */
+#define PROF_MM_I       10  /* closing mismatch of generic interior loops, (i, i - 1) */
+#define PROF_MM_1N      11  /* closing mismatch of 1xn interior loops, (i, i - 1) */
+#define PROF_AU         12  /* terminal AU penalty of bulges, (i) */
+#define PROF_EXT        13  /* exterior stem closing the duplex, (i, i + 1) */
+#define PROF_OPEN_I     14  /* opening mismatch of generic interior loops, (i, i - 1) */
+#define PROF_OPEN_1N    15  /* opening mismatch of 1xn interior loops, (i, i - 1) */
+#define PROF_OPEN_BX    16  /* terminal AU penalty of target bulge opening, (i - 1) */
+#define PROF_OPEN_BY    17  /* terminal AU penalty of query bulge opening, (i) */
+#define PROF_NUM        18
+
+typedef struct {
+  const plex_model_t  *m;
+  const short         *S2;
+  const short         *SS2;
+  int                 n2;
+  int                 l;      /* length of the rows */
+  int                 init;   /* constant part of the duplex initiation */
+  int                 *rows[PROF_NUM][PLEX_PROFILE_CONTEXTS];
+} plex_profile_t;
+
+
+PRIVATE int
+profile_compatible(const short  *S1,
+                   const short  *SS1,
+                   const int    n1,
+                   const int    n2)
+{
+  int i;
+
+  if ((n2 > PLEX_PROFILE_MAX_LENGTH) ||
+      (n1 < 20) ||
+      (n2 < 20))
+    return 0;
+
+  /* contexts are encoded with 5 letters, so no alias or extended alphabets */
+  for (i = 1; i <= n1; i++)
+    if ((S1[i] < 0) || (S1[i] > 4) || (SS1[i] != S1[i]))
+      return 0;
+
+  return 1;
+}
+
+
+PRIVATE void
+profile_fill(const plex_profile_t *p,
+             int                  kind,
+             int                  x0,
+             int                  x1,
+             int                  x2,
+             int                  x3,
+             int                  *row)
+{
+  int           j, type, type2, rt, en;
+  vrna_param_t  *P      = p->m->P;
+  int           *rtype  = p->m->rtype;
+  int           (*pair)[MAXALPHA + 1] = p->m->pair;
+  const short   *S2     = p->S2;
+  const short   *SS2    = p->SS2;
+
+  for (j = 10; j <= p->n2 - 10; j++) {
+    type  = pair[x0][S2[j]];
+    rt    = rtype[type];
+    en    = PLEX_PROFILE_SENTINEL;
+
+    switch (kind) {
+      case PROF_INIT:
+        en = (type) ? p->init + vrna_E_ext_stem(type, x1, SS2[j + 1], P) : INF;
+        break;
+
+      case PROF_STACK:
+        if ((type) && (type2 = pair[x1][S2[j + 1]]))
+          en = P->stack[rt][type2];
+
+        break;
+
+      case PROF_BULGE_X:
+        if ((type) && (type2 = pair[x1][S2[j + 2]]))
+          en = P->bulge[1] + P->stack[rt][type2];
+
+        break;
+
+      case PROF_BULGE_Y:
+        if ((type) && (type2 = pair[x1][S2[j + 1]]))
+          en = P->bulge[1] + P->stack[type2][rt];
+
+        break;
+
+      case PROF_INT11:
+        if ((type) && (type2 = pair[x2][S2[j + 2]]))
+          en = P->int11[type2][rt][x1][SS2[j + 1]];
+
+        break;
+
+      case PROF_INT22:
+        if ((type) && (type2 = pair[x3][S2[j + 3]]))
+          en = P->int22[type2][rt][x2][x1][SS2[j + 1]][SS2[j + 2]];
+
+        break;
+
+      case PROF_INT21:
+        if ((type) && (type2 = pair[x3][S2[j + 2]]))
+          en = P->int21[rt][type2][SS2[j + 1]][x2][x1];
+
+        break;
+
+      case PROF_INT12:
+        if ((type) && (type2 = pair[x2][S2[j + 3]]))
+          en = P->int21[type2][rt][x1][SS2[j + 1]][SS2[j + 2]];
+
+        break;
+
+      case PROF_INT23:
+        if ((type) && (type2 = pair[x3][S2[j + 3]]))
+          en = P->internal_loop[5] + P->ninio[2] +
+               P->mismatch23I[type2][x2][SS2[j + 2]] +
+               P->mismatch23I[rt][SS2[j + 1]][x1];
+
+        break;
+
+      case PROF_INT32:
+        if ((type) && (type2 = pair[x3][S2[j + 4]]))
+          en = P->internal_loop[5] + P->ninio[2] +
+               P->mismatch23I[type2][x2][SS2[j + 3]] +
+               P->mismatch23I[rt][SS2[j + 1]][x1];
+
+        break;
+
+      case PROF_MM_I:
+        if (type)
+          en = P->mismatchI[rt][x1][SS2[j + 1]];
+
+        break;
+
+      case PROF_MM_1N:
+        if (type)
+          en = P->mismatch1nI[rt][x1][SS2[j + 1]];
+
+        break;
+
+      case PROF_AU:
+        if (type)
+          en = (type > 2) ? P->TerminalAU : 0;
+
+        break;
+
+      case PROF_EXT:
+        if (type)
+          en = vrna_E_ext_stem(rt, SS2[j - 1], x1, P);
+
+        break;
+
+      case PROF_OPEN_I:
+        type2 = pair[S2[j + 1]][x1];
+        en    = P->mismatchI[type2][SS2[j]][x0];
+        break;
+
+      case PROF_OPEN_1N:
+        type2 = pair[S2[j + 1]][x1];
+        en    = P->mismatch1nI[type2][SS2[j]][x0];
+        break;
+
+      case PROF_OPEN_BX:
+        type2 = pair[S2[j]][x0];
+        en    = (type2 > 2) ? P->TerminalAU : 0;
+        break;
+
+      case PROF_OPEN_BY:
+        type2 = pair[S2[j + 1]][x0];
+        en    = (type2 > 2) ? P->TerminalAU : 0;
+        break;
+    }
+
+    row[j] = en;
+  }
+}
+
+
+/**
+*** Return the profile of kind 'kind' for the target context x0, ..., x3
+*** (offset to the first query position considered). Profiles are
+*** tabulated lazily, upon first use of a particular context
+**/
+PRIVATE const int *
+profile_row(plex_profile_t  *p,
+            int             kind,
+            int             x0,
+            int             x1,
+            int             x2,
+            int             x3)
+{
+  int key = ((x0 * 5 + x1) * 5 + x2) * 5 + x3;
+
+  if (!p->rows[kind][key]) {
+    p->rows[kind][key] = (int *)vrna_alloc(sizeof(int) * p->l);
+    profile_fill(p, kind, x0, x1, x2, x3, p->rows[kind][key]);
+  }
+
+  return p->rows[kind][key] + 10;
+}
+
+
+PRIVATE void
+profile_free(plex_profile_t *p)
+{
+  int k, c;
+
+  for (k = 0; k < PROF_NUM; k++)
+    for (c = 0; c < PLEX_PROFILE_CONTEXTS; c++)
+      free(p->rows[k][c]);
+
+  free(p);
+}
+
+
+/**
+*** State of a profile based scan of a block of queries along a target. The
+*** (padded) queries are concatenated along j, such that each column of the
+*** target is evaluated for all of them within the same vector operations.
+*** Positions in between the queries are reset to INF after each column
+**/
+typedef struct {
+  const plex_model_t  *m;
+  int                 num;            /* number of queries */
+  int                 *off;           /* offset of each query within the concatenation */
+  int                 *n2;            /* length of each (padded) query */
+  short               *S2;            /* concatenated encodings */
+  short               *SS2;
+  int                 l;              /* row length of SA, profiles, and DJ */
+  int                 count;          /* number of positions covered by vectorized recursions */
+  int                 ec;
+  int                 bopen;
+  int                 bext;
+  int                 iopen;
+  int                 iext_s;
+  int                 iext_ass;
+  int                 delta;
+  int                 *SA;
+  int                 **DJ;
+  int                 *zero;
+  plex_profile_t      *prof;
+  int                 *min_j_colonne;
+  int                 *max;
+  int                 *max_pos;
+  int                 *max_pos_j;
+  int                 **position;
+  int                 **position_j;
+} plex_scan_t;
+
+
+/**
+*** Prepare a profile based scan of the queries S2[0], ..., S2[num - 1].
+*** Accessibilities may be NULL, in which case they are assumed to be 0. For
+*** extension_cost = 0, this is the forward recursion of Lduplexfold_XS(),
+*** without accessibilities it is the one of Lduplexfold(). Results of query
+*** q are written to position[q] and position_j[q]
+**/
+PRIVATE plex_scan_t *
+scan_profile_init(const plex_model_t  *m,
+                  int                 num,
+                  short               **S2,
+                  short               **SS2,
+                  const int           *n2,
+                  const int           ***access_s2,
+                  const int           extension_cost,
+                  const int           delta,
+                  const int           il_a,
+                  const int           il_b,
+                  const int           b_a,
+                  const int           b_b,
+                  int                 **position,
+                  int                 **position_j)
+{
+  int         j, k, q, o, total;
+  int         **DJ;
+  plex_scan_t *s;
+
+  s               = (plex_scan_t *)vrna_alloc(sizeof(plex_scan_t));
+  s->m            = m;
+  s->num          = num;
+  s->off          = (int *)vrna_alloc(sizeof(int) * num);
+  s->n2           = (int *)vrna_alloc(sizeof(int) * num);
+  s->ec           = extension_cost;
+  s->bopen        = b_b;
+  s->bext         = b_a + extension_cost;
+  s->iopen        = il_b;
+  s->iext_s       = 2 * (il_a + extension_cost);
+  s->iext_ass     = 50 + il_a + extension_cost;
+  s->delta        = delta;
+  s->position     = position;
+  s->position_j   = position_j;
+  s->min_j_colonne  = (int *)vrna_alloc(sizeof(int) * num);
+  s->max            = (int *)vrna_alloc(sizeof(int) * num);
+  s->max_pos        = (int *)vrna_alloc(sizeof(int) * num);
+  s->max_pos_j      = (int *)vrna_alloc(sizeof(int) * num);
+
+  for (total = q = 0; q < num; q++) {
+    s->off[q]   = total;
+    s->n2[q]    = n2[q];
+    s->max[q]   = INF;
+    total       += n2[q];
+  }
+
+  s->count  = PLEX_PROFILE_LANES * ((total - 19 + PLEX_PROFILE_LANES - 1) / PLEX_PROFILE_LANES);
+  s->l      = s->count + 20;
+  s->S2     = (short *)vrna_alloc(sizeof(short) * (s->l + 1));
+  s->SS2    = (short *)vrna_alloc(sizeof(short) * (s->l + 1));
+
+  for (q = 0; q < num; q++) {
+    memcpy(s->S2 + s->off[q] + 1, S2[q] + 1, sizeof(short) * n2[q]);
+    memcpy(s->SS2 + s->off[q] + 1, SS2[q] + 1, sizeof(short) * n2[q]);
+  }
+
+  s->prof       = (plex_profile_t *)vrna_alloc(sizeof(plex_profile_t));
+  s->prof->m    = m;
+  s->prof->S2   = s->S2;
+  s->prof->SS2  = s->SS2;
+  s->prof->n2   = total;
+  s->prof->l    = s->l;
+  s->prof->init = m->P->DuplexInit + 4 * extension_cost;
+
+  s->zero = (int *)vrna_alloc(sizeof(int) * s->l);
+  DJ      = s->DJ = (int **)vrna_alloc(4 * sizeof(int *));
+  for (k = 0; k < 4; k++)
+    DJ[k] = (int *)vrna_alloc(s->l * sizeof(int));
+
+  for (q = 0; q < num; q++) {
+    const int **acc = (access_s2) ? access_s2[q] : NULL;
+
+    if (!acc)
+      continue;
+
+    o = s->off[q];
+    j = n2[q] - 9;
+    while (--j > 10) {
+      DJ[0][o + j] = 0.5 *
+                     (acc[5][j + 4] - acc[4][j + 4] + acc[5][j] - acc[4][j - 1]);
+      DJ[1][o + j] = 0.5 *
+                     (acc[5][j + 5] - acc[4][j + 5] + acc[5][j + 1] - acc[4][j]) +
+                     DJ[0][o + j];
+      DJ[2][o + j] = 0.5 *
+                     (acc[5][j + 6] - acc[4][j + 6] + acc[5][j + 2] - acc[4][j + 1]) +
+                     DJ[1][o + j];
+      DJ[3][o + j] = 0.5 *
+                     (acc[5][j + 7] - acc[4][j + 7] + acc[5][j + 3] - acc[4][j + 2]) +
+                     DJ[2][o + j];
+    }
+  }
+
+  s->SA = (int *)vrna_alloc(sizeof(int) * 5 * 6 * s->l);
+  for (j = 5 * 6 * s->l - 1; j >= 0; j--)
+    s->SA[j] = INF;
+
+  return s;
+}
+
+
+PRIVATE void
+scan_profile_free(plex_scan_t *s)
+{
+  int k;
+
+  free(s->SA);
+  free(s->zero);
+  for (k = 0; k < 4; k++)
+    free(s->DJ[k]);
+  free(s->DJ);
+  profile_free(s->prof);
+  free(s->S2);
+  free(s->SS2);
+  free(s->off);
+  free(s->n2);
+  free(s->min_j_colonne);
+  free(s->max);
+  free(s->max_pos);
+  free(s->max_pos_j);
+  free(s);
+}
+
+
+/**
+*** Compute the accessibility contributions di1, ..., di4 of the target
+*** columns from <= i < to as in scan_XS()
+**/
+PRIVATE void
+scan_target_di(const int  **access_s1,
+               int        from,
+               int        to,
+               int        *di)
+{
+  int i;
+
+  for (i = from; i < to; i++, di += 4) {
+    di[0] = 0.5 *
+            (access_s1[5][i + 4] - access_s1[4][i + 4] + access_s1[5][i] - access_s1[4][i - 1]);
+    di[1] = 0.5 *
+            (access_s1[5][i + 3] - access_s1[4][i + 3] + access_s1[5][i - 1] -
+             access_s1[4][i - 2]) +
+            di[0];
+    di[2] = 0.5 *
+            (access_s1[5][i + 2] - access_s1[4][i + 2] + access_s1[5][i - 2] -
+             access_s1[4][i - 3]) +
+            di[1];
+    di[3] = 0.5 *
+            (access_s1[5][i + 1] - access_s1[4][i + 1] + access_s1[5][i - 3] -
+             access_s1[4][i - 4]) +
+            di[2];
+  }
+}
+
+
+/**
+*** Advance the scan over the target columns from <= i < to. The columns have
+*** to be processed in order, starting at i = 10. DI holds the values of
+*** scan_target_di() for these columns, or NULL without accessibilities
+**/
+PRIVATE void
+scan_profile_columns(plex_scan_t  *s,
+                     const short  *S1,
+                     const int    *DI,
+                     int          from,
+                     int          to)
+{
+  int             i, j, q, en;
+  int             l           = s->l;
+  int             count       = s->count;
+  int             ec          = s->ec;
+  int             bopen       = s->bopen;
+  int             bext        = s->bext;
+  int             iopen       = s->iopen;
+  int             iext_s      = s->iext_s;
+  int             iext_ass    = s->iext_ass;
+  int             *SA         = s->SA;
+  int             **DJ        = s->DJ;
+  int             *zero       = s->zero;
+  const int       *a[17], *b[17], *c[17], *ext, *open_by;
+  int             d[17];
+  plex_profile_t  *prof       = s->prof;
+
+  for (i = from; i < to; i++) {
+    int di1   = (DI) ? DI[4 * (i - from)] : 0;
+    int di2   = (DI) ? DI[4 * (i - from) + 1] : 0;
+    int di3   = (DI) ? DI[4 * (i - from) + 2] : 0;
+    int di4   = (DI) ? DI[4 * (i - from) + 3] : 0;
+    int idx   = i % 5;
+    int idx_1 = (i - 1) % 5;
+    int idx_2 = (i - 2) % 5;
+    int idx_3 = (i - 3) % 5;
+    int idx_4 = (i - 4) % 5;
+    int s0    = S1[i];
+    int s_1   = S1[i - 1];
+    int s_2   = S1[i - 2];
+    int s_3   = S1[i - 3];
+    int s_4   = S1[i - 4];
+
+    /**
+    *** interior loops and target bulges of column i,
+    *** except for the extensions along j that are done below
+    **/
+    a[0]  = SA + LCI(idx_1, 11, l);
+    b[0]  = profile_row(prof, PROF_OPEN_I, s0, s_1, 0, 0);
+    c[0]  = DJ[0] + 10;
+    d[0]  = di1 + iopen + iext_s;
+    a[1]  = SA + LINI(idx_1, 10, l);
+    b[1]  = zero;
+    c[1]  = zero;
+    d[1]  = di1 + iext_ass;
+    a[2]  = SA + LINI(idx_1, 11, l);
+    b[2]  = zero;
+    c[2]  = DJ[0] + 10;
+    d[2]  = di1 + iext_s;
+    vrna_fun_min_add_terms(SA + LINI(idx, 10, l), a, b, c, d, 3, count);
+
+    b[0]  = profile_row(prof, PROF_OPEN_1N, s0, s_1, 0, 0);
+    vrna_fun_min_add_terms(SA + LINIY(idx, 10, l), a, b, c, d, 1, count);
+
+    a[1] = SA + LINIX(idx_1, 10, l);
+    vrna_fun_min_add_terms(SA + LINIX(idx, 10, l), a, b, c, d, 2, count);
+
+    a[0]  = SA + LBXI(idx_1, 10, l);
+    b[0]  = zero;
+    c[0]  = zero;
+    d[0]  = di1 + bext;
+    a[1]  = SA + LCI(idx_1, 10, l);
+    b[1]  = profile_row(prof, PROF_OPEN_BX, s_1, 0, 0, 0);
+    c[1]  = zero;
+    d[1]  = di1 + bopen + bext;
+    vrna_fun_min_add_terms(SA + LBXI(idx, 10, l), a, b, c, d, 2, count);
+
+    /**
+    *** duplexes closed by (i, j)
+    **/
+    a[0]  = zero;
+    b[0]  = profile_row(prof, PROF_INIT, s0, s_1, 0, 0);
+    c[0]  = zero;
+    d[0]  = 0;
+    /* stack */
+    a[1]  = SA + LCI(idx_1, 11, l);
+    b[1]  = profile_row(prof, PROF_STACK, s0, s_1, 0, 0);
+    c[1]  = DJ[0] + 10;
+    d[1]  = di1 + 2 * ec;
+    /* 1x0 / 0x1 */
+    a[2]  = SA + LCI(idx_1, 12, l);
+    b[2]  = profile_row(prof, PROF_BULGE_X, s0, s_1, 0, 0);
+    c[2]  = DJ[1] + 10;
+    d[2]  = di1 + 3 * ec;
+    a[3]  = SA + LCI(idx_2, 11, l);
+    b[3]  = profile_row(prof, PROF_BULGE_Y, s0, s_2, 0, 0);
+    c[3]  = DJ[0] + 10;
+    d[3]  = di2 + 3 * ec;
+    /* 1x1 / 2x2 */
+    a[4]  = SA + LCI(idx_2, 12, l);
+    b[4]  = profile_row(prof, PROF_INT11, s0, s_1, s_2, 0);
+    c[4]  = DJ[1] + 10;
+    d[4]  = di2 + 4 * ec;
+    a[5]  = SA + LCI(idx_3, 13, l);
+    b[5]  = profile_row(prof, PROF_INT22, s0, s_1, s_2, s_3);
+    c[5]  = DJ[2] + 10;
+    d[5]  = di3 + 6 * ec;
+    /* 2x1 / 1x2 */
+    a[6]  = SA + LCI(idx_3, 12, l);
+    b[6]  = profile_row(prof, PROF_INT21, s0, s_1, s_2, s_3);
+    c[6]  = DJ[1] + 10;
+    d[6]  = di3 + 5 * ec;
+    a[7]  = SA + LCI(idx_2, 13, l);
+    b[7]  = profile_row(prof, PROF_INT12, s0, s_1, s_2, 0);
+    c[7]  = DJ[2] + 10;
+    d[7]  = di2 + 5 * ec;
+    /* 2x3 / 3x2 */
+    a[8]  = SA + LCI(idx_4, 13, l);
+    b[8]  = profile_row(prof, PROF_INT23, s0, s_1, s_3, s_4);
+    c[8]  = DJ[2] + 10;
+    d[8]  = di4 + 7 * ec;
+    a[9]  = SA + LCI(idx_3, 14, l);
+    b[9]  = profile_row(prof, PROF_INT32, s0, s_1, s_2, s_3);
+    c[9]  = DJ[3] + 10;
+    d[9]  = di3 + 7 * ec;
+    /* 3x3, 2xn, nx2 */
+    a[10] = SA + LINI(idx_3, 13, l);
+    b[10] = profile_row(prof, PROF_MM_I, s0, s_1, 0, 0);
+    c[10] = DJ[2] + 10;
+    d[10] = di3 + 2 * iext_s + 2 * ec;
+    a[11] = SA + LINI(idx_4, 12, l);
+    b[11] = b[10];
+    c[11] = DJ[1] + 10;
+    d[11] = di4 + iext_s + 2 * iext_ass + 2 * ec;
+    a[12] = SA + LINI(idx_2, 14, l);
+    b[12] = b[10];
+    c[12] = DJ[3] + 10;
+    d[12] = di2 + iext_s + 2 * iext_ass + 2 * ec;
+    /* nx1, 1xn */
+    a[13] = SA + LINIX(idx_3, 11, l);
+    b[13] = profile_row(prof, PROF_MM_1N, s0, s_1, 0, 0);
+    c[13] = DJ[0] + 10;
+    d[13] = di3 + 2 * iext_ass + 2 * ec;
+    a[14] = SA + LINIY(idx_1, 13, l);
+    b[14] = b[13];
+    c[14] = DJ[2] + 10;
+    d[14] = di1 + 2 * iext_ass + 2 * ec;
+    /* nx0, 0xn */
+    a[15] = SA + LBXI(idx_2, 11, l);
+    b[15] = profile_row(prof, PROF_AU, s0, 0, 0, 0);
+    c[15] = DJ[0] + 10;
+    d[15] = di2 + bext + 2 * ec;
+    a[16] = SA + LBYI(idx_1, 12, l);
+    b[16] = b[15];
+    c[16] = DJ[1] + 10;
+    d[16] = di1 + bext + 2 * ec;
+    vrna_fun_min_add_terms(SA + LCI(idx, 10, l), a, b, c, d, 17, count);
+
+    /* reset all positions outside the queries, including the padding for full vectors */
+    for (q = 0; q < s->num; q++) {
+      int last = (q + 1 < s->num) ? s->off[q + 1] + 10 : 10 + count;
+      for (j = s->off[q] + s->n2[q] - 9; j < last; j++) {
+        SA[LCI(idx, j, l)]    = INF;
+        SA[LINI(idx, j, l)]   = INF;
+        SA[LINIX(idx, j, l)]  = INF;
+        SA[LINIY(idx, j, l)]  = INF;
+        SA[LBXI(idx, j, l)]   = INF;
+      }
+    }
+
+    /**
+    *** extensions along j within column i, and the best duplex of each query
+    **/
+    ext     = profile_row(prof, PROF_EXT, s0, S1[i + 1], 0, 0) - 10;
+    open_by = profile_row(prof, PROF_OPEN_BY, s0, 0, 0, 0) - 10;
+
+    for (q = 0; q < s->num; q++) {
+      int o           = s->off[q];
+      int min_colonne = INF;
+
+      for (j = o + s->n2[q] - 10; j > o + 9; j--) {
+        int dj1 = DJ[0][j];
+
+        SA[LINIY(idx, j, l)] =
+          MIN2(SA[LINIY(idx, j, l)], SA[LINIY(idx, j + 1, l)] + iext_ass + dj1);
+        SA[LINI(idx, j, l)] =
+          MIN2(SA[LINI(idx, j, l)], SA[LINI(idx, j + 1, l)] + iext_ass + dj1);
+        SA[LBYI(idx, j, l)] = MIN2(SA[LBYI(idx, j + 1, l)] + bext + dj1,
+                                   SA[LCI(idx, j + 1, l)] + bopen + bext + open_by[j] + dj1);
+
+        /* the sentinel of ext[j] excludes positions that can't pair with i */
+        en = SA[LCI(idx, j, l)] + ext[j] + 2 * ec;
+        if (en < min_colonne) {
+          min_colonne         = en;
+          s->min_j_colonne[q] = j - o;
+        }
+      }
+
+      if (s->max[q] >= min_colonne) {
+        s->max[q]       = min_colonne;
+        s->max_pos[q]   = i;
+        s->max_pos_j[q] = s->min_j_colonne[q];
+      }
 
-  while (--size) {
-    free(array[size]->structure);
-    free(array[size]);
+      s->position[q][i + s->delta]    = min_colonne;
+      s->position_j[q][i + s->delta]  = s->min_j_colonne[q];
+    }
   }
-  free(array[0]->structure);
-  free(array);
+}
+
+
+/**
+*** Same as scan_XS() and scan() but the energy contributions are taken
+*** from query profiles, see scan_profile_init()
+**/
+PRIVATE int
+scan_profile(const plex_model_t *m,
+             const short        *S1,
+             const int          n1,
+             const short        *S2,
+             const short        *SS2,
+             const int          n2,
+             const int          **access_s1,
+             const int          **access_s2,
+             const int          extension_cost,
+             const int          delta,
+             const int          il_a,
+             const int          il_b,
+             const int          b_a,
+             const int          b_b,
+             int                *position,
+             int                *position_j,
+             int                *max_pos,
+             int                *max_pos_j)
+{
+  int         max, *DI;
+  plex_scan_t *s;
+
+  s = scan_profile_init(m,
+                        1,
+                        (short **)&S2,
+                        (short **)&SS2,
+                        &n2,
+                        (access_s2) ? &access_s2 : NULL,
+                        extension_cost,
+                        delta,
+                        il_a,
+                        il_b,
+                        b_a,
+                        b_b,
+                        &position,
+                        &position_j);
+
+  DI = NULL;
+  if (access_s1) {
+    DI = (int *)vrna_alloc(sizeof(int) * 4 * (n1 - 19));
+    scan_target_di(access_s1, 10, n1 - 9, DI);
+  }
+
+  scan_profile_columns(s, S1, DI, 10, n1 - 9);
+
+  max = s->max[0];
+  if (max < INF) {
+    *max_pos    = s->max_pos[0];
+    *max_pos_j  = s->max_pos_j[0];
+  }
+
+  free(DI);
+  scan_profile_free(s);
+
+  return max;
+}
+
+
+/*
+ #####################################
+ # Reentrant duplex engine           #
+ #####################################
+ */
+
+/**
+*** Hits of a scan are collected either in a list, or in a bounded heap that
+*** only keeps the max_hits hits of lowest energy (all if max_hits == 0)
+**/
+typedef struct {
+  duplexT       **list;
+  unsigned int  num;
+  unsigned int  size;
+  vrna_heap_t   heap;
+  unsigned int  max_hits;
+} plex_hits_t;
+
+/* maximal number of queries that vrna_plex_scan_batch() scans together */
+#define PLEX_BATCH_QUERIES  8
+
+
+/* hits of higher energy are smaller, such that the root of the heap is the worst hit */
+PRIVATE int
+plex_hit_cmp(const void *a,
+             const void *b,
+             void       *data)
+{
+  const duplexT *h1 = (const duplexT *)a;
+  const duplexT *h2 = (const duplexT *)b;
+
+  if (h1->energy != h2->energy)
+    return (h1->energy > h2->energy) ? -1 : 1;
+
+  if (h1->i != h2->i)
+    return (h1->i > h2->i) ? -1 : 1;
+
+  if (h1->j != h2->j)
+    return (h1->j > h2->j) ? -1 : 1;
+
+  return 0;
+}
+
+
+PRIVATE void
+plex_hits_init(plex_hits_t  *hits,
+               int          bounded,
+               unsigned int max_hits)
+{
+  hits->num       = 0;
+  hits->size      = 16;
+  hits->list      = NULL;
+  hits->heap      = NULL;
+  hits->max_hits  = max_hits;
+
+  if (bounded)
+    hits->heap = vrna_heap_init((max_hits) ? max_hits + 1 : 16, plex_hit_cmp, NULL, NULL, NULL);
+  else
+    hits->list = (duplexT **)vrna_alloc(sizeof(duplexT *) * hits->size);
+}
+
+
+PRIVATE void
+plex_hits_add(plex_hits_t *hits,
+              duplexT     *hit)
+{
+  duplexT *worst;
+
+  if (!hits->heap) {
+    if (hits->num + 1 >= hits->size) {
+      hits->size  *= 2;
+      hits->list  = (duplexT **)vrna_realloc(hits->list, sizeof(duplexT *) * hits->size);
+    }
+
+    hits->list[hits->num++] = hit;
+    return;
+  }
+
+  if ((hits->max_hits) && (vrna_heap_size(hits->heap) >= hits->max_hits)) {
+    worst = (duplexT *)vrna_heap_top(hits->heap);
+    if (plex_hit_cmp(hit, worst, NULL) <= 0) {
+      free(hit->structure);
+      free(hit);
+      return;
+    }
+
+    (void)vrna_heap_pop(hits->heap);
+    free(worst->structure);
+    free(worst);
+  }
+
+  vrna_heap_insert(hits->heap, hit);
+}
+
+
+/**
+*** Convert collected hits into a NULL-terminated list. Hits of a bounded
+*** heap are sorted by increasing energy
+**/
+PRIVATE duplexT **
+plex_hits_finalize(plex_hits_t *hits)
+{
+  size_t  k;
+  duplexT **list, *hit;
+
+  if (!hits->heap) {
+    list            = (duplexT **)vrna_realloc(hits->list, sizeof(duplexT *) * (hits->num + 1));
+    list[hits->num] = NULL;
+    return list;
+  }
+
+  k       = vrna_heap_size(hits->heap);
+  list    = (duplexT **)vrna_alloc(sizeof(duplexT *) * (k + 1));
+  list[k] = NULL;
+
+  while ((hit = (duplexT *)vrna_heap_pop(hits->heap)))
+    list[--k] = hit;
+
+  vrna_heap_free(hits->heap);
+
+  return list;
+}
+
+
+/**
+*** store_hit_XS refines the duplex closed by (pos, pos_j) of the padded
+*** sequences s1, s2 and adds it to the hits if its energy is below
+*** threshold. Returns non-zero if a hit has been stored
+**/
+PRIVATE int
+store_hit_XS(const plex_model_t *m,
+             const char         *s1,
+             const char         *s2,
+             const int          n1,
+             const int          n2,
+             const int          **access_s1,
+             const int          **access_s2,
+             const int          pos,
+             const int          pos_j,
+             const int          alignment_length,
+             const int          threshold,
+             plex_hits_t        *hits)
+{
+  int     begin_t, end_t, begin_q, end_q, i_flag, j_flag;
+  char    *s3, *s4;
+  duplexT test, *hit;
+
+  begin_t = MAX2(11, pos - alignment_length);
+  end_t   = MIN2(n1 - 10, pos + 1);
+  begin_q = MAX2(11, pos_j - 1);
+  end_q   = MIN2(n2 - 10, pos_j + alignment_length - 1);
+  i_flag  = (end_t == pos + 1 ? 1 : 0);
+  j_flag  = (begin_q == pos_j - 1 ? 1 : 0);
+  s3      = (char *)vrna_alloc(sizeof(char) * (end_t - begin_t + 2));
+  s4      = (char *)vrna_alloc(sizeof(char) * (end_q - begin_q + 2));
+
+  strncpy(s3, (s1 + begin_t - 1), end_t - begin_t + 1);
+  strncpy(s4, (s2 + begin_q - 1), end_q - begin_q + 1);
+
+  test = duplexfold_XS(m, s3, s4, access_s1, access_s2, pos, pos_j, threshold, i_flag, j_flag);
+
+  free(s3);
+  free(s4);
+
+  if ((!test.structure) || (test.energy * 100 >= threshold)) {
+    free(test.structure);
+    return 0;
+  }
+
+  test.i  = pos - 10;
+  test.j  = pos_j - 10;
+
+  hit   = (duplexT *)vrna_alloc(sizeof(duplexT));
+  *hit  = test;
+  plex_hits_add(hits, hit);
+
+  return 1;
+}
+
+
+/**
+*** Refine the suboptimal hits (see find_max_XS()) and the optimal hit (see
+*** plot_max_XS()) of a scan. If unique is set, the optimal hit is skipped
+*** whenever the suboptimal hits already contain it
+**/
+PRIVATE void
+collect_hits_XS(const vrna_plex_engine_t  *engine,
+                const char                *s1,
+                const char                *s2,
+                const int                 n1,
+                const int                 n2,
+                const int                 **access_t,
+                const int                 **access_q,
+                const int                 *position,
+                const int                 *position_j,
+                const int                 max,
+                const int                 max_pos,
+                const int                 max_pos_j,
+                const int                 unique,
+                plex_hits_t               *hits)
+{
+  int pos, best_seen, delta, threshold;
+
+  delta     = engine->delta;
+  threshold = engine->threshold;
+  best_seen = 0;
+
+  /* suboptimal hits, see find_max_XS() */
+  if (max < threshold) {
+    pos = n1 - 9;
+    while (pos-- > 10) {
+      int temp_min = 0;
+      if (position[pos + delta] < threshold) {
+        int search_range;
+        search_range = delta + 1;
+        while (--search_range)
+          if (position[pos + delta - search_range] <= position[pos + delta - temp_min])
+            temp_min = search_range;
+
+        pos -= temp_min;
+
+        if (store_hit_XS(&(engine->model),
+                         s1,
+                         s2,
+                         n1,
+                         n2,
+                         access_t,
+                         access_q,
+                         pos,
+                         position_j[pos + delta],
+                         engine->alignment_length,
+                         threshold,
+                         hits)) {
+          if ((pos == max_pos) && (position_j[pos + delta] == max_pos_j))
+            best_seen = 1;
+
+          pos = MAX2(10, pos + temp_min - delta);
+        }
+      }
+    }
+  }
+
+  /* optimal hit, see plot_max_XS() */
+  if ((max < INF) && (!(unique && best_seen)))
+    (void)store_hit_XS(&(engine->model),
+                       s1,
+                       s2,
+                       n1,
+                       n2,
+                       access_t,
+                       access_q,
+                       max_pos,
+                       max_pos_j,
+                       engine->alignment_length,
+                       INF,
+                       hits);
+}
+
+
+/**
+*** opening energies of zero for a query without accessibility profile
+**/
+PRIVATE int **
+zero_access(int n,
+            int u)
+{
+  int i, **a;
+
+  a = (int **)vrna_alloc(sizeof(int *) * (u + 2));
+  for (i = 0; i < u + 2; i++)
+    a[i] = (int *)vrna_alloc(sizeof(int) * (n + 20));
+
+  a[0][0] = u + 2;
+
+  return a;
+}
+
+
+PUBLIC vrna_plex_engine_t *
+vrna_plex_engine(const vrna_md_t  *md,
+                 int              threshold,
+                 int              alignment_length,
+                 int              delta,
+                 int              il_a,
+                 int              il_b,
+                 int              b_a,
+                 int              b_b)
+{
+  vrna_md_t           md_local;
+  vrna_plex_engine_t  *engine;
+
+  if ((alignment_length < 1) || (delta < 0))
+    return NULL;
+
+  if (md) {
+    md_local = *md;
+    vrna_md_update(&md_local);
+  } else {
+    set_model_details(&md_local);
+    /* pair rules follow the globals, as for make_pair_matrix() in Lduplexfold_XS() */
+    md_local.noGU         = noGU;
+    md_local.noGUclosure  = no_closingGU;
+    vrna_md_update(&md_local);
+  }
+
+  engine = (vrna_plex_engine_t *)vrna_alloc(sizeof(vrna_plex_engine_t));
+
+  engine->model.P           = vrna_params(&md_local);
+  engine->model.pair        = engine->model.P->model_details.pair;
+  engine->model.rtype       = engine->model.P->model_details.rtype;
+  engine->threshold         = threshold;
+  engine->alignment_length  = alignment_length;
+  engine->delta             = delta;
+  engine->il_a              = il_a;
+  engine->il_b              = il_b;
+  engine->b_a               = b_a;
+  engine->b_b               = b_b;
+
+  return engine;
+}
+
+
+PUBLIC void
+vrna_plex_engine_free(vrna_plex_engine_t *engine)
+{
+  if (engine) {
+    free(engine->model.P);
+    free(engine);
+  }
+}
+
+
+PUBLIC duplexT **
+vrna_plex_scan(const vrna_plex_engine_t *engine,
+               const char               *target,
+               const char               *query,
+               const int                **access_t,
+               const int                **access_q)
+{
+  char          *s1, *s2;
+  short         *S1, *SS1, *S2, *SS2;
+  int           n1, n2, u, k, max, max_pos, max_pos_j, delta;
+  int           *position, *position_j, **zero_q;
+  plex_hits_t   hits;
+
+  if ((!engine) || (!target) || (!query) || (!access_t))
+    return NULL;
+
+  /* the refinement looks at opening energies of up to alignment_length + 1 nucleotides */
+  u = MAX2(engine->alignment_length, 5);
+
+  if ((access_t[0][0] < u + 2) ||
+      ((access_q) && (access_q[0][0] < u + 2))) {
+    vrna_message_warning("vrna_plex_scan: "
+                         "Opening energies must cover stretches of at least %d nucleotides",
+                         u);
+    return NULL;
+  }
+
+  n1      = (int)strlen(target) + 20;
+  n2      = (int)strlen(query) + 20;
+  delta   = engine->delta;
+  zero_q  = NULL;
+
+  if (!access_q) {
+    zero_q    = zero_access(n2 - 20, u);
+    access_q  = (const int **)zero_q;
+  }
+
+  /* pad both sequences with 10 N on either side as RNAplex does */
+  s1  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", target);
+  s2  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", query);
+
+  encode_seq_md(s1, &(engine->model.P->model_details), &S1, &SS1);
+  encode_seq_md(s2, &(engine->model.P->model_details), &S2, &SS2);
+
+  position    = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+  position_j  = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+  max_pos     = max_pos_j = 0;
+
+  max = scan_XS(&(engine->model),
+                S1,
+                SS1,
+                n1,
+                S2,
+                SS2,
+                n2,
+                access_t,
+                access_q,
+                delta,
+                engine->il_a,
+                engine->il_b,
+                engine->b_a,
+                engine->b_b,
+                position,
+                position_j,
+                &max_pos,
+                &max_pos_j);
+
+  free(S1);
+  free(S2);
+  free(SS1);
+  free(SS2);
+
+  plex_hits_init(&hits, 0, 0);
+  collect_hits_XS(engine,
+                  s1,
+                  s2,
+                  n1,
+                  n2,
+                  access_t,
+                  access_q,
+                  position,
+                  position_j,
+                  max,
+                  max_pos,
+                  max_pos_j,
+                  0,
+                  &hits);
+
+  if (zero_q) {
+    for (k = 0; k < u + 2; k++)
+      free(zero_q[k]);
+    free(zero_q);
+  }
+
+  free(position);
+  free(position_j);
+  free(s1);
+  free(s2);
+
+  return plex_hits_finalize(&hits);
+}
+
+
+PUBLIC duplexT ***
+vrna_plex_scan_multi(const vrna_plex_engine_t *engine,
+                     const char               **targets,
+                     const int                ***access_t,
+                     unsigned int             num_targets,
+                     const char               **queries,
+                     const int                ***access_q,
+                     unsigned int             num_queries)
+{
+  int       k, num;
+  duplexT   ***hits;
+
+  if ((!engine) || (!targets) || (!access_t) || (!queries) ||
+      (num_targets == 0) || (num_queries == 0))
+    return NULL;
+
+  num   = (int)(num_targets * num_queries);
+  hits  = (duplexT ***)vrna_alloc(sizeof(duplexT * *) * num);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < num; k++) {
+    unsigned int t = (unsigned int)k / num_queries;
+    unsigned int q = (unsigned int)k % num_queries;
+
+    hits[k] = vrna_plex_scan(engine,
+                             targets[t],
+                             queries[q],
+                             access_t[t],
+                             (access_q) ? access_q[q] : NULL);
+  }
+
+  return hits;
+}
+
+
+PUBLIC duplexT ***
+vrna_plex_scan_batch(const vrna_plex_engine_t *engine,
+                     const char               *target,
+                     const int                **access_t,
+                     const char               **queries,
+                     const int                ***access_q,
+                     unsigned int             num_queries,
+                     unsigned int             max_hits)
+{
+  char          *s1, **s2;
+  short         *S1, *SS1, **S2, **SS2;
+  int           n1, *n2, u, k, q, num_blocks, total = 0, delta, too_few, compatible;
+  int           *max, *max_pos, *max_pos_j, *block, *DI;
+  int           **position, **position_j, ***zero_q;
+  const int     ***acc_q;
+  duplexT       ***hits;
+
+  if ((!engine) || (!target) || (!access_t) || (!queries) || (num_queries == 0))
+    return NULL;
+
+  /* the refinement looks at opening energies of up to alignment_length + 1 nucleotides */
+  u       = MAX2(engine->alignment_length, 5);
+  too_few = (access_t[0][0] < u + 2);
+
+  if (access_q)
+    for (q = 0; q < (int)num_queries; q++)
+      if ((access_q[q]) && (access_q[q][0][0] < u + 2))
+        too_few = 1;
+
+  if (too_few) {
+    vrna_message_warning("vrna_plex_scan_batch: "
+                         "Opening energies must cover stretches of at least %d nucleotides",
+                         u);
+    return NULL;
+  }
+
+  n1    = (int)strlen(target) + 20;
+  delta = engine->delta;
+  s1    = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", target);
+  encode_seq_md(s1, &(engine->model.P->model_details), &S1, &SS1);
+
+  /* encode all queries only once */
+  s2          = (char **)vrna_alloc(sizeof(char *) * num_queries);
+  S2          = (short **)vrna_alloc(sizeof(short *) * num_queries);
+  SS2         = (short **)vrna_alloc(sizeof(short *) * num_queries);
+  n2          = (int *)vrna_alloc(sizeof(int) * num_queries);
+  acc_q       = (const int ***)vrna_alloc(sizeof(int * *) * num_queries);
+  zero_q      = (int ***)vrna_alloc(sizeof(int * *) * num_queries);
+  position    = (int **)vrna_alloc(sizeof(int *) * num_queries);
+  position_j  = (int **)vrna_alloc(sizeof(int *) * num_queries);
+  hits        = (duplexT ***)vrna_alloc(sizeof(duplexT * *) * num_queries);
+  max         = (int *)vrna_alloc(sizeof(int) * num_queries);
+  max_pos     = (int *)vrna_alloc(sizeof(int) * num_queries);
+  max_pos_j   = (int *)vrna_alloc(sizeof(int) * num_queries);
+
+  for (q = 0; q < (int)num_queries; q++) {
+    n2[q] = (int)strlen(queries[q]) + 20;
+    s2[q] = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", queries[q]);
+    encode_seq_md(s2[q], &(engine->model.P->model_details), &(S2[q]), &(SS2[q]));
+
+    if ((access_q) && (access_q[q])) {
+      acc_q[q] = access_q[q];
+    } else {
+      zero_q[q] = zero_access(n2[q] - 20, u);
+      acc_q[q]  = (const int **)zero_q[q];
+    }
+
+    position[q]   = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+    position_j[q] = (int *)vrna_alloc((delta + n1 + 3 + delta) * sizeof(int));
+  }
+
+  /*
+   *  group consecutive queries into blocks that are scanned together,
+   *  queries that can't be handled by query profiles are scanned on their own
+   */
+  block       = (int *)vrna_alloc(sizeof(int) * (num_queries + 1));
+  num_blocks  = 0;
+  compatible  = profile_compatible(S1, SS1, n1, 20);
+
+  for (q = 0; q < (int)num_queries; q++) {
+    if ((num_blocks == 0) ||
+        (!compatible) ||
+        (q - block[num_blocks - 1] >= PLEX_BATCH_QUERIES) ||
+        (total + n2[q] > PLEX_PROFILE_MAX_LENGTH)) {
+      block[num_blocks++] = q;
+      total               = 0;
+    }
+
+    total += n2[q];
+  }
+
+  block[num_blocks] = (int)num_queries;
+
+  /* the accessibility contributions of the target are shared by all blocks */
+  DI = (int *)vrna_alloc(sizeof(int) * 4 * (n1 - 19));
+  scan_target_di(access_t, 10, n1 - 9, DI);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < num_blocks; k++) {
+    int         b, q, first, num;
+    plex_scan_t *scan;
+    plex_hits_t h;
+
+    first = block[k];
+    num   = block[k + 1] - first;
+    scan  = NULL;
+
+    if ((compatible) && (profile_compatible(S1, SS1, n1, n2[first]))) {
+      scan = scan_profile_init(&(engine->model),
+                               num,
+                               S2 + first,
+                               SS2 + first,
+                               n2 + first,
+                               acc_q + first,
+                               0,
+                               delta,
+                               engine->il_a,
+                               engine->il_b,
+                               engine->b_a,
+                               engine->b_b,
+                               position + first,
+                               position_j + first);
+
+      scan_profile_columns(scan, S1, DI, 10, n1 - 9);
+
+      for (b = 0; b < num; b++) {
+        max[first + b] = scan->max[b];
+        if (scan->max[b] < INF) {
+          max_pos[first + b]    = scan->max_pos[b];
+          max_pos_j[first + b]  = scan->max_pos_j[b];
+        }
+      }
+
+      scan_profile_free(scan);
+    } else {
+      for (b = 0; b < num; b++) {
+        q       = first + b;
+        max[q]  = scan_XS(&(engine->model),
+                          S1,
+                          SS1,
+                          n1,
+                          S2[q],
+                          SS2[q],
+                          n2[q],
+                          access_t,
+                          acc_q[q],
+                          delta,
+                          engine->il_a,
+                          engine->il_b,
+                          engine->b_a,
+                          engine->b_b,
+                          position[q],
+                          position_j[q],
+                          &(max_pos[q]),
+                          &(max_pos_j[q]));
+      }
+    }
+
+    for (b = 0; b < num; b++) {
+      q = first + b;
+
+      plex_hits_init(&h, 1, max_hits);
+      collect_hits_XS(engine,
+                      s1,
+                      s2[q],
+                      n1,
+                      n2[q],
+                      access_t,
+                      acc_q[q],
+                      position[q],
+                      position_j[q],
+                      max[q],
+                      max_pos[q],
+                      max_pos_j[q],
+                      1,
+                      &h);
+      hits[q] = plex_hits_finalize(&h);
+    }
+  }
+
+  for (q = 0; q < (int)num_queries; q++) {
+    if (zero_q[q]) {
+      for (k = 0; k < u + 2; k++)
+        free(zero_q[q][k]);
+      free(zero_q[q]);
+    }
+
+    free(s2[q]);
+    free(S2[q]);
+    free(SS2[q]);
+    free(position[q]);
+    free(position_j[q]);
+  }
+
+  free(s1);
+  free(S1);
+  free(SS1);
+  free(s2);
+  free(S2);
+  free(SS2);
+  free(n2);
+  free(acc_q);
+  free(zero_q);
+  free(position);
+  free(position_j);
+  free(max);
+  free(max_pos);
+  free(max_pos_j);
+  free(block);
+  free(DI);
+
+  return hits;
+}
+
+
+/*
+ #####################################
+ # Accessibility database            #
+ #####################################
+ */
+
+/*
+ *  Layout of the database file (native byte order):
+ *
+ *  header  : magic[8], version, number of records, max_unpaired (uint32_t each), padding
+ *  index   : per record the file offset (uint64_t), the sequence length and the
+ *            length of the identifier (uint32_t each)
+ *  records : identifier and sequence (both '\0'-terminated), padded to a multiple
+ *            of 8 bytes, followed by (max_unpaired + 2) rows of (length + 20)
+ *            int32_t opening energies in the layout RNAplex uses
+ */
+#define PLEX_DB_MAGIC     "VRNAPLXA"
+#define PLEX_DB_VERSION   1
+#define PLEX_DB_HEADER    24
+#define PLEX_DB_ENTRY     16
+#define PLEX_DB_ALIGN(x)  (((x) + 7) & ~((uint64_t)7))
+
+struct plex_db_entry {
+  uint64_t  offset;
+  uint32_t  length;
+  uint32_t  id_length;
+};
+
+struct plex_db_pu {
+  int     **a;
+  int     max_unpaired;
+  double  kT;
+};
+
+
+PRIVATE void
+plex_db_pu_cb(FLT_OR_DBL    *pr,
+              int           pr_size,
+              int           i,
+              int           max,
+              unsigned int  type,
+              void          *data)
+{
+  int               u;
+  struct plex_db_pu *d = (struct plex_db_pu *)data;
+
+  if ((type & VRNA_PROBS_WINDOW_UP) && ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP)) {
+    for (u = 1; u <= MIN2(pr_size, d->max_unpaired); u++)
+      if (pr[u] > 0)
+        d->a[u][i + 10] = (int)rint(100 * (-log(pr[u])) * d->kT);
+  }
+}
+
+
+/* size of identifier and sequence including padding, i.e. the offset of the opening energies */
+PRIVATE uint64_t
+plex_db_record_head(uint32_t  length,
+                    uint32_t  id_length)
+{
+  return PLEX_DB_ALIGN((uint64_t)id_length + 1 + length + 1);
+}
+
+
+PRIVATE uint64_t
+plex_db_record_size(uint32_t  length,
+                    uint32_t  id_length,
+                    uint32_t  max_unpaired)
+{
+  return PLEX_DB_ALIGN(plex_db_record_head(length, id_length) +
+                       sizeof(int32_t) * (uint64_t)(max_unpaired + 2) * (length + 20));
+}
+
+
+PUBLIC int
+vrna_plex_access_db_build(const char      *filename,
+                          const char      **ids,
+                          const char      **sequences,
+                          unsigned int    num,
+                          unsigned int    max_unpaired,
+                          int             window_size,
+                          int             max_bp_span,
+                          const vrna_md_t *md)
+{
+  unsigned char         header[PLEX_DB_HEADER];
+  int                   k, ret;
+  uint32_t              v;
+  uint64_t              offset;
+  FILE                  *fp;
+  vrna_md_t             md_local;
+  struct plex_db_entry  *entries;
+
+  if ((!filename) || (!sequences) || (num == 0) || (max_unpaired == 0))
+    return 0;
+
+  if (!(fp = fopen(filename, "wb"))) {
+    vrna_message_warning("vrna_plex_access_db_build: Can't open file %s for writing", filename);
+    return 0;
+  }
+
+  if (md)
+    md_local = *md;
+  else
+    set_model_details(&md_local);
+
+  md_local.compute_bpp  = 1;
+  md_local.window_size  = window_size;
+  md_local.max_bp_span  = max_bp_span;
+
+  /* all sizes are known in advance, so each record can be written to its final offset */
+  entries = (struct plex_db_entry *)vrna_alloc(sizeof(struct plex_db_entry) * num);
+  offset  = PLEX_DB_ALIGN(PLEX_DB_HEADER + (uint64_t)PLEX_DB_ENTRY * num);
+
+  for (k = 0; k < (int)num; k++) {
+    entries[k].offset     = offset;
+    entries[k].length     = (uint32_t)strlen(sequences[k]);
+    entries[k].id_length  = (ids && ids[k]) ? (uint32_t)strlen(ids[k]) : 0;
+    offset                += plex_db_record_size(entries[k].length,
+                                                 entries[k].id_length,
+                                                 max_unpaired);
+  }
+
+  memset(header, 0, sizeof(header));
+  memcpy(header, PLEX_DB_MAGIC, 8);
+  v = PLEX_DB_VERSION;
+  memcpy(header + 8, &v, sizeof(uint32_t));
+  v = num;
+  memcpy(header + 12, &v, sizeof(uint32_t));
+  v = max_unpaired;
+  memcpy(header + 16, &v, sizeof(uint32_t));
+
+  ret = (fwrite(header, 1, PLEX_DB_HEADER, fp) == PLEX_DB_HEADER);
+
+  for (k = 0; (k < (int)num) && (ret); k++) {
+    unsigned char buf[PLEX_DB_ENTRY];
+    memcpy(buf, &(entries[k].offset), sizeof(uint64_t));
+    memcpy(buf + 8, &(entries[k].length), sizeof(uint32_t));
+    memcpy(buf + 12, &(entries[k].id_length), sizeof(uint32_t));
+    ret = (fwrite(buf, 1, PLEX_DB_ENTRY, fp) == PLEX_DB_ENTRY);
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < (int)num; k++) {
+    unsigned int          u, i, n, cols;
+    int32_t               *record;
+    unsigned char         *buf;
+    uint64_t              size;
+    vrna_fold_compound_t  *fc;
+    struct plex_db_pu     d;
+
+    n     = entries[k].length;
+    cols  = n + 20;
+    size  = plex_db_record_size(n, entries[k].id_length, max_unpaired);
+    buf   = (unsigned char *)vrna_alloc(size);
+
+    if (entries[k].id_length)
+      memcpy(buf, ids[k], entries[k].id_length);
+
+    memcpy(buf + entries[k].id_length + 1, sequences[k], n);
+
+    record  = (int32_t *)(buf + plex_db_record_head(n, entries[k].id_length));
+    d.a     = (int **)vrna_alloc(sizeof(int *) * (max_unpaired + 2));
+    for (u = 0; u < max_unpaired + 2; u++) {
+      d.a[u] = (int *)vrna_alloc(sizeof(int) * cols);
+      for (i = 0; i < cols; i++)
+        d.a[u][i] = INF;
+    }
+
+    d.max_unpaired  = (int)max_unpaired;
+    d.kT            = (md_local.temperature + K0) * GASCONST / 1000.0;
+
+    fc = vrna_fold_compound(sequences[k], &md_local, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+    if (fc) {
+      vrna_ptypes_prepare(fc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+      (void)vrna_probs_window(fc, (int)max_unpaired, VRNA_PROBS_WINDOW_UP, &plex_db_pu_cb, &d);
+      vrna_fold_compound_free(fc);
+    }
+
+    d.a[0][0] = (int)max_unpaired + 2;
+
+    for (u = 0; u < max_unpaired + 2; u++) {
+      for (i = 0; i < cols; i++)
+        record[u * cols + i] = (int32_t)d.a[u][i];
+      free(d.a[u]);
+    }
+    free(d.a);
+
+#ifdef _OPENMP
+#pragma omp critical (plex_db_write)
+#endif
+    {
+      if ((ret) &&
+          ((fseek(fp, (long)entries[k].offset, SEEK_SET) != 0) ||
+           (fwrite(buf, 1, size, fp) != size)))
+        ret = 0;
+    }
+
+    free(buf);
+  }
+
+  if (fclose(fp) != 0)
+    ret = 0;
+
+  free(entries);
+
+  if (!ret)
+    vrna_message_warning("vrna_plex_access_db_build: Failed to write database %s", filename);
+
+  return ret;
+}
+
+
+PRIVATE struct plex_db_entry
+plex_db_get_entry(const vrna_plex_access_db_t *db,
+                  unsigned int                i)
+{
+  struct plex_db_entry  e;
+  const unsigned char   *p = db->data + PLEX_DB_HEADER + PLEX_DB_ENTRY * (size_t)i;
+
+  memcpy(&e.offset, p, sizeof(uint64_t));
+  memcpy(&e.length, p + 8, sizeof(uint32_t));
+  memcpy(&e.id_length, p + 12, sizeof(uint32_t));
+
+  return e;
+}
+
+
+PUBLIC vrna_plex_access_db_t *
+vrna_plex_access_db_open(const char *filename)
+{
+  unsigned char         *data;
+  unsigned int          k;
+  int                   mapped;
+  uint32_t              version, num, max_unpaired;
+  size_t                size;
+  vrna_plex_access_db_t *db;
+
+  if (!filename)
+    return NULL;
+
+  data    = NULL;
+  mapped  = 0;
+  size    = 0;
+
+#ifndef _WIN32
+  {
+    int         fd;
+    struct stat st;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+      return NULL;
+
+    if ((fstat(fd, &st) == 0) && (st.st_size >= PLEX_DB_HEADER)) {
+      size  = (size_t)st.st_size;
+      data  = (unsigned char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == (unsigned char *)MAP_FAILED)
+        data = NULL;
+      else
+        mapped = 1;
+    }
+
+    close(fd);
+  }
+#endif
+
+  if (!data) {
+    /* fall back to reading the entire file into memory */
+    FILE *fp;
+    long  len;
+
+    if (!(fp = fopen(filename, "rb")))
+      return NULL;
+
+    if ((fseek(fp, 0, SEEK_END) == 0) &&
+        ((len = ftell(fp)) >= PLEX_DB_HEADER) &&
+        (fseek(fp, 0, SEEK_SET) == 0)) {
+      size  = (size_t)len;
+      data  = (unsigned char *)vrna_alloc(size);
+      if (fread(data, 1, size, fp) != size) {
+        free(data);
+        data = NULL;
+      }
+    }
+
+    fclose(fp);
+
+    if (!data)
+      return NULL;
+  }
+
+  memcpy(&version, data + 8, sizeof(uint32_t));
+  memcpy(&num, data + 12, sizeof(uint32_t));
+  memcpy(&max_unpaired, data + 16, sizeof(uint32_t));
+
+  db                = (vrna_plex_access_db_t *)vrna_alloc(sizeof(vrna_plex_access_db_t));
+  db->data          = data;
+  db->size          = size;
+  db->mapped        = mapped;
+  db->num           = num;
+  db->max_unpaired  = max_unpaired;
+
+  /* sanity checks */
+  if ((memcmp(data, PLEX_DB_MAGIC, 8) != 0) ||
+      (version != PLEX_DB_VERSION) ||
+      (PLEX_DB_HEADER + (uint64_t)PLEX_DB_ENTRY * num > size)) {
+    vrna_message_warning("vrna_plex_access_db_open: %s is not a valid accessibility database",
+                         filename);
+    vrna_plex_access_db_close(db);
+    return NULL;
+  }
+
+  for (k = 0; k < num; k++) {
+    struct plex_db_entry e = plex_db_get_entry(db, k);
+    if ((e.offset % 8) ||
+        (e.offset + plex_db_record_size(e.length, e.id_length, max_unpaired) > size)) {
+      vrna_message_warning("vrna_plex_access_db_open: %s is truncated", filename);
+      vrna_plex_access_db_close(db);
+      return NULL;
+    }
+  }
+
+  return db;
+}
+
+
+PUBLIC void
+vrna_plex_access_db_close(vrna_plex_access_db_t *db)
+{
+  if (db) {
+#ifndef _WIN32
+    if (db->mapped)
+      munmap(db->data, db->size);
+    else
+#endif
+    free(db->data);
+
+    free(db);
+  }
+}
+
+
+PUBLIC unsigned int
+vrna_plex_access_db_size(const vrna_plex_access_db_t *db)
+{
+  return (db) ? db->num : 0;
+}
+
+
+PUBLIC const char *
+vrna_plex_access_db_id(const vrna_plex_access_db_t  *db,
+                       unsigned int                 i)
+{
+  if ((!db) || (i >= db->num))
+    return NULL;
+
+  return (const char *)(db->data + plex_db_get_entry(db, i).offset);
+}
+
+
+PUBLIC const char *
+vrna_plex_access_db_sequence(const vrna_plex_access_db_t  *db,
+                             unsigned int                 i)
+{
+  struct plex_db_entry e;
+
+  if ((!db) || (i >= db->num))
+    return NULL;
+
+  e = plex_db_get_entry(db, i);
+
+  return (const char *)(db->data + e.offset + e.id_length + 1);
+}
+
+
+PUBLIC int
+vrna_plex_access_db_find(const vrna_plex_access_db_t  *db,
+                         const char                   *id)
+{
+  unsigned int i;
+
+  if ((db) && (id))
+    for (i = 0; i < db->num; i++)
+      if (!strcmp(vrna_plex_access_db_id(db, i), id))
+        return (int)i;
+
+  return -1;
+}
+
+
+PUBLIC const int **
+vrna_plex_access_db_get(const vrna_plex_access_db_t  *db,
+                        unsigned int                 i)
+{
+  unsigned int          u, cols;
+  const int             **a;
+  const int32_t         *record;
+  struct plex_db_entry  e;
+
+  if ((!db) || (i >= db->num))
+    return NULL;
+
+  e       = plex_db_get_entry(db, i);
+  cols    = e.length + 20;
+  record  = (const int32_t *)(db->data + e.offset + plex_db_record_head(e.length, e.id_length));
+  a = (const int **)vrna_alloc(sizeof(int *) * (db->max_unpaired + 2));
+
+  for (u = 0; u < db->max_unpaired + 2; u++)
+    a[u] = (const int *)(record + (size_t)u * cols);
+
+  return a;
 }
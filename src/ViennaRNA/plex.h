@@ -2,6 +2,21 @@
 #define VIENNA_RNA_PACKAGE_PLEX_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
+
+/**
+ *  @brief  A reentrant engine for RNAplex-like duplex scans with accessibility
+ *
+ *  @see vrna_plex_engine(), vrna_plex_scan(), vrna_plex_engine_free()
+ */
+typedef struct vrna_plex_engine_s vrna_plex_engine_t;
+
+/**
+ *  @brief  A database of precomputed opening energies for RNAplex-like duplex scans
+ *
+ *  @see vrna_plex_access_db_build(), vrna_plex_access_db_open(), vrna_plex_access_db_get()
+ */
+typedef struct vrna_plex_access_db_s vrna_plex_access_db_t;
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -80,4 +95,256 @@ void     freeDuplexT(duplexT** array);
 
 #endif
 
+/**
+ *  @brief  Prepare a reentrant engine for duplex scans with accessibility
+ *
+ *  The engine holds the energy parameters and all settings of the scan, such
+ *  that they are computed once rather than for each target/query pair as in
+ *  Lduplexfold_XS(). Since the engine is never modified afterwards, it may be
+ *  used by any number of threads at the same time.
+ *
+ *  The parameters correspond to those of Lduplexfold_XS(). Model details default
+ *  to the global settings when @p md is @em NULL.
+ *
+ *  @see  vrna_plex_scan(), vrna_plex_scan_multi(), vrna_plex_scan_batch(), vrna_plex_engine_free()
+ *
+ *  @param  md                The model details (may be @em NULL)
+ *  @param  threshold         Energy threshold for reported hits in dcal/mol
+ *  @param  alignment_length  Maximal length of an interaction
+ *  @param  delta             Minimal distance between two reported hits on the target
+ *  @param  il_a              Interior loop extension parameter of the linear loop model
+ *  @param  il_b              Interior loop opening parameter of the linear loop model
+ *  @param  b_a               Bulge loop extension parameter of the linear loop model
+ *  @param  b_b               Bulge loop opening parameter of the linear loop model
+ *  @return                   The duplex engine
+ */
+vrna_plex_engine_t *
+vrna_plex_engine(const vrna_md_t  *md,
+                 int              threshold,
+                 int              alignment_length,
+                 int              delta,
+                 int              il_a,
+                 int              il_b,
+                 int              b_a,
+                 int              b_b);
+
+
+/**
+ *  @brief  Free memory occupied by a duplex engine
+ *
+ *  @see  vrna_plex_engine()
+ *
+ *  @param  engine  The duplex engine
+ */
+void
+vrna_plex_engine_free(vrna_plex_engine_t *engine);
+
+
+/**
+ *  @brief  Scan a target RNA for duplexes with a query RNA taking accessibility into account
+ *
+ *  This is the reentrant counterpart of Lduplexfold_XS() with @p fast = 0. Instead
+ *  of printing them, the hits are returned in a @em NULL terminated list that
+ *  can be released with freeDuplexT(). Suboptimal hits are listed first, from the 3' to
+ *  the 5' end of the target, followed by the optimal hit. Positions refer to the
+ *  unmodified input sequences.
+ *
+ *  Opening energies are expected in the layout RNAplex uses, i.e.
+ *  @p access_t[u][i + 10] is the energy in dcal/mol required to open the stretch of
+ *  @f$ u @f$ nucleotides that ends at position @f$ i @f$ and @p access_t[0][0] holds
+ *  the number of rows, i.e. @f$ u_{max} + 2 @f$. Each row covers @f$ n + 20 @f$
+ *  positions and @f$ u_{max} @f$ must not be smaller than the maximal interaction
+ *  length of the engine. See vrna_plex_access_db_get() for a source of such arrays.
+ *
+ *  @see  vrna_plex_engine(), vrna_plex_scan_multi(), Lduplexfold_XS(), freeDuplexT()
+ *
+ *  @param  engine    The duplex engine
+ *  @param  target    The target RNA sequence
+ *  @param  query     The query RNA sequence
+ *  @param  access_t  The opening energies of the target
+ *  @param  access_q  The opening energies of the query (may be @em NULL for no opening penalties)
+ *  @return           A list of hits, or @em NULL on any error
+ */
+duplexT **
+vrna_plex_scan(const vrna_plex_engine_t *engine,
+               const char               *target,
+               const char               *query,
+               const int                **access_t,
+               const int                **access_q);
+
+
+/**
+ *  @brief  Scan many target RNAs for duplexes with many query RNAs
+ *
+ *  Evaluates all combinations of @p num_targets targets and @p num_queries queries
+ *  with vrna_plex_scan(). If OpenMP support is enabled, the combinations are
+ *  processed in parallel. The hits of query @f$ q @f$ on target @f$ t @f$ are stored
+ *  at position @f$ t \cdot num\_queries + q @f$ of the returned array.
+ *
+ *  @see  vrna_plex_scan()
+ *
+ *  @param  engine        The duplex engine
+ *  @param  targets       The target RNA sequences
+ *  @param  access_t      The opening energies of each target
+ *  @param  num_targets   The number of targets
+ *  @param  queries       The query RNA sequences
+ *  @param  access_q      The opening energies of each query (may be @em NULL)
+ *  @param  num_queries   The number of queries
+ *  @return               An array of @f$ num\_targets \cdot num\_queries @f$ hit lists, or @em NULL on any error
+ */
+duplexT ***
+vrna_plex_scan_multi(const vrna_plex_engine_t *engine,
+                     const char               **targets,
+                     const int                ***access_t,
+                     unsigned int             num_targets,
+                     const char               **queries,
+                     const int                ***access_q,
+                     unsigned int             num_queries);
+
+
+/**
+ *  @brief  Scan a target RNA for duplexes with a batch of query RNAs
+ *
+ *  In contrast to vrna_plex_scan_multi(), the target and its opening energies
+ *  are encoded only once. Queries are grouped into blocks that are concatenated
+ *  along the query axis, such that each position of the target is evaluated for
+ *  all queries of a block within a single pass. If OpenMP support is enabled,
+ *  blocks of queries are processed in parallel.
+ *
+ *  For each query, only the @p max_hits hits of lowest energy are kept, sorted
+ *  by increasing energy (all hits if @p max_hits is 0). Apart from this order
+ *  and the optimal hit, which isn't repeated if it is among the suboptimal hits
+ *  already, the hits are the same as for vrna_plex_scan(). The hits of query
+ *  @f$ q @f$ are stored at position @f$ q @f$ of the returned array and can be
+ *  released with freeDuplexT().
+ *
+ *  @see  vrna_plex_scan(), vrna_plex_scan_multi()
+ *
+ *  @param  engine        The duplex engine
+ *  @param  target        The target RNA sequence
+ *  @param  access_t      The opening energies of the target
+ *  @param  queries       The query RNA sequences
+ *  @param  access_q      The opening energies of each query (may be @em NULL)
+ *  @param  num_queries   The number of queries
+ *  @param  max_hits      The maximal number of hits per query (0 for no limit)
+ *  @return               An array of @p num_queries hit lists, or @em NULL on any error
+ *                        and for an empty batch
+ */
+duplexT ***
+vrna_plex_scan_batch(const vrna_plex_engine_t *engine,
+                     const char               *target,
+                     const int                **access_t,
+                     const char               **queries,
+                     const int                ***access_q,
+                     unsigned int             num_queries,
+                     unsigned int             max_hits);
+
+
+/**
+ *  @brief  Compute the opening energies for a set of RNAs and store them in a database file
+ *
+ *  Probabilities of being unpaired are obtained from vrna_probs_window() with the
+ *  given window settings, i.e. the same way RNAplfold -u computes them, and turned
+ *  into opening energies as required for vrna_plex_scan(). If OpenMP support is
+ *  enabled, the sequences are processed in parallel. The database is stored in
+ *  native byte order.
+ *
+ *  @see  vrna_plex_access_db_open()
+ *
+ *  @param  filename      The name of the database file
+ *  @param  ids           The identifiers of the sequences (may be @em NULL)
+ *  @param  sequences     The RNA sequences
+ *  @param  num           The number of sequences
+ *  @param  max_unpaired  The maximal length of unpaired stretches
+ *  @param  window_size   The size of the sliding window
+ *  @param  max_bp_span   The maximal base pair span
+ *  @param  md            The model details (may be @em NULL)
+ *  @return               Non-zero on success, 0 otherwise
+ */
+int
+vrna_plex_access_db_build(const char      *filename,
+                          const char      **ids,
+                          const char      **sequences,
+                          unsigned int    num,
+                          unsigned int    max_unpaired,
+                          int             window_size,
+                          int             max_bp_span,
+                          const vrna_md_t *md);
+
+
+/**
+ *  @brief  Open an accessibility database
+ *
+ *  The file is memory-mapped where supported, so opening a database is cheap and
+ *  opening energies are only read when they are actually used.
+ *
+ *  @see  vrna_plex_access_db_build(), vrna_plex_access_db_get(), vrna_plex_access_db_close()
+ *
+ *  @param  filename  The name of the database file
+ *  @return           The database, or @em NULL on any error
+ */
+vrna_plex_access_db_t *
+vrna_plex_access_db_open(const char *filename);
+
+
+/**
+ *  @brief  Close an accessibility database
+ *
+ *  Any opening energies obtained from the database become invalid.
+ *
+ *  @param  db  The database
+ */
+void
+vrna_plex_access_db_close(vrna_plex_access_db_t *db);
+
+
+/**
+ *  @brief  Get the number of records in an accessibility database
+ */
+unsigned int
+vrna_plex_access_db_size(const vrna_plex_access_db_t *db);
+
+
+/**
+ *  @brief  Get the identifier of a record in an accessibility database
+ */
+const char *
+vrna_plex_access_db_id(const vrna_plex_access_db_t  *db,
+                       unsigned int                 i);
+
+
+/**
+ *  @brief  Get the sequence of a record in an accessibility database
+ */
+const char *
+vrna_plex_access_db_sequence(const vrna_plex_access_db_t  *db,
+                             unsigned int                 i);
+
+
+/**
+ *  @brief  Find a record in an accessibility database by its identifier
+ *
+ *  @return The index of the record, or -1 if there is none
+ */
+int
+vrna_plex_access_db_find(const vrna_plex_access_db_t  *db,
+                         const char                   *id);
+
+
+/**
+ *  @brief  Get the opening energies of a record in an accessibility database
+ *
+ *  The rows of the returned array point directly into the database and are
+ *  suitable as input for vrna_plex_scan(). Only the array itself has to be
+ *  released with free() after use.
+ *
+ *  @param  db  The database
+ *  @param  i   The index of the record
+ *  @return     The opening energies, or @em NULL on any error
+ */
+const int **
+vrna_plex_access_db_get(const vrna_plex_access_db_t  *db,
+                        unsigned int                 i);
+
+
 #endif
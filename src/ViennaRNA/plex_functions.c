@@ -589,7 +589,7 @@ duplexfold_XS(vrna_fold_compound_t        *fc,
         tempK = max_interaction_length - i + k - 1;
         sk    = S1[k + 1];
         for (l = i + turn + 1; l <= n; l++) {
-          if (hc->mx[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+          if (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
             type2 = md->pair[S[k]][S[l]];
             sl    = S1[l - 1];
 
@@ -600,7 +600,7 @@ duplexfold_XS(vrna_fold_compound_t        *fc,
                 if (p - k + l - q - 2 > MAXLOOP)
                   break;
 
-                if (hc->mx[n * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+                if (vrna_hc_context(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
                   type3 = md->pair[S[q]][S[p]];
                   sq    = S1[q + 1];
 
@@ -614,7 +614,7 @@ duplexfold_XS(vrna_fold_compound_t        *fc,
                                 sq,
                                 P);
                   for (j = MAX2(i + turn + 1, l - max_interaction_length + 1); j <= q; j++) {
-                    if (hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+                    if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
                       type                    = md->pair[S[i]][S[j]];
                       c3[j - 1][tempK][l - j] =
                         MIN2(c3[j - 1][tempK][l - j],
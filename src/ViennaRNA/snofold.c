@@ -20,6 +20,7 @@
 #include <string.h>
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/pair_mat.h"
@@ -41,6 +42,29 @@
 #define STACK_BULGE1  1   /* stacking energies for bulges of size 1 */
 #define NEW_NINIO     1   /* new asymetry penalty */
 
+/*
+ *  DP arrays and energy model of the stem folding recursions. snofold() works
+ *  on a view of the global arrays below, whereas vrna_sno_stems() owns them
+ */
+struct vrna_sno_stems_s {
+  int           length;
+  char          *sequence;
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1];
+  int           *rtype;
+  int           noGUclosure;
+  int           noLP;
+  short         *S1;
+  int           *indx;
+  int           *c;
+  int           *mLoop;
+  char          *ptype;
+  int           *BP;
+  folden        **foldlist;
+  folden        **foldlist_XS;
+  int           energy;
+};
+
 /*@unused@*/
 PRIVATE void
 get_arrays(unsigned int size);
@@ -48,8 +72,9 @@ get_arrays(unsigned int size);
 
 /* PRIVATE int   stack_energy(int i, const char *string); */
 PRIVATE void
-make_ptypes(const short *S,
-            const char  *structure);
+make_ptypes(vrna_sno_stems_t  *stems,
+            const short       *S,
+            const char        *structure);
 
 
 PRIVATE void
@@ -57,18 +82,31 @@ encode_seq(const char *sequence);
 
 
 PRIVATE void
-backtrack(const char  *sequence,
-          int         s);
+backtrack(const vrna_sno_stems_t  *stems,
+          const char              *sequence,
+          sect                    *sector,
+          vrna_bp_stack_t         *bp_stack,
+          int                     s);
 
 
 PRIVATE int
-fill_arrays(const char  *sequence,
-            const int   max_asymm,
-            const int   threshloop,
-            const int   min_s2,
-            const int   max_s2,
-            const int   half_stem,
-            const int   max_half_stem);
+fill_arrays(vrna_sno_stems_t  *stems,
+            const char        *sequence,
+            const int         max_asymm,
+            const int         threshloop,
+            const int         min_s2,
+            const int         max_s2,
+            const int         half_stem,
+            const int         max_half_stem);
+
+
+PRIVATE void
+legacy_stems(vrna_sno_stems_t *stems);
+
+
+PRIVATE void
+free_fold_list(folden **list,
+               int    length);
 
 
 /*@unused@*/
@@ -263,26 +301,8 @@ snofree_arrays(const int length)
   free(cc1);
   free(ptype);
   free(mLoop);
-  int i;
-
-  for (i = length; i > -1; i--) {
-    while (foldlist[i] != NULL) {
-      folden *n = foldlist[i];
-      foldlist[i] = foldlist[i]->next;
-      free(n);
-    }
-    free(foldlist[i]);
-  }
-  free(foldlist);
-  for (i = length; i > -1; i--) {
-    while (foldlist_XS[i] != NULL) {
-      folden *n = foldlist_XS[i];
-      foldlist_XS[i] = foldlist_XS[i]->next;
-      free(n);
-    }
-    free(foldlist_XS[i]);
-  }
-  free(foldlist_XS);
+  free_fold_list(foldlist, length);
+  free_fold_list(foldlist_XS, length);
   free(base_pair);
   base_pair = NULL;
   free(Fmi);
@@ -366,7 +386,8 @@ snofold(const char  *string,
         const int   half_stem,
         const int   max_half_stem)
 {
-  int length, energy, bonus, bonus_cnt, s;
+  int               length, energy, bonus, bonus_cnt, s;
+  vrna_sno_stems_t  stems;
 
   /* Variable initialization */
   bonus     = 0;
@@ -387,9 +408,19 @@ snofold(const char  *string,
 
   /* encode_seq(string); */
   BP = (int *)vrna_alloc(sizeof(int) * (length + 2));
-  make_ptypes(S, structure);
-  energy = fill_arrays(string, max_assym, threshloop, min_s2, max_s2, half_stem, max_half_stem);
-  backtrack(string, s);
+  legacy_stems(&stems);
+  make_ptypes(&stems, S, structure);
+  energy = fill_arrays(&stems,
+                       string,
+                       max_assym,
+                       threshloop,
+                       min_s2,
+                       max_s2,
+                       half_stem,
+                       max_half_stem);
+  foldlist    = stems.foldlist;
+  foldlist_XS = stems.foldlist_XS;
+  backtrack(&stems, string, sector, base_pair, s);
 
   free(structure);
   free(S);
@@ -886,23 +917,39 @@ repeat1:
 
 
 PRIVATE int
-fill_arrays(const char  *string,
-            const int   max_asymm,
-            const int   threshloop,
-            const int   min_s2,
-            const int   max_s2,
-            const int   half_stem,
-            const int   max_half_stem)
+fill_arrays(vrna_sno_stems_t  *stems,
+            const char        *string,
+            const int         max_asymm,
+            const int         threshloop,
+            const int         min_s2,
+            const int         max_s2,
+            const int         half_stem,
+            const int         max_half_stem)
 {
   int i, j, length, energy;
   /*   int   decomp;*/ /*, new_fML; */
   int no_close, type, type_2;
   int bonus;
   int min_c;
+  int *cc, *cc1;
+
+  /* the DP arrays and energy model the recursions work on */
+  vrna_param_t  *P            = stems->P;
+  short         *S1           = stems->S1;
+  int           *indx         = stems->indx;
+  int           *c            = stems->c;
+  int           *mLoop        = stems->mLoop;
+  char          *ptype        = stems->ptype;
+  int           *BP           = stems->BP;
+  int           *rtype        = stems->rtype;
+  int           no_closingGU  = stems->noGUclosure;
+  folden        **foldlist, **foldlist_XS;
 
   min_c   = INF;
   length  = (int)strlen(string);
   bonus   = 0;
+  cc      = (int *)vrna_alloc(sizeof(int) * (length + 2));
+  cc1     = (int *)vrna_alloc(sizeof(int) * (length + 2));
   /*   max_separation = (int) ((1.-LOCALITY)*(double)(length-2)); */ /* not in use */
 
 
@@ -999,17 +1046,16 @@ fill_arrays(const char  *string,
 
     {
       int *FF; /* rotate the auxilliary arrays */
-      FF    = DMLi2;
-      DMLi2 = DMLi1;
-      DMLi1 = DMLi;
-      DMLi  = FF;
-      FF    = cc1;
-      cc1   = cc;
-      cc    = FF;
+      FF  = cc1;
+      cc1 = cc;
+      cc  = FF;
       for (j = 1; j <= length; j++)
-        cc[j] = Fmi[j] = DMLi[j] = INF;
+        cc[j] = INF;
     }
   }
+  free(cc);
+  free(cc1);
+
   foldlist    = (folden **)vrna_alloc((length + 1) * sizeof(folden *));
   foldlist_XS = (folden **)vrna_alloc((length + 1) * sizeof(folden *));
   /* linked list initialization*/
@@ -1071,6 +1117,8 @@ fill_arrays(const char  *string,
       }
     }
   }
+  stems->foldlist     = foldlist;
+  stems->foldlist_XS  = foldlist_XS;
   /*
    *   int count=0;
    *    for(i=0; i< length; i++){
@@ -1105,8 +1153,11 @@ fill_arrays(const char  *string,
 
 
 PRIVATE void
-backtrack(const char  *string,
-          int         s)
+backtrack(const vrna_sno_stems_t  *stems,
+          const char              *string,
+          sect                    *sector,
+          vrna_bp_stack_t         *bp_stack,
+          int                     s)
 {
   /*------------------------------------------------------------------
    *  trace back through the "c", "f5" and "fML" arrays to get the
@@ -1121,6 +1172,16 @@ backtrack(const char  *string,
   int bonus;
   int b = 0;
 
+  /* the DP arrays and energy model the recursions worked on */
+  vrna_param_t  *P            = stems->P;
+  short         *S1           = stems->S1;
+  int           *indx         = stems->indx;
+  int           *c            = stems->c;
+  char          *ptype        = stems->ptype;
+  int           *BP           = stems->BP;
+  int           *rtype        = stems->rtype;
+  int           no_closingGU  = stems->noGUclosure;
+
   length = strlen(string);
   if (s == 0) {
     sector[++s].i = 1;
@@ -1136,8 +1197,8 @@ backtrack(const char  *string,
     ml  = sector[s--].ml;  /* ml is a flag indicating if backtracking is to
                            * occur in the fML- (1) or in the f-array (0) */
     if (ml == 2) {
-      base_pair[++b].i  = i;
-      base_pair[b].j    = j;
+      bp_stack[++b].i  = i;
+      bp_stack[b].j    = j;
       goto repeat1;
     }
 
@@ -1160,15 +1221,15 @@ repeat1:
         bonus -= BONUS;
     }
 
-    if (noLonelyPairs) {
+    if (stems->noLP) {
       if (cij == c[indx[j] + i]) {
         /* (i.j) closes canonical structures, thus
          *  (i+1.j-1) must be a pair                */
         type_2            = ptype[indx[j - 1] + i + 1];
         type_2            = rtype[type_2];
         cij               -= P->stack[type][type_2] + bonus;
-        base_pair[++b].i  = i + 1;
-        base_pair[b].j    = j - 1;
+        bp_stack[++b].i  = i + 1;
+        bp_stack[b].j    = j - 1;
         i++;
         j--;
         canonical = 0;
@@ -1210,8 +1271,8 @@ repeat1:
         new     = energy + c[indx[q] + p] + bonus;
         traced  = (cij == new);
         if (traced) {
-          base_pair[++b].i  = p;
-          base_pair[b].j    = q;
+          bp_stack[++b].i  = p;
+          bp_stack[b].j    = q;
           i                 = p, j = q;
           goto repeat1;
         }
@@ -1244,7 +1305,7 @@ repeat1:
      */
   }
 
-  base_pair[0].i = b;    /* save the total number of base pairs */
+  bp_stack[0].i = b;    /* save the total number of base pairs */
 }
 
 
@@ -1255,12 +1316,15 @@ snobacktrack_fold_from_pair(const char  *sequence,
 {
   char *structure;
 
+  vrna_sno_stems_t stems;
+
   sector[1].i     = i;
   sector[1].j     = j;
   sector[1].ml    = 2;
   base_pair[0].i  = 0;
   encode_seq(sequence);
-  backtrack(sequence, 1);
+  legacy_stems(&stems);
+  backtrack(&stems, sequence, sector, base_pair, 1);
   structure = vrna_db_from_bp_stack(base_pair, strlen(sequence));
   free(S);
   free(S1);
@@ -1383,10 +1447,12 @@ snoupdate_fold_params(void)
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
-make_ptypes(const short *S,
-            const char  *structure)
+make_ptypes(vrna_sno_stems_t  *stems,
+            const short       *S,
+            const char        *structure)
 {
   int n, i, j, k, l;
+  int (*pair)[MAXALPHA + 1] = stems->pair;
 
   n = S[0];
   for (k = 1; k < n - TURN; k++)
@@ -1402,17 +1468,194 @@ make_ptypes(const short *S,
         if ((i > 1) && (j < n))
           ntype = pair[S[i - 1]][S[j + 1]];
 
-        if (noLonelyPairs && (!otype) && (!ntype))
+        if (stems->noLP && (!otype) && (!ntype))
           type = 0; /* i.j can only form isolated pairs */
 
-        ptype[indx[j] + i]  = (char)type;
-        otype               = type;
-        type                = ntype;
+        stems->ptype[stems->indx[j] + i]  = (char)type;
+        otype                             = type;
+        type                              = ntype;
         i--;
         j++;
       }
     }
 
   if (fold_constrained && (structure != NULL))
-    constrain_ptypes(structure, (unsigned int)n, ptype, BP, TURN, 0);
+    constrain_ptypes(structure, (unsigned int)n, stems->ptype, stems->BP, TURN, 0);
+}
+
+
+PRIVATE void
+legacy_stems(vrna_sno_stems_t *stems)
+{
+  stems->length       = init_length;
+  stems->sequence     = NULL;
+  stems->P            = P;
+  stems->pair         = pair;
+  stems->rtype        = rtype;
+  stems->noGUclosure  = no_closingGU;
+  stems->noLP         = noLonelyPairs;
+  stems->S1           = S1;
+  stems->indx         = indx;
+  stems->c            = c;
+  stems->mLoop        = mLoop;
+  stems->ptype        = ptype;
+  stems->BP           = BP;
+  stems->foldlist     = foldlist;
+  stems->foldlist_XS  = foldlist_XS;
+  stems->energy       = 0;
+}
+
+
+PRIVATE void
+free_fold_list(folden **list,
+               int    length)
+{
+  int i;
+
+  for (i = length; i > -1; i--) {
+    while (list[i] != NULL) {
+      folden *n = list[i];
+      list[i] = list[i]->next;
+      free(n);
+    }
+    free(list[i]);
+  }
+  free(list);
+}
+
+
+/*
+ #################################
+ # Reentrant stem folding        #
+ #################################
+ */
+PUBLIC vrna_sno_stems_t *
+vrna_sno_stems(const char       *sequence,
+               const vrna_md_t  *md,
+               int              max_assym,
+               int              threshloop,
+               int              min_s2,
+               int              max_s2,
+               int              half_stem,
+               int              max_half_stem)
+{
+  unsigned int      n, size, i;
+  short             *S;
+  vrna_md_t         md_local;
+  vrna_sno_stems_t  *stems;
+
+  if ((!sequence) || (!(n = (unsigned int)strlen(sequence))))
+    return NULL;
+
+  if (md) {
+    md_local = *md;
+    vrna_md_update(&md_local);
+  } else {
+    set_model_details(&md_local);
+    /* pair rules follow the globals, as for make_pair_matrix() in snofold() */
+    md_local.noGU         = noGU;
+    md_local.noGUclosure  = no_closingGU;
+    vrna_md_update(&md_local);
+  }
+
+  size  = (n * (n + 1)) / 2 + 2;
+  stems = (vrna_sno_stems_t *)vrna_alloc(sizeof(vrna_sno_stems_t));
+
+  stems->length       = (int)n;
+  stems->sequence     = strdup(sequence);
+  stems->P            = vrna_params(&md_local);
+  stems->pair         = stems->P->model_details.pair;
+  stems->rtype        = &(stems->P->model_details.rtype[0]);
+  stems->noGUclosure  = md_local.noGUclosure;
+  stems->noLP         = md_local.noLP;
+  stems->S1           = vrna_seq_encode(sequence, &md_local);
+  stems->indx         = (int *)vrna_alloc(sizeof(int) * (n + 1));
+  stems->c            = (int *)vrna_alloc(sizeof(int) * size);
+  stems->mLoop        = (int *)vrna_alloc(sizeof(int) * size);
+  stems->ptype        = (char *)vrna_alloc(sizeof(char) * size);
+  stems->BP           = (int *)vrna_alloc(sizeof(int) * (n + 2));
+
+  for (i = 1; i <= n; i++)
+    stems->indx[i] = (i * (i - 1)) >> 1;
+
+  S = vrna_seq_encode_simple(sequence, &md_local);
+  make_ptypes(stems, S, NULL);
+  free(S);
+
+  stems->energy = fill_arrays(stems,
+                              sequence,
+                              max_assym,
+                              threshloop,
+                              min_s2,
+                              max_s2,
+                              half_stem,
+                              max_half_stem);
+
+  return stems;
+}
+
+
+PUBLIC void
+vrna_sno_stems_free(vrna_sno_stems_t *stems)
+{
+  if (stems) {
+    free_fold_list(stems->foldlist, stems->length);
+    free_fold_list(stems->foldlist_XS, stems->length);
+    free(stems->sequence);
+    free(stems->P);
+    free(stems->S1);
+    free(stems->indx);
+    free(stems->c);
+    free(stems->mLoop);
+    free(stems->ptype);
+    free(stems->BP);
+    free(stems);
+  }
+}
+
+
+PUBLIC int
+vrna_sno_stems_energy(const vrna_sno_stems_t *stems)
+{
+  return (stems) ? stems->energy : INF;
+}
+
+
+PUBLIC void
+vrna_sno_stems_export(const vrna_sno_stems_t  *stems,
+                      const int               **indx_p,
+                      const int               **cLoop_p,
+                      folden                  ***fold_p)
+{
+  *indx_p   = stems->indx;
+  *cLoop_p  = stems->c;
+  *fold_p   = stems->foldlist;
+}
+
+
+PUBLIC char *
+vrna_sno_stems_structure(const vrna_sno_stems_t *stems,
+                         int                    i,
+                         int                    j)
+{
+  char            *structure;
+  sect            bt_stack[MAXSECTORS];
+  vrna_bp_stack_t *bp;
+
+  if ((!stems) || (i < 1) || (j > stems->length) || (i >= j))
+    return NULL;
+
+  bp = (vrna_bp_stack_t *)vrna_alloc(sizeof(vrna_bp_stack_t) * (1 + stems->length / 2));
+
+  bt_stack[1].i   = i;
+  bt_stack[1].j   = j;
+  bt_stack[1].ml  = 2;
+  bp[0].i         = 0;
+
+  backtrack(stems, stems->sequence, bt_stack, bp, 1);
+
+  structure = vrna_db_from_bp_stack(bp, (unsigned int)stems->length);
+  free(bp);
+
+  return structure;
 }
@@ -3,6 +3,14 @@
 #define VIENNA_RNA_PACKAGE_SNOFOLD_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
+
+/**
+ *  @brief  The stem folding arrays of a snoRNA as required by RNAsnoop
+ *
+ *  @see vrna_sno_stems(), vrna_sno_stems_free()
+ */
+typedef struct vrna_sno_stems_s vrna_sno_stems_t;
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -79,4 +87,92 @@ extern double nc_fact /* =1 */;
 
 #endif
 
+/**
+ *  @brief  Compute the stem folding arrays of a snoRNA
+ *
+ *  This is the reentrant counterpart of snofold(). Instead of global arrays,
+ *  the DP arrays, the list of admissible stems, and the energy parameters are
+ *  stored in the returned object, such that they can be computed once and used
+ *  for any number of interactions with target RNAs, concurrently from as many
+ *  threads as desired. Model details default to the global settings when
+ *  @p md is @em NULL.
+ *
+ *  @see  vrna_sno_stems_free(), vrna_sno_stems_structure(), vrna_snoop_engine(), snofold()
+ *
+ *  @param  sequence      The snoRNA sequence
+ *  @param  md            The model details (may be @em NULL)
+ *  @param  max_assym     Maximal asymmetry of interior loops within a stem
+ *  @param  threshloop    Energy threshold for admissible stems in dcal/mol
+ *  @param  min_s2        Minimal distance of a stem from the 3' end of the snoRNA
+ *  @param  max_s2        Maximal distance of a stem from the 3' end of the snoRNA
+ *  @param  half_stem     Minimal length of the 5' half of a stem
+ *  @param  max_half_stem Maximal length of the 5' half of a stem
+ *  @return               The stem folding arrays, or @em NULL on any error
+ */
+vrna_sno_stems_t *
+vrna_sno_stems(const char       *sequence,
+               const vrna_md_t  *md,
+               int              max_assym,
+               int              threshloop,
+               int              min_s2,
+               int              max_s2,
+               int              half_stem,
+               int              max_half_stem);
+
+
+/**
+ *  @brief  Free memory occupied by the stem folding arrays of a snoRNA
+ *
+ *  @param  stems   The stem folding arrays
+ */
+void
+vrna_sno_stems_free(vrna_sno_stems_t *stems);
+
+
+/**
+ *  @brief  Get the minimal stem energy of a snoRNA in dcal/mol
+ *
+ *  This corresponds to the return value of snofold().
+ *
+ *  @param  stems   The stem folding arrays
+ *  @return         The minimal stem energy
+ */
+int
+vrna_sno_stems_energy(const vrna_sno_stems_t *stems);
+
+
+/**
+ *  @brief  Make the stem folding arrays available to interaction routines
+ *
+ *  This is the counterpart of snoexport_fold_arrays(). The arrays remain owned
+ *  by @p stems.
+ *
+ *  @param  stems     The stem folding arrays
+ *  @param  indx_p    A pointer to store the index array of the triangular matrices
+ *  @param  cLoop_p   A pointer to store the energy array of the stems
+ *  @param  fold_p    A pointer to store the lists of admissible stems for each 5' position
+ */
+void
+vrna_sno_stems_export(const vrna_sno_stems_t  *stems,
+                      const int               **indx_p,
+                      const int               **cLoop_p,
+                      folden                  ***fold_p);
+
+
+/**
+ *  @brief  Backtrack the structure of the stem closed by @f$ (i,j) @f$
+ *
+ *  This is the reentrant counterpart of snobacktrack_fold_from_pair().
+ *
+ *  @param  stems   The stem folding arrays
+ *  @param  i       The 5' position of the closing pair
+ *  @param  j       The 3' position of the closing pair
+ *  @return         The structure of the stem in dot-bracket notation, or @em NULL on any error
+ */
+char *
+vrna_sno_stems_structure(const vrna_sno_stems_t *stems,
+                         int                    i,
+                         int                    j);
+
+
 #endif
@@ -30,10 +30,184 @@
 /* #include "ViennaRNA/fold.h" */
 #include "ViennaRNA/duplex.h"
 #include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/alphabet.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 #define STACK_BULGE1  1   /* stacking energies for bulges of size 1 */
 #define NEW_NINIO     1   /* new asymetry penalty */
+#define SEED_MAX      12  /* maximal k-mer length of the seed prefilter */
+
+/**
+*** Energy parameters and pairing rules used by the reentrant parts of the
+*** snoRNA-RNA interaction computations. The legacy interface refers to the
+*** global pair matrix, whereas a vrna_snoop_engine_t brings its own (see below)
+**/
+typedef struct {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1];
+  int           *rtype;
+  short         *alias;
+} snoop_model_t;
+
+/**
+*** The stem folding arrays of the snoRNA, either those of the last call to
+*** snofold() (stems == NULL), or those of a vrna_sno_stems_t
+**/
+typedef struct {
+  const int               *indx;
+  const int               *cLoop;
+  folden                  **foldlist;
+  const vrna_sno_stems_t  *stems;
+} snoop_stems_t;
+
+/**
+*** Sequence encodings and DP matrices of a single interaction
+**/
+typedef struct {
+  short *S1;
+  short *SS1;
+  short *S2;
+  short *SS2;
+  int   n1;
+  int   n2;
+  int   **c;
+  int   **r;
+} snoop_mx_t;
+
+/**
+*** An interaction that passed all energy thresholds in find_max_snoop()
+**/
+typedef struct {
+  snoopT      test;       /* the interaction within the window */
+  int         begin;      /* 5' end of the window in the (padded) target */
+  int         l1;         /* length of the target part of the structure */
+  const char  *structure; /* the target&snoRNA structure */
+  const char  *target;    /* the target subsequence */
+} snoop_site_t;
+
+typedef void (snoop_site_f)(const snoop_site_t  *site,
+                            void                *data);
+
+struct vrna_snoop_engine_s {
+  snoop_model_t     model;
+  snoop_stems_t     stems;
+  vrna_sno_stems_t  *sno;
+  vrna_snoop_opt_t  opt;
+  char              *sequence;      /* the snoRNA, padded with 5 'N' on both sides */
+  int               fullStemEnergy;
+  unsigned char     *seeds;         /* bit set of all target k-mers that pair with the snoRNA */
+};
+
+typedef struct {
+  const char  *s2;
+  const char  *name;
+  int         count;
+} snoop_print_t;
+
+typedef struct {
+  snoopT  *list;
+  int     num;
+  int     size;
+} snoop_hits_t;
+
+PRIVATE void
+legacy_model(snoop_model_t *m);
+
+
+PRIVATE void
+legacy_stems(snoop_stems_t *st);
+
+
+PRIVATE void
+legacy_opt(vrna_snoop_opt_t *opt,
+           const int        delta,
+           const int        penalty,
+           const int        threshloop,
+           const int        threshLE,
+           const int        threshRE,
+           const int        threshDE,
+           const int        threshTE,
+           const int        threshSE,
+           const int        threshD,
+           const int        distance,
+           const int        half_stem,
+           const int        max_half_stem,
+           const int        min_s2,
+           const int        max_s2,
+           const int        min_s1,
+           const int        max_s1,
+           const int        min_d1,
+           const int        min_d2,
+           const int        alignment_length);
+
+
+PRIVATE void
+prepare_mx(const snoop_model_t  *m,
+           snoop_mx_t           *mx,
+           const char           *s1,
+           const char           *s2);
+
+
+PRIVATE void
+free_mx(snoop_mx_t *mx);
+
+
+PRIVATE snoopT
+snoop_mfe(const snoop_model_t     *m,
+          const snoop_stems_t     *st,
+          snoop_mx_t              *mx,
+          const char              *s2,
+          const vrna_snoop_opt_t  *opt,
+          const int               fullStemEnergy);
+
+
+PRIVATE int
+scan_snoop(const snoop_model_t    *m,
+           const snoop_stems_t    *st,
+           const snoop_mx_t       *mx,
+           const vrna_snoop_opt_t *opt,
+           const unsigned char    *active,
+           int                    *position);
+
+
+PRIVATE void
+print_site(const snoop_site_t *site,
+           void               *data);
+
+
+PRIVATE void
+collect_site(const snoop_site_t *site,
+             void               *data);
+
+
+PRIVATE char *
+stem_structure(const snoop_stems_t  *st,
+               const char           *snoseq,
+               int                  i,
+               int                  j);
+
+
+PRIVATE duplexT
+loop_duplexfold(const snoop_model_t *m,
+                const char          *s1,
+                const char          *s2);
+
+
+PRIVATE char *
+loop_backtrack(const snoop_model_t  *m,
+               const snoop_mx_t     *mx,
+               int                  i,
+               int                  j);
+
+
+PRIVATE unsigned char *
+seed_rows(const vrna_snoop_engine_t *engine,
+          const snoop_mx_t          *mx);
+
 
 
 PRIVATE void
@@ -46,31 +220,16 @@ encode_seq(const char *seq);
 
 
 PRIVATE void
-find_max_snoop(const char *s1,
-               const char *s2,
-               const int  max,
-               const int  alignment_length,
-               const int  *position,
-               const int  delta,
-               const int  distance,
-               const int  penalty,
-               const int  threshloop,
-               const int  threshLE,
-               const int  threshRE,
-               const int  threshDE,
-               const int  threshTE,
-               const int  threshSE,
-               const int  threshD,
-               const int  half_stem,
-               const int  max_half_stem,
-               const int  min_s2,
-               const int  max_s2,
-               const int  min_s1,
-               const int  max_s1,
-               const int  min_d1,
-               const int  min_d2,
-               const char *name,
-               const int  fullStemEnergy);
+find_max_snoop(const snoop_model_t    *m,
+               const snoop_stems_t    *st,
+               const char             *s1,
+               const char             *s2,
+               const int              max,
+               const int              *position,
+               const vrna_snoop_opt_t *opt,
+               const int              fullStemEnergy,
+               snoop_site_f           *cb,
+               void                   *data);
 
 
 PRIVATE void
@@ -134,28 +293,18 @@ alisnoop_backtrack(int          i,
 
 
 PRIVATE char *
-snoop_backtrack(int         i,
-                int         j,
-                const char  *s2,
-                int         *Duplex_El,
-                int         *Duplex_Er,
-                int         *Loop_E,
-                int         *Loop_D,
-                int         *u,
-                const int   penalty,
-                const int   threshloop,
-                const int   threshLE,
-                const int   threshRE,
-                const int   threshDE,
-                const int   threshD,
-                const int   half_stem,
-                const int   max_half_stem,
-                const int   min_s2,
-                const int   max_s2,
-                const int   min_s1,
-                const int   max_s1,
-                const int   min_d1,
-                const int   min_d2);
+snoop_backtrack(const snoop_model_t     *m,
+                const snoop_stems_t     *st,
+                const snoop_mx_t        *mx,
+                int                     i,
+                int                     j,
+                const char              *snoseq,
+                int                     *Duplex_El,
+                int                     *Duplex_Er,
+                int                     *Loop_E,
+                int                     *Loop_D,
+                int                     *u,
+                const vrna_snoop_opt_t  *opt);
 
 
 PRIVATE char *
@@ -1278,31 +1427,21 @@ Lsnoop_subopt(const char  *s1,
   free(SS1);
   free(SS2);
   if (max < threshTE) {
-    find_max_snoop(s1,
-                   s2,
-                   max,
-                   alignment_length,
-                   position,
-                   delta,
-                   distance,
-                   penalty,
-                   threshloop,
-                   threshLE,
-                   threshRE,
-                   threshDE,
-                   threshTE,
-                   threshSE,
-                   threshD,
-                   half_stem,
-                   max_half_stem,
-                   min_s2,
-                   max_s2,
-                   min_s1,
-                   max_s1,
-                   min_d1,
-                   min_d2,
-                   name,
-                   fullStemEnergy);
+    snoop_model_t     m;
+    snoop_stems_t     st;
+    snoop_print_t     out;
+    vrna_snoop_opt_t  opt;
+
+    legacy_model(&m);
+    legacy_stems(&st);
+    legacy_opt(&opt, delta, penalty, threshloop, threshLE, threshRE, threshDE, threshTE,
+               threshSE, threshD, distance, half_stem, max_half_stem, min_s2, max_s2,
+               min_s1, max_s1, min_d1, min_d2, alignment_length);
+    out.s2    = s2;
+    out.name  = name;
+    out.count = 0;
+    find_max_snoop(&m, &st, s1, s2, max, position, &opt, fullStemEnergy, &print_site,
+                   (void *)&out);
   }
 
   for (i = 1; i < 5; i++) {
@@ -1343,43 +1482,13 @@ Lsnoop_subopt_list(const char *s1,
                    const char *name,
                    const int  fullStemEnergy)
 {
-  int min_colonne = INF;
-  int max_pos;
-  int max;
-
-  max = INF;
-
-  /*
-   * int temp;
-   * int nsubopt=10;
-   */
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
-  int *position;
-
-  position = (int *)vrna_alloc((n1 + 3) * sizeof(int));
-
-
-  /* int Eminj, Emin_l; */
-  int       i, j;/*  l1, Emin=INF, i_min=0, j_min=0; */
-  /*
-   * char *struc;
-   * snoopT mfe;
-   */
-  int       *indx;
-  int       *mLoop;
-  int       *cLoop;
-  folden    **foldlist, **foldlist_XS;
-  int       Duplex_El, Duplex_Er;
-  int       Loop_D;
-  /* int u; */
-  int       Loop_E;
-  vrna_md_t md;
-
-  Duplex_El = 0;
-  Duplex_Er = 0;
-  Loop_E    = 0, Loop_D = 0;
-  snoexport_fold_arrays(&indx, &mLoop, &cLoop, &foldlist, &foldlist_XS);
+  int               max, *position;
+  snoop_model_t     m;
+  snoop_stems_t     st;
+  snoop_mx_t        mx;
+  snoop_print_t     out;
+  vrna_snoop_opt_t  opt;
+  vrna_md_t         md;
 
   set_model_details(&md);
   if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
@@ -1391,6 +1500,64 @@ Lsnoop_subopt_list(const char *s1,
     make_pair_matrix();
   }
 
+  legacy_model(&m);
+  legacy_stems(&st);
+  legacy_opt(&opt, delta, penalty, threshloop, threshLE, threshRE, threshDE, threshTE,
+             threshSE, threshD, distance, half_stem, max_half_stem, min_s2, max_s2,
+             min_s1, max_s1, min_d1, min_d2, alignment_length);
+
+  prepare_mx(&m, &mx, s1, s2);
+  n1        = mx.n1;
+  n2        = mx.n2;
+  position  = (int *)vrna_alloc((n1 + 3) * sizeof(int));
+
+  max = scan_snoop(&m, &st, &mx, &opt, NULL, position);
+
+  free_mx(&mx);
+
+  if (max < threshTE) {
+    out.s2    = s2;
+    out.name  = name;
+    out.count = 0;
+    find_max_snoop(&m, &st, s1, s2, max, position, &opt, fullStemEnergy, &print_site,
+                   (void *)&out);
+  }
+
+  free(position);
+}
+
+
+/*
+ *  Fill the RNAplex-like linear DP for the (padded) target of mx and store
+ *  the best interaction energy ending at each target position in position[].
+ *  Rows i with active[i] == 0 are skipped, i.e. they can't end or continue
+ *  an interaction. Returns the overall best energy
+ */
+PRIVATE int
+scan_snoop(const snoop_model_t    *m,
+           const snoop_stems_t    *st,
+           const snoop_mx_t       *mx,
+           const vrna_snoop_opt_t *opt,
+           const unsigned char    *active,
+           int                    *position)
+{
+  int           i, j, n1, n2, max, min_colonne;
+  int           **lc, **lr, **lpair;
+  const short   *S1, *SS1, *S2, *SS2;
+  vrna_param_t  *P                      = m->P;
+  int           *rtype                  = m->rtype;
+  int           (*pair)[MAXALPHA + 1]   = m->pair;
+  folden        **foldlist              = st->foldlist;
+
+  n1          = mx->n1;
+  n2          = mx->n2;
+  S1          = mx->S1;
+  SS1         = mx->SS1;
+  S2          = mx->S2;
+  SS2         = mx->SS2;
+  max         = INF;
+  min_colonne = INF;
+
   lpair = (int **)vrna_alloc(sizeof(int *) * (6));
   lc    = (int **)vrna_alloc(sizeof(int *) * (6));
   lr    = (int **)vrna_alloc(sizeof(int *) * (6));
@@ -1404,9 +1571,8 @@ Lsnoop_subopt_list(const char *s1,
       lpair[i][j] = 0;
     }
   }
-  encode_seqs(s1, s2);
-  int lim_maxj  = n2 - min_d2;
-  int lim_minj  = min_d1;
+  int lim_maxj  = n2 - opt->min_d2;
+  int lim_minj  = opt->min_d1;
   int lim_maxi  = n1;
 
   for (i = 5; i <= lim_maxi; i++) {
@@ -1416,69 +1582,60 @@ Lsnoop_subopt_list(const char *s1,
     int idx_3 = (i - 3) % 5;
     int idx_4 = (i - 4) % 5;
 
+    if ((active) && (!active[i])) {
+      for (j = lim_maxj; j > lim_minj; j--) {
+        lpair[idx][j] = 0;
+        lc[idx][j]    = INF;
+        lr[idx][j]    = INF;
+      }
+      position[i] = INF;
+      continue;
+    }
+
     for (j = lim_maxj; j > lim_minj; j--) {
       int type, type2;/*  E, k,l; */
       type          = pair[S1[i]][S2[j]];
       lpair[idx][j] = type;
-      lc[idx][j]    = (type) ? P->DuplexInit + 2 * penalty : INF;
+      lc[idx][j]    = (type) ? P->DuplexInit + 2 * opt->penalty : INF;
       lr[idx][j]    = INF;
       if (!type)
         continue;
 
       if ( /*pair[S1[i+1]][S2[j-1]] && Be sure it binds*/
-        j < max_s1 && j > min_s1 &&
-        j > n2 - max_s2 - max_half_stem &&
-        j < n2 - min_s2 - half_stem && S1[i - 2] == 4) {
+        j < opt->max_s1 && j > opt->min_s1 &&
+        j > n2 - opt->max_s2 - opt->max_half_stem &&
+        j < n2 - opt->min_s2 - opt->half_stem && S1[i - 2] == 4) {
         /*constraint on s2 and i*/
-        int     min_k, max_k;
-        max_k = MIN2(n2 - min_s2, j + max_half_stem + 1);
-        min_k = MAX2(j + half_stem + 1, n2 - max_s2);
-        folden  *temp;
+        folden *temp;
         temp = foldlist[j + 1];
         while (temp->next) {
           int k = temp->k;
-          /* if(k >= min_k-1 && k < max_k){ comment to recover normal behaviour */
           if (lpair[idx_3][k + 1] /*&& lpair[idx_4][k+2]*/)
             lr[idx][j] = MIN2(lr[idx][j], lc[idx_3][k + 1] + temp->energy);   /*--NU--*/
 
           /*else*/ if (lpair[idx_4][k + 1])                                   /*--NUN--*/
             lr[idx][j] = MIN2(lr[idx][j], lc[idx_4][k + 1] + temp->energy);
 
-          /*  } */
           temp = temp->next;
         }
       }
 
       /* dangle 5'SIDE relative to the mRNA  */
       lc[idx][j] += vrna_E_ext_stem(type, SS1[i - 1], SS2[j + 1], P);
-      /**
-      ***      lc[idx][j] += P->dangle5[type][SS1[i-1]];
-      ***      lc[idx][j] += P->dangle3[type][SS2[j+1]];
-      ***      if (type>2) lc[idx][j] += P->TerminalAU;
-      **/
-      /*
-       *       if(j<n2 && i>1){
-       * type2=pair[S1[i-1]][S2[j+1]];
-       */
-      type2 = lpair[idx_1][j + 1];
+      type2       = lpair[idx_1][j + 1];
       if (type2 > 0) {
         lc[idx][j] =
           MIN2(lc[idx_1][j + 1] +
                E_IntLoop(0, 0, type2, rtype[type], SS1[i], SS2[j], SS1[i - 1], SS2[j + 1],
-                         P) + 2 * penalty,
+                         P) + 2 * opt->penalty,
                lc[idx][j]);
         lr[idx][j] =
           MIN2(lr[idx_1][j + 1] +
                E_IntLoop(0, 0, type2, rtype[type], SS1[i], SS2[j], SS1[i - 1], SS2[j + 1],
-                         P) + 2 * penalty,
+                         P) + 2 * opt->penalty,
                lr[idx][j]);
       }
 
-      /*
-       * }
-       *       if(j<n2-1 && i>2){
-       * type2=pair[S1[i-2]][S2[j+2]];
-       */
       type2 = lpair[idx_2][j + 2];
       if (type2 > 0) {
         lc[idx][j] =
@@ -1491,168 +1648,103 @@ Lsnoop_subopt_list(const char *s1,
                E_IntLoop(1, 1, type2, rtype[type], SS1[i - 1], SS2[j + 1], SS1[i - 1], SS2[j + 1],
                          P),
                lr[idx][j]);
-        /*         } */
       }
 
-      /*
-       *       if(j<n2-2 && i>3){
-       * type2 = pair[S1[i-3]][S2[j+3]];
-       */
       type2 = lpair[idx_3][j + 3];
       if (type2 > 0) {
         lc[idx][j] =
           MIN2(lc[idx_3][j + 3] +
                E_IntLoop(2, 2, type2, rtype[type], SS1[i - 2], SS2[j + 2], SS1[i - 1], SS2[j + 1],
-                         P) + 6 * penalty,
+                         P) + 6 * opt->penalty,
                lc[idx][j]);
         lr[idx][j] =
           MIN2(lr[idx_3][j + 3] +
                E_IntLoop(2, 2, type2, rtype[type], SS1[i - 2], SS2[j + 2], SS1[i - 1], SS2[j + 1],
-                         P) + 6 * penalty,
+                         P) + 6 * opt->penalty,
                lr[idx][j]);
-        /*         } */
       }
 
-      /* min_colonne=MIN2(lr[idx][j]+(type>2?P->TerminalAU:0)+P->dangle3[rtype[type]][SS1[i+1]]+P->dangle5[rtype[type]][SS2[j-1]], min_colonne); */
       int bla;
       bla = lr[idx][j] +
-            vrna_E_ext_stem(rtype[type], SS2[j - 1], SS1[i + 1], P) + 2 * penalty;
+            vrna_E_ext_stem(rtype[type], SS2[j - 1], SS1[i + 1], P) + 2 * opt->penalty;
       min_colonne = MIN2(bla, min_colonne);
     }
     position[i] = min_colonne;
-    if (max >= min_colonne) {
-      max     = min_colonne;
-      max_pos = i;
-    }
+    if (max >= min_colonne)
+      max = min_colonne;
 
     min_colonne = INF;
   }
 
-  free(S1);
-  free(S2);
-  free(SS1);
-  free(SS2);
-  if (max < threshTE) {
-    find_max_snoop(s1,
-                   s2,
-                   max,
-                   alignment_length,
-                   position,
-                   delta,
-                   distance,
-                   penalty,
-                   threshloop,
-                   threshLE,
-                   threshRE,
-                   threshDE,
-                   threshTE,
-                   threshSE,
-                   threshD,
-                   half_stem,
-                   max_half_stem,
-                   min_s2,
-                   max_s2,
-                   min_s1,
-                   max_s1,
-                   min_d1,
-                   min_d2,
-                   name,
-                   fullStemEnergy);
-  }
-
-  for (i = 1; i < 6; i++) {
+  for (i = 0; i < 6; i++) {
     free(lc[i]);
     free(lr[i]);
     free(lpair[i]);
   }
-  free(lc[0]);
-  free(lr[0]);
-  free(lpair[0]);
   free(lc);
   free(lr);
   free(lpair);
-  free(position);
+
+  return max;
 }
 
 
+/*
+ *  Refine all local minima of position[] below the threshold with a full
+ *  snoop_mfe() within a window of the target and hand each interaction that
+ *  passes the energy thresholds over to the callback cb
+ */
 PRIVATE void
-find_max_snoop(const char *s1,
-               const char *s2,
-               const int  max,
-               const int  alignment_length,
-               const int  *position,
-               const int  delta,
-               const int  distance,
-               const int  penalty,
-               const int  threshloop,
-               const int  threshLE,
-               const int  threshRE,
-               const int  threshDE,
-               const int  threshTE,
-               const int  threshSE,
-               const int  threshD,
-               const int  half_stem,
-               const int  max_half_stem,
-               const int  min_s2,
-               const int  max_s2,
-               const int  min_s1,
-               const int  max_s1,
-               const int  min_d1,
-               const int  min_d2,
-               const char *name,
-               const int  fullStemEnergy)
+find_max_snoop(const snoop_model_t    *m,
+               const snoop_stems_t    *st,
+               const char             *s1,
+               const char             *s2,
+               const int              max,
+               const int              *position,
+               const vrna_snoop_opt_t *opt,
+               const int              fullStemEnergy,
+               snoop_site_f           *cb,
+               void                   *data)
 {
-  int count     = 0;
-  int pos       = n1 + 1;
-  int threshold = MIN2(threshTE, max + delta);
+  int pos       = (int)strlen(s1) + 1;
+  int threshold = MIN2(opt->threshTE, max + opt->delta);
 
-  /*
-   * printf("threshTE %d max %d\n", threshTE, max);
-   * #pragma omp parallel for
-   *   for(pos=n1+1;pos>distance;pos--){
-   */
   while (pos-- > 5) {
     int temp_min = 0;
     if (position[pos] < (threshold)) {
       int search_range;
-      search_range = distance + 1;
+      search_range = opt->distance + 1;
       while (--search_range)
         if (position[pos - search_range] <= position[pos - temp_min])
           temp_min = search_range;
 
       pos -= temp_min;
-      int     begin = MAX2(6, pos - alignment_length + 1);
-      char    *s3   = (char *)vrna_alloc(sizeof(char) * (pos - begin + 3 + 12));
+      int         begin = MAX2(6, pos - opt->alignment_length + 1);
+      char        *s3   = (char *)vrna_alloc(sizeof(char) * (pos - begin + 3 + 12));
+      snoopT      test;
+      snoop_mx_t  mx;
       strcpy(s3, "NNNNN");
       strncat(s3, (s1 + begin - 1), pos - begin + 2);
       strcat(s3, "NNNNN\0");
-      /* printf("%s s3\n", s3);  */
-      snoopT  test;
-      test = snoopfold(s3,
-                       s2,
-                       penalty,
-                       threshloop,
-                       threshLE,
-                       threshRE,
-                       threshDE,
-                       threshD,
-                       half_stem,
-                       max_half_stem,
-                       min_s2,
-                       max_s2,
-                       min_s1,
-                       max_s1,
-                       min_d1,
-                       min_d2,
-                       fullStemEnergy);
+
+      prepare_mx(m, &mx, s3, s2);
+      test = snoop_mfe(m, st, &mx, s2, opt, fullStemEnergy);
+      free_mx(&mx);
+
       if (test.energy == INF) {
+        /* the legacy interface reports windows without any interaction */
+        if (!st->stems)
+          printf("no target found under the constraints chosen\n");
+
         free(s3);
         continue;
       }
 
-      if (test.Duplex_El > threshLE * 0.01 || test.Duplex_Er > threshRE * 0.01 ||
-          test.Loop_D > threshD * 0.01 || (test.Duplex_Er + test.Duplex_El) > threshDE * 0.01 ||
-          (test.Duplex_Er + test.Duplex_El + test.Loop_E + test.Loop_D + 410) > threshSE * 0.01) {
+      if (test.Duplex_El > opt->threshLE * 0.01 || test.Duplex_Er > opt->threshRE * 0.01 ||
+          test.Loop_D > opt->threshD * 0.01 ||
+          (test.Duplex_Er + test.Duplex_El) > opt->threshDE * 0.01 ||
+          (test.Duplex_Er + test.Duplex_El + test.Loop_E + test.Loop_D + 410) >
+          opt->threshSE * 0.01) {
         free(test.structure);
         free(s3);
         continue;
@@ -1684,54 +1776,15 @@ find_max_snoop(const char *s1,
       target = (char *)vrna_alloc(l1 + 1);
       strncpy(target, (s3 + test.i + 5 - l1), l1);
       target[l1] = '\0';
-      char  *s4;
-      s4 = (char *)vrna_alloc(sizeof(char) * (strlen(s2) - 9));
-      strncpy(s4, s2 + 5, (int)strlen(s2) - 10);
-      s4[(int)strlen(s2) - 10] = '\0';
-      printf(
-        "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + 4.1 ) (%5.2f) \n%s&%s\n",
-        target_struct,
-        begin + test.i - 5 - l1,
-        begin + test.i - 6,
-        begin + test.u - 6,
-        test.j + 1,
-        test.j + (int)(strrchr(test.structure, '>') - strchr(test.structure, '>')) + 1,
-        test.Loop_D + test.Duplex_El + test.Duplex_Er + test.Loop_E + 4.10,
-        test.Duplex_El,
-        test.Duplex_Er,
-        test.Loop_E,
-        test.Loop_D,
-        test.fullStemEnergy,
-        target,
-        s4);
-      if (name) {
-        char  *temp_seq;
-        char  *temp_struc;
-        char  *psoutput;
-        temp_seq    = (char *)vrna_alloc(sizeof(char) * (l1 + n2 - 9));
-        temp_struc  = (char *)vrna_alloc(sizeof(char) * (l1 + n2 - 9));
-        strcpy(temp_seq, target);
-        strcat(temp_seq, s4);
-        strncpy(temp_struc, target_struct, l1);
-        strcat(temp_struc, target_struct + l1 + 1);
-        temp_seq[n2 + l1 - 10]    = '\0';
-        temp_struc[n2 + l1 - 10]  = '\0';
-        cut_point                 = l1 + 1;
-        psoutput                  = vrna_strdup_printf("sno_%d_u_%d_%s.ps",
-                                                       count,
-                                                       begin + test.u - 6,
-                                                       name);
-
-        PS_rna_plot_snoop_a(temp_seq, temp_struc, psoutput, NULL, NULL);
-        cut_point = -1;
-        free(temp_seq);
-        free(temp_struc);
-        free(psoutput);
-        count++;
-        /* free(psoutput); */
-      }
 
-      free(s4);
+      snoop_site_t site;
+      site.test       = test;
+      site.begin      = begin;
+      site.l1         = l1;
+      site.structure  = target_struct;
+      site.target     = target;
+      cb(&site, data);
+
       free(test.structure);
       free(target_struct);
       free(target);
@@ -1741,6 +1794,90 @@ find_max_snoop(const char *s1,
 }
 
 
+PRIVATE void
+print_site(const snoop_site_t *site,
+           void               *data)
+{
+  snoop_print_t *out    = (snoop_print_t *)data;
+  const snoopT  *test   = &(site->test);
+  const char    *s2     = out->s2;
+  int           l1      = site->l1;
+  int           begin   = site->begin;
+  int           n2      = (int)strlen(s2);
+  char          *s4;
+
+  s4 = (char *)vrna_alloc(sizeof(char) * (strlen(s2) - 9));
+  strncpy(s4, s2 + 5, (int)strlen(s2) - 10);
+  s4[(int)strlen(s2) - 10] = '\0';
+  printf(
+    "%s %3d,%-3d;%3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f + %5.2f + 4.1 ) (%5.2f) \n%s&%s\n",
+    site->structure,
+    begin + test->i - 5 - l1,
+    begin + test->i - 6,
+    begin + test->u - 6,
+    test->j + 1,
+    test->j + (int)(strrchr(test->structure, '>') - strchr(test->structure, '>')) + 1,
+    test->Loop_D + test->Duplex_El + test->Duplex_Er + test->Loop_E + 4.10,
+    test->Duplex_El,
+    test->Duplex_Er,
+    test->Loop_E,
+    test->Loop_D,
+    test->fullStemEnergy,
+    site->target,
+    s4);
+  if (out->name) {
+    char  *temp_seq;
+    char  *temp_struc;
+    char  *psoutput;
+    temp_seq    = (char *)vrna_alloc(sizeof(char) * (l1 + n2 - 9));
+    temp_struc  = (char *)vrna_alloc(sizeof(char) * (l1 + n2 - 9));
+    strcpy(temp_seq, site->target);
+    strcat(temp_seq, s4);
+    strncpy(temp_struc, site->structure, l1);
+    strcat(temp_struc, site->structure + l1 + 1);
+    temp_seq[n2 + l1 - 10]    = '\0';
+    temp_struc[n2 + l1 - 10]  = '\0';
+    cut_point                 = l1 + 1;
+    psoutput                  = vrna_strdup_printf("sno_%d_u_%d_%s.ps",
+                                                   out->count,
+                                                   begin + test->u - 6,
+                                                   out->name);
+
+    PS_rna_plot_snoop_a(temp_seq, temp_struc, psoutput, NULL, NULL);
+    cut_point = -1;
+    free(temp_seq);
+    free(temp_struc);
+    free(psoutput);
+    out->count++;
+  }
+
+  free(s4);
+}
+
+
+PRIVATE void
+collect_site(const snoop_site_t *site,
+             void               *data)
+{
+  snoop_hits_t  *hits = (snoop_hits_t *)data;
+  const snoopT  *test = &(site->test);
+  snoopT        *hit;
+
+  if (hits->num + 1 >= hits->size) {
+    hits->size  *= 2;
+    hits->list  = (snoopT *)vrna_realloc(hits->list, sizeof(snoopT) * hits->size);
+  }
+
+  hit             = hits->list + hits->num++;
+  *hit            = *test;
+  hit->i          = site->begin + test->i - 6;
+  hit->u          = site->begin + test->u - 6;
+  hit->j          = test->j + 1;
+  hit->energy     = test->Loop_D + test->Duplex_El + test->Duplex_Er + test->Loop_E + 4.10;
+  hit->structure  = strdup(site->structure);
+}
+
+
 snoopT
 snoopfold(const char  *s1,
           const char  *s2,
@@ -1760,26 +1897,12 @@ snoopfold(const char  *s1,
           const int   min_d2,
           const int   fullStemEnergy)
 {
-  /* int Eminj, Emin_l; */
-  int       i, j, l1, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  snoopT    mfe;
-  int       *indx;
-  int       *mLoop;
-  int       *cLoop;
-  folden    **foldlist, **foldlist_XS;
-  int       Duplex_El, Duplex_Er;
-  int       Loop_D;
-  int       u;
-  int       Loop_E;
-  vrna_md_t md;
-
-  Duplex_El = 0;
-  Duplex_Er = 0;
-  Loop_E    = 0, Loop_D = 0;
-  snoexport_fold_arrays(&indx, &mLoop, &cLoop, &foldlist, &foldlist_XS);
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+  snoopT            mfe;
+  snoop_model_t     m;
+  snoop_stems_t     st;
+  snoop_mx_t        mx;
+  vrna_snoop_opt_t  opt;
+  vrna_md_t         md;
 
   set_model_details(&md);
   if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
@@ -1791,6 +1914,74 @@ snoopfold(const char  *s1,
     make_pair_matrix();
   }
 
+  legacy_model(&m);
+  legacy_stems(&st);
+  legacy_opt(&opt, 0, penalty, threshloop, threshLE, threshRE, threshDE, 0, 0, threshD, 0,
+             half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2, 0);
+
+  prepare_mx(&m, &mx, s1, s2);
+  mfe = snoop_mfe(&m, &st, &mx, s2, &opt, fullStemEnergy);
+
+  if (mfe.energy == INF)
+    printf("no target found under the constraints chosen\n");
+
+  if ((delay_free) && (mfe.energy != INF)) {
+    /* keep the matrices for snoop_subopt() */
+    S1  = mx.S1;
+    SS1 = mx.SS1;
+    S2  = mx.S2;
+    SS2 = mx.SS2;
+    n1  = mx.n1;
+    n2  = mx.n2;
+    c   = mx.c;
+    r   = mx.r;
+  } else {
+    n1  = mx.n1;
+    n2  = mx.n2;
+    free_mx(&mx);
+  }
+
+  return mfe;
+}
+
+
+/*
+ *  Compute the minimum free energy interaction between the (padded) target
+ *  and snoRNA of mx. The DP matrices remain in mx for backtracking
+ */
+PRIVATE snoopT
+snoop_mfe(const snoop_model_t     *m,
+          const snoop_stems_t     *st,
+          snoop_mx_t              *mx,
+          const char              *s2,
+          const vrna_snoop_opt_t  *opt,
+          const int               fullStemEnergy)
+{
+  int           i, j, n1, n2, Emin = INF, i_min = 0, j_min = 0;
+  int           Duplex_El, Duplex_Er, Loop_D, Loop_E, u;
+  int           **c, **r;
+  const short   *S1, *SS1, *S2, *SS2;
+  char          *struc;
+  snoopT        mfe;
+  vrna_param_t  *P                      = m->P;
+  int           *rtype                  = m->rtype;
+  int           (*pair)[MAXALPHA + 1]   = m->pair;
+  folden        **foldlist              = st->foldlist;
+
+  Duplex_El = 0;
+  Duplex_Er = 0;
+  Loop_E    = 0;
+  Loop_D    = 0;
+  u         = 0;
+  n1        = mx->n1;
+  n2        = mx->n2;
+  S1        = mx->S1;
+  SS1       = mx->SS1;
+  S2        = mx->S2;
+  SS2       = mx->SS2;
+
+  memset(&mfe, 0, sizeof(snoopT));
+
   c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   r = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   for (i = 0; i <= n1; i++) {
@@ -1801,9 +1992,11 @@ snoopfold(const char  *s1,
       r[i][j] = INF;
     }
   }
-  encode_seqs(s1, s2);
+  mx->c = c;
+  mx->r = r;
+
   for (i = 6; i <= n1 - 5; i++) {
-    for (j = n2 - min_d2; j > min_d1; j--) {
+    for (j = n2 - opt->min_d2; j > opt->min_d1; j--) {
       int type, type2, E, k, l;
       type    = pair[S1[i]][S2[j]];
       c[i][j] = (type) ? P->DuplexInit : INF;
@@ -1811,35 +2004,25 @@ snoopfold(const char  *s1,
         continue;
 
       if (/*  pair[S1[i+1]][S2[j-1]] &&  */
-        j < max_s1 && j > min_s1 &&
-        j > n2 - max_s2 - max_half_stem &&
-        j < n2 - min_s2 - half_stem && S1[i - 2] == 4) {
+        j < opt->max_s1 && j > opt->min_s1 &&
+        j > n2 - opt->max_s2 - opt->max_half_stem &&
+        j < n2 - opt->min_s2 - opt->half_stem && S1[i - 2] == 4) {
         /*constraint on s2 and i*/
-        int     min_k, max_k;
-        max_k = MIN2(n2 - min_s2, j + max_half_stem);
-        min_k = MAX2(j + half_stem, n2 - max_s2);
-        folden  *temp;
+        folden *temp;
         temp = foldlist[j + 1];
         while (temp->next) {
           int k = temp->k;
-          /* if(k >= min_k-1 && k < max_k){ uncomment to recovernormal behaviour */
           if (pair[S1[i - 3]][S2[k + 1]] /*&& pair[S1[i-4]][S2[k+2]]*/)
             r[i][j] = MIN2(r[i][j], c[i - 3][k + 1] + temp->energy);
 
           /*else*/ if (pair[S1[i - 4]][S2[k + 1]] /*&& pair[S1[i-5]][S2[k+2]]*/)
             r[i][j] = MIN2(r[i][j], c[i - 4][k + 1] + temp->energy);
 
-          /* } */
           temp = temp->next;
         }
       }
 
       /* dangle 5'SIDE relative to the mRNA  */
-      /**
-      *** c[i][j] += P->dangle5[type][SS1[i-1]];
-      *** c[i][j] += P->dangle3[type][SS2[j+1]];
-      *** if (type>2) c[i][j] += P->TerminalAU;
-      **/
       c[i][j] += vrna_E_ext_stem(type, SS1[i - 1], SS2[j + 1], P);
       for (k = i - 1; k > 0 && (i - k) < MAXLOOP_L; k--) {
         for (l = j + 1; l <= n2; l++) {
@@ -1855,16 +2038,11 @@ snoopfold(const char  *s1,
 
           E = E_IntLoop(i - k - 1, l - j - 1, type2, rtype[type],
                         SS1[k + 1], SS2[l - 1], SS1[i - 1], SS2[j + 1], P);
-          c[i][j] = MIN2(c[i][j], c[k][l] + E + (i - k + l - j) * penalty);
-          r[i][j] = MIN2(r[i][j], r[k][l] + E + (i - k + l - j) * penalty);
+          c[i][j] = MIN2(c[i][j], c[k][l] + E + (i - k + l - j) * opt->penalty);
+          r[i][j] = MIN2(r[i][j], r[k][l] + E + (i - k + l - j) * opt->penalty);
         }
       }
       E = r[i][j];
-      /**
-      *** if (i<n1) E += P->dangle3[rtype[type]][SS1[i+1]];
-      *** if (j>1)  E += P->dangle5[rtype[type]][SS2[j-1]];
-      *** f (type>2) E += P->TerminalAU;
-      **/
       E += vrna_E_ext_stem(rtype[type], (j > 1) ? SS2[j - 1] : -1, (i < n1) ? SS1[i + 1] : -1, P);
       if (E < Emin) {
         Emin  = E;
@@ -1874,29 +2052,13 @@ snoopfold(const char  *s1,
     }
   }
   if (Emin > 0) {
-    printf("no target found under the constraints chosen\n");
-    for (i = 0; i <= n1; i++) {
-      free(r[i]);
-      free(c[i]);
-    }
-    free(c);
-    free(r);
-    free(S1);
-    free(S2);
-    free(SS1);
-    free(SS2);
     mfe.energy = INF;
     return mfe;
   }
 
-  struc = snoop_backtrack(i_min, j_min, s2, &Duplex_El, &Duplex_Er, &Loop_E, &Loop_D,
-                          &u, penalty, threshloop, threshLE, threshRE, threshDE, threshD,
-                          half_stem, max_half_stem, min_s2, max_s2, min_s1, max_s1, min_d1, min_d2);
-  /*
-   *   if (i_min<n1-5) i_min++;
-   *   if (j_min>1 ) j_min--;
-   */
-  l1                  = strchr(struc, '&') - struc;
+  struc = snoop_backtrack(m, st, mx, i_min, j_min, s2, &Duplex_El, &Duplex_Er, &Loop_E, &Loop_D,
+                          &u, opt);
+
   mfe.i               = i_min - 5;
   mfe.j               = j_min - 5;
   mfe.u               = u - 5;
@@ -1907,18 +2069,6 @@ snoopfold(const char  *s1,
   mfe.energy          = (float)Emin / 100;
   mfe.fullStemEnergy  = (float)fullStemEnergy / 100;
   mfe.structure       = struc;
-  if (!delay_free) {
-    for (i = 0; i <= n1; i++) {
-      free(r[i]);
-      free(c[i]);
-    }
-    free(c);
-    free(r);
-    free(S1);
-    free(S2);
-    free(SS1);
-    free(SS2);
-  }
 
   return mfe;
 }
@@ -2113,6 +2263,10 @@ snoop_subopt(const char *s1,
   Loop_E    = 0;
   Loop_D    = 0;
   int u;
+  snoop_model_t     m;
+  snoop_stems_t     st;
+  snoop_mx_t        mx;
+  vrna_snoop_opt_t  opt;
 
   u           = 0;
   n_max       = 16;
@@ -2134,8 +2288,22 @@ snoop_subopt(const char *s1,
   /* subopt[n_subopt++]=mfe; */
   free(mfe.structure);
 
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+  legacy_model(&m);
+  legacy_stems(&st);
+  legacy_opt(&opt, delta, penalty, threshloop, threshLE, threshRE, threshDE, threshTE,
+             threshSE, threshD, distance, half_stem, max_half_stem, min_s2, max_s2,
+             min_s1, max_s1, min_d1, min_d2, 0);
+
+  n1      = (int)strlen(s1);
+  n2      = (int)strlen(s2);
+  mx.S1   = S1;
+  mx.SS1  = SS1;
+  mx.S2   = S2;
+  mx.SS2  = SS2;
+  mx.n1   = n1;
+  mx.n2   = n2;
+  mx.c    = c;
+  mx.r    = r;
   for (i = n1; i > 0; i--) {
     for (j = 1; j <= n2; j++) {
       int type, Ed;
@@ -2167,28 +2335,8 @@ snoop_subopt(const char *s1,
       if (!type)
         continue;
 
-      struc = snoop_backtrack(i,
-                              j,
-                              s2,
-                              &Duplex_El,
-                              &Duplex_Er,
-                              &Loop_E,
-                              &Loop_D,
-                              &u,
-                              penalty,
-                              threshloop,
-                              threshLE,
-                              threshRE,
-                              threshDE,
-                              threshD,
-                              half_stem,
-                              max_half_stem,
-                              min_s2,
-                              max_s2,
-                              min_s1,
-                              max_s1,
-                              min_d1,
-                              min_d2);
+      struc = snoop_backtrack(&m, &st, &mx, i, j, s2, &Duplex_El, &Duplex_Er, &Loop_E, &Loop_D,
+                              &u, &opt);
       if (Duplex_Er > threshRE || Duplex_El > threshLE || Loop_D > threshD ||
           (Duplex_Er + Duplex_El) > threshDE ||
           (Duplex_Er + Duplex_El + Loop_E) > threshTE ||
@@ -2302,6 +2450,10 @@ snoop_subopt_XS(const char  *s1,
   Loop_E    = 0;
   Loop_D    = 0;
   int u;
+  snoop_model_t     m;
+  snoop_stems_t     st;
+  snoop_mx_t        mx;
+  vrna_snoop_opt_t  opt;
 
   u           = 0;
   n_max       = 16;
@@ -2493,45 +2645,44 @@ snoop_subopt_XS(const char  *s1,
 
 
 PRIVATE char *
-snoop_backtrack(int         i,
-                int         j,
-                const char  *snoseq,
-                int         *Duplex_El,
-                int         *Duplex_Er,
-                int         *Loop_E,
-                int         *Loop_D,
-                int         *u,
-                const int   penalty,
-                const int   threshloop,
-                const int   threshLE,
-                const int   threshRE,
-                const int   threshDE,
-                const int   threshD,
-                const int   half_stem,
-                const int   max_half_stem,
-                const int   min_s2,
-                const int   max_s2,
-                const int   min_s1,
-                const int   max_s1,
-                const int   min_d1,
-                const int   min_d2)
+snoop_backtrack(const snoop_model_t     *m,
+                const snoop_stems_t     *st,
+                const snoop_mx_t        *mx,
+                int                     i,
+                int                     j,
+                const char              *snoseq,
+                int                     *Duplex_El,
+                int                     *Duplex_Er,
+                int                     *Loop_E,
+                int                     *Loop_D,
+                int                     *u,
+                const vrna_snoop_opt_t  *opt)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int     k, l, type, type2, E, traced, i0, j0;
-  int     traced_r = 0; /* flag for following backtrack in c or r */
-  char    *st1, *st2, *struc;
-  char    *struc_loop;
+  int           k, l, type, type2, E, traced, i0, j0;
+  int           traced_r = 0; /* flag for following backtrack in c or r */
+  char          *st1, *st2, *struc;
+  char          *struc_loop;
+  int           n1                    = mx->n1;
+  int           n2                    = mx->n2;
+  int           **c                   = mx->c;
+  int           **r                   = mx->r;
+  const short   *S1                   = mx->S1;
+  const short   *SS1                  = mx->SS1;
+  const short   *S2                   = mx->S2;
+  const short   *SS2                  = mx->SS2;
+  const int     *indx                 = st->indx;
+  const int     *cLoop                = st->cLoop;
+  folden        **foldlist            = st->foldlist;
+  vrna_param_t  *P                    = m->P;
+  int           *rtype                = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
-  int     *indx;
-  int     *mLoop;
-  int     *cLoop;
-  folden  **foldlist, **foldlist_XS;
 
   type = pair[S1[i]][S2[j]];
-  snoexport_fold_arrays(&indx, &mLoop, &cLoop, &foldlist, &foldlist_XS);
   i0  = i;
   j0  = j;
   /**
@@ -2543,7 +2694,7 @@ snoop_backtrack(int         i,
                                 (j > 1) ? SS2[j - 1] : -1,
                                 (i < n1) ? SS1[i + 1] : -1,
                                 P);
-  while (i > 0 && j <= n2 - min_d2) {
+  while (i > 0 && j <= n2 - opt->min_d2) {
     if (!traced_r) {
       E           = r[i][j];
       traced      = 0;
@@ -2568,7 +2719,7 @@ snoop_backtrack(int         i,
 
           LE = E_IntLoop(i - k - 1, l - j - 1, type2, rtype[type],
                          SS1[k + 1], SS2[l - 1], SS1[i - 1], SS2[j + 1], P);
-          if (E == r[k][l] + LE + (i - k + l - j) * penalty) {
+          if (E == r[k][l] + LE + (i - k + l - j) * opt->penalty) {
             traced      = 1;
             i           = k;
             j           = l;
@@ -2581,13 +2732,13 @@ snoop_backtrack(int         i,
       }
       if (!traced) {
         if (/*  pair[S1[i+1]][S2[j-1]] && */
-          j < max_s1 && j > min_s1 &&
-          j > n2 - max_s2 - max_half_stem &&
-          j < n2 - min_s2 - half_stem &&
+          j < opt->max_s1 && j > opt->min_s1 &&
+          j > n2 - opt->max_s2 - opt->max_half_stem &&
+          j < n2 - opt->min_s2 - opt->half_stem &&
           S1[i - 2] == 4) {
           int     min_k, max_k;
-          max_k = MIN2(n2 - min_s2, j + max_half_stem + 1);
-          min_k = MAX2(j + half_stem + 1, n2 - max_s2);
+          max_k = MIN2(n2 - opt->min_s2, j + opt->max_half_stem + 1);
+          min_k = MAX2(j + opt->half_stem + 1, n2 - opt->max_s2);
           folden  *temp;
           temp = foldlist[j + 1];
           while (temp->next) {
@@ -2604,7 +2755,7 @@ snoop_backtrack(int         i,
                   for (b = 0; b < MISMATCH; b++) {
                     int ij = indx[k - 1 - a + 1] + j + 1 + b;
                     if (cLoop[ij] == temp->energy) {
-                      struc_loop  = snobacktrack_fold_from_pair(snoseq, j + 1 + b, k - a - 1 + 1);
+                      struc_loop  = stem_structure(st, snoseq, j + 1 + b, k - a - 1 + 1);
                       a           = INF;
                       b           = INF;
                     }
@@ -2630,7 +2781,7 @@ snoop_backtrack(int         i,
                   for (b = 0; b < MISMATCH; b++) {
                     int ij = indx[k - 1 - a + 1] + j + 1 + b;
                     if (cLoop[ij] == temp->energy) {
-                      struc_loop  = snobacktrack_fold_from_pair(snoseq, j + 1 + b, k - a - 1 + 1);
+                      struc_loop  = stem_structure(st, snoseq, j + 1 + b, k - a - 1 + 1);
                       a           = INF;
                       b           = INF;
                     }
@@ -2673,7 +2824,7 @@ snoop_backtrack(int         i,
 
           LE = E_IntLoop(i - k - 1, l - j - 1, type2, rtype[type],
                          SS1[k + 1], SS2[l - 1], SS1[i - 1], SS2[j + 1], P);
-          if (E == c[k][l] + LE + (i - k + l - j) * penalty) {
+          if (E == c[k][l] + LE + (i - k + l - j) * opt->penalty) {
             traced      = 1;
             i           = k;
             j           = l;
@@ -2746,7 +2897,12 @@ snoop_backtrack(int         i,
     duplexseq_1[j0 - 1]     = '\0';
     duplexseq_2[n2 - j + 1] = '\0';
     duplexT temp;
-    temp    = duplexfold(duplexseq_1, duplexseq_2);
+    /* the legacy duplexfold() relies on global state */
+    if (st->stems)
+      temp = loop_duplexfold(m, duplexseq_1, duplexseq_2);
+    else
+      temp = duplexfold(duplexseq_1, duplexseq_2);
+
     *Loop_D = MIN2(0, -410 + (int)100 * temp.energy);
     if (*Loop_D) {
       int l1, ibegin, iend, jbegin, jend;
@@ -3843,3 +3999,562 @@ compare(const void  *sub1,
 
   return ((snoopT *)sub1)->j - ((snoopT *)sub2)->j;
 }
+
+
+/*
+ *  Reentrant counterpart of duplexfold() (see duplex.c) for the interaction
+ *  between the 5' and 3' parts of the snoRNA in snoop_backtrack()
+ */
+PRIVATE duplexT
+loop_duplexfold(const snoop_model_t *m,
+                const char          *s1,
+                const char          *s2)
+{
+  int           i, j, n1, n2, Emin = INF, i_min = 0, j_min = 0;
+  int           **c;
+  const short   *S1, *SS1, *S2, *SS2;
+  snoop_mx_t    mx;
+  duplexT       mfe;
+  vrna_param_t  *P                    = m->P;
+  int           *rtype                = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
+
+  prepare_mx(m, &mx, s1, s2);
+  n1  = mx.n1;
+  n2  = mx.n2;
+  S1  = mx.S1;
+  SS1 = mx.SS1;
+  S2  = mx.S2;
+  SS2 = mx.SS2;
+
+  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  for (i = 0; i <= n1; i++)
+    c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+
+  mx.c = c;
+
+  for (i = 1; i <= n1; i++) {
+    for (j = n2; j > 0; j--) {
+      int type, type2, E, k, l;
+      type    = pair[S1[i]][S2[j]];
+      c[i][j] = type ? P->DuplexInit : INF;
+      if (!type)
+        continue;
+
+      c[i][j] += vrna_E_ext_stem(type, (i > 1) ? SS1[i - 1] : -1, (j < n2) ? SS2[j + 1] : -1, P);
+      for (k = i - 1; k > 0 && k > i - MAXLOOP - 2; k--) {
+        for (l = j + 1; l <= n2; l++) {
+          if (i - k + l - j - 2 > MAXLOOP)
+            break;
+
+          type2 = pair[S1[k]][S2[l]];
+          if (!type2)
+            continue;
+
+          E = E_IntLoop(i - k - 1, l - j - 1, type2, rtype[type],
+                        SS1[k + 1], SS2[l - 1], SS1[i - 1], SS2[j + 1], P);
+          c[i][j] = MIN2(c[i][j], c[k][l] + E);
+        }
+      }
+      E = c[i][j];
+      E += vrna_E_ext_stem(rtype[type], (j > 1) ? SS2[j - 1] : -1, (i < n1) ? SS1[i + 1] : -1, P);
+      if (E < Emin) {
+        Emin  = E;
+        i_min = i;
+        j_min = j;
+      }
+    }
+  }
+
+  mfe.structure = loop_backtrack(m, &mx, i_min, j_min);
+  if (i_min < n1)
+    i_min++;
+
+  if (j_min > 1)
+    j_min--;
+
+  mfe.i       = i_min;
+  mfe.j       = j_min;
+  mfe.energy  = (float)Emin / 100.;
+
+  free_mx(&mx);
+
+  return mfe;
+}
+
+
+PRIVATE char *
+loop_backtrack(const snoop_model_t  *m,
+               const snoop_mx_t     *mx,
+               int                  i,
+               int                  j)
+{
+  /* backtrack structure going backwards from i, and forwards from j
+   * return structure in bracket notation with & as separator */
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+  int           n1                    = mx->n1;
+  int           n2                    = mx->n2;
+  int           **c                   = mx->c;
+  const short   *S1                   = mx->S1;
+  const short   *SS1                  = mx->SS1;
+  const short   *S2                   = mx->S2;
+  const short   *SS2                  = mx->SS2;
+  vrna_param_t  *P                    = m->P;
+  int           *rtype                = m->rtype;
+  int           (*pair)[MAXALPHA + 1] = m->pair;
+
+  st1 = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
+  st2 = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
+
+  i0  = MIN2(i + 1, n1);
+  j0  = MAX2(j - 1, 1);
+
+  while (i > 0 && j <= n2) {
+    E           = c[i][j];
+    traced      = 0;
+    st1[i - 1]  = '(';
+    st2[j - 1]  = ')';
+    type        = pair[S1[i]][S2[j]];
+    if (!type)
+      vrna_message_error("backtrack failed in fold duplex");
+
+    for (k = i - 1; k > 0 && k > i - MAXLOOP - 2; k--) {
+      for (l = j + 1; l <= n2; l++) {
+        int LE;
+        if (i - k + l - j - 2 > MAXLOOP)
+          break;
+
+        type2 = pair[S1[k]][S2[l]];
+        if (!type2)
+          continue;
+
+        LE = E_IntLoop(i - k - 1, l - j - 1, type2, rtype[type],
+                       SS1[k + 1], SS2[l - 1], SS1[i - 1], SS2[j + 1], P);
+        if (E == c[k][l] + LE) {
+          traced  = 1;
+          i       = k;
+          j       = l;
+          break;
+        }
+      }
+      if (traced)
+        break;
+    }
+    if (!traced) {
+      E -= vrna_E_ext_stem(type, (i > 1) ? SS1[i - 1] : -1, (j < n2) ? SS2[j + 1] : -1, P);
+      if (E != P->DuplexInit)
+        vrna_message_error("backtrack failed in fold duplex");
+      else
+        break;
+    }
+  }
+  if (i > 1)
+    i--;
+
+  if (j < n2)
+    j++;
+
+  struc = (char *)vrna_alloc(i0 - i + 1 + j - j0 + 1 + 2);
+  for (k = MAX2(i, 1); k <= i0; k++)
+    if (!st1[k - 1])
+      st1[k - 1] = '.';
+
+  for (k = j0; k <= j; k++)
+    if (!st2[k - 1])
+      st2[k - 1] = '.';
+
+  strcpy(struc, st1 + MAX2(i - 1, 0));
+  strcat(struc, "&");
+  strcat(struc, st2 + j0 - 1);
+
+  free(st1);
+  free(st2);
+
+  return struc;
+}
+
+
+PRIVATE char *
+stem_structure(const snoop_stems_t  *st,
+               const char           *snoseq,
+               int                  i,
+               int                  j)
+{
+  if (st->stems)
+    return vrna_sno_stems_structure(st->stems, i, j);
+
+  return snobacktrack_fold_from_pair(snoseq, i, j);
+}
+
+
+PRIVATE void
+legacy_model(snoop_model_t *m)
+{
+  m->P      = P;
+  m->pair   = pair;
+  m->rtype  = rtype;
+  m->alias  = alias;
+}
+
+
+PRIVATE void
+legacy_stems(snoop_stems_t *st)
+{
+  int     *indx, *mLoop, *cLoop;
+  folden  **foldlist, **foldlist_XS;
+
+  snoexport_fold_arrays(&indx, &mLoop, &cLoop, &foldlist, &foldlist_XS);
+
+  st->indx      = indx;
+  st->cLoop     = cLoop;
+  st->foldlist  = foldlist;
+  st->stems     = NULL;
+}
+
+
+PRIVATE void
+legacy_opt(vrna_snoop_opt_t *opt,
+           const int        delta,
+           const int        penalty,
+           const int        threshloop,
+           const int        threshLE,
+           const int        threshRE,
+           const int        threshDE,
+           const int        threshTE,
+           const int        threshSE,
+           const int        threshD,
+           const int        distance,
+           const int        half_stem,
+           const int        max_half_stem,
+           const int        min_s2,
+           const int        max_s2,
+           const int        min_s1,
+           const int        max_s1,
+           const int        min_d1,
+           const int        min_d2,
+           const int        alignment_length)
+{
+  opt->penalty          = penalty;
+  opt->threshloop       = threshloop;
+  opt->threshLE         = threshLE;
+  opt->threshRE         = threshRE;
+  opt->threshDE         = threshDE;
+  opt->threshTE         = threshTE;
+  opt->threshSE         = threshSE;
+  opt->threshD          = threshD;
+  opt->distance         = distance;
+  opt->half_stem        = half_stem;
+  opt->max_half_stem    = max_half_stem;
+  opt->min_s2           = min_s2;
+  opt->max_s2           = max_s2;
+  opt->min_s1           = min_s1;
+  opt->max_s1           = max_s1;
+  opt->min_d1           = min_d1;
+  opt->min_d2           = min_d2;
+  opt->alignment_length = alignment_length;
+  opt->delta            = delta;
+  opt->max_assym        = 0;
+  opt->seed_length      = 0;
+}
+
+
+PRIVATE void
+prepare_mx(const snoop_model_t  *m,
+           snoop_mx_t           *mx,
+           const char           *s1,
+           const char           *s2)
+{
+  int i;
+
+  mx->n1  = (int)strlen(s1);
+  mx->n2  = (int)strlen(s2);
+  mx->S1  = vrna_seq_encode_simple(s1, &(m->P->model_details));
+  mx->S2  = vrna_seq_encode_simple(s2, &(m->P->model_details));
+  mx->SS1 = (short *)vrna_alloc(sizeof(short) * (mx->n1 + 2));
+  mx->SS2 = (short *)vrna_alloc(sizeof(short) * (mx->n2 + 2));
+  mx->c   = NULL;
+  mx->r   = NULL;
+
+  for (i = 1; i <= mx->n1; i++)  /* for mismatches of nostandard bases */
+    mx->SS1[i] = m->alias[mx->S1[i]];
+
+  for (i = 1; i <= mx->n2; i++)
+    mx->SS2[i] = m->alias[mx->S2[i]];
+}
+
+
+PRIVATE void
+free_mx(snoop_mx_t *mx)
+{
+  int i;
+
+  for (i = 0; i <= mx->n1; i++) {
+    if (mx->c)
+      free(mx->c[i]);
+
+    if (mx->r)
+      free(mx->r[i]);
+  }
+
+  free(mx->c);
+  free(mx->r);
+  free(mx->S1);
+  free(mx->SS1);
+  free(mx->S2);
+  free(mx->SS2);
+}
+
+
+/*
+ *  Mark all rows of the (padded) target that may take part in an interaction
+ *  with a perfect seed, i.e. a k-mer that pairs with the guide region of the
+ *  snoRNA. Returns NULL if there is no seed at all
+ */
+PRIVATE unsigned char *
+seed_rows(const vrna_snoop_engine_t *engine,
+          const snoop_mx_t          *mx)
+{
+  unsigned int  i, k, key, mask, valid, seed_length, margin, from, to, found;
+  int           *cover, sum;
+  unsigned char *active;
+
+  seed_length = engine->opt.seed_length;
+  margin      = (unsigned int)engine->opt.alignment_length + 5;
+  mask        = (1U << (2 * seed_length)) - 1;
+  cover       = (int *)vrna_alloc(sizeof(int) * (mx->n1 + 2));
+  key         = 0;
+  valid       = 0;
+  found       = 0;
+
+  for (i = 1; i <= (unsigned int)mx->n1; i++) {
+    k = (unsigned int)mx->S1[i];
+    if ((k < 1) || (k > 4)) {
+      valid = 0;
+      continue;
+    }
+
+    key = ((key << 2) | (k - 1)) & mask;
+    if (++valid < seed_length)
+      continue;
+
+    if (engine->seeds[key >> 3] & (1U << (key & 7))) {
+      from  = (i + 1 > seed_length + margin) ? i + 1 - seed_length - margin : 1;
+      to    = MIN2(i + margin, (unsigned int)mx->n1);
+      cover[from]++;
+      cover[to + 1]--;
+      found = 1;
+    }
+  }
+
+  active = NULL;
+  if (found) {
+    active = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (mx->n1 + 1));
+    for (sum = 0, i = 1; i <= (unsigned int)mx->n1; i++) {
+      sum       += cover[i];
+      active[i] = (sum > 0);
+    }
+  }
+
+  free(cover);
+
+  return active;
+}
+
+
+PUBLIC vrna_snoop_engine_t *
+vrna_snoop_engine(const char              *snoRNA,
+                  const vrna_snoop_opt_t  *opt,
+                  const vrna_md_t         *md)
+{
+  unsigned int        k, key, mask, valid, seed_length;
+  int                 j;
+  const int           *indx, *cLoop;
+  short               *S;
+  vrna_md_t           md_local;
+  vrna_snoop_engine_t *engine;
+
+  if ((!snoRNA) || (!opt) || (*snoRNA == '\0') || (opt->alignment_length < 1) ||
+      (opt->seed_length > SEED_MAX))
+    return NULL;
+
+  if (md) {
+    md_local = *md;
+    vrna_md_update(&md_local);
+  } else {
+    set_model_details(&md_local);
+    /* pair rules follow the globals, as for make_pair_matrix() in Lsnoop_subopt_list() */
+    md_local.noGU         = noGU;
+    md_local.noGUclosure  = no_closingGU;
+    vrna_md_update(&md_local);
+  }
+
+  engine            = (vrna_snoop_engine_t *)vrna_alloc(sizeof(vrna_snoop_engine_t));
+  engine->opt       = *opt;
+  engine->sequence  = vrna_strdup_printf("NNNNN%sNNNNN", snoRNA);
+  engine->sno       = vrna_sno_stems(engine->sequence,
+                                     &md_local,
+                                     opt->max_assym,
+                                     opt->threshloop,
+                                     opt->min_s2,
+                                     opt->max_s2,
+                                     opt->half_stem,
+                                     opt->max_half_stem);
+
+  if (!engine->sno) {
+    free(engine->sequence);
+    free(engine);
+    return NULL;
+  }
+
+  engine->model.P         = vrna_params(&md_local);
+  engine->model.pair      = engine->model.P->model_details.pair;
+  engine->model.rtype     = engine->model.P->model_details.rtype;
+  engine->model.alias     = engine->model.P->model_details.alias;
+  engine->fullStemEnergy  = vrna_sno_stems_energy(engine->sno);
+  engine->stems.stems     = engine->sno;
+
+  vrna_sno_stems_export(engine->sno, &indx, &cLoop, &(engine->stems.foldlist));
+  engine->stems.indx  = indx;
+  engine->stems.cLoop = cLoop;
+
+  /*
+   *  index the reverse complements of all Watson-Crick k-mers within the
+   *  guide region of the snoRNA, i.e. the seeds of interactions in the target
+   */
+  seed_length = opt->seed_length;
+  if (seed_length > 0) {
+    S             = vrna_seq_encode_simple(engine->sequence, &md_local);
+    mask          = (1U << (2 * seed_length)) - 1;
+    engine->seeds = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (mask / 8 + 1));
+    key           = 0;
+    valid         = 0;
+
+    for (j = (int)S[0] - opt->min_d2; j > opt->min_d1; j--) {
+      k = (unsigned int)S[j];
+      if ((k < 1) || (k > 4)) {
+        valid = 0;
+        continue;
+      }
+
+      key = ((key << 2) | (4 - k)) & mask;
+      if (++valid >= seed_length)
+        engine->seeds[key >> 3] |= (unsigned char)(1U << (key & 7));
+    }
+
+    free(S);
+  }
+
+  return engine;
+}
+
+
+PUBLIC void
+vrna_snoop_engine_free(vrna_snoop_engine_t *engine)
+{
+  if (engine) {
+    vrna_sno_stems_free(engine->sno);
+    free(engine->model.P);
+    free(engine->sequence);
+    free(engine->seeds);
+    free(engine);
+  }
+}
+
+
+PUBLIC snoopT *
+vrna_snoop_scan(const vrna_snoop_engine_t *engine,
+                const char                *target)
+{
+  int           max, *position;
+  char          *s1;
+  unsigned char *active;
+  snoop_mx_t    mx;
+  snoop_hits_t  hits;
+
+  if ((!engine) || (!target))
+    return NULL;
+
+  s1        = vrna_strdup_printf("NNNNN%sNNNNN", target);
+  hits.num  = 0;
+  hits.size = 16;
+  hits.list = (snoopT *)vrna_alloc(sizeof(snoopT) * hits.size);
+
+  prepare_mx(&(engine->model), &mx, s1, engine->sequence);
+
+  active = NULL;
+  if (engine->seeds)
+    active = seed_rows(engine, &mx);
+
+  if ((!engine->seeds) || (active)) {
+    position  = (int *)vrna_alloc((mx.n1 + 3) * sizeof(int));
+    max       = scan_snoop(&(engine->model), &(engine->stems), &mx, &(engine->opt), active,
+                           position);
+
+    if (max < engine->opt.threshTE)
+      find_max_snoop(&(engine->model),
+                     &(engine->stems),
+                     s1,
+                     engine->sequence,
+                     max,
+                     position,
+                     &(engine->opt),
+                     engine->fullStemEnergy,
+                     &collect_site,
+                     (void *)&hits);
+
+    free(position);
+  }
+
+  free_mx(&mx);
+  free(active);
+  free(s1);
+
+  hits.list = (snoopT *)vrna_realloc(hits.list, sizeof(snoopT) * (hits.num + 1));
+  memset(hits.list + hits.num, 0, sizeof(snoopT));
+
+  return hits.list;
+}
+
+
+PUBLIC snoopT **
+vrna_snoop_scan_multi(vrna_snoop_engine_t **engines,
+                      unsigned int        num_engines,
+                      const char          **targets,
+                      unsigned int        num_targets)
+{
+  int     k, num;
+  snoopT  **hits;
+
+  if ((!engines) || (!targets) || (num_engines == 0) || (num_targets == 0))
+    return NULL;
+
+  num   = (int)(num_engines * num_targets);
+  hits  = (snoopT **)vrna_alloc(sizeof(snoopT *) * num);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (k = 0; k < num; k++) {
+    unsigned int  e = (unsigned int)k / num_targets;
+    unsigned int  t = (unsigned int)k % num_targets;
+
+    hits[k] = vrna_snoop_scan(engines[e], targets[t]);
+  }
+
+  return hits;
+}
+
+
+PUBLIC void
+vrna_snoop_hits_free(snoopT *hits)
+{
+  snoopT *ptr;
+
+  if (hits) {
+    for (ptr = hits; ptr->structure; ptr++)
+      free(ptr->structure);
+
+    free(hits);
+  }
+}
@@ -2,6 +2,44 @@
 #define VIENNA_RNA_PACKAGE_SNOOP_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
+
+/**
+ *  @brief  A reentrant engine for snoRNA-RNA interactions with a single snoRNA
+ *
+ *  @see vrna_snoop_engine(), vrna_snoop_scan(), vrna_snoop_engine_free()
+ */
+typedef struct vrna_snoop_engine_s vrna_snoop_engine_t;
+
+/**
+ *  @brief  The search constraints of a snoRNA target scan
+ *
+ *  All energies are given in dcal/mol, all positions refer to the snoRNA
+ *  padded with five 'N' on either side, just like for Lsnoop_subopt_list().
+ */
+typedef struct {
+  int           penalty;          /**< @brief Penalty for each nucleotide of interior loops in the interaction */
+  int           threshloop;       /**< @brief Energy threshold of the stems of the snoRNA */
+  int           threshLE;         /**< @brief Energy threshold of the lower (5') duplex */
+  int           threshRE;         /**< @brief Energy threshold of the upper (3') duplex */
+  int           threshDE;         /**< @brief Energy threshold of both duplexes */
+  int           threshTE;         /**< @brief Energy threshold of the duplexes and the stem */
+  int           threshSE;         /**< @brief Energy threshold of the entire interaction */
+  int           threshD;          /**< @brief Energy threshold of the interaction between the 5' and 3' parts of the snoRNA */
+  int           distance;         /**< @brief Minimal distance between two interaction sites */
+  int           half_stem;        /**< @brief Minimal length of the 5' half of a stem */
+  int           max_half_stem;    /**< @brief Maximal length of the 5' half of a stem */
+  int           min_s2;           /**< @brief Minimal distance of a stem from the 3' end of the snoRNA */
+  int           max_s2;           /**< @brief Maximal distance of a stem from the 3' end of the snoRNA */
+  int           min_s1;           /**< @brief Minimal position of the upper duplex in the snoRNA */
+  int           max_s1;           /**< @brief Maximal position of the upper duplex in the snoRNA */
+  int           min_d1;           /**< @brief Minimal distance of the upper duplex from the 5' end of the snoRNA */
+  int           min_d2;           /**< @brief Minimal distance of the upper duplex from the 3' end of the snoRNA */
+  int           alignment_length; /**< @brief Maximal length of an interaction in the target */
+  int           delta;            /**< @brief Energy range of suboptimal interactions */
+  int           max_assym;        /**< @brief Maximal asymmetry of interior loops within a stem */
+  unsigned int  seed_length;      /**< @brief Length of the seed prefilter, 0 to disable it */
+} vrna_snoop_opt_t;
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -291,4 +329,102 @@ snoopT snoopfold_XS(const char  *s1,
 extern int snoop_subopt_sorted;
 #endif
 
+/**
+ *  @brief  Prepare a reentrant snoRNA target scan engine
+ *
+ *  The engine stores everything that Lsnoop_subopt_list() requires of a single
+ *  H/ACA snoRNA, i.e. the energy parameters and the stem folding arrays as
+ *  obtained from vrna_sno_stems(). Afterwards, arbitrarily many target RNAs can
+ *  be scanned with vrna_snoop_scan(), concurrently from as many threads as
+ *  desired, since the engine itself is never modified.
+ *
+ *  If @p opt->seed_length is non-zero, the engine additionally indexes all
+ *  k-mers of length @p opt->seed_length (at most 12) that pair perfectly with
+ *  the guide region of the snoRNA. Target scans then skip all parts of a target
+ *  that lack such a seed within @p opt->alignment_length nucleotides. This is
+ *  a heuristic that may miss interactions without a perfect seed.
+ *
+ *  Model details default to the global settings when @p md is @em NULL.
+ *
+ *  @see  vrna_snoop_scan(), vrna_snoop_scan_multi(), vrna_snoop_engine_free(), Lsnoop_subopt_list()
+ *
+ *  @param  snoRNA  The snoRNA sequence (without padding)
+ *  @param  opt     The search constraints
+ *  @param  md      The model details (may be @em NULL)
+ *  @return         The snoRNA engine, or @em NULL on any error
+ */
+vrna_snoop_engine_t *
+vrna_snoop_engine(const char              *snoRNA,
+                  const vrna_snoop_opt_t  *opt,
+                  const vrna_md_t         *md);
+
+
+/**
+ *  @brief  Free memory occupied by a snoRNA target scan engine
+ *
+ *  @see  vrna_snoop_engine()
+ *
+ *  @param  engine  The snoRNA engine
+ */
+void
+vrna_snoop_engine_free(vrna_snoop_engine_t *engine);
+
+
+/**
+ *  @brief  Scan a target RNA for interactions with the snoRNA of an engine
+ *
+ *  This is the reentrant counterpart of Lsnoop_subopt_list(). All intermediate
+ *  data is local to the call, so different threads may use the same engine at
+ *  the same time. Without seed prefilter, the interactions are those printed by
+ *  Lsnoop_subopt_list() for the same (padded) sequences.
+ *
+ *  Each hit stores the 3' end of the interaction within @p target in @em i, the
+ *  position of the pseudouridine in @em u (both 1-based), the 5' end of the
+ *  upper duplex in the snoRNA in @em j, the target and snoRNA structure in
+ *  @em structure, and the total interaction energy in kcal/mol in @em energy.
+ *  The list is terminated by an entry whose @em structure is @em NULL.
+ *
+ *  @see  vrna_snoop_engine(), vrna_snoop_hits_free(), Lsnoop_subopt_list()
+ *
+ *  @param  engine  The snoRNA engine
+ *  @param  target  The target RNA sequence (without padding)
+ *  @return         The list of interactions, or @em NULL on any error
+ */
+snoopT *
+vrna_snoop_scan(const vrna_snoop_engine_t *engine,
+                const char                *target);
+
+
+/**
+ *  @brief  Scan many target RNAs for interactions with many snoRNAs
+ *
+ *  Evaluates all combinations of @p num_engines snoRNA engines and @p num_targets
+ *  target sequences. If OpenMP support is enabled, the combinations are processed
+ *  in parallel. The hits of target @f$ t @f$ with snoRNA @f$ e @f$ are stored at
+ *  position @f$ e \cdot num\_targets + t @f$ of the returned array.
+ *
+ *  @see  vrna_snoop_scan()
+ *
+ *  @param  engines       The snoRNA engines
+ *  @param  num_engines   The number of engines
+ *  @param  targets       The target RNA sequences
+ *  @param  num_targets   The number of targets
+ *  @return               An array of @f$ num\_engines \cdot num\_targets @f$ hit lists, or @em NULL on any error
+ */
+snoopT **
+vrna_snoop_scan_multi(vrna_snoop_engine_t **engines,
+                      unsigned int        num_engines,
+                      const char          **targets,
+                      unsigned int        num_targets);
+
+
+/**
+ *  @brief  Free a list of interactions as obtained from vrna_snoop_scan()
+ *
+ *  @param  hits  The list of interactions
+ */
+void
+vrna_snoop_hits_free(snoopT *hits);
+
+
 #endif
@@ -1910,7 +1910,6 @@ scan_circular(vrna_fold_compound_t  *fc,
               subopt_env            *env,
               constraint_helpers    *constraints_dat)
 {
-  unsigned char             *hard_constraints;
   char                      *ptype;
   short                     *S1;
   int                       k, l, p, q, tmp_en, best_energy, *c, *fML, *fM1, Fc, FcH,
@@ -1955,7 +1954,6 @@ scan_circular(vrna_fold_compound_t  *fc,
   fM2 = fc->matrices->fM2;
 
   hc                = fc->hc;
-  hard_constraints  = hc->mx;
 
   sc = fc->sc;
 
@@ -2055,7 +2053,7 @@ scan_circular(vrna_fold_compound_t  *fc,
       for (l = j; l >= k + turn + 1; l--) {
         kl = indx[l] + k;         /* just confusing these indices ;-) */
 
-        if ((hard_constraints[length * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
+        if ((vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
             (c[kl] != INF)) {
           type = rtype[vrna_get_ptype(kl, ptype)];
 
@@ -2704,7 +2702,7 @@ repeat(vrna_fold_compound_t *fc,
 
   char                      *ptype;
   short                     *S1;
-  unsigned int              n, *sn, *se, nick;
+  unsigned int              *sn, *se, nick;
   int                       ij, k, p, q, energy, new, mm, no_close, type, type_2, element_energy,
                             *c, *fML, *fM1, *ggg, **fms5, **fms3, rt, *indx, *rtype, noGUclosure,
                             noLP, with_gquad, dangle_model, minq, eee, aux_eee, cnt, *ps, *qs,
@@ -2727,7 +2725,6 @@ repeat(vrna_fold_compound_t *fc,
   sc_mb_red_cb              sc_mb_decomp_ml;
   STATE                     *new_state;
 
-  n     = fc->length;
   S1    = fc->sequence_encoding;
   ptype = fc->ptype;
   indx  = fc->jindx;
@@ -2807,7 +2804,7 @@ repeat(vrna_fold_compound_t *fc,
   best_energy += part_energy; /* energy of current structural element */
   best_energy += temp_energy; /* energy from unpushed interval */
 
-  if (hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     for (p = i + 1; p <= MIN2(j - 2, i + MAXLOOP + 1); p++) {
       minq = j - i + p - MAXLOOP - 2;
       if (minq < p + 1)
@@ -2824,7 +2821,7 @@ repeat(vrna_fold_compound_t *fc,
         if ((noLP) && (p == i + 1) && (q == j - 1))
           continue;
 
-        if (!(hc->mx[n * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC))
+        if (!(vrna_hc_context(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC))
           continue;
 
         if (c[indx[q] + p] == INF)
@@ -143,7 +143,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
     f3        = aux_mx->f3;
 
     /* backtrack (1,n) */
-    if (hc->mx[n + n] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+    if (vrna_hc_context(hc, 1, n) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
       kl            = idx[n] + 1;
       type          = vrna_get_ptype_md(S[1], S[n], md);
       e             = vrna_E_ext_stem(type, -1, -1, P);
@@ -152,7 +152,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
 
     /* backtrack all structures with pairs (k, n) 1 < k < n */
     for (k = n - 1; k > 1; k--) {
-      if (hc->mx[n * n + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+      if (vrna_hc_context(hc, n, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         kl = idx[n] + k;
         if ((sn[k - 1] == sn[k]) &&
             (f5[k - 1] != INF)) {
@@ -180,7 +180,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
 
     /* backtrack all structures with pairs (1, k) 1 < k < n */
     for (k = n - 1; k > 1; k--) {
-      if (hc->mx[n + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+      if (vrna_hc_context(hc, 1, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         kl = idx[k] + 1;
         if ((sn[k] == sn[k + 1]) &&
             (f3[k + 1] != INF)) {
@@ -221,7 +221,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
         e_ext = e_int = e_mb = INF;
 
         /* 1. (k,l) is external pair */
-        if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+        if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
           /* 1.a (k,l) not enclosed by any other pair */
           if ((f5[k - 1] != INF) &&
               (f3[l + 1] != INF) &&
@@ -249,7 +249,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
         }
 
         /* 2. (k,l) enclosed by a single pair forming an internal loop */
-        if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+        if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
           for (j = l + 1; j <= MIN2(l + MAXLOOP + 1, n); j++) {
             u2 = j - l - 1;
 
@@ -268,7 +268,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
               if (hc->up_int[i + 1] < u1)
                 break;
 
-              if (hc->mx[j * n + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+              if (vrna_hc_context(hc, j, i) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
                 tmp = outside_c[ij] +
                       vrna_eval_int_loop(fc, i, j, k, l);
 
@@ -279,7 +279,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
         }
 
         /* 3. (k,l) enclosed as part of a multibranch loop */
-        if ((hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
+        if ((vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
             (sn[l] == sn[l + 1]) &&
             (sn[k - 1] == sn[k])) {
           int *aux_mb     = aux_mx->mb[l];
@@ -371,7 +371,7 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
     for (l = n; l > 1; l--) {
       int idxj = idx[l];
       for (k = 1; k < l; k++) {
-        if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS) {
+        if (vrna_hc_context(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS) {
           pairlist[num_pairs].i     = k;
           pairlist[num_pairs].j     = l;
           pairlist[num_pairs].e     = c[idxj + k] + outside_c[idxj + k];
@@ -511,7 +511,7 @@ prepare_ml_helper(vrna_fold_compound_t  *fc,
     for (j = l + 3; j <= n; j++) {
       if (sn[j] == sn[j - 1]) {
         for (i = l - 2; i > 0; i--) {
-          if ((hc->mx[j * n + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_context(hc, j, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (sn[i] == sn[i + 1]) &&
               (outside_c[idx[j] + i] != INF) &&
               (fML[idx[j - 1] + l + 1] != INF)) {
@@ -567,7 +567,7 @@ prepare_ml_helper(vrna_fold_compound_t  *fc,
     }
 
     for (i = l - 2; i > 0; i--) {
-      if ((hc->mx[(l + 1) * n + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+      if ((vrna_hc_context(hc, l + 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
           (sn[i] == sn[i + 1])) {
         type  = vrna_get_ptype_md(S[l + 1], S[i], md);
         e     = outside_c[idx[l + 1] + i] +
@@ -674,7 +674,7 @@ compute_f3(vrna_fold_compound_t *fc)
 
     /* 2nd case, j forms pair (j,k) with j < k < n */
     for (k = j + 1; k < n; k++) {
-      if (hc->mx[j * n + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+      if (vrna_hc_context(hc, j, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         jk = idx[k] + j;
         if ((c[jk] != INF) &&
             (f3[k + 1] != INF) &&
@@ -702,7 +702,7 @@ compute_f3(vrna_fold_compound_t *fc)
     }
 
     /* 3rd case, j forms pair with (j, n) */
-    if (hc->mx[j * n + n] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+    if (vrna_hc_context(hc, j, n) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
       jk = idx[n] + j;
       if (c[jk] != INF) {
         type  = vrna_get_ptype_md(S[j], S[n], md);
@@ -780,7 +780,7 @@ backtrack_outside:
   /* 1st case, (k,l) enclosed by a single pair (i,j) forming an internal loop */
   if ((k > 1) &&
       (l < n) &&
-      (hc->mx[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC)) {
+      (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC)) {
     min_i = (k > MAXLOOP + 1) ? k - MAXLOOP - 1 : 1;
     u1    = 0;
 
@@ -803,7 +803,7 @@ backtrack_outside:
         if (sn[l] != sn[j])
           break;
 
-        if (hc->mx[j * n + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_context(hc, j, i) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           ij  = idx[j] + i;
           tmp = vrna_eval_int_loop(fc, i, j, k, l);
 
@@ -822,7 +822,7 @@ backtrack_outside:
   /* 2nd case, (k,l) enclosed by a pair (i,j) forming a multibranch loop */
   if ((k > 1) &&
       (l < n) &&
-      (hc->mx[k * n + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
+      (vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
       (sn[k - 1] == sn[k]) &&
       (sn[l] == sn[l + 1])) {
     mb      = aux_mb[l];
@@ -993,7 +993,7 @@ backtrack_outside:
   }
 
   /* 3rd and last chance, (k,l) is not enclosed by any other pair */
-  if ((hc->mx[k * n + l] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+  if ((vrna_hc_context(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
       ((k == 1) || (sn[k - 1] == sn[k])) &&
       ((l == n) || (sn[l] == sn[l + 1]))) {
     switch (dangle_model) {
@@ -1095,7 +1095,7 @@ backtrack_mb(vrna_fold_compound_t *fc,
   e             = aux_mx->mb[*l][i];
 
   for (j = *l + 3; j <= n; j++) {
-    if ((hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+    if ((vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
         (outside_c[idx[j] + i] != INF) &&
         (fML[idx[j - 1] + *l + 1] != INF) &&
         (sn[j - 1] == sn[j])) {
@@ -1162,7 +1162,7 @@ backtrack_mb_up(vrna_fold_compound_t  *fc,
 
   /* find pairing partner j */
   for (j = *l + 1; j <= n; j++) {
-    if ((hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+    if ((vrna_hc_context(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
         (outside_c[idx[j] + i] != INF) &&
         (sn[*l] == sn[j])) {
       type  = vrna_get_ptype_md(S[j], S[i], md);
@@ -1265,7 +1265,7 @@ backtrack_f3(vrna_fold_compound_t *fc,
     case 0:
       for (u = ii + 1; u <= n; u++) {
         if ((sn[u] == sn[u + 1]) &&
-            (hc->mx[ii * n + u] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)) {
+            (vrna_hc_context(hc, ii, u) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)) {
           type  = vrna_get_ptype_md(S[ii], S[u], md);
           en    = c[idx[u] + ii];
 
@@ -1286,7 +1286,7 @@ backtrack_f3(vrna_fold_compound_t *fc,
     case 2:
       for (u = ii + 1; u <= n; u++) {
         if ((sn[u] == sn[u + 1]) &&
-            (hc->mx[ii * n + u] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)) {
+            (vrna_hc_context(hc, ii, u) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)) {
           type  = vrna_get_ptype_md(S[ii], S[u], md);
           s5    = S1[ii - 1];
           s3    = (u < n) ? S1[u + 1] : -1;
@@ -15,6 +15,20 @@ typedef int (*proto_fun_zip_reduce)(const int  *a,
                                     int        size);
 
 
+typedef void (*proto_fun_min_terms)(int           *result,
+                                    const int     **a,
+                                    const int     **b,
+                                    const int     **c,
+                                    const int     *d,
+                                    unsigned int  num_terms,
+                                    int           count);
+
+
+typedef int (*proto_fun_zip_count)(const short  *a,
+                                   const short  *b,
+                                   int          count);
+
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -32,6 +46,38 @@ fun_zip_add_min_default(const int *e1,
                         int       count);
 
 
+static void
+min_add_terms_dispatcher(int          *result,
+                         const int    **a,
+                         const int    **b,
+                         const int    **c,
+                         const int    *d,
+                         unsigned int num_terms,
+                         int          count);
+
+
+static void
+fun_min_add_terms_default(int           *result,
+                          const int     **a,
+                          const int     **b,
+                          const int     **c,
+                          const int     *d,
+                          unsigned int  num_terms,
+                          int           count);
+
+
+static int
+zip_count_common_dispatcher(const short *a,
+                            const short *b,
+                            int         count);
+
+
+static int
+fun_zip_count_common_default(const short  *a,
+                             const short  *b,
+                             int          count);
+
+
 #if VRNA_WITH_SIMD_AVX512
 int
 vrna_fun_zip_add_min_avx512(const int *e1,
@@ -39,6 +85,22 @@ vrna_fun_zip_add_min_avx512(const int *e1,
                             int       count);
 
 
+void
+vrna_fun_min_add_terms_avx512(int           *result,
+                              const int     **a,
+                              const int     **b,
+                              const int     **c,
+                              const int     *d,
+                              unsigned int  num_terms,
+                              int           count);
+
+
+int
+vrna_fun_zip_count_common_avx512(const short  *a,
+                                 const short  *b,
+                                 int          count);
+
+
 #endif
 
 #if VRNA_WITH_SIMD_SSE41
@@ -48,10 +110,28 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
                            int        count);
 
 
+void
+vrna_fun_min_add_terms_sse41(int          *result,
+                             const int    **a,
+                             const int    **b,
+                             const int    **c,
+                             const int    *d,
+                             unsigned int num_terms,
+                             int          count);
+
+
+int
+vrna_fun_zip_count_common_sse41(const short *a,
+                                const short *b,
+                                int         count);
+
+
 #endif
 
 
 static proto_fun_zip_reduce fun_zip_add_min = &zip_add_min_dispatcher;
+static proto_fun_min_terms  fun_min_add_terms = &min_add_terms_dispatcher;
+static proto_fun_zip_count  fun_zip_count_common = &zip_count_common_dispatcher;
 
 
 /*
@@ -62,14 +142,18 @@ static proto_fun_zip_reduce fun_zip_add_min = &zip_add_min_dispatcher;
 PUBLIC void
 vrna_fun_dispatch_disable(void)
 {
-  fun_zip_add_min = &fun_zip_add_min_default;
+  fun_zip_add_min       = &fun_zip_add_min_default;
+  fun_min_add_terms     = &fun_min_add_terms_default;
+  fun_zip_count_common  = &fun_zip_count_common_default;
 }
 
 
 PUBLIC void
 vrna_fun_dispatch_enable(void)
 {
-  fun_zip_add_min = &zip_add_min_dispatcher;
+  fun_zip_add_min       = &zip_add_min_dispatcher;
+  fun_min_add_terms     = &min_add_terms_dispatcher;
+  fun_zip_count_common  = &zip_count_common_dispatcher;
 }
 
 
@@ -82,6 +166,28 @@ vrna_fun_zip_add_min(const int  *e1,
 }
 
 
+PUBLIC void
+vrna_fun_min_add_terms(int          *result,
+                       const int    **a,
+                       const int    **b,
+                       const int    **c,
+                       const int    *d,
+                       unsigned int num_terms,
+                       int          count)
+{
+  (*fun_min_add_terms)(result, a, b, c, d, num_terms, count);
+}
+
+
+PUBLIC int
+vrna_fun_zip_count_common(const short *a,
+                          const short *b,
+                          int         count)
+{
+  return (*fun_zip_count_common)(a, b, count);
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -137,3 +243,109 @@ fun_zip_add_min_default(const int *e1,
 
   return decomp;
 }
+
+
+/* min_add_terms() dispatcher */
+static void
+min_add_terms_dispatcher(int          *result,
+                         const int    **a,
+                         const int    **b,
+                         const int    **c,
+                         const int    *d,
+                         unsigned int num_terms,
+                         int          count)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_min_add_terms = &vrna_fun_min_add_terms_avx512;
+    goto exec_fun_min_add_terms;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_min_add_terms = &vrna_fun_min_add_terms_sse41;
+    goto exec_fun_min_add_terms;
+  }
+
+#endif
+
+  fun_min_add_terms = &fun_min_add_terms_default;
+
+exec_fun_min_add_terms:
+
+  (*fun_min_add_terms)(result, a, b, c, d, num_terms, count);
+}
+
+
+static void
+fun_min_add_terms_default(int           *result,
+                          const int     **a,
+                          const int     **b,
+                          const int     **c,
+                          const int     *d,
+                          unsigned int  num_terms,
+                          int           count)
+{
+  int           i;
+  unsigned int  k;
+
+  for (i = 0; i < count; i++)
+    result[i] = a[0][i] + b[0][i] + c[0][i] + d[0];
+
+  for (k = 1; k < num_terms; k++)
+    for (i = 0; i < count; i++) {
+      const int en = a[k][i] + b[k][i] + c[k][i] + d[k];
+      result[i] = MIN2(result[i], en);
+    }
+}
+
+
+/* zip_count_common() dispatcher */
+static int
+zip_count_common_dispatcher(const short *a,
+                            const short *b,
+                            int         count)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_count_common = &vrna_fun_zip_count_common_avx512;
+    goto exec_fun_zip_count_common;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_count_common = &vrna_fun_zip_count_common_sse41;
+    goto exec_fun_zip_count_common;
+  }
+
+#endif
+
+  fun_zip_count_common = &fun_zip_count_common_default;
+
+exec_fun_zip_count_common:
+
+  return (*fun_zip_count_common)(a, b, count);
+}
+
+
+static int
+fun_zip_count_common_default(const short  *a,
+                             const short  *b,
+                             int          count)
+{
+  int i, cnt;
+
+  for (cnt = i = 0; i < count; i++)
+    if ((a[i] == b[i]) && (a[i] != 0))
+      cnt++;
+
+  return cnt;
+}
@@ -15,4 +15,34 @@ vrna_fun_zip_add_min(const int  *e1,
                      int        count);
 
 
+/**
+ *  @brief  Element-wise minimum over sums of arrays
+ *
+ *  For each @f$ 0 \leq i < count @f$, compute
+ *  @f$ result[i] = \min_{0 \leq k < num\_terms} (a_k[i] + b_k[i] + c_k[i] + d_k) @f$.
+ *  In contrast to vrna_fun_zip_add_min(), #INF values receive no special treatment,
+ *  i.e. they are simply added up. @p result must not overlap with any of the inputs.
+ */
+void
+vrna_fun_min_add_terms(int          *result,
+                       const int    **a,
+                       const int    **b,
+                       const int    **c,
+                       const int    *d,
+                       unsigned int num_terms,
+                       int          count);
+
+
+/**
+ *  @brief  Count the positions where two arrays hold the same non-zero value
+ *
+ *  Returns the number of indices @f$ 0 \leq i < count @f$ with
+ *  @f$ a[i] = b[i] \neq 0 @f$.
+ */
+int
+vrna_fun_zip_count_common(const short *a,
+                          const short *b,
+                          int         count);
+
+
 #endif
@@ -48,3 +48,76 @@ vrna_fun_zip_add_min_avx512(const int *e1,
 
   return decomp;
 }
+
+
+PUBLIC void
+vrna_fun_min_add_terms_avx512(int           *result,
+                              const int     **a,
+                              const int     **b,
+                              const int     **c,
+                              const int     *d,
+                              unsigned int  num_terms,
+                              int           count)
+{
+  int           i = 0;
+  unsigned int  k;
+
+  for (i = 0; i < count - 15; i += 16) {
+    __m512i m = _mm512_set1_epi32(d[0]);
+
+    m = _mm512_add_epi32(m, _mm512_loadu_si512((void *)(a[0] + i)));
+    m = _mm512_add_epi32(m, _mm512_loadu_si512((void *)(b[0] + i)));
+    m = _mm512_add_epi32(m, _mm512_loadu_si512((void *)(c[0] + i)));
+
+    for (k = 1; k < num_terms; k++) {
+      __m512i en = _mm512_set1_epi32(d[k]);
+
+      en  = _mm512_add_epi32(en, _mm512_loadu_si512((void *)(a[k] + i)));
+      en  = _mm512_add_epi32(en, _mm512_loadu_si512((void *)(b[k] + i)));
+      en  = _mm512_add_epi32(en, _mm512_loadu_si512((void *)(c[k] + i)));
+      m   = _mm512_min_epi32(m, en);
+    }
+
+    _mm512_storeu_si512((void *)(result + i), m);
+  }
+
+  for (; i < count; i++) {
+    result[i] = a[0][i] + b[0][i] + c[0][i] + d[0];
+    for (k = 1; k < num_terms; k++) {
+      const int en = a[k][i] + b[k][i] + c[k][i] + d[k];
+      result[i] = MIN2(result[i], en);
+    }
+  }
+}
+
+
+PUBLIC int
+vrna_fun_zip_count_common_avx512(const short  *a,
+                                 const short  *b,
+                                 int          count)
+{
+  int     i   = 0;
+  int     cnt = 0;
+
+  __m512i zero  = _mm512_setzero_si512();
+  __m512i one   = _mm512_set1_epi32(1);
+  __m512i acc   = _mm512_setzero_si512();
+
+  /* AVX512F lacks 16-bit comparisons, so widen to 32-bit lanes first */
+  for (i = 0; i < count - 15; i += 16) {
+    __m512i   x = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)&a[i]));
+    __m512i   y = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)&b[i]));
+
+    __mmask16 m = _mm512_mask_cmpeq_epi32_mask(_mm512_cmpneq_epi32_mask(x, zero), x, y);
+
+    acc = _mm512_mask_add_epi32(acc, m, acc, one);
+  }
+
+  cnt = _mm512_reduce_add_epi32(acc);
+
+  for (; i < count; i++)
+    if ((a[i] == b[i]) && (a[i] != 0))
+      cnt++;
+
+  return cnt;
+}
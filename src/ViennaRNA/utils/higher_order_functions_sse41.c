@@ -55,6 +55,84 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
 }
 
 
+PUBLIC void
+vrna_fun_min_add_terms_sse41(int           *result,
+                             const int     **a,
+                             const int     **b,
+                             const int     **c,
+                             const int     *d,
+                             unsigned int  num_terms,
+                             int           count)
+{
+  int           i = 0;
+  unsigned int  k;
+
+  for (i = 0; i < count - 3; i += 4) {
+    __m128i m = _mm_set1_epi32(d[0]);
+
+    m = _mm_add_epi32(m, _mm_loadu_si128((__m128i *)(a[0] + i)));
+    m = _mm_add_epi32(m, _mm_loadu_si128((__m128i *)(b[0] + i)));
+    m = _mm_add_epi32(m, _mm_loadu_si128((__m128i *)(c[0] + i)));
+
+    for (k = 1; k < num_terms; k++) {
+      __m128i en = _mm_set1_epi32(d[k]);
+
+      en  = _mm_add_epi32(en, _mm_loadu_si128((__m128i *)(a[k] + i)));
+      en  = _mm_add_epi32(en, _mm_loadu_si128((__m128i *)(b[k] + i)));
+      en  = _mm_add_epi32(en, _mm_loadu_si128((__m128i *)(c[k] + i)));
+      m   = _mm_min_epi32(m, en);
+    }
+
+    _mm_storeu_si128((__m128i *)(result + i), m);
+  }
+
+  for (; i < count; i++) {
+    result[i] = a[0][i] + b[0][i] + c[0][i] + d[0];
+    for (k = 1; k < num_terms; k++) {
+      const int en = a[k][i] + b[k][i] + c[k][i] + d[k];
+      result[i] = MIN2(result[i], en);
+    }
+  }
+}
+
+
+PUBLIC int
+vrna_fun_zip_count_common_sse41(const short *a,
+                                const short *b,
+                                int         count)
+{
+  int     i   = 0;
+  int     cnt = 0;
+
+  __m128i zero  = _mm_setzero_si128();
+  __m128i acc   = _mm_setzero_si128();
+
+  for (i = 0; i < count - 7; i += 8) {
+    __m128i x = _mm_loadu_si128((__m128i *)&a[i]);
+    __m128i y = _mm_loadu_si128((__m128i *)&b[i]);
+
+    /* all bits set where x == y and x != 0 */
+    __m128i m = _mm_andnot_si128(_mm_cmpeq_epi16(x, zero),
+                                 _mm_cmpeq_epi16(x, y));
+
+    /* each lane counts at most count / 8 < 2^15 matches */
+    acc = _mm_sub_epi16(acc, m);
+  }
+
+  /* sum up the 16-bit counters */
+  acc = _mm_madd_epi16(acc, _mm_set1_epi16(1));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  cnt = _mm_cvtsi128_si32(acc);
+
+  for (; i < count; i++)
+    if ((a[i] == b[i]) && (a[i] != 0))
+      cnt++;
+
+  return cnt;
+}
+
+
 /*
  *  SSE minimum
  *  see also: http://stackoverflow.com/questions/9877700/getting-max-value-in-a-m128i-vector-with-sse
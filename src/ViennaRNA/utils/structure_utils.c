@@ -17,8 +17,19 @@
 #include <math.h>
 #include <limits.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/gquad.h"
 #include "ViennaRNA/utils/structures.h"
@@ -31,6 +42,10 @@
 #endif
 
 
+/* row alignment (in entries) and number of rows processed together in packed structures */
+#define STRUCT_PACK_ALIGN   16
+#define STRUCT_PACK_BLOCK   16
+
 #define SHAPES_OPEN   '['
 #define SHAPES_CLOSE  ']'
 #define SHAPES_UP     '_'
@@ -68,6 +83,11 @@ assign_elements_pair(short  *pt,
                      char   *elements);
 
 
+PRIVATE void
+bp_distance_matrix_fill(const vrna_struct_pack_t  *pack,
+                        int                       *dist);
+
+
 PRIVATE INLINE void
 flatten_brackets(char       *string,
                  const char pair[3],
@@ -637,6 +657,159 @@ vrna_bp_distance(const char *str1,
 }
 
 
+PUBLIC vrna_struct_pack_t *
+vrna_struct_pack(const char   **structures,
+                 unsigned int num)
+{
+  short               *pt, *row;
+  unsigned int        k, i, n;
+  vrna_struct_pack_t  *pack;
+
+  if ((!structures) ||
+      (num == 0) ||
+      (!structures[0]))
+    return NULL;
+
+  n = (unsigned int)strlen(structures[0]);
+
+  for (k = 1; k < num; k++)
+    if ((!structures[k]) ||
+        (strlen(structures[k]) != n)) {
+      vrna_message_warning("vrna_struct_pack: "
+                           "structures have unequal lengths!");
+      return NULL;
+    }
+
+  pack            = (vrna_struct_pack_t *)vrna_alloc(sizeof(vrna_struct_pack_t));
+  pack->length    = n;
+  pack->num       = num;
+  pack->stride    = STRUCT_PACK_ALIGN * ((n + STRUCT_PACK_ALIGN - 1) / STRUCT_PACK_ALIGN);
+  pack->partners  = (short *)vrna_alloc(sizeof(short) * (size_t)pack->stride * num);
+  pack->pairs     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num);
+
+  for (k = 0; k < num; k++) {
+    pt  = vrna_ptable(structures[k]);
+    row = pack->partners + (size_t)k * pack->stride;
+
+    for (i = 1; i <= n; i++)
+      if (pt[i] > (short)i) {
+        row[i - 1] = pt[i];
+        pack->pairs[k]++;
+      }
+
+    free(pt);
+  }
+
+  return pack;
+}
+
+
+PUBLIC void
+vrna_struct_pack_free(vrna_struct_pack_t *pack)
+{
+  if (pack) {
+    free(pack->partners);
+    free(pack->pairs);
+    free(pack);
+  }
+}
+
+
+PUBLIC int
+vrna_bp_distance_packed(const vrna_struct_pack_t  *pack,
+                        unsigned int              a,
+                        unsigned int              b)
+{
+  int common;
+
+  if ((!pack) ||
+      (a >= pack->num) ||
+      (b >= pack->num))
+    return -1;
+
+  common = vrna_fun_zip_count_common(pack->partners + (size_t)a * pack->stride,
+                                     pack->partners + (size_t)b * pack->stride,
+                                     (int)pack->stride);
+
+  return (int)(pack->pairs[a] + pack->pairs[b]) - 2 * common;
+}
+
+
+PUBLIC int *
+vrna_bp_distance_matrix(const vrna_struct_pack_t *pack)
+{
+  int *dist;
+
+  if ((!pack) ||
+      (pack->num < 2))
+    return NULL;
+
+  dist = (int *)vrna_alloc(sizeof(int) * ((size_t)pack->num * (pack->num - 1) / 2));
+
+  bp_distance_matrix_fill(pack, dist);
+
+  return dist;
+}
+
+
+PUBLIC int
+vrna_bp_distance_matrix_file(const vrna_struct_pack_t *pack,
+                             const char               *filename)
+{
+  int     *dist, ret;
+  size_t  size, written;
+  FILE    *fp;
+
+  if ((!pack) ||
+      (!filename))
+    return 0;
+
+  size = sizeof(int) * ((size_t)pack->num * (pack->num - 1) / 2);
+
+#ifndef _WIN32
+  if (size > 0) {
+    int fd;
+
+    if ((fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+      return 0;
+
+    dist = NULL;
+
+    if (ftruncate(fd, (off_t)size) == 0) {
+      dist = (int *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (dist == (int *)MAP_FAILED)
+        dist = NULL;
+    }
+
+    close(fd);
+
+    if (dist) {
+      bp_distance_matrix_fill(pack, dist);
+      ret = (munmap(dist, size) == 0) ? 1 : 0;
+      return ret;
+    }
+  }
+
+#endif
+
+  /* fall back to computing the matrix in memory */
+  if (!(fp = fopen(filename, "wb")))
+    return 0;
+
+  written = 0;
+  dist    = vrna_bp_distance_matrix(pack);
+
+  if (dist)
+    written = fwrite(dist, 1, size, fp);
+
+  free(dist);
+
+  ret = ((fclose(fp) == 0) && (written == size)) ? 1 : 0;
+
+  return ret;
+}
+
+
 PUBLIC double
 vrna_dist_mountain(const char   *str1,
                    const char   *str2,
@@ -1583,9 +1756,10 @@ wrap_get_plist(vrna_mx_pf_t     *matrices,
                vrna_exp_param_t *pf_params,
                double           cut_off)
 {
-  int         i, j, k, n, count, gquad;
-  FLT_OR_DBL  *probs, *G, *scale;
-  vrna_ep_t   *pl;
+  int                 i, j, k, n, count, gquad;
+  FLT_OR_DBL          *probs, *scale;
+  vrna_ep_t           *pl;
+  vrna_gquad_index_t  *G;
 
   probs = matrices->probs;
   G     = matrices->G;
@@ -2053,3 +2227,48 @@ bppm_to_structure(char          *structure,
 
 
 #endif
+
+
+PRIVATE void
+bp_distance_matrix_fill(const vrna_struct_pack_t  *pack,
+                        int                       *dist)
+{
+  unsigned int  num, blocks, blk, a, b, a_start, a_end;
+  int           stride;
+  size_t        offset[STRUCT_PACK_BLOCK];
+  const short   *row_b;
+
+  num     = pack->num;
+  stride  = (int)pack->stride;
+  blocks  = (num + STRUCT_PACK_BLOCK - 1) / STRUCT_PACK_BLOCK;
+
+  /* resolve the SIMD dispatcher before any thread calls it */
+  (void)vrna_fun_zip_count_common(pack->partners, pack->partners, 0);
+
+  /*
+   *  Each task processes a block of rows a, such that every row b
+   *  is loaded once per block rather than once per row
+   */
+#ifdef _OPENMP
+#pragma omp parallel for private(a, b, a_start, a_end, offset, row_b) schedule(dynamic, 1)
+#endif
+  for (blk = 0; blk < blocks; blk++) {
+    a_start = blk * STRUCT_PACK_BLOCK;
+    a_end   = MIN2(a_start + STRUCT_PACK_BLOCK, num);
+
+    /* start of row a in the condensed matrix, shifted such that column b can be added directly */
+    for (a = a_start; a < a_end; a++)
+      offset[a - a_start] = (size_t)a * num - (size_t)a * (a + 1) / 2 - a - 1;
+
+    for (b = a_start + 1; b < num; b++) {
+      row_b = pack->partners + (size_t)b * stride;
+
+      for (a = a_start; (a < a_end) && (a < b); a++)
+        dist[offset[a - a_start] + b] = (int)(pack->pairs[a] + pack->pairs[b]) -
+                                        2 * vrna_fun_zip_count_common(pack->partners +
+                                                                      (size_t)a * stride,
+                                                                      row_b,
+                                                                      stride);
+    }
+  }
+}
@@ -39,6 +39,13 @@ typedef struct vrna_hx_s vrna_hx_t;
 typedef struct vrna_elem_prob_s vrna_ep_t;
 
 
+/**
+ *  @brief Convenience typedef for data structure #vrna_struct_pack_s
+ *  @ingroup  struct_utils_metrics
+ */
+typedef struct vrna_struct_pack_s vrna_struct_pack_t;
+
+
 /**
  *  @addtogroup struct_utils_dot_bracket
  *  @{
@@ -667,6 +674,109 @@ vrna_bp_distance(const char *str1,
                  const char *str2);
 
 
+/**
+ *  @brief  A set of secondary structures packed for fast base pair distance computations
+ *
+ *  Each structure @f$ k @f$ occupies a row of @p stride entries in @p partners, where
+ *  @p partners[k * stride + i - 1] holds @f$ j @f$ if the structure contains the base
+ *  pair @f$ (i,j) @f$ with @f$ i < j @f$, and 0 otherwise. Rows are padded with zeros.
+ *  Two structures share a base pair exactly where their rows hold the same non-zero
+ *  value, such that their base pair distance is
+ *  @f$ pairs[a] + pairs[b] - 2 \cdot |\{i : row_a[i] = row_b[i] \neq 0\}| @f$.
+ *
+ *  @see vrna_struct_pack(), vrna_bp_distance_packed(), vrna_bp_distance_matrix()
+ */
+struct vrna_struct_pack_s {
+  unsigned int  length;     /**<  @brief  Length of the structures */
+  unsigned int  num;        /**<  @brief  Number of structures */
+  unsigned int  stride;     /**<  @brief  Number of entries per row in @p partners */
+  short         *partners;  /**<  @brief  3' pairing partners of all structures, row by row */
+  unsigned int  *pairs;     /**<  @brief  Number of base pairs of each structure */
+};
+
+
+/**
+ *  @brief  Pack a set of secondary structures for fast base pair distance computations
+ *
+ *  @see vrna_struct_pack_free(), vrna_bp_distance_packed(), vrna_bp_distance_matrix()
+ *
+ *  @param  structures  The secondary structures in dot-bracket notation
+ *  @param  num         The number of structures
+ *  @return             The packed structures, or NULL if the structures differ in length
+ */
+vrna_struct_pack_t *
+vrna_struct_pack(const char   **structures,
+                 unsigned int num);
+
+
+/**
+ *  @brief  Free memory occupied by a set of packed structures
+ *
+ *  @see vrna_struct_pack()
+ *
+ *  @param  pack  The packed structures
+ */
+void
+vrna_struct_pack_free(vrna_struct_pack_t *pack);
+
+
+/**
+ *  @brief  Compute the base pair distance between two packed structures
+ *
+ *  Yields the same result as vrna_bp_distance() for the corresponding
+ *  dot-bracket strings.
+ *
+ *  @see vrna_struct_pack(), vrna_bp_distance()
+ *
+ *  @param  pack  The packed structures
+ *  @param  a     The index of the first structure (0-based)
+ *  @param  b     The index of the second structure (0-based)
+ *  @return       The base pair distance between structures @p a and @p b
+ */
+int
+vrna_bp_distance_packed(const vrna_struct_pack_t  *pack,
+                        unsigned int              a,
+                        unsigned int              b);
+
+
+/**
+ *  @brief  Compute all pairwise base pair distances of a set of packed structures
+ *
+ *  The distances are returned as condensed matrix, i.e. the upper triangle of the
+ *  distance matrix without the main diagonal in row-major order. The distance
+ *  between structures @f$ a < b @f$ is stored at position
+ *  @f$ a \cdot num - a (a + 1) / 2 + b - a - 1 @f$.
+ *  If the library has been compiled with OpenMP support, the rows of the matrix
+ *  are distributed among the available threads.
+ *
+ *  @see vrna_struct_pack(), vrna_bp_distance_matrix_file()
+ *
+ *  @param  pack  The packed structures
+ *  @return       The condensed distance matrix of @f$ num (num - 1) / 2 @f$ entries, or NULL on any error
+ */
+int *
+vrna_bp_distance_matrix(const vrna_struct_pack_t *pack);
+
+
+/**
+ *  @brief  Compute all pairwise base pair distances of a set of packed structures and store them in a file
+ *
+ *  Same as vrna_bp_distance_matrix() but the condensed matrix is written to @p filename
+ *  as raw array of native 32-bit integers without any header. Where available, the file
+ *  is memory-mapped and filled in place, such that matrices larger than the main memory
+ *  can be produced, and the file can be mapped again by subsequent analyses.
+ *
+ *  @see vrna_struct_pack(), vrna_bp_distance_matrix()
+ *
+ *  @param  pack      The packed structures
+ *  @param  filename  The name of the output file
+ *  @return           1 on success, 0 otherwise
+ */
+int
+vrna_bp_distance_matrix_file(const vrna_struct_pack_t *pack,
+                             const char               *filename);
+
+
 double
 vrna_dist_mountain(const char   *str1,
                    const char   *str2,
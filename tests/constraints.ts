@@ -5,6 +5,8 @@
 #include <ViennaRNA/io/file_formats.h>
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/constraints/SHAPE.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
 
 static int
 deltaCompare(double a,
@@ -32,6 +34,47 @@ writeTempFile(char        *tempfile,
 }
 
 
+
+/*
+ *  compare an (incremental) re-computation of MFE, partition function and
+ *  base pair probabilities with a computation from scratch
+ */
+static void
+compareFills(vrna_fold_compound_t *fc,
+             vrna_fold_compound_t *ref)
+{
+  char        *s1, *s2;
+  int         i, j, n, *iindx;
+  double      e1, e2;
+  FLT_OR_DBL  *p1, *p2;
+
+  n   = (int)fc->length;
+  s1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s2  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  e1  = vrna_mfe(fc, s1);
+  e2  = vrna_mfe(ref, s2);
+
+  ck_assert_str_eq(s1, s2);
+  ck_assert(deltaCompare(e1, e2));
+
+  e1  = vrna_pf(fc, NULL);
+  e2  = vrna_pf(ref, NULL);
+
+  ck_assert(deltaCompare(e1, e2));
+
+  iindx = fc->iindx;
+  p1    = fc->exp_matrices->probs;
+  p2    = ref->exp_matrices->probs;
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++)
+      ck_assert(fabs(p1[iindx[i] - j] - p2[iindx[i] - j]) < 1e-9);
+
+  free(s1);
+  free(s2);
+}
+
 /* end of prologue */
 
 #suite Constraints
@@ -450,5 +493,217 @@ writeTempFile(char        *tempfile,
 }
 
 
+#test test_vrna_sc_SHAPE_fold_batch
+{
+  const char              *sequence = "GGGAUCCGAAAGUUCGCAUAGCAAAUGCUAAAGCGAUCUUAAGCGGUACCAAAUCCC";
+  char                    *structure;
+  unsigned int            i, j, k, n;
+  double                  *reactivities, *energies, mfe, G;
+  vrna_sc_SHAPE_profile_t profiles[3];
+  vrna_sc_SHAPE_fold_t    *results;
+  vrna_fold_compound_t    *fc, *ref;
+
+  n             = strlen(sequence);
+  structure     = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  reactivities  = (double *)vrna_alloc(sizeof(double) * (n + 1));
+  energies      = (double *)vrna_alloc(sizeof(double) * (n + 1));
+
+  for (i = 1; i <= n; i++) {
+    reactivities[i] = (double)((i * 37) % 11) / 5.;
+    energies[i]     = ((i % 3) == 0) ? -0.8 : 0.;
+  }
+
+  profiles[0].reactivities      = reactivities;
+  profiles[0].method            = 'D';
+  profiles[0].p1                = 1.8;
+  profiles[0].p2                = -0.6;
+  profiles[0].shape_conversion  = NULL;
+  profiles[1].reactivities      = reactivities;
+  profiles[1].method            = 'Z';
+  profiles[1].p1                = 0.89;
+  profiles[1].p2                = 0.;
+  profiles[1].shape_conversion  = NULL;
+  profiles[2].reactivities      = energies;
+  profiles[2].method            = 'W';
+  profiles[2].p1                = 0.;
+  profiles[2].p2                = 0.;
+  profiles[2].shape_conversion  = NULL;
+
+  /* hard constraints are shared, soft constraints of the fold compound are ignored */
+  fc = vrna_fold_compound(sequence, NULL, VRNA_OPTION_DEFAULT);
+  vrna_hc_add_up(fc, 20, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+  vrna_sc_add_up(fc, 40, -5., VRNA_OPTION_DEFAULT);
+
+  results = vrna_sc_SHAPE_fold_batch(fc, profiles, 3, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  ck_assert(results != NULL);
+
+  for (k = 0; k < 3; k++) {
+    ref = vrna_fold_compound(sequence, NULL, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    vrna_hc_add_up(ref, 20, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+
+    switch (profiles[k].method) {
+      case 'D':
+        vrna_sc_add_SHAPE_deigan(ref, reactivities, 1.8, -0.6, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+        break;
+
+      case 'Z':
+        vrna_sc_add_SHAPE_zarringhalam(ref,
+                                       reactivities,
+                                       0.89,
+                                       0.5,
+                                       "O",
+                                       VRNA_OPTION_MFE | VRNA_OPTION_PF);
+        break;
+
+      case 'W':
+        for (i = 1; i <= n; i++)
+          vrna_sc_add_up(ref, i, energies[i], VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+        break;
+    }
+
+    /* apply the constraints like vrna_sc_SHAPE_fold_batch() does */
+    vrna_hc_prepare(ref, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+    vrna_sc_prepare(ref, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+    mfe = (double)vrna_mfe(ref, structure);
+    vrna_exp_params_rescale(ref, &mfe);
+    G = (double)vrna_pf(ref, NULL);
+
+    ck_assert_int_eq(results[k].status, 1);
+    ck_assert_str_eq(results[k].structure, structure);
+    ck_assert(deltaCompare(results[k].mfe, mfe));
+    ck_assert(fabs(results[k].ensemble_energy - G) < 1e-6);
+    ck_assert(results[k].probs != NULL);
+
+    for (i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++)
+        ck_assert(fabs(results[k].probs[ref->iindx[i] - j] - ref->exp_matrices->probs[ref->iindx[i] - j]) < 1e-9);
+
+    vrna_fold_compound_free(ref);
+  }
+
+  vrna_sc_SHAPE_fold_batch_free(results, 3);
+  vrna_fold_compound_free(fc);
+  free(structure);
+  free(reactivities);
+  free(energies);
+}
+
+
+#tcase  HardConstraints
+
+#test test_vrna_hc_context_band
+{
+  const char            *sequence = "GGGAAAUCCCGCGAUAGCGCAUAGCUAGCUAGCGGCAUUUCGCCGGAUCC";
+  char                  structure[51];
+  unsigned int          i, j, n, span;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *ref;
+  short                 *pt;
+
+  n     = strlen(sequence);
+  span  = 20;
+
+  /* reference with the full matrix of pair contexts */
+  vrna_md_set_default(&md);
+  ref = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+  md.max_bp_span  = span;
+  fc              = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+  ck_assert_int_eq(fc->hc->span, span);
+
+  /* the same constraints, including pairs that exceed the band */
+  vrna_hc_add_bp(ref, 2, 48, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+  vrna_hc_add_bp(fc, 2, 48, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+  vrna_hc_add_bp(ref, 12, 19, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  vrna_hc_add_bp(fc, 12, 19, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  vrna_hc_add_up(ref, 30, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  vrna_hc_add_up(fc, 30, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+
+  vrna_hc_prepare(ref, VRNA_OPTION_MFE);
+  vrna_hc_prepare(fc, VRNA_OPTION_MFE);
+
+  for (i = 1; i <= n; i++) {
+    ck_assert_int_eq(vrna_hc_context(fc->hc, i, i), vrna_hc_context(ref->hc, i, i));
+
+    for (j = i + 1; j <= n; j++) {
+      ck_assert_int_eq(vrna_hc_context(fc->hc, i, j), vrna_hc_context(fc->hc, j, i));
+
+      if ((j - i < span) ||
+          ((i == 2) && (j == 48)))
+        ck_assert_int_eq(vrna_hc_context(fc->hc, i, j), vrna_hc_context(ref->hc, i, j));
+      else
+        ck_assert_int_eq(vrna_hc_context(fc->hc, i, j), VRNA_CONSTRAINT_CONTEXT_NONE);
+    }
+  }
+
+  /* the enforced pair and the unpaired nucleotide end up in the MFE structure */
+  (void)vrna_mfe(fc, structure);
+  pt = vrna_ptable(structure);
+
+  ck_assert_int_eq(pt[12], 19);
+  ck_assert_int_eq(pt[30], 0);
+
+  for (i = 1; i <= n; i++)
+    ck_assert((pt[i] == 0) || (abs(pt[i] - (int)i) < (int)span));
+
+  free(pt);
+  vrna_fold_compound_free(fc);
+  vrna_fold_compound_free(ref);
+}
+
+
+#test test_vrna_mx_incremental_constraints
+{
+  const char            *sequence = "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUGAGGUCGCUGAUUCGAAUUCAGCAUAGCCCA";
+  unsigned int          i, n;
+  FLT_OR_DBL            *up;
+  vrna_fold_compound_t  *fc, *ref;
+
+  n   = strlen(sequence);
+  fc  = vrna_fold_compound(sequence, NULL, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+
+  ck_assert_int_eq(vrna_mx_incremental(fc, VRNA_OPTION_MFE | VRNA_OPTION_PF, 1), 1);
+
+  (void)vrna_mfe(fc, NULL);
+  (void)vrna_pf(fc, NULL);
+
+  /* hard constraints change the matrices of a subsegment only */
+  vrna_hc_add_bp(fc, 50, 63, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  vrna_hc_add_up(fc, 45, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+
+  ref = vrna_fold_compound(sequence, NULL, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  vrna_hc_add_bp(ref, 50, 63, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+  vrna_hc_add_up(ref, 45, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+
+  vrna_hc_prepare(fc, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  vrna_hc_prepare(ref, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  compareFills(fc, ref);
+
+  ck_assert(fc->exp_matrices->probs[fc->iindx[50] - 63] > 0.99);
+
+  for (i = 1; i <= n; i++)
+    if (i != 45)
+      ck_assert(fc->exp_matrices->probs[fc->iindx[MIN2(i, 45)] - MAX2(i, 45)] == 0.);
+
+  /* so do soft constraints */
+  up      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
+  up[60]  = -2.5;
+  up[61]  = -1.5;
+
+  vrna_sc_set_up(fc, up, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  vrna_sc_set_up(ref, up, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  compareFills(fc, ref);
+
+  free(up);
+  vrna_fold_compound_free(fc);
+  vrna_fold_compound_free(ref);
+}
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -1,11 +1,96 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
 #include <math.h>
 
 #include <ViennaRNA/data_structures.h>
 #include <ViennaRNA/utils/strings.h>
 #include <ViennaRNA/constraints/soft.h>
+#include <ViennaRNA/params/basic.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/heat_capacity.h>
+#include <ViennaRNA/perturbation_fold.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int
+sc_zero(int           i,
+        int           j,
+        int           k,
+        int           l,
+        unsigned char d,
+        void          *data)
+{
+  return 0;
+}
+
+
+static FLT_OR_DBL
+sc_exp_one(int            i,
+           int            j,
+           int            k,
+           int            l,
+           unsigned char  d,
+           void           *data)
+{
+  return 1.;
+}
+
+
+/* objective values reported by the minimizer, one per iteration */
+static double perturbation_scores[1024];
+static int    perturbation_calls;
+
+
+static void
+perturbation_progress(int     iteration,
+                      double  score,
+                      double  *epsilon)
+{
+  if (perturbation_calls < 1024)
+    perturbation_scores[perturbation_calls] = score;
+
+  perturbation_calls++;
+}
+
+
+static double *
+perturbation_lbfgs(const char *seq,
+                   double     *q,
+                   int        threads)
+{
+  int                   i, n;
+  double                *epsilon;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  vrna_md_set_default(&md);
+  fc      = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  n       = (int)fc->length;
+  epsilon = (double *)vrna_alloc(sizeof(double) * (n + 1));
+
+  perturbation_calls = 0;
+  vrna_sc_minimize_pertubation(fc, q, VRNA_OBJECTIVE_FUNCTION_QUADRATIC, 1., 1.,
+                               VRNA_MINIMIZER_LBFGS, 0, epsilon,
+                               0.01, 1e-15, 1e-3, 1e-4,
+                               perturbation_progress);
+
+  for (i = 1; i <= n; i++)
+    ck_assert(!isnan(epsilon[i]));
+
+  vrna_fold_compound_free(fc);
+
+  return epsilon;
+}
+
 
 #suite Constraints
 
@@ -218,5 +303,193 @@
 }
 
 
+#test test_vrna_sc_heat_capacity
+{
+  const char            *seq = "GGGGAAAACCCCUAUAGCGCAUAUUCGCGGAAACCGUAAGG";
+  int                   i, k, p;
+  double                mfe, F[3], G_before, G_after, hc_ref;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *ref;
+  vrna_heat_capacity_t  *curve;
+
+  vrna_md_set_default(&md);
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  for (i = 1; i <= fc->length; i++)
+    vrna_sc_add_up(fc, i, -0.5, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  G_before = (double)vrna_pf(fc, NULL);
+
+  curve = vrna_heat_capacity(fc, 30., 40., 1., 1);
+
+  ck_assert(curve != NULL);
+
+  /* compare against the second derivative of ensemble free energies computed from scratch */
+  for (k = 0; curve[k].temperature >= -K0; k++) {
+    for (i = 0; i < 3; i++) {
+      md.temperature  = curve[k].temperature - 1. + i;
+      ref             = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+      for (p = 1; p <= ref->length; p++)
+        vrna_sc_add_up(ref, p, -0.5, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+      mfe = (double)vrna_mfe(ref, NULL);
+      vrna_exp_params_rescale(ref, &mfe);
+      F[i] = (double)vrna_pf(ref, NULL);
+
+      vrna_fold_compound_free(ref);
+    }
+
+    hc_ref = -(F[0] - 2. * F[1] + F[2]) * (curve[k].temperature + K0);
+
+    ck_assert(fabs(curve[k].heat_capacity - hc_ref) < 0.01);
+  }
+
+  ck_assert_int_eq(k, 11);
+
+  /* the soft constraints must be restored for the original temperature */
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  G_after = (double)vrna_pf(fc, NULL);
+
+  ck_assert(fabs(G_after - G_before) < 1e-6);
+
+  free(curve);
+  vrna_fold_compound_free(fc);
+}
+
+
+#test test_vrna_sc_interior_loop_tables
+{
+  const char            *seq = "GGGAUCCGAAAGUUCGCAUAGCAAAUGCUAAAGCGAUCUUAAGCGGUACCAAAUCCC";
+  char                  *s1, *s2;
+  unsigned int          i, j, n, u, w;
+  double                e1, e2;
+  FLT_OR_DBL            *p1, *p2;
+  vrna_fold_compound_t  *fc, *ref;
+
+  n   = strlen(seq);
+  w   = MAXLOOP + 1;
+  s1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s2  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  fc  = vrna_fold_compound(seq, NULL, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  ref = vrna_fold_compound(seq, NULL, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  for (i = 1; i <= n; i++) {
+    vrna_sc_add_up(fc, i, -1.0 * (i % 2), VRNA_OPTION_MFE | VRNA_OPTION_PF);
+    vrna_sc_add_up(ref, i, -1.0 * (i % 2), VRNA_OPTION_MFE | VRNA_OPTION_PF);
+  }
+
+  /* user-defined callbacks disable the flat tables in the interior loop recursions */
+  vrna_sc_add_f(ref, &sc_zero);
+  vrna_sc_add_exp_f(ref, &sc_exp_one);
+
+  e1  = vrna_mfe(fc, s1);
+  e2  = vrna_mfe(ref, s2);
+
+  ck_assert_str_eq(s1, s2);
+  ck_assert(fabs(e1 - e2) < 1e-6);
+
+  e1  = vrna_pf(fc, NULL);
+  e2  = vrna_pf(ref, NULL);
+
+  ck_assert(fabs(e1 - e2) < 1e-6);
+
+  p1  = fc->exp_matrices->probs;
+  p2  = ref->exp_matrices->probs;
+
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++)
+      ck_assert(fabs(p1[fc->iindx[i] - j] - p2[fc->iindx[i] - j]) < 1e-9);
+
+  /* the tables hold the contributions of the unpaired stretches next to inner pairs */
+  ck_assert(fc->sc->energy_il5 != NULL);
+  ck_assert(fc->sc->exp_energy_il5 != NULL);
+
+  for (i = 0; i <= n + 1; i++)
+    for (u = 1; u < w; u++) {
+      if (i + u <= n) {
+        ck_assert_int_eq(fc->sc->energy_il5[i * w + u], fc->sc->energy_up[i + 1][u]);
+        ck_assert(fc->sc->exp_energy_il5[i * w + u] == fc->sc->exp_energy_up[i + 1][u]);
+      }
+
+      if (u < i) {
+        ck_assert_int_eq(fc->sc->energy_il3[i * w + u], fc->sc->energy_up[i - u][u]);
+        ck_assert(fc->sc->exp_energy_il3[i * w + u] == fc->sc->exp_energy_up[i - u][u]);
+      }
+    }
+
+  free(s1);
+  free(s2);
+  vrna_fold_compound_free(fc);
+  vrna_fold_compound_free(ref);
+}
+
+
+#tcase  Perturbation
+#test test_vrna_sc_minimize_pertubation_lbfgs
+{
+  const char  *seq = "GGGGAAAACCCCUAUAGCGCAUAUUCGCGGAAACCG";
+  int         i, k, n, threads, calls;
+  double      *q, *eps_single, *eps_multi;
+
+  n       = (int)strlen(seq);
+  q       = (double *)vrna_alloc(sizeof(double) * (n + 1));
+  threads = 1;
+
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  /* probing data that disagrees with the unperturbed ensemble, some positions missing */
+  for (i = 1; i <= n; i++)
+    q[i] = (i % 7 == 0) ? -1. : ((i % 3) ? 0.9 : 0.1);
+
+  eps_single  = perturbation_lbfgs(seq, q, 1);
+  calls       = perturbation_calls;
+
+  ck_assert(calls > 1);
+
+  /* only accepted steps are reported, so the objective never increases */
+  for (k = 0; k < calls; k++) {
+    ck_assert(!isnan(perturbation_scores[k]));
+    if (k > 0)
+      ck_assert(perturbation_scores[k] <= perturbation_scores[k - 1]);
+  }
+
+  ck_assert(perturbation_scores[calls - 1] < perturbation_scores[0]);
+
+  /* the parallel line search must pick the very same steps */
+  eps_multi = perturbation_lbfgs(seq, q, (threads > 1) ? threads : 4);
+
+  ck_assert_int_eq(perturbation_calls, calls);
+  for (i = 1; i <= n; i++)
+    ck_assert(eps_single[i] == eps_multi[i]);
+
+  free(eps_single);
+  free(eps_multi);
+
+  /* without any data, the gradient at epsilon = 0 vanishes */
+  for (i = 1; i <= n; i++)
+    q[i] = -1.;
+
+  eps_single = perturbation_lbfgs(seq, q, 1);
+
+  ck_assert_int_eq(perturbation_calls, 1);
+  ck_assert(perturbation_scores[0] == 0.);
+  for (i = 1; i <= n; i++)
+    ck_assert(eps_single[i] == 0.);
+
+  free(eps_single);
+  free(q);
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -10,10 +10,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 #include <ViennaRNA/fold_compound.h>
 #include <ViennaRNA/utils/structures.h>
+#include <ViennaRNA/subopt.h>
 #include "ViennaRNA/eval.h"
 
 typedef struct {
@@ -25,7 +27,7 @@ typedef struct {
 
 START_TEST(eval_structure)
 {
-#line 19
+#line 21
 {
   rnaStr  strList[20];
 
@@ -160,6 +162,74 @@ START_TEST(eval_structure)
 }
 
 
+
+}
+END_TEST
+
+START_TEST(eval_structure_pt_batch)
+{
+#line 157
+{
+  const char            *alignment[] = {
+    "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUG",
+    "GGGCUAUUAGCUCAG-UGGUUAGAGCGCACCCCUGA-AAGGGUG",
+    "GGGCUAUAAGCUCAGUUGG-UAGAGCGCACCUCUGAUAAGGGUG",
+    NULL
+  };
+  unsigned int          f, k, n, num;
+  int                   *energies;
+  short                 *pt, *pts;
+  vrna_subopt_solution_t *sols;
+  vrna_fold_compound_t  *fc[3];
+
+  /* all three fold compounds cover the same 44 nucleotides */
+  fc[0] = vrna_fold_compound("GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUG",
+                             NULL,
+                             VRNA_OPTION_DEFAULT);
+  fc[1] = vrna_fold_compound("GGGCUAUUAGCUCAGUUGGUUAG&AGCGCACCCCUGAUAAGGGUG",
+                             NULL,
+                             VRNA_OPTION_DEFAULT);
+  fc[2] = vrna_fold_compound_comparative(alignment,
+                                         NULL,
+                                         VRNA_OPTION_DEFAULT);
+
+  n     = fc[0]->length;
+  sols  = vrna_subopt(fc[0], 300, 0, NULL);
+
+  for (num = 0; sols[num].structure; num++);
+
+  ck_assert(num > 1);
+
+  /* pack the pair tables, the batch evaluation shares loops among them */
+  pts = (short *)vrna_alloc(sizeof(short) * (n + 1) * num);
+
+  for (k = 0; k < num; k++) {
+    pt = vrna_ptable(sols[k].structure);
+    memcpy(pts + k * (n + 1), pt, sizeof(short) * (n + 1));
+    free(pt);
+  }
+
+  for (f = 0; f < 3; f++) {
+    ck_assert_int_eq(fc[f]->length, n);
+
+    energies = vrna_eval_structure_pt_batch(fc[f], pts, num);
+
+    ck_assert(energies != NULL);
+
+    for (k = 0; k < num; k++)
+      ck_assert_int_eq(energies[k], vrna_eval_structure_pt(fc[f], pts + k * (n + 1)));
+
+    free(energies);
+    vrna_fold_compound_free(fc[f]);
+  }
+
+  for (k = 0; k < num; k++)
+    free(sols[k].structure);
+
+  free(sols);
+  free(pts);
+}
+
 }
 END_TEST
 
@@ -171,11 +241,12 @@ int main(void)
     int nf;
 
     /* User-specified pre-run code */
-#line 154
+#line 219
     srunner_set_tap(sr, "-");
 
     suite_add_tcase(s1, tc1_1);
     tcase_add_test(tc1_1, eval_structure);
+    tcase_add_test(tc1_1, eval_structure_pt_batch);
 
     srunner_run_all(sr, CK_ENV);
     nf = srunner_ntests_failed(sr);
@@ -1,5 +1,9 @@
 #include <stdio.h>      /* printf, scanf, NULL */
 #include <stdlib.h>     /* malloc, free, rand */
+#include <math.h>       /* fabs */
+#include <string.h>     /* strlen */
+#include <unistd.h>     /* unlink, rmdir */
+#include <dirent.h>     /* opendir, readdir */
 
 #include <ViennaRNA/fold_vars.h>
 #include <ViennaRNA/data_structures.h>
@@ -8,6 +12,43 @@
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/fold.h>
 #include <ViennaRNA/part_func.h>
+#include <ViennaRNA/heat_capacity.h>
+#include <ViennaRNA/part_func_up.h>
+#include <ViennaRNA/params/constants.h>
+#include <ViennaRNA/alphabet.h>
+#include <ViennaRNA/part_func_window.h>
+#include <ViennaRNA/accessibility.h>
+#include <ViennaRNA/params/basic.h>
+#include <ViennaRNA/params/salt.h>
+#include <ViennaRNA/utils/alignments.h>
+#include <ViennaRNA/gquad.h>
+#include <ViennaRNA/dp_matrices.h>
+#include <ViennaRNA/2Dfold.h>
+#include <ViennaRNA/2Dpfold.h>
+#include <ViennaRNA/eval.h>
+
+struct up_data {
+  double        **up;
+  unsigned int  ulength;
+};
+
+
+static void
+store_up(FLT_OR_DBL   *pr,
+         int          pr_size,
+         int          i,
+         int          max,
+         unsigned int type,
+         void         *data)
+{
+  int             u;
+  struct up_data  *d = (struct up_data *)data;
+
+  if ((type & VRNA_PROBS_WINDOW_UP) && ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP))
+    for (u = 1; (u <= pr_size) && (u <= (int)d->ulength); u++)
+      d->up[i][u] = pr[u];
+}
+
 
 #suite  MFE_Prediction
 
@@ -55,6 +96,183 @@
   vrna_fold_compound_free(vc);
 }
 
+#tcase Multiple_Temperatures
+
+#test test_pf_temperatures
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *ref;
+  const char            *sequences[] = {
+    "GGGGAAAACCCCUAUAGCGC",
+    "UCCAGAAACGAUCAUUUAGCAGAGCACCGUGUACUUUCCAUCUUAAUCUCUGUUCGGCUG"
+  };
+  const int             dangles[] = {
+    0, 2
+  };
+  double                temperatures[18], G[18], mfe, G_ref;
+  int                   s, d, t;
+
+  for (t = 0; t < 18; t++)
+    temperatures[t] = 70. - 4.5 * t;
+
+  for (s = 0; s < 2; s++) {
+    for (d = 0; d < 2; d++) {
+      vrna_md_set_default(&md);
+      md.dangles  = dangles[d];
+      fc          = vrna_fold_compound(sequences[s], &md, VRNA_OPTION_DEFAULT);
+
+      ck_assert_int_eq(vrna_pf_temperatures(fc, temperatures, 18, G), 1);
+
+      for (t = 0; t < 18; t++) {
+        md.temperature  = temperatures[t];
+        ref             = vrna_fold_compound(sequences[s], &md, VRNA_OPTION_DEFAULT);
+        mfe             = (double)vrna_mfe(ref, NULL);
+        vrna_exp_params_rescale(ref, &mfe);
+        G_ref = (double)vrna_pf(ref, NULL);
+
+        ck_assert(fabs(G[t] - G_ref) < 1e-4);
+
+        vrna_fold_compound_free(ref);
+      }
+
+      vrna_fold_compound_free(fc);
+    }
+  }
+}
+
+#tcase Heat_Capacity
+
+#test test_heat_capacity_peaks
+{
+  vrna_heat_capacity_t  curve[22], *peaks;
+  double                T;
+  int                   i;
+
+  /*
+   *  two parabolic peaks at 6.3 and 15.6 degrees Celsius, and a
+   *  rising flank at the upper boundary that must not be reported
+   */
+  for (i = 0; i <= 20; i++) {
+    T                       = (double)i;
+    curve[i].temperature    = (float)T;
+    curve[i].heat_capacity  = (float)MAX2(10. - (T - 6.3) * (T - 6.3),
+                                          4. - 0.5 * (T - 15.6) * (T - 15.6));
+    if (i > 18)
+      curve[i].heat_capacity = (float)(0.5 * (T - 18.) * (T - 18.));
+    else if (curve[i].heat_capacity < 0.)
+      curve[i].heat_capacity = 0.;
+  }
+
+  curve[21].temperature   = -K0 - 1.;
+  curve[21].heat_capacity = -K0 - 1.;
+
+  peaks = vrna_heat_capacity_peaks(curve);
+
+  ck_assert(peaks != NULL);
+  ck_assert(fabs(peaks[0].temperature - 6.3) < 1e-4);
+  ck_assert(fabs(peaks[0].heat_capacity - 10.) < 1e-4);
+  ck_assert(fabs(peaks[1].temperature - 15.6) < 1e-4);
+  ck_assert(fabs(peaks[1].heat_capacity - 4.) < 1e-4);
+  ck_assert(peaks[2].temperature < -K0);
+
+  free(peaks);
+
+  ck_assert(vrna_heat_capacity_peaks(NULL) == NULL);
+}
+
+#tcase Interaction
+
+#test test_up_engine_interact
+{
+  char              target[] = "UCCAGAAACGAUCAUUUAGCAGAGCACCGUGUACUUUCCAUCUUAAUCUCUGUUCGGCUG";
+  const char        *queries[] = {
+    "GAUGGAAAGUACACGGUGCU", "AGCUGAUCGUUUCUGG"
+  };
+  const double      p_target[] = {
+    1., 0.5
+  };
+  const int         incr[][2] = {
+    { 0, 0 }, { 3, 2 }
+  };
+  int               c, q, i, u, w, n1, n2;
+  double            kT;
+  pu_contrib        *p_c[2], *p_c2;
+  interact          *res[2], *single, **multi;
+  vrna_up_engine_t  *engines[2];
+
+  w   = 10;
+  n1  = (int)strlen(target);
+  n2  = (int)strlen(queries[0]);
+  kT  = (K0 + 37.) * GASCONST / 1000.;
+
+  /*
+   *  uniform probabilities of being unpaired only shift the interaction
+   *  energies by the respective opening energy, but neither change the
+   *  optimal interaction site nor the probabilities of interaction
+   */
+  p_c2 = get_pu_contrib_struct(n2, w);
+  for (i = 1; i <= n2; i++)
+    for (u = 0; u <= w; u++)
+      p_c2->E[i][u] = 0.25;
+
+  for (c = 0; c < 2; c++) {
+    for (q = 0; q < 2; q++) {
+      p_c[q] = get_pu_contrib_struct(n1, w + incr[c][0] + incr[c][1]);
+      for (i = 1; i <= n1; i++)
+        for (u = 0; u <= p_c[q]->w; u++) {
+          p_c[q]->H[i][u] = 0.1 * p_target[q];
+          p_c[q]->I[i][u] = 0.2 * p_target[q];
+          p_c[q]->M[i][u] = 0.3 * p_target[q];
+          p_c[q]->E[i][u] = 0.4 * p_target[q];
+        }
+
+      engines[q] = vrna_up_engine(target, p_c[q], w, incr[c][0], incr[c][1], NULL);
+      ck_assert(engines[q] != NULL);
+
+      res[q] = vrna_up_engine_interact(engines[q], queries[0], (q) ? p_c2 : NULL);
+      ck_assert(res[q] != NULL);
+    }
+
+    ck_assert(fabs(res[0]->Gikjl - res[0]->Gikjl_wo) < 1e-9);
+    ck_assert(fabs(res[1]->Gikjl - res[1]->Gikjl_wo - kT * log(2. * 4.)) < 1e-9);
+    ck_assert(fabs(res[1]->Gikjl_wo - res[0]->Gikjl_wo) < 1e-9);
+    ck_assert_int_eq(res[1]->i, res[0]->i);
+    ck_assert_int_eq(res[1]->j, res[0]->j);
+    ck_assert_int_eq(res[1]->k, res[0]->k);
+    ck_assert_int_eq(res[1]->l, res[0]->l);
+
+    for (i = 1; i <= n1; i++)
+      ck_assert(fabs(res[1]->Pi[i] - res[0]->Pi[i]) < 1e-9);
+
+    vrna_up_interact_free(res[0]);
+    vrna_up_interact_free(res[1]);
+
+    /* the batch interface computes the same interactions */
+    multi = vrna_up_engine_interact_multi(engines, 2, queries, NULL, 2);
+    ck_assert(multi != NULL);
+
+    for (q = 0; q < 4; q++) {
+      single = vrna_up_engine_interact(engines[q / 2], queries[q % 2], NULL);
+      ck_assert(multi[q]->Gikjl == single->Gikjl);
+      ck_assert(multi[q]->Gikjl_wo == single->Gikjl_wo);
+      ck_assert_int_eq(multi[q]->k, single->k);
+      ck_assert_int_eq(multi[q]->i, single->i);
+      vrna_up_interact_free(single);
+      vrna_up_interact_free(multi[q]);
+    }
+
+    free(multi);
+
+    for (q = 0; q < 2; q++) {
+      vrna_up_engine_free(engines[q]);
+      free_pu_contrib(p_c[q]);
+    }
+  }
+
+  free_pu_contrib(p_c2);
+}
+
+
 #suite  Constraints_Implementation
 
 #tcase  Soft_Constraints
@@ -144,5 +362,572 @@
 }
 
 
+
+#tcase  Incremental
+
+#test test_mx_incremental_params
+{
+  const char            *sequence = "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUGAGGUCGCUGAUUCGAAUUCAGCAUAGCCCA";
+  char                  *s_inc, *s_ref;
+  unsigned int          n;
+  double                e_inc, e_ref;
+  vrna_md_t             md;
+  vrna_param_t          *P;
+  vrna_exp_param_t      *pf;
+  vrna_fold_compound_t  *fc, *ref;
+
+  n     = strlen(sequence);
+  s_inc = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  s_ref = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  vrna_md_set_default(&md);
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+
+  ck_assert_int_eq(vrna_mx_incremental(fc, VRNA_OPTION_MFE | VRNA_OPTION_PF, 1), 1);
+
+  (void)vrna_mfe(fc, s_inc);
+  (void)vrna_pf(fc, NULL);
+
+  /*
+   *  replace the energy parameters directly, as vrna_pf_dimer_grid() does,
+   *  but keep the scaling factor, such that only the parameters themselves
+   *  outdate the matrices
+   */
+  md.temperature  = 55.;
+  P               = fc->params;
+  pf              = fc->exp_params;
+  fc->params      = vrna_params(&md);
+  fc->exp_params  = vrna_exp_params(&md);
+
+  fc->exp_params->pf_scale = pf->pf_scale;
+  vrna_exp_params_rescale(fc, NULL);
+
+  ref = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  vrna_exp_params_subst(ref, fc->exp_params);
+
+  e_inc = vrna_mfe(fc, s_inc);
+  e_ref = vrna_mfe(ref, s_ref);
+
+  ck_assert_str_eq(s_inc, s_ref);
+  ck_assert(fabs(e_inc - e_ref) < 1e-6);
+
+  e_inc = vrna_pf(fc, NULL);
+  e_ref = vrna_pf(ref, NULL);
+
+  ck_assert(fabs(e_inc - e_ref) < 1e-6);
+
+  free(P);
+  free(pf);
+  free(s_inc);
+  free(s_ref);
+  vrna_fold_compound_free(fc);
+  vrna_fold_compound_free(ref);
+}
+
+#tcase  Salt_Grid
+
+#test test_pf_dimer_grid
+{
+  const char            *sequence = "ACGAUCGGCUAGCUAA&UUAGCUAGCCGAUCGU";
+  double                temperatures[] = {
+    24.5, 37., 51.3
+  };
+  double                salt[] = {
+    0.05, 0.3, 1.021
+  };
+  double                mfe;
+  unsigned int          t, s, k;
+  vrna_md_t             md;
+  vrna_dimer_pf_t       F;
+  vrna_dimer_grid_t     *grid;
+  vrna_fold_compound_t  *fc, *ref;
+
+  vrna_md_set_default(&md);
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+  grid = vrna_pf_dimer_grid(fc, temperatures, 3, salt, 3);
+  ck_assert(grid != NULL);
+
+  /* each grid point equals a dimer computation from scratch at the same conditions */
+  for (t = 0; t < 3; t++)
+    for (s = 0; s < 3; s++) {
+      k               = t * 3 + s;
+      md.temperature  = temperatures[t];
+      md.salt         = salt[s];
+      md.compute_bpp  = 0;
+      ref             = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+      mfe             = (double)vrna_mfe(ref, NULL);
+      vrna_exp_params_rescale(ref, &mfe);
+      F = vrna_pf_dimer(ref, NULL);
+
+      ck_assert(fabs(grid[k].temperature - temperatures[t]) < 1e-12);
+      ck_assert(fabs(grid[k].salt - salt[s]) < 1e-12);
+      ck_assert(fabs(grid[k].mfe - mfe) < 1e-6);
+      ck_assert(fabs(grid[k].F.F0AB - F.F0AB) < 1e-6);
+      ck_assert(fabs(grid[k].F.FAB - F.FAB) < 1e-6);
+      ck_assert(fabs(grid[k].F.FcAB - F.FcAB) < 1e-6);
+      ck_assert(fabs(grid[k].F.FA - F.FA) < 1e-6);
+      ck_assert(fabs(grid[k].F.FB - F.FB) < 1e-6);
+      ck_assert(fabs(grid[k].dG - (F.FcAB - F.FA - F.FB)) < 1e-6);
+
+      vrna_fold_compound_free(ref);
+    }
+
+  free(grid);
+
+  /* without salt concentrations, that of the fold compound is used */
+  grid = vrna_pf_dimer_grid(fc, temperatures + 1, 1, NULL, 0);
+  ck_assert(grid != NULL);
+  ck_assert(fabs(grid[0].salt - fc->params->model_details.salt) < 1e-12);
+
+  md.temperature  = temperatures[1];
+  md.salt         = fc->params->model_details.salt;
+  ref             = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe             = (double)vrna_mfe(ref, NULL);
+  vrna_exp_params_rescale(ref, &mfe);
+  F = vrna_pf_dimer(ref, NULL);
+
+  ck_assert(fabs(grid[0].F.FcAB - F.FcAB) < 1e-6);
+  ck_assert(fabs(grid[0].dG - (F.FcAB - F.FA - F.FB)) < 1e-6);
+
+  free(grid);
+  vrna_fold_compound_free(ref);
+  vrna_fold_compound_free(fc);
+}
+
+#test test_params_salt
+{
+  double                  temperatures[] = {
+    24.5, 37., 51.3
+  };
+  double                  salt[] = {
+    0.05, 0.3, 1.021
+  };
+  int                     L;
+  unsigned int            k;
+  double                  T;
+  vrna_md_t               md, md_ref;
+  vrna_param_t            *P, *P_ref;
+  vrna_exp_param_t        *pf, *pf_ref;
+  vrna_salt_correction_t  *corr;
+
+  vrna_md_set_default(&md);
+  md.dangles = 2;
+
+  corr = vrna_salt_corrections(&md, temperatures, 3, salt, 3);
+  ck_assert(corr != NULL);
+
+  /* precomputed corrections yield the same parameters as vrna_params() with md.salt */
+  for (k = 0; k < 9; k++) {
+    ck_assert(fabs(corr[k].temperature - temperatures[k / 3]) < 1e-12);
+    ck_assert(fabs(corr[k].salt - salt[k % 3]) < 1e-12);
+
+    md_ref              = md;
+    md_ref.temperature  = temperatures[k / 3];
+    md_ref.salt         = salt[k % 3];
+
+    /* the shared terms of the grid don't change the corrections of each point */
+    if (salt[k % 3] != VRNA_MODEL_DEFAULT_SALT) {
+      T = md_ref.temperature + K0;
+      for (L = 1; L <= MAXLOOP + 1; L++)
+        ck_assert(fabs(corr[k].loop[L] -
+                       vrna_salt_loop(L, md_ref.salt, T, md_ref.backbone_length)) < 1e-6);
+
+      ck_assert_int_eq(corr[k].stack, vrna_salt_stack(md_ref.salt, T, md_ref.helical_rise));
+      ck_assert_int_eq(corr[k].duplex_init, vrna_salt_duplex_init(&md_ref));
+    }
+
+    P       = vrna_params_salt(&md, corr + k);
+    P_ref   = vrna_params(&md_ref);
+    pf      = vrna_exp_params_salt(&md, corr + k);
+    pf_ref  = vrna_exp_params(&md_ref);
+
+    /* apart from the identifier of the parameter set */
+    P_ref->id = P->id;
+    ck_assert(memcmp(P, P_ref, sizeof(vrna_param_t)) == 0);
+    ck_assert(memcmp(pf, pf_ref, sizeof(vrna_exp_param_t)) == 0);
+
+    free(P);
+    free(P_ref);
+    free(pf);
+    free(pf_ref);
+  }
+
+  free(corr);
+}
+
+#tcase  Covariance
+
+#test test_pscore_alignment
+{
+  const char            *pairs[] = {
+    "GC", "CG", "AU", "UA", "GU", "UG"
+  };
+  char                  **alignment;
+  int                   i, j, n, n_seq, s, turn, span, pscore;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  /* more sequences than fit into a single bit vector word */
+  n     = 60;
+  n_seq = 150;
+
+  srand(4711);
+  alignment = (char **)vrna_alloc(sizeof(char *) * (n_seq + 1));
+  for (s = 0; s < n_seq; s++) {
+    alignment[s] = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    for (i = 0; i < n; i++)
+      alignment[s][i] = "ACGU-"[rand() % 5];
+
+    /* two helices with compensatory and inconsistent mutations */
+    for (i = 0; i < 8; i++) {
+      const char *bp = pairs[rand() % 6];
+
+      if (rand() % 10 == 0)
+        bp = "CA";
+
+      alignment[s][i]           = bp[0];
+      alignment[s][n - 1 - i]   = bp[1];
+      alignment[s][20 + i]      = bp[0];
+      alignment[s][40 - 1 - i]  = bp[1];
+    }
+
+    /* unknown nucleotides at the ends of some sequences */
+    if (s % 7 == 0)
+      for (i = 0; i < 1 + s % 5; i++)
+        alignment[s][i] = '~';
+
+    if (s % 11 == 0)
+      for (i = n - 1; i > n - 4; i--)
+        alignment[s][i] = '~';
+  }
+
+  /* a column pair of gaps only */
+  for (s = 0; s < n_seq; s++)
+    alignment[s][10] = alignment[s][50] = '-';
+
+  for (span = 0; span < 2; span++) {
+    vrna_md_set_default(&md);
+    md.max_bp_span  = (span) ? 25 : -1;
+    turn            = md.min_loop_size;
+
+    fc = vrna_fold_compound_comparative((const char **)alignment, &md,
+                                        VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    ck_assert(fc != NULL);
+    ck_assert(fc->pscore != NULL);
+
+    for (i = 1; i < n; i++)
+      for (j = i + turn + 1; j <= n; j++) {
+        pscore = vrna_pscore(fc, i, j);
+        ck_assert_int_eq(fc->pscore[fc->jindx[j] + i], pscore);
+
+        if (fc->pscore_pf_compat)
+          ck_assert_int_eq(fc->pscore_pf_compat[fc->iindx[i] - j], (short)pscore);
+      }
+
+    vrna_fold_compound_free(fc);
+  }
+
+  for (s = 0; s < n_seq; s++)
+    free(alignment[s]);
+
+  free(alignment);
+}
+
+#tcase  G_Quadruplex
+
+#test test_gquad_pf_index
+{
+  /* with a G-quadruplex of the largest size at the 3' end */
+  const char            *sequence =
+    "GGGAGGGAGGGAGGGUUAGCGGGGAAGGGGAAGGGGAAGGGGCUAAGGAGGUAGGCAGGAUCC"
+    "GGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGG";
+  const char            *alignment[] = {
+    "GGGAGGGAGGGAGGGUUAGCGGGGAAGGGGAAGGGGAAGGGGCUAAGGAGGUAGGCAGGAUCC"
+    "GGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGG",
+    "GGG-GGGAGGGAGGGUUAGCGGGGAAGG-GAAGGGGAAGGGGCUAAGGAGGUAGGCAGGAUCC"
+    "GGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGG",
+    "GGGAGGGUGGGAGGGUUAGCGGGGUAGGGGAAGGGAAAGGGGCUAAGGAGG-AGGCAGGAUCC"
+    "GGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGGUAAUCAUAAUCAUAAGGGGGGG",
+    NULL
+  };
+  int                   i, j, n, k, *iindx;
+  double                mfe;
+  FLT_OR_DBL            *G_legacy, w;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.gquad = 1;
+
+  /* single sequence and alignment */
+  for (k = 0; k < 2; k++) {
+    if (k == 0)
+      fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    else
+      fc = vrna_fold_compound_comparative(alignment, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+
+    mfe = (double)vrna_mfe(fc, NULL);
+    vrna_exp_params_rescale(fc, &mfe);
+    vrna_pf(fc, NULL);
+
+    ck_assert(fc->exp_matrices->G != NULL);
+
+    n     = (int)fc->length;
+    iindx = fc->iindx;
+
+    if (k == 0)
+      G_legacy = get_gquad_pf_matrix(fc->sequence_encoding2,
+                                     fc->exp_matrices->scale,
+                                     fc->exp_params);
+    else
+      G_legacy = get_gquad_pf_matrix_comparative(fc->length,
+                                                 fc->S_cons,
+                                                 fc->S,
+                                                 fc->a2s,
+                                                 fc->exp_matrices->scale,
+                                                 fc->n_seq,
+                                                 fc->exp_params);
+
+    /* every entry of the dense matrix, zero or not, is found in the sparse index */
+    for (w = 0., i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++) {
+        ck_assert(vrna_gquad_index_weight(fc->exp_matrices->G, i, j) ==
+                  G_legacy[iindx[i] - j]);
+        w += G_legacy[iindx[i] - j];
+      }
+
+    ck_assert(w > 0.);
+
+    free(G_legacy);
+    vrna_fold_compound_free(fc);
+  }
+}
+
+#tcase  Distance_Classes
+
+#test test_mx_pool
+{
+  size_t          k, size[6] = {
+    1, 7, 16, 33, 60, 1000
+  };
+  unsigned char   *block[60];
+  vrna_mx_pool_t  *pool;
+
+  /* small chunks, such that blocks span several chunks and some exceed a chunk */
+  pool = vrna_mx_pool_init(256);
+
+  for (k = 0; k < 60; k++) {
+    block[k] = (unsigned char *)vrna_mx_pool_alloc(pool, size[k % 6]);
+    ck_assert(block[k] != NULL);
+    ck_assert_int_eq((int)((size_t)block[k] % sizeof(double)), 0);
+    memset(block[k], (int)k, size[k % 6]);
+  }
+
+  /* blocks do not overlap */
+  for (k = 0; k < 60; k++)
+    ck_assert(block[k][0] == (unsigned char)k &&
+              block[k][size[k % 6] - 1] == (unsigned char)k);
+
+  vrna_mx_pool_free(pool);
+}
+
+#test test_TwoD_pooled_matrices
+{
+  const char            *sequences[2] = {
+    "GGGAUCCGAAAGUUCGCAUAGCAAAUGCUAAAGCGAUCUU",
+    "AAGCGGUACCAAAUCCCUUAGCGGAUAACGCUAAGGCUUGGCAUCGCUAGCCGUUAAAACG"
+  };
+  char                  *s1[2], *s2[2];
+  int                   k, r, n;
+  double                mfe, G, q;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *ref;
+  vrna_sol_TwoD_t       *sol[2][2], *m;
+  vrna_sol_TwoD_pf_t    *sol_pf[2][2], *pf;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  /* distance classes to the open chain and the MFE structure */
+  for (k = 0; k < 2; k++) {
+    n     = (int)strlen(sequences[k]);
+    ref   = vrna_fold_compound(sequences[k], &md, VRNA_OPTION_DEFAULT);
+    s1[k] = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s2[k] = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    memset(s1[k], '.', n);
+    vrna_mfe(ref, s2[k]);
+    vrna_fold_compound_free(ref);
+  }
+
+  /* pooled matrices of compounds with different lengths, set up and released in turn */
+  for (r = 0; r < 2; r++)
+    for (k = 0; k < 2; k++) {
+      fc = vrna_fold_compound_TwoD(sequences[k], s1[k], s2[k], &md,
+                                   VRNA_OPTION_MFE | VRNA_OPTION_PF);
+      ck_assert(fc != NULL);
+
+      sol[k][r] = vrna_mfe_TwoD(fc, -1, -1);
+      mfe       = (double)sol[k][r][0].en;
+      for (m = sol[k][r]; m->k != INF; m++)
+        mfe = MIN2(mfe, m->en);
+
+      vrna_exp_params_rescale(fc, &mfe);
+      sol_pf[k][r] = vrna_pf_TwoD(fc, -1, -1);
+
+      /* keep the ensemble free energy only */
+      for (q = 0., pf = sol_pf[k][r]; pf->k != INF; pf++)
+        q += pf->q;
+
+      sol_pf[k][r][0].q = -(log(q) + strlen(sequences[k]) * log(fc->exp_params->pf_scale)) *
+                          fc->exp_params->kT / 1000.;
+
+      vrna_fold_compound_free(fc);
+    }
+
+  for (k = 0; k < 2; k++) {
+    ref = vrna_fold_compound(sequences[k], &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    mfe = (double)vrna_mfe(ref, NULL);
+    vrna_exp_params_rescale(ref, &mfe);
+    G   = (double)vrna_pf(ref, NULL);
+
+    /* identical results in both rounds */
+    for (r = 0; sol[k][0][r].k != INF; r++) {
+      ck_assert_int_eq(sol[k][1][r].k, sol[k][0][r].k);
+      ck_assert_int_eq(sol[k][1][r].l, sol[k][0][r].l);
+      ck_assert(sol[k][1][r].en == sol[k][0][r].en);
+      ck_assert_str_eq(sol[k][1][r].s, sol[k][0][r].s);
+    }
+    ck_assert_int_eq(sol[k][1][r].k, INF);
+    ck_assert(sol_pf[k][1][0].q == sol_pf[k][0][0].q);
+
+    /* that agree with the regular recursions */
+    for (q = INF, m = sol[k][0]; m->k != INF; m++) {
+      ck_assert(fabs(vrna_eval_structure(ref, m->s) - m->en) < 1e-4);
+      ck_assert_int_eq(vrna_bp_distance(m->s, s1[k]), m->k);
+      ck_assert_int_eq(vrna_bp_distance(m->s, s2[k]), m->l);
+      q = MIN2(q, m->en);
+    }
+
+    ck_assert(fabs(q - mfe) < 1e-4);
+    ck_assert(fabs(sol_pf[k][0][0].q - G) < 1e-6);
+
+    for (r = 0; r < 2; r++) {
+      for (m = sol[k][r]; m->k != INF; m++)
+        free(m->s);
+
+      free(sol[k][r]);
+      free(sol_pf[k][r]);
+    }
+
+    free(s1[k]);
+    free(s2[k]);
+    vrna_fold_compound_free(ref);
+  }
+}
+
+#tcase  Accessibility
+
+#test test_access_store
+{
+  const char            *sequence = "GGGAUCCGAAAGUUCGCAUAGCAAAUGCUAAAGCGAUCUUAAGCGGUACCAAAUCCCUUAGCGGAUAACGCUAAGGCUU";
+  char                  directory[] = "/tmp/vrna_access_XXXXXX", path[512];
+  unsigned int          i, n, u, ulength, files;
+  int                   pass;
+  double                **up, **mx, p;
+  struct up_data        d;
+  DIR                   *dir;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  struct dirent         *entry;
+  vrna_access_store_t   *store;
+  vrna_access_profile_t *profile;
+
+  n       = strlen(sequence);
+  ulength = 8;
+
+  /* reference probabilities, computed like RNAplfold -u does */
+  vrna_md_set_default(&md);
+  md.compute_bpp  = 1;
+  md.window_size  = 40;
+  md.max_bp_span  = 30;
+  fc              = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+
+  up = (double **)vrna_alloc(sizeof(double *) * (n + 1));
+  for (i = 0; i <= n; i++)
+    up[i] = (double *)vrna_alloc(sizeof(double) * (ulength + 1));
+
+  d.up      = up;
+  d.ulength = ulength;
+
+  vrna_ptypes_prepare(fc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(fc, ulength, VRNA_PROBS_WINDOW_UP, &store_up, &d));
+  vrna_fold_compound_free(fc);
+
+  ck_assert(mkdtemp(directory) != NULL);
+
+  /* the first query computes the profile, the others read it from the store */
+  for (pass = 0; pass < 3; pass++) {
+    store = vrna_access_store_open(directory);
+    ck_assert(store != NULL);
+
+    profile = vrna_access_store_get(store, sequence, ulength, 40, 30, NULL);
+    ck_assert(profile != NULL);
+    ck_assert_int_eq(vrna_access_profile_length(profile), n);
+    ck_assert_int_eq(vrna_access_profile_ulength(profile), ulength);
+
+    mx = vrna_access_profile_matrix(profile);
+    ck_assert(mx != NULL);
+
+    for (i = 1; i <= n; i++)
+      for (u = 1; (u <= ulength) && (u <= i); u++) {
+        p = vrna_access_profile_up(profile, i, u);
+        /* quantized, and probabilities below exp(-32) are rounded up */
+        ck_assert(fabs(p - up[i][u]) <= 1e-3 * up[i][u] + 2e-14);
+        ck_assert(mx[i][u] == p);
+      }
+
+    /* segments beyond the sequence or the maximal length are invalid */
+    ck_assert(vrna_access_profile_up(profile, n + 1, 1) == 0.);
+    ck_assert(vrna_access_profile_up(profile, n, ulength + 1) == 0.);
+
+    for (i = 0; i <= n; i++)
+      free(mx[i]);
+
+    free(mx);
+    vrna_access_profile_free(profile);
+    vrna_access_store_close(store);
+  }
+
+  /* different settings are stored as a profile of their own */
+  store   = vrna_access_store_open(directory);
+  profile = vrna_access_store_get(store, sequence, ulength, 60, 30, NULL);
+  ck_assert(profile != NULL);
+  vrna_access_profile_free(profile);
+  vrna_access_store_close(store);
+
+  files = 0;
+  dir   = opendir(directory);
+  ck_assert(dir != NULL);
+  while ((entry = readdir(dir))) {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    files++;
+    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+    unlink(path);
+  }
+  closedir(dir);
+  rmdir(directory);
+
+  ck_assert_int_eq(files, 2);
+
+  for (i = 0; i <= n; i++)
+    free(up[i]);
+
+  free(up);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
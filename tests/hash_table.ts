@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ViennaRNA/datastructures/hash_tables.h>
+#include <string.h>
+#include <ViennaRNA/utils/structures.h>
 #include <stdarg.h>
 
 
@@ -79,5 +81,54 @@ free_dummy(void *x)
 }
 
 
+#test test_vrna_ht_pt
+{
+  /* set of packed secondary structures */
+  short         *pt1  = vrna_ptable("((((...))))..((...))");
+  short         *pt2  = vrna_ptable("((((...)))).........");
+  short         *pt3  = vrna_ptable_from_string("((((...))))..[[...]]", VRNA_BRACKETS_ANY);
+  short         *pt4  = vrna_ptable_from_string("((((..[[))))....]]..", VRNA_BRACKETS_ANY);
+  short         *pt;
+  vrna_ht_pt_t  ht    = vrna_ht_pt_init(20, 0);
+
+  ck_assert_ptr_ne(ht, NULL);
+  ck_assert_int_eq(vrna_ht_pt_get(ht, pt1), -1);
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt1), 0);
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt2), 1);
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt1), 0);
+  ck_assert_int_eq(vrna_ht_pt_num(ht), 2);
+  ck_assert_int_eq(vrna_ht_pt_get(ht, pt2), 1);
+
+  /* nested pairs of different brackets are identical in pair table notation */
+  ck_assert_int_eq(vrna_ht_pt_get(ht, pt3), 0);
+
+  /* crossing pairs require the pseudoknot option */
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt4), -1);
+
+  pt = vrna_ht_pt_ptable(ht, 1);
+  ck_assert_int_eq(memcmp(pt, pt2, sizeof(short) * 21), 0);
+  free(pt);
+
+  vrna_ht_pt_clear(ht);
+  ck_assert_int_eq(vrna_ht_pt_num(ht), 0);
+  ck_assert_int_eq(vrna_ht_pt_get(ht, pt1), -1);
+  vrna_ht_pt_free(ht);
+
+  ht = vrna_ht_pt_init(20, VRNA_HT_PT_PK);
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt4), 0);
+  ck_assert_int_eq(vrna_ht_pt_insert(ht, pt1), 1);
+  ck_assert_int_eq(vrna_ht_pt_get(ht, pt4), 0);
+  pt = vrna_ht_pt_ptable(ht, 0);
+  ck_assert_int_eq(memcmp(pt, pt4, sizeof(short) * 21), 0);
+  free(pt);
+  vrna_ht_pt_free(ht);
+
+  free(pt1);
+  free(pt2);
+  free(pt3);
+  free(pt4);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -0,0 +1,482 @@
+/*
+ * DO NOT EDIT THIS FILE. Generated by checkmk.
+ * Edit the original source file "plex.ts" instead.
+ */
+
+#include <check.h>
+
+#line 1 "plex.ts"
+#include <stdio.h>      /* printf, tmpfile */
+#include <stdlib.h>     /* malloc, free */
+#include <math.h>       /* fabs, log, rint */
+#include <string.h>     /* strlen, strcmp */
+#include <unistd.h>     /* dup, dup2, unlink */
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/alphabet.h>
+#include <ViennaRNA/params/constants.h>
+#include <ViennaRNA/part_func_window.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
+#include <ViennaRNA/plex.h>
+
+#define TARGET  "GGGAUCCGAAAGUUCGCAUAGCAAAUGCUAAAGCGAUCUUAAGCGGUACCAAAUCCCUUAGCGGAUAACGCUAAGGCUU"
+#define QUERY   "UUAGCGCUUUAGCAUUUGCUAUG"
+
+/* unpaired probabilities as RNAplfold -u computes them, stored as opening energies */
+struct up_energies {
+  int     **a;
+  int     ulength;
+  double  kT;
+};
+
+
+static void
+store_up_energies(FLT_OR_DBL    *pr,
+                  int           pr_size,
+                  int           i,
+                  int           max,
+                  unsigned int  type,
+                  void          *data)
+{
+  int                 u;
+  struct up_energies  *d = (struct up_energies *)data;
+
+  if ((type & VRNA_PROBS_WINDOW_UP) && ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP))
+    for (u = 1; (u <= pr_size) && (u <= d->ulength); u++)
+      if (pr[u] > 0)
+        d->a[u][i + 10] = (int)rint(100 * (-log(pr[u])) * d->kT);
+}
+
+
+static int **
+opening_energies(const char *sequence,
+                 int        ulength,
+                 int        window_size,
+                 int        max_bp_span)
+{
+  int                   u, i, n;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  struct up_energies    d;
+
+  n = (int)strlen(sequence);
+
+  vrna_md_set_default(&md);
+  md.compute_bpp  = 1;
+  md.window_size  = window_size;
+  md.max_bp_span  = max_bp_span;
+
+  d.ulength = ulength;
+  d.kT      = (md.temperature + K0) * GASCONST / 1000.0;
+  d.a       = (int **)vrna_alloc(sizeof(int *) * (ulength + 2));
+  for (u = 0; u < ulength + 2; u++) {
+    d.a[u] = (int *)vrna_alloc(sizeof(int) * (n + 20));
+    for (i = 0; i < n + 20; i++)
+      d.a[u][i] = INF;
+  }
+
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  vrna_ptypes_prepare(fc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(fc, ulength, VRNA_PROBS_WINDOW_UP, &store_up_energies, &d));
+  vrna_fold_compound_free(fc);
+
+  d.a[0][0] = ulength + 2;
+
+  return d.a;
+}
+
+
+static void
+free_energies(int **a)
+{
+  int u, rows = a[0][0];
+
+  for (u = 0; u < rows; u++)
+    free(a[u]);
+
+  free(a);
+}
+
+
+static int
+hit_num(duplexT **hits)
+{
+  int k;
+
+  for (k = 0; hits[k]; k++);
+
+  return k;
+}
+
+
+static int
+same_hit(const duplexT  *a,
+         const duplexT  *b)
+{
+  return (strcmp(a->structure, b->structure) == 0) &&
+         (a->i == b->i) && (a->j == b->j) &&
+         (a->tb == b->tb) && (a->te == b->te) &&
+         (a->qb == b->qb) && (a->qe == b->qe) &&
+         (a->energy == b->energy) && (a->ddG == b->ddG);
+}
+
+
+/* run one of the legacy scans and return what it prints */
+static char *
+legacy_output(const char  *target,
+              const char  *query,
+              const int   **access_t,
+              const int   **access_q)
+{
+  char  *s1, *s2, *output;
+  int   stdout_copy;
+  long  size;
+  FILE  *out;
+
+  s1  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", target);
+  s2  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", query);
+  out = tmpfile();
+  ck_assert(out != NULL);
+
+  fflush(stdout);
+  stdout_copy = dup(STDOUT_FILENO);
+  dup2(fileno(out), STDOUT_FILENO);
+  if (access_t)
+    (void)Lduplexfold_XS(s1, s2, access_t, access_q, -500, 20, 10, 0, 25, 110, 48, 320);
+  else
+    (void)Lduplexfold(s1, s2, -500, 15, 20, 10, 0, 25, 110, 48, 320);
+
+  fflush(stdout);
+  dup2(stdout_copy, STDOUT_FILENO);
+  close(stdout_copy);
+
+  size = ftell(out);
+  rewind(out);
+  output = (char *)vrna_alloc(sizeof(char) * (size + 1));
+  ck_assert_int_eq(fread(output, 1, size, out), size);
+  output[size] = '\0';
+
+  fclose(out);
+  free(s1);
+  free(s2);
+
+  return output;
+}
+
+
+
+
+START_TEST(test_plex_engine_legacy)
+{
+#line 167
+{
+  char                *s1, *s2, line[1024], structure[512];
+  int                 **access_t, **access_q, k, stdout_copy, tb, te, qb, qe;
+  double              ddG, energy;
+  FILE                *out;
+  duplexT             **hits;
+  vrna_plex_engine_t  *engine;
+
+  access_t  = opening_energies(TARGET, 20, 60, 40);
+  access_q  = opening_energies(QUERY, 20, 60, 40);
+
+  /* the legacy scan prints its hits, so capture them */
+  s1  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", TARGET);
+  s2  = vrna_strdup_printf("NNNNNNNNNN%sNNNNNNNNNN", QUERY);
+  out = tmpfile();
+  ck_assert(out != NULL);
+
+  fflush(stdout);
+  stdout_copy = dup(STDOUT_FILENO);
+  dup2(fileno(out), STDOUT_FILENO);
+  (void)Lduplexfold_XS(s1, s2,
+                       (const int **)access_t,
+                       (const int **)access_q,
+                       -500, 20, 10, 0,
+                       25, 110, 48, 320);
+  fflush(stdout);
+  dup2(stdout_copy, STDOUT_FILENO);
+  close(stdout_copy);
+  rewind(out);
+
+  engine = vrna_plex_engine(NULL, -500, 20, 10, 25, 110, 48, 320);
+  ck_assert(engine != NULL);
+
+  hits = vrna_plex_scan(engine, TARGET, QUERY, (const int **)access_t, (const int **)access_q);
+  ck_assert(hits != NULL);
+  ck_assert(hit_num(hits) >= 2);
+
+  /* same hits in the same order, up to the precision of the printed energies */
+  for (k = 0; fgets(line, sizeof(line), out); k++) {
+    ck_assert(sscanf(line, "%511s %d,%d : %d,%d (%lf = %lf",
+                     structure, &tb, &te, &qb, &qe, &ddG, &energy) == 7);
+    ck_assert(hits[k] != NULL);
+    ck_assert_str_eq(hits[k]->structure, structure);
+    ck_assert_int_eq(hits[k]->tb, tb);
+    ck_assert_int_eq(hits[k]->te, te);
+    ck_assert_int_eq(hits[k]->qb, qb);
+    ck_assert_int_eq(hits[k]->qe, qe);
+    ck_assert(fabs(hits[k]->ddG - ddG) < 0.006);
+    ck_assert(fabs(hits[k]->energy - energy) < 0.006);
+  }
+
+  ck_assert_int_eq(k, hit_num(hits));
+
+  fclose(out);
+  freeDuplexT(hits);
+  vrna_plex_engine_free(engine);
+  free_energies(access_t);
+  free_energies(access_q);
+  free(s1);
+  free(s2);
+}
+
+}
+END_TEST
+
+START_TEST(test_plex_scan_batch)
+{
+#line 230
+{
+  const char          *queries[] = {
+    QUERY,
+    "UAGCUUAUCAGACUGAUGUUGA",
+    "CCGCUUAAGAUCGCUUUAGCAU",
+    "GGUACCGCUUAAG",
+    "UGAGGUAGUAGGUUGUAUAGUU",
+    "AAGCCUUAGCGUUAUCCGCUAAGGG",
+    "CUUUGGUCGAUCCCAGG",
+    "UUCCGCUAAGCGAUUUGGGAUCUUAA",
+    "GAUCCCAUUGAGCGCUUAA",
+    "AGCGCAUUUGCUAUGCGAACUUU"
+  };
+  unsigned int        num = sizeof(queries) / sizeof(queries[0]);
+  int                 **access_t, ***access_q, q, k, l, n, matched;
+  duplexT             ***batch, ***best, **single;
+  vrna_plex_engine_t  *engine;
+
+  access_t  = opening_energies(TARGET, 20, 60, 40);
+  access_q  = (int ***)vrna_alloc(sizeof(int **) * num);
+
+  /* every other query without opening energies */
+  for (q = 0; q < (int)num; q += 2)
+    access_q[q] = opening_energies(queries[q], 20, 60, 40);
+
+  engine = vrna_plex_engine(NULL, -500, 20, 10, 25, 110, 48, 320);
+
+  /* more queries than fit into a single block */
+  batch = vrna_plex_scan_batch(engine, TARGET, (const int **)access_t,
+                               queries, (const int ***)access_q, num, 0);
+  best = vrna_plex_scan_batch(engine, TARGET, (const int **)access_t,
+                              queries, (const int ***)access_q, num, 2);
+  ck_assert(batch != NULL);
+  ck_assert(best != NULL);
+
+  for (q = 0; q < (int)num; q++) {
+    single = vrna_plex_scan(engine, TARGET, queries[q],
+                            (const int **)access_t, (const int **)access_q[q]);
+    ck_assert(single != NULL);
+    ck_assert(batch[q] != NULL);
+
+    /* the optimal hit closes the list of a single scan, and may repeat a suboptimal one */
+    n = hit_num(single);
+    for (k = 0; k < n - 1; k++)
+      if (same_hit(single[n - 1], single[k])) {
+        n--;
+        break;
+      }
+
+    ck_assert_int_eq(hit_num(batch[q]), n);
+
+    /* same hits, sorted by energy */
+    for (k = 0; k < n; k++) {
+      for (matched = 0, l = 0; batch[q][l]; l++)
+        if (same_hit(single[k], batch[q][l]))
+          matched++;
+
+      ck_assert_int_eq(matched, 1);
+    }
+
+    for (l = 1; l < n; l++)
+      ck_assert(batch[q][l - 1]->energy <= batch[q][l]->energy);
+
+    /* only the two best hits are kept */
+    ck_assert_int_eq(hit_num(best[q]), MIN2(n, 2));
+    for (l = 0; best[q][l]; l++)
+      ck_assert(same_hit(best[q][l], batch[q][l]));
+
+    freeDuplexT(single);
+    freeDuplexT(batch[q]);
+    freeDuplexT(best[q]);
+  }
+
+  free(batch);
+  free(best);
+
+  /* an empty batch yields no result */
+  ck_assert(vrna_plex_scan_batch(engine, TARGET, (const int **)access_t,
+                                 queries, NULL, 0, 0) == NULL);
+
+  vrna_plex_engine_free(engine);
+  free_energies(access_t);
+  for (q = 0; q < (int)num; q += 2)
+    free_energies(access_q[q]);
+  free(access_q);
+}
+
+}
+END_TEST
+
+START_TEST(test_plex_profile_scan_scalar)
+{
+#line 318
+{
+  /* none of the query lengths is a multiple of the vector widths, so profile rows are padded */
+  const char          *queries[] = {
+    QUERY,
+    "GGUACCGCUUAAGAUCG",
+    "AAGCCUUAGCGUUAUCCGCUAAGGGAUUUGGUA"
+  };
+  char                *simd_out, *scalar_out;
+  int                 **access_t, **access_q, q, k, a;
+  duplexT             **simd, **scalar;
+  vrna_plex_engine_t  *engine;
+
+  access_t  = opening_energies(TARGET, 20, 60, 40);
+  engine    = vrna_plex_engine(NULL, -500, 20, 10, 25, 110, 48, 320);
+
+  for (q = 0; q < 3; q++) {
+    access_q = opening_energies(queries[q], 20, 60, 40);
+
+    /* the legacy scans print the same, with and without SIMD */
+    for (a = 0; a < 2; a++) {
+      vrna_fun_dispatch_enable();
+      simd_out = legacy_output(TARGET, queries[q],
+                               a ? (const int **)access_t : NULL,
+                               (const int **)access_q);
+      vrna_fun_dispatch_disable();
+      scalar_out = legacy_output(TARGET, queries[q],
+                                 a ? (const int **)access_t : NULL,
+                                 (const int **)access_q);
+
+      ck_assert(strlen(scalar_out) > 0);
+      ck_assert_str_eq(simd_out, scalar_out);
+
+      free(simd_out);
+      free(scalar_out);
+    }
+
+    /* the reentrant scan yields the same hits, with and without query opening energies */
+    for (a = 0; a < 2; a++) {
+      vrna_fun_dispatch_enable();
+      simd = vrna_plex_scan(engine, TARGET, queries[q],
+                            (const int **)access_t, a ? (const int **)access_q : NULL);
+      vrna_fun_dispatch_disable();
+      scalar = vrna_plex_scan(engine, TARGET, queries[q],
+                              (const int **)access_t, a ? (const int **)access_q : NULL);
+
+      ck_assert(scalar != NULL);
+      ck_assert(hit_num(scalar) > 0);
+      ck_assert_int_eq(hit_num(simd), hit_num(scalar));
+      for (k = 0; scalar[k]; k++)
+        ck_assert(same_hit(simd[k], scalar[k]));
+
+      freeDuplexT(simd);
+      freeDuplexT(scalar);
+    }
+
+    free_energies(access_q);
+  }
+
+  vrna_fun_dispatch_enable();
+  vrna_plex_engine_free(engine);
+  free_energies(access_t);
+}
+
+}
+END_TEST
+
+START_TEST(test_plex_access_db)
+{
+#line 384
+{
+  const char            *ids[]        = { "target", NULL, "query" };
+  const char            *sequences[]  = { TARGET, "GGGGAAAACCCCAUGCAUGC", QUERY };
+  char                  filename[]    = "/tmp/vrna_plex_db_XXXXXX";
+  const int             **a;
+  int                   **ref, fd, u, i, k, n;
+  vrna_md_t             md;
+  vrna_plex_access_db_t *db;
+
+  fd = mkstemp(filename);
+  ck_assert(fd >= 0);
+  close(fd);
+
+  vrna_md_set_default(&md);
+  ck_assert(vrna_plex_access_db_build(filename, ids, sequences, 3, 20, 60, 40, &md));
+
+  db = vrna_plex_access_db_open(filename);
+  ck_assert(db != NULL);
+  ck_assert_int_eq(vrna_plex_access_db_size(db), 3);
+
+  for (k = 0; k < 3; k++) {
+    if (ids[k])
+      ck_assert_str_eq(vrna_plex_access_db_id(db, k), ids[k]);
+
+    ck_assert_str_eq(vrna_plex_access_db_sequence(db, k), sequences[k]);
+
+    /* opening energies are the same as those computed directly */
+    n   = (int)strlen(sequences[k]);
+    ref = opening_energies(sequences[k], 20, 60, 40);
+    a   = vrna_plex_access_db_get(db, k);
+    ck_assert(a != NULL);
+    ck_assert_int_eq(a[0][0], ref[0][0]);
+
+    for (u = 0; u < 22; u++)
+      for (i = (u == 0) ? 1 : 0; i < n + 20; i++)
+        ck_assert_int_eq(a[u][i], ref[u][i]);
+
+    free(a);
+    free_energies(ref);
+  }
+
+  ck_assert_int_eq(vrna_plex_access_db_find(db, "query"), 2);
+  ck_assert_int_eq(vrna_plex_access_db_find(db, "missing"), -1);
+  ck_assert(vrna_plex_access_db_get(db, 3) == NULL);
+
+  vrna_plex_access_db_close(db);
+  unlink(filename);
+}
+
+
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s1 = suite_create("RNAplex");
+    TCase *tc1_1 = tcase_create("Duplex_Engine");
+    TCase *tc1_2 = tcase_create("Accessibility_Database");
+    SRunner *sr = srunner_create(s1);
+    int nf;
+
+    /* User-specified pre-run code */
+#line 435
+    srunner_set_tap(sr, "-");
+
+    suite_add_tcase(s1, tc1_1);
+    tcase_add_test(tc1_1, test_plex_engine_legacy);
+    tcase_add_test(tc1_1, test_plex_scan_batch);
+    tcase_add_test(tc1_1, test_plex_profile_scan_scalar);
+    suite_add_tcase(s1, tc1_2);
+    tcase_add_test(tc1_2, test_plex_access_db);
+
+    srunner_run_all(sr, CK_ENV);
+    nf = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return nf == 0 ? 0 : 1;
+}
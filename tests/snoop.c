@@ -0,0 +1,219 @@
+/*
+ * DO NOT EDIT THIS FILE. Generated by checkmk.
+ * Edit the original source file "snoop.ts" instead.
+ */
+
+#include <check.h>
+
+#line 1 "snoop.ts"
+#include <stdio.h>      /* printf, tmpfile */
+#include <stdlib.h>     /* malloc, free */
+#include <math.h>       /* fabs */
+#include <string.h>     /* strlen, strcmp, strspn */
+#include <unistd.h>     /* dup, dup2 */
+
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/snofold.h>
+#include <ViennaRNA/snoop.h>
+
+#define SNORNA  "GGCUUGGCAUCGCUAGCCGUUAAAACGGCUGAACGUGCCAAGCCAGAGACAUAGAUAAGCCUACCGAGUUUCGGUAGGUCUGAGUCAACAUU"
+#define TARGET  "AUCCGAGGAAACGUUCGUUUUAGCGAUCGAUUGCAAAUGCCACGUUCAGUUAGCGAUGGUACCCCACCCCACCCCACCCCACCCCACCCCA"
+
+/* the defaults of RNAsnoop, with a less strict lower duplex threshold */
+static void
+snoop_options(vrna_snoop_opt_t  *opt,
+              unsigned int      seed_length)
+{
+  memset(opt, 0, sizeof(vrna_snoop_opt_t));
+  opt->penalty          = 0;
+  opt->threshloop       = -280;
+  opt->threshLE         = -100;
+  opt->threshRE         = -270;
+  opt->threshDE         = -1090;
+  opt->threshTE         = -1370;
+  opt->threshSE         = 100000;
+  opt->threshD          = 100000;
+  opt->distance         = 2;
+  opt->half_stem        = 5;
+  opt->max_half_stem    = 120;
+  opt->min_s2           = 11;
+  opt->max_s2           = 16;
+  opt->min_s1           = 1;
+  opt->max_s1           = 100000;
+  opt->min_d1           = 0;
+  opt->min_d2           = 0;
+  opt->alignment_length = 25;
+  opt->delta            = 300;
+  opt->max_assym        = 30;
+  opt->seed_length      = seed_length;
+}
+
+
+static int
+hit_num(const snoopT *hits)
+{
+  int k;
+
+  for (k = 0; hits[k].structure; k++);
+
+  return k;
+}
+
+
+static int
+same_hit(const snoopT *a,
+         const snoopT *b)
+{
+  return (strcmp(a->structure, b->structure) == 0) &&
+         (a->i == b->i) && (a->u == b->u) && (a->j == b->j) &&
+         (a->energy == b->energy);
+}
+
+
+
+
+START_TEST(test_snoop_scan_legacy)
+{
+#line 71
+{
+  char                *s1, *s2, *structure, line[1024], hit_structure[512];
+  int                 k, num, stem_energy, tb, te, u, jb, je;
+  double              energy;
+  FILE                *out;
+  snoopT              *hits;
+  vrna_snoop_opt_t    opt;
+  vrna_snoop_engine_t *engine;
+
+  snoop_options(&opt, 0);
+
+  /* the legacy scan requires the stems of the (padded) snoRNA */
+  s1        = vrna_strdup_printf("NNNNN%sNNNNN", TARGET);
+  s2        = vrna_strdup_printf("NNNNN%sNNNNN", SNORNA);
+  structure = (char *)vrna_alloc(sizeof(char) * (strlen(s2) + 1));
+  snoinitialize_fold((int)strlen(s2));
+  stem_energy = snofold(s2, structure, opt.max_assym, opt.threshloop, opt.min_s2, opt.max_s2,
+                        opt.half_stem, opt.max_half_stem);
+
+  /* it prints its hits, so capture them */
+  out = tmpfile();
+  ck_assert(out != NULL);
+
+  fflush(stdout);
+  k = dup(STDOUT_FILENO);
+  dup2(fileno(out), STDOUT_FILENO);
+  Lsnoop_subopt_list(s1, s2, opt.delta, 5, opt.penalty, opt.threshloop,
+                     opt.threshLE, opt.threshRE, opt.threshDE, opt.threshTE,
+                     opt.threshSE, opt.threshD, opt.distance, opt.half_stem,
+                     opt.max_half_stem, opt.min_s2, opt.max_s2, opt.min_s1,
+                     opt.max_s1, opt.min_d1, opt.min_d2, opt.alignment_length,
+                     NULL, stem_energy);
+  fflush(stdout);
+  dup2(k, STDOUT_FILENO);
+  close(k);
+  rewind(out);
+
+  engine = vrna_snoop_engine(SNORNA, &opt, NULL);
+  ck_assert(engine != NULL);
+
+  hits = vrna_snoop_scan(engine, TARGET);
+  ck_assert(hits != NULL);
+  ck_assert(hit_num(hits) >= 2);
+
+  /* same hits in the same order, each followed by a line with the sequences */
+  for (num = 0; fgets(line, sizeof(line), out);) {
+    /* skip anything printed in front of the structure */
+    char *ptr = line + strspn(line, "0123456789");
+
+    if (sscanf(ptr, "%511s %d,%d ; %d : %d,%d (%lf",
+               hit_structure, &tb, &te, &u, &jb, &je, &energy) != 7)
+      continue;
+
+    ck_assert(hits[num].structure != NULL);
+    ck_assert_str_eq(hits[num].structure, hit_structure);
+    ck_assert_int_eq(hits[num].i, te);
+    ck_assert_int_eq(hits[num].u, u);
+    ck_assert_int_eq(hits[num].j, jb);
+    ck_assert(fabs(hits[num].energy - energy) < 0.006);
+    num++;
+  }
+
+  ck_assert_int_eq(num, hit_num(hits));
+
+  fclose(out);
+  vrna_snoop_hits_free(hits);
+  vrna_snoop_engine_free(engine);
+  snofree_arrays((int)strlen(s2));
+  free(s1);
+  free(s2);
+}
+
+}
+END_TEST
+
+START_TEST(test_snoop_scan_seed_prefilter)
+{
+#line 144
+{
+  int                 k, l, matched;
+  unsigned int        seed_length;
+  snoopT              *hits, *seeded;
+  vrna_snoop_opt_t    opt;
+  vrna_snoop_engine_t *engine, *seeded_engine;
+
+  snoop_options(&opt, 0);
+  engine  = vrna_snoop_engine(SNORNA, &opt, NULL);
+  hits    = vrna_snoop_scan(engine, TARGET);
+  ck_assert(hit_num(hits) > 0);
+
+  /* all interactions here contain perfect seeds of these lengths */
+  for (seed_length = 4; seed_length <= 8; seed_length += 2) {
+    snoop_options(&opt, seed_length);
+    seeded_engine = vrna_snoop_engine(SNORNA, &opt, NULL);
+    ck_assert(seeded_engine != NULL);
+
+    seeded = vrna_snoop_scan(seeded_engine, TARGET);
+    ck_assert(seeded != NULL);
+    ck_assert_int_eq(hit_num(seeded), hit_num(hits));
+
+    for (k = 0; hits[k].structure; k++) {
+      for (matched = 0, l = 0; seeded[l].structure; l++)
+        if (same_hit(hits + k, seeded + l))
+          matched++;
+
+      ck_assert(matched > 0);
+    }
+
+    vrna_snoop_hits_free(seeded);
+    vrna_snoop_engine_free(seeded_engine);
+  }
+
+  vrna_snoop_hits_free(hits);
+  vrna_snoop_engine_free(engine);
+}
+
+
+}
+END_TEST
+
+int main(void)
+{
+    Suite *s1 = suite_create("RNAsnoop");
+    TCase *tc1_1 = tcase_create("Target_Scan");
+    SRunner *sr = srunner_create(s1);
+    int nf;
+
+    /* User-specified pre-run code */
+#line 184
+    srunner_set_tap(sr, "-");
+
+    suite_add_tcase(s1, tc1_1);
+    tcase_add_test(tc1_1, test_snoop_scan_legacy);
+    tcase_add_test(tc1_1, test_snoop_scan_seed_prefilter);
+
+    srunner_run_all(sr, CK_ENV);
+    nf = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return nf == 0 ? 0 : 1;
+}
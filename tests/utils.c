@@ -6,14 +6,32 @@
 #include <check.h>
 
 #line 1 "utils.ts"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/alphabet.h>
 #include <ViennaRNA/mfe.h>
+#include <ViennaRNA/io/file_formats_msa.h>
+#include <ViennaRNA/utils/cpu.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
+
+typedef void (min_add_terms_f)(int *,
+                               const int **,
+                               const int **,
+                               const int **,
+                               const int *,
+                               unsigned int,
+                               int);
+
+/* SIMD implementations, only present if the library was built with them */
+extern min_add_terms_f  vrna_fun_min_add_terms_sse41 __attribute__((weak));
+extern min_add_terms_f  vrna_fun_min_add_terms_avx512 __attribute__((weak));
 
 static int
 compare_str(const void  *a,
@@ -23,10 +41,41 @@ compare_str(const void  *a,
 }
 
 
+struct msa_stream_results {
+  unsigned int  num;
+  char          *ids[4];
+};
+
+
+static void *
+msa_stream_fold(vrna_fold_compound_t    *fc,
+                const vrna_msa_record_t *record,
+                void                    *data)
+{
+  ck_assert_int_eq(fc->n_seq, record->n_seq);
+
+  return strdup(record->id);
+}
+
+
+static void
+msa_stream_output(void          *auxdata,
+                  unsigned int  i,
+                  void          *data)
+{
+  struct msa_stream_results *results = (struct msa_stream_results *)auxdata;
+
+  ck_assert_int_eq(i, results->num);
+  ck_assert(i < 4);
+
+  results->ids[results->num++] = (char *)data;
+}
+
+
 
 START_TEST(test_vrna_nucleotide_encode)
 {
-#line 22
+#line 71
 {
   vrna_md_t details = {
     0
@@ -62,7 +111,7 @@ END_TEST
 
 START_TEST(test_vrna_nucleotide_decode)
 {
-#line 53
+#line 102
 {
   const char  *characters = "_ACGUTXKI";
   const char  *p;
@@ -99,7 +148,7 @@ END_TEST
 
 START_TEST(test_sequence_encoding)
 {
-#line 85
+#line 134
 {
   vrna_md_t details = {
     0
@@ -133,7 +182,7 @@ END_TEST
 
 START_TEST(test_vrna_md_update)
 {
-#line 116
+#line 165
 {
   vrna_md_t details = {
     0
@@ -190,7 +239,7 @@ END_TEST
 
 START_TEST(test_get_ptypes)
 {
-#line 170
+#line 219
 {
   vrna_md_t details = {
     0
@@ -242,7 +291,7 @@ END_TEST
 
 START_TEST(test_pack_unpack_structure)
 {
-#line 217
+#line 266
 {
   int i;
   vrna_init_rand();
@@ -276,7 +325,7 @@ END_TEST
 
 START_TEST(test_pack_lexicographic_order)
 {
-#line 246
+#line 295
 {
   int i, j, k, l, m;
   char db[3] = { '.', '(', ')' };
@@ -333,6 +382,262 @@ START_TEST(test_pack_lexicographic_order)
 }
 
 
+}
+END_TEST
+
+START_TEST(test_vrna_bp_distance_matrix)
+{
+#line 352
+{
+  const char          *mixed[] = {
+    "((...))", "(....)"
+  };
+  char                **structures, *seq, filename[L_tmpnam];
+  unsigned int        a, b, k, num;
+  int                 *dist, d;
+  FILE                *fp;
+  vrna_struct_pack_t  *pack;
+
+  /* not a multiple of the 16 rows and columns processed at once */
+  num         = 37;
+  structures  = (char **)vrna_alloc(sizeof(char *) * num);
+
+  vrna_init_rand();
+  for (k = 0; k < num; k++) {
+    structures[k] = (char *)vrna_alloc(sizeof(char) * 101);
+    if (k == 0) {
+      memset(structures[k], '.', 100);
+    } else {
+      seq = vrna_random_string(100, "ACGU");
+      (void)vrna_fold(seq, structures[k]);
+      free(seq);
+    }
+  }
+
+  ck_assert(vrna_struct_pack(mixed, 2) == NULL);
+
+  pack = vrna_struct_pack((const char **)structures, num);
+  ck_assert(pack != NULL);
+  ck_assert_int_eq(pack->num, num);
+  ck_assert_int_eq(pack->length, 100);
+
+  dist = vrna_bp_distance_matrix(pack);
+  ck_assert(dist != NULL);
+
+  for (k = 0, a = 0; a < num; a++)
+    for (b = a + 1; b < num; b++, k++) {
+      d = vrna_bp_distance(structures[a], structures[b]);
+      ck_assert_int_eq(dist[k], d);
+      ck_assert_int_eq(vrna_bp_distance_packed(pack, a, b), d);
+      ck_assert_int_eq(vrna_bp_distance_packed(pack, b, a), d);
+    }
+
+  /* the file holds the same condensed matrix */
+  ck_assert(tmpnam(filename) != NULL);
+  ck_assert_int_eq(vrna_bp_distance_matrix_file(pack, filename), 1);
+
+  fp = fopen(filename, "rb");
+  ck_assert(fp != NULL);
+
+  for (k = 0; k < num * (num - 1) / 2; k++) {
+    ck_assert_int_eq(fread(&d, sizeof(int), 1, fp), 1);
+    ck_assert_int_eq(d, dist[k]);
+  }
+
+  ck_assert_int_eq(fread(&d, sizeof(int), 1, fp), 0);
+  fclose(fp);
+  unlink(filename);
+
+  free(dist);
+  vrna_struct_pack_free(pack);
+  for (k = 0; k < num; k++)
+    free(structures[k]);
+
+  free(structures);
+}
+
+
+}
+END_TEST
+
+START_TEST(test_vrna_file_msa_fold_stream)
+{
+#line 424
+{
+  const char                *records[] = {
+    "# STOCKHOLM 1.0\n#=GF ID first\n"
+    "seq1 GGGGAAAACCCC\nseq2 GGGCAAAAGCCC\n//\n",
+    "# STOCKHOLM 1.0\n#=GF ID second\n"
+    "seq1 GCGCAUAUGCGC\nseq2 GCGGAUAUCCGC\n//\n",
+    "# STOCKHOLM 1.0\n#=GF ID third\n"
+    "seq1 CCCCUUUUGGGG\nseq2 CCGCUUUUGCGG\n//\n"
+  };
+  char                      msa_file[L_tmpnam], err_file[L_tmpnam], line[256];
+  int                       i, stderr_fd, warnings;
+  FILE                      *fp, *err;
+  struct msa_stream_results results;
+
+  ck_assert(tmpnam(msa_file) != NULL);
+  fp = fopen(msa_file, "w");
+  ck_assert(fp != NULL);
+  for (i = 0; i < 3; i++)
+    fputs(records[i], fp);
+  fclose(fp);
+
+  /* the format must be detected once, without any warnings per record */
+  ck_assert(tmpnam(err_file) != NULL);
+  fflush(stderr);
+  stderr_fd = dup(fileno(stderr));
+  ck_assert(freopen(err_file, "w", stderr) != NULL);
+
+  results.num = 0;
+  fp          = fopen(msa_file, "r");
+  ck_assert_int_eq(vrna_file_msa_fold_stream(fp,
+                                             0,
+                                             NULL,
+                                             VRNA_OPTION_DEFAULT,
+                                             msa_stream_fold,
+                                             msa_stream_output,
+                                             (void *)&results),
+                   3);
+  fclose(fp);
+
+  fflush(stderr);
+  dup2(stderr_fd, fileno(stderr));
+  close(stderr_fd);
+
+  warnings  = 0;
+  err       = fopen(err_file, "r");
+  while (fgets(line, sizeof(line), err))
+    if (strstr(line, "More than one MSA format parser"))
+      warnings++;
+
+  fclose(err);
+  unlink(err_file);
+
+  ck_assert_int_eq(warnings, 0);
+  ck_assert_int_eq(results.num, 3);
+  ck_assert_str_eq(results.ids[0], "first");
+  ck_assert_str_eq(results.ids[1], "second");
+  ck_assert_str_eq(results.ids[2], "third");
+
+  for (i = 0; i < 3; i++)
+    free(results.ids[i]);
+
+  /* input that no parser accepts must not be processed at all */
+  fp = fopen(msa_file, "w");
+  ck_assert(fp != NULL);
+  fputs("no alignment in here\n", fp);
+  fclose(fp);
+
+  results.num = 0;
+  fp          = fopen(msa_file, "r");
+  ck_assert_int_eq(vrna_file_msa_fold_stream(fp,
+                                             VRNA_FILE_FORMAT_MSA_SILENT,
+                                             NULL,
+                                             VRNA_OPTION_DEFAULT,
+                                             msa_stream_fold,
+                                             msa_stream_output,
+                                             (void *)&results),
+                   0);
+  fclose(fp);
+  unlink(msa_file);
+
+  ck_assert_int_eq(results.num, 0);
+}
+
+
+}
+END_TEST
+
+START_TEST(test_vrna_fun_min_add_terms)
+{
+#line 511
+{
+  /* none of the lengths is a multiple of the vector widths */
+  int           counts[]  = { 1, 3, 5, 7, 15, 17, 31, 33, 63, 65, 67 };
+  int           *a[5], *b[5], *c[5], d[5], ref[67], res[67], i, n, x;
+  unsigned int  k, t, num_terms, features;
+
+  features = vrna_cpu_simd_capabilities();
+  srand(4711);
+
+  for (k = 0; k < 5; k++) {
+    a[k]  = (int *)vrna_alloc(sizeof(int) * 67);
+    b[k]  = (int *)vrna_alloc(sizeof(int) * 67);
+    c[k]  = (int *)vrna_alloc(sizeof(int) * 67);
+    d[k]  = rand() % 2001 - 1000;
+
+    /* include some INF values, they are simply added up */
+    for (i = 0; i < 67; i++) {
+      a[k][i] = (rand() % 10 == 0) ? INF : rand() % 2001 - 1000;
+      b[k][i] = rand() % 2001 - 1000;
+      c[k][i] = (rand() % 20 == 0) ? INF : rand() % 2001 - 1000;
+    }
+  }
+
+  for (num_terms = 1; num_terms <= 5; num_terms++) {
+    for (n = 0; n < (int)(sizeof(counts) / sizeof(counts[0])); n++) {
+      for (i = 0; i < counts[n]; i++) {
+        ref[i] = a[0][i] + b[0][i] + c[0][i] + d[0];
+        for (t = 1; t < num_terms; t++) {
+          x       = a[t][i] + b[t][i] + c[t][i] + d[t];
+          ref[i]  = MIN2(ref[i], x);
+        }
+      }
+
+      /* dispatched and scalar implementations; the trailing sentinel must stay untouched */
+      for (t = 0; t < 2; t++) {
+        if (t == 0)
+          vrna_fun_dispatch_enable();
+        else
+          vrna_fun_dispatch_disable();
+
+        for (i = 0; i < 67; i++)
+          res[i] = -1;
+
+        vrna_fun_min_add_terms(res, (const int **)a, (const int **)b, (const int **)c, d,
+                               num_terms, counts[n]);
+
+        for (i = 0; i < counts[n]; i++)
+          ck_assert_int_eq(res[i], ref[i]);
+
+        if (counts[n] < 67)
+          ck_assert_int_eq(res[counts[n]], -1);
+      }
+
+      /* each SIMD implementation the CPU supports, independent of the dispatcher's choice */
+      for (t = 0; t < 2; t++) {
+        min_add_terms_f *f = (t == 0) ? &vrna_fun_min_add_terms_sse41 : &vrna_fun_min_add_terms_avx512;
+
+        if ((!f) ||
+            (!(features & ((t == 0) ? VRNA_CPU_SIMD_SSE41 : VRNA_CPU_SIMD_AVX512F))))
+          continue;
+
+        for (i = 0; i < 67; i++)
+          res[i] = -1;
+
+        f(res, (const int **)a, (const int **)b, (const int **)c, d, num_terms, counts[n]);
+
+        for (i = 0; i < counts[n]; i++)
+          ck_assert_int_eq(res[i], ref[i]);
+
+        if (counts[n] < 67)
+          ck_assert_int_eq(res[counts[n]], -1);
+      }
+    }
+  }
+
+  vrna_fun_dispatch_enable();
+
+  for (k = 0; k < 5; k++) {
+    free(a[k]);
+    free(b[k]);
+    free(c[k]);
+  }
+}
+
+
 //@TODO: extend alphabeth
 //@TODO: details.noLP = 1
 //@TODO: idx_type = 1
@@ -347,11 +652,13 @@ int main(void)
     TCase *tc1_1 = tcase_create("Sequence_Utils");
     TCase *tc1_2 = tcase_create("Model_Details");
     TCase *tc1_3 = tcase_create("Structure_Utils");
+    TCase *tc1_4 = tcase_create("File_Formats");
+    TCase *tc1_5 = tcase_create("Higher_Order_Functions");
     SRunner *sr = srunner_create(s1);
     int nf;
 
     /* User-specified pre-run code */
-#line 308
+#line 602
     srunner_set_tap(sr, "-");
 
     suite_add_tcase(s1, tc1_1);
@@ -364,6 +671,11 @@ int main(void)
     tcase_add_test(tc1_3, test_get_ptypes);
     tcase_add_test(tc1_3, test_pack_unpack_structure);
     tcase_add_test(tc1_3, test_pack_lexicographic_order);
+    tcase_add_test(tc1_3, test_vrna_bp_distance_matrix);
+    suite_add_tcase(s1, tc1_4);
+    tcase_add_test(tc1_4, test_vrna_file_msa_fold_stream);
+    suite_add_tcase(s1, tc1_5);
+    tcase_add_test(tc1_5, test_vrna_fun_min_add_terms);
 
     srunner_run_all(sr, CK_ENV);
     nf = srunner_ntests_failed(sr);
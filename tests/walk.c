@@ -8,15 +8,38 @@
 #line 1 "walk.ts"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <ViennaRNA/landscape/walk.h>
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/data_structures.h>
+#include <ViennaRNA/eval.h>
+#include <ViennaRNA/landscape/move.h>
+#include <ViennaRNA/landscape/neighbor.h>
+#include <ViennaRNA/landscape/findpath.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* energy change of a move, evaluated directly on the structure */
+static int
+move_dG(vrna_fold_compound_t  *vc,
+        vrna_move_t           *m,
+        short                 *pt)
+{
+  if (vrna_move_is_shift(m))
+    return vrna_eval_move_shift_pt(vc, m, pt);
+
+  return vrna_eval_move_pt(vc, pt, m->pos_5, m->pos_3);
+}
+
 
 
 START_TEST(Walk_Gradient)
 {
-#line 11
+#line 34
 {
   char                  *sequence                             = "GGGAAACCCAACCUUU";
   char                  *structure                            = ".(.....)........";
@@ -59,6 +82,161 @@ START_TEST(Walk_Gradient)
 }
 
 
+}
+END_TEST
+
+START_TEST(Walk_Gradient_Energies)
+{
+#line 77
+{
+  /* replay gradient walks with direct energy evaluations */
+  char                  *sequence =
+    "GGGAUACGCUAGCUAGGCAUCGAUCGGAUCCGAUGCUAGCUAGGAUCCCGAUCG"
+    "AUGCAUGCUAGCUAGGCAUCGGAUCCGAUCGAUCGUAGCUAGCAUGCAUCGAUCG";
+  /* a misfolded hairpin, and the ground state with helices partially opened */
+  char                  *structures[3] = {
+    "........((((.....))))................................."
+    ".......................................................",
+    ".((.(...(.((.((..(.((..........)).).)).)).).).)).((.(("
+    ".((.((.((.((.(...(.((........)).)..).)).)).)).)).)).)).",
+    ".(((..(..(((.(((.(((.(........).)))))).))).).))).(((.("
+    "((.(((.(((.(((.(.(.((........)).)).))).))).))).))).))).",
+  };
+  unsigned int          options[2] = {
+    VRNA_PATH_DEFAULT, VRNA_PATH_DEFAULT | VRNA_MOVESET_SHIFT
+  };
+  int                   k, s, dG, dG_min, e;
+  short                 *pt, *pt_replay;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  vrna_move_t           *moves, *m, *n, *neighbors;
+
+  vrna_md_set_default(&md);
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+
+  for (s = 0; s < 3; s++)
+    for (k = 0; k < 2; k++) {
+      pt        = vrna_ptable(structures[s]);
+      pt_replay = vrna_ptable(structures[s]);
+      moves     = vrna_path_gradient(vc, pt, options[k]);
+
+      ck_assert(moves != NULL);
+
+      e = vrna_eval_structure_pt(vc, pt_replay);
+
+      /* every move of the walk is a steepest descent among all neighbors */
+      for (m = moves; m->pos_5 != 0; m++) {
+        dG = move_dG(vc, m, pt_replay);
+        ck_assert_int_le(dG, 0);
+
+        neighbors = vrna_neighbors(vc, pt_replay, options[k]);
+        for (dG_min = 0, n = neighbors; n->pos_5 != 0; n++)
+          dG_min = MIN2(dG_min, move_dG(vc, n, pt_replay));
+
+        ck_assert_int_eq(dG, dG_min);
+        free(neighbors);
+
+        /* and the energy change of the move matches full evaluations */
+        vrna_move_apply(pt_replay, m);
+        ck_assert_int_eq(vrna_eval_structure_pt(vc, pt_replay), e + dG);
+        e += dG;
+      }
+
+      ck_assert_int_eq(memcmp(pt, pt_replay, sizeof(short) * (pt[0] + 1)), 0);
+
+      /* and ends in a local minimum */
+      neighbors = vrna_neighbors(vc, pt, options[k]);
+      for (m = neighbors; m->pos_5 != 0; m++)
+        ck_assert_int_ge(move_dG(vc, m, pt), 0);
+
+      free(neighbors);
+      free(moves);
+      free(pt_replay);
+      free(pt);
+    }
+
+  vrna_fold_compound_free(vc);
+}
+
+
+}
+END_TEST
+
+START_TEST(Findpath_Saddle_Batch)
+{
+#line 149
+{
+  const char            *sequence = "UCCAGAAACGAUCAUUUAGCAGAGCACCGUGUACUUUCCAUCUUAAUCUCUGUUCGGCUG";
+  const char            *structures[] = {
+    "..(((...(((.......((((((.....((............))..))))))))).)))",
+    "........(((.......((((((....(((.......)))......)))))))))....",
+    "................((((.(((((..(...(.........)....)..))))).))))",
+    "..(((...(((.......((((((......(..........).....))))))))).)))",
+    "..((....(((.......((((((....(((.......)))......)))))))))..))",
+    ".................(((.(((((..(..((..........))..)..))))).))).",
+    "..(((...(((.......((((((....(((.......)))......))))))))).)))",
+    ".................(((((((((...))................)))))))......",
+  };
+  const char            *s1[64], *s2[64];
+  unsigned int          i, j, x, num, n_str, t;
+  int                   *saddles, *saddles_threads, en, idx[8][8];
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+
+  vrna_md_set_default(&md);
+  vc    = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+  n_str = sizeof(structures) / sizeof(structures[0]);
+
+  /* all pairs, some of them twice */
+  for (num = i = 0; i < n_str; i++)
+    for (j = i + 1; j < n_str; j++) {
+      s1[num]     = structures[i];
+      s2[num]     = structures[j];
+      idx[i][j]   = idx[j][i] = num++;
+    }
+
+  s1[num]   = structures[1];
+  s2[num++] = structures[5];
+  s1[num]   = structures[0];
+  s2[num++] = structures[6];
+
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif
+  saddles = vrna_path_findpath_saddle_batch(vc, s1, s2, num, 1, INT_MAX - 1);
+  ck_assert(saddles != NULL);
+
+  ck_assert_int_eq(saddles[num - 2], saddles[idx[1][5]]);
+  ck_assert_int_eq(saddles[num - 1], saddles[idx[0][6]]);
+
+  for (i = 0; i < n_str; i++)
+    for (j = i + 1; j < n_str; j++) {
+      /* never worse than a single search */
+      en = vrna_path_findpath_saddle(vc, structures[i], structures[j], 1);
+      ck_assert_int_le(saddles[idx[i][j]], en);
+
+      /* and not improved by a detour via another structure of the batch */
+      for (x = 0; x < n_str; x++)
+        if ((x != i) && (x != j))
+          ck_assert_int_le(saddles[idx[i][j]],
+                           MAX2(saddles[idx[i][x]], saddles[idx[x][j]]));
+    }
+
+  /* results do not depend on the number of threads */
+  for (t = 2; t <= 4; t++) {
+#ifdef _OPENMP
+    omp_set_num_threads(t);
+#endif
+    saddles_threads = vrna_path_findpath_saddle_batch(vc, s1, s2, num, 1, INT_MAX - 1);
+    ck_assert_int_eq(memcmp(saddles, saddles_threads, sizeof(int) * num), 0);
+    free(saddles_threads);
+  }
+
+  free(saddles);
+  vrna_fold_compound_free(vc);
+}
+
+
 }
 END_TEST
 
@@ -70,11 +248,13 @@ int main(void)
     int nf;
 
     /* User-specified pre-run code */
-#line 54
+#line 222
     srunner_set_tap(sr, "-");
 
     suite_add_tcase(s1, tc1_1);
     tcase_add_test(tc1_1, Walk_Gradient);
+    tcase_add_test(tc1_1, Walk_Gradient_Energies);
+    tcase_add_test(tc1_1, Findpath_Saddle_Batch);
 
     srunner_run_all(sr, CK_ENV);
     nf = srunner_ntests_failed(sr);